@@ -129,6 +129,9 @@ export MICROPY_VERSION="MaixPy-FreeRTOS_LoBo v${MICRO_PI_VER}"
 MICROPY_FLASH_START=$( cat mpy_support/mpconfigport.h | grep "MICRO_PY_FLASHFS_START_ADDRESS" | cut -d'(' -s -f 2 | cut -d')' -s -f 1 | head -n 1 )
 FLASH_START_ADDRES=$(( ${MICROPY_FLASH_START} ))
 
+MICROPY_XIPIMG_START=$( cat mpy_support/mpconfigport.h | grep "MICRO_PY_XIPIMG_START_ADDRESS" | cut -d'(' -s -f 2 | cut -d')' -s -f 1 | head -n 1 )
+XIPIMG_START_ADDRES=$(( ${MICROPY_XIPIMG_START} ))
+
 FS_USED=$(cat mpy_support/mpconfigport.h | grep "#define MICRO_PY_FLASHFS_USED" | cut -d'(' -f 2)
 if [ "${FS_USED}" == "MICRO_PY_FLASHFS_LITTLEFS)" ]; then
 	# Do not compile spiffs if not used
@@ -176,6 +179,17 @@ fi
 # ===============================================================================
 
 if [ $? -eq 0 ]; then
+# === Create the XIP modules image if there are modules to include ===
+rm -f mpy_support/build/maixpy_xip.img > /dev/null 2>&1
+if [ -n "$(find -L mpy_support/xip_modules -type f -name '*.py' 2>/dev/null)" ]; then
+echo "===[ Creating XIP modules image ]==="
+make -C mpy_support xipimg > /dev/null
+if [ $? -ne 0 ]; then
+echo "===[ ERROR creating XIP modules image ]==="
+exit 1
+fi
+fi
+
 FILESIZE=$(stat -c%s MaixPy.bin)
 ALLIGNED_SIZE=$(( (((${FILESIZE} / 4096) * 4096)) + 8192 ))
 END_ADDRESS=$(( ${ALLIGNED_SIZE} + 2147483648 ))
@@ -206,20 +220,32 @@ echo "        },">> flash-list.json
 echo "        {">> flash-list.json
 echo "            \"address\": ${FLASH_START_ADDRES},">> flash-list.json
 echo "            \"bin\": \"maixpy_lfs.img\",">> flash-list.json
+if [ -f "${PWD}/../mklittlefs/maixpy_lfs.img.json" ]; then
+cp ${PWD}/../mklittlefs/maixpy_lfs.img.json .
+echo "            \"sha256Prefix\": false,">> flash-list.json
+echo "            \"manifest\": \"maixpy_lfs.img.json\"">> flash-list.json
+else
 echo "            \"sha256Prefix\": false">> flash-list.json
+fi
 echo "        }">> flash-list.json
 else
 echo "        }">> flash-list.json
 fi
+if [ -f "${PWD}/mpy_support/build/maixpy_xip.img" ]; then
+cp ${PWD}/mpy_support/build/maixpy_xip.img .
+sed -i '$ d' flash-list.json
+echo "        },">> flash-list.json
+echo "        {">> flash-list.json
+echo "            \"address\": ${XIPIMG_START_ADDRES},">> flash-list.json
+echo "            \"bin\": \"maixpy_xip.img\",">> flash-list.json
+echo "            \"sha256Prefix\": false">> flash-list.json
+echo "        }">> flash-list.json
+fi
 echo "    ]">> flash-list.json
 echo "}">> flash-list.json
 
 rm -f *.kfpkg > /dev/null 2>&1
-if [ -f maixpy_lfs.img ]; then
-zip MaixPy.kfpkg -9 flash-list.json MaixPy.bin maixpy_lfs.img > /dev/null
-else
-zip MaixPy.kfpkg -9 flash-list.json MaixPy.bin > /dev/null
-fi
+zip MaixPy.kfpkg -9 flash-list.json MaixPy.bin $(ls maixpy_lfs.img maixpy_lfs.img.json maixpy_xip.img 2>/dev/null) > /dev/null
 
 if [ $? -eq 0 ]; then
 echo "===[ kfpkg created ]==="
@@ -8,6 +8,7 @@ import termios
 import time
 import argparse
 import binascii
+import zlib
 import re
 import shutil
 from threading import Thread
@@ -54,14 +55,16 @@ class PyTerm:
     }
 
     #----------------------------------------------------------------------------
-    def __init__(self, baudrate=115200, device='/dev/ttyUSB0', rst=0, clr=False):
+    def __init__(self, baudrate=115200, device='/dev/ttyUSB0', rst=0, clr=False, window=8, deflate=True):
         self.DEVICE     = device
         self.BAUDRATE   = baudrate
         self.ESCAPECHAR = "\033"
-        self.VERSION = "5.1.3"
+        self.VERSION = "5.2.0"
         self.ShutdownReceiver = False
         self.ReceiverToStdout = True
         self.DefaultTimeout = 0.1
+        self.XferWindow = window
+        self.XferDeflate = deflate
         self.width, self.height = shutil.get_terminal_size()
         self.colors = clr;
         if clr is True:
@@ -247,15 +250,8 @@ class PyTerm:
 
     #---------------------
     def crc_16(self, buf):
-        crc = 0xFFFF
-        for c in buf:
-            crc = (crc ^ (c << 8)) & 0xFFFF
-            for i in range(8):
-                if (crc & 0x8000):
-                    crc = ((crc << 1) & 0xFFFF) ^ 0x1021
-                else:
-                    crc = (crc << 1) & 0xFFFF
-        return crc
+        # CRC-16/CCITT, the same as mp_hal_crc16() on the device
+        return binascii.crc_hqx(buf, 0xFFFF)
 
     #-----------------------------------------
     def EnterRawREPL(self, imprt, cmd, bdr=0):
@@ -314,8 +310,279 @@ class PyTerm:
         self.ReceiverToStdout = True
         #print("Exit Raw REPL ({})".format(tmo), end="\r\n")
 
+    # ==== Windowed file transfer ====
+    # Up to 'window' data blocks can be sent before they are acknowledged,
+    # the missing blocks are selectively retransmitted
+    # Data frame:  0xA5 seq(2) len(2) data crc16(2)
+    # Acknowledge: type next(2) bitmap(2) crc16(2)
+    # See 'mpy_support/standard_lib/uos/file_xfer.h' for details
+
+    XFER_MARK      = 0xA5
+    XFER_RETRY     = 1.0
+    XFER_TIMEOUT   = 5.0
+
+    #---------------------------------------
+    def XferFrame(self, seq, data):
+        frame = bytes([self.XFER_MARK, seq & 0xFF, (seq >> 8) & 0xFF, len(data) & 0xFF, len(data) >> 8]) + data
+        crc = self.crc_16(frame)
+        return frame + bytes([crc >> 8, crc & 0xFF])
+
+    #-------------------------------------------------------
+    def XferAck(self, nxt, have, typ=0x06):
+        bitmap = 0
+        for i in range(16):
+            if (nxt + 1 + i) in have:
+                bitmap |= 1 << i
+        ack = bytes([typ, nxt & 0xFF, (nxt >> 8) & 0xFF, bitmap & 0xFF, bitmap >> 8])
+        crc = self.crc_16(ack)
+        self.uart.write(ack + bytes([crc >> 8, crc & 0xFF]))
+
+    # Wait for the device start sequence
+    # Returns the sequence, or None if the device does not support the windowed transfer
+    #---------------------------------
+    def XferWaitStart(self, length):
+        bb = b''
+        while bb != b'\x06':
+            bb = self.uart.read(1)
+            if (len(bb) == 0) or (bb == b'\x04'):
+                # timeout or command error (end of raw REPL output)
+                return None
+        resp = self.uart.read(length - 1)
+        if (len(resp) != (length - 1)) or (resp[0:1] != b'W'):
+            return None
+        return bb + resp
+
+    # Send the data to the device
+    # Returns 0 on success, abort type received from the device or -1 on timeout
+    #-------------------------------------------------------
+    def XferSendData(self, data, window, blk_size, total=0):
+        nblocks = (len(data) + blk_size - 1) // blk_size
+        frames = {}
+        sent_time = {}
+        head = 0
+        nxt = 0
+        rx = b''
+        last_ack = time.time()
+        last_retry = 0
+        self.uart.timeout = 0.05
+        while nxt < nblocks:
+            # fill the window
+            while (head < nblocks) and ((head - nxt) < window):
+                frames[head] = self.XferFrame(head & 0xFFFF, data[head*blk_size:(head+1)*blk_size])
+                self.uart.write(frames[head])
+                self.uart.flush()
+                sent_time[head] = time.time()
+                if head == nxt:
+                    last_ack = sent_time[head]
+                head += 1
+                if self.uart.in_waiting > 0:
+                    break
+
+            rx += self.uart.read(max(1, self.uart.in_waiting))
+            now = time.time()
+            # process the acknowledges
+            while len(rx) >= 7:
+                typ = rx[0]
+                if (typ not in (0x06, 0x08, 0x09, 0x0A)) or (self.crc_16(rx[0:5]) != ((rx[5] << 8) | rx[6])):
+                    rx = rx[1:]
+                    continue
+                delta = (rx[1] + (rx[2] << 8) - nxt) & 0xFFFF
+                bitmap = rx[3] + (rx[4] << 8)
+                rx = rx[7:]
+                if typ != 0x06:
+                    return typ
+                if delta > (head - nxt):
+                    continue
+                for b in range(nxt, nxt + delta):
+                    del frames[b]
+                    del sent_time[b]
+                nxt += delta
+                last_ack = now
+                if (bitmap == 0) and ((delta > 0) or (nxt >= head)):
+                    continue
+                # retransmit the blocks missing before the last received one
+                # if sent before it and not retransmitted since, acknowledge
+                # without progress or bitmap reports the damaged block 'nxt'
+                top = bitmap.bit_length()
+                if (bitmap != 0) and ((nxt + top) >= head):
+                    continue
+                for i in range(max(1, top)):
+                    b = nxt + i
+                    if b >= head:
+                        break
+                    if (i > 0) and (bitmap & (1 << (i - 1))):
+                        continue
+                    if (sent_time[b] <= sent_time[nxt + top]) if bitmap else ((now - sent_time[b]) >= (self.XFER_RETRY / 4)):
+                        self.uart.write(frames[b])
+                        sent_time[b] = now
+            if nxt < head:
+                if ((now - last_ack) >= self.XFER_RETRY) and ((now - last_retry) >= self.XFER_RETRY):
+                    self.uart.write(frames[nxt])
+                    sent_time[nxt] = now
+                    last_retry = now
+                if (now - last_ack) >= self.XFER_TIMEOUT:
+                    return -1
+            if total > 0:
+                sys.stdout.write("\r--> {0:.2f}%".format(min(nxt * blk_size, len(data)) / len(data) * 100))
+                sys.stdout.flush()
+        return 0
+
+    # Receive 'size' bytes from the device, the data is written to 'dst_file'
+    # Returns 0 on success, -1 on timeout, -2 on abort from the device
+    #------------------------------------------------------------------
+    def XferReceiveData(self, dst_file, size, window, blk_size):
+        nblocks = (size + blk_size - 1) // blk_size
+        last_len = size - (nblocks - 1) * blk_size
+        have = {}
+        nxt = 0
+        rx = b''
+        last_rx = time.time()
+        last_ack = last_rx
+        self.uart.timeout = 0.05
+        while nxt < nblocks:
+            rx += self.uart.read(max(1, self.uart.in_waiting))
+            send_ack = False
+            while len(rx) > 0:
+                if rx[0] != self.XFER_MARK:
+                    idx = rx.find(bytes([self.XFER_MARK]))
+                    rx = rx[idx:] if idx >= 0 else b''
+                    continue
+                if len(rx) < 5:
+                    break
+                seq = rx[1] + (rx[2] << 8)
+                length = rx[3] + (rx[4] << 8)
+                if length > blk_size:
+                    rx = rx[1:]
+                    continue
+                if len(rx) < (length + 7):
+                    break
+                if self.crc_16(rx[0:length+5]) != ((rx[length+5] << 8) | rx[length+6]):
+                    rx = rx[1:]
+                    send_ack = True
+                    continue
+                block_data = rx[5:length+5]
+                rx = rx[length+7:]
+                last_rx = time.time()
+                if length == 0:
+                    return -2
+                delta = (seq - nxt) & 0xFFFF
+                if delta < window:
+                    block = nxt + delta
+                    if (block >= nblocks) or (length != (last_len if block == (nblocks - 1) else blk_size)):
+                        return -2
+                    if delta > 0:
+                        send_ack = True
+                    have[block] = block_data
+                else:
+                    send_ack = True
+            # write the blocks in order
+            while nxt in have:
+                dst_file.write(have.pop(nxt))
+                nxt += 1
+                send_ack = True
+            now = time.time()
+            if send_ack or (((now - last_rx) >= self.XFER_RETRY) and ((now - last_ack) >= self.XFER_RETRY)):
+                self.XferAck(nxt, have)
+                last_ack = now
+            if (now - last_rx) >= self.XFER_TIMEOUT:
+                return -1
+            sys.stdout.write("\r<<< {0:.2f}%".format(min(nxt * blk_size, size) / size * 100))
+            sys.stdout.flush()
+        # repeat the last acknowledge in case it is lost
+        self.XferAck(nxt, have)
+        return 0
+
+    # Send the file using windowed transfer
+    # Returns None if not supported by the device
+    #--------------------------------------------------
+    def SendFileWindowed(self, src_fname, dest_fname):
+        try:
+            with open(src_fname, 'rb') as src_file:
+                data = src_file.read()
+        except:
+            print("Error opening file", end="\r\n")
+            return False
+        filesize = len(data)
+        zsize = 0
+        if self.XferDeflate:
+            # raw deflate stream, decompressed on the device
+            comp = zlib.compressobj(9, zlib.DEFLATED, -15)
+            zdata = comp.compress(data) + comp.flush()
+            if len(zdata) < (filesize * 0.9):
+                data = zdata
+                zsize = len(zdata)
+        send_cmd = "os.get_file('{}', {}, {}, {})\r\n".format(dest_fname, filesize, self.XferWindow, zsize)
+
+        print("Sending local file "+self.TCLR['BLUE']+src_fname+self.TCLR['NORMAL']+" to "+self.TCLR['BLUE']+dest_fname+self.TCLR['NORMAL']+"\r\n", end="\r\n")
+        if zsize > 0:
+            print("compressed to {} bytes ({:.1f}%)".format(zsize, zsize / filesize * 100), end="\r\n")
+
+        if not self.EnterRawREPL(b'import os\r\n', bytes(send_cmd.encode('utf-8'))):
+            return False
+
+        start = self.XferWaitStart(5)
+        if start is None:
+            self.ExitRawREPL()
+            return None
+
+        start_time = time.time()
+        res = self.XferSendData(data, start[2], start[3] + (start[4] << 8), filesize)
+        print("", end="\r\n")
+        if res == 0:
+            end_time = time.time()
+            print("OK, took "+self.TCLR['BLUE'] + "%.3f" % (end_time - start_time) + self.TCLR['NORMAL']+" seconds, " + self.TCLR['BLUE'] + "%.3f" % ((filesize / (end_time - start_time)) / 1024) + self.TCLR['NORMAL']+" KB/s", end="\r\n")
+        elif res < 0:
+            print("timed out sending file to remote", end="\r\n")
+        else:
+            print("abort requested from remote [{}]".format(res), end="\r\n")
+        self.ExitRawREPL()
+        return res == 0
+
+    # Receive the file using windowed transfer
+    # Returns None if not supported by the device
+    #--------------------------------------------------------
+    def ReceiveFileWindowed(self, src_fname, dest_fname):
+        recv_cmd = "os.send_file('{}', 0, {})\r\n".format(src_fname, self.XferWindow)
+
+        print("Receiving remote file "+self.TCLR['BLUE']+src_fname+self.TCLR['NORMAL']+" to "+self.TCLR['BLUE']+dest_fname+self.TCLR['NORMAL']+"\r\n", end="\r\n")
+
+        if not self.EnterRawREPL(b'import os\r\n', bytes(recv_cmd.encode('utf-8'))):
+            return False
+
+        start = self.XferWaitStart(11)
+        if (start is None) or (self.crc_16(start[0:9]) != ((start[9] << 8) | start[10])):
+            self.ExitRawREPL()
+            return None
+
+        filesize = start[5] + (start[6] << 8) + (start[7] << 16) + (start[8] << 24)
+        try:
+            dst_file = open(dest_fname, 'wb')
+        except:
+            self.XferAck(0, {}, 0x08)
+            print("Error opening file", end="\r\n")
+            self.ExitRawREPL()
+            return False
+
+        start_time = time.time()
+        res = self.XferReceiveData(dst_file, filesize, start[2], start[3] + (start[4] << 8))
+        dst_file.close()
+        print("", end="\r\n")
+        if res == 0:
+            end_time = time.time()
+            print("OK, took "+self.TCLR['BLUE']+"%.3f" % (end_time - start_time) + self.TCLR['NORMAL']+" seconds, "+self.TCLR['BLUE']+"%.3f" % ((filesize / (end_time - start_time)) / 1024)+self.TCLR['NORMAL']+" KB/s", end="\r\n")
+        else:
+            if res == -1:
+                self.XferAck(0, {}, 0x0A)
+            print("timed out or error in receiving file from remote", end="\r\n")
+        self.ExitRawREPL()
+        return res == 0
+
     #-------------------------------------------------
     def SendFileToDevice(self, src_fname, dest_fname):
+        if self.XferWindow > 0:
+            if self.SendFileWindowed(src_fname, dest_fname) is not None:
+                return
+            print("Windowed transfer not supported by the device, using block transfer", end="\r\n")
         try:
             filesize = os.path.getsize(src_fname)
             src_file = open(src_fname, 'rb')
@@ -383,6 +650,10 @@ class PyTerm:
 
     #------------------------------------------------------
     def ReceiveFileFromDevice(self, src_fname, dest_fname):
+        if self.XferWindow > 0:
+            if self.ReceiveFileWindowed(src_fname, dest_fname) is not None:
+                return
+            print("Windowed transfer not supported by the device, using block transfer", end="\r\n")
         try:
             dst_file = open(dest_fname, 'wb')
             recv_cmd = "os.send_file('{}', 0)\r\n".format(src_fname)
@@ -823,7 +1094,12 @@ if __name__ == '__main__':
         help="Use ANSI colors or not")
     cli.add_argument("-d", "--device",   default='/dev/ttyUSB0', type=str, action="store",
         help="Path to the serial communication device.")
+    cli.add_argument("-w", "--window",   default=8,              type=int, action="store",
+        help="File transfer window in blocks, 0 to use the block transfer.")
+    cli.add_argument("-z", "--deflate",  default=True,           type=str, action="store",
+        help="Compress the files sent to the device")
 
     args = cli.parse_args()
 
-    trm = PyTerm(baudrate=args.baudrate, device=args.device, rst=args.reset, clr=args.color)
+    trm = PyTerm(baudrate=args.baudrate, device=args.device, rst=args.reset, clr=args.color,
+                 window=args.window, deflate=(str(args.deflate).lower() not in ('false', '0', 'no')))
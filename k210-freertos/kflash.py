@@ -410,6 +410,118 @@ class KFlash:
             for i in range(0, len(l), n):
                 yield l[i:i + n]
 
+        def flash_image(firmware_bin, aes_key = None, sha256Prefix = True):
+            """Return the data written to Flash, padded to the dataframe size"""
+            if sha256Prefix == True:
+                # Add header to the firmware
+                # Format: SHA256(after)(32bytes) + AES_CIPHER_FLAG (1byte) + firmware_size(4bytes) + firmware_data
+                aes_cipher_flag = b'\x01' if aes_key else b'\x00'
+
+                # Encryption
+                if aes_key:
+                    enc = AES_128_CBC(aes_key, iv=b'\x00'*16).encrypt
+                    padded = firmware_bin + b'\x00'*15 # zero pad
+                    firmware_bin = b''.join([enc(padded[i*16:i*16+16]) for i in range(len(padded)//16)])
+
+                firmware_len = len(firmware_bin)
+
+                data = aes_cipher_flag + struct.pack('I', firmware_len) + firmware_bin
+
+                sha256_hash = hashlib.sha256(data).digest()
+
+                firmware_bin = data + sha256_hash
+
+            total_chunk = math.ceil(len(firmware_bin)/ISP_FLASH_DATA_FRAME_SIZE)
+            # align by size of dataframe
+            return firmware_bin.ljust(total_chunk * ISP_FLASH_DATA_FRAME_SIZE, b'\x00')
+
+        def flash_sectors_crc(image, swap):
+            """CRC32 of each sector of the image as read back by the firmware ('machine.flash_crc()')"""
+            # The 32-bit words sent to the flash stub are read back byte swapped,
+            # that is why the data at the addresses above 0 is sent swapped (see 'dump_to_flash')
+            if not swap:
+                nwords = len(image) // 4
+                image = struct.pack('<%dI' % nwords, *struct.unpack('>%dI' % nwords, image))
+            return [binascii.crc32(sector) & 0xFFFFFFFF for sector in chunks(image, ISP_FLASH_SECTOR_SIZE)]
+
+        def changed_frames(image, swap, flash_crc=None, used_sectors=None):
+            """Return the list of (offset, size) dataframes covering the sectors which must be written
+
+            Sectors not listed in 'used_sectors' (if given) and sectors equal to the Flash content
+            (if 'flash_crc' is given) are skipped
+            """
+            frames = []
+            for n, crc in enumerate(flash_sectors_crc(image, swap)):
+                if (used_sectors is not None) and (n not in used_sectors):
+                    continue
+                if (flash_crc is not None) and (n < len(flash_crc)) and (crc == flash_crc[n]):
+                    continue
+                offset = n * ISP_FLASH_SECTOR_SIZE
+                if frames and ((frames[-1][0] + frames[-1][1]) == offset) and (frames[-1][1] < ISP_FLASH_DATA_FRAME_SIZE):
+                    frames[-1] = (frames[-1][0], frames[-1][1] + ISP_FLASH_SECTOR_SIZE)
+                else:
+                    frames.append((offset, ISP_FLASH_SECTOR_SIZE))
+            return frames
+
+        def image_used_sectors(manifest, image_size):
+            """Return the set of used sectors from the file system image manifest created by 'mklfs'
+
+            None is returned if the manifest does not match the image, all sectors are written then
+            """
+            try:
+                manifest = json.loads(manifest)
+                if (manifest['size'] != image_size) or (manifest['sector_size'] != ISP_FLASH_SECTOR_SIZE):
+                    print(WARN_MSG, "Image manifest does not match the image, ignored", BASH_TIPS['DEFAULT'])
+                    return None
+                used = set()
+                for first, count in manifest['sectors']:
+                    used.update(range(first, first + count))
+                return used
+            except (ValueError, KeyError, TypeError):
+                print(WARN_MSG, "Invalid image manifest, ignored", BASH_TIPS['DEFAULT'])
+                return None
+
+        def read_flash_crc(port, baudrate, regions):
+            """Get the sectors CRC32 of the Flash regions from the MicroPython firmware running on the board
+
+            The firmware's raw REPL is used to run 'machine.flash_crc()' for each (address, size) region
+            Returns the dictionary {address: [crc, ...]}, empty if the firmware does not respond
+            """
+            def read_until(ending, timeout):
+                port.timeout = 0.1
+                resp = b''
+                tmo = time.time() + timeout
+                while not resp.endswith(ending):
+                    if time.time() > tmo:
+                        return None
+                    resp += port.read(max(1, port.inWaiting()))
+                return resp
+
+            flash_crc = {}
+            port.baudrate = baudrate
+            # interrupt the running program and enter raw REPL
+            port.write(b'\r\x03\x03')
+            time.sleep(0.2)
+            port.flushInput()
+            port.write(b'\x01')
+            if read_until(b'raw REPL; CTRL-B to exit\r\n>', 2) is not None:
+                for address, size in regions:
+                    port.write("import machine,ubinascii;print(ubinascii.hexlify(machine.flash_crc({}, {})).decode())".format(address, size).encode() + b'\x04')
+                    # response: 'OK' + output + '\x04' + error message + '\x04>'
+                    resp = read_until(b'\x04>', 60)
+                    if (resp is None) or (not resp.startswith(b'OK')):
+                        break
+                    out, err = resp[2:-2].split(b'\x04', 1)
+                    if err:
+                        print(WARN_MSG, "Flash CRC at 0x%08x not available:" % address, err.decode(errors='replace').strip().splitlines()[-1], BASH_TIPS['DEFAULT'])
+                        continue
+                    crc_bin = binascii.unhexlify(out.strip())
+                    flash_crc[address] = list(struct.unpack('<%dI' % (len(crc_bin) // 4), crc_bin))
+                port.write(b'\x02')
+            port.baudrate = 115200
+            port.timeout = 0.1
+            return flash_crc
+
         def getTerminalSize():
            import platform
            current_os = platform.system()
@@ -990,7 +1102,7 @@ class KFlash:
                         continue
                     self.flash_dataframe(segment.data(), segment['p_vaddr'])
 
-            def flash_firmware(self, firmware_bin, aes_key = None, address_offset = 0, sha256Prefix = True, swap=False):
+            def flash_firmware(self, firmware_bin, aes_key = None, address_offset = 0, sha256Prefix = True, swap=False, flash_crc=None, used_sectors=None):
                 print(INFO_MSG, "Flashing data at Flash address", "0x%08x"%address_offset, BASH_TIPS['DEFAULT'])
                 # type: (bytes, bytes, int, bool) -> None
                 # Don't remove above code!
@@ -999,43 +1111,36 @@ class KFlash:
 
                 if sha256Prefix == True:
                     print(INFO_MSG, "Flashing with SHA prefix", BASH_TIPS['DEFAULT'])
-                    # Add header to the firmware
-                    # Format: SHA256(after)(32bytes) + AES_CIPHER_FLAG (1byte) + firmware_size(4bytes) + firmware_data
-                    aes_cipher_flag = b'\x01' if aes_key else b'\x00'
-
-                    # Encryption
-                    if aes_key:
-                        enc = AES_128_CBC(aes_key, iv=b'\x00'*16).encrypt
-                        padded = firmware_bin + b'\x00'*15 # zero pad
-                        firmware_bin = b''.join([enc(padded[i*16:i*16+16]) for i in range(len(padded)//16)])
-
-                    firmware_len = len(firmware_bin)
-
-                    data = aes_cipher_flag + struct.pack('I', firmware_len) + firmware_bin
-
-                    sha256_hash = hashlib.sha256(data).digest()
-
-                    firmware_with_header = data + sha256_hash
-
-                    total_chunk = math.ceil(len(firmware_with_header)/ISP_FLASH_DATA_FRAME_SIZE)
-                    # Slice download firmware
-                    data_chunks = chunks(firmware_with_header, ISP_FLASH_DATA_FRAME_SIZE)  # 4kiB for a sector, 16kiB for dataframe
-                else:
-                    total_chunk = math.ceil(len(firmware_bin)/ISP_FLASH_DATA_FRAME_SIZE)
-                    data_chunks = chunks(firmware_bin, ISP_FLASH_DATA_FRAME_SIZE)
 
+                image = flash_image(firmware_bin, aes_key, sha256Prefix)
+                swap = (address_offset > 0)
+
+                # Slice download firmware, 4kiB for a sector, 64kiB for dataframe
+                frames = [(offset, ISP_FLASH_DATA_FRAME_SIZE) for offset in range(0, len(image), ISP_FLASH_DATA_FRAME_SIZE)]
+                if (flash_crc is not None) or (used_sectors is not None):
+                    # Delta/sparse flashing, write only the used sectors which differ from the Flash content
+                    frames = changed_frames(image, swap, flash_crc, used_sectors)
+                    changed = sum([size for offset, size in frames])
+                    if used_sectors is not None:
+                        print(INFO_MSG, "Sparse: {} of {} sectors used".format(len(used_sectors), len(image) // ISP_FLASH_SECTOR_SIZE), BASH_TIPS['DEFAULT'])
+                    if flash_crc is not None:
+                        print(INFO_MSG, "Delta: {} of {} sectors changed".format(changed // ISP_FLASH_SECTOR_SIZE, len(image) // ISP_FLASH_SECTOR_SIZE), BASH_TIPS['DEFAULT'])
+                    if len(frames) == 0:
+                        return
+
+                total_chunk = len(frames)
+                sent = 0
                 time_start = time.time()
-                for n, chunk in enumerate(data_chunks):
-                    chunk = chunk.ljust(ISP_FLASH_DATA_FRAME_SIZE, b'\x00')  # align by size of dataframe
-
+                for n, (offset, size) in enumerate(frames):
                     # Download a dataframe
                     #print('[INFO]', 'Write firmware data piece')
-                    self.dump_to_flash(chunk, address= n * ISP_FLASH_DATA_FRAME_SIZE + address_offset, swap=(address_offset > 0))
+                    self.dump_to_flash(image[offset:offset+size], address= offset + address_offset, swap=swap)
+                    sent += size
                     columns, lines = get_terminal_size()
                     time_delta = time.time() - time_start
                     speed = ''
                     if (time_delta > 1):
-                        speed = str(int((n + 1) * ISP_FLASH_DATA_FRAME_SIZE / 1024.0 / time_delta)) + 'kiB/s'
+                        speed = str(int(sent / 1024.0 / time_delta)) + 'kiB/s'
                     printProgressBar(n+1, total_chunk, prefix = 'Programming BIN:', suffix = speed, length = columns - 35)
 
         def open_terminal(reset, bdr, colors=True):
@@ -1057,6 +1162,7 @@ class KFlash:
         parser.add_argument("-s", "--sram", help="Download firmware to SRAM and boot", default=False, action="store_true")
         parser.add_argument("-a", "--address", type=int, help="Download firmware to address", default=0)
         parser.add_argument("-E", "--erase", help="Erase the Falsh chip!", default=False, action="store_true")
+        parser.add_argument("-D", "--delta", help="Write only the Flash sectors which differ, MicroPython must run on the board", default=False, action="store_true")
 
         parser.add_argument("-B", "--Board",required=False, type=str, help="Select dev board, e.g. kd233, dan, bit, goD, goE or trainer", default="bit")
         parser.add_argument("-S", "--Slow",required=False, help="Slow download mode", default=False)
@@ -1143,6 +1249,27 @@ class KFlash:
                         print(ERROR_MSG, 'Please retry:', args.firmware + '.bin', BASH_TIPS['DEFAULT'])
                         sys.exit(1)
 
+        # 0.1 Delta flashing, get the sectors CRC from the running firmware
+        flash_crc = {}
+        if args.delta and (firmware_bin != None) and (not args.sram) and (not args.erase):
+            regions = []
+            if file_format == ProgramFileFormat.FMT_KFPKG:
+                with zipfile.ZipFile(args.firmware) as zf:
+                    sFlashList = re.sub(r'"address": (.*),', r'"address": "\1",', zf.read('flash-list.json').decode())
+                    for lBinFiles in json.loads(sFlashList)['files']:
+                        image = flash_image(zf.read(lBinFiles['bin']), sha256Prefix=lBinFiles['sha256Prefix'])
+                        regions.append((int(lBinFiles['address'], 0), len(image)))
+            else:
+                aes_key = binascii.a2b_hex(args.key) if args.key else None
+                image = flash_image(firmware_bin.read(), aes_key, sha256Prefix=(args.address == 0))
+                firmware_bin.seek(0)
+                regions.append((args.address, len(image)))
+
+            print(INFO_MSG,"Reading Flash sectors CRC from the board...",BASH_TIPS['DEFAULT'])
+            flash_crc = read_flash_crc(loader._port, args.termbdr, regions)
+            if len(flash_crc) == 0:
+                print(WARN_MSG,"Flash CRC not available from the board, all sectors will be written",BASH_TIPS['DEFAULT'])
+
         # 1. Greeting.
         print(INFO_MSG,"Trying to Enter the ISP Mode...",BASH_TIPS['DEFAULT'])
 
@@ -1313,8 +1440,14 @@ class KFlash:
                 for lBinFiles in jsonFlashList['files']:
                     print(INFO_MSG,"  Writing",lBinFiles['bin'],"to Flash address","0x%08x"%int(lBinFiles['address'], 0),BASH_TIPS['DEFAULT'])
                     firmware_bin = open(os.path.join(tmpdir, lBinFiles["bin"]), "rb")
-                    loader.flash_firmware(firmware_bin.read(), address_offset=int(lBinFiles['address'], 0), sha256Prefix=lBinFiles['sha256Prefix'])
+                    bin_data = firmware_bin.read()
                     firmware_bin.close()
+                    used_sectors = None
+                    if ('manifest' in lBinFiles) and (not lBinFiles['sha256Prefix']):
+                        with open(os.path.join(tmpdir, lBinFiles['manifest']), "r") as fManifest:
+                            used_sectors = image_used_sectors(fManifest.read(), len(bin_data))
+                    loader.flash_firmware(bin_data, address_offset=int(lBinFiles['address'], 0), sha256Prefix=lBinFiles['sha256Prefix'],
+                                          flash_crc=flash_crc.get(int(lBinFiles['address'], 0)), used_sectors=used_sectors)
         else:
             print(INFO_MSG,"Flash to address: {} ({}). ".format(args.address, hex(args.address)), BASH_TIPS['DEFAULT'])
             if args.key:
@@ -1323,14 +1456,20 @@ class KFlash:
                     raise ValueError('AES key must by 16 bytes')
 
                 if args.address > 0:
-                    loader.flash_firmware(firmware_bin.read(), aes_key=aes_key, address_offset=args.address, sha256Prefix=False)
+                    loader.flash_firmware(firmware_bin.read(), aes_key=aes_key, address_offset=args.address, sha256Prefix=False, flash_crc=flash_crc.get(args.address))
                 else:
-                    loader.flash_firmware(firmware_bin.read(), aes_key=aes_key)
+                    loader.flash_firmware(firmware_bin.read(), aes_key=aes_key, flash_crc=flash_crc.get(0))
             else:
                 if args.address > 0:
-                    loader.flash_firmware(firmware_bin.read(), address_offset=args.address, sha256Prefix=False)
+                    bin_data = firmware_bin.read()
+                    used_sectors = None
+                    if os.path.isfile(args.firmware + '.json'):
+                        # file system image created by 'mklfs', write only the used sectors
+                        with open(args.firmware + '.json', "r") as fManifest:
+                            used_sectors = image_used_sectors(fManifest.read(), len(bin_data))
+                    loader.flash_firmware(bin_data, address_offset=args.address, sha256Prefix=False, flash_crc=flash_crc.get(args.address), used_sectors=used_sectors)
                 else:
-                    loader.flash_firmware(firmware_bin.read())
+                    loader.flash_firmware(firmware_bin.read(), flash_crc=flash_crc.get(0))
 
         # 3. boot
         if args.Board == "dan" or args.Board == "bit" or args.Board == "trainer":
@@ -120,20 +120,16 @@ static bool exec_boot_py = true;
 static bool exec_main_py = true;
 static bool use_default_config = false;
 
+extern char _heap_end[];
+extern char *_heap_cur;
+
+// Returns the free memory available to 'malloc'
+// free space in the malloc arena + space not yet requested from the system ('sbrk')
 //----------------------------
 size_t _check_remaining_heap()
 {
-    uint32_t hp_size = 1*1024*1024;
-    uint8_t * hp_testbuf = NULL;
-    while (hp_size > 1024) {
-        hp_testbuf = malloc(hp_size);
-        if (hp_testbuf) {
-            free(hp_testbuf);
-            break;
-        }
-        hp_size -= 1024;
-    }
-    return hp_size;
+    struct mallinfo mi = mallinfo();
+    return mi.fordblks + (size_t)(_heap_end - _heap_cur);
 }
 
 //-------------------------
@@ -171,6 +167,7 @@ static void mp_task_proc0(void *pvParameter)
         mp_stack_set_top((void *)pxTaskGetStackEnd(NULL));
         mp_stack_set_limit((size_t)(pxTaskGetStackEnd(NULL) - pxTaskGetStackStart(NULL) - MICROPY_TASK_STACK_RESERVED));
 
+        int trace = mp_hal_boot_trace_begin("mp_init");
         #if MICROPY_ENABLE_GC
         // ** Initialize MicroPython heap
         gc_init(mp_heap, mp_heap + mpy_config.config.heap_size1);
@@ -181,9 +178,12 @@ static void mp_task_proc0(void *pvParameter)
         mp_obj_list_init((mp_obj_list_t *)mp_sys_argv, 0) ;
         // Set gc threshold to 4/5 of the heap size
         MP_STATE_MEM(gc_alloc_threshold) = (mpy_config.config.heap_size1 * 4 / 5) & 0xFFFFFFFFFFFFFFF8;
+        mp_hal_boot_trace_end(trace);
 
         // Initialize file system on internal Flash
+        trace = mp_hal_boot_trace_begin("flash fs mount");
         flash_fs_ok = init_flash_filesystem();
+        mp_hal_boot_trace_end(trace);
         if (!flash_fs_ok) LOGE(TAG, "FLASH File system initialization failed!");
 
         readline_init0();
@@ -191,16 +191,23 @@ static void mp_task_proc0(void *pvParameter)
         if (flash_fs_ok) {
             // 'boot.py' should always exist
             check_boot_py();
-            if ((exec_boot_py) && (mp_vfs_import_stat("/flash/boot.py") == MP_IMPORT_STAT_FILE)) pyexec_file("/flash/boot.py");
+            if ((exec_boot_py) && (mp_vfs_import_stat("/flash/boot.py") == MP_IMPORT_STAT_FILE)) {
+                trace = mp_hal_boot_trace_begin("boot.py");
+                pyexec_file("/flash/boot.py");
+                mp_hal_boot_trace_end(trace);
+            }
 
             // Execute 'main.py' if it exists
             if (mp_vfs_import_stat("/flash/main.py") == MP_IMPORT_STAT_FILE) {
+                trace = mp_hal_boot_trace_begin("main.py");
                 pyexec_file("/flash/main.py");
+                mp_hal_boot_trace_end(trace);
             }
         }
 
         // Print MicroPython banners
         mp_printf(&mp_plat_print, "%s%s%s%s%s", term_color(BLUE), Banner, term_color(BROWN), (mpy_config.config.use_two_main_tasks) ? ver_info1 : ver_info2, term_color(DEFAULT));
+        if (!task0_started) mp_hal_boot_trace_mark("REPL ready");
         task0_started = true;
 
         // ==== Main REPL loop =========================================
@@ -280,7 +287,9 @@ static void mp_task_proc1(void *pvParameter)
 
             // Execute 'boot2.py' if it exists
             if ((exec_boot_py) && (mp_vfs_import_stat("/flash/boot2.py") == MP_IMPORT_STAT_FILE)) {
+                int trace = mp_hal_boot_trace_begin("boot2.py");
                 pyexec_file("/flash/boot2.py");
+                mp_hal_boot_trace_end(trace);
             }
         }
 
@@ -348,6 +357,9 @@ static void mp_task_proc1(void *pvParameter)
 //========
 int main()
 {
+    // CPU frequency set by the boot loader, used to convert the boot trace start time
+    uint32_t reset_freq = sysctl_clock_get_freq(SYSCTL_CLOCK_CPU);
+
     // ==== Allocate ram buffer ====
     sys_rambuf = malloc(MYCROPY_SYS_RAMBUF_SIZE);
     if (sys_rambuf) sys_rambuf_ptr = (uintptr_t)sys_rambuf;
@@ -363,6 +375,7 @@ int main()
     sysctl_clock_set_clock_select(SYSCTL_CLOCK_SELECT_SPI3, 1);
 
     sys_us_counter_cpu = read_csr64(mcycle);
+    mp_hal_boot_trace_init(reset_freq);
     uarths_baudrate = uarths_init(MICRO_PY_DEFAULT_BAUDRATE);
 
     // ==== Get reset status ====
@@ -387,6 +400,7 @@ int main()
     #endif
 
     // ==== Initialize the SPI Flash hardware ====
+    int trace = mp_hal_boot_trace_begin("flash init");
     flash_spi = io_open("/dev/spi3");
     configASSERT(flash_spi);
 
@@ -394,8 +408,10 @@ int main()
     uint32_t res = w25qxx_init(flash_spi, SPI_FF_QUAD, WQ25QXX_MAX_SPEED);
     configASSERT(res);
     vTaskDelay(2);
+    mp_hal_boot_trace_end(trace);
 
     // === Read MicroPython configuration from flash ===
+    trace = mp_hal_boot_trace_begin("config read");
     bool cfg_loaded = false;
     if (!mpy_read_config()) {
         vTaskDelay(2);
@@ -403,6 +419,7 @@ int main()
     }
     else cfg_loaded = true;
     configASSERT(mpy_config_crc(false));
+    mp_hal_boot_trace_end(trace);
 
     user_log_level = mpy_config.config.log_level;
     user_log_color = mpy_config.config.log_color;
@@ -415,7 +432,14 @@ int main()
     if (sys_rambuf) LOGQ(TAG_MAIN, "RAM buffer of %d bytes allocated at %p", MYCROPY_SYS_RAMBUF_SIZE, sys_rambuf);
 
     // ==== Initialize MicroPython HAL ====
+    trace = mp_hal_boot_trace_begin("hal init");
 	mp_hal_init();
+    mp_hal_boot_trace_end(trace);
+
+    // ==== Map the precompiled modules image, if present ====
+    trace = mp_hal_boot_trace_begin("xip init");
+    if (mp_hal_xip_init()) LOGM(TAG_MAIN, "XIP modules image found at %p", mp_hal_xip_image());
+    mp_hal_boot_trace_end(trace);
 
 	// === Initialize RTC ===
 	mp_rtc_rtc0 = io_open("/dev/rtc0");
@@ -442,6 +466,7 @@ int main()
     sysctl->peri.jtag_clk_bypass = 1;
 
     // ==== Initialize GPIOHS for boot menu pin check====
+    trace = mp_hal_boot_trace_begin("boot menu");
     if (mpy_config.config.boot_menu_pin) {
         machine_init_gpiohs();
         configASSERT(gpiohs_handle);
@@ -500,6 +525,8 @@ int main()
         }
     }
 
+    mp_hal_boot_trace_end(trace);
+
     if (use_default_config) {
         vTaskDelay(2);
         mpy_config_set_default();
@@ -513,6 +540,7 @@ int main()
     // ======================================
     // ==== Allocate MicroPython heap(s) ====
     // ======================================
+    trace = mp_hal_boot_trace_begin("heap alloc");
     mp_heap = pvPortMalloc(mpy_config.config.heap_size1 + 16);
     configASSERT(mp_heap);
     if (mpy_config.config.pystack_enabled) {
@@ -527,10 +555,12 @@ int main()
             mp_task_pystack2 = pvPortMalloc(mpy_config.config.pystack_size);
             configASSERT(mp_task_pystack2);
         }
+        mp_hal_boot_trace_end(trace);
         LOGM(TAG_MAIN, "Heaps: FreeRTOS=%lu KB (%lu KB free), MPy_1=%u KB, MPy_2=%u KB, other=%lu KB",
                 FREE_RTOS_TOTAL_HEAP_SIZE/1024, xPortGetFreeHeapSize()/1024, mpy_config.config.heap_size1/1024, mpy_config.config.heap_size2/1024, _check_remaining_heap()/1024);
     }
     else {
+        mp_hal_boot_trace_end(trace);
         LOGM(TAG_MAIN, "Heaps: FreeRTOS=%lu KB (%lu KB free), MPy=%u KB, other=%lu KB",
                 FREE_RTOS_TOTAL_HEAP_SIZE/1024, xPortGetFreeHeapSize()/1024, mpy_config.config.heap_size1/1024, _check_remaining_heap()/1024);
     }
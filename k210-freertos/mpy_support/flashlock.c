@@ -0,0 +1,134 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stddef.h>
+#include "flashlock.h"
+
+static SemaphoreHandle_t xip_mutex = NULL;
+static SemaphoreHandle_t *gil_handle[FLASHLOCK_INSTANCES] = {NULL};
+static TaskHandle_t volatile xip_writer = NULL;
+static TaskHandle_t volatile xip_parked[FLASHLOCK_INSTANCES] = {NULL};
+
+//--------------------------------------------------------------
+bool flashlock_init(SemaphoreHandle_t *gil[FLASHLOCK_INSTANCES])
+{
+    if (xip_mutex == NULL) {
+        xip_mutex = xSemaphoreCreateMutex();
+        if (xip_mutex == NULL) return false;
+    }
+    for (int idx = 0; idx < FLASHLOCK_INSTANCES; idx++) {
+        gil_handle[idx] = gil[idx];
+    }
+    return true;
+}
+
+//---------------------------------------------
+static SemaphoreHandle_t flashlock_gil(int idx)
+{
+    return (gil_handle[idx]) ? *gil_handle[idx] : NULL;
+}
+
+// Returns the index of the instance whose GIL is held by the current task, -1 if none
+//-------------------------------------
+static int flashlock_gil_instance(void)
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    for (int idx = 0; idx < FLASHLOCK_INSTANCES; idx++) {
+        SemaphoreHandle_t gil = flashlock_gil(idx);
+        if ((gil) && (xSemaphoreGetMutexHolder(gil) == task)) return idx;
+    }
+    return -1;
+}
+
+// While the task waits for the mutex, its instance is marked as parked.
+// After the mutex is taken, the task waits for the end of a write
+// which was started while it was parked.
+//--------------------------------------------------------------
+bool flashlock_take(SemaphoreHandle_t mutex, TickType_t timeout)
+{
+    if (xip_mutex == NULL) return (xSemaphoreTake(mutex, timeout) == pdTRUE);
+
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    int idx = flashlock_gil_instance();
+    if (idx >= 0) {
+        xip_parked[idx] = task;
+        __sync_synchronize();
+    }
+    bool res = (xSemaphoreTake(mutex, timeout) == pdTRUE);
+    if (idx >= 0) {
+        while (true) {
+            xip_parked[idx] = NULL;
+            __sync_synchronize();
+            if ((xip_writer == NULL) || (xip_writer == task)) break;
+            // a write in progress may rely on this task being parked
+            xip_parked[idx] = task;
+            __sync_synchronize();
+            if (xSemaphoreTake(xip_mutex, portMAX_DELAY) == pdTRUE) xSemaphoreGive(xip_mutex);
+        }
+    }
+    return res;
+}
+
+// 'write' is false for the reads through the XIP window, which only exclude the writes.
+// Returns the bit mask of the GILs taken by the lock
+//--------------------------------
+int flashlock_xip_lock(bool write)
+{
+    int state = 0;
+
+    flashlock_take(xip_mutex, portMAX_DELAY);
+    if (!write) return 0;
+
+    int own = flashlock_gil_instance();
+    xip_writer = xTaskGetCurrentTaskHandle();
+    __sync_synchronize();
+    for (int idx = 0; idx < FLASHLOCK_INSTANCES; idx++) {
+        SemaphoreHandle_t gil = flashlock_gil(idx);
+        if ((idx == own) || (gil == NULL)) continue;
+        while (true) {
+            if (xSemaphoreTake(gil, 1) == pdTRUE) {
+                state |= (1 << idx);
+                break;
+            }
+            TaskHandle_t holder = xSemaphoreGetMutexHolder(gil);
+            if ((holder != NULL) && (xip_parked[idx] == holder)) break;
+        }
+    }
+    return state;
+}
+
+//----------------------------------------------
+void flashlock_xip_unlock(int state, bool write)
+{
+    if (write) {
+        xip_writer = NULL;
+        __sync_synchronize();
+        for (int idx = FLASHLOCK_INSTANCES - 1; idx >= 0; idx--) {
+            if (state & (1 << idx)) xSemaphoreGive(flashlock_gil(idx));
+        }
+    }
+    xSemaphoreGive(xip_mutex);
+}
@@ -0,0 +1,57 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MICROPY_INCLUDED_FLASHLOCK_H__
+#define __MICROPY_INCLUDED_FLASHLOCK_H__
+
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#define FLASHLOCK_INSTANCES     2
+
+// Keeps the MicroPython code executed from the XIP image away from the Flash
+// while XIP is disabled for a Flash write or erase.
+// The image is only accessed by MicroPython code, which runs only while its
+// instance holds the GIL. Flash reads use the XIP window and only take the XIP mutex.
+// A write or erase takes the XIP mutex and then, for each instance, its GIL or the
+// knowledge that the GIL holder is "parked": blocked in flashlock_take() on the XIP
+// or a file system mutex, from where it can not return while XIP is disabled.
+// The caller's own GIL is never released. File system drivers take their mutex
+// before the flash operation, so the lock order is always
+// FS mutex -> XIP mutex -> GIL of the other instance.
+// Driver code executed between the flash mutexes must not use the image.
+
+// 'gil' are the addresses of the instances' GIL mutex handles, which are created later
+bool flashlock_init(SemaphoreHandle_t *gil[FLASHLOCK_INSTANCES]);
+// Take a flash related mutex (XIP or file system lock), returns false on timeout
+bool flashlock_take(SemaphoreHandle_t mutex, TickType_t timeout);
+// XIP lock functions used by the w25qxx driver (w25qxx_set_xip_lock)
+int flashlock_xip_lock(bool write);
+void flashlock_xip_unlock(int state, bool write);
+
+#endif
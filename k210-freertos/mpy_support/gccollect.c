@@ -37,6 +37,18 @@
 #include "py/mpthread.h"
 #include "mphalport.h"
 #include "gccollect.h"
+#if MICROPY_GC_PARALLEL_MARK
+#include "FreeRTOS.h"
+#include "task.h"
+#include "mpthreadport.h"
+#include "modmachine.h"
+
+#define GC_HELPER_PROC  (MAIN_TASK_PROC ^ 1)
+
+static const char *TAG = "[GC]";
+static TaskHandle_t gc_helper_task_handle = NULL;
+static void *gc_helper_state = NULL;
+#endif
 
 /*
 uintptr_t get_sp(void) {
@@ -91,6 +103,53 @@ static void gc_collect_inner(int level)
 }
 */
 
+#if MICROPY_GC_PARALLEL_MARK
+// The helper marker runs on the other core,
+// the notification is sent from gc_collect_end when the roots are collected
+//--------------------------------------------
+static void gc_helper_task(void *pvParameters)
+{
+    MICROPY_GC_STACK_ENTRY_TYPE stack[MICROPY_ALLOC_GC_STACK_SIZE];
+    uint64_t notify_val = 0;
+
+    while (1) {
+        if (xTaskNotifyWait(0, ULONG_MAX, &notify_val, portMAX_DELAY) != pdTRUE) continue;
+        // use the MicroPython state of the task running the collection
+        vTaskSetThreadLocalStoragePointer(NULL, THREAD_LSP_STATE, gc_helper_state);
+        gc_mark_helper(stack);
+    }
+}
+
+//-----------------------------
+void gc_mark_helper_start(void)
+{
+    // Disabled with gc.parallel(False)
+    if (!MP_STATE_MEM(gc_mark_parallel)) return;
+    // The other core runs the second MicroPython instance
+    if (mpy_config.config.use_two_main_tasks) return;
+    // The caller busy-waits for the helper, it must run on the other core
+    if (uxPortGetProcessorId() == GC_HELPER_PROC) return;
+
+    if (gc_helper_task_handle == NULL) {
+        BaseType_t res = xTaskCreateAtProcessor(
+                GC_HELPER_PROC,                         // processor
+                gc_helper_task,                         // function entry
+                "GC_helper",                            // task name
+                configMINIMAL_STACK_SIZE,               // stack_deepth
+                NULL,                                   // function argument
+                MICROPY_TASK_PRIORITY+1,                // task priority
+                &gc_helper_task_handle);                // task handle
+        if (res != pdPASS) {
+            gc_helper_task_handle = NULL;
+            LOGE(TAG, "Helper task not started");
+            return;
+        }
+    }
+    gc_helper_state = pvTaskGetThreadLocalStoragePointer(NULL, THREAD_LSP_STATE);
+    xTaskNotify(gc_helper_task_handle, 1, eSetValueWithOverwrite);
+}
+#endif
+
 //-------------------
 void gc_collect(void)
 {
@@ -0,0 +1,278 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * K210 hardware FFT accelerator module
+ *
+ * Complex data is stored as interleaved 16-bit (real, imaginary) pairs,
+ * 4 bytes per point, in any buffer object ('h' array, bytearray, ...).
+ * Buffers used by the hardware FFT must be 8-byte aligned (DMA transfers
+ * 64-bit words), which is always true for array/bytearray objects.
+ *
+ * The 'shift' argument is the 9-bit mask of the FFT stages after which
+ * the intermediate result is divided by 2 (bit 0 = first stage).
+ * With the default value (0x1FF) the result is scaled by 1/points and
+ * can never overflow.
+ */
+
+#include <string.h>
+
+#include "py/runtime.h"
+#include "py/objarray.h"
+
+#if MICROPY_PY_UFFT
+
+#include "devices.h"
+#include "ufftkernels.h"
+
+#define UFFT_MIN_POINTS     64
+#define UFFT_MAX_POINTS     512
+#define UFFT_DEFAULT_SHIFT  0x1FF
+
+enum { ARG_input, ARG_output, ARG_points, ARG_shift, ARG_inverse };
+
+//-----------------------------------------------
+STATIC const mp_arg_t ufft_fft_allowed_args[] = {
+    { MP_QSTR_input,                      MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    { MP_QSTR_output,                                       MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    { MP_QSTR_points,                                       MP_ARG_INT, {.u_int = 0} },
+    { MP_QSTR_shift,                                        MP_ARG_INT, {.u_int = UFFT_DEFAULT_SHIFT} },
+    { MP_QSTR_inverse,                                     MP_ARG_BOOL, {.u_bool = false} },
+};
+
+//----------------------------------
+STATIC bool ufft_check_points(int n)
+{
+    return ((n >= UFFT_MIN_POINTS) && (n <= UFFT_MAX_POINTS) && ((n & (n - 1)) == 0));
+}
+
+// Parse the arguments common to all FFT functions
+// Returns the number of frames in the input buffer
+//----------------------------------------------------------------------------------------------------------------------------------
+STATIC size_t ufft_get_args(mp_arg_val_t *args, mp_buffer_info_t *inbuf, mp_buffer_info_t *outbuf, int *points, bool hw, bool batch)
+{
+    // the input is only read if the separate output buffer is used
+    mp_get_buffer_raise(args[ARG_input].u_obj, inbuf, (args[ARG_output].u_obj == mp_const_none) ? MP_BUFFER_RW : MP_BUFFER_READ);
+    if (args[ARG_output].u_obj == mp_const_none) *outbuf = *inbuf;
+    else mp_get_buffer_raise(args[ARG_output].u_obj, outbuf, MP_BUFFER_WRITE);
+
+    *points = args[ARG_points].u_int;
+    if (*points == 0) *points = (batch) ? UFFT_MAX_POINTS : inbuf->len / 4;
+    if (!ufft_check_points(*points)) {
+        mp_raise_ValueError("FFT points must be 64, 128, 256 or 512");
+    }
+    size_t frame_len = *points * 4;
+    if ((inbuf->len < frame_len) || ((inbuf->len % frame_len) != 0) || ((!batch) && (inbuf->len != frame_len))) {
+        mp_raise_ValueError("Input buffer size does not match the number of points");
+    }
+    if (outbuf->len < inbuf->len) {
+        mp_raise_ValueError("Output buffer too small");
+    }
+    if ((args[ARG_shift].u_int < 0) || (args[ARG_shift].u_int > 0x1FF)) {
+        mp_raise_ValueError("Shift must be 9-bit mask (0 ~ 0x1FF)");
+    }
+    if ((hw) && ((((uintptr_t)inbuf->buf & 7) != 0) || (((uintptr_t)outbuf->buf & 7) != 0))) {
+        mp_raise_ValueError("Buffers must be 8-byte aligned");
+    }
+    return inbuf->len / frame_len;
+}
+
+// The hardware expects (imaginary, real) pairs, the driver swaps each input frame into its own
+// buffer, so the input is never modified and can be used by other threads while the FFT runs
+//----------------------------------------------------------------------------------------------------------------------------
+STATIC void ufft_hw_run(mp_buffer_info_t *inbuf, mp_buffer_info_t *outbuf, int points, size_t frames, int shift, bool inverse)
+{
+    MP_THREAD_GIL_EXIT();
+    fft_complex_uint16_batch_ri(shift, (inverse) ? FFT_DIR_BACKWARD : FFT_DIR_FORWARD,
+                                (const uint64_t *)inbuf->buf, points, frames, (uint64_t *)outbuf->buf);
+    MP_THREAD_GIL_ENTER();
+}
+
+//--------------------------------------------------------------------------------------------------------------
+STATIC mp_obj_t ufft_fft_common(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args, bool hw, bool batch)
+{
+    mp_arg_val_t args[MP_ARRAY_SIZE(ufft_fft_allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(ufft_fft_allowed_args), ufft_fft_allowed_args, args);
+
+    mp_buffer_info_t inbuf, outbuf;
+    int points = 0;
+    size_t frames = ufft_get_args(args, &inbuf, &outbuf, &points, hw, batch);
+
+    if (hw) ufft_hw_run(&inbuf, &outbuf, points, frames, args[ARG_shift].u_int, args[ARG_inverse].u_bool);
+    else {
+        for (size_t i=0; i<frames; i++) {
+            ufft_sw_fft((int16_t *)inbuf.buf + (i * points * 2), (int16_t *)outbuf.buf + (i * points * 2),
+                    points, args[ARG_shift].u_int, args[ARG_inverse].u_bool);
+        }
+    }
+
+    return (args[ARG_output].u_obj == mp_const_none) ? args[ARG_input].u_obj : args[ARG_output].u_obj;
+}
+
+//----------------------------------------------------------------------------------
+STATIC mp_obj_t ufft_fft(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    return ufft_fft_common(n_args, pos_args, kw_args, true, false);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(ufft_fft_obj, 1, ufft_fft);
+
+// Process all frames from the input buffer, DMA channels are opened only once
+//------------------------------------------------------------------------------------
+STATIC mp_obj_t ufft_batch(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    return ufft_fft_common(n_args, pos_args, kw_args, true, true);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(ufft_batch_obj, 1, ufft_batch);
+
+//-------------------------------------------------------------------------------------
+STATIC mp_obj_t ufft_fft_sw(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    return ufft_fft_common(n_args, pos_args, kw_args, false, true);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(ufft_fft_sw_obj, 1, ufft_fft_sw);
+
+// Get complex input buffer and the output buffer or allocate new one
+//-----------------------------------------------------------------------------------------------------------------------------
+STATIC void *ufft_get_result_buf(size_t n_args, const mp_obj_t *args, mp_buffer_info_t *inbuf, size_t item_size, mp_obj_t *res)
+{
+    mp_get_buffer_raise(args[0], inbuf, MP_BUFFER_READ);
+    size_t points = inbuf->len / 4;
+    if ((n_args > 1) && (args[1] != mp_const_none)) {
+        mp_buffer_info_t outbuf;
+        mp_get_buffer_raise(args[1], &outbuf, MP_BUFFER_WRITE);
+        if (outbuf.len < (points * item_size)) {
+            mp_raise_ValueError("Output buffer too small");
+        }
+        *res = args[1];
+        return outbuf.buf;
+    }
+    void *buf = m_new_noscan(uint8_t, points * item_size);
+    *res = mp_obj_new_memoryview(((item_size == 2) ? 'H' : 'I') | MP_OBJ_ARRAY_TYPECODE_FLAG_RW, points, buf);
+    return buf;
+}
+
+// Returns the magnitude of each point as unsigned 16-bit values
+//-----------------------------------------------------------------
+STATIC mp_obj_t ufft_magnitude(size_t n_args, const mp_obj_t *args)
+{
+    mp_buffer_info_t inbuf;
+    mp_obj_t res;
+    uint16_t *out = (uint16_t *)ufft_get_result_buf(n_args, args, &inbuf, sizeof(uint16_t), &res);
+    ufft_calc_magnitude((int16_t *)inbuf.buf, out, inbuf.len / 4);
+    return res;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(ufft_magnitude_obj, 1, 2, ufft_magnitude);
+
+// Returns the power (re^2 + im^2) of each point as unsigned 32-bit values
+//-------------------------------------------------------------
+STATIC mp_obj_t ufft_power(size_t n_args, const mp_obj_t *args)
+{
+    mp_buffer_info_t inbuf;
+    mp_obj_t res;
+    uint32_t *out = (uint32_t *)ufft_get_result_buf(n_args, args, &inbuf, sizeof(uint32_t), &res);
+    ufft_calc_power((int16_t *)inbuf.buf, out, inbuf.len / 4);
+    return res;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(ufft_power_obj, 1, 2, ufft_power);
+
+// Convert the real 16-bit samples to complex FFT input data
+//-----------------------------------------------------------------
+STATIC mp_obj_t ufft_from_real(size_t n_args, const mp_obj_t *args)
+{
+    mp_buffer_info_t inbuf, outbuf;
+    mp_get_buffer_raise(args[0], &inbuf, MP_BUFFER_READ);
+    size_t samples = inbuf.len / 2;
+    mp_obj_t res;
+    if ((n_args > 1) && (args[1] != mp_const_none)) {
+        mp_get_buffer_raise(args[1], &outbuf, MP_BUFFER_WRITE);
+        if (outbuf.len < (samples * 4)) {
+            mp_raise_ValueError("Output buffer too small");
+        }
+        res = args[1];
+    }
+    else {
+        res = mp_obj_new_bytearray_by_ref(samples * 4, m_new_noscan(uint8_t, samples * 4));
+        mp_get_buffer_raise(res, &outbuf, MP_BUFFER_WRITE);
+    }
+    ufft_real_to_complex((int16_t *)inbuf.buf, (int16_t *)outbuf.buf, samples);
+    return res;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(ufft_from_real_obj, 1, 2, ufft_from_real);
+
+// Apply the window function to the 16-bit samples in place
+// If 'complex' is True, the buffer contains complex data and both parts are scaled
+//-------------------------------------------------------------------------------------
+STATIC mp_obj_t ufft_window(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_data, ARG_kind, ARG_complex };
+    STATIC const mp_arg_t allowed_args[] = {
+        { MP_QSTR_data,    MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_kind,                      MP_ARG_INT, {.u_int = UFFT_WINDOW_HANN} },
+        { MP_QSTR_complex,  MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[ARG_data].u_obj, &bufinfo, MP_BUFFER_RW);
+    int kind = args[ARG_kind].u_int;
+    if ((kind < UFFT_WINDOW_HANN) || (kind > UFFT_WINDOW_BLACKMAN)) {
+        mp_raise_ValueError("Unknown window type");
+    }
+    int step = (args[ARG_complex].u_bool) ? 2 : 1;
+    int n = bufinfo.len / (2 * step);
+    if (n < 2) return args[ARG_data].u_obj;
+
+    ufft_apply_window((int16_t *)bufinfo.buf, n, step, kind);
+    return args[ARG_data].u_obj;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(ufft_window_obj, 1, ufft_window);
+
+
+//===============================================================
+STATIC const mp_rom_map_elem_t mp_module_ufft_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__),    MP_ROM_QSTR(MP_QSTR_ufft) },
+    { MP_ROM_QSTR(MP_QSTR_fft),         MP_ROM_PTR(&ufft_fft_obj) },
+    { MP_ROM_QSTR(MP_QSTR_batch),       MP_ROM_PTR(&ufft_batch_obj) },
+    { MP_ROM_QSTR(MP_QSTR_fft_sw),      MP_ROM_PTR(&ufft_fft_sw_obj) },
+    { MP_ROM_QSTR(MP_QSTR_magnitude),   MP_ROM_PTR(&ufft_magnitude_obj) },
+    { MP_ROM_QSTR(MP_QSTR_power),       MP_ROM_PTR(&ufft_power_obj) },
+    { MP_ROM_QSTR(MP_QSTR_from_real),   MP_ROM_PTR(&ufft_from_real_obj) },
+    { MP_ROM_QSTR(MP_QSTR_window),      MP_ROM_PTR(&ufft_window_obj) },
+
+    { MP_ROM_QSTR(MP_QSTR_HANN),        MP_ROM_INT(UFFT_WINDOW_HANN) },
+    { MP_ROM_QSTR(MP_QSTR_HAMMING),     MP_ROM_INT(UFFT_WINDOW_HAMMING) },
+    { MP_ROM_QSTR(MP_QSTR_BLACKMAN),    MP_ROM_INT(UFFT_WINDOW_BLACKMAN) },
+};
+STATIC MP_DEFINE_CONST_DICT(mp_module_ufft_globals, mp_module_ufft_globals_table);
+
+//======================================
+const mp_obj_module_t mp_module_ufft = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t*)&mp_module_ufft_globals,
+};
+
+#endif // MICROPY_PY_UFFT
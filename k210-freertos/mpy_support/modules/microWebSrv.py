@@ -780,14 +780,13 @@ class MicroWebSrv :
                 if size > 0 :
                     with open(filepath, 'rb') as file :
                         self._writeBeforeContent(200, headers, contentType, None, size)
-                        buf = bytearray(2048)
-                        while size > 0 :
-                            x = file.readinto(buf)
-                            if x < len(buf) :
-                                buf = memoryview(buf)[:x]
-                            self._write(buf)
-                            size -= x
-                        return True
+                        # file read and socket send are overlapped in 'sendfile'
+                        n_sent = self._client._socket.sendfile(file, 0, size)
+                        if self._debug:
+                            print("    [{}] [RESPONSE] File: sent {} of {}".format(time.ticks_ms(), n_sent, size))
+                        # the file got shorter after its size was sent in the header,
+                        # the response is truncated
+                        return (n_sent == size)
             except Exception as err:
                 if self._debug:
                     print("    [{}] [RESPONSE] File: Exception: {}".format(time.ticks_ms(), err))
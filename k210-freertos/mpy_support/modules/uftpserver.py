@@ -10,7 +10,7 @@
 '''
 
 import network, socket, uos, utime
-import sys, gc, _thread, uerrno
+import sys, gc, _thread
 
 '''
 Features:
@@ -218,17 +218,17 @@ class MicroFtpSrv:
     def send_file_data(self, pos):
         try:
             file = open(self.path, "rb")
-            if pos > 0:
-                file.seek(pos)
         except:
             return False
         try:
-            chunk = file.read(2048)
-            while len(chunk) > 0:
-                _ = self.dataclient.write(chunk)
-                chunk = file.read(2048)
-                utime.sleep_ms(100)
+            size = max(uos.stat(self.path)[6] - pos, 0)
+            # any transfer error raises the exception
+            sent = self.dataclient.sendfile(file, pos)
             file.close()
+            if sent != size:
+                if self.debug:
+                    print ("Error sending file, sent {} of {}".format(sent, size))
+                return False
             return True
         except Exception as err:
             file.close()
@@ -251,33 +251,19 @@ class MicroFtpSrv:
                 print ("Error opening file.")
             return False
     
-        rec_cnt = 0;
         try:
-            while True:
-                chunk = self.dataclient.read(1024)
-                if len(chunk) > 0:
-                    file.write(chunk)
-                    rec_cnt += len(chunk)
-                else:
-                    if self.dataclient.peer_closed():
-                        if self.debug:
-                            print ("OK finished, received {}.".format(rec_cnt))
-                        break
-                    else:
-                        utime.sleep_ms(50)
-    
+            # receives until the remote client closes the data connection,
+            # any error (also the timeout or the file system full) raises the exception,
+            # the upload is not complete then
+            rec_cnt = self.dataclient.recvinto_file(file)
+            if self.debug:
+                print ("OK finished, received {}.".format(rec_cnt))
             file.close()
             return True
         except Exception as err:
             file.close()
             if self.debug:
                 sys.print_exception(err)
-            if err.args[0] == uerrno.ETIMEDOUT:
-                if self.debug:
-                    print ("OK finished (timeout), received {}.".format(rec_cnt))
-                return True
-
-            if self.debug:
                 print ("Error receiving file ({})".format(err))
             return False
 
@@ -35,6 +35,7 @@
 #include "py/objlist.h"
 #include "py/runtime.h"
 #include "py/smallint.h"
+#include "py/gc.h"
 
 #if MICROPY_PY_UTIMEQ_K210
 
@@ -146,13 +147,18 @@ STATIC mp_obj_t mod_utimeq_heappop(mp_obj_t heap_in, mp_obj_t list_ref) {
     }
 
     struct qentry *item = &heap->items[0];
-    ret->items[0] = mp_obj_new_int_from_ll(item->time);
+    mp_obj_t time = mp_obj_new_int_from_ll(item->time);
+    GC_WRITE_BARRIER_OBJ(ret->items);
+    GC_WRITE_BARRIER(item->callback);
+    GC_WRITE_BARRIER(item->args);
+    ret->items[0] = time;
     ret->items[1] = item->callback;
     ret->items[2] = item->args;
 
     heap->len -= 1;
 
     if (heap->len) {
+        GC_WRITE_BARRIER_MOVE(heap);
     	memmove(&heap->items[0], &heap->items[1], sizeof(struct qentry) * heap->len);
         //sort_items(heap);
         // we don't want to retain a pointers !
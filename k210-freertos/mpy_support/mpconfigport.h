@@ -83,7 +83,7 @@
 #define MICROPY_ENABLE_PYSTACK                  (1)
 //---------------------------------------------------------------------------
 
-#define MICROPY_K210_KPU_USED                   (0)
+#define MICROPY_K210_KPU_USED                   (1)
 
 // sqlite3 module uses ~416 KB of code (and SRAM) space
 #define MICROPY_PY_USE_SQLITE                   (0)
@@ -149,6 +149,9 @@
 
 #define MYCROPY_SYS_RAMBUF_SIZE                 1024
 extern uintptr_t sys_rambuf_ptr;
+
+// Number of entries in the boot time trace buffer (machine.boot_trace())
+#define MICRO_PY_BOOT_TRACE_SIZE                32
 //------------------------------------------------------------------------------------------------------------
 
 
@@ -176,6 +179,16 @@ extern uintptr_t sys_rambuf_ptr;
 
 #define MICRO_PY_FLASH_USED_END                 (MICRO_PY_FLASH_USER_VAR_START + MICRO_PY_FLASH_USER_VAR_SIZE)
 
+// Image of the precompiled modules executed in place from flash (created by 'make xipimg')
+#define MICRO_PY_XIPIMG_START_ADDRESS           (15*1024*1024)
+#define MICRO_PY_XIPIMG_SIZE                    (1024*1024)
+// Flash is memory mapped at this address when SPI3 XIP mode is enabled
+#define MICRO_PY_FLASH_XIP_ADDRESS              (0x54000000)  // same as w25qxx_FLASH_XIP_ADDRESS
+
+#if (MICRO_PY_XIPIMG_START_ADDRESS < MICRO_PY_FLASH_USED_END) || ((MICRO_PY_XIPIMG_START_ADDRESS + MICRO_PY_XIPIMG_SIZE) > MICRO_PY_FLASH_SIZE)
+#error "XIP image overlaps the used Flash area"
+#endif
+
 // -------------------------
 // File system configuration
 // -------------------------
@@ -280,6 +293,7 @@ extern void vm_loop_hook();
 
 // optimizations
 #define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE    (0)
+#define MICROPY_OPT_INLINE_CACHE                (1)
 
 #define MICROPY_OPT_COMPUTED_GOTO               (1)
 #define MICROPY_OPT_MPZ_BITWISE                 (1)
@@ -311,6 +325,11 @@ extern void vm_loop_hook();
 #define MICROPY_SCHEDULER_DEPTH                 (8)
 
 #define MICROPY_ENABLE_FINALISER                (1)
+#define MICROPY_GC_NOSCAN                       (1) // buffers are marked, but not scanned by the GC
+#define MICROPY_GC_PARALLEL_MARK                (1) // share the GC mark phase with the other core
+#define MICROPY_GC_LAZY_SWEEP                   (1) // time limited GC sweep slices, gc.lazy_sweep()
+#define MICROPY_GC_INCREMENTAL                  (1) // time limited GC mark slices, gc.incremental()
+#define MICROPY_GC_FREE_INDEX                   (1) // index of the free runs for larger allocations
 #define MICROPY_STACK_CHECK                     (1) // !do not change!
 #define MICROPY_ENABLE_EMERGENCY_EXCEPTION_BUF  (1)
 #define MICROPY_KBD_EXCEPTION                   (1)
@@ -325,7 +344,9 @@ extern void vm_loop_hook();
 #define MICROPY_MODULE_WEAK_LINKS               (1)
 
 #define MICROPY_PERSISTENT_CODE_LOAD            (1)
-#define MICROPY_PERSISTENT_CODE_SAVE            (0)
+#define MICROPY_PERSISTENT_CODE_SAVE            (1)
+// cache the compiled .py modules in '__pycache__' directories
+#define MICROPY_MODULE_CACHE_MPY                (1)
 
 #define MICROPY_COMP_RETURN_IF_EXPR             (1)
 
@@ -364,6 +385,8 @@ extern const struct _mp_print_t mp_debug_print;
 #define MICROPY_PY_GC                           (1)
 #define MICROPY_MODULE_FROZEN_STR               (0)
 #define MICROPY_MODULE_FROZEN_MPY               (1)
+#define MICROPY_MODULE_FROZEN_XIP               (1)
+#define MICROPY_MODULE_FROZEN_XIP_IMAGE         (mp_hal_xip_image())
 #define MICROPY_LONGINT_IMPL                    (MICROPY_LONGINT_IMPL_MPZ) //(MICROPY_LONGINT_IMPL_LONGLONG)
 
 //-----------------------------
@@ -451,7 +474,9 @@ extern const struct _mp_print_t mp_debug_print;
 
 #define MICROPY_PY_UCTYPES                      (1)
 #define MICROPY_PY_UZLIB                        (1)
+#define MICROPY_PY_UZLIB_COMPRESS               (1)
 #define MICROPY_PY_UJSON                        (1)
+#define MICROPY_PY_UJSON_STREAM                 (1)
 #define MICROPY_PY_URE                          (1)
 #define MICROPY_PY_URE_SUB                      (1)
 #define MICROPY_PY_UHEAPQ                       (1)
@@ -473,6 +498,9 @@ extern const struct _mp_print_t mp_debug_print;
 // K210 specific implementation of crypto functions
 #define MICROPY_PY_UCRYPTOLIB_K210              (1)
 
+// K210 hardware FFT module
+#define MICROPY_PY_UFFT                         (1)
+
 #define MICROPY_PY_UBINASCII                    (1)
 #define MICROPY_PY_UBINASCII_CRC32              (1)
 #define MICROPY_PY_URANDOM                      (1)
@@ -540,6 +568,9 @@ typedef int64_t mp_off_t;
 
 #define MP_PLAT_PRINT_STRN(str, len) mp_hal_stdout_tx_strn_cooked(str, len)
 
+// address of the XIP module image in memory mapped Flash, or NULL if not used
+const unsigned char *mp_hal_xip_image(void);
+
 // extra built in names to add to the global namespace
 #define MICROPY_PORT_BUILTINS \
     { MP_ROM_QSTR(MP_QSTR_open), MP_ROM_PTR(&mp_builtin_open_obj) },
@@ -571,6 +602,20 @@ extern const struct _mp_obj_module_t mp_module_ucryptolib;
 #define BUILTIN_MODULE_UCRYPTOLIB_K210
 #endif
 
+#if MICROPY_PY_UFFT
+extern const struct _mp_obj_module_t mp_module_ufft;
+#define BUILTIN_MODULE_UFFT { MP_ROM_QSTR(MP_QSTR_ufft), MP_ROM_PTR(&mp_module_ufft) },
+#else
+#define BUILTIN_MODULE_UFFT
+#endif
+
+#if MICROPY_K210_KPU_USED
+extern const struct _mp_obj_module_t mp_module_kpu;
+#define BUILTIN_MODULE_KPU { MP_ROM_QSTR(MP_QSTR_kpu), MP_ROM_PTR(&mp_module_kpu) },
+#else
+#define BUILTIN_MODULE_KPU
+#endif
+
 #if MICROPY_USE_DISPLAY
 extern const struct _mp_obj_module_t mp_module_display;
 #define BUILTIN_MODULE_DISPLAY { MP_OBJ_NEW_QSTR(MP_QSTR_display), (mp_obj_t)&mp_module_display },
@@ -616,6 +661,8 @@ extern const struct _mp_obj_module_t mp_test_module;
     BUILTIN_MODULE_NETWORK \
     BUILTIN_MODULE_UHASHLIB_K210 \
     BUILTIN_MODULE_UCRYPTOLIB_K210 \
+    BUILTIN_MODULE_UFFT \
+    BUILTIN_MODULE_KPU \
     BUILTIN_MODULE_DISPLAY \
     BUILTIN_MODULE_UTIMEQ_K210 \
     BUILTIN_MODULE_SQLITE \
@@ -35,6 +35,7 @@
 #include "py/obj.h"
 #include "py/mpstate.h"
 #include "py/mphal.h"
+#include "py/gc.h"
 #include "extmod/misc.h"
 #include "lib/utils/pyexec.h"
 #include "mphalport.h"
@@ -48,6 +49,7 @@
 #include "hal.h"
 #include "wdt.h"
 #include "w25qxx.h"
+#include "flashlock.h"
 #include "mpthreadport.h"
 #include "modmachine.h"
 #include "machine_uart.h"
@@ -130,6 +132,15 @@ void vm_loop_hook()
 
     if (wdt_reset_in_vm_hook) wdt_restart_counter(mpy_wdt);
 
+    #if MICROPY_GC_LAZY_SWEEP
+    // continue the pending lazy GC sweep
+    gc_sweep_step();
+    #endif
+    #if MICROPY_GC_INCREMENTAL
+    // and the incremental GC mark phase
+    gc_mark_step();
+    #endif
+
     if (mpy_config.config.use_two_main_tasks) {
         if (uxPortGetProcessorId() != MAIN_TASK_PROC) {
             if (task_ipc.irq) {
@@ -736,6 +747,62 @@ int mp_hal_get_file_block(uint8_t *buff, int size)
     return res;
 }
 
+// uarths RX interrupt handler for the bulk transfer
+// all received bytes are pushed to the ring buffer passed as userdata
+//==================================================
+static void on_irq_haluart_recv_ring(void *userdata)
+{
+    ringbuf_t *ring = (ringbuf_t *)userdata;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    uarths_rxdata_t recv;
+    bool received = false;
+
+    // empty the receive FIFO
+    while (1) {
+        recv = uarths->rxdata;
+        if (recv.empty) break;
+        ringbuf_put(ring, (uint8_t)recv.data);
+        received = true;
+    }
+    if (received) {
+        xSemaphoreGiveFromISR(mp_hal_uart_semaphore, &xHigherPriorityTaskWoken);
+        if( xHigherPriorityTaskWoken != pdFALSE ) {
+            portYIELD_FROM_ISR();
+        }
+    }
+}
+
+// Receive the uarths data into the ring buffer from the interrupt handler
+// The receiving continues while the task is busy with other work (writing to file system)
+//---------------------------------------------
+void mp_hal_uarths_setirq_ring(ringbuf_t *ring)
+{
+    mp_hal_uarths_setirqhandle(NULL, NULL);
+    xSemaphoreTake(mp_hal_uart_semaphore, 0);
+    mp_hal_uarths_setirqhandle(on_irq_haluart_recv_ring, (void *)ring);
+}
+
+// Get all bytes available in the ring buffer, max 'len'
+// If no data is available, wait max 'timeout' ms for data
+//-----------------------------------------------------------------------------------
+int mp_hal_uarths_read_ring(ringbuf_t *ring, uint8_t *buf, int len, uint32_t timeout)
+{
+    int n = 0;
+    while (1) {
+        uarths->ie.rxwm = 0;
+        while (n < len) {
+            int c = ringbuf_get(ring);
+            if (c < 0) break;
+            buf[n++] = (uint8_t)c;
+        }
+        uarths->ie.rxwm = 1;
+        if ((n > 0) || (timeout == 0)) break;
+        if (xSemaphoreTake(mp_hal_uart_semaphore, timeout / portTICK_PERIOD_MS) != pdTRUE) break;
+        timeout = 0;
+    }
+    return n;
+}
+
 //--------------------------------------------
 char wait_key(const char *prompt, int timeout)
 {
@@ -868,6 +935,125 @@ int mp_hal_send_file_block(uint8_t *buff, int size, bool docrc, int fsize)
     return res;
 }
 
+// =========================
+// === XIP modules image ===
+// =========================
+
+static const unsigned char *xip_image = NULL;
+
+// Check if the image of the precompiled modules is present in Flash
+// and enable the memory mapped (XIP) Flash access if it is.
+// The image content is checked when MicroPython is initialized.
+// The flash writes are coordinated with the code executed from the image by flashlock.c
+//------------------------
+bool mp_hal_xip_init(void)
+{
+    uint8_t magic[4];
+
+    xip_image = NULL;
+    if (w25qxx_read_data(MICRO_PY_XIPIMG_START_ADDRESS, magic, 4) != W25QXX_OK) return false;
+    if (memcmp(magic, "MPXI", 4) != 0) return false;
+    SemaphoreHandle_t *gil[FLASHLOCK_INSTANCES] = {&mp_state_ctx.vm.gil_mutex.handle, &mp_state_ctx2.vm.gil_mutex.handle};
+    if (!flashlock_init(gil)) return false;
+    if (w25qxx_enable_xip_mode() != W25QXX_OK) return false;
+    w25qxx_set_xip_lock(flashlock_xip_lock, flashlock_xip_unlock);
+    xip_image = (const unsigned char *)((uintptr_t)MICRO_PY_FLASH_XIP_ADDRESS + MICRO_PY_XIPIMG_START_ADDRESS);
+    return true;
+}
+
+//-----------------------------------------
+const unsigned char *mp_hal_xip_image(void)
+{
+    return xip_image;
+}
+
+// =========================
+// === Boot time tracing ===
+// =========================
+
+static boot_trace_t boot_trace[MICRO_PY_BOOT_TRACE_SIZE];
+static uint32_t boot_trace_count = 0;
+static uint32_t boot_trace_level = 0;   // used by 'main' and the tasks not running MicroPython
+static uint64_t boot_trace_offset = 0;
+
+// Each MicroPython instance has its own nesting level,
+// spans started by one instance must not indent the entries of the other
+//-------------------------------------------
+static uint32_t *boot_trace_level_ptr(void)
+{
+    mp_state_ctx_t *state = MP_STATE_STATE();
+    return (state) ? &state->vm.boot_trace_level : &boot_trace_level;
+}
+
+//-----------------------------------
+static uint64_t boot_trace_time(void)
+{
+    return boot_trace_offset + mp_hal_ticks_us();
+}
+
+//--------------------------------------------------------------------
+static int boot_trace_add(const char *name, uint64_t start, bool span)
+{
+    uint32_t idx = __atomic_fetch_add(&boot_trace_count, 1, __ATOMIC_RELAXED);
+    if (idx >= MICRO_PY_BOOT_TRACE_SIZE) return -1;
+
+    boot_trace_t *entry = &boot_trace[idx];
+    strncpy(entry->name, name, BOOT_TRACE_NAME_LEN-1);
+    entry->name[BOOT_TRACE_NAME_LEN-1] = '\0';
+    entry->level = *boot_trace_level_ptr();
+    entry->start = start;
+    entry->end = (span) ? 0 : start;
+    return idx;
+}
+
+// Called from 'main' as soon as the ticks counter is started.
+// 'mcycle' counts from reset, the cycles executed before that point
+// (ROM boot loader, firmware loading, clock setup) are converted
+// using the CPU frequency at 'main' entry ('reset_freq')
+//----------------------------------------------
+void mp_hal_boot_trace_init(uint32_t reset_freq)
+{
+    boot_trace_count = 0;
+    boot_trace_level = 0;
+    boot_trace_offset = sys_us_counter_cpu / (uint64_t)(reset_freq / 1000000);
+    int idx = boot_trace_add("reset", 0, true);
+    if (idx >= 0) boot_trace[idx].end = boot_trace_offset;
+}
+
+// Start the timed span, returns the index to be passed to 'mp_hal_boot_trace_end'
+//-------------------------------------------
+int mp_hal_boot_trace_begin(const char *name)
+{
+    int idx = boot_trace_add(name, boot_trace_time(), true);
+    (*boot_trace_level_ptr())++;
+    return idx;
+}
+
+//---------------------------------
+void mp_hal_boot_trace_end(int idx)
+{
+    uint32_t *level = boot_trace_level_ptr();
+    if (*level > 0) (*level)--;
+    if ((idx < 0) || (idx >= MICRO_PY_BOOT_TRACE_SIZE)) return;
+    boot_trace[idx].end = boot_trace_time();
+}
+
+// Record the time point (zero length entry)
+//-------------------------------------------
+void mp_hal_boot_trace_mark(const char *name)
+{
+    boot_trace_add(name, boot_trace_time(), false);
+}
+
+// Returns the number of the recorded entries
+//---------------------------------------------------
+int mp_hal_boot_trace_get(const boot_trace_t **trace)
+{
+    uint32_t count = __atomic_load_n(&boot_trace_count, __ATOMIC_RELAXED);
+    *trace = boot_trace;
+    return (count > MICRO_PY_BOOT_TRACE_SIZE) ? MICRO_PY_BOOT_TRACE_SIZE : count;
+}
+
 // ===================================
 // === MicroPython sleep functions ===
 // ===================================
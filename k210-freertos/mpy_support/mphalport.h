@@ -64,6 +64,16 @@ typedef struct _task_ipc_t {
     bool        irq;
 } __attribute__((aligned(8))) task_ipc_t;
 
+#define BOOT_TRACE_NAME_LEN         23
+
+// Boot time trace entry, times are in micro seconds since reset
+typedef struct _boot_trace_t {
+    uint64_t    start;
+    uint64_t    end;                        // 0 while the span is not finished
+    uint8_t     level;                      // nesting level of the span
+    char        name[BOOT_TRACE_NAME_LEN];
+} boot_trace_t;
+
 
 extern task_ipc_t task_ipc;
 extern SemaphoreHandle_t inter_proc_mutex;
@@ -80,6 +90,8 @@ void mp_hal_set_cpu_frequency(uint32_t freq);
 void mp_hal_uarths_setirqhandle(void *irq_handler, void *userdata);
 void mp_hal_uarths_setirq_default();
 void mp_hal_uarths_setirq_ymodem();
+void mp_hal_uarths_setirq_ring(ringbuf_t *ring);
+int mp_hal_uarths_read_ring(ringbuf_t *ring, uint8_t *buf, int len, uint32_t timeout);
 int mp_hal_stdin_rx_chr(void);
 void mp_hal_stdout_tx_strn(const char *str, size_t len);
 void mp_hal_debug_tx_strn_cooked(void *env, const char *str, size_t len);
@@ -110,6 +122,13 @@ mp_uint_t _mp_hal_delay_ms(mp_uint_t ms);
 void mp_hal_delay_us(mp_uint_t us);
 void mp_hal_delay_ms(mp_uint_t ms);
 void mp_hal_init(void);
+bool mp_hal_xip_init(void);
+
+void mp_hal_boot_trace_init(uint32_t reset_freq);
+int mp_hal_boot_trace_begin(const char *name);
+void mp_hal_boot_trace_end(int idx);
+void mp_hal_boot_trace_mark(const char *name);
+int mp_hal_boot_trace_get(const boot_trace_t **trace);
 
 #endif
 
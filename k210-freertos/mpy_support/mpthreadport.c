@@ -68,6 +68,10 @@ static SemaphoreHandle_t thread_mutex2 = NULL;
 thread_t thread_entry2;
 mp_state_ctx_t mp_state_ctx2 = { 0 };
 
+// Channels are shared by both MicroPython instances
+static thread_channel_t thread_channels[THREAD_MAX_CHANNELS] = { 0 };
+static SemaphoreHandle_t channel_mutex = NULL;
+
 extern void mp_thread_entry(void *args_in);
 
 
@@ -76,6 +80,12 @@ extern void mp_thread_entry(void *args_in);
 //-----------------------------------------------------------------------------------------------------
 void mp_thread_preinit(void *stack, uint32_t stack_len, void *pystack, int pystack_size, int task_proc)
 {
+    // Channels mutex is created only once, by the first MicroPython instance
+    if ((task_proc == MAIN_TASK_PROC) && (channel_mutex == NULL)) {
+        channel_mutex = xSemaphoreCreateMutex();
+        configASSERT(channel_mutex);
+    }
+
     // Initialize threads mutex and create thread local storage pointers
     if (mpy_config.config.use_two_main_tasks) {
         if (task_proc == MAIN_TASK_PROC) {
@@ -924,6 +934,69 @@ int mp_thread_getmsg(uint32_t *msg_int, uint8_t **buf, uint32_t *buflen, uint64_
     return res;
 }
 
+// === Zero-copy channels ===
+// The ring buffer operations are in threadchannel.c
+
+//-------------------------------------------------------------
+thread_channel_t *mp_thread_channel_open(int id, uint32_t size)
+{
+    thread_channel_t *ch = NULL;
+    if (channel_mutex == NULL) return NULL;
+
+    xSemaphoreTake(channel_mutex, portMAX_DELAY);
+    // Check if the channel with the same id is already opened
+    for (int i=0; i<THREAD_MAX_CHANNELS; i++) {
+        if ((thread_channels[i].nopen > 0) && (thread_channels[i].id == id)) {
+            ch = &thread_channels[i];
+            ch->nopen++;
+            break;
+        }
+    }
+    if (ch == NULL) {
+        for (int i=0; i<THREAD_MAX_CHANNELS; i++) {
+            if (thread_channels[i].nopen == 0) {
+                // Ring buffer size must be a power of 2
+                uint32_t rsize = THREAD_CHANNEL_MIN_SIZE;
+                while ((rsize < size) && (rsize < THREAD_CHANNEL_MAX_SIZE)) rsize <<= 1;
+                uint8_t *buf = pvPortMalloc(rsize);
+                if (buf != NULL) {
+                    ch = &thread_channels[i];
+                    memset(ch, 0, sizeof(thread_channel_t));
+                    ch->buf = buf;
+                    ch->size = rsize;
+                    ch->id = id;
+                    ch->nopen = 1;
+                }
+                break;
+            }
+        }
+    }
+    xSemaphoreGive(channel_mutex);
+    return ch;
+}
+
+// The ring buffer is not freed while a reservation or a received message is outstanding,
+// the channel is left opened and 0 is returned in that case
+//-----------------------------------------------
+int mp_thread_channel_close(thread_channel_t *ch)
+{
+    int res = 1;
+    if (channel_mutex == NULL) return 0;
+
+    xSemaphoreTake(channel_mutex, portMAX_DELAY);
+    if (ch->nopen == 1) {
+        if ((ch->reserved) || (ch->received)) res = 0;
+        else {
+            // No one is using the channel anymore, free the ring buffer
+            if (ch->buf) vPortFree(ch->buf);
+            memset(ch, 0, sizeof(thread_channel_t));
+        }
+    }
+    else if (ch->nopen > 1) ch->nopen--;
+    xSemaphoreGive(channel_mutex);
+    return res;
+}
+
 //-------------------------------------
 int mp_thread_status(TaskHandle_t id) {
 	int res = -1;
@@ -35,6 +35,7 @@
 #include "queue.h"
 #include "mpconfigport.h"
 #include "py/obj.h"
+#include "threadchannel.h"
 
 // Local storage pointers id's
 #define THREAD_LSP_STATE                    0
@@ -194,6 +195,9 @@ int mp_thread_sendmsg_to_mpy2(int type, uint32_t msg_int, uint8_t *buf, uint32_t
 int mp_thread_sendmsg_to_mpy1(int type, uint32_t msg_int, uint8_t *buf, uint32_t buflen);
 int mp_thread_getmsg(uint32_t *msg_int, uint8_t **buf, uint32_t *buflen, uint64_t *sender);
 
+thread_channel_t *mp_thread_channel_open(int id, uint32_t size);
+int mp_thread_channel_close(thread_channel_t *ch);
+
 int mp_thread_status(TaskHandle_t id);
 thread_t *mp_thread_get_thread(TaskHandle_t id, thread_t *self);
 
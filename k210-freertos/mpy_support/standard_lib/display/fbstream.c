@@ -0,0 +1,184 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "mpconfigport.h"
+
+#if MICROPY_USE_DISPLAY
+
+#include <string.h>
+#include "fbstream.h"
+
+#define OP_INDEX        0x00
+#define OP_DIFF         0x40
+#define OP_LUMA         0x80
+#define OP_RUN          0xC0
+#define OP_RUN16        0xDE
+#define OP_SKIP16       0xDF
+#define OP_SKIP         0xE0
+#define OP_RGB565       0xFE
+#define OP_END          0xFF
+#define OP_SHORT_MAX    30
+
+#define COLOR_HASH(c)   (((((c) >> 11) * 3) + ((((c) >> 5) & 0x3F) * 5) + (((c) & 0x1F) * 7)) & 0x3F)
+
+typedef struct {
+    uint8_t *buf;
+    int size;
+    int len;
+    int total;
+    int err;
+    fb_stream_write_t write;
+    void *ctx;
+} fb_stream_out_t;
+
+//-----------------------------------------
+static void out_flush(fb_stream_out_t *out)
+{
+    if ((out->len > 0) && (out->err == 0)) {
+        if (out->write(out->ctx, out->buf, out->len) != 0) out->err = 1;
+    }
+    out->total += out->len;
+    out->len = 0;
+}
+
+//----------------------------------------------------------
+static inline void out_byte(fb_stream_out_t *out, uint8_t b)
+{
+    out->buf[out->len++] = b;
+    if (out->len >= out->size) out_flush(out);
+}
+
+// Run or skip operation, short form for up to 30 pixels
+//-----------------------------------------------------------------------------------------
+static void out_repeat(fb_stream_out_t *out, uint8_t op_short, uint8_t op_long, uint32_t n)
+{
+    while (n > 0) {
+        if (n <= OP_SHORT_MAX) {
+            out_byte(out, op_short | (n - 1));
+            return;
+        }
+        uint32_t cnt = (n > 0xFFFF) ? 0xFFFF : n;
+        out_byte(out, op_long);
+        out_byte(out, cnt & 0xFF);
+        out_byte(out, cnt >> 8);
+        n -= cnt;
+    }
+}
+
+//=================================================================================================
+int fb_stream_encode(const color_t *fb, color_t *ref, int stride, int x, int y, int width, int height,
+                     uint8_t *chunk, int chunk_size, fb_stream_write_t write, void *ctx)
+{
+    fb_stream_out_t out = { .buf = chunk, .size = chunk_size, .write = write, .ctx = ctx };
+    color_t index[64];
+    color_t prev = 0;
+    uint32_t run = 0, skip = 0;
+
+    memset(index, 0, sizeof(index));
+
+    out_byte(&out, 'Q');
+    out_byte(&out, '5');
+    out_byte(&out, '6');
+    out_byte(&out, '5');
+    out_byte(&out, (ref) ? FB_STREAM_FLAG_DELTA : 0);
+    out_byte(&out, 0);
+    out_byte(&out, x & 0xFF);
+    out_byte(&out, x >> 8);
+    out_byte(&out, y & 0xFF);
+    out_byte(&out, y >> 8);
+    out_byte(&out, width & 0xFF);
+    out_byte(&out, width >> 8);
+    out_byte(&out, height & 0xFF);
+    out_byte(&out, height >> 8);
+
+    for (int row = y; row < (y + height); row++) {
+        const color_t *src = fb + (row * stride) + x;
+        color_t *refrow = (ref) ? ref + (row * stride) + x : NULL;
+        for (int col = 0; col < width; col++) {
+            color_t px = src[col];
+            // unchanged pixels in delta mode, continue the current run or skip if possible
+            if (skip && (px == refrow[col])) {
+                skip++;
+                prev = px;
+                continue;
+            }
+            if (px == prev) {
+                if (skip) {
+                    out_repeat(&out, OP_SKIP, OP_SKIP16, skip);
+                    skip = 0;
+                }
+                run++;
+                continue;
+            }
+            if (run) {
+                out_repeat(&out, OP_RUN, OP_RUN16, run);
+                run = 0;
+            }
+            if ((refrow) && (px == refrow[col])) {
+                skip = 1;
+                prev = px;
+                continue;
+            }
+            if (skip) {
+                out_repeat(&out, OP_SKIP, OP_SKIP16, skip);
+                skip = 0;
+            }
+
+            int hash = COLOR_HASH(px);
+            if (index[hash] == px) out_byte(&out, OP_INDEX | hash);
+            else {
+                index[hash] = px;
+                int dr = (int)(px >> 11) - (int)(prev >> 11);
+                int dg = (int)((px >> 5) & 0x3F) - (int)((prev >> 5) & 0x3F);
+                int db = (int)(px & 0x1F) - (int)(prev & 0x1F);
+                int dg_2 = dg >> 1;
+                if ((dr >= -2) && (dr <= 1) && (dg >= -2) && (dg <= 1) && (db >= -2) && (db <= 1)) {
+                    out_byte(&out, OP_DIFF | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+                }
+                else if ((dg >= -32) && (dg <= 31) && ((dr - dg_2) >= -8) && ((dr - dg_2) <= 7) &&
+                         ((db - dg_2) >= -8) && ((db - dg_2) <= 7)) {
+                    out_byte(&out, OP_LUMA | (dg + 32));
+                    out_byte(&out, ((dr - dg_2 + 8) << 4) | (db - dg_2 + 8));
+                }
+                else {
+                    out_byte(&out, OP_RGB565);
+                    out_byte(&out, px & 0xFF);
+                    out_byte(&out, px >> 8);
+                }
+            }
+            prev = px;
+        }
+        if (refrow) memcpy(refrow, src, width * sizeof(color_t));
+    }
+    if (run) out_repeat(&out, OP_RUN, OP_RUN16, run);
+    if (skip) out_repeat(&out, OP_SKIP, OP_SKIP16, skip);
+    out_byte(&out, OP_END);
+    out_flush(&out);
+
+    return (out.err) ? -1 : out.total;
+}
+
+#endif // MICROPY_USE_DISPLAY
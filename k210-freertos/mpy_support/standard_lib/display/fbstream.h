@@ -0,0 +1,87 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Compressed frame buffer stream
+ *
+ * The frame buffer (or its rectangle) is encoded with QOI-like operations
+ * adapted to RGB565 pixels. In delta mode, the pixels not changed since the previous
+ * encoded frame are skipped, the decoder keeps them from its copy of the frame.
+ *
+ * Stream format, multi-byte values are little endian:
+ *
+ *   header, 14 bytes:
+ *     'Q','5','6','5'
+ *     flags           bit 0: delta frame, the skip operations are used
+ *     0               reserved
+ *     x, y            2 bytes each, position of the encoded rectangle
+ *     width, height   2 bytes each
+ *   operations, the pixels of the rectangle row by row:
+ *     00iiiiii        INDEX, pixel = index[i]
+ *     01rrggbb        DIFF, r, g, b differences from the previous pixel, -2~1 (+2 bias)
+ *     10gggggg        LUMA, green difference -32~31 (+32 bias),
+ *       rrrrbbbb        followed by dr-dg/2 and db-dg/2, -8~7 (+8 bias)
+ *     110nnnnn        RUN, the previous pixel repeated n+1 times (n = 0~29)
+ *     11011110        RUN, followed by 2 bytes run length
+ *     11011111        SKIP, followed by 2 bytes number of skipped pixels
+ *     111nnnnn        SKIP, n+1 pixels are unchanged (n = 0~29)
+ *     11111110        RGB565 pixel value follows, 2 bytes
+ *     11111111        end of the frame
+ *
+ *   The previous pixel starts as 0 and the index table is cleared at the start of each frame.
+ *   Every pixel decoded from INDEX, DIFF, LUMA or RGB565 operation is stored into
+ *   index[(r*3 + g*5 + b*7) & 63], where r, g, b are the 5-6-5 color components.
+ *   After the SKIP, the previous pixel is the last skipped pixel.
+ *   DIFF and LUMA components do not wrap around.
+ */
+
+#ifndef _FBSTREAM_H_
+#define _FBSTREAM_H_
+
+#include "mpconfigport.h"
+
+#if MICROPY_USE_DISPLAY
+
+#include <stdint.h>
+#include "tftspi.h"
+
+#define FB_STREAM_HEADER_SIZE   14
+#define FB_STREAM_FLAG_DELTA    0x01
+
+// Output function, called with each filled chunk, returns 0 on success
+typedef int (*fb_stream_write_t)(void *ctx, const uint8_t *buf, int len);
+
+// Encode the rectangle of the frame buffer 'fb' ('stride' pixels per row)
+// The output is passed to 'write' in chunks of 'chunk_size' bytes using the buffer 'chunk'
+// If 'ref' is not NULL, the delta frame is encoded against it and the rectangle in 'ref' is updated
+// Returns the number of encoded bytes or -1 if the write function failed
+//================================================================================================
+int fb_stream_encode(const color_t *fb, color_t *ref, int stride, int x, int y, int width, int height,
+                     uint8_t *chunk, int chunk_size, fb_stream_write_t write, void *ctx);
+
+#endif // MICROPY_USE_DISPLAY
+
+#endif
@@ -37,6 +37,8 @@ uint8_t disp_used_spi_host = 0;
 
 #if MICROPY_USE_TFT
 extern const mp_obj_type_t display_tft_type;
+extern const mp_obj_type_t display_sprite_type;
+extern const mp_obj_type_t display_layer_type;
 #endif
 
 //===============================================================
@@ -45,6 +47,8 @@ STATIC const mp_rom_map_elem_t display_module_globals_table[] = {
 
     #if MICROPY_USE_TFT
     { MP_OBJ_NEW_QSTR(MP_QSTR_TFT), MP_ROM_PTR(&display_tft_type) },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_Sprite), MP_ROM_PTR(&display_sprite_type) },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_Layer), MP_ROM_PTR(&display_layer_type) },
     #endif
 };
 
@@ -48,6 +48,11 @@ typedef struct _display_tft_obj_t {
 } display_tft_obj_t;
 
 extern const mp_obj_type_t display_tft_type;
+extern const mp_obj_type_t display_sprite_type;
+extern const mp_obj_type_t display_layer_type;
+
+// Color argument: integer 16-bit color or (r, g, b) tuple
+color_t get_color(mp_obj_t color_in);
 
 typedef struct _display_epd_obj_t {
     mp_obj_base_t base;
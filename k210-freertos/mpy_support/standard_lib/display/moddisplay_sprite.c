@@ -0,0 +1,535 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "mpconfigport.h"
+
+#if MICROPY_USE_DISPLAY
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+
+#include "moddisplay.h"
+#include "sprite.h"
+
+#include "py/runtime.h"
+#include "py/objstr.h"
+
+typedef struct _display_sprite_obj_t {
+    mp_obj_base_t base;
+    tft_sprite_t spr;
+    mp_obj_t layer;                             // the layer the sprite is added to
+} display_sprite_obj_t;
+
+typedef struct _display_layer_obj_t {
+    mp_obj_base_t base;
+    tft_layer_t layer;
+    mp_obj_t sprites[TFT_LAYER_MAX_SPRITES];    // keeps the added sprites referenced
+} display_layer_obj_t;
+
+const mp_obj_type_t display_sprite_type;
+const mp_obj_type_t display_layer_type;
+
+//---------------------------------------------------------
+static display_sprite_obj_t *get_sprite(mp_obj_t sprite_in)
+{
+    if (!mp_obj_is_type(sprite_in, &display_sprite_type)) {
+        mp_raise_TypeError("Sprite object expected");
+    }
+    display_sprite_obj_t *self = MP_OBJ_TO_PTR(sprite_in);
+    if (self->spr.bitmap == NULL) {
+        mp_raise_ValueError("Sprite not initialized");
+    }
+    return self;
+}
+
+//--------------------------------------------------------------------
+static void sprite_write(display_sprite_obj_t *self, mp_obj_t data_in)
+{
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(data_in, &bufinfo, MP_BUFFER_READ);
+    size_t size = self->spr.width * self->spr.height * ((self->spr.format == SPRITE_FMT_PAL8) ? 1 : sizeof(color_t));
+    if (bufinfo.len != size) {
+        mp_raise_ValueError("wrong data size");
+    }
+    memcpy(self->spr.bitmap, bufinfo.buf, size);
+    TFT_sprite_changed(&self->spr);
+}
+
+//-------------------------------------------------------------------------
+static void sprite_set_palette(display_sprite_obj_t *self, mp_obj_t pal_in)
+{
+    mp_obj_t *items;
+    size_t n_items = 0;
+
+    if (self->spr.format != SPRITE_FMT_PAL8) {
+        mp_raise_ValueError("Sprite has no palette");
+    }
+    mp_obj_get_array(pal_in, &n_items, &items);
+    if ((n_items == 0) || (n_items > 256)) {
+        mp_raise_ValueError("palette must have 1~256 colors");
+    }
+    for (int i = 0; i < n_items; i++) {
+        self->spr.palette[i] = get_color(items[i]);
+    }
+    TFT_sprite_changed(&self->spr);
+}
+
+// ==== Sprite ====
+
+// Sprite(width, height, data=None, *, palette=None, key=-1, alpha=255, x=0, y=0, z=0)
+//--------------------------------------------------------------------------------------------------------------------
+STATIC mp_obj_t display_sprite_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    enum { ARG_width, ARG_height, ARG_data, ARG_palette, ARG_key, ARG_alpha, ARG_x, ARG_y, ARG_z };
+    const mp_arg_t allowed_args[] = {
+        { MP_QSTR_width,    MP_ARG_REQUIRED | MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_height,   MP_ARG_REQUIRED | MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_data,                       MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_palette,  MP_ARG_KW_ONLY  | MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_key,      MP_ARG_KW_ONLY  | MP_ARG_INT, { .u_int = -1 } },
+        { MP_QSTR_alpha,    MP_ARG_KW_ONLY  | MP_ARG_INT, { .u_int = 255 } },
+        { MP_QSTR_x,        MP_ARG_KW_ONLY  | MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_y,        MP_ARG_KW_ONLY  | MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_z,        MP_ARG_KW_ONLY  | MP_ARG_INT, { .u_int = 0 } },
+    };
+    mp_map_t kw_args;
+    mp_map_init_fixed_table(&kw_args, n_kw, args + n_args);
+    mp_arg_val_t pargs[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, args, &kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, pargs);
+
+    int width = pargs[ARG_width].u_int;
+    int height = pargs[ARG_height].u_int;
+    if ((width < 1) || (height < 1) || (width > 1024) || (height > 1024)) {
+        mp_raise_ValueError("Wrong sprite size");
+    }
+    uint8_t format = (pargs[ARG_palette].u_obj == mp_const_none) ? SPRITE_FMT_RGB565 : SPRITE_FMT_PAL8;
+
+    display_sprite_obj_t *self = m_new_obj_with_finaliser(display_sprite_obj_t);
+    self->base.type = &display_sprite_type;
+    self->layer = mp_const_none;
+    // The bitmap is allocated outside the MicroPython heap
+    if (!TFT_sprite_init(&self->spr, width, height, format)) {
+        mp_raise_msg(&mp_type_MemoryError, "Error allocating sprite bitmap");
+    }
+    self->spr.key = pargs[ARG_key].u_int;
+    self->spr.alpha = (pargs[ARG_alpha].u_int < 0) ? 0 : ((pargs[ARG_alpha].u_int > 255) ? 255 : pargs[ARG_alpha].u_int);
+    self->spr.x = pargs[ARG_x].u_int;
+    self->spr.y = pargs[ARG_y].u_int;
+    self->spr.z = pargs[ARG_z].u_int;
+
+    if (format == SPRITE_FMT_PAL8) sprite_set_palette(self, pargs[ARG_palette].u_obj);
+    if (pargs[ARG_data].u_obj != mp_const_none) sprite_write(self, pargs[ARG_data].u_obj);
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+//---------------------------------------------------------------------------------------------------
+STATIC void display_sprite_printinfo(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind)
+{
+    display_sprite_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->spr.bitmap == NULL) {
+        mp_printf(print, "Sprite(deinitialized)");
+        return;
+    }
+    mp_printf(print, "Sprite(%dx%d, %s, x=%d, y=%d, z=%d, visible=%s, key=%d, alpha=%d)",
+            self->spr.width, self->spr.height, (self->spr.format == SPRITE_FMT_PAL8) ? "PAL8" : "RGB565",
+            self->spr.x, self->spr.y, self->spr.z, self->spr.visible ? "True" : "False", self->spr.key, self->spr.alpha);
+}
+
+//----------------------------------------------------------------------
+STATIC mp_obj_t display_sprite_write(mp_obj_t self_in, mp_obj_t data_in)
+{
+    sprite_write(get_sprite(self_in), data_in);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(display_sprite_write_obj, display_sprite_write);
+
+//----------------------------------------------------------------------
+STATIC mp_obj_t display_sprite_fill(mp_obj_t self_in, mp_obj_t color_in)
+{
+    display_sprite_obj_t *self = get_sprite(self_in);
+    int n = self->spr.width * self->spr.height;
+    if (self->spr.format == SPRITE_FMT_PAL8) memset(self->spr.bitmap, mp_obj_get_int(color_in) & 0xFF, n);
+    else {
+        color_t color = get_color(color_in);
+        color_t *bitmap = (color_t *)self->spr.bitmap;
+        for (int i = 0; i < n; i++) bitmap[i] = color;
+    }
+    TFT_sprite_changed(&self->spr);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(display_sprite_fill_obj, display_sprite_fill);
+
+// Set the sprite pixel; the color is the palette index for the palettized sprite
+//-----------------------------------------------------------------------
+STATIC mp_obj_t display_sprite_pixel(size_t n_args, const mp_obj_t *args)
+{
+    display_sprite_obj_t *self = get_sprite(args[0]);
+    mp_int_t x = mp_obj_get_int(args[1]);
+    mp_int_t y = mp_obj_get_int(args[2]);
+    if ((x < 0) || (y < 0) || (x >= self->spr.width) || (y >= self->spr.height)) return mp_const_none;
+
+    if (self->spr.format == SPRITE_FMT_PAL8) self->spr.bitmap[(y * self->spr.width) + x] = mp_obj_get_int(args[3]) & 0xFF;
+    else ((color_t *)self->spr.bitmap)[(y * self->spr.width) + x] = get_color(args[3]);
+    TFT_sprite_changed(&self->spr);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(display_sprite_pixel_obj, 4, 4, display_sprite_pixel);
+
+//-------------------------------------------------------------------------
+STATIC mp_obj_t display_sprite_palette(size_t n_args, const mp_obj_t *args)
+{
+    display_sprite_obj_t *self = get_sprite(args[0]);
+    if (n_args > 1) {
+        sprite_set_palette(self, args[1]);
+        return mp_const_none;
+    }
+    if (self->spr.format != SPRITE_FMT_PAL8) return mp_const_none;
+    mp_obj_t list = mp_obj_new_list(0, NULL);
+    for (int i = 0; i < 256; i++) {
+        mp_obj_list_append(list, mp_obj_new_int(self->spr.palette[i]));
+    }
+    return list;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(display_sprite_palette_obj, 1, 2, display_sprite_palette);
+
+//---------------------------------------------------------------------------------
+STATIC mp_obj_t display_sprite_move(mp_obj_t self_in, mp_obj_t x_in, mp_obj_t y_in)
+{
+    display_sprite_obj_t *self = get_sprite(self_in);
+    TFT_sprite_move(&self->spr, mp_obj_get_int(x_in), mp_obj_get_int(y_in));
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(display_sprite_move_obj, display_sprite_move);
+
+//--------------------------------------------------
+STATIC mp_obj_t display_sprite_pos(mp_obj_t self_in)
+{
+    display_sprite_obj_t *self = get_sprite(self_in);
+    mp_obj_t tuple[2];
+    tuple[0] = mp_obj_new_int(self->spr.x);
+    tuple[1] = mp_obj_new_int(self->spr.y);
+    return mp_obj_new_tuple(2, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(display_sprite_pos_obj, display_sprite_pos);
+
+//---------------------------------------------------
+STATIC mp_obj_t display_sprite_size(mp_obj_t self_in)
+{
+    display_sprite_obj_t *self = get_sprite(self_in);
+    mp_obj_t tuple[2];
+    tuple[0] = mp_obj_new_int(self->spr.width);
+    tuple[1] = mp_obj_new_int(self->spr.height);
+    return mp_obj_new_tuple(2, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(display_sprite_size_obj, display_sprite_size);
+
+//-------------------------------------------------------------------------
+STATIC mp_obj_t display_sprite_visible(size_t n_args, const mp_obj_t *args)
+{
+    display_sprite_obj_t *self = get_sprite(args[0]);
+    if (n_args > 1) TFT_sprite_set_visible(&self->spr, mp_obj_is_true(args[1]));
+    return mp_obj_new_bool(self->spr.visible);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(display_sprite_visible_obj, 1, 2, display_sprite_visible);
+
+//-------------------------------------------------------------------
+STATIC mp_obj_t display_sprite_z(size_t n_args, const mp_obj_t *args)
+{
+    display_sprite_obj_t *self = get_sprite(args[0]);
+    if (n_args > 1) TFT_sprite_set_z(&self->spr, mp_obj_get_int(args[1]));
+    return mp_obj_new_int(self->spr.z);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(display_sprite_z_obj, 1, 2, display_sprite_z);
+
+// Transparent color (palette index for palettized sprite), -1 if not used
+//---------------------------------------------------------------------
+STATIC mp_obj_t display_sprite_key(size_t n_args, const mp_obj_t *args)
+{
+    display_sprite_obj_t *self = get_sprite(args[0]);
+    if (n_args > 1) {
+        self->spr.key = (args[1] == mp_const_none) ? -1 : mp_obj_get_int(args[1]);
+        TFT_sprite_changed(&self->spr);
+    }
+    return mp_obj_new_int(self->spr.key);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(display_sprite_key_obj, 1, 2, display_sprite_key);
+
+//-----------------------------------------------------------------------
+STATIC mp_obj_t display_sprite_alpha(size_t n_args, const mp_obj_t *args)
+{
+    display_sprite_obj_t *self = get_sprite(args[0]);
+    if (n_args > 1) {
+        mp_int_t alpha = mp_obj_get_int(args[1]);
+        self->spr.alpha = (alpha < 0) ? 0 : ((alpha > 255) ? 255 : alpha);
+        TFT_sprite_changed(&self->spr);
+    }
+    return mp_obj_new_int(self->spr.alpha);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(display_sprite_alpha_obj, 1, 2, display_sprite_alpha);
+
+//-----------------------------------------------------
+STATIC mp_obj_t display_sprite_deinit(mp_obj_t self_in)
+{
+    display_sprite_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->layer != mp_const_none) {
+        display_layer_obj_t *layer = MP_OBJ_TO_PTR(self->layer);
+        for (int i = 0; i < TFT_LAYER_MAX_SPRITES; i++) {
+            if (layer->sprites[i] == self_in) layer->sprites[i] = MP_OBJ_NULL;
+        }
+        TFT_layer_remove(&layer->layer, &self->spr);
+        self->layer = mp_const_none;
+    }
+    TFT_sprite_free(&self->spr);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(display_sprite_deinit_obj, display_sprite_deinit);
+
+// The finaliser must not access the layer, it may be already collected.
+// A sprite in a layer is referenced by it, so it is only collected together
+// with the layer, which is never composed again.
+//--------------------------------------------------
+STATIC mp_obj_t display_sprite_del(mp_obj_t self_in)
+{
+    display_sprite_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    self->layer = mp_const_none;
+    TFT_sprite_free(&self->spr);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(display_sprite_del_obj, display_sprite_del);
+
+//==================================================================
+STATIC const mp_rom_map_elem_t display_sprite_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_write),               MP_ROM_PTR(&display_sprite_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_fill),                MP_ROM_PTR(&display_sprite_fill_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pixel),               MP_ROM_PTR(&display_sprite_pixel_obj) },
+    { MP_ROM_QSTR(MP_QSTR_palette),             MP_ROM_PTR(&display_sprite_palette_obj) },
+    { MP_ROM_QSTR(MP_QSTR_move),                MP_ROM_PTR(&display_sprite_move_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pos),                 MP_ROM_PTR(&display_sprite_pos_obj) },
+    { MP_ROM_QSTR(MP_QSTR_size),                MP_ROM_PTR(&display_sprite_size_obj) },
+    { MP_ROM_QSTR(MP_QSTR_visible),             MP_ROM_PTR(&display_sprite_visible_obj) },
+    { MP_ROM_QSTR(MP_QSTR_z),                   MP_ROM_PTR(&display_sprite_z_obj) },
+    { MP_ROM_QSTR(MP_QSTR_key),                 MP_ROM_PTR(&display_sprite_key_obj) },
+    { MP_ROM_QSTR(MP_QSTR_alpha),               MP_ROM_PTR(&display_sprite_alpha_obj) },
+    { MP_ROM_QSTR(MP_QSTR_deinit),              MP_ROM_PTR(&display_sprite_deinit_obj) },
+    { MP_ROM_QSTR(MP_QSTR___del__),             MP_ROM_PTR(&display_sprite_del_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(display_sprite_locals_dict, display_sprite_locals_dict_table);
+
+//=========================================
+const mp_obj_type_t display_sprite_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_Sprite,
+    .print = display_sprite_printinfo,
+    .make_new = display_sprite_make_new,
+    .locals_dict = (mp_obj_dict_t*)&display_sprite_locals_dict,
+};
+
+
+// ==== Layer ====
+
+// Layer(bg=None)
+// bg=None: the current frame buffer content is used as the background image
+// bg=color: the background is filled with the color, no background image is allocated
+//-------------------------------------------------------------------------------------------------------------------
+STATIC mp_obj_t display_layer_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 0, 1, false);
+
+    if ((!use_frame_buffer) || (tft_frame_buffer == NULL)) {
+        mp_raise_ValueError("Frame buffer must be used");
+    }
+
+    bool use_image = ((n_args == 0) || (args[0] == mp_const_none));
+    color_t bg_color = use_image ? 0 : get_color(args[0]);
+
+    display_layer_obj_t *self = m_new_obj_with_finaliser(display_layer_obj_t);
+    memset(self, 0, sizeof(display_layer_obj_t));
+    self->base.type = &display_layer_type;
+    // The background image is allocated outside the MicroPython heap
+    if (!TFT_layer_init(&self->layer, use_image, bg_color)) {
+        mp_raise_msg(&mp_type_MemoryError, "Error allocating background image");
+    }
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+//--------------------------------------------------------------------------------------------------
+STATIC void display_layer_printinfo(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind)
+{
+    display_layer_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_printf(print, "Layer(%dx%d, sprites=%d, background=", self->layer.width, self->layer.height, self->layer.n_sprites);
+    if (self->layer.bg) mp_printf(print, "image)");
+    else mp_printf(print, "0x%04X)", self->layer.bg_color);
+}
+
+//---------------------------------------------------------------------
+STATIC mp_obj_t display_layer_add(mp_obj_t self_in, mp_obj_t sprite_in)
+{
+    display_layer_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    display_sprite_obj_t *sprite = get_sprite(sprite_in);
+
+    if (sprite->layer == self_in) return mp_const_none;
+    if (sprite->layer != mp_const_none) {
+        // move the sprite from the other layer
+        display_layer_obj_t *other = MP_OBJ_TO_PTR(sprite->layer);
+        for (int i = 0; i < TFT_LAYER_MAX_SPRITES; i++) {
+            if (other->sprites[i] == sprite_in) other->sprites[i] = MP_OBJ_NULL;
+        }
+        TFT_layer_remove(&other->layer, &sprite->spr);
+        sprite->layer = mp_const_none;
+    }
+    if (!TFT_layer_add(&self->layer, &sprite->spr)) {
+        mp_raise_ValueError("Too many sprites in layer");
+    }
+    for (int i = 0; i < TFT_LAYER_MAX_SPRITES; i++) {
+        if (self->sprites[i] == MP_OBJ_NULL) {
+            self->sprites[i] = sprite_in;
+            break;
+        }
+    }
+    sprite->layer = self_in;
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(display_layer_add_obj, display_layer_add);
+
+//------------------------------------------------------------------------
+STATIC mp_obj_t display_layer_remove(mp_obj_t self_in, mp_obj_t sprite_in)
+{
+    display_layer_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    display_sprite_obj_t *sprite = get_sprite(sprite_in);
+
+    if (sprite->layer != self_in) return mp_const_none;
+    for (int i = 0; i < TFT_LAYER_MAX_SPRITES; i++) {
+        if (self->sprites[i] == sprite_in) self->sprites[i] = MP_OBJ_NULL;
+    }
+    TFT_layer_remove(&self->layer, &sprite->spr);
+    sprite->layer = mp_const_none;
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(display_layer_remove_obj, display_layer_remove);
+
+// damage([x, y, w, h]), mark the area for redraw; the whole screen if no argument is given
+//-----------------------------------------------------------------------
+STATIC mp_obj_t display_layer_damage(size_t n_args, const mp_obj_t *args)
+{
+    display_layer_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    if (n_args == 1) {
+        TFT_layer_damage(&self->layer, 0, 0, _width - 1, _height - 1);
+        return mp_const_none;
+    }
+    if (n_args != 5) {
+        mp_raise_TypeError("expected x, y, width, height");
+    }
+    mp_int_t x = mp_obj_get_int(args[1]);
+    mp_int_t y = mp_obj_get_int(args[2]);
+    mp_int_t w = mp_obj_get_int(args[3]);
+    mp_int_t h = mp_obj_get_int(args[4]);
+    if ((w > 0) && (h > 0)) TFT_layer_damage(&self->layer, x, y, x + w - 1, y + h - 1);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(display_layer_damage_obj, 1, 5, display_layer_damage);
+
+// bgdraw(True) redirects the display drawing functions into the background image
+//--------------------------------------------------------------------
+STATIC mp_obj_t display_layer_bgdraw(mp_obj_t self_in, mp_obj_t on_in)
+{
+    display_layer_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (!TFT_layer_bgdraw(&self->layer, mp_obj_is_true(on_in))) {
+        mp_raise_ValueError("Layer has no background image");
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(display_layer_bgdraw_obj, display_layer_bgdraw);
+
+// compose(show=True)
+// Redraw the damaged areas into the frame buffer and send them to the display
+// Returns the number of redrawn areas
+//-----------------------------------------------------------------------------------------------
+STATIC mp_obj_t display_layer_compose(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    const mp_arg_t allowed_args[] = {
+        { MP_QSTR_show, MP_ARG_BOOL, { .u_bool = true } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    display_layer_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    int n = TFT_layer_compose(&self->layer, args[0].u_bool);
+    if (n < 0) {
+        mp_raise_ValueError("Display size changed or frame buffer not used");
+    }
+    return mp_obj_new_int(n);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(display_layer_compose_obj, 1, display_layer_compose);
+
+//----------------------------------------------------
+STATIC mp_obj_t display_layer_deinit(mp_obj_t self_in)
+{
+    display_layer_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    for (int i = 0; i < TFT_LAYER_MAX_SPRITES; i++) {
+        if (self->sprites[i] != MP_OBJ_NULL) {
+            ((display_sprite_obj_t *)MP_OBJ_TO_PTR(self->sprites[i]))->layer = mp_const_none;
+            self->sprites[i] = MP_OBJ_NULL;
+        }
+    }
+    TFT_layer_free(&self->layer);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(display_layer_deinit_obj, display_layer_deinit);
+
+// The finaliser must not access the sprites, they may be already collected
+//-------------------------------------------------
+STATIC mp_obj_t display_layer_del(mp_obj_t self_in)
+{
+    display_layer_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    self->layer.n_sprites = 0;
+    TFT_layer_free(&self->layer);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(display_layer_del_obj, display_layer_del);
+
+//=================================================================
+STATIC const mp_rom_map_elem_t display_layer_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_add),                 MP_ROM_PTR(&display_layer_add_obj) },
+    { MP_ROM_QSTR(MP_QSTR_remove),              MP_ROM_PTR(&display_layer_remove_obj) },
+    { MP_ROM_QSTR(MP_QSTR_damage),              MP_ROM_PTR(&display_layer_damage_obj) },
+    { MP_ROM_QSTR(MP_QSTR_bgdraw),              MP_ROM_PTR(&display_layer_bgdraw_obj) },
+    { MP_ROM_QSTR(MP_QSTR_compose),             MP_ROM_PTR(&display_layer_compose_obj) },
+    { MP_ROM_QSTR(MP_QSTR_deinit),              MP_ROM_PTR(&display_layer_deinit_obj) },
+    { MP_ROM_QSTR(MP_QSTR___del__),             MP_ROM_PTR(&display_layer_del_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(display_layer_locals_dict, display_layer_locals_dict_table);
+
+//========================================
+const mp_obj_type_t display_layer_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_Layer,
+    .print = display_layer_printinfo,
+    .make_new = display_layer_make_new,
+    .locals_dict = (mp_obj_dict_t*)&display_layer_locals_dict,
+};
+
+#endif // MICROPY_USE_DISPLAY
@@ -39,12 +39,14 @@
 #include "sysctl.h"
 
 #include "moddisplay.h"
+#include "fbstream.h"
 #include "modmachine.h"
 
 #include "py/runtime.h"
 #include "py/objstr.h"
 #include "extmod/vfs.h"
 #include "py/stream.h"
+#include "py/mperrno.h"
 
 // constructor(id, ...)
 //-----------------------------------------------------------------------------------------------------------------
@@ -176,8 +178,8 @@ static color_t rgb2color(uint8_t r, uint8_t g, uint8_t b)
     return color;
 }
 
-//-----------------------------------------
-static color_t get_color(mp_obj_t color_in)
+//----------------------------------
+color_t get_color(mp_obj_t color_in)
 {
     if (mp_obj_is_int(color_in)) return mp_obj_get_int(color_in);
 
@@ -1038,6 +1040,20 @@ STATIC mp_obj_t display_tft_show(mp_obj_t self_in)
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(display_tft_show_obj, display_tft_show);
 
+// Reference frame for the delta frame buffer stream, allocated on first use
+static color_t *fb_stream_ref = NULL;
+static int fb_stream_ref_size = 0;
+
+//----------------------------------
+static void fb_stream_ref_free(void)
+{
+    if (fb_stream_ref) {
+        vPortFree(fb_stream_ref);
+        fb_stream_ref = NULL;
+        fb_stream_ref_size = 0;
+    }
+}
+
 //----------------------------------------------------------------------
 STATIC mp_obj_t display_tft_use_tft_fb(size_t n_args, const mp_obj_t *args)
 {
@@ -1055,6 +1071,7 @@ STATIC mp_obj_t display_tft_use_tft_fb(size_t n_args, const mp_obj_t *args)
                 vPortFree(tft_frame_buffer);
                 tft_frame_buffer = NULL;
             }
+            fb_stream_ref_free();
         }
     }
     return mp_obj_new_bool(use_frame_buffer);
@@ -1228,6 +1245,133 @@ STATIC mp_obj_t display_tft_fb_write(size_t n_args, const mp_obj_t *pos_args, mp
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_KW(display_tft_fb_write_obj, 1, display_tft_fb_write);
 
+typedef struct {
+    mp_obj_t stream;
+    vstr_t *vstr;
+    int errcode;
+} fb_stream_dest_t;
+
+//----------------------------------------------------------------
+static int fb_stream_write(void *ctx, const uint8_t *buf, int len)
+{
+    fb_stream_dest_t *dest = (fb_stream_dest_t *)ctx;
+    if (dest->vstr) {
+        vstr_add_strn(dest->vstr, (const char *)buf, len);
+        return 0;
+    }
+    if (mp_stream_rw(dest->stream, (void *)buf, len, &dest->errcode, MP_STREAM_RW_WRITE) != len) return -1;
+    return 0;
+}
+
+// Compress the frame buffer or its rectangle to the stream or socket in 'chunk' size blocks
+// If 'delta=True', only the pixels changed since the previous call are sent,
+// the first call encodes the full (key) frame
+// Returns the compressed frame as bytes object if 'dest' is not given,
+// otherwise the number of bytes written
+//-----------------------------------------------------------------------------------------------
+STATIC mp_obj_t display_tft_fb_stream(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_dest, ARG_x, ARG_y, ARG_width, ARG_height, ARG_delta, ARG_chunk };
+    const mp_arg_t allowed_args[] = {
+        { MP_QSTR_dest,                     MP_ARG_OBJ,  { .u_obj = mp_const_none } },
+        { MP_QSTR_x,                        MP_ARG_INT,  { .u_int = 0 } },
+        { MP_QSTR_y,                        MP_ARG_INT,  { .u_int = 0 } },
+        { MP_QSTR_width,                    MP_ARG_INT,  { .u_int = _width } },
+        { MP_QSTR_height,                   MP_ARG_INT,  { .u_int = _height } },
+        { MP_QSTR_delta,  MP_ARG_KW_ONLY  | MP_ARG_BOOL, { .u_bool = false } },
+        { MP_QSTR_chunk,  MP_ARG_KW_ONLY  | MP_ARG_INT,  { .u_int = 1024 } },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if ((!use_frame_buffer) || (tft_frame_buffer == NULL)) {
+        mp_raise_msg(&mp_type_OSError, "Framebuffer not used");
+    }
+    int x = args[ARG_x].u_int;
+    int y = args[ARG_y].u_int;
+    int width = args[ARG_width].u_int;
+    int height = args[ARG_height].u_int;
+    if ((x < 0) || (y < 0) || (width < 1) || (height < 1) || ((x + width) > _width) || ((y + height) > _height)) {
+        mp_raise_ValueError("Wrong coordinates");
+    }
+    int chunk_size = args[ARG_chunk].u_int;
+    if ((chunk_size < 64) || (chunk_size > 16384)) {
+        mp_raise_ValueError("chunk size must be 64~16384");
+    }
+
+    color_t *ref = NULL;
+    bool key_frame = true;
+    if ((args[ARG_delta].u_bool) || (fb_stream_ref)) {
+        // the reference frame is kept updated after it was first requested
+        if (fb_stream_ref_size != (_width * _height)) {
+            if (fb_stream_ref) vPortFree(fb_stream_ref);
+            fb_stream_ref_size = 0;
+            fb_stream_ref = pvPortMalloc(_width * _height * sizeof(color_t));
+            if (fb_stream_ref == NULL) {
+                mp_raise_msg(&mp_type_MemoryError, "Error allocating reference frame");
+            }
+            // the receiver's frame starts cleared
+            memset(fb_stream_ref, 0, _width * _height * sizeof(color_t));
+            fb_stream_ref_size = _width * _height;
+        }
+        else if (args[ARG_delta].u_bool) key_frame = false;
+        ref = fb_stream_ref;
+    }
+
+    fb_stream_dest_t dest = { .stream = args[ARG_dest].u_obj, .vstr = NULL, .errcode = 0 };
+    vstr_t vstr;
+    bool close = false;
+    if (dest.stream == mp_const_none) {
+        vstr_init(&vstr, chunk_size);
+        dest.vstr = &vstr;
+    }
+    else if (mp_obj_is_str(dest.stream)) {
+        mp_obj_t fargs[2];
+        fargs[0] = dest.stream;
+        fargs[1] = mp_obj_new_str("wb", 2);
+        dest.stream = mp_vfs_open(2, fargs, (mp_map_t*)&mp_const_empty_map);
+        close = true;
+    }
+    else mp_get_stream_raise(dest.stream, MP_STREAM_OP_WRITE);
+
+    int len = -1;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        uint8_t *chunk = m_new(uint8_t, chunk_size);
+        if (key_frame) {
+            len = fb_stream_encode(tft_frame_buffer, NULL, _width, x, y, width, height, chunk, chunk_size, fb_stream_write, &dest);
+            if (ref) {
+                for (int i = y; i < (y + height); i++) {
+                    memcpy(ref + (i * _width) + x, tft_frame_buffer + (i * _width) + x, width * sizeof(color_t));
+                }
+            }
+        }
+        else len = fb_stream_encode(tft_frame_buffer, ref, _width, x, y, width, height, chunk, chunk_size, fb_stream_write, &dest);
+        m_del(uint8_t, chunk, chunk_size);
+        nlr_pop();
+    }
+    else {
+        // Exception from the allocation or from the stream's write method,
+        // the file opened here must not be left opened
+        if (close) mp_stream_close(dest.stream);
+        // the receiver state is unknown, the next frame must be the key frame
+        fb_stream_ref_free();
+        nlr_jump(nlr.ret_val);
+    }
+
+    if (close) mp_stream_close(dest.stream);
+    if (dest.vstr) return mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr);
+    if (len < 0) {
+        // the receiver state is unknown, the next frame must be the key frame
+        fb_stream_ref_free();
+        // short write without an error code (eg. stream closed by the peer)
+        mp_raise_OSError((dest.errcode) ? dest.errcode : MP_EIO);
+    }
+    return mp_obj_new_int(len);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(display_tft_fb_stream_obj, 1, display_tft_fb_stream);
+
 
 //================================================================
 STATIC const mp_rom_map_elem_t display_tft_locals_dict_table[] = {
@@ -1274,6 +1418,7 @@ STATIC const mp_rom_map_elem_t display_tft_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_useFB),               MP_ROM_PTR(&display_tft_use_tft_fb_obj) },
     { MP_ROM_QSTR(MP_QSTR_FBread),              MP_ROM_PTR(&display_tft_fb_read_obj) },
     { MP_ROM_QSTR(MP_QSTR_FBwrite),             MP_ROM_PTR(&display_tft_fb_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_FBstream),            MP_ROM_PTR(&display_tft_fb_stream_obj) },
 
     // class constants
     { MP_ROM_QSTR(MP_QSTR_CENTER),              MP_ROM_INT(CENTER) },
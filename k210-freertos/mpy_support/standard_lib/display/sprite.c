@@ -0,0 +1,375 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "mpconfigport.h"
+
+#if MICROPY_USE_DISPLAY
+
+#include <string.h>
+#include "FreeRTOS.h"
+#include "sprite.h"
+
+
+// ==== Rectangles ====
+
+//--------------------------------------------------------------
+static bool rect_touch(const tft_rect_t *a, const tft_rect_t *b)
+{
+    // overlapping or adjacent rectangles
+    return ((a->x1 <= (b->x2 + 1)) && (b->x1 <= (a->x2 + 1)) && (a->y1 <= (b->y2 + 1)) && (b->y1 <= (a->y2 + 1)));
+}
+
+//--------------------------------------------------------
+static void rect_union(tft_rect_t *a, const tft_rect_t *b)
+{
+    if (b->x1 < a->x1) a->x1 = b->x1;
+    if (b->y1 < a->y1) a->y1 = b->y1;
+    if (b->x2 > a->x2) a->x2 = b->x2;
+    if (b->y2 > a->y2) a->y2 = b->y2;
+}
+
+//---------------------------------------------------------------------------------
+static bool rect_intersect(tft_rect_t *r, const tft_rect_t *a, const tft_rect_t *b)
+{
+    r->x1 = (a->x1 > b->x1) ? a->x1 : b->x1;
+    r->y1 = (a->y1 > b->y1) ? a->y1 : b->y1;
+    r->x2 = (a->x2 < b->x2) ? a->x2 : b->x2;
+    r->y2 = (a->y2 < b->y2) ? a->y2 : b->y2;
+    return ((r->x1 <= r->x2) && (r->y1 <= r->y2));
+}
+
+//--------------------------------------------
+static uint32_t rect_area(const tft_rect_t *r)
+{
+    return (uint32_t)(r->x2 - r->x1 + 1) * (uint32_t)(r->y2 - r->y1 + 1);
+}
+
+//-------------------------------------------------------------
+static void sprite_rect(const tft_sprite_t *spr, tft_rect_t *r)
+{
+    r->x1 = spr->x;
+    r->y1 = spr->y;
+    r->x2 = spr->x + spr->width - 1;
+    r->y2 = spr->y + spr->height - 1;
+}
+
+
+// ==== Sprites ====
+
+//----------------------------------------------------------------------------
+bool TFT_sprite_init(tft_sprite_t *spr, int width, int height, uint8_t format)
+{
+    memset(spr, 0, sizeof(tft_sprite_t));
+    size_t size = width * height * ((format == SPRITE_FMT_PAL8) ? 1 : sizeof(color_t));
+    spr->bitmap = pvPortMalloc(size);
+    if (spr->bitmap == NULL) return false;
+    memset(spr->bitmap, 0, size);
+    if (format == SPRITE_FMT_PAL8) {
+        spr->palette = pvPortMalloc(256 * sizeof(color_t));
+        if (spr->palette == NULL) {
+            vPortFree(spr->bitmap);
+            spr->bitmap = NULL;
+            return false;
+        }
+        memset(spr->palette, 0, 256 * sizeof(color_t));
+    }
+    spr->width = width;
+    spr->height = height;
+    spr->format = format;
+    spr->alpha = 255;
+    spr->key = -1;
+    spr->visible = true;
+    spr->dirty = true;
+    return true;
+}
+
+//-------------------------------------
+void TFT_sprite_free(tft_sprite_t *spr)
+{
+    if (spr->bitmap) vPortFree(spr->bitmap);
+    if (spr->palette) vPortFree(spr->palette);
+    spr->bitmap = NULL;
+    spr->palette = NULL;
+}
+
+//---------------------------------------------------
+void TFT_sprite_move(tft_sprite_t *spr, int x, int y)
+{
+    if ((x == spr->x) && (y == spr->y)) return;
+    spr->x = x;
+    spr->y = y;
+    spr->dirty = true;
+}
+
+//----------------------------------------------------------
+void TFT_sprite_set_visible(tft_sprite_t *spr, bool visible)
+{
+    if (visible == spr->visible) return;
+    spr->visible = visible;
+    spr->dirty = true;
+}
+
+//---------------------------------------------
+void TFT_sprite_set_z(tft_sprite_t *spr, int z)
+{
+    if (z == spr->z) return;
+    spr->z = z;
+    spr->dirty = true;
+    if (spr->layer) spr->layer->order_dirty = true;
+}
+
+//----------------------------------------
+void TFT_sprite_changed(tft_sprite_t *spr)
+{
+    spr->dirty = true;
+}
+
+// Blend two RGB565 colors, 'a' is the opacity of 'fg' in range 0~32
+//----------------------------------------------------------------
+static inline color_t blend565(color_t fg, color_t bg, uint32_t a)
+{
+    // spread the components so that each has the room for the multiplication
+    uint32_t f = (fg | ((uint32_t)fg << 16)) & 0x07E0F81F;
+    uint32_t b = (bg | ((uint32_t)bg << 16)) & 0x07E0F81F;
+    uint32_t r = (((f * a) + (b * (32 - a))) >> 5) & 0x07E0F81F;
+    return (color_t)(r | (r >> 16));
+}
+
+// Draw 'n' pixels of the sprite row 'sy' starting at 'sx' into 'dst'
+//----------------------------------------------------------------------------------------
+static void sprite_draw_span(const tft_sprite_t *spr, color_t *dst, int sx, int sy, int n)
+{
+    uint32_t a = ((uint32_t)spr->alpha + 4) >> 3;
+    int32_t key = spr->key;
+
+    if (spr->format == SPRITE_FMT_PAL8) {
+        const uint8_t *src = spr->bitmap + (sy * spr->width) + sx;
+        const color_t *pal = spr->palette;
+        for (int i = 0; i < n; i++) {
+            if (src[i] == key) continue;
+            dst[i] = (a >= 32) ? pal[src[i]] : blend565(pal[src[i]], dst[i], a);
+        }
+        return;
+    }
+
+    const color_t *src = (const color_t *)spr->bitmap + (sy * spr->width) + sx;
+    if ((key < 0) && (a >= 32)) {
+        memcpy(dst, src, n * sizeof(color_t));
+        return;
+    }
+    for (int i = 0; i < n; i++) {
+        if (src[i] == key) continue;
+        dst[i] = (a >= 32) ? src[i] : blend565(src[i], dst[i], a);
+    }
+}
+
+
+// ==== Layers ====
+
+//-----------------------------------------------------------------------
+bool TFT_layer_init(tft_layer_t *layer, bool use_image, color_t bg_color)
+{
+    memset(layer, 0, sizeof(tft_layer_t));
+    layer->width = _width;
+    layer->height = _height;
+    layer->bg_color = bg_color;
+    if (use_image) {
+        layer->bg = pvPortMalloc(_width * _height * sizeof(color_t));
+        if (layer->bg == NULL) return false;
+        if (tft_frame_buffer) memcpy(layer->bg, tft_frame_buffer, _width * _height * sizeof(color_t));
+        else memset(layer->bg, 0, _width * _height * sizeof(color_t));
+    }
+    TFT_layer_damage(layer, 0, 0, _width - 1, _height - 1);
+    return true;
+}
+
+//-------------------------------------
+void TFT_layer_free(tft_layer_t *layer)
+{
+    TFT_layer_bgdraw(layer, false);
+    for (int i = 0; i < layer->n_sprites; i++) layer->sprite[i]->layer = NULL;
+    layer->n_sprites = 0;
+    if (layer->bg) vPortFree(layer->bg);
+    layer->bg = NULL;
+}
+
+//-------------------------------------------------------
+bool TFT_layer_add(tft_layer_t *layer, tft_sprite_t *spr)
+{
+    if (spr->layer == layer) return true;
+    if (spr->layer) TFT_layer_remove(spr->layer, spr);
+    if (layer->n_sprites >= TFT_LAYER_MAX_SPRITES) return false;
+
+    layer->sprite[layer->n_sprites++] = spr;
+    spr->layer = layer;
+    spr->drawn = false;
+    spr->dirty = true;
+    layer->order_dirty = true;
+    return true;
+}
+
+//----------------------------------------------------------
+void TFT_layer_remove(tft_layer_t *layer, tft_sprite_t *spr)
+{
+    for (int i = 0; i < layer->n_sprites; i++) {
+        if (layer->sprite[i] != spr) continue;
+        // keep the z order of the remaining sprites
+        memmove(&layer->sprite[i], &layer->sprite[i+1], (layer->n_sprites - i - 1) * sizeof(tft_sprite_t *));
+        layer->n_sprites--;
+        if (spr->drawn) TFT_layer_damage(layer, spr->drawn_rect.x1, spr->drawn_rect.y1, spr->drawn_rect.x2, spr->drawn_rect.y2);
+        spr->drawn = false;
+        spr->layer = NULL;
+        return;
+    }
+}
+
+// Add the rectangle to the damage list
+// The rectangles touching the new one are merged with it; if the list is full,
+// the new rectangle is merged with the one giving the smallest union
+//-----------------------------------------------------------------------
+void TFT_layer_damage(tft_layer_t *layer, int x1, int y1, int x2, int y2)
+{
+    tft_rect_t screen = { 0, 0, _width - 1, _height - 1 };
+    tft_rect_t in = { x1, y1, x2, y2 };
+    tft_rect_t r;
+
+    if (!rect_intersect(&r, &in, &screen)) return;
+
+    int i = 0;
+    while (i < layer->n_damage) {
+        if (rect_touch(&r, &layer->damage[i])) {
+            rect_union(&r, &layer->damage[i]);
+            layer->damage[i] = layer->damage[--layer->n_damage];
+            i = 0;  // the grown rectangle may touch the ones already checked
+            continue;
+        }
+        i++;
+    }
+    while (layer->n_damage >= TFT_LAYER_DAMAGE_RECTS) {
+        int best = 0;
+        uint32_t best_area = 0xFFFFFFFF;
+        for (i = 0; i < layer->n_damage; i++) {
+            tft_rect_t u = r;
+            rect_union(&u, &layer->damage[i]);
+            uint32_t area = rect_area(&u) - rect_area(&layer->damage[i]);
+            if (area < best_area) {
+                best_area = area;
+                best = i;
+            }
+        }
+        rect_union(&r, &layer->damage[best]);
+        layer->damage[best] = layer->damage[--layer->n_damage];
+    }
+    layer->damage[layer->n_damage++] = r;
+}
+
+//------------------------------------------------
+bool TFT_layer_bgdraw(tft_layer_t *layer, bool on)
+{
+    if (layer->bg == NULL) return false;
+    if (on) {
+        if (layer->saved_fb == NULL) {
+            layer->saved_fb = tft_frame_buffer;
+            tft_frame_buffer = layer->bg;
+        }
+    }
+    else if (layer->saved_fb) {
+        tft_frame_buffer = layer->saved_fb;
+        layer->saved_fb = NULL;
+    }
+    return true;
+}
+
+// Stable insertion sort of the sprites by z
+//----------------------------------------
+static void layer_sort(tft_layer_t *layer)
+{
+    for (int i = 1; i < layer->n_sprites; i++) {
+        tft_sprite_t *spr = layer->sprite[i];
+        int j = i - 1;
+        while ((j >= 0) && (layer->sprite[j]->z > spr->z)) {
+            layer->sprite[j+1] = layer->sprite[j];
+            j--;
+        }
+        layer->sprite[j+1] = spr;
+    }
+    layer->order_dirty = false;
+}
+
+// Draw the background and all visible sprites intersecting the rectangle into the frame buffer
+//---------------------------------------------------------------
+static void layer_render(tft_layer_t *layer, const tft_rect_t *r)
+{
+    int width = r->x2 - r->x1 + 1;
+    tft_rect_t sr, ir;
+
+    for (int y = r->y1; y <= r->y2; y++) {
+        color_t *dst = tft_frame_buffer + (y * _width) + r->x1;
+        if (layer->bg) memcpy(dst, layer->bg + (y * _width) + r->x1, width * sizeof(color_t));
+        else {
+            for (int x = 0; x < width; x++) dst[x] = layer->bg_color;
+        }
+    }
+
+    for (int i = 0; i < layer->n_sprites; i++) {
+        tft_sprite_t *spr = layer->sprite[i];
+        if ((!spr->visible) || (spr->bitmap == NULL)) continue;
+        sprite_rect(spr, &sr);
+        if (!rect_intersect(&ir, &sr, r)) continue;
+        for (int y = ir.y1; y <= ir.y2; y++) {
+            sprite_draw_span(spr, tft_frame_buffer + (y * _width) + ir.x1, ir.x1 - spr->x, y - spr->y, ir.x2 - ir.x1 + 1);
+        }
+    }
+}
+
+//--------------------------------------------------
+int TFT_layer_compose(tft_layer_t *layer, bool show)
+{
+    if ((layer->width != _width) || (layer->height != _height) || (tft_frame_buffer == NULL)) return -1;
+    TFT_layer_bgdraw(layer, false);
+    if (layer->order_dirty) layer_sort(layer);
+
+    // Collect the areas of the changed sprites, where they were and where they are now
+    for (int i = 0; i < layer->n_sprites; i++) {
+        tft_sprite_t *spr = layer->sprite[i];
+        if (!spr->dirty) continue;
+        if (spr->drawn) TFT_layer_damage(layer, spr->drawn_rect.x1, spr->drawn_rect.y1, spr->drawn_rect.x2, spr->drawn_rect.y2);
+        spr->drawn = spr->visible;
+        sprite_rect(spr, &spr->drawn_rect);
+        if (spr->drawn) TFT_layer_damage(layer, spr->drawn_rect.x1, spr->drawn_rect.y1, spr->drawn_rect.x2, spr->drawn_rect.y2);
+        spr->dirty = false;
+    }
+
+    int n = layer->n_damage;
+    for (int i = 0; i < n; i++) {
+        layer_render(layer, &layer->damage[i]);
+        if (show) send_frame_buffer_rect(layer->damage[i].x1, layer->damage[i].y1, layer->damage[i].x2, layer->damage[i].y2);
+    }
+    layer->n_damage = 0;
+    return n;
+}
+
+#endif // MICROPY_USE_DISPLAY
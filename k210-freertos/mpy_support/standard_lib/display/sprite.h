@@ -0,0 +1,149 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Sprites and layers composed into the TFT frame buffer
+ *
+ * The layer holds the background image (or color) and the list of sprites ordered by z.
+ * Changes of the sprites are collected as damaged rectangles; compose() redraws
+ * only the damaged rectangles into the frame buffer and sends them to the display.
+ */
+
+#ifndef _SPRITE_H_
+#define _SPRITE_H_
+
+#include "mpconfigport.h"
+
+#if MICROPY_USE_DISPLAY
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tftspi.h"
+
+#ifndef TFT_LAYER_MAX_SPRITES
+#define TFT_LAYER_MAX_SPRITES   32
+#endif
+// Maximal number of separate damaged rectangles, more are merged
+#define TFT_LAYER_DAMAGE_RECTS  16
+
+// Sprite bitmap formats
+#define SPRITE_FMT_RGB565       0   // 2 bytes per pixel
+#define SPRITE_FMT_PAL8         1   // 1 byte per pixel, index into 256 colors palette
+
+// Rectangle, inclusive coordinates
+typedef struct {
+    int x1;
+    int y1;
+    int x2;
+    int y2;
+} tft_rect_t;
+
+typedef struct _tft_layer_t tft_layer_t;
+
+typedef struct _tft_sprite_t {
+    uint8_t     *bitmap;        // pixel data, allocated outside the MicroPython heap
+    color_t     *palette;       // colors of the palettized sprite
+    int         width;
+    int         height;
+    uint8_t     format;         // SPRITE_FMT_xxx
+    uint8_t     alpha;          // sprite opacity, 255: opaque
+    int32_t     key;            // transparent color or palette index, -1 if not used
+    int         x;              // position on the display, can be negative
+    int         y;
+    int         z;              // z order, sprites with higher z are drawn on top
+    bool        visible;
+    bool        dirty;          // changed since the last compose
+    bool        drawn;          // drawn at 'drawn_rect' by the last compose
+    tft_rect_t  drawn_rect;
+    tft_layer_t *layer;         // layer the sprite is added to
+} tft_sprite_t;
+
+struct _tft_layer_t {
+    color_t     *bg;            // background image, NULL if the background color is used
+    color_t     bg_color;
+    color_t     *saved_fb;      // frame buffer while drawing into the background image
+    int         width;          // display size the background was created for
+    int         height;
+    bool        order_dirty;    // sprites must be sorted by z
+    int         n_sprites;
+    tft_sprite_t *sprite[TFT_LAYER_MAX_SPRITES];
+    int         n_damage;
+    tft_rect_t  damage[TFT_LAYER_DAMAGE_RECTS];
+};
+
+// Allocate the sprite bitmap, returns false if not enough memory
+//-----------------------------------------------------------------------------
+bool TFT_sprite_init(tft_sprite_t *spr, int width, int height, uint8_t format);
+
+// Free the sprite bitmap and palette, the sprite must not be in a layer
+//--------------------------------------
+void TFT_sprite_free(tft_sprite_t *spr);
+
+// Set the sprite position, visibility or z order and mark it for redraw
+//----------------------------------------------------
+void TFT_sprite_move(tft_sprite_t *spr, int x, int y);
+void TFT_sprite_set_visible(tft_sprite_t *spr, bool visible);
+void TFT_sprite_set_z(tft_sprite_t *spr, int z);
+
+// Mark the sprite for redraw after its bitmap or attributes are changed
+//-----------------------------------------
+void TFT_sprite_changed(tft_sprite_t *spr);
+
+// Initialize the layer
+// If 'use_image' is set, the current frame buffer content is used as the background image,
+// otherwise the background is filled with 'bg_color'
+// Returns false if not enough memory
+//------------------------------------------------------------------------
+bool TFT_layer_init(tft_layer_t *layer, bool use_image, color_t bg_color);
+
+// Free the background image and remove all sprites
+//--------------------------------------
+void TFT_layer_free(tft_layer_t *layer);
+
+// Add the sprite to the layer or remove it from the layer
+// TFT_layer_add returns false if the layer is full
+//--------------------------------------------------------
+bool TFT_layer_add(tft_layer_t *layer, tft_sprite_t *spr);
+void TFT_layer_remove(tft_layer_t *layer, tft_sprite_t *spr);
+
+// Mark the display rectangle (inclusive coordinates) for redraw
+//------------------------------------------------------------------------
+void TFT_layer_damage(tft_layer_t *layer, int x1, int y1, int x2, int y2);
+
+// Redirect the TFT drawing functions into the background image (on=true)
+// or back to the frame buffer (on=false)
+// Returns false if the layer has no background image
+//-------------------------------------------------
+bool TFT_layer_bgdraw(tft_layer_t *layer, bool on);
+
+// Redraw the damaged rectangles into the frame buffer and send them to the display if 'show' is set
+// Returns the number of redrawn rectangles, -1 if the display size has changed
+//---------------------------------------------------
+int TFT_layer_compose(tft_layer_t *layer, bool show);
+
+#endif // MICROPY_USE_DISPLAY
+
+#endif
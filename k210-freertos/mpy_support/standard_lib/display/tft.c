@@ -42,6 +42,7 @@
 #include <string.h>
 #include "FreeRTOS.h"
 #include "task.h"
+#include "semphr.h"
 #include "tft.h"
 #include "time.h"
 #include <math.h>
@@ -191,6 +192,7 @@ static dispWin_t dispWinTemp;
 static uint8_t *userfont = NULL;
 static int TFT_OFFSET = 0;
 static propFont	fontChar;
+static uint16_t fontCharPtr[256];	// offsets of the proportional font characters data, 0 if not in font
 static float _arcAngleMax = DEFAULT_ARC_ANGLE_MAX;
 
 
@@ -1071,6 +1073,201 @@ void TFT_drawStar(int cx, int cy, int diameter, color_t color, bool fill, float
 
 // ================ Font and string functions ==================================
 
+// ==== Glyph cache ====
+// The glyphs expanded to RGB565 are kept in the fixed size arena.
+// The arena is divided into blocks of GLYPH_BLOCK_PIXELS pixels,
+// each glyph uses the contiguous range of blocks.
+// If there is no free space, the least recently used glyphs are evicted.
+
+#define GLYPH_BLOCK_PIXELS      64
+#define GLYPH_CACHE_BLOCKS      (TFT_GLYPH_CACHE_SIZE / (GLYPH_BLOCK_PIXELS * sizeof(color_t)))
+#define GLYPH_CACHE_ENTRIES     128
+#define GLYPH_HASH_SIZE         64      // must be power of 2
+
+typedef struct {
+    const uint8_t *font;
+    color_t     fg;
+    color_t     bg;
+    uint8_t     ch;
+    uint8_t     width;
+    uint8_t     height;
+    uint16_t    block;      // first used arena block
+    uint16_t    nblocks;    // number of used arena blocks
+    int16_t     hnext;      // next entry in the hash chain
+    int16_t     prev;       // LRU list, more recently used entry; free list is linked with 'next'
+    int16_t     next;       // LRU list, less recently used entry
+} glyph_entry_t;
+
+static color_t glyph_arena[GLYPH_CACHE_BLOCKS * GLYPH_BLOCK_PIXELS];
+static uint8_t glyph_block_used[GLYPH_CACHE_BLOCKS];
+static glyph_entry_t glyph_entry[GLYPH_CACHE_ENTRIES];
+static int16_t glyph_hash[GLYPH_HASH_SIZE];
+static int16_t glyph_free_first = -1;
+static int16_t glyph_lru_first = -1;
+static int16_t glyph_lru_last = -1;
+static bool glyph_cache_ok = false;
+
+//----------------------------
+static void glyph_cache_init()
+{
+    memset(glyph_block_used, 0, sizeof(glyph_block_used));
+    for (int i=0; i<GLYPH_HASH_SIZE; i++) {
+        glyph_hash[i] = -1;
+    }
+    for (int i=0; i<GLYPH_CACHE_ENTRIES; i++) {
+        glyph_entry[i].nblocks = 0;
+        glyph_entry[i].next = (i < (GLYPH_CACHE_ENTRIES-1)) ? i+1 : -1;
+    }
+    glyph_free_first = 0;
+    glyph_lru_first = -1;
+    glyph_lru_last = -1;
+    glyph_cache_ok = true;
+}
+
+//----------------------------------------------------------------------------------
+static int glyph_hash_index(const uint8_t *font, uint8_t ch, color_t fg, color_t bg)
+{
+    uint32_t h = (uint32_t)((uintptr_t)font >> 2) ^ (ch * 0x9E37U) ^ (fg * 0x85EBU) ^ (bg * 0xC2B3U);
+    return (h ^ (h >> 7) ^ (h >> 15)) & (GLYPH_HASH_SIZE-1);
+}
+
+//-----------------------------------
+static void glyph_lru_unlink(int idx)
+{
+    glyph_entry_t *entry = &glyph_entry[idx];
+    if (entry->prev >= 0) glyph_entry[entry->prev].next = entry->next;
+    else glyph_lru_first = entry->next;
+    if (entry->next >= 0) glyph_entry[entry->next].prev = entry->prev;
+    else glyph_lru_last = entry->prev;
+}
+
+//--------------------------------------
+static void glyph_lru_set_first(int idx)
+{
+    glyph_entry_t *entry = &glyph_entry[idx];
+    entry->prev = -1;
+    entry->next = glyph_lru_first;
+    if (glyph_lru_first >= 0) glyph_entry[glyph_lru_first].prev = idx;
+    else glyph_lru_last = idx;
+    glyph_lru_first = idx;
+}
+
+// Remove the glyph from the cache and free its arena blocks
+//-------------------------------------
+static void glyph_cache_remove(int idx)
+{
+    glyph_entry_t *entry = &glyph_entry[idx];
+    int16_t *pidx = &glyph_hash[glyph_hash_index(entry->font, entry->ch, entry->fg, entry->bg)];
+    while (*pidx != idx) {
+        pidx = &glyph_entry[*pidx].hnext;
+    }
+    *pidx = entry->hnext;
+    glyph_lru_unlink(idx);
+    memset(glyph_block_used + entry->block, 0, entry->nblocks);
+    entry->nblocks = 0;
+    entry->next = glyph_free_first;
+    glyph_free_first = idx;
+}
+
+// Remove all glyphs of the font, must be called before the font data is freed
+//------------------------------------------------------
+static void glyph_cache_remove_font(const uint8_t *font)
+{
+    if (!glyph_cache_ok) return;
+    for (int i=0; i<GLYPH_CACHE_ENTRIES; i++) {
+        if ((glyph_entry[i].nblocks > 0) && (glyph_entry[i].font == font)) glyph_cache_remove(i);
+    }
+}
+
+// Find 'n' contiguous free arena blocks, returns the first block or -1
+//---------------------------------
+static int glyph_find_blocks(int n)
+{
+    int free_blocks = 0;
+    for (int i=0; i<GLYPH_CACHE_BLOCKS; i++) {
+        if (glyph_block_used[i]) free_blocks = 0;
+        else {
+            free_blocks++;
+            if (free_blocks == n) return i - n + 1;
+        }
+    }
+    return -1;
+}
+
+// Expand 1-bpp glyph data to RGB565 buffer with the row length 'stride'
+// The glyph data has 'row_bits' bits per row, MSB first
+//----------------------------------------------------------------------------------------------------------
+static void expand_glyph(const uint8_t *bits, int row_bits, int width, int height, color_t *dst, int stride)
+{
+    for (int j=0; j<height; j++) {
+        uint32_t bitpos = j * row_bits;
+        const uint8_t *src = bits + (bitpos >> 3);
+        uint8_t mask = 0x80 >> (bitpos & 7);
+        uint8_t data = *src++;
+        for (int i=0; i<width; i++) {
+            if (mask == 0) {
+                mask = 0x80;
+                data = *src++;
+            }
+            dst[i] = (data & mask) ? _fg : _bg;
+            mask >>= 1;
+        }
+        dst += stride;
+    }
+}
+
+// Returns the character glyph expanded with the current colors.
+// The glyph is expanded and added to the cache if not already cached.
+// Returns NULL if the glyph is too large for the cache.
+//---------------------------------------------------------------------------------------------------
+static color_t *glyph_cache_get(uint8_t ch, const uint8_t *bits, int row_bits, int width, int height)
+{
+    if (!glyph_cache_ok) glyph_cache_init();
+
+    int h = glyph_hash_index(cfont.font, ch, _fg, _bg);
+    for (int idx = glyph_hash[h]; idx >= 0; idx = glyph_entry[idx].hnext) {
+        glyph_entry_t *entry = &glyph_entry[idx];
+        if ((entry->ch == ch) && (entry->font == cfont.font) && (entry->fg == _fg) && (entry->bg == _bg)) {
+            if (idx != glyph_lru_first) {
+                glyph_lru_unlink(idx);
+                glyph_lru_set_first(idx);
+            }
+            return glyph_arena + (entry->block * GLYPH_BLOCK_PIXELS);
+        }
+    }
+
+    // === Not cached ===
+    int nblocks = ((width * height) + GLYPH_BLOCK_PIXELS - 1) / GLYPH_BLOCK_PIXELS;
+    if ((nblocks == 0) || (nblocks > GLYPH_CACHE_BLOCKS) || (width > 255) || (height > 255)) return NULL;
+
+    int block = -1;
+    while ((glyph_free_first < 0) || ((block = glyph_find_blocks(nblocks)) < 0)) {
+        // evict the least recently used glyph
+        glyph_cache_remove(glyph_lru_last);
+    }
+
+    int idx = glyph_free_first;
+    glyph_entry_t *entry = &glyph_entry[idx];
+    glyph_free_first = entry->next;
+
+    entry->font = cfont.font;
+    entry->fg = _fg;
+    entry->bg = _bg;
+    entry->ch = ch;
+    entry->width = width;
+    entry->height = height;
+    entry->block = block;
+    entry->nblocks = nblocks;
+    memset(glyph_block_used + block, 1, nblocks);
+    entry->hnext = glyph_hash[h];
+    glyph_hash[h] = idx;
+    glyph_lru_set_first(idx);
+
+    color_t *glyph = glyph_arena + (block * GLYPH_BLOCK_PIXELS);
+    expand_glyph(bits, row_bits, width, height, glyph, width);
+    return glyph;
+}
+
 //----------------------------------------------------
 static int load_file_font(mp_obj_t fontfile, int info)
 {
@@ -1078,6 +1275,7 @@ static int load_file_font(mp_obj_t fontfile, int info)
 	char err_msg[256] = {'\0'};
 
 	if (userfont != NULL) {
+		glyph_cache_remove_font(userfont);
 		vPortFree(userfont);
 		userfont = NULL;
 	}
@@ -1211,12 +1409,18 @@ static void getMaxWidthHeight()
 	uint16_t tempPtr = 4; // point at first char data
 	uint8_t cc, cw, ch, cd, cy;
 
+	bool indexed = true;
+
 	cfont.numchars = 0;
 	cfont.max_x_size = 0;
+	memset(fontCharPtr, 0, sizeof(fontCharPtr));
 
     cc = cfont.font[tempPtr++];
     while (cc)  {
     	cfont.numchars++;
+    	// index the characters for 'getCharPtr', the characters after 0xFF are not used
+    	if (cc == 0xFF) indexed = false;
+    	if ((indexed) && (fontCharPtr[cc] == 0)) fontCharPtr[cc] = tempPtr - 1;
         cy = cfont.font[tempPtr++];
         cw = cfont.font[tempPtr++];
         ch = cfont.font[tempPtr++];
@@ -1237,38 +1441,26 @@ static void getMaxWidthHeight()
 }
 
 // Return the Glyph data for an individual character in the proportional font
+// The character is found using the index created by 'getMaxWidthHeight'
 //------------------------------------
 static uint8_t getCharPtr(uint8_t c) {
-  uint16_t tempPtr = 4; // point at first char data
-
-  do {
-	fontChar.charCode = cfont.font[tempPtr++];
-    if (fontChar.charCode == 0xFF) return 0;
-
-    fontChar.adjYOffset = cfont.font[tempPtr++];
-    fontChar.width = cfont.font[tempPtr++];
-    fontChar.height = cfont.font[tempPtr++];
-    fontChar.xOffset = cfont.font[tempPtr++];
-    fontChar.xOffset = fontChar.xOffset < 0x80 ? fontChar.xOffset : -(0xFF - fontChar.xOffset);
-    fontChar.xDelta = cfont.font[tempPtr++];
-
-    if ((c != fontChar.charCode) && (fontChar.charCode != 0)) {
-      if (fontChar.width != 0) {
-        // packed bits
-        tempPtr += (((fontChar.width * fontChar.height)-1) / 8) + 1;
-      }
-    }
-  } while ((c != fontChar.charCode) && (fontChar.charCode != 0));
-
+  uint16_t tempPtr = fontCharPtr[c];
+  if (tempPtr == 0) return 0;
+
+  fontChar.charCode = cfont.font[tempPtr++];
+  fontChar.adjYOffset = cfont.font[tempPtr++];
+  fontChar.width = cfont.font[tempPtr++];
+  fontChar.height = cfont.font[tempPtr++];
+  fontChar.xOffset = cfont.font[tempPtr++];
+  fontChar.xOffset = fontChar.xOffset < 0x80 ? fontChar.xOffset : -(0xFF - fontChar.xOffset);
+  fontChar.xDelta = cfont.font[tempPtr++];
   fontChar.dataPtr = tempPtr;
-  if (c == fontChar.charCode) {
-    if (font_forceFixed > 0) {
-      // fix width & offset for forced fixed width
-      fontChar.xDelta = cfont.max_x_size;
-      fontChar.xOffset = (fontChar.xDelta - fontChar.width) / 2;
-    }
+
+  if (font_forceFixed > 0) {
+    // fix width & offset for forced fixed width
+    fontChar.xDelta = cfont.max_x_size;
+    fontChar.xOffset = (fontChar.xDelta - fontChar.width) / 2;
   }
-  else return 0;
 
   return 1;
 }
@@ -1352,80 +1544,49 @@ bool TFT_setFont(uint8_t font, mp_obj_t font_file, bool info)
 
 // print non-rotated proportional character
 // character is already in fontChar
+// Used for transparent or non buffered text,
+// horizontal runs of the visible pixels are drawn as lines
 //----------------------------------------------
 static int printProportionalChar(int x, int y) {
 	uint8_t ch = 0;
-	int i, j, char_width;
-    int cx, cy;
+	int i, j, char_width, run;
 
 	char_width = ((fontChar.width > fontChar.xDelta) ? fontChar.width : fontChar.xDelta);
 
-	if ((font_buffered_char) && (!font_transparent)) {
-		int len, bufPos;
-
-		// === buffer Glyph data for faster sending ===
-		len = (char_width+1) * cfont.y_size;
-		color_t *color_line = pvPortMalloc(len*3);
-		if (color_line) {
-			// fill with background color
-			for (int n = 0; n < len; n++) {
-				color_line[n] = _bg;
-			}
-			// set character pixels to foreground color
-			uint8_t mask = 0x80;
-			for (j=0; j < fontChar.height; j++) {
-				for (i=0; i < fontChar.width; i++) {
-					if (((i + (j*fontChar.width)) % 8) == 0) {
-						mask = 0x80;
-						ch = cfont.font[fontChar.dataPtr++];
-					}
-					if ((ch & mask) != 0) {
-						// visible pixel
-		                cx = (uint16_t)(fontChar.xOffset+i);
-		                cy = (uint16_t)(j+fontChar.adjYOffset);
-		                bufPos = ((char_width+1) * cy) + cx;
-						//bufPos = ((j + fontChar.adjYOffset) * (char_width+1)) + (fontChar.xOffset + i);  // bufY + bufX
-						color_line[bufPos] = _fg;
-					}
-					mask >>= 1;
-				}
-			}
-			// send to display in one transaction
-			send_data(x, y, x+char_width+1, y+cfont.y_size, len, color_line);
-			vPortFree(color_line);
-
-			return char_width;
-		}
-	}
-
 	if (!font_transparent) _fillRect(x, y, char_width+1, cfont.y_size, _bg);
 
 	// draw Glyph
 	uint8_t mask = 0x80;
 	for (j=0; j < fontChar.height; j++) {
+		int cy = y+j+fontChar.adjYOffset;
+		run = 0;
 		for (i=0; i < fontChar.width; i++) {
 			if (((i + (j*fontChar.width)) % 8) == 0) {
 				mask = 0x80;
 				ch = cfont.font[fontChar.dataPtr++];
 			}
 
-			if ((ch & mask) !=0) {
-				cx = (uint16_t)(x+fontChar.xOffset+i);
-				cy = (uint16_t)(y+j+fontChar.adjYOffset);
-				TFT_drawPixel(cx, cy, _fg);
+			if ((ch & mask) != 0) run++;
+			else if (run) {
+				if (run == 1) TFT_drawPixel(x+fontChar.xOffset+i-1, cy, _fg);
+				else _drawFastHLine(x+fontChar.xOffset+i-run, cy, run, _fg);
+				run = 0;
 			}
 			mask >>= 1;
 		}
+		if (run == 1) TFT_drawPixel(x+fontChar.xOffset+i-1, cy, _fg);
+		else if (run) _drawFastHLine(x+fontChar.xOffset+i-run, cy, run, _fg);
 	}
 
 	return char_width;
 }
 
 // non-rotated fixed width character
+// Used for transparent or non buffered text
 //----------------------------------------------
 static void printChar(uint8_t c, int x, int y) {
 	uint8_t i, j, ch, fz, mask;
-	uint16_t k, temp, cx, cy, len;
+	uint16_t k, temp, run;
 
 	// fz = bytes per char row
 	fz = cfont.x_size/8;
@@ -1434,54 +1595,173 @@ static void printChar(uint8_t c, int x, int y) {
 	// get character position in buffer
 	temp = ((c-cfont.offset)*((fz)*cfont.y_size))+4;
 
-	if ((font_buffered_char) && (!font_transparent)) {
-		// === buffer Glyph data for faster sending ===
-		len = cfont.x_size * cfont.y_size;
-		color_t *color_line = pvPortMalloc(len*3);
-		if (color_line) {
-			// fill with background color
-			for (int n = 0; n < len; n++) {
-				color_line[n] = _bg;
-			}
-			// set character pixels to foreground color
-			for (j=0; j<cfont.y_size; j++) {
-				for (k=0; k < fz; k++) {
-					ch = cfont.font[temp+k];
-					mask=0x80;
-					for (i=0; i<8; i++) {
-						if ((ch & mask) !=0) color_line[(j*cfont.x_size) + (i+(k*8))] = _fg;
-						mask >>= 1;
-					}
-				}
-				temp += (fz);
-			}
-			// send to display
-			send_data(x, y, x+cfont.x_size, y+cfont.y_size, len, color_line);
-			vPortFree(color_line);
-
-			return;
-		}
-	}
-
 	if (!font_transparent) _fillRect(x, y, cfont.x_size, cfont.y_size, _bg);
 
 	for (j=0; j<cfont.y_size; j++) {
+		run = 0;
 		for (k=0; k < fz; k++) {
 			ch = cfont.font[temp+k];
 			mask=0x80;
 			for (i=0; i<8; i++) {
-				if ((ch & mask) !=0) {
-					cx = (uint16_t)(x+i+(k*8));
-					cy = (uint16_t)(y+j);
-					TFT_drawPixel(cx, cy, _fg);
+				if ((ch & mask) !=0) run++;
+				else if (run) {
+					if (run == 1) TFT_drawPixel(x+i+(k*8)-1, y+j, _fg);
+					else _drawFastHLine(x+i+(k*8)-run, y+j, run, _fg);
+					run = 0;
 				}
 				mask >>= 1;
 			}
 		}
+		if (run == 1) TFT_drawPixel(x+(fz*8)-1, y+j, _fg);
+		else if (run) _drawFastHLine(x+(fz*8)-run, y+j, run, _fg);
 		temp += (fz);
 	}
 }
 
+// ==== Text runs ====
+// Adjacent non-rotated characters printed in buffered, non transparent mode
+// are composed into one buffer and sent to the display as a single window
+
+#define TEXT_RUN_MAX_CHARS  64
+
+typedef struct {
+	int x;
+	int y;
+	int width;
+	int count;
+	uint8_t chars[TEXT_RUN_MAX_CHARS];
+} text_run_t;
+
+static text_run_t text_run = { 0 };
+
+// Copy the glyph to the run buffer, clipped to the right side of the character cell
+// As when printed character by character, the foreground pixels of a glyph starting
+// left of its cell are drawn over the previous character
+//----------------------------------------------------------------------------------------------------------------------------------------
+static void blit_glyph(color_t *buf, int stride, int height, int cell_x, int cell_w, const color_t *glyph, int gx, int gy, int gw, int gh)
+{
+	int x0 = (gx < -cell_x) ? -cell_x : gx;
+	int x1 = ((gx + gw) > cell_w) ? cell_w : (gx + gw);
+	int y0 = (gy < 0) ? 0 : gy;
+	int y1 = ((gy + gh) > height) ? height : (gy + gh);
+	if ((x1 <= x0) || (y1 <= y0)) return;
+
+	for (int y=y0; y<y1; y++) {
+		color_t *dst = buf + (y * stride) + cell_x;
+		const color_t *src = glyph + ((y - gy) * gw) - gx;
+		int x = x0;
+		for (; x<0; x++) {
+			if (src[x] == _fg) dst[x] = _fg;
+		}
+		if (x < x1) memcpy(dst + x, src + x, (x1 - x) * sizeof(color_t));
+	}
+}
+
+// Copy the glyph of the character to the run buffer, returns the cell width
+//---------------------------------------------------------------------------
+static int text_run_put_char(uint8_t c, color_t *buf, int stride, int cell_x)
+{
+	const uint8_t *bits;
+	int row_bits, width, height, gx, gy, cell_w;
+
+	if (cfont.x_size == 0) {
+		// proportional font
+		if (!getCharPtr(c)) return 0;
+		cell_w = ((fontChar.width > fontChar.xDelta) ? fontChar.width : fontChar.xDelta) + 1;
+		bits = cfont.font + fontChar.dataPtr;
+		row_bits = fontChar.width;
+		width = fontChar.width;
+		height = fontChar.height;
+		gx = fontChar.xOffset;
+		gy = fontChar.adjYOffset;
+	}
+	else {
+		// fixed width font
+		int fz = (cfont.x_size + 7) / 8;
+		cell_w = cfont.x_size;
+		bits = cfont.font + ((c-cfont.offset) * fz * cfont.y_size) + 4;
+		row_bits = fz * 8;
+		width = cfont.x_size;
+		height = cfont.y_size;
+		gx = 0;
+		gy = 0;
+	}
+	if ((width == 0) || (height == 0)) return cell_w;
+
+	color_t *glyph = glyph_cache_get(c, bits, row_bits, width, height);
+	if (glyph) {
+		blit_glyph(buf, stride, cfont.y_size, cell_x, cell_w, glyph, gx, gy, width, height);
+	}
+	else {
+		// too large for the cache, expand to the temporary buffer
+		glyph = pvPortMalloc(width * height * sizeof(color_t));
+		if (glyph) {
+			expand_glyph(bits, row_bits, width, height, glyph, width);
+			blit_glyph(buf, stride, cfont.y_size, cell_x, cell_w, glyph, gx, gy, width, height);
+			vPortFree(glyph);
+		}
+	}
+	return cell_w;
+}
+
+// Draw the pending text run
+//--------------------------
+static void text_run_flush()
+{
+	if (text_run.count == 0) return;
+
+	int height = cfont.y_size;
+	uint32_t len = text_run.width * height;
+	color_t *buf = pvPortMalloc(len * sizeof(color_t));
+	if (buf == NULL) {
+		// not enough memory, print the characters one by one
+		int x = text_run.x;
+		for (int i=0; i<text_run.count; i++) {
+			if (cfont.x_size == 0) {
+				if (getCharPtr(text_run.chars[i])) x += printProportionalChar(x, text_run.y) + 1;
+			}
+			else {
+				printChar(text_run.chars[i], x, text_run.y);
+				x += cfont.x_size;
+			}
+		}
+		text_run.count = 0;
+		return;
+	}
+
+	// fill with background color and compose the glyphs
+	for (uint32_t n=0; n<len; n++) {
+		buf[n] = _bg;
+	}
+	int cell_x = 0;
+	for (int i=0; i<text_run.count; i++) {
+		cell_x += text_run_put_char(text_run.chars[i], buf, text_run.width, cell_x);
+	}
+
+	// send to display in one transaction
+	send_data(text_run.x, text_run.y, text_run.x+text_run.width, text_run.y+height, len, buf);
+	vPortFree(buf);
+	text_run.count = 0;
+}
+
+// Add the character cell to the text run
+// The pending run is drawn first if the character is not adjacent to it
+//-----------------------------------------------------------
+static void text_run_add(uint8_t c, int x, int y, int cell_w)
+{
+	if ((text_run.count > 0) &&
+			((text_run.count >= TEXT_RUN_MAX_CHARS) || (y != text_run.y) || (x != (text_run.x + text_run.width)))) {
+		text_run_flush();
+	}
+	if (text_run.count == 0) {
+		text_run.x = x;
+		text_run.y = y;
+		text_run.width = 0;
+	}
+	text_run.chars[text_run.count++] = c;
+	text_run.width += cell_w;
+}
+
 // print rotated proportional character
 // character is already in fontChar
 //---------------------------------------------------
@@ -1774,6 +2054,9 @@ void TFT_print(char *st, int x, int y) {
 
 	int offset = TFT_OFFSET;
 
+	// non rotated characters are composed into text runs in buffered, non transparent mode
+	bool use_run = ((font_buffered_char) && (!font_transparent) && (font_rotate == 0) && (cfont.bitmap == 1));
+
 	for (i=0; i<stl; i++) {
 		ch = st[i]; // get string character
 
@@ -1807,7 +2090,14 @@ void TFT_print(char *st, int x, int y) {
 			// Let's print the character
 			if (cfont.x_size == 0) {
 				// == proportional font
-				if (font_rotate == 0) TFT_X += printProportionalChar(TFT_X, TFT_Y) + 1;
+				if (font_rotate == 0) {
+					if (use_run) {
+						tmpw = ((fontChar.width > fontChar.xDelta) ? fontChar.width : fontChar.xDelta) + 1;
+						text_run_add(ch, TFT_X, TFT_Y, tmpw);
+						TFT_X += tmpw;
+					}
+					else TFT_X += printProportionalChar(TFT_X, TFT_Y) + 1;
+				}
 				else {
 					// rotated proportional font
 					offset += rotatePropChar(x, y, offset);
@@ -1819,7 +2109,8 @@ void TFT_print(char *st, int x, int y) {
 					// == fixed font
 					if ((ch < cfont.offset) || ((ch-cfont.offset) > cfont.numchars)) ch = cfont.offset;
 					if (font_rotate == 0) {
-						printChar(ch, TFT_X, TFT_Y);
+						if (use_run) text_run_add(ch, TFT_X, TFT_Y, tmpw);
+						else printChar(ch, TFT_X, TFT_Y);
 						TFT_X += tmpw;
 					}
 					else rotateChar(ch, x, y, i);
@@ -1832,6 +2123,7 @@ void TFT_print(char *st, int x, int y) {
 			}
 		}
 	}
+	if (use_run) text_run_flush();
 }
 
 
@@ -2033,6 +2325,17 @@ void TFT_restoreClipWin()
 
 
 // ================ JPG SUPPORT ================================================
+
+// The image is decoded one MCU at a time and each MCU is written, clipped to the
+// display window, directly to the frame buffer or into a band buffer holding one
+// row of MCUs. Full bands are sent to the display by the helper task running
+// on the other core while the decoding continues into the second band buffer.
+// If the image from memory buffer contains restart markers, the helper task
+// decodes the bottom half of the image in parallel with the top half.
+#define JPG_HELPER_PROC     (MAIN_TASK_PROC ^ 1)
+#define JPG_WORK_SIZE       4096    // size of the decoder working buffer (must be power of 2)
+#define JPG_FORK_WORK_SIZE  2048    // size of the helper's decoder working buffer
+
 // User defined device identifier
 typedef struct {
 	mp_obj_t	fhndl;			// File object for input function
@@ -2042,9 +2345,41 @@ typedef struct {
     uint32_t	bufsize;		// size of the memory buffer
     uint32_t	bufptr;			// memory buffer current position
     uint32_t    spi_time;
-    color_t		*linbuf;		// memory buffer used for display output
+    int         x1;             // visible part of the image
+    int         y1;
+    int         x2;
+    int         y2;
+    color_t     *band[2];       // band buffers used for display output
+    int         band_idx;       // band buffer currently written
+    int         band_top;       // image row (unclipped) of the MCU row in the current band
+    int         band_y1;        // display rows covered by the current band
+    int         band_y2;
+    bool        band_used;      // the current band contains data
+    bool        async;          // bands are sent by the helper task
+    SemaphoreHandle_t band_free;// number of band buffers not waiting to be sent
+    JRESULT     rc;             // result of the decoding done by the helper task
 } JPGIODEV;
 
+// Job for the helper task, either send the band or decode the image part
+typedef struct {
+    JPGIODEV    *dev;
+    color_t     *band;
+    int         x1;
+    int         y1;
+    int         x2;
+    int         y2;
+    JDEC        *jd;
+    uint8_t     scale;
+    UINT        mcu_start;
+    UINT        mcu_end;
+    SemaphoreHandle_t done;
+} jpg_job_t;
+
+static TaskHandle_t jpg_helper_task_handle = NULL;
+static QueueHandle_t jpg_helper_queue = NULL;
+static SemaphoreHandle_t jpg_spi_mutex = NULL;
+
+static UINT tjd_output(JDEC* jd, void* bitmap, JRECT* rect);
 
 // User defined call-back function to input JPEG data from file
 //---------------------
@@ -2094,6 +2429,106 @@ static UINT tjd_buf_input (
 	}
 }
 
+// Send the band to the display, or pass it to the helper task
+//---------------------------------------
+static void jpg_band_flush(JPGIODEV *dev)
+{
+    if (!dev->band_used) return;
+    dev->band_used = false;
+
+    if (dev->async) {
+        jpg_job_t job = {
+            .dev = dev, .band = dev->band[dev->band_idx],
+            .x1 = dev->x1, .y1 = dev->band_y1, .x2 = dev->x2, .y2 = dev->band_y2,
+            .jd = NULL, .done = dev->band_free
+        };
+        xQueueSend(jpg_helper_queue, &job, portMAX_DELAY);
+        dev->band_idx ^= 1;
+        return;
+    }
+
+    uint64_t spi_startt = mp_hal_ticks_us();
+    if (jpg_spi_mutex) xSemaphoreTake(jpg_spi_mutex, portMAX_DELAY);
+    send_data(dev->x1, dev->band_y1, dev->x2+1, dev->band_y2+1,
+            (dev->x2-dev->x1+1) * (dev->band_y2-dev->band_y1+1), dev->band[dev->band_idx]);
+    if (jpg_spi_mutex) xSemaphoreGive(jpg_spi_mutex);
+    dev->spi_time += (uint32_t)(mp_hal_ticks_us() - spi_startt);
+}
+
+//---------------------------------------------
+static void jpg_helper_task(void *pvParameters)
+{
+    jpg_job_t job;
+
+    while (1) {
+        if (xQueueReceive(jpg_helper_queue, &job, portMAX_DELAY) != pdTRUE) continue;
+        if (job.jd) {
+            // decode the bottom part of the image
+            job.dev->rc = jd_decomp_part(job.jd, tjd_output, job.scale, job.mcu_start, job.mcu_end);
+            jpg_band_flush(job.dev);
+        }
+        else {
+            uint64_t spi_startt = mp_hal_ticks_us();
+            send_data(job.x1, job.y1, job.x2+1, job.y2+1, (job.x2-job.x1+1) * (job.y2-job.y1+1), job.band);
+            job.dev->spi_time += (uint32_t)(mp_hal_ticks_us() - spi_startt);
+        }
+        xSemaphoreGive(job.done);
+    }
+}
+
+// Start the helper task on the other core if not already started
+// Returns false if the helper task cannot be used
+//--------------------------------
+static bool jpg_helper_start(void)
+{
+    // The other core runs the second MicroPython instance
+    if (mpy_config.config.use_two_main_tasks) return false;
+    // The decoding must not compete with the helper for the same core
+    if (uxPortGetProcessorId() == JPG_HELPER_PROC) return false;
+
+    if (jpg_helper_task_handle == NULL) {
+        if (jpg_helper_queue == NULL) jpg_helper_queue = xQueueCreate(4, sizeof(jpg_job_t));
+        if (jpg_spi_mutex == NULL) jpg_spi_mutex = xSemaphoreCreateMutex();
+        if ((jpg_helper_queue == NULL) || (jpg_spi_mutex == NULL)) return false;
+        BaseType_t res = xTaskCreateAtProcessor(
+                JPG_HELPER_PROC,                        // processor
+                jpg_helper_task,                        // function entry
+                "JPG_helper",                           // task name
+                configMINIMAL_STACK_SIZE,               // stack_deepth
+                NULL,                                   // function argument
+                MICROPY_TASK_PRIORITY+1,                // task priority
+                &jpg_helper_task_handle);               // task handle
+        if (res != pdPASS) {
+            jpg_helper_task_handle = NULL;
+            if (image_debug) mp_printf(&mp_plat_print, "JPG helper task not started\r\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+// Find the position following the 'count'-th RSTn marker in the entropy coded data
+// Returns -1 if not found
+//------------------------------------------------------------------------------------------
+static int jpg_find_restart(const uint8_t *buf, uint32_t size, uint32_t pos, uint32_t count)
+{
+    const uint8_t *p;
+    uint32_t n = 0;
+
+    while ((pos + 1) < size) {
+        p = memchr(buf + pos, 0xFF, size - pos - 1);
+        if (p == NULL) break;
+        pos = p - buf + 1;
+        if ((buf[pos] & 0xF8) == 0xD0) {
+            // RSTn markers are numbered modulo 8
+            if ((buf[pos] & 7) != (n & 7)) break;
+            if (++n == count) return pos + 1;
+        }
+        else if (buf[pos] == 0xD9) break; // EOI
+    }
+    return -1;
+}
+
 // User defined call-back function to output RGB bitmap to display device
 //----------------------
 static UINT tjd_output (
@@ -2105,66 +2540,54 @@ static UINT tjd_output (
 	// Device identifier for the session (5th argument of jd_prepare function)
 	JPGIODEV *dev = (JPGIODEV*)jd->device;
 
-	// ** Put the rectangular into the display device **
-	int x;
-	int y;
-	int dleft, dtop, dright, dbottom;
 	BYTE *src = (BYTE*)bitmap;
-    uint16_t _color;
-
+	int width = rect->right - rect->left + 1;
 	int left = rect->left + dev->x;
 	int top = rect->top + dev->y;
 	int right = rect->right + dev->x;
 	int bottom = rect->bottom + dev->y;
-	int fbpos;
-
-	if ((left > dispWin.x2) || (top > dispWin.y2)) return 1;	// out of screen area, return
-	if ((right < dispWin.x1) || (bottom < dispWin.y1)) return 1;// out of screen area, return
-
-	if (left < dispWin.x1) dleft = dispWin.x1;
-	else dleft = left;
-	if (top < dispWin.y1) dtop = dispWin.y1;
-	else dtop = top;
-	if (right > dispWin.x2) dright = dispWin.x2;
-	else dright = right;
-	if (bottom > dispWin.y2) dbottom = dispWin.y2;
-	else dbottom = bottom;
-
-	if ((dleft > dispWin.x2) || (dtop > dispWin.y2)) return 1;		// out of screen area, return
-	if ((dright < dispWin.x1) || (dbottom < dispWin.y1)) return 1;	// out of screen area, return
-
-	uint32_t len = ((dright-dleft+1) * (dbottom-dtop+1));	// calculate length of data
-
-	if ((len > 0) && (len <= JPG_IMAGE_LINE_BUF_SIZE)) {
-        int lbidx = 0;
-        for (y = top; y <= bottom; y++) {
-            for (x = left; x <= right; x++) {
-                // Clip to display area
-                if ((x >= dleft) && (y >= dtop) && (x <= dright) && (y <= dbottom)) {
-                    _color = (uint16_t)((*src++) & 0xF8) << 8;  // R
-                    _color |= (uint16_t)((*src++) & 0xFC) << 3; // G
-                    _color |= (uint16_t)((*src++) & 0xF8) >> 3; // B
-                    if (use_frame_buffer) {
-                        fbpos = y*_width + x;
-                        tft_frame_buffer[fbpos] = _color;
-                    }
-                    else {
-                        dev->linbuf[lbidx] = _color;
-                        lbidx++;
-                    }
-                }
-                else src += 3; // skip
-            }
-        }
-        if (!use_frame_buffer) {
-            uint64_t spi_startt = mp_hal_ticks_us();
-            send_data(dleft, dtop, dright+1, dbottom+1, len, dev->linbuf);
-            dev->spi_time += (uint32_t)(mp_hal_ticks_us() - spi_startt);
-        }
+
+	// Clip to the visible part of the image
+	if ((left > dev->x2) || (top > dev->y2)) return 1;	// out of screen area, return
+	if ((right < dev->x1) || (bottom < dev->y1)) return 1;// out of screen area, return
+
+	int dleft = (left < dev->x1) ? dev->x1 : left;
+	int dtop = (top < dev->y1) ? dev->y1 : top;
+	int dright = (right > dev->x2) ? dev->x2 : right;
+	int dbottom = (bottom > dev->y2) ? dev->y2 : bottom;
+
+	color_t *dst;
+	int stride;
+	if (use_frame_buffer) {
+	    dst = tft_frame_buffer + (dtop * _width) + dleft;
+	    stride = _width;
 	}
 	else {
-		mp_printf(&mp_plat_print, "Data size error: %d jpg: (%d,%d,%d,%d) disp: (%d,%d,%d,%d)\r\n", len, left,top,right,bottom, dleft,dtop,dright,dbottom);
-		return 0;  // stop decompression
+	    if ((!dev->band_used) || (top != dev->band_top)) {
+	        // First MCU of the next MCU row, start the new band
+	        jpg_band_flush(dev);
+	        // wait until the band buffer is sent by the helper task
+	        if (dev->async) xSemaphoreTake(dev->band_free, portMAX_DELAY);
+	        dev->band_top = top;
+	        dev->band_y1 = dtop;
+	        dev->band_y2 = dbottom;
+	        dev->band_used = true;
+	    }
+	    stride = dev->x2 - dev->x1 + 1;
+	    dst = dev->band[dev->band_idx] + ((dtop - dev->band_y1) * stride) + (dleft - dev->x1);
+	}
+
+	// Convert the visible rows to RGB565
+	int n = dright - dleft + 1;
+	src += ((dtop - top) * width + (dleft - left)) * 3;
+	for (int y = dtop; y <= dbottom; y++) {
+	    BYTE *s = src;
+	    for (int x = 0; x < n; x++) {
+	        dst[x] = ((uint16_t)(s[0] & 0xF8) << 8) | ((uint16_t)(s[1] & 0xFC) << 3) | (s[2] >> 3);
+	        s += 3;
+	    }
+	    dst += stride;
+	    src += width * 3;
 	}
 
 	return 1;	// Continue to decompression
@@ -2176,13 +2599,16 @@ static UINT tjd_output (
 void TFT_jpg_image(int x, int y, uint8_t scale, mp_obj_t fname, uint8_t *buf, int size)
 {
 	JPGIODEV dev;
+	JPGIODEV dev2;			// device of the image part decoded by the helper task
 	char *work = NULL;		// Pointer to the working buffer (must be 4-byte aligned)
-	UINT sz_work = 4096;	// Size of the working buffer (must be power of 2)
+	char *work2 = NULL;		// Working buffer of the helper's decoder
 	JDEC jd;				// Decompression object (70 bytes)
+	JDEC jd2;
 	JRESULT rc;
+	SemaphoreHandle_t done = NULL;
 
-	dev.linbuf = NULL;
-	dev.spi_time = 0;
+	memset(&dev, 0, sizeof(JPGIODEV));
+	memset(&dev2, 0, sizeof(JPGIODEV));
 
    	dev.fhndl = mp_const_none;
     if (fname == mp_const_none) {
@@ -2215,11 +2641,11 @@ void TFT_jpg_image(int x, int y, uint8_t scale, mp_obj_t fname, uint8_t *buf, in
 
     if (scale > 3) scale = 3;
 
-	work = pvPortMalloc(sz_work);
+	work = pvPortMalloc(JPG_WORK_SIZE);
 	if (work) {
         if (image_debug) mp_printf(&mp_plat_print, "Preparing JPG\n");
-		if (dev.membuff) rc = jd_prepare(&jd, tjd_buf_input, (void *)work, sz_work, &dev);
-		else rc = jd_prepare(&jd, tjd_input, (void *)work, sz_work, &dev);
+		if (dev.membuff) rc = jd_prepare(&jd, tjd_buf_input, (void *)work, JPG_WORK_SIZE, &dev);
+		else rc = jd_prepare(&jd, tjd_input, (void *)work, JPG_WORK_SIZE, &dev);
 		if (rc == JDR_OK) {
 	        if (image_debug) mp_printf(&mp_plat_print, "Prepared.\n");
 			if (x == CENTER) x = ((dispWin.x2 - dispWin.x1 + 1 - (int)(jd.width >> scale)) / 2) + dispWin.x1;
@@ -2235,23 +2661,85 @@ void TFT_jpg_image(int x, int y, uint8_t scale, mp_obj_t fname, uint8_t *buf, in
 
 			dev.x = x;
 			dev.y = y;
+			// Visible part of the image
+			dev.x1 = (x < dispWin.x1) ? dispWin.x1 : x;
+			dev.y1 = (y < dispWin.y1) ? dispWin.y1 : y;
+			dev.x2 = x + (int)(jd.width >> scale) - 1;
+			if (dev.x2 > dispWin.x2) dev.x2 = dispWin.x2;
+			dev.y2 = y + (int)(jd.height >> scale) - 1;
+			if (dev.y2 > dispWin.y2) dev.y2 = dispWin.y2;
+			if ((dev.x1 > dev.x2) || (dev.y1 > dev.y2)) goto exit;
+
+			UINT mcu_w = jd.msx * 8;
+			UINT mcu_h = jd.msy * 8;
+			UINT mcu_cols = (jd.width + mcu_w - 1) / mcu_w;
+			UINT mcu_rows = (jd.height + mcu_h - 1) / mcu_h;
+			UINT mcu_split = mcu_cols * mcu_rows;
+			bool helper = jpg_helper_start();
+
+			if ((helper) && (dev.membuff) && (jd.nrst)) {
+			    // Split at the restart interval starting the MCU row nearest to the middle of the image
+			    int best = 0;
+			    for (int row = 1; row < (int)mcu_rows; row++) {
+			        if (((row * mcu_cols) % jd.nrst) != 0) continue;
+			        if ((best == 0) || (abs(row - (int)(mcu_rows / 2)) < abs(best - (int)(mcu_rows / 2)))) best = row;
+			    }
+			    if (best) {
+			        int pos = jpg_find_restart(dev.membuff, dev.bufsize, dev.bufptr - jd.dctr, (best * mcu_cols) / jd.nrst);
+			        if (pos > 0) {
+			            work2 = pvPortMalloc(JPG_FORK_WORK_SIZE);
+			            done = xSemaphoreCreateBinary();
+			            dev2 = dev;
+			            dev2.bufptr = pos;
+			            if ((work2) && (done) && (jd_fork(&jd2, &jd, tjd_buf_input, work2, JPG_FORK_WORK_SIZE, &dev2) == JDR_OK)) {
+			                mcu_split = best * mcu_cols;
+			            }
+			        }
+			    }
+			}
 
             if (!use_frame_buffer) {
-                dev.linbuf = pvPortMalloc(JPG_IMAGE_LINE_BUF_SIZE*2);
-                if (dev.linbuf == NULL) {
-                    if (image_debug) mp_printf(&mp_plat_print, "Error allocating line buffer\r\n");
+                // The bands are sent by the helper task if it is not used for decoding
+                dev.async = (helper) && (mcu_split == (mcu_cols * mcu_rows));
+                uint32_t band_size = (dev.x2 - dev.x1 + 1) * (mcu_h >> scale) * sizeof(color_t);
+                dev.band[0] = pvPortMalloc(band_size);
+                if (dev.async) {
+                    dev.band[1] = pvPortMalloc(band_size);
+                    dev.band_free = xSemaphoreCreateCounting(2, 2);
+                    if ((dev.band[1] == NULL) || (dev.band_free == NULL)) dev.async = false;
+                }
+                if (mcu_split < (mcu_cols * mcu_rows)) dev2.band[0] = pvPortMalloc(band_size);
+                if ((dev.band[0] == NULL) || ((mcu_split < (mcu_cols * mcu_rows)) && (dev2.band[0] == NULL))) {
+                    if (image_debug) mp_printf(&mp_plat_print, "Error allocating band buffer\r\n");
                     goto exit;
                 }
             }
 
-			// Start to decode the JPEG file
-			rc = jd_decomp(&jd, tjd_output, scale);
+			// Start to decode the JPEG image
+			if (mcu_split < (mcu_cols * mcu_rows)) {
+			    jpg_job_t job = {
+			        .dev = &dev2, .band = NULL, .jd = &jd2, .scale = scale,
+			        .mcu_start = mcu_split, .mcu_end = mcu_cols * mcu_rows, .done = done
+			    };
+			    xQueueSend(jpg_helper_queue, &job, portMAX_DELAY);
+			}
+			rc = jd_decomp_part(&jd, tjd_output, scale, 0, mcu_split);
+			jpg_band_flush(&dev);
+			if (dev.async) {
+			    // wait until all bands are sent
+			    xSemaphoreTake(dev.band_free, portMAX_DELAY);
+			    xSemaphoreTake(dev.band_free, portMAX_DELAY);
+			}
+			if (mcu_split < (mcu_cols * mcu_rows)) {
+			    xSemaphoreTake(done, portMAX_DELAY);
+			    if (rc == JDR_OK) rc = dev2.rc;
+			}
 
 			if (rc != JDR_OK) {
 				if (image_debug) mp_printf(&mp_plat_print, "jpg decompression error %d\r\n", rc);
 			}
-			if (image_debug) mp_printf(&mp_plat_print, "Jpg size: %dx%d, position; %d,%d, scale: %d, bytes used: %d, spitime=%u\r\n",
-			        jd.width, jd.height, x, y, scale, jd.sz_pool, dev.spi_time);
+			if (image_debug) mp_printf(&mp_plat_print, "Jpg size: %dx%d, position; %d,%d, scale: %d, bytes used: %d, split at MCU %u, spitime=%u\r\n",
+			        jd.width, jd.height, x, y, scale, jd.sz_pool, mcu_split, dev.spi_time + dev2.spi_time);
 		}
 		else {
 			if (image_debug) mp_printf(&mp_plat_print, "jpg prepare error %d\r\n", rc);
@@ -2263,7 +2751,12 @@ void TFT_jpg_image(int x, int y, uint8_t scale, mp_obj_t fname, uint8_t *buf, in
 
 exit:
 	if (work) vPortFree(work);  // vPortFree work buffer
-	if (dev.linbuf) vPortFree(dev.linbuf);
+	if (work2) vPortFree(work2);
+	if (done) vSemaphoreDelete(done);
+	if (dev.band_free) vSemaphoreDelete(dev.band_free);
+	if (dev.band[0]) vPortFree(dev.band[0]);
+	if (dev.band[1]) vPortFree(dev.band[1]);
+	if (dev2.band[0]) vPortFree(dev2.band[0]);
     if (dev.fhndl) mp_stream_close(dev.fhndl);  // close input file
 }
 
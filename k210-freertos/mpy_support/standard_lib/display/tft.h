@@ -88,9 +88,11 @@ extern uint32_t tp_caly;			// touch screen Y calibration constant
 // =========================================================================================
 
 
-// Buffer is created during jpeg decode for sending data
-// The size must be multiple of 256 bytes !!
-#define JPG_IMAGE_LINE_BUF_SIZE 256
+// Size of the cache for the glyphs expanded to RGB565 (in bytes)
+// Used for non transparent, non rotated text in buffered mode
+#ifndef TFT_GLYPH_CACHE_SIZE
+#define TFT_GLYPH_CACHE_SIZE    (32*1024)
+#endif
 
 // --- Constants for ellipse function ---
 #define TFT_ELLIPSE_UPPER_RIGHT 0x01
@@ -699,6 +701,8 @@ color_t HSBtoRGB(float _hue, float _sat, float _brightness);
  *     buf: pointer to the memory buffer from which the image will be read; used if fname=NULL
  *    size: size of the memory buffer from which the image will be read; used if fname=NULL & buf!=NULL
  *
+ * The image is sent to the display one row of MCUs at a time, from the task on the other core.
+ * The image from memory buffer with restart markers is decoded on both cores.
  */
 //--------------------------------------------------------------------------------------
 void TFT_jpg_image(int x, int y, uint8_t scale, mp_obj_t fname, uint8_t *buf, int size);
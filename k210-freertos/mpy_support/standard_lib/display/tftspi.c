@@ -62,6 +62,8 @@
 #define GS_FACT_G 0.4870
 #define GS_FACT_B 0.2140
 
+#define FB_RECT_CHUNK   (32*1024)   // max number of pixels sent from the frame buffer at once
+
 #define SPI_CHANNEL     (0)
 #define DCX_IO          (38)
 #define TFT_RST         (37)
@@ -472,6 +474,44 @@ void send_frame_buffer()
     }
 }
 
+// Send the rectangle of the frame buffer to the display
+// The rows not covering the full display width are copied into the band buffer,
+// the data is sent in chunks of at most FB_RECT_CHUNK pixels
+//========================================================
+void send_frame_buffer_rect(int x1, int y1, int x2, int y2)
+{
+    if ((!use_frame_buffer) || (tft_frame_buffer == NULL)) return;
+
+    if (x1 < 0) x1 = 0;
+    if (y1 < 0) y1 = 0;
+    if (x2 >= _width) x2 = _width - 1;
+    if (y2 >= _height) y2 = _height - 1;
+    if ((x1 > x2) || (y1 > y2)) return;
+
+    int width = x2 - x1 + 1;
+    int rows = FB_RECT_CHUNK / width;
+    if (rows > (y2 - y1 + 1)) rows = y2 - y1 + 1;
+    color_t *band = NULL;
+    if (width < _width) {
+        band = pvPortMalloc(width * rows * sizeof(color_t));
+        // without the band buffer, send the rows one by one
+        if (band == NULL) rows = 1;
+    }
+
+    for (int y = y1; y <= y2; y += rows) {
+        int n = (rows > (y2 - y + 1)) ? (y2 - y + 1) : rows;
+        disp_spi_transfer_addrwin(x1, x2, y, y + n - 1);
+        if (band) {
+            for (int i = 0; i < n; i++) {
+                memcpy(band + (i * width), tft_frame_buffer + ((y + i) * _width) + x1, width * sizeof(color_t));
+            }
+            tft_write_half(band, width * n);
+        }
+        else tft_write_half(tft_frame_buffer + (y * _width) + x1, width * n);
+    }
+    if (band) vPortFree(band);
+}
+
 //==================================
 void _tft_setRotation(uint8_t rot) {
 	uint8_t rotation = rot & 3; // can't be higher than 3
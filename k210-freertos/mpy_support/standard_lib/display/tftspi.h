@@ -221,6 +221,7 @@ void drawPixel(int16_t x, int16_t y, color_t color);
 void send_data(int x1, int y1, int x2, int y2, uint32_t len, color_t *buf);
 void TFT_pushColorRep(int x1, int y1, int x2, int y2, color_t data, uint32_t len);
 void send_frame_buffer();
+void send_frame_buffer_rect(int x1, int y1, int x2, int y2);
 void TFT_display_setvars(display_config_t *dconfig);
 void tft_set_speed(uint32_t speed);
 uint32_t tft_get_speed();
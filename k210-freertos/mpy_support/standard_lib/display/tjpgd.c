@@ -936,31 +936,61 @@ JRESULT jd_decomp (
 	BYTE scale								/* Output de-scaling factor (0 to 3) */
 )
 {
-	UINT x, y, mx, my;
+	UINT mx, my;
+
+
+	mx = jd->msx * 8; my = jd->msy * 8;			/* Size of the MCU (pixel) */
+
+	return jd_decomp_part(jd, outfunc, scale, 0, ((jd->width + mx - 1) / mx) * ((jd->height + my - 1) / my));
+}
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Decompress a range of MCUs of the JPEG picture                        */
+/*-----------------------------------------------------------------------*/
+
+JRESULT jd_decomp_part (
+	JDEC* jd,								/* Initialized decompression object */
+	UINT (*outfunc)(JDEC*, void*, JRECT*),	/* RGB output function */
+	BYTE scale,								/* Output de-scaling factor (0 to 3) */
+	UINT mcu_start,							/* First MCU to decompress (must start a restart interval) */
+	UINT mcu_end							/* MCU following the last one to decompress */
+)
+{
+	UINT x, y, mx, my, n;
 	WORD rst, rsc;
 	JRESULT rc;
 
 
 	if (scale > (JD_USE_SCALE ? 3 : 0)) return JDR_PAR;
+	if (mcu_start && (!jd->nrst || mcu_start % jd->nrst)) return JDR_PAR;
 	jd->scale = scale;
 
 	mx = jd->msx * 8; my = jd->msy * 8;			/* Size of the MCU (pixel) */
+	n = (jd->width + mx - 1) / mx;				/* Number of MCUs in a row */
+	x = (mcu_start % n) * mx;					/* Position of the first MCU */
+	y = (mcu_start / n) * my;
 
 	jd->dcv[2] = jd->dcv[1] = jd->dcv[0] = 0;	/* Initialize DC values */
-	rst = rsc = 0;
+	rst = 0;
+	rsc = jd->nrst ? (WORD)(mcu_start / jd->nrst) : 0;	/* Number of the next expected RSTn marker */
 
 	rc = JDR_OK;
-	for (y = 0; y < jd->height; y += my) {		/* Vertical loop of MCUs */
-		for (x = 0; x < jd->width; x += mx) {	/* Horizontal loop of MCUs */
-			if (jd->nrst && rst++ == jd->nrst) {	/* Process restart interval if enabled */
-				rc = restart(jd, rsc++);
-				if (rc != JDR_OK) return rc;
-				rst = 1;
-			}
-			rc = mcu_load(jd);					/* Load an MCU (decompress huffman coded stream and apply IDCT) */
-			if (rc != JDR_OK) return rc;
-			rc = mcu_output(jd, outfunc, x, y);	/* Output the MCU (color space conversion, scaling and output) */
+	for (n = mcu_start; n < mcu_end; n++) {
+		if (jd->nrst && rst++ == jd->nrst) {	/* Process restart interval if enabled */
+			rc = restart(jd, rsc++);
 			if (rc != JDR_OK) return rc;
+			rst = 1;
+		}
+		rc = mcu_load(jd);					/* Load an MCU (decompress huffman coded stream and apply IDCT) */
+		if (rc != JDR_OK) return rc;
+		rc = mcu_output(jd, outfunc, x, y);	/* Output the MCU (color space conversion, scaling and output) */
+		if (rc != JDR_OK) return rc;
+		x += mx;
+		if (x >= jd->width) {				/* Next row of MCUs */
+			x = 0; y += my;
 		}
 	}
 
@@ -969,3 +999,44 @@ JRESULT jd_decomp (
 
 
 
+
+/*-----------------------------------------------------------------------*/
+/* Create a decompressor sharing the tables of a prepared one            */
+/*-----------------------------------------------------------------------*/
+
+JRESULT jd_fork (
+	JDEC* jd,			/* Blank decompressor object */
+	const JDEC* src,	/* Decompressor object initialized by jd_prepare */
+	UINT (*infunc)(JDEC*, BYTE*, UINT),	/* JPEG strem input function, positioned after the RSTn marker */
+	void* pool,			/* Working buffer for the decompression session */
+	UINT sz_pool,		/* Size of working buffer */
+	void* dev			/* I/O device identifier for the session */
+)
+{
+	UINT n, len;
+
+
+	if (!pool) return JDR_PAR;
+
+	*jd = *src;				/* Huffman and de-quantizer tables are only read during decompression */
+	jd->pool = pool;		/* Work memroy */
+	jd->sz_pool = sz_pool;	/* Size of given work memory */
+	jd->infunc = infunc;	/* Stream input function */
+	jd->device = dev;		/* I/O device identifier */
+
+	jd->inbuf = alloc_pool(jd, JD_SZBUF);		/* Allocate stream input buffer */
+	if (!jd->inbuf) return JDR_MEM1;
+
+	n = jd->msy * jd->msx;						/* Allocate working buffers as jd_prepare does */
+	len = n * 64 * 2 + 64;
+	if (len < 256) len = 256;
+	jd->workbuf = alloc_pool(jd, len);
+	if (!jd->workbuf) return JDR_MEM3;
+	jd->mcubuf = alloc_pool(jd, (n + 2) * 64);
+	if (!jd->mcubuf) return JDR_MEM4;
+
+	jd->dptr = jd->inbuf; jd->dctr = 0; jd->dmsk = 0;	/* Input buffer is empty, read on first use */
+
+	return JDR_OK;
+}
+
@@ -78,6 +78,8 @@ struct JDEC {
 /* TJpgDec API functions */
 JRESULT jd_prepare (JDEC*, UINT(*)(JDEC*,BYTE*,UINT), void*, UINT, void*);
 JRESULT jd_decomp (JDEC*, UINT(*)(JDEC*,void*,JRECT*), BYTE);
+JRESULT jd_decomp_part (JDEC*, UINT(*)(JDEC*,void*,JRECT*), BYTE, UINT, UINT);
+JRESULT jd_fork (JDEC*, const JDEC*, UINT(*)(JDEC*,BYTE*,UINT), void*, UINT, void*);
 
 
 #ifdef __cplusplus
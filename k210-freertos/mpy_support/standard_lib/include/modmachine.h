@@ -72,6 +72,7 @@ typedef enum _gpio_func_t
     GPIO_FUNC_WIFI_UART,
     GPIO_FUNC_TIMER,
     GPIO_FUNC_1WIRE,
+    GPIO_FUNC_I2S,
 } gpio_pin_func_t;
 
 typedef enum _gpio_func_as_t
@@ -97,6 +98,8 @@ typedef enum _gpio_func_as_t
     GPIO_USEDAS_DATA2,
     GPIO_USEDAS_DATA3,
     GPIO_USEDAS_1WIRE,
+    GPIO_USEDAS_WS,
+    GPIO_USEDAS_MCLK,
 } gpio_pin_func_as_t;
 
 
@@ -175,6 +178,29 @@ typedef struct _machine_pwm_obj_t {
 } __attribute__((aligned(8))) machine_pwm_obj_t;
 
 
+typedef struct _machine_i2s_obj_t {
+    mp_obj_base_t   base;
+    handle_t        handle;     // i2s device handle
+    int8_t          id;         // i2s device number (0~2)
+    uint8_t         mode;       // I2S_MODE_RX or I2S_MODE_TX
+    uint8_t         bits;       // bits per sample
+    uint8_t         channels;   // number of audio channels (2 per data line)
+    uint8_t         align;      // i2s align mode
+    bool            running;
+    int8_t          sck;
+    int8_t          ws;
+    int8_t          mclk;
+    int8_t          sd[4];      // data pins
+    uint32_t        rate;       // sample rate
+    uint32_t        buf_ms;     // DMA buffer length in ms
+    uint32_t        block_align;// bytes per frame
+    uint64_t        events;     // number of completed DMA buffers
+    uint64_t        cb_num;     // number of scheduled callbacks
+    uint64_t        cb_missed;  // number of callbacks not scheduled
+    mp_obj_t        callback;   // buffer completion callback
+    void            *dmabuf;    // buffer object returned by 'buffer()', invalidated when the DMA buffer is released
+} __attribute__((aligned(8))) machine_i2s_obj_t;
+
 typedef struct _mpy_flash_config_t {
     uint32_t    ver;
     bool        use_two_main_tasks;
@@ -212,8 +238,8 @@ extern handle_t flash_spi;
 extern handle_t gpiohs_handle;
 extern uint32_t mp_used_gpiohs;
 extern machine_pin_def_t mp_used_pins[FPIOA_NUM_IO];
-extern const char *gpiohs_funcs[16];
-extern const char *gpiohs_funcs_in_use[16];
+extern const char *gpiohs_funcs[17];
+extern const char *gpiohs_funcs_in_use[17];
 extern const char *reset_reason[8];
 extern const char *term_colors[8];
 extern mpy_config_t mpy_config;
@@ -244,6 +270,7 @@ extern const mp_obj_type_t machine_hw_i2c_type;
 extern const mp_obj_type_t machine_hw_spi_type;
 extern const mp_obj_type_t machine_timer_type;
 extern const mp_obj_type_t machine_pwm_type;
+extern const mp_obj_type_t machine_i2s_type;
 extern const mp_obj_type_t machine_onewire_type;
 extern const mp_obj_type_t machine_ds18x20_type;
 
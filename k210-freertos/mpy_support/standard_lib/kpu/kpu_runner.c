@@ -0,0 +1,80 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stddef.h>
+#include "kpu_runner.h"
+
+//----------------------------------------
+bool kpu_runner_init(kpu_runner_t *runner)
+{
+    runner->running = false;
+    runner->idle_sem = xSemaphoreCreateBinary();
+    if (runner->idle_sem == NULL) return false;
+    xSemaphoreGive(runner->idle_sem);
+    return true;
+}
+
+//------------------------------------------
+void kpu_runner_deinit(kpu_runner_t *runner)
+{
+    if (runner->idle_sem) {
+        vSemaphoreDelete(runner->idle_sem);
+        runner->idle_sem = NULL;
+    }
+}
+
+//---------------------------------------------------------
+bool kpu_runner_start(kpu_runner_t *runner, TickType_t tmo)
+{
+    if (xSemaphoreTake(runner->idle_sem, tmo) != pdTRUE) return false;
+    runner->running = true;
+    return true;
+}
+
+// 'running' is cleared before the token is given back,
+// when kpu_runner_wait() returns, kpu_runner_done() is always true
+//------------------------------------------
+void kpu_runner_finish(kpu_runner_t *runner)
+{
+    runner->running = false;
+    xSemaphoreGive(runner->idle_sem);
+}
+
+// The token is always taken, even if 'running' is already cleared:
+// the task may not have given it back yet
+//--------------------------------------------------------
+bool kpu_runner_wait(kpu_runner_t *runner, TickType_t tmo)
+{
+    if (xSemaphoreTake(runner->idle_sem, tmo) != pdTRUE) return false;
+    xSemaphoreGive(runner->idle_sem);
+    return true;
+}
+
+//----------------------------------------
+bool kpu_runner_done(kpu_runner_t *runner)
+{
+    return !runner->running;
+}
@@ -0,0 +1,58 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Synchronization between the KPU MicroPython object and its inference task
+ *
+ * 'idle_sem' is a token held by the inference: the run takes it and the task gives it back
+ * when the inference is finished. Waiting for the result takes the token and gives it back,
+ * so the state of the semaphore always matches the state of the inference and a finished
+ * inference never leaves a stale token for the next one.
+ */
+
+#ifndef _KPU_RUNNER_H_
+#define _KPU_RUNNER_H_
+
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+typedef struct _kpu_runner_t {
+    SemaphoreHandle_t idle_sem;     // given while no inference is running
+    volatile bool running;
+} kpu_runner_t;
+
+bool kpu_runner_init(kpu_runner_t *runner);
+void kpu_runner_deinit(kpu_runner_t *runner);
+// Wait for the previous inference to finish (up to 'tmo' ticks) and mark the new one as running
+bool kpu_runner_start(kpu_runner_t *runner, TickType_t tmo);
+// Called by the inference task after the results are stored
+void kpu_runner_finish(kpu_runner_t *runner);
+// Wait up to 'tmo' ticks for the running inference, true if no inference is running
+bool kpu_runner_wait(kpu_runner_t *runner, TickType_t tmo);
+bool kpu_runner_done(kpu_runner_t *runner);
+
+#endif
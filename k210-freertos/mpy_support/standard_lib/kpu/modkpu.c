@@ -0,0 +1,521 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * KPU (neural network accelerator) module
+ *
+ * The kmodel is loaded into FreeRTOS heap, outside of the MicroPython heap,
+ * either from a file or directly from the Flash address (model flashed by kflash).
+ * Inference runs in a separate FreeRTOS task, so the interpreter is free while
+ * the KPU is working. Two input buffers are used: while one is processed by the KPU,
+ * the other one can be filled with the next frame.
+ * The input buffers are allocated from the MicroPython heap, the memoryview returned
+ * by 'input()' keeps its buffer alive even after the model is freed.
+ * Outputs are copied from the model's main buffer, which is reused by the next inference
+ * and released with the model.
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "mpconfigport.h"
+
+#if MICROPY_K210_KPU_USED
+
+#include "devices.h"
+#include "kpu.h"
+#include "w25qxx.h"
+#include "syslog.h"
+
+#include "py/runtime.h"
+#include "py/obj.h"
+#include "py/objarray.h"
+#include "py/stream.h"
+#include "extmod/vfs.h"
+#include "mphalport.h"
+#include "modmachine.h"
+#include "kpu_runner.h"
+
+#define KPU_MODEL_VERSION       3
+#define KPU_TASK_RUN            0x01
+#define KPU_TASK_EXIT           0xA5
+
+typedef struct _kpu_model_obj_t {
+    mp_obj_base_t base;
+    handle_t handle;                // kpu model context handle
+    uint8_t *model;                 // kmodel data, allocated from FreeRTOS heap
+    size_t model_size;
+    uint8_t *input[2];              // double input buffers, allocated from MicroPython heap
+    size_t input_size;
+    uint16_t width;
+    uint16_t height;
+    uint16_t channels;
+    uint8_t in_idx;                 // index of the input buffer which can be filled by the user
+    uint8_t run_idx;                // index of the input buffer used by the running inference
+    kpu_runner_t runner;
+    int result;
+    uint64_t start_time;
+    uint64_t run_time;
+    uint32_t n_runs;
+    TaskHandle_t task_handle;
+    mp_obj_t callback;
+} __attribute__((aligned(8))) kpu_model_obj_t;
+
+const mp_obj_type_t kpu_model_type;
+
+static const char *TAG = "[KPU]";
+
+// Inference task, runs the model on request
+//--------------------------------------
+static void kpu_task(void *pvParameters)
+{
+    kpu_model_obj_t *self = (kpu_model_obj_t *)pvParameters;
+    uint64_t notify_val = 0;
+
+    while (1) {
+        notify_val = 0;
+        if (xTaskNotifyWait(0, ULONG_MAX, &notify_val, 1000 / portTICK_RATE_MS) != pdPASS) continue;
+        if (notify_val == KPU_TASK_EXIT) break; // Terminate task requested
+        if (notify_val != KPU_TASK_RUN) continue;
+
+        self->start_time = mp_hal_ticks_us();
+        self->result = kpu_run(self->handle, self->input[self->run_idx]);
+        self->run_time = mp_hal_ticks_us() - self->start_time;
+        self->n_runs++;
+        kpu_runner_finish(&self->runner);
+
+        if (self->callback) mp_sched_schedule(self->callback, self);
+    }
+
+    self->task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+//--------------------------------------------------------------
+static bool kpu_wait_done(kpu_model_obj_t *self, int timeout_ms)
+{
+    TickType_t tmo = (timeout_ms < 0) ? portMAX_DELAY : (timeout_ms / portTICK_PERIOD_MS);
+    MP_THREAD_GIL_EXIT();
+    bool res = kpu_runner_wait(&self->runner, tmo);
+    MP_THREAD_GIL_ENTER();
+    return res;
+}
+
+//-----------------------------------------------
+static void kpu_model_free(kpu_model_obj_t *self)
+{
+    // can be called from finaliser, do not release GIL here
+    if (self->runner.idle_sem) kpu_runner_wait(&self->runner, 5000 / portTICK_PERIOD_MS);
+    if (self->task_handle) {
+        xTaskNotify(self->task_handle, KPU_TASK_EXIT, eSetValueWithOverwrite);
+        int tmo = 100;
+        while ((self->task_handle) && (tmo > 0)) {
+            vTaskDelay(2);
+            tmo--;
+        }
+    }
+    if (self->handle) {
+        io_close(self->handle);
+        self->handle = 0;
+    }
+    kpu_runner_deinit(&self->runner);
+    // the input buffers are owned by the MicroPython heap, the memoryviews
+    // returned by 'input()' may still use them
+    self->input[0] = NULL;
+    self->input[1] = NULL;
+    if (self->model) vPortFree(self->model);
+    self->model = NULL;
+    self->callback = NULL;
+}
+
+// Load the model from file into FreeRTOS heap
+//-----------------------------------------------------------------
+static void kpu_load_file(kpu_model_obj_t *self, mp_obj_t fname_in)
+{
+    mp_obj_t args[2];
+    args[0] = fname_in;
+    args[1] = mp_obj_new_str("rb", 2);
+    mp_obj_t ffd = mp_vfs_open(2, args, (mp_map_t*)&mp_const_empty_map);
+    if (!ffd) {
+        mp_raise_msg(&mp_type_OSError, "Error opening model file");
+    }
+
+    int fsize = mp_stream_posix_lseek((void *)ffd, 0, SEEK_END);
+    int at_start = mp_stream_posix_lseek((void *)ffd, 0, SEEK_SET);
+    if ((fsize <= sizeof(kpu_model_header_t)) || (at_start != 0)) {
+        mp_stream_close(ffd);
+        mp_raise_msg(&mp_type_OSError, "Error getting model file size");
+    }
+    self->model = pvPortMalloc(fsize);
+    if (self->model == NULL) {
+        mp_stream_close(ffd);
+        mp_raise_msg(&mp_type_OSError, "Not enough memory to load the model");
+    }
+    self->model_size = fsize;
+    int rd = mp_stream_posix_read((void *)ffd, self->model, fsize);
+    mp_stream_close(ffd);
+    if (rd != fsize) {
+        mp_raise_msg(&mp_type_OSError, "Error reading model file");
+    }
+}
+
+// Load the model directly from Flash into FreeRTOS heap
+//---------------------------------------------------------------------------
+static void kpu_load_flash(kpu_model_obj_t *self, uint32_t addr, size_t size)
+{
+    if (size <= sizeof(kpu_model_header_t)) {
+        mp_raise_ValueError("Model size must be given when loading from Flash");
+    }
+    self->model = pvPortMalloc(size);
+    if (self->model == NULL) {
+        mp_raise_msg(&mp_type_OSError, "Not enough memory to load the model");
+    }
+    self->model_size = size;
+    if (w25qxx_read_data(addr, self->model, size) != W25QXX_OK) {
+        mp_raise_msg(&mp_type_OSError, "Error reading model from Flash");
+    }
+}
+
+// Check the model header and get the input shape from the first layer
+//------------------------------------------------
+static void kpu_model_check(kpu_model_obj_t *self)
+{
+    const kpu_model_header_t *header = (const kpu_model_header_t *)self->model;
+    if ((header->version != KPU_MODEL_VERSION) || (header->arch != 0) || (header->layers_length == 0)) {
+        mp_raise_ValueError("Unsupported kmodel format");
+    }
+    const kpu_model_layer_header_t *layer_header = (const kpu_model_layer_header_t *)(self->model + sizeof(kpu_model_header_t) +
+            sizeof(kpu_model_output_t) * header->output_count);
+    if (layer_header->type != KL_K210_CONV) {
+        mp_raise_ValueError("First model layer must be K210 convolution");
+    }
+    const kpu_model_conv_layer_argument_t *first_layer = (const kpu_model_conv_layer_argument_t *)((uint8_t *)layer_header +
+            sizeof(kpu_model_layer_header_t) * header->layers_length);
+    const kpu_layer_argument_t *layer_arg = (const kpu_layer_argument_t *)(self->model + first_layer->layer_offset);
+    self->width = layer_arg->image_size.data.i_row_wid + 1;
+    self->height = layer_arg->image_size.data.i_col_high + 1;
+    self->channels = layer_arg->image_channel_num.data.i_ch_num + 1;
+    self->input_size = self->width * self->height * self->channels;
+}
+
+//--------------------------------------------
+static void check_model(kpu_model_obj_t *self)
+{
+    if (self->handle == 0) {
+        mp_raise_ValueError("Model not loaded");
+    }
+}
+
+// ============================================================================================
+// === KPU MicroPython bindings ===============================================================
+// ============================================================================================
+
+//------------------------------------------------------------------------------------------
+STATIC void kpu_model_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind)
+{
+    kpu_model_obj_t *self = self_in;
+    if (self->handle == 0) {
+        mp_printf(print, "KPU_Model (Not loaded)");
+        return;
+    }
+    const kpu_model_header_t *header = (const kpu_model_header_t *)self->model;
+    mp_printf(print, "KPU_Model (Size=%u, Layers=%u, Outputs=%u, Main buffer=%u, Input=%ux%ux%u, Running=%s)",
+            self->model_size, header->layers_length, header->output_count, header->main_mem_usage,
+            self->width, self->height, self->channels, (kpu_runner_done(&self->runner)) ? "False" : "True");
+    mp_printf(print, "\n     Runs: %u, Last run time: %lu us", self->n_runs, self->run_time);
+}
+
+//-----------------------------------------------------------------------------------------------------------------
+STATIC mp_obj_t kpu_model_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args)
+{
+    enum { ARG_model, ARG_size, ARG_callback };
+    STATIC const mp_arg_t allowed_args[] = {
+        { MP_QSTR_model,                      MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_size,                                        MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_callback,                  MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, all_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if ((args[ARG_callback].u_obj != mp_const_none) && (!mp_obj_is_fun(args[ARG_callback].u_obj)) && (!mp_obj_is_meth(args[ARG_callback].u_obj))) {
+        mp_raise_ValueError("Function or None expected");
+    }
+
+    kpu_model_obj_t *self = m_new_obj_with_finaliser(kpu_model_obj_t);
+    memset(self, 0, sizeof(kpu_model_obj_t));
+    self->base.type = &kpu_model_type;
+
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        if (mp_obj_is_str(args[ARG_model].u_obj)) kpu_load_file(self, args[ARG_model].u_obj);
+        else kpu_load_flash(self, mp_obj_get_int(args[ARG_model].u_obj), args[ARG_size].u_int);
+        kpu_model_check(self);
+
+        for (int i=0; i<2; i++) {
+            self->input[i] = m_new(uint8_t, self->input_size);
+            memset(self->input[i], 0, self->input_size);
+        }
+        if (!kpu_runner_init(&self->runner)) {
+            mp_raise_msg(&mp_type_OSError, "Error creating semaphore");
+        }
+        self->handle = kpu_model_load_from_buffer(self->model);
+        if (self->handle == 0) {
+            mp_raise_msg(&mp_type_OSError, "Error loading the model");
+        }
+
+        // If only one MicroPython instance is running, inference task runs on the other processor
+        UBaseType_t proc = (mpy_config.config.use_two_main_tasks) ? uxPortGetProcessorId() : (MAIN_TASK_PROC ^ 1);
+        BaseType_t res = xTaskCreateAtProcessor(
+                proc,                                   // processor
+                kpu_task,                               // function entry
+                "KPU_task",                             // task name
+                configMINIMAL_STACK_SIZE * 2,           // stack_deepth
+                (void *)self,                           // function argument
+                MICROPY_TASK_PRIORITY,                  // task priority
+                &self->task_handle);                    // task handle
+        if (res != pdPASS) {
+            self->task_handle = NULL;
+            mp_raise_msg(&mp_type_OSError, "Error starting KPU task");
+        }
+        // if the callback is used, MicroPython state has to be available to the task
+        vTaskSetThreadLocalStoragePointer(self->task_handle, THREAD_LSP_STATE, pvTaskGetThreadLocalStoragePointer(NULL, THREAD_LSP_STATE));
+        vTaskSetThreadLocalStoragePointer(self->task_handle, THREAD_LSP_ARGS, pvTaskGetThreadLocalStoragePointer(NULL, THREAD_LSP_ARGS));
+        nlr_pop();
+    }
+    else {
+        kpu_model_free(self);
+        nlr_jump(nlr.ret_val);
+    }
+
+    self->callback = (args[ARG_callback].u_obj == mp_const_none) ? NULL : args[ARG_callback].u_obj;
+    LOGD(TAG, "Model loaded (%u bytes), input %ux%ux%u", self->model_size, self->width, self->height, self->channels);
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// Returns the input buffer which can be filled while the other one is processed
+//-----------------------------------------------
+STATIC mp_obj_t kpu_model_input(mp_obj_t self_in)
+{
+    kpu_model_obj_t *self = self_in;
+    check_model(self);
+    return mp_obj_new_memoryview('B' | MP_OBJ_ARRAY_TYPECODE_FLAG_RW, self->input_size, self->input[self->in_idx]);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(kpu_model_input_obj, kpu_model_input);
+
+// Start the inference on the current input buffer (or on the data from 'input' argument)
+// If the previous inference is still running, waits for it to finish
+// If 'wait' is False, returns immediately, 'done()' or 'wait()' can be used to check the result
+//---------------------------------------------------------------------------------------
+STATIC mp_obj_t kpu_model_run(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_input, ARG_wait };
+    STATIC const mp_arg_t allowed_args[] = {
+        { MP_QSTR_input,                                     MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_wait,                     MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = true} },
+    };
+    kpu_model_obj_t *self = pos_args[0];
+    check_model(self);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if (args[ARG_input].u_obj != mp_const_none) {
+        mp_buffer_info_t bufinfo;
+        mp_get_buffer_raise(args[ARG_input].u_obj, &bufinfo, MP_BUFFER_READ);
+        if (bufinfo.len != self->input_size) {
+            mp_raise_ValueError("Input size does not match the model input");
+        }
+        if (bufinfo.buf != self->input[self->in_idx]) memcpy(self->input[self->in_idx], bufinfo.buf, self->input_size);
+    }
+
+    // previous inference must be finished
+    MP_THREAD_GIL_EXIT();
+    kpu_runner_start(&self->runner, portMAX_DELAY);
+    MP_THREAD_GIL_ENTER();
+
+    self->run_idx = self->in_idx;
+    self->in_idx ^= 1;
+    xTaskNotify(self->task_handle, KPU_TASK_RUN, eSetValueWithOverwrite);
+
+    if (args[ARG_wait].u_bool) {
+        kpu_wait_done(self, -1);
+        if (self->result != 0) {
+            mp_raise_msg(&mp_type_OSError, "KPU run error");
+        }
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(kpu_model_run_obj, 1, kpu_model_run);
+
+//-----------------------------------------------------------------
+STATIC mp_obj_t kpu_model_wait(size_t n_args, const mp_obj_t *args)
+{
+    kpu_model_obj_t *self = args[0];
+    check_model(self);
+    int tmo = (n_args > 1) ? mp_obj_get_int(args[1]) : -1;
+    if (!kpu_wait_done(self, tmo)) return mp_const_false;
+    if (self->result != 0) {
+        mp_raise_msg(&mp_type_OSError, "KPU run error");
+    }
+    return mp_const_true;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(kpu_model_wait_obj, 1, 2, kpu_model_wait);
+
+//----------------------------------------------
+STATIC mp_obj_t kpu_model_done(mp_obj_t self_in)
+{
+    kpu_model_obj_t *self = self_in;
+    check_model(self);
+    return mp_obj_new_bool(kpu_runner_done(&self->runner));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(kpu_model_done_obj, kpu_model_done);
+
+// Returns the memoryview on the copy of the model output data
+//-------------------------------------------------------------------
+STATIC mp_obj_t kpu_model_output(size_t n_args, const mp_obj_t *args)
+{
+    kpu_model_obj_t *self = args[0];
+    check_model(self);
+    if (!kpu_runner_done(&self->runner)) {
+        mp_raise_msg(&mp_type_OSError, "Inference is running");
+    }
+    int idx = (n_args > 1) ? mp_obj_get_int(args[1]) : 0;
+    byte typecode = 'B';
+    if (n_args > 2) {
+        const char *fmt = mp_obj_str_get_str(args[2]);
+        if ((fmt[0] != 'B') && (fmt[0] != 'f')) {
+            mp_raise_ValueError("Output format can be 'B' or 'f'");
+        }
+        typecode = fmt[0];
+    }
+
+    uint8_t *data = NULL;
+    size_t size = 0;
+    if (kpu_get_output(self->handle, idx, &data, &size) != 0) {
+        mp_raise_ValueError("Wrong output index");
+    }
+    // the main buffer is reused by the next inference, return the copy
+    uint8_t *out = m_new(uint8_t, size);
+    memcpy(out, data, size);
+    if (typecode == 'f') size /= sizeof(float);
+    return mp_obj_new_memoryview(typecode, size, out);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(kpu_model_output_obj, 1, 3, kpu_model_output);
+
+//-------------------------------------------------
+STATIC mp_obj_t kpu_model_outputs(mp_obj_t self_in)
+{
+    kpu_model_obj_t *self = self_in;
+    check_model(self);
+    const kpu_model_header_t *header = (const kpu_model_header_t *)self->model;
+    return mp_obj_new_int(header->output_count);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(kpu_model_outputs_obj, kpu_model_outputs);
+
+//-----------------------------------------------
+STATIC mp_obj_t kpu_model_shape(mp_obj_t self_in)
+{
+    kpu_model_obj_t *self = self_in;
+    check_model(self);
+    mp_obj_t tuple[3];
+    tuple[0] = mp_obj_new_int(self->width);
+    tuple[1] = mp_obj_new_int(self->height);
+    tuple[2] = mp_obj_new_int(self->channels);
+    return mp_obj_new_tuple(3, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(kpu_model_shape_obj, kpu_model_shape);
+
+//----------------------------------------------
+STATIC mp_obj_t kpu_model_time(mp_obj_t self_in)
+{
+    kpu_model_obj_t *self = self_in;
+    return mp_obj_new_int_from_ull(self->run_time);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(kpu_model_time_obj, kpu_model_time);
+
+//--------------------------------------------------------------------
+STATIC mp_obj_t kpu_model_callback(mp_obj_t self_in, mp_obj_t func_in)
+{
+    kpu_model_obj_t *self = self_in;
+    if ((mp_obj_is_fun(func_in)) || (mp_obj_is_meth(func_in))) self->callback = func_in;
+    else if (func_in == mp_const_none) self->callback = NULL;
+    else {
+        mp_raise_ValueError("Function or None expected");
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(kpu_model_callback_obj, kpu_model_callback);
+
+//-----------------------------------------------------
+STATIC mp_obj_t kpu_model_free_method(mp_obj_t self_in)
+{
+    kpu_model_obj_t *self = self_in;
+    kpu_model_free(self);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(kpu_model_free_obj, kpu_model_free_method);
+
+
+//============================================================
+STATIC const mp_rom_map_elem_t kpu_model_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___del__),         MP_ROM_PTR(&kpu_model_free_obj) },
+    { MP_ROM_QSTR(MP_QSTR_free),            MP_ROM_PTR(&kpu_model_free_obj) },
+    { MP_ROM_QSTR(MP_QSTR_input),           MP_ROM_PTR(&kpu_model_input_obj) },
+    { MP_ROM_QSTR(MP_QSTR_run),             MP_ROM_PTR(&kpu_model_run_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wait),            MP_ROM_PTR(&kpu_model_wait_obj) },
+    { MP_ROM_QSTR(MP_QSTR_done),            MP_ROM_PTR(&kpu_model_done_obj) },
+    { MP_ROM_QSTR(MP_QSTR_output),          MP_ROM_PTR(&kpu_model_output_obj) },
+    { MP_ROM_QSTR(MP_QSTR_outputs),         MP_ROM_PTR(&kpu_model_outputs_obj) },
+    { MP_ROM_QSTR(MP_QSTR_shape),           MP_ROM_PTR(&kpu_model_shape_obj) },
+    { MP_ROM_QSTR(MP_QSTR_time),            MP_ROM_PTR(&kpu_model_time_obj) },
+    { MP_ROM_QSTR(MP_QSTR_callback),        MP_ROM_PTR(&kpu_model_callback_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(kpu_model_locals_dict, kpu_model_locals_dict_table);
+
+//==================================
+const mp_obj_type_t kpu_model_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_Model,
+    .print = kpu_model_print,
+    .make_new = kpu_model_make_new,
+    .locals_dict = (mp_obj_dict_t*)&kpu_model_locals_dict,
+};
+
+//==============================================================
+STATIC const mp_rom_map_elem_t mp_module_kpu_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__),    MP_ROM_QSTR(MP_QSTR_kpu) },
+    { MP_ROM_QSTR(MP_QSTR_Model),       MP_ROM_PTR(&kpu_model_type) },
+};
+STATIC MP_DEFINE_CONST_DICT(mp_module_kpu_globals, mp_module_kpu_globals_table);
+
+//=====================================
+const mp_obj_module_t mp_module_kpu = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t*)&mp_module_kpu_globals,
+};
+
+#endif // MICROPY_K210_KPU_USED
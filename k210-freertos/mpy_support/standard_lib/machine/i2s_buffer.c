@@ -0,0 +1,47 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+#include "i2s_buffer.h"
+
+//-----------------------------------------------------------------------------------------------------
+size_t i2s_buffer_transfer(handle_t handle, uint8_t *buf, size_t len, size_t block_align, bool capture)
+{
+    size_t done = 0;
+    size_t max_frames = len / block_align;
+    uint8_t *dmabuf = NULL;
+    size_t frames = 0;
+
+    while ((max_frames > 0) && (i2s_try_get_buffer(handle, &dmabuf, &frames))) {
+        if (frames > max_frames) frames = max_frames;
+        if (capture) memcpy(buf + done, dmabuf, frames * block_align);
+        else memcpy(dmabuf, buf + done, frames * block_align);
+        i2s_release_buffer(handle, frames);
+        done += frames * block_align;
+        max_frames -= frames;
+    }
+    return done;
+}
@@ -0,0 +1,47 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Copying the audio data between the user buffers and the I2S DMA buffers
+ *
+ * The i2s driver uses two DMA buffers, the one not used by the DMA is accessed
+ * with i2s_try_get_buffer()/i2s_release_buffer(). Only whole frames are copied.
+ */
+
+#ifndef _I2S_BUFFER_H_
+#define _I2S_BUFFER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "devices.h"
+
+// Copy as many frames as available and fit into 'len' bytes of 'buf'
+// from the DMA buffers ('capture' true) or to the DMA buffers ('capture' false).
+// Does not block, returns the number of bytes copied (always a multiple of 'block_align')
+size_t i2s_buffer_transfer(handle_t handle, uint8_t *buf, size_t len, size_t block_align, bool capture);
+
+#endif
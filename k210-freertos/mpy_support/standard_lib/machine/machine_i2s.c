@@ -0,0 +1,651 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "mpconfigport.h"
+
+#include "devices.h"
+#include "syslog.h"
+
+#include "py/runtime.h"
+#include "py/obj.h"
+#include "modmachine.h"
+#include "i2s_buffer.h"
+
+#define I2S_MAX_DEVICES         3
+#define I2S_MODE_RX             1
+#define I2S_MODE_TX             2
+#define I2S_FUNC_PER_DEVICE     (FUNC_I2S1_MCLK - FUNC_I2S0_MCLK)
+
+#define I2S_TASK_EXIT           0xA5
+
+static const char *TAG = "[I2S]";
+
+static machine_i2s_obj_t *i2s_used[I2S_MAX_DEVICES] = {NULL};
+static TaskHandle_t i2s_task_handle = NULL;
+
+// The buffer object returned by 'buffer()' points into the free part of the DMA buffer.
+// It is invalidated on 'release()', 'start()', 'stop()', 'init()' and 'deinit()',
+// any access after that raises ValueError.
+// As for the thread channel buffer, a memoryview taken from the buffer object holds only
+// the raw pointer and is NOT invalidated, it must not be used after the buffer is released.
+typedef struct _machine_i2s_buf_obj_t {
+    mp_obj_base_t       base;
+    machine_i2s_obj_t   *i2s;       // keeps the I2S object alive while the buffer is referenced
+    uint8_t             *buf;       // NULL if invalidated
+    uint32_t            len;
+    bool                rw;
+} machine_i2s_buf_obj_t;
+
+STATIC const mp_obj_type_t machine_i2s_buf_type;
+
+//-----------------------------------------------------
+static void i2s_buf_invalidate(machine_i2s_obj_t *self)
+{
+    machine_i2s_buf_obj_t *dmabuf = (machine_i2s_buf_obj_t *)self->dmabuf;
+    if (dmabuf != NULL) {
+        dmabuf->buf = NULL;
+        dmabuf->len = 0;
+        self->dmabuf = NULL;
+    }
+}
+
+// The task is used to schedule the MicroPython callback
+// after DMA has finished one of the buffers
+//--------------------------------------
+static void i2s_task(void *pvParameters)
+{
+    TaskHandle_t *task_handle = (TaskHandle_t)pvParameters;
+    // if the task uses some MicroPython functions, we have to save
+    // MicroPython state in local storage pointers
+    vTaskSetThreadLocalStoragePointer(NULL, THREAD_LSP_STATE, pvTaskGetThreadLocalStoragePointer(task_handle, THREAD_LSP_STATE));
+    vTaskSetThreadLocalStoragePointer(NULL, THREAD_LSP_ARGS, pvTaskGetThreadLocalStoragePointer(task_handle, THREAD_LSP_ARGS));
+
+    machine_i2s_obj_t *self = NULL;
+    uint64_t notify_val = 0;
+    int notify_res = 0;
+
+    while (1) {
+        notify_val = 0;
+        notify_res = xTaskNotifyWait(0, ULONG_MAX, &notify_val, 1000 / portTICK_RATE_MS);
+        if (notify_res != pdPASS) continue;
+        if (notify_val == I2S_TASK_EXIT) break; // Terminate task requested
+
+        // notification value contains the bits of the i2s devices with finished buffers
+        for (int i=0; i<I2S_MAX_DEVICES; i++) {
+            if ((notify_val & (1 << i)) == 0) continue;
+            self = i2s_used[i];
+            if ((self == NULL) || (self->callback == NULL)) continue;
+            if (mp_sched_schedule(self->callback, self)) self->cb_num++;
+            else self->cb_missed++;
+        }
+    }
+
+    i2s_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+// Called from DMA ISR when one of the DMA buffers is finished
+//----------------------------------------------
+static void i2s_stage_completion(void *userdata)
+{
+    machine_i2s_obj_t *self = (machine_i2s_obj_t *)userdata;
+    self->events++;
+    if ((self->callback) && (i2s_task_handle)) {
+        BaseType_t HPTaskAwoken = pdFALSE;
+        if (xTaskNotifyFromISR(i2s_task_handle, 1 << self->id, eSetBits, &HPTaskAwoken) == pdPASS) {
+            if (HPTaskAwoken == pdTRUE) vPortYieldFromISR();
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------------------------------
+static void i2s_pins_func(machine_i2s_obj_t *self, mp_fpioa_cfg_item_t *pin_func, int *n_func, bool used)
+{
+    int offset = self->id * I2S_FUNC_PER_DEVICE;
+    int n = 0;
+    pin_func[n++] = (mp_fpioa_cfg_item_t){-1, self->sck, GPIO_USEDAS_CLK, (used) ? FUNC_I2S0_SCLK + offset : FUNC_RESV0};
+    pin_func[n++] = (mp_fpioa_cfg_item_t){-1, self->ws, GPIO_USEDAS_WS, (used) ? FUNC_I2S0_WS + offset : FUNC_RESV0};
+    if (self->mclk >= 0) pin_func[n++] = (mp_fpioa_cfg_item_t){-1, self->mclk, GPIO_USEDAS_MCLK, (used) ? FUNC_I2S0_MCLK + offset : FUNC_RESV0};
+    for (int i=0; i<(self->channels/2); i++) {
+        fpioa_function_t func = (self->mode == I2S_MODE_RX) ? FUNC_I2S0_IN_D0 : FUNC_I2S0_OUT_D0;
+        pin_func[n++] = (mp_fpioa_cfg_item_t){-1, self->sd[i], GPIO_USEDAS_DATA0+i, (used) ? func + offset + i : FUNC_RESV0};
+    }
+    *n_func = n;
+}
+
+//---------------------------------------------------
+static void machine_i2s_stop(machine_i2s_obj_t *self)
+{
+    i2s_buf_invalidate(self);
+    if (self->running) {
+        i2s_stop(self->handle);
+        self->running = false;
+    }
+}
+
+//-----------------------------------------------------
+static void machine_i2s_deinit(machine_i2s_obj_t *self)
+{
+    i2s_buf_invalidate(self);
+    if (self->handle) {
+        machine_i2s_stop(self);
+        i2s_set_on_stage_completion(self->handle, NULL, NULL);
+        io_close(self->handle);
+        self->handle = 0;
+
+        mp_fpioa_cfg_item_t pin_func[7];
+        int n_func = 0;
+        i2s_pins_func(self, pin_func, &n_func, false);
+        fpioa_setup_pins(n_func, pin_func);
+        fpioa_freeused_pins(n_func, pin_func);
+    }
+    if ((self->id >= 0) && (i2s_used[self->id] == self)) i2s_used[self->id] = NULL;
+    self->callback = NULL;
+
+    int i;
+    for (i=0; i<I2S_MAX_DEVICES; i++) {
+        if (i2s_used[i]) break;
+    }
+    // Terminate I2S task if no I2S devices are used
+    if ((i >= I2S_MAX_DEVICES) && (i2s_task_handle)) xTaskNotify(i2s_task_handle, I2S_TASK_EXIT, eSetValueWithOverwrite);
+}
+
+//---------------------------------------------------
+static void machine_i2s_init(machine_i2s_obj_t *self)
+{
+    char i2sdev[16];
+
+    mp_fpioa_cfg_item_t pin_func[7];
+    int n_func = 0;
+    i2s_pins_func(self, pin_func, &n_func, true);
+    if (!fpioa_check_pins(n_func, pin_func, GPIO_FUNC_I2S)) {
+        mp_raise_ValueError("Requested pin is used by other function");
+    }
+
+    sprintf(i2sdev, "/dev/i2s%d", self->id);
+    self->handle = io_open(i2sdev);
+    if (self->handle == 0) {
+        mp_raise_msg(&mp_type_OSError, "Error opening I2S device");
+    }
+    fpioa_setup_pins(n_func, pin_func);
+    fpioa_setused_pins(n_func, pin_func, GPIO_FUNC_I2S);
+
+    audio_format_t format = {AUDIO_FMT_PCM, self->bits, self->rate, self->channels};
+    // each data line carries 2 audio channels
+    size_t channels_mask = (1 << self->channels) - 1;
+    if (self->mode == I2S_MODE_RX) i2s_config_as_capture(self->handle, &format, self->buf_ms, self->align, channels_mask);
+    else i2s_config_as_render(self->handle, &format, self->buf_ms, self->align, channels_mask);
+    self->block_align = self->channels * ((self->bits == 16) ? 2 : 4);
+
+    i2s_set_on_stage_completion(self->handle, i2s_stage_completion, (void *)self);
+    i2s_used[self->id] = self;
+
+    if (i2s_task_handle == NULL) {
+        BaseType_t res = xTaskCreate(
+                i2s_task,                               // function entry
+                "I2S_task",                             // task name
+                configMINIMAL_STACK_SIZE,               // stack_deepth
+                (void *)xTaskGetCurrentTaskHandle(),    // function argument
+                MICROPY_TASK_PRIORITY+1,                // task priority
+                &i2s_task_handle);                      // task handle
+        if (res != pdPASS) {
+            i2s_task_handle = NULL;
+            LOGE(TAG, "I2S task not started");
+        }
+    }
+}
+
+// ============================================================================================
+// === I2S MicroPython bindings ===============================================================
+// ============================================================================================
+
+enum { ARG_id, ARG_mode, ARG_sck, ARG_ws, ARG_sd, ARG_mclk, ARG_rate, ARG_bits, ARG_channels, ARG_buflen, ARG_align, ARG_callback };
+
+//-------------------------------------------------------
+STATIC const mp_arg_t machine_i2s_init_allowed_args[] = {
+        { MP_QSTR_id,                               MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_mode,                             MP_ARG_INT, {.u_int = I2S_MODE_RX} },
+        { MP_QSTR_sck,             MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = -1} },
+        { MP_QSTR_ws,              MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = -1} },
+        { MP_QSTR_sd,              MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_mclk,            MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = -1} },
+        { MP_QSTR_rate,            MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 16000} },
+        { MP_QSTR_bits,            MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 16} },
+        { MP_QSTR_channels,        MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 2} },
+        { MP_QSTR_buflen,          MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 50} },
+        { MP_QSTR_align,           MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = I2S_AM_STANDARD} },
+        { MP_QSTR_callback,        MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+};
+
+//--------------------------------------------------------------------------------------------
+STATIC void machine_i2s_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind)
+{
+    machine_i2s_obj_t *self = self_in;
+    if (self->handle == 0) {
+        mp_printf(print, "I2S (Deinitialized)");
+        return;
+    }
+    mp_printf(print, "I2S (Device=%d, Mode=%s, Rate=%u Hz, Bits=%u, Channels=%u, Buffer=%u ms, Running=%s)",
+            self->id, (self->mode == I2S_MODE_RX) ? "RX" : "TX", self->rate, self->bits, self->channels, self->buf_ms,
+            (self->running) ? "True" : "False");
+    mp_printf(print, "\n     sck=%d, ws=%d, mclk=%d, sd=%d", self->sck, self->ws, self->mclk, self->sd[0]);
+    for (int i=1; i<(self->channels/2); i++) {
+        mp_printf(print, ",%d", self->sd[i]);
+    }
+    mp_printf(print, "\n     Events: %lu; Callbacks: %lu; Missed: %lu", self->events, self->cb_num, self->cb_missed);
+}
+
+//----------------------------------------------------------------------------
+STATIC void machine_i2s_set_args(machine_i2s_obj_t *self, mp_arg_val_t args[])
+{
+    int id = args[ARG_id].u_int;
+    if ((id < 0) || (id >= I2S_MAX_DEVICES)) {
+        mp_raise_ValueError("I2S device not available (0~2)");
+    }
+    if ((args[ARG_mode].u_int != I2S_MODE_RX) && (args[ARG_mode].u_int != I2S_MODE_TX)) {
+        mp_raise_ValueError("RX or TX mode must be selected");
+    }
+    if ((args[ARG_bits].u_int != 16) && (args[ARG_bits].u_int != 24) && (args[ARG_bits].u_int != 32)) {
+        mp_raise_ValueError("Bits per sample can be 16, 24 or 32");
+    }
+    int channels = args[ARG_channels].u_int;
+    if ((channels < 2) || (channels > 8) || (channels & 1)) {
+        mp_raise_ValueError("Channels can be 2, 4, 6 or 8");
+    }
+    if ((args[ARG_rate].u_int < 8000) || (args[ARG_rate].u_int > 192000)) {
+        mp_raise_ValueError("Sample rate out of range (8000 ~ 192000)");
+    }
+    if ((args[ARG_align].u_int < I2S_AM_STANDARD) || (args[ARG_align].u_int > I2S_AM_LEFT)) {
+        mp_raise_ValueError("Wrong align mode");
+    }
+    if ((args[ARG_sck].u_int < 0) || (args[ARG_sck].u_int >= FPIOA_NUM_IO) ||
+        (args[ARG_ws].u_int < 0) || (args[ARG_ws].u_int >= FPIOA_NUM_IO)) {
+        mp_raise_ValueError("sck & ws must be given");
+    }
+    if ((args[ARG_mclk].u_int >= FPIOA_NUM_IO)) {
+        mp_raise_ValueError("Wrong mclk pin");
+    }
+    // DMA buffer must hold at least 100 frames
+    int buflen = args[ARG_buflen].u_int;
+    if ((buflen * args[ARG_rate].u_int / 1000) < 100) buflen = (100 * 1000 / args[ARG_rate].u_int) + 1;
+    if (buflen > 1000) {
+        mp_raise_ValueError("Buffer length out of range");
+    }
+
+    // Data pins, one data line for each two channels
+    mp_obj_t *sd_pins = NULL;
+    size_t n_sd = 0;
+    if (mp_obj_is_int(args[ARG_sd].u_obj)) {
+        sd_pins = &args[ARG_sd].u_obj;
+        n_sd = 1;
+    }
+    else if (args[ARG_sd].u_obj != mp_const_none) {
+        mp_obj_get_array(args[ARG_sd].u_obj, &n_sd, &sd_pins);
+    }
+    if (n_sd != (channels / 2)) {
+        mp_raise_ValueError("One sd pin must be given for each two channels");
+    }
+    for (int i=0; i<n_sd; i++) {
+        int pin = mp_obj_get_int(sd_pins[i]);
+        if ((pin < 0) || (pin >= FPIOA_NUM_IO)) {
+            mp_raise_ValueError("Wrong sd pin");
+        }
+        self->sd[i] = pin;
+    }
+
+    self->id = id;
+    self->mode = args[ARG_mode].u_int;
+    self->sck = args[ARG_sck].u_int;
+    self->ws = args[ARG_ws].u_int;
+    self->mclk = args[ARG_mclk].u_int;
+    self->rate = args[ARG_rate].u_int;
+    self->bits = args[ARG_bits].u_int;
+    self->channels = channels;
+    self->buf_ms = buflen;
+    self->align = args[ARG_align].u_int;
+    self->events = 0;
+    self->cb_num = 0;
+    self->cb_missed = 0;
+    if ((args[ARG_callback].u_obj != mp_const_none) && (mp_obj_is_fun(args[ARG_callback].u_obj) || mp_obj_is_meth(args[ARG_callback].u_obj))) {
+        self->callback = args[ARG_callback].u_obj;
+    }
+    else self->callback = NULL;
+}
+
+//-------------------------------------------------------------------------------------------------------------------
+STATIC mp_obj_t machine_i2s_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args)
+{
+    mp_arg_val_t args[MP_ARRAY_SIZE(machine_i2s_init_allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, all_args, MP_ARRAY_SIZE(machine_i2s_init_allowed_args), machine_i2s_init_allowed_args, args);
+
+    int id = args[ARG_id].u_int;
+    if ((id >= 0) && (id < I2S_MAX_DEVICES) && (i2s_used[id] != NULL)) {
+        mp_raise_msg(&mp_type_OSError, "I2S device already used");
+    }
+
+    machine_i2s_obj_t *self = m_new_obj_with_finaliser(machine_i2s_obj_t);
+    memset(self, 0, sizeof(machine_i2s_obj_t));
+    self->base.type = &machine_i2s_type;
+    self->id = -1;
+
+    machine_i2s_set_args(self, args);
+    machine_i2s_init(self);
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+//-------------------------------------------------------------------------------------------------
+STATIC mp_obj_t machine_i2s_init_method(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    machine_i2s_obj_t *self = pos_args[0];
+    mp_arg_val_t args[MP_ARRAY_SIZE(machine_i2s_init_allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(machine_i2s_init_allowed_args), machine_i2s_init_allowed_args, args);
+
+    if ((args[ARG_id].u_int >= 0) && (args[ARG_id].u_int < I2S_MAX_DEVICES) &&
+        (i2s_used[args[ARG_id].u_int] != NULL) && (i2s_used[args[ARG_id].u_int] != self)) {
+        mp_raise_msg(&mp_type_OSError, "I2S device already used");
+    }
+    machine_i2s_deinit(self);
+    machine_i2s_set_args(self, args);
+    machine_i2s_init(self);
+
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(machine_i2s_init_obj, 1, machine_i2s_init_method);
+
+//--------------------------------------------
+STATIC void check_i2s(machine_i2s_obj_t *self)
+{
+    if (self->handle == 0) {
+        mp_raise_ValueError("I2S not initialized");
+    }
+}
+
+//---------------------------------------------------------
+STATIC mp_obj_t machine_i2s_deinit_method(mp_obj_t self_in)
+{
+    machine_i2s_obj_t *self = self_in;
+    machine_i2s_deinit(self);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(machine_i2s_deinit_obj, machine_i2s_deinit_method);
+
+//--------------------------------------------------------
+STATIC mp_obj_t machine_i2s_start_method(mp_obj_t self_in)
+{
+    machine_i2s_obj_t *self = self_in;
+    check_i2s(self);
+    if (!self->running) {
+        // the partially prefilled TX buffer is closed by the driver
+        i2s_buf_invalidate(self);
+        i2s_start(self->handle);
+        self->running = true;
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(machine_i2s_start_obj, machine_i2s_start_method);
+
+//-------------------------------------------------------
+STATIC mp_obj_t machine_i2s_stop_method(mp_obj_t self_in)
+{
+    machine_i2s_obj_t *self = self_in;
+    check_i2s(self);
+    machine_i2s_stop(self);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(machine_i2s_stop_obj, machine_i2s_stop_method);
+
+// Copy as much data as available from the DMA buffer into the given buffer
+// Does not block, returns the number of bytes read (always multiple of frame size)
+//---------------------------------------------------------------------
+STATIC mp_obj_t machine_i2s_readinto(mp_obj_t self_in, mp_obj_t buf_in)
+{
+    machine_i2s_obj_t *self = self_in;
+    check_i2s(self);
+    if (self->mode != I2S_MODE_RX) {
+        mp_raise_ValueError("I2S not in RX mode");
+    }
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_in, &bufinfo, MP_BUFFER_WRITE);
+
+    size_t nread = i2s_buffer_transfer(self->handle, bufinfo.buf, bufinfo.len, self->block_align, true);
+    return mp_obj_new_int(nread);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(machine_i2s_readinto_obj, machine_i2s_readinto);
+
+// Copy as much data as possible from the given buffer to the DMA buffer
+// Does not block, returns the number of bytes written (always multiple of frame size)
+// Before 'start()' both DMA buffers can be filled, the playback starts with that data
+//------------------------------------------------------------------
+STATIC mp_obj_t machine_i2s_write(mp_obj_t self_in, mp_obj_t buf_in)
+{
+    machine_i2s_obj_t *self = self_in;
+    check_i2s(self);
+    if (self->mode != I2S_MODE_TX) {
+        mp_raise_ValueError("I2S not in TX mode");
+    }
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_in, &bufinfo, MP_BUFFER_READ);
+
+    size_t nwrite = i2s_buffer_transfer(self->handle, bufinfo.buf, bufinfo.len, self->block_align, false);
+    return mp_obj_new_int(nwrite);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(machine_i2s_write_obj, machine_i2s_write);
+
+// Returns the buffer object on the free part of the DMA buffer or None if not available
+// The buffer is writable in TX mode and read-only in RX mode
+// After processing the data, 'release(nbytes)' must be called, it invalidates the buffer object
+//--------------------------------------------------
+STATIC mp_obj_t machine_i2s_buffer(mp_obj_t self_in)
+{
+    machine_i2s_obj_t *self = self_in;
+    check_i2s(self);
+    i2s_buf_invalidate(self);
+    uint8_t *dmabuf = NULL;
+    size_t frames = 0;
+    if (!i2s_try_get_buffer(self->handle, &dmabuf, &frames)) return mp_const_none;
+
+    machine_i2s_buf_obj_t *buf = m_new_obj(machine_i2s_buf_obj_t);
+    buf->base.type = &machine_i2s_buf_type;
+    buf->i2s = self;
+    buf->buf = dmabuf;
+    buf->len = frames * self->block_align;
+    buf->rw = (self->mode == I2S_MODE_TX);
+    self->dmabuf = buf;
+    return MP_OBJ_FROM_PTR(buf);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(machine_i2s_buffer_obj, machine_i2s_buffer);
+
+//--------------------------------------------------------------------
+STATIC mp_obj_t machine_i2s_release(mp_obj_t self_in, mp_obj_t len_in)
+{
+    machine_i2s_obj_t *self = self_in;
+    check_i2s(self);
+    uint8_t *dmabuf = NULL;
+    size_t frames = 0;
+    if (!i2s_try_get_buffer(self->handle, &dmabuf, &frames)) return mp_const_false;
+
+    mp_int_t len = mp_obj_get_int(len_in);
+    if ((len < 0) || ((len / self->block_align) > frames)) {
+        mp_raise_ValueError("Wrong length");
+    }
+    i2s_buf_invalidate(self);
+    i2s_release_buffer(self->handle, len / self->block_align);
+    return mp_const_true;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(machine_i2s_release_obj, machine_i2s_release);
+
+//--------------------------------------------------------------------
+STATIC mp_obj_t machine_i2s_irq(mp_obj_t self_in, mp_obj_t handler_in)
+{
+    machine_i2s_obj_t *self = self_in;
+    check_i2s(self);
+    if ((mp_obj_is_fun(handler_in)) || (mp_obj_is_meth(handler_in))) {
+        self->callback = handler_in;
+    }
+    else if (handler_in == mp_const_none) self->callback = NULL;
+    else {
+        mp_raise_ValueError("Function or None expected");
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(machine_i2s_irq_obj, machine_i2s_irq);
+
+//--------------------------------------------------
+STATIC mp_obj_t machine_i2s_events(mp_obj_t self_in)
+{
+    machine_i2s_obj_t *self = self_in;
+    mp_obj_t tuple[3];
+    tuple[0] = mp_obj_new_int_from_ull(self->events);
+    tuple[1] = mp_obj_new_int_from_ull(self->cb_num);
+    tuple[2] = mp_obj_new_int_from_ull(self->cb_missed);
+    return mp_obj_new_tuple(3, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(machine_i2s_events_obj, machine_i2s_events);
+
+// ==== I2S DMA buffer object ====
+
+//----------------------------------------------------
+STATIC void i2s_buf_check(machine_i2s_buf_obj_t *self)
+{
+    if (self->buf == NULL) {
+        mp_raise_ValueError("I2S buffer released");
+    }
+}
+
+//------------------------------------------------------------------------------------------------
+STATIC void machine_i2s_buf_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind)
+{
+    machine_i2s_buf_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->buf == NULL) mp_printf(print, "I2SBuffer(released)");
+    else mp_printf(print, "I2SBuffer(len=%u, %s)", self->len, (self->rw) ? "rw" : "ro");
+}
+
+//--------------------------------------------------------------------------
+STATIC mp_obj_t machine_i2s_buf_unary_op(mp_unary_op_t op, mp_obj_t self_in)
+{
+    machine_i2s_buf_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    switch (op) {
+        case MP_UNARY_OP_BOOL: return mp_obj_new_bool(self->buf != NULL);
+        case MP_UNARY_OP_LEN: i2s_buf_check(self); return MP_OBJ_NEW_SMALL_INT(self->len);
+        default: return MP_OBJ_NULL; // op not supported
+    }
+}
+
+// Items and slices are copied, slice assignment must not change the buffer size
+//-----------------------------------------------------------------------------------------
+STATIC mp_obj_t machine_i2s_buf_subscr(mp_obj_t self_in, mp_obj_t index_in, mp_obj_t value)
+{
+    machine_i2s_buf_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (value == MP_OBJ_NULL) return MP_OBJ_NULL; // delete not supported
+    i2s_buf_check(self);
+    if ((value != MP_OBJ_SENTINEL) && (!self->rw)) {
+        mp_raise_TypeError("Read-only I2S buffer");
+    }
+
+    if (MP_OBJ_IS_TYPE(index_in, &mp_type_slice)) {
+        mp_bound_slice_t slice;
+        if (!mp_seq_get_fast_slice_indexes(self->len, index_in, &slice)) {
+            mp_raise_NotImplementedError("only slices with step=1 (aka None) are supported");
+        }
+        size_t slen = slice.stop - slice.start;
+        if (value == MP_OBJ_SENTINEL) {
+            return mp_obj_new_bytes(self->buf + slice.start, slen);
+        }
+        mp_buffer_info_t src;
+        mp_get_buffer_raise(value, &src, MP_BUFFER_READ);
+        if (src.len != slen) {
+            mp_raise_ValueError("Slice assignment can't change the buffer size");
+        }
+        memmove(self->buf + slice.start, src.buf, slen);
+        return mp_const_none;
+    }
+
+    size_t index = mp_get_index(self->base.type, self->len, index_in, false);
+    if (value == MP_OBJ_SENTINEL) {
+        return MP_OBJ_NEW_SMALL_INT(self->buf[index]);
+    }
+    self->buf[index] = mp_obj_get_int(value);
+    return mp_const_none;
+}
+
+// The buffer pointer obtained this way is only valid until the buffer is invalidated
+//------------------------------------------------------------------------------------------------------
+STATIC mp_int_t machine_i2s_buf_get_buffer(mp_obj_t self_in, mp_buffer_info_t *bufinfo, mp_uint_t flags)
+{
+    machine_i2s_buf_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    i2s_buf_check(self);
+    if ((flags & MP_BUFFER_WRITE) && (!self->rw)) return 1;
+    bufinfo->buf = self->buf;
+    bufinfo->len = self->len;
+    bufinfo->typecode = 'B';
+    return 0;
+}
+
+//=================================================
+STATIC const mp_obj_type_t machine_i2s_buf_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_I2SBuffer,
+    .print = machine_i2s_buf_print,
+    .unary_op = machine_i2s_buf_unary_op,
+    .subscr = machine_i2s_buf_subscr,
+    .buffer_p = { .get_buffer = machine_i2s_buf_get_buffer },
+};
+
+//==============================================================
+STATIC const mp_rom_map_elem_t machine_i2s_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___del__),         MP_ROM_PTR(&machine_i2s_deinit_obj) },
+    { MP_ROM_QSTR(MP_QSTR_init),            MP_ROM_PTR(&machine_i2s_init_obj) },
+    { MP_ROM_QSTR(MP_QSTR_deinit),          MP_ROM_PTR(&machine_i2s_deinit_obj) },
+    { MP_ROM_QSTR(MP_QSTR_start),           MP_ROM_PTR(&machine_i2s_start_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stop),            MP_ROM_PTR(&machine_i2s_stop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_readinto),        MP_ROM_PTR(&machine_i2s_readinto_obj) },
+    { MP_ROM_QSTR(MP_QSTR_write),           MP_ROM_PTR(&machine_i2s_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_buffer),          MP_ROM_PTR(&machine_i2s_buffer_obj) },
+    { MP_ROM_QSTR(MP_QSTR_release),         MP_ROM_PTR(&machine_i2s_release_obj) },
+    { MP_ROM_QSTR(MP_QSTR_irq),             MP_ROM_PTR(&machine_i2s_irq_obj) },
+    { MP_ROM_QSTR(MP_QSTR_events),          MP_ROM_PTR(&machine_i2s_events_obj) },
+
+    { MP_ROM_QSTR(MP_QSTR_RX),              MP_ROM_INT(I2S_MODE_RX) },
+    { MP_ROM_QSTR(MP_QSTR_TX),              MP_ROM_INT(I2S_MODE_TX) },
+    { MP_ROM_QSTR(MP_QSTR_STANDARD),        MP_ROM_INT(I2S_AM_STANDARD) },
+    { MP_ROM_QSTR(MP_QSTR_RIGHT),           MP_ROM_INT(I2S_AM_RIGHT) },
+    { MP_ROM_QSTR(MP_QSTR_LEFT),            MP_ROM_INT(I2S_AM_LEFT) },
+};
+STATIC MP_DEFINE_CONST_DICT(machine_i2s_locals_dict, machine_i2s_locals_dict_table);
+
+//======================================
+const mp_obj_type_t machine_i2s_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_I2S,
+    .print = machine_i2s_print,
+    .make_new = machine_i2s_make_new,
+    .locals_dict = (mp_obj_dict_t*)&machine_i2s_locals_dict,
+};
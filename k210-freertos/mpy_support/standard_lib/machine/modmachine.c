@@ -59,7 +59,7 @@ handle_t flash_spi = 0;
 
 uintptr_t sys_rambuf_ptr = 0;
 
-const char *gpiohs_funcs[16] = {
+const char *gpiohs_funcs[17] = {
         "Not used",
         "Flash",
         "SD Card",
@@ -75,10 +75,11 @@ const char *gpiohs_funcs[16] = {
         "GSM_UART",
         "WiFi_UART",
         "TIMER",
-        "I/O"
+        "I/O",
+        "I2S"
 };
 
-const char *gpiohs_funcs_in_use[16] = {
+const char *gpiohs_funcs_in_use[17] = {
         "pin not used",
         "pin used by Flash",
         "pin used by SD Card",
@@ -94,10 +95,11 @@ const char *gpiohs_funcs_in_use[16] = {
         "pin used by GSM_UART",
         "pin used by WiFi_UART",
         "pin used by Timer",
-        "pin used by 1Wire"
+        "pin used by 1Wire",
+        "pin used by I2S"
 };
 
-const char *gpiohs_usedas[21] = {
+const char *gpiohs_usedas[23] = {
         "--",
         "Tx",
         "Rx",
@@ -118,7 +120,9 @@ const char *gpiohs_usedas[21] = {
         "data1",
         "data2",
         "data3",
-        "1wire"
+        "1wire",
+        "ws",
+        "mclk"
 };
 
 const char *reset_reason[8] = {
@@ -785,6 +789,48 @@ STATIC mp_obj_t mod_machine_flash_read(mp_obj_t addr_in)
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_machine_flash_read_obj, mod_machine_flash_read);
 
+// Return the CRC32 of each 4 KB Flash sector in the range as bytes,
+// 4 bytes (little endian) per sector
+// Used by 'kflash.py --delta' to send only the changed sectors
+//-----------------------------------------------------------------------
+STATIC mp_obj_t mod_machine_flash_crc(mp_obj_t addr_in, mp_obj_t size_in)
+{
+    uint32_t addr = mp_obj_get_int(addr_in);
+    uint32_t size = mp_obj_get_int(size_in);
+    if ((addr % w25qxx_FLASH_SECTOR_SIZE) || (size == 0) || (addr >= MICRO_PY_FLASH_SIZE) ||
+        (size > (MICRO_PY_FLASH_SIZE - addr))) {
+        mp_raise_ValueError("Sector aligned address and size in Flash range expected");
+    }
+    // the flash size is a multiple of the sector size, the last partial sector is in range
+    int nsect = (size + w25qxx_FLASH_SECTOR_SIZE - 1) / w25qxx_FLASH_SECTOR_SIZE;
+    // the result is allocated first, vstr_init_len raises MemoryError
+    // and the sector buffer would not be freed
+    vstr_t vstr;
+    vstr_init_len(&vstr, nsect * 4);
+    uint8_t *buf = pvPortMalloc(w25qxx_FLASH_SECTOR_SIZE);
+    if (buf == NULL) {
+        vstr_clear(&vstr);
+        mp_raise_msg(&mp_type_MemoryError, "Error allocating sector buffer");
+    }
+
+    uint8_t *crc_out = (uint8_t *)vstr.buf;
+    for (int i = 0; i < nsect; i++) {
+        if (w25qxx_read_data(addr + (i * w25qxx_FLASH_SECTOR_SIZE), buf, w25qxx_FLASH_SECTOR_SIZE) != W25QXX_OK) {
+            vPortFree(buf);
+            vstr_clear(&vstr);
+            mp_raise_msg(&mp_type_OSError, "Flash read error");
+        }
+        uint32_t crc = mp_hal_crc32(buf, w25qxx_FLASH_SECTOR_SIZE);
+        crc_out[i*4] = crc & 0xFF;
+        crc_out[i*4 + 1] = (crc >> 8) & 0xFF;
+        crc_out[i*4 + 2] = (crc >> 16) & 0xFF;
+        crc_out[i*4 + 3] = crc >> 24;
+    }
+    vPortFree(buf);
+    return mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_machine_flash_crc_obj, mod_machine_flash_crc);
+
 //----------------------------------------------------
 STATIC mp_obj_t mod_machine_membytes(mp_obj_t size_in)
 {
@@ -800,6 +846,60 @@ STATIC mp_obj_t mod_machine_membytes(mp_obj_t size_in)
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_machine_membytes_obj, mod_machine_membytes);
 
+// Print or return the boot time trace
+// All times are in micro seconds since reset
+//------------------------------------------------------------------------------------------------
+STATIC mp_obj_t mod_machine_boot_trace(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
+{
+    enum { ARG_mark, ARG_print };
+    const mp_arg_t allowed_args[] = {
+       { MP_QSTR_mark,  MP_ARG_OBJ,                  { .u_obj = mp_const_none } },
+       { MP_QSTR_print, MP_ARG_KW_ONLY | MP_ARG_BOOL, { .u_bool = true } },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if (args[ARG_mark].u_obj != mp_const_none) {
+        // Add the time point to the trace
+        mp_hal_boot_trace_mark(mp_obj_str_get_str(args[ARG_mark].u_obj));
+        return mp_const_none;
+    }
+
+    const boot_trace_t *trace;
+    int count = mp_hal_boot_trace_get(&trace);
+
+    if (args[ARG_print].u_bool) {
+        mp_printf(&mp_plat_print, "\r\n%s   Start (ms)  Time (ms)  Boot trace\r\n---------------------------------------------%s\r\n", term_color(CYAN), term_color(DEFAULT));
+        for (int i=0; i<count; i++) {
+            mp_printf(&mp_plat_print, "%6lu.%03lu", trace[i].start / 1000, trace[i].start % 1000);
+            if (trace[i].end == 0) mp_printf(&mp_plat_print, "%11s", "...");
+            else if (trace[i].end == trace[i].start) mp_printf(&mp_plat_print, "%11s", "");
+            else {
+                uint64_t duration = trace[i].end - trace[i].start;
+                mp_printf(&mp_plat_print, "%7lu.%03lu", duration / 1000, duration % 1000);
+            }
+            mp_printf(&mp_plat_print, "  %*s%s\r\n", trace[i].level * 2, "", trace[i].name);
+        }
+        mp_printf(&mp_plat_print, "---------------------------------------------\r\n");
+        return mp_const_none;
+    }
+
+    // Return the list of (name, start, duration) tuples
+    // duration is 'None' for the time points and unfinished spans
+    mp_obj_t list = mp_obj_new_list(0, NULL);
+    mp_obj_t tuple[3];
+    for (int i=0; i<count; i++) {
+        tuple[0] = mp_obj_new_str(trace[i].name, strlen(trace[i].name));
+        tuple[1] = mp_obj_new_int_from_ull(trace[i].start);
+        if ((trace[i].end == 0) || (trace[i].end == trace[i].start)) tuple[2] = mp_const_none;
+        else tuple[2] = mp_obj_new_int_from_ull(trace[i].end - trace[i].start);
+        mp_obj_list_append(list, mp_obj_new_tuple(3, tuple));
+    }
+    return list;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(mod_machine_boot_trace_obj, 0, mod_machine_boot_trace);
+
 
 //===========================================================
 STATIC const mp_map_elem_t machine_module_globals_table[] = {
@@ -831,6 +931,8 @@ STATIC const mp_map_elem_t machine_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_vm_hook),         MP_ROM_PTR(&mod_machine_vm_hook_obj) },
     { MP_ROM_QSTR(MP_QSTR_vm_hook_wdt),     MP_ROM_PTR(&mod_machine_wdt_reset_in_vm_hook_obj) },
     { MP_ROM_QSTR(MP_QSTR_flash_read),      MP_ROM_PTR(&mod_machine_flash_read_obj) },
+    { MP_ROM_QSTR(MP_QSTR_flash_crc),       MP_ROM_PTR(&mod_machine_flash_crc_obj) },
+    { MP_ROM_QSTR(MP_QSTR_boot_trace),      MP_ROM_PTR(&mod_machine_boot_trace_obj) },
 
     { MP_ROM_QSTR(MP_QSTR_Pin),             MP_ROM_PTR(&machine_pin_type) },
     { MP_ROM_QSTR(MP_QSTR_UART),            MP_ROM_PTR(&machine_uart_type) },
@@ -838,6 +940,7 @@ STATIC const mp_map_elem_t machine_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_SPI),             MP_ROM_PTR(&machine_hw_spi_type) },
     { MP_ROM_QSTR(MP_QSTR_Timer),           MP_ROM_PTR(&machine_timer_type) },
     { MP_ROM_QSTR(MP_QSTR_PWM),             MP_ROM_PTR(&machine_pwm_type) },
+    { MP_ROM_QSTR(MP_QSTR_I2S),             MP_ROM_PTR(&machine_i2s_type) },
     { MP_OBJ_NEW_QSTR(MP_QSTR_Onewire),     MP_ROM_PTR(&machine_onewire_type) },
 
     { MP_ROM_QSTR(MP_QSTR_RAM_START),       MP_ROM_INT(K210_SRAM_START_ADDRESS) },
@@ -43,11 +43,15 @@
 #include "modmachine.h"
 #include "extmod/vfs.h"
 #include "py/stream.h"
+#if MICROPY_PY_UZLIB_COMPRESS
+#include "extmod/uzlib/uzlib.h"
+#endif
 
 #define MAX_HTTP_RECV_BUFFER    512
 #define FLOAT_FIELD_DEC_PLACES  8
 #define DEFAULT_RQBODY_LEN      64*1024
 #define DEFAULT_RQHEADER_LEN    2048
+#define GZIP_BODY_WBITS         12      // 4 KB window, ~40 KB of compressor memory
 
 static const char *TAG = "[REQUESTS]";
 static const char *TAG_EVENT = "[REQUESTS EVENT]";
@@ -433,8 +437,57 @@ static int multipart_post_fields(mp_obj_dict_t *dict, char *bndry, esp_http_clie
     return data_len;
 }
 
-//----------------------------------------------------------------------------------------------------------------
-static mp_obj_t request(int method, bool multipart, mp_obj_t post_data_in, char * url, char *tofile, int buf_size)
+#if MICROPY_PY_UZLIB_COMPRESS
+typedef struct _gzip_body_t {
+    struct uzlib_comp comp;
+    char *buf;
+    int len;
+    int size;
+} gzip_body_t;
+
+//-----------------------------------------------------------------------------------------------
+static void gzip_body_write(struct uzlib_comp *comp, const unsigned char *data, unsigned int len)
+{
+    gzip_body_t *body = (gzip_body_t *)comp;
+    if ((body->len + (int)len) <= body->size) memcpy(body->buf + body->len, data, len);
+    body->len += len;
+}
+
+// Compress the request body with gzip
+// Returns the allocated buffer with compressed data or NULL
+// if there is not enough memory or the data are not compressible
+//------------------------------------------------------------
+static char *gzip_body(const char *data, int len, int *gz_len)
+{
+    char *gz_data = NULL;
+    gzip_body_t *body = pvPortMalloc(sizeof(gzip_body_t));
+    void *mem = pvPortMalloc(UZLIB_COMP_MEM_SIZE(GZIP_BODY_WBITS));
+
+    if ((body) && (mem)) {
+        // compressed data larger than the original are not used
+        body->size = len;
+        body->len = 0;
+        body->buf = pvPortMalloc(body->size);
+        if (body->buf) {
+            uzlib_compress_init(&body->comp, mem, GZIP_BODY_WBITS, 6, TINF_CHKSUM_CRC);
+            body->comp.dest_write_cb = gzip_body_write;
+            uzlib_compress_write(&body->comp, data, len);
+            uzlib_compress_flush(&body->comp, UZLIB_FLUSH_FINISH);
+            if (body->len < len) {
+                gz_data = body->buf;
+                *gz_len = body->len;
+            }
+            else vPortFree(body->buf);
+        }
+    }
+    if (mem) vPortFree(mem);
+    if (body) vPortFree(body);
+    return gz_data;
+}
+#endif
+
+//---------------------------------------------------------------------------------------------------------------------------
+static mp_obj_t request(int method, bool multipart, mp_obj_t post_data_in, char * url, char *tofile, int buf_size, bool gzip)
 {
     if (transport_debug) LOGI(TAG, "Preparing HTTP Request");
     int status;
@@ -593,11 +646,25 @@ static mp_obj_t request(int method, bool multipart, mp_obj_t post_data_in, char
     }
 
     if (!perform_handled) {
+        char *gz_data = NULL;
+        #if MICROPY_PY_UZLIB_COMPRESS
+        if ((gzip) && (post_data)) {
+            // Send the compressed body
+            int gz_len = 0;
+            gz_data = gzip_body(post_data, strlen(post_data), &gz_len);
+            if (gz_data) {
+                esp_http_client_set_post_field(client, gz_data, gz_len);
+                esp_http_client_set_header(client, "Content-Encoding", "gzip");
+                if (transport_debug) LOGD(TAG, "Body compressed: %d -> %d", (int)strlen(post_data), gz_len);
+            }
+        }
+        #endif
         // POST method is already handled, handle others methods here
         MP_THREAD_GIL_EXIT();
         err = esp_http_client_perform(client);
         esp_http_client_cleanup(client);
         if ((free_post_data) && (post_data)) vPortFree(post_data);
+        if (gz_data) vPortFree(gz_data);
         MP_THREAD_GIL_ENTER();
     }
 
@@ -709,7 +776,7 @@ STATIC mp_obj_t requests_GET(size_t n_args, const mp_obj_t *pos_args, mp_map_t *
         fname = (char *)mp_obj_str_get_str(args[ARG_file].u_obj);
     }
 
-    mp_obj_t res = request(HTTP_METHOD_GET, false, NULL, url, fname, args[ARG_bufsize].u_int);
+    mp_obj_t res = request(HTTP_METHOD_GET, false, NULL, url, fname, args[ARG_bufsize].u_int, false);
 
     return res;
 }
@@ -731,7 +798,7 @@ STATIC mp_obj_t requests_HEAD(size_t n_args, const mp_obj_t *pos_args, mp_map_t
 
     url = (char *)mp_obj_str_get_str(args[ARG_url].u_obj);
 
-    mp_obj_t res = request(HTTP_METHOD_HEAD, false, NULL, url, NULL, 1536);
+    mp_obj_t res = request(HTTP_METHOD_HEAD, false, NULL, url, NULL, 1536, false);
 
     return res;
 }
@@ -741,7 +808,7 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_KW(requests_HEAD_obj, 1, requests_HEAD);
 STATIC mp_obj_t requests_POST(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
 {
     //network_checkConnection();
-    enum { ARG_url, ARG_params, ARG_file, ARG_multipart, ARG_base64, ARG_bufsize };
+    enum { ARG_url, ARG_params, ARG_file, ARG_multipart, ARG_base64, ARG_bufsize, ARG_gzip };
     const mp_arg_t allowed_args[] = {
         { MP_QSTR_url,        MP_ARG_REQUIRED | MP_ARG_OBJ,  { .u_obj = mp_const_none } },
         { MP_QSTR_params,     MP_ARG_REQUIRED | MP_ARG_OBJ,  { .u_obj = mp_const_none } },
@@ -749,6 +816,7 @@ STATIC mp_obj_t requests_POST(size_t n_args, const mp_obj_t *pos_args, mp_map_t
         { MP_QSTR_multipart,                    MP_ARG_BOOL, { .u_bool = false } },
         { MP_QSTR_base64,                       MP_ARG_BOOL, { .u_bool = false } },
         { MP_QSTR_bufsize,                      MP_ARG_INT, { .u_int = 1536 } },
+        { MP_QSTR_gzip,                         MP_ARG_BOOL, { .u_bool = false } },
     };
 
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
@@ -765,7 +833,7 @@ STATIC mp_obj_t requests_POST(size_t n_args, const mp_obj_t *pos_args, mp_map_t
         fname = (char *)mp_obj_str_get_str(args[ARG_file].u_obj);
     }
 
-    mp_obj_t res = request(HTTP_METHOD_POST, args[ARG_multipart].u_bool, args[ARG_params].u_obj, url, fname, args[ARG_bufsize].u_int);
+    mp_obj_t res = request(HTTP_METHOD_POST, args[ARG_multipart].u_bool, args[ARG_params].u_obj, url, fname, args[ARG_bufsize].u_int, args[ARG_gzip].u_bool);
 
     return res;
 }
@@ -775,10 +843,11 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_KW(requests_POST_obj, 1, requests_POST);
 STATIC mp_obj_t requests_PUT(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
 {
     //network_checkConnection();
-    enum { ARG_url, ARG_data };
+    enum { ARG_url, ARG_data, ARG_gzip };
     const mp_arg_t allowed_args[] = {
-        { MP_QSTR_url,  MP_ARG_REQUIRED | MP_ARG_OBJ, { .u_obj = mp_const_none } },
-        { MP_QSTR_data, MP_ARG_REQUIRED | MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_url,  MP_ARG_REQUIRED | MP_ARG_OBJ,  { .u_obj = mp_const_none } },
+        { MP_QSTR_data, MP_ARG_REQUIRED | MP_ARG_OBJ,  { .u_obj = mp_const_none } },
+        { MP_QSTR_gzip,                   MP_ARG_BOOL, { .u_bool = false } },
     };
 
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
@@ -788,7 +857,7 @@ STATIC mp_obj_t requests_PUT(size_t n_args, const mp_obj_t *pos_args, mp_map_t *
 
     url = (char *)mp_obj_str_get_str(args[ARG_url].u_obj);
 
-    mp_obj_t res = request(HTTP_METHOD_PUT, false, args[ARG_data].u_obj, url, NULL, 1536);
+    mp_obj_t res = request(HTTP_METHOD_PUT, false, args[ARG_data].u_obj, url, NULL, 1536, args[ARG_gzip].u_bool);
 
     return res;
 }
@@ -798,10 +867,11 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_KW(requests_PUT_obj, 1, requests_PUT);
 STATIC mp_obj_t requests_PATCH(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
 {
     //network_checkConnection();
-    enum { ARG_url, ARG_data };
+    enum { ARG_url, ARG_data, ARG_gzip };
     const mp_arg_t allowed_args[] = {
-        { MP_QSTR_url,  MP_ARG_REQUIRED | MP_ARG_OBJ, { .u_obj = mp_const_none } },
-        { MP_QSTR_data, MP_ARG_REQUIRED | MP_ARG_OBJ, { .u_obj = mp_const_none } },
+        { MP_QSTR_url,  MP_ARG_REQUIRED | MP_ARG_OBJ,  { .u_obj = mp_const_none } },
+        { MP_QSTR_data, MP_ARG_REQUIRED | MP_ARG_OBJ,  { .u_obj = mp_const_none } },
+        { MP_QSTR_gzip,                   MP_ARG_BOOL, { .u_bool = false } },
     };
 
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
@@ -811,7 +881,7 @@ STATIC mp_obj_t requests_PATCH(size_t n_args, const mp_obj_t *pos_args, mp_map_t
 
     url = (char *)mp_obj_str_get_str(args[ARG_url].u_obj);
 
-    mp_obj_t res = request(HTTP_METHOD_PATCH, false, args[ARG_data].u_obj, url, NULL, 1536);
+    mp_obj_t res = request(HTTP_METHOD_PATCH, false, args[ARG_data].u_obj, url, NULL, 1536, args[ARG_gzip].u_bool);
 
     return res;
 }
@@ -834,7 +904,7 @@ STATIC mp_obj_t requests_DELETE(size_t n_args, const mp_obj_t *pos_args, mp_map_
 
     url = (char *)mp_obj_str_get_str(args[ARG_url].u_obj);
 
-    mp_obj_t res = request(HTTP_METHOD_DELETE, false, args[ARG_data].u_obj, url, NULL, 1536);
+    mp_obj_t res = request(HTTP_METHOD_DELETE, false, args[ARG_data].u_obj, url, NULL, 1536, false);
 
     return res;
 }
@@ -49,6 +49,7 @@
 #include "lwip/ip4.h"
 #include "lwip/igmp.h"
 #include "syslog.h"
+#include "socket_xfer.h"
 
 #define SOCKET_POLL_US      (100000)
 #define SOCKET_TIMEOUT_MAX  43200000
@@ -151,6 +152,15 @@ static inline void check_for_exceptions(void)
     mp_handle_pending();
 }
 
+// Boot trace mark of the first data received over lwIP (Ethernet, GSM),
+// the WiFi module is not using lwIP and is traced in modwifi
+//------------------------------------
+static void lwip_first_rx_mark(void)
+{
+    static bool first_rx = true;
+    if (__atomic_exchange_n(&first_rx, false, __ATOMIC_RELAXED)) mp_hal_boot_trace_mark("lwip first rx");
+}
+
 //----------------------------------------------------
 static void _socket_freeaddrinfo(struct addrinfo *res)
 {
@@ -870,6 +880,7 @@ STATIC mp_uint_t _socket_read_data(mp_obj_t self_in, void *buf, size_t size,
         r = lwip_recvfrom(sock->fd, buf, size, 0, from, from_len);
         MP_THREAD_GIL_ENTER();
         if (r == 0) sock->peer_closed = true;
+        if (r > 0) lwip_first_rx_mark();
         if (r >= 0) return r;
         if (errno != EWOULDBLOCK) {
             *errcode = errno;
@@ -1103,6 +1114,220 @@ STATIC mp_obj_t socket_sendto(mp_obj_t self_in, mp_obj_t data_in, mp_obj_t addr_
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_3(socket_sendto_obj, socket_sendto);
 
+// ==== Socket <-> file transfer ==============================================
+// The transfer is run by socket_xfer.c, the network side of the transfer
+// is executed by its helper task using the functions below.
+
+#define SOCKET_XFER_BUF_WIFI    2048            // max data length of one 'AT+TCPSEND' command
+#define SOCKET_XFER_BUF_LWIP    (TCP_MSS * 2)
+
+// Send one buffer over WiFi, runs in the transfer task
+//-------------------------------------------------------------
+static int _socket_xfer_send_wifi(socket_xfer_t *xfer, int idx)
+{
+    int r = wifi_send((socket_obj_t *)xfer->sock, (const char *)xfer->buf[idx], xfer->len[idx]);
+    if (r < 0) xfer->err = errno;
+    return r;
+}
+
+// Send one buffer over lwIP, runs in the transfer task
+//-------------------------------------------------------------
+static int _socket_xfer_send_lwip(socket_xfer_t *xfer, int idx)
+{
+    socket_obj_t *sock = (socket_obj_t *)xfer->sock;
+    const char *data = (const char *)xfer->buf[idx];
+    int datalen = xfer->len[idx];
+    int sentlen = 0;
+    int r;
+
+    int wait_end = mp_hal_ticks_ms() + sock->timeout;
+    while (sentlen < datalen) {
+        r = lwip_write(sock->fd, data+sentlen, datalen-sentlen);
+        if (r > 0) {
+            sentlen += r;
+            wait_end = mp_hal_ticks_ms() + sock->timeout;
+            continue;
+        }
+        if ((r < 0) && (errno != EWOULDBLOCK)) {
+            xfer->err = errno;
+            return -1;
+        }
+        if (mp_hal_ticks_ms() > wait_end) {
+            xfer->err = MP_ETIMEDOUT;
+            return -1;
+        }
+        vTaskDelay(2);
+        mp_hal_wdt_reset();
+    }
+    return sentlen;
+}
+
+// Receive into one buffer, runs in the transfer task
+// Returns when some data was received and no more data is available,
+// so that the file writes are not delayed waiting for the full buffer
+//-------------------------------------------------------------------
+static int _socket_xfer_recv(socket_xfer_t *xfer, int idx, bool wifi)
+{
+    socket_obj_t *sock = (socket_obj_t *)xfer->sock;
+    uint8_t *data = xfer->buf[idx];
+    int size = xfer->len[idx];
+    int rdlen = 0;
+    int r;
+
+    int wait_end = mp_hal_ticks_ms() + sock->timeout;
+    while (rdlen < size) {
+        if (wifi) {
+            r = wifi_read(sock, (const char *)(data+rdlen), size-rdlen);
+            if (wifi_task_semaphore) xSemaphoreGive(wifi_task_semaphore);
+        }
+        else {
+            if (sock->peer_closed) break;
+            r = lwip_recvfrom(sock->fd, data+rdlen, size-rdlen, 0, NULL, NULL);
+            if (r == 0) sock->peer_closed = true;
+            if (r > 0) lwip_first_rx_mark();
+        }
+        if (r == 0) break;
+        if (r > 0) {
+            rdlen += r;
+            wait_end = mp_hal_ticks_ms() + sock->timeout;
+            continue;
+        }
+        if (errno != EWOULDBLOCK) {
+            if (rdlen > 0) break;
+            xfer->err = errno;
+            return -1;
+        }
+        if (rdlen > 0) break;
+        if (mp_hal_ticks_ms() > wait_end) {
+            xfer->err = MP_ETIMEDOUT;
+            return -1;
+        }
+        vTaskDelay((wifi) ? 10 : 2);
+        mp_hal_wdt_reset();
+    }
+    return rdlen;
+}
+
+//-------------------------------------------------------------
+static int _socket_xfer_recv_wifi(socket_xfer_t *xfer, int idx)
+{
+    return _socket_xfer_recv(xfer, idx, true);
+}
+
+//-------------------------------------------------------------
+static int _socket_xfer_recv_lwip(socket_xfer_t *xfer, int idx)
+{
+    return _socket_xfer_recv(xfer, idx, false);
+}
+
+//------------------------------------------------------------------
+static int _socket_xfer_file_read(void *file, uint8_t *buf, int len)
+{
+    return mp_stream_posix_read(file, buf, len);
+}
+
+//-------------------------------------------------------------------
+static int _socket_xfer_file_write(void *file, uint8_t *buf, int len)
+{
+    return mp_stream_posix_write(file, buf, len);
+}
+
+// Returns true if the transfer uses the WiFi module
+//--------------------------------------------------------------------------------
+static bool _socket_xfer_start(socket_xfer_t *xfer, socket_obj_t *sock, bool send)
+{
+    check_net_interfaces();
+    if (net_active_interfaces & ACTIVE_INTERFACE_GSM) {
+        mp_raise_msg(&mp_type_NotImplementedError, "Not available in GSM IDLE mode");
+    }
+    if (sock->listening) {
+        mp_raise_ValueError("Socket in listening mode");
+    }
+
+    bool wifi = (net_active_interfaces & ACTIVE_INTERFACE_WIFI);
+    socket_xfer_net_t net;
+    if (send) net = (wifi) ? _socket_xfer_send_wifi : _socket_xfer_send_lwip;
+    else net = (wifi) ? _socket_xfer_recv_wifi : _socket_xfer_recv_lwip;
+    if (!socket_xfer_start(xfer, sock, send, (wifi) ? SOCKET_XFER_BUF_WIFI : SOCKET_XFER_BUF_LWIP, net, check_for_exceptions)) {
+        mp_raise_msg(&mp_type_OSError, "Error starting the transfer");
+    }
+    if ((wifi) && (!send) && (wifi_task_semaphore)) wifi_task_semaphore_active = true;
+    return wifi;
+}
+
+//----------------------------------------------------------
+static void _socket_xfer_end(socket_xfer_t *xfer, bool wifi)
+{
+    socket_xfer_end(xfer);
+    if ((wifi) && (!xfer->send) && (wifi_task_semaphore)) wifi_task_semaphore_active = false;
+}
+
+// Any error raises the exception, also if some data were already transferred
+//------------------------------------------------------------------
+STATIC mp_obj_t socket_sendfile(size_t n_args, const mp_obj_t *args)
+{
+    socket_obj_t *sock = MP_OBJ_TO_PTR(args[0]);
+    mp_obj_t file = args[1];
+    mp_get_stream_raise(file, MP_STREAM_OP_READ);
+    mp_int_t offset = (n_args > 2) ? mp_obj_get_int(args[2]) : 0;
+    mp_int_t count = ((n_args > 3) && (args[3] != mp_const_none)) ? mp_obj_get_int(args[3]) : -1;
+    if (offset < 0) {
+        mp_raise_ValueError("Negative offset");
+    }
+    if (offset > 0) {
+        if (mp_stream_posix_lseek((void *)file, offset, SEEK_SET) < 0) mp_raise_OSError(errno);
+    }
+
+    socket_xfer_t xfer;
+    bool wifi = _socket_xfer_start(&xfer, sock, true);
+    int res;
+
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        res = socket_xfer_send_file(&xfer, (void *)file, _socket_xfer_file_read, count);
+        nlr_pop();
+    }
+    else {
+        _socket_xfer_end(&xfer, wifi);
+        nlr_jump(nlr.ret_val);
+    }
+    _socket_xfer_end(&xfer, wifi);
+
+    if (res < 0) exception_from_errno(xfer.err);
+    return mp_obj_new_int(res);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(socket_sendfile_obj, 2, 4, socket_sendfile);
+
+// Any error raises the exception, also if some data were already written to the file
+// A short file write (file system full) raises ENOSPC
+//-----------------------------------------------------------------------
+STATIC mp_obj_t socket_recvinto_file(size_t n_args, const mp_obj_t *args)
+{
+    socket_obj_t *sock = MP_OBJ_TO_PTR(args[0]);
+    mp_obj_t file = args[1];
+    mp_get_stream_raise(file, MP_STREAM_OP_WRITE);
+    mp_int_t count = ((n_args > 2) && (args[2] != mp_const_none)) ? mp_obj_get_int(args[2]) : -1;
+
+    socket_xfer_t xfer;
+    bool wifi = _socket_xfer_start(&xfer, sock, false);
+    int res;
+
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        res = socket_xfer_recv_file(&xfer, (void *)file, _socket_xfer_file_write, count);
+        nlr_pop();
+    }
+    else {
+        _socket_xfer_end(&xfer, wifi);
+        nlr_jump(nlr.ret_val);
+    }
+    _socket_xfer_end(&xfer, wifi);
+
+    if (res < 0) exception_from_errno(xfer.err);
+    return mp_obj_new_int(res);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(socket_recvinto_file_obj, 2, 3, socket_recvinto_file);
+
 //------------------------------------------------
 STATIC mp_obj_t socket_fileno(const mp_obj_t arg0)
 {
@@ -1353,6 +1578,8 @@ STATIC const mp_rom_map_elem_t socket_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_send),            MP_ROM_PTR(&socket_send_obj) },
     { MP_ROM_QSTR(MP_QSTR_sendall),         MP_ROM_PTR(&socket_sendall_obj) },
     { MP_ROM_QSTR(MP_QSTR_sendto),          MP_ROM_PTR(&socket_sendto_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sendfile),        MP_ROM_PTR(&socket_sendfile_obj) },
+    { MP_ROM_QSTR(MP_QSTR_recvinto_file),   MP_ROM_PTR(&socket_recvinto_file_obj) },
     { MP_ROM_QSTR(MP_QSTR_recv),            MP_ROM_PTR(&socket_recv_obj) },
     { MP_ROM_QSTR(MP_QSTR_recvfrom),        MP_ROM_PTR(&socket_recvfrom_obj) },
     { MP_ROM_QSTR(MP_QSTR_setsockopt),      MP_ROM_PTR(&socket_setsockopt_obj) },
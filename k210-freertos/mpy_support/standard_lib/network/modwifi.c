@@ -69,6 +69,7 @@ static uint64_t last_received_time = 0;
 static int timezone = 0;
 static uint32_t wifi_rx_count = 0;
 static uint32_t wifi_tx_count = 0;
+static bool wifi_first_rx = true;
 static bool wifi_tcpsend_wait_sent = true;
 
 static at_responses_t at_responses = { 0 };
@@ -294,6 +295,10 @@ static void _get_data_to_socket(char* data, size_t size, int link_id, int len, u
         }
     }
     else if (wifi_debug) LOGW(WIFI_TASK_TAG, "no open socket for link_id %d", link_id);
+    if ((sock) && (wifi_first_rx)) {
+        wifi_first_rx = false;
+        mp_hal_boot_trace_mark("wifi first rx");
+    }
 
     // === Get all data to socket buffer ===
     if (sock) {
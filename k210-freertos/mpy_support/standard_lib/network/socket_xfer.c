@@ -0,0 +1,215 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+#include <errno.h>
+
+#include "mpconfigport.h"
+#include "py/mpthread.h"
+#include "socket_xfer.h"
+
+//----------------------------------------------
+static void socket_xfer_task(void *pvParameters)
+{
+    socket_xfer_t *xfer = (socket_xfer_t *)pvParameters;
+    uint8_t idx = 0;
+
+    while (1) {
+        if (xQueueReceive(xfer->cmd_queue, &idx, portMAX_DELAY) != pdTRUE) continue;
+        if (idx == SOCKET_XFER_EXIT) break;
+
+        int res = xfer->net(xfer, idx);
+        if ((xfer->send) && (res >= 0) && (res != xfer->len[idx])) {
+            // the whole buffer must be sent
+            xfer->err = EIO;
+            res = -1;
+        }
+        xfer->result[idx] = res;
+        xQueueSend(xfer->res_queue, &idx, portMAX_DELAY);
+    }
+    xQueueSend(xfer->res_queue, &idx, portMAX_DELAY);
+    vTaskDelete(NULL);
+}
+
+// Pass the buffer to the transfer task
+//------------------------------------------------------------
+static void _socket_xfer_put(socket_xfer_t *xfer, uint8_t idx)
+{
+    xQueueSend(xfer->cmd_queue, &idx, portMAX_DELAY);
+    xfer->pending++;
+}
+
+// Wait until the transfer task finishes with the buffer
+//----------------------------------------------
+static int _socket_xfer_get(socket_xfer_t *xfer)
+{
+    uint8_t idx = 0;
+    MP_THREAD_GIL_EXIT();
+    xQueueReceive(xfer->res_queue, &idx, portMAX_DELAY);
+    MP_THREAD_GIL_ENTER();
+    xfer->pending--;
+    return idx;
+}
+
+// Set the error of the failed file operation,
+// the transfer task must not be using any buffer
+//--------------------------------------------------------------
+static int _socket_xfer_file_error(socket_xfer_t *xfer, int err)
+{
+    while (xfer->pending > 0) _socket_xfer_get(xfer);
+    xfer->err = (err) ? err : EIO;
+    return -1;
+}
+
+//---------------------------------------
+void socket_xfer_end(socket_xfer_t *xfer)
+{
+    if (xfer->task) {
+        while (xfer->pending > 0) _socket_xfer_get(xfer);
+        _socket_xfer_put(xfer, SOCKET_XFER_EXIT);
+        _socket_xfer_get(xfer);
+        xfer->task = NULL;
+    }
+    if (xfer->cmd_queue) vQueueDelete(xfer->cmd_queue);
+    if (xfer->res_queue) vQueueDelete(xfer->res_queue);
+    if (xfer->buf[0]) vPortFree(xfer->buf[0]);
+    if (xfer->buf[1]) vPortFree(xfer->buf[1]);
+    xfer->cmd_queue = NULL;
+    xfer->res_queue = NULL;
+    xfer->buf[0] = NULL;
+    xfer->buf[1] = NULL;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+bool socket_xfer_start(socket_xfer_t *xfer, void *sock, bool send, int bufsize, socket_xfer_net_t net, socket_xfer_poll_t poll)
+{
+    memset(xfer, 0, sizeof(socket_xfer_t));
+    xfer->sock = sock;
+    xfer->send = send;
+    xfer->bufsize = bufsize;
+    xfer->net = net;
+    xfer->poll = poll;
+
+    xfer->buf[0] = pvPortMalloc(xfer->bufsize);
+    xfer->buf[1] = pvPortMalloc(xfer->bufsize);
+    xfer->cmd_queue = xQueueCreate(2, sizeof(uint8_t));
+    xfer->res_queue = xQueueCreate(2, sizeof(uint8_t));
+    if ((xfer->buf[0] == NULL) || (xfer->buf[1] == NULL) || (xfer->cmd_queue == NULL) || (xfer->res_queue == NULL)) {
+        socket_xfer_end(xfer);
+        return false;
+    }
+
+    BaseType_t res = xTaskCreate(
+            socket_xfer_task,                       // function entry
+            "Socket_xfer",                          // task name
+            configMINIMAL_STACK_SIZE*2,             // stack_deepth
+            (void *)xfer,                           // function argument
+            MICROPY_TASK_PRIORITY,                  // task priority
+            &xfer->task);                           // task handle
+    if (res != pdPASS) {
+        xfer->task = NULL;
+        socket_xfer_end(xfer);
+        return false;
+    }
+    return true;
+}
+
+// Read the next block from the file into the buffer 'idx'
+//---------------------------------------------------------------------------------------------------------------
+static int _socket_xfer_read(socket_xfer_t *xfer, void *file, socket_xfer_file_t file_read, int idx, int *remain)
+{
+    int n = ((*remain < 0) || (*remain > xfer->bufsize)) ? xfer->bufsize : *remain;
+    if (n == 0) return 0;
+    n = file_read(file, xfer->buf[idx], n);
+    if (n < 0) return -1;
+    if (*remain > 0) *remain -= n;
+    return n;
+}
+
+//-------------------------------------------------------------------------------------------------
+int socket_xfer_send_file(socket_xfer_t *xfer, void *file, socket_xfer_file_t file_read, int count)
+{
+    int remain = count;
+    uint8_t idx = 0;
+    xfer->total = 0;
+    xfer->err = 0;
+
+    // Read the first block
+    int n = _socket_xfer_read(xfer, file, file_read, idx, &remain);
+    int rd_err = errno;
+    while (n > 0) {
+        xfer->len[idx] = n;
+        _socket_xfer_put(xfer, idx);
+
+        // read the next block while the previous one is being sent
+        idx ^= 1;
+        n = _socket_xfer_read(xfer, file, file_read, idx, &remain);
+        rd_err = errno;
+
+        int sent_idx = _socket_xfer_get(xfer);
+        if (xfer->result[sent_idx] < 0) return -1;
+        xfer->total += xfer->result[sent_idx];
+        if (xfer->poll) xfer->poll();
+    }
+    if (n < 0) return _socket_xfer_file_error(xfer, rd_err);
+    return xfer->total;
+}
+
+//--------------------------------------------------------------------------------------------------
+int socket_xfer_recv_file(socket_xfer_t *xfer, void *file, socket_xfer_file_t file_write, int count)
+{
+    int remain = count;
+    uint8_t idx = 0;
+    xfer->total = 0;
+    xfer->err = 0;
+
+    if (remain != 0) {
+        xfer->len[idx] = ((remain < 0) || (remain > xfer->bufsize)) ? xfer->bufsize : remain;
+        _socket_xfer_put(xfer, idx);
+    }
+    while (xfer->pending > 0) {
+        int rd_idx = _socket_xfer_get(xfer);
+        int n = xfer->result[rd_idx];
+        if (n < 0) return -1;
+        if (n == 0) break; // peer closed
+        if (remain > 0) remain -= n;
+
+        // receive the next block while the previous one is being written
+        if (remain != 0) {
+            idx = rd_idx ^ 1;
+            xfer->len[idx] = ((remain < 0) || (remain > xfer->bufsize)) ? xfer->bufsize : remain;
+            _socket_xfer_put(xfer, idx);
+        }
+        int wr = file_write(file, xfer->buf[rd_idx], n);
+        if (wr != n) {
+            // short write: the file system is full
+            return _socket_xfer_file_error(xfer, (wr < 0) ? errno : ENOSPC);
+        }
+        xfer->total += n;
+        if (xfer->poll) xfer->poll();
+    }
+    return xfer->total;
+}
@@ -0,0 +1,88 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Socket <-> file transfer
+ *
+ * The network side of the transfer is executed by the helper task,
+ * the MicroPython task reads (or writes) the file at the same time.
+ * Two buffers are used, while one is transferred over the network,
+ * the other one is being filled from (or written to) the file.
+ * The network and file operations are provided by the caller (modsocket.c).
+ */
+
+#ifndef _SOCKET_XFER_H_
+#define _SOCKET_XFER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+#define SOCKET_XFER_EXIT        0xFF
+
+typedef struct _socket_xfer_t socket_xfer_t;
+
+// Send or receive one buffer, runs in the transfer task
+// Returns the number of bytes transferred (0 if the peer closed) or -1 with 'xfer->err' set
+typedef int (*socket_xfer_net_t)(socket_xfer_t *xfer, int idx);
+// Read or write the file, returns the number of bytes or -1 with 'errno' set
+typedef int (*socket_xfer_file_t)(void *file, uint8_t *buf, int len);
+// Called in the MicroPython task after each transferred buffer, may not return (nlr_jump)
+typedef void (*socket_xfer_poll_t)(void);
+
+struct _socket_xfer_t {
+    void                *sock;
+    bool                send;
+    uint8_t             *buf[2];
+    int                 len[2];     // data length (send) or requested length (receive)
+    int                 result[2];  // number of bytes transferred or -1 on error
+    int                 err;        // errno of the failed transfer
+    int                 bufsize;
+    int                 pending;    // number of buffers passed to the task
+    int                 total;      // number of bytes transferred
+    socket_xfer_net_t   net;
+    socket_xfer_poll_t  poll;
+    QueueHandle_t       cmd_queue;
+    QueueHandle_t       res_queue;
+    TaskHandle_t        task;
+};
+
+// Allocate the buffers and start the transfer task, returns false on error
+bool socket_xfer_start(socket_xfer_t *xfer, void *sock, bool send, int bufsize, socket_xfer_net_t net, socket_xfer_poll_t poll);
+// Stop the transfer task and free all resources, can be called more than once
+void socket_xfer_end(socket_xfer_t *xfer);
+
+// Send 'count' bytes (until the file end if 'count' < 0) read from the file
+// Receive 'count' bytes (until the peer closes if 'count' < 0) and write them to the file
+// Both return the number of bytes transferred or -1 on any error, with 'xfer->err' set,
+// 'xfer->total' is the number of bytes transferred before the error.
+// A short file write is reported as ENOSPC, a short network send as EIO.
+int socket_xfer_send_file(socket_xfer_t *xfer, void *file, socket_xfer_file_t file_read, int count);
+int socket_xfer_recv_file(socket_xfer_t *xfer, void *file, socket_xfer_file_t file_write, int count);
+
+#endif
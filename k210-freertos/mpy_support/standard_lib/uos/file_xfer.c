@@ -0,0 +1,338 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "mphalport.h"
+#include "file_xfer.h"
+
+#define XFER_ACK            0x06
+#define XFER_ABORT          0x08
+#define XFER_ABORT_FILE     0x09
+#define XFER_ABORT_TIMEOUT  0x0A
+
+#define XFER_RX_BUF_SIZE    (2 * XFER_SLOT_SIZE)
+#define XFER_SLOT(x, n)     ((x)->slots + (((n) % (x)->window) * XFER_SLOT_SIZE))
+
+//-----------------------------------------------------
+static void xfer_send_ack(file_xfer_t *x, uint8_t type)
+{
+    uint8_t ack[XFER_ACK_SIZE];
+    uint32_t bitmap = (x->have >> 1) & 0xFFFF;
+    ack[0] = type;
+    ack[1] = x->next & 0xFF;
+    ack[2] = (x->next >> 8) & 0xFF;
+    ack[3] = bitmap & 0xFF;
+    ack[4] = bitmap >> 8;
+    uint16_t crc = mp_hal_crc16(ack, 5);
+    ack[5] = crc >> 8;
+    ack[6] = crc & 0xFF;
+    mp_hal_send_bytes((char *)ack, XFER_ACK_SIZE);
+    x->last_tx = mp_hal_ticks_ms();
+}
+
+// Build the data frame in 'frame', the data must already be at 'frame' + XFER_DATA_HDR_SIZE
+// Returns the frame size
+//---------------------------------------------------------------
+static int xfer_make_frame(uint8_t *frame, uint32_t seq, int len)
+{
+    frame[0] = XFER_DATA_MARK;
+    frame[1] = seq & 0xFF;
+    frame[2] = (seq >> 8) & 0xFF;
+    frame[3] = len & 0xFF;
+    frame[4] = (len >> 8) & 0xFF;
+    uint16_t crc = mp_hal_crc16(frame, XFER_DATA_HDR_SIZE + len);
+    frame[XFER_DATA_HDR_SIZE + len] = crc >> 8;
+    frame[XFER_DATA_HDR_SIZE + len + 1] = crc & 0xFF;
+    return len + XFER_DATA_OVERHEAD;
+}
+
+//----------------------------------------------------------------------
+static void xfer_send_slot(file_xfer_t *x, uint32_t block, uint64_t now)
+{
+    uint8_t *frame = XFER_SLOT(x, block);
+    int len = frame[3] | (frame[4] << 8);
+    mp_hal_send_bytes((char *)frame, len + XFER_DATA_OVERHEAD);
+    x->slot_time[block % x->window] = now;
+}
+
+// Get the received bytes into the parse buffer
+//----------------------------------------------------
+static int xfer_read(file_xfer_t *x, uint32_t timeout)
+{
+    int n = mp_hal_uarths_read_ring(&x->ring, x->rx + x->rx_len, XFER_RX_BUF_SIZE - x->rx_len, timeout);
+    x->rx_len += n;
+    return n;
+}
+
+//---------------------------------------------
+static void xfer_consume(file_xfer_t *x, int n)
+{
+    x->rx_len -= n;
+    if (x->rx_len > 0) memmove(x->rx, x->rx + n, x->rx_len);
+}
+
+// Receiver: parse the received data frames and store them into the window slots
+// Returns 1 if the acknowledge should be sent, 0 if nothing changed or negative error code
+//----------------------------------------
+static int xfer_parse_data(file_xfer_t *x)
+{
+    int res = 0;
+    while (x->rx_len > 0) {
+        if (x->rx[0] != XFER_DATA_MARK) {
+            // resynchronize
+            uint8_t *mark = memchr(x->rx, XFER_DATA_MARK, x->rx_len);
+            xfer_consume(x, (mark) ? (mark - x->rx) : x->rx_len);
+            continue;
+        }
+        if (x->rx_len < XFER_DATA_HDR_SIZE) break;
+        uint16_t seq = x->rx[1] | (x->rx[2] << 8);
+        int len = x->rx[3] | (x->rx[4] << 8);
+        if (len > XFER_BLOCK_SIZE) {
+            // not a frame header
+            xfer_consume(x, 1);
+            continue;
+        }
+        if (x->rx_len < (len + XFER_DATA_OVERHEAD)) break;
+        uint16_t crc = mp_hal_crc16(x->rx, XFER_DATA_HDR_SIZE + len);
+        if (crc != ((x->rx[XFER_DATA_HDR_SIZE + len] << 8) | x->rx[XFER_DATA_HDR_SIZE + len + 1])) {
+            // damaged frame or false header, the acknowledge shows the missing block
+            xfer_consume(x, 1);
+            res = 1;
+            continue;
+        }
+        x->last_rx = mp_hal_ticks_ms();
+        if (len == 0) return XFER_ERR_ABORT;
+
+        uint16_t delta = seq - (uint16_t)x->next;
+        if (delta < x->window) {
+            uint32_t block = x->next + delta;
+            int expected = (block == (x->nblocks - 1)) ? x->last_len : XFER_BLOCK_SIZE;
+            if ((block >= x->nblocks) || (len != expected)) return XFER_ERR_DATA;
+            if ((x->have & (1 << delta)) == 0) {
+                memcpy(XFER_SLOT(x, block), x->rx, len + XFER_DATA_OVERHEAD);
+                x->have |= 1 << delta;
+                // acknowledge the out of order block immediately, the sender retransmits the missing ones
+                if (delta > 0) res = 1;
+            }
+            else res = 1;
+        }
+        else res = 1; // already delivered, the acknowledge was lost
+        xfer_consume(x, len + XFER_DATA_OVERHEAD);
+    }
+    return res;
+}
+
+// Sender: parse the received acknowledge frames
+// Returns negative error code on abort
+//---------------------------------------
+static int xfer_parse_ack(file_xfer_t *x)
+{
+    uint64_t now = mp_hal_ticks_ms();
+    while (x->rx_len >= XFER_ACK_SIZE) {
+        uint8_t type = x->rx[0];
+        if (((type != XFER_ACK) && ((type < XFER_ABORT) || (type > XFER_ABORT_TIMEOUT))) ||
+            (mp_hal_crc16(x->rx, 5) != ((x->rx[5] << 8) | x->rx[6]))) {
+            xfer_consume(x, 1);
+            continue;
+        }
+        uint16_t next = x->rx[1] | (x->rx[2] << 8);
+        uint32_t bitmap = x->rx[3] | (x->rx[4] << 8);
+        xfer_consume(x, XFER_ACK_SIZE);
+        if (type != XFER_ACK) return XFER_ERR_ABORT;
+
+        uint16_t delta = next - (uint16_t)x->next;
+        if (delta > (x->head - x->next)) continue; // old acknowledge
+        x->next += delta;
+        x->last_rx = now;
+        if ((bitmap == 0) && ((delta > 0) || (x->next >= x->head))) continue;
+
+        // selective retransmission of the blocks missing before the last received one
+        // block 'next' is always missing, block 'next'+i is missing if bit i-1 is not set
+        // a missing block sent before the last received one was lost, unless already retransmitted
+        // an acknowledge without progress or bitmap reports a damaged frame, retransmit block 'next'
+        int top = 0;
+        while (bitmap >> (top + 1)) top++;
+        uint64_t top_time = 0;
+        if (bitmap) {
+            if ((x->next + top + 1) >= x->head) continue;
+            top_time = x->slot_time[(x->next + top + 1) % x->window];
+        }
+        for (int i = 0; i <= top; i++) {
+            uint32_t block = x->next + i;
+            if (block >= x->head) break;
+            if ((i > 0) && (bitmap & (1 << (i - 1)))) continue;
+            uint64_t sent = x->slot_time[block % x->window];
+            if ((bitmap) ? (sent > top_time) : ((now - sent) < (XFER_RETRY_MS / 4))) continue;
+            xfer_send_slot(x, block, now);
+        }
+    }
+    return 0;
+}
+
+//-------------------------------------------------------------------------
+int file_xfer_start(file_xfer_t *x, bool sender, uint32_t size, int window)
+{
+    memset(x, 0, sizeof(file_xfer_t));
+    if (window < 1) window = 1;
+    if (window > XFER_WINDOW_MAX) window = XFER_WINDOW_MAX;
+    x->window = window;
+    x->sender = sender;
+    x->nblocks = (size + XFER_BLOCK_SIZE - 1) / XFER_BLOCK_SIZE;
+    x->last_len = size - ((x->nblocks - 1) * XFER_BLOCK_SIZE);
+
+    // the receiver's ring buffer must hold the full window while the blocks are written to file
+    int ring_size = (sender) ? 1024 : (window * XFER_SLOT_SIZE) + 1024;
+    x->ring.buf = pvPortMalloc(ring_size);
+    x->ring.size = ring_size;
+    x->rx = pvPortMalloc(XFER_RX_BUF_SIZE);
+    x->slots = pvPortMalloc(window * XFER_SLOT_SIZE);
+    x->slot_time = pvPortMalloc(window * sizeof(uint64_t));
+    if ((!x->ring.buf) || (!x->rx) || (!x->slots) || (!x->slot_time)) {
+        file_xfer_end(x, 0);
+        return XFER_ERR_MEMORY;
+    }
+
+    mp_hal_uarths_setirq_ring(&x->ring);
+
+    uint8_t start[11] = { BLOCK_CTRL_READY, 'W', window, XFER_BLOCK_SIZE & 0xFF, XFER_BLOCK_SIZE >> 8 };
+    int start_len = 5;
+    if (sender) {
+        start[5] = size & 0xFF;
+        start[6] = (size >> 8) & 0xFF;
+        start[7] = (size >> 16) & 0xFF;
+        start[8] = (size >> 24) & 0xFF;
+        uint16_t crc = mp_hal_crc16(start, 9);
+        start[9] = crc >> 8;
+        start[10] = crc & 0xFF;
+        start_len = 11;
+    }
+    mp_hal_send_bytes((char *)start, start_len);
+    x->last_rx = x->last_tx = mp_hal_ticks_ms();
+    return 0;
+}
+
+//------------------------------------------------------
+int file_xfer_recv(file_xfer_t *x, const uint8_t **data)
+{
+    if (x->delivered) {
+        // the previous block is processed, free its slot
+        x->delivered = false;
+        x->have >>= 1;
+        x->next++;
+        xfer_send_ack(x, XFER_ACK);
+    }
+    if (x->next >= x->nblocks) {
+        // the last acknowledge may be lost, repeat it while the retransmissions arrive
+        while (xfer_read(x, 100) > 0) {
+            x->rx_len = 0;
+            xfer_send_ack(x, XFER_ACK);
+        }
+        return 0;
+    }
+
+    while ((x->have & 1) == 0) {
+        xfer_read(x, 50);
+        int res = xfer_parse_data(x);
+        if (res < 0) return res;
+        uint64_t now = mp_hal_ticks_ms();
+        if ((res > 0) || (((now - x->last_rx) >= XFER_RETRY_MS) && ((now - x->last_tx) >= XFER_RETRY_MS))) {
+            xfer_send_ack(x, XFER_ACK);
+        }
+        if ((now - x->last_rx) >= XFER_TIMEOUT_MS) return XFER_ERR_TIMEOUT;
+    }
+
+    *data = XFER_SLOT(x, x->next) + XFER_DATA_HDR_SIZE;
+    x->delivered = true;
+    return (x->next == (x->nblocks - 1)) ? x->last_len : XFER_BLOCK_SIZE;
+}
+
+// Process the acknowledges, retransmit the oldest block if no acknowledge arrives
+//--------------------------------------------------------
+static int xfer_wait_ack(file_xfer_t *x, uint32_t timeout)
+{
+    xfer_read(x, timeout);
+    int res = xfer_parse_ack(x);
+    if (res < 0) return res;
+    uint64_t now = mp_hal_ticks_ms();
+    if ((x->next < x->head) && ((now - x->last_rx) >= XFER_RETRY_MS) && ((now - x->last_tx) >= XFER_RETRY_MS)) {
+        xfer_send_slot(x, x->next, now);
+        x->last_tx = now;
+    }
+    if ((x->next < x->head) && ((now - x->last_rx) >= XFER_TIMEOUT_MS)) return XFER_ERR_TIMEOUT;
+    return 0;
+}
+
+//--------------------------------------------------------------
+int file_xfer_send(file_xfer_t *x, const uint8_t *data, int len)
+{
+    if ((len < 1) || (len > XFER_BLOCK_SIZE) || (x->head >= x->nblocks)) return XFER_ERR_DATA;
+    while ((x->head - x->next) >= x->window) {
+        int res = xfer_wait_ack(x, 50);
+        if (res < 0) return res;
+    }
+    uint64_t now = mp_hal_ticks_ms();
+    // the acknowledge timeout starts with the first block sent
+    if (x->head == x->next) x->last_rx = now;
+    uint8_t *frame = XFER_SLOT(x, x->head);
+    memcpy(frame + XFER_DATA_HDR_SIZE, data, len);
+    xfer_make_frame(frame, x->head, len);
+    xfer_send_slot(x, x->head, now);
+    x->head++;
+    // process the acknowledges received so far
+    return xfer_wait_ack(x, 0);
+}
+
+//---------------------------------
+int file_xfer_flush(file_xfer_t *x)
+{
+    while (x->next < x->head) {
+        int res = xfer_wait_ack(x, 50);
+        if (res < 0) return res;
+    }
+    return 0;
+}
+
+//-----------------------------------------
+void file_xfer_end(file_xfer_t *x, int err)
+{
+    if (x->ring.buf) {
+        if (err) {
+            if (x->sender) {
+                uint8_t frame[XFER_DATA_OVERHEAD];
+                mp_hal_send_bytes((char *)frame, xfer_make_frame(frame, 0, 0));
+            }
+            else xfer_send_ack(x, (err == XFER_ERR_FILE) ? XFER_ABORT_FILE : ((err == XFER_ERR_TIMEOUT) ? XFER_ABORT_TIMEOUT : XFER_ABORT));
+        }
+        mp_hal_uarths_setirq_default();
+        vPortFree(x->ring.buf);
+    }
+    if (x->rx) vPortFree(x->rx);
+    if (x->slots) vPortFree(x->slots);
+    if (x->slot_time) vPortFree(x->slot_time);
+    memset(x, 0, sizeof(file_xfer_t));
+}
@@ -0,0 +1,109 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Windowed file transfer over the REPL UART
+ *
+ * Used by os.get_file() and os.send_file() when the window size is given
+ * The sender may have up to 'window' blocks not yet acknowledged, the lost or damaged
+ * blocks are selectively retransmitted.
+ * The received data are collected from the UART interrupt handler into the ring buffer,
+ * so the receiving continues while the received blocks are written to the file system.
+ *
+ * Start, sent by the device after the command was received:
+ *   0x06 'W' window block_size(2)                            os.get_file()
+ *   0x06 'W' window block_size(2) file_size(4) crc16(2)      os.send_file()
+ *
+ * Data frame, sender -> receiver:
+ *   0xA5 seq(2) len(2) data[len] crc16(2)
+ *   'seq' is the block number (modulo 65536), all blocks except the last one have 'block_size' bytes
+ *   the frame with len=0 aborts the transfer
+ *
+ * Acknowledge frame, receiver -> sender:
+ *   type next(2) bitmap(2) crc16(2)
+ *   type: 0x06 acknowledge, 0x08 abort, 0x09 abort on file error, 0x0A abort on timeout
+ *   'next' is the first block not yet received and stored, all previous blocks are acknowledged
+ *   bit 'n' of 'bitmap' is set if the block 'next'+1+n is already received
+ *
+ * Multi-byte values are little endian, crc16 (big endian) is calculated over all frame bytes before it
+ */
+
+#ifndef _FILE_XFER_H_
+#define _FILE_XFER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "py/ringbuf.h"
+
+#define XFER_BLOCK_SIZE         2048
+#define XFER_WINDOW_MAX         16
+#define XFER_DATA_MARK          0xA5
+#define XFER_DATA_HDR_SIZE      5
+#define XFER_DATA_OVERHEAD      (XFER_DATA_HDR_SIZE + 2)
+#define XFER_SLOT_SIZE          (XFER_BLOCK_SIZE + XFER_DATA_OVERHEAD)
+#define XFER_ACK_SIZE           7
+#define XFER_RETRY_MS           1000    // repeat the acknowledge or the oldest block if nothing was received
+#define XFER_MAX_FILE_SIZE      (16 * 1024 * 1024)
+#define XFER_TIMEOUT_MS         5000    // abort if nothing was received
+
+#define XFER_ERR_ABORT          -1      // aborted by the other side
+#define XFER_ERR_TIMEOUT        -2
+#define XFER_ERR_MEMORY         -3
+#define XFER_ERR_DATA           -4      // wrong or too much data
+#define XFER_ERR_FILE           -5      // file read or write error
+
+typedef struct _file_xfer_t {
+    ringbuf_t   ring;           // UART receive buffer, filled from the interrupt handler
+    uint8_t     *rx;            // frame parse buffer
+    int         rx_len;
+    uint8_t     *slots;         // window blocks, stored as complete data frames
+    uint64_t    *slot_time;     // sender: time the block was last sent
+    uint32_t    have;           // receiver: bit 'n' set if the block 'next'+n is received
+    uint32_t    next;           // first block not delivered (receiver) or not acknowledged (sender)
+    uint32_t    head;           // sender: number of blocks sent
+    uint32_t    nblocks;
+    int         last_len;       // size of the last block
+    int         window;
+    bool        delivered;      // receiver: block 'next' was returned to the caller
+    bool        sender;
+    uint64_t    last_rx;        // time of the last valid frame received
+    uint64_t    last_tx;        // time of the last acknowledge (receiver) or retransmission (sender)
+} file_xfer_t;
+
+// Allocate the buffers, start receiving from UART and send the start sequence
+// 'size' is the number of bytes to be transferred
+int file_xfer_start(file_xfer_t *x, bool sender, uint32_t size, int window);
+// Receiver: get the next block, the block is valid until the next call
+// returns the block length, 0 if all blocks were received or negative error code
+int file_xfer_recv(file_xfer_t *x, const uint8_t **data);
+// Sender: send the next block, waits if the window is full
+int file_xfer_send(file_xfer_t *x, const uint8_t *data, int len);
+// Sender: wait until all blocks are acknowledged
+int file_xfer_flush(file_xfer_t *x);
+// Abort the transfer if 'err' is set, free the buffers and restore the UART
+void file_xfer_end(file_xfer_t *x, int err);
+
+#endif
@@ -43,6 +43,7 @@
 #include "mphalport.h"
 #include "modmachine.h"
 #include "littleflash.h"
+#include "flashlock.h"
 
 #define LITTLEFS_MUTEX_TIMEOUT  (600 / portTICK_PERIOD_MS)
 
@@ -70,7 +71,7 @@ void *vfs_flashfs = &littlefs_user_mount_handle;
 static char littlefs_current_dir[LITTLEFS_CFG_MAX_NAME_LEN-8] = {'\0'};
 static char littlefs_file_path[LITTLEFS_CFG_MAX_NAME_LEN] = {'\0'};
 
-static SemaphoreHandle_t littlefs_mutex = NULL; // FS lock
+static SemaphoreHandle_t littlefs_mutex = NULL; // FS lock, always taken before the XIP lock
 
 static uint8_t read_buffer[LITTLEFS_CFG_SECTOR_SIZE] __attribute__((aligned (8)));
 static uint8_t prog_buffer[LITTLEFS_CFG_SECTOR_SIZE] __attribute__((aligned (8)));
@@ -84,7 +85,7 @@ static uint8_t lookahead_buffer[LITTLEFS_CFG_LOOKAHEAD_SIZE] __attribute__((alig
 static int internal_read(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size)
 {
     uint32_t phy_addr = LITTLEFS_CFG_START_ADDR + (block * LITTLEFS_CFG_SECTOR_SIZE) + off;
-    if (xSemaphoreTake(littlefs_mutex, LITTLEFS_MUTEX_TIMEOUT) != pdTRUE) {
+    if (!flashlock_take(littlefs_mutex, LITTLEFS_MUTEX_TIMEOUT)) {
         if (w25qxx_debug) LOGE(TAG, "[READ] Mutex timeout: bkl=%u, off=%u, sz=%u, adr=0x%x", block, off, size, phy_addr);
         return LFS_ERR_IO;
     }
@@ -104,7 +105,7 @@ static int internal_read(const struct lfs_config *c, lfs_block_t block, lfs_off_
 static int internal_prog(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size)
 {
     uint32_t phy_addr = LITTLEFS_CFG_START_ADDR + (block * LITTLEFS_CFG_SECTOR_SIZE) + off;
-    if (xSemaphoreTake(littlefs_mutex, LITTLEFS_MUTEX_TIMEOUT) != pdTRUE) {
+    if (!flashlock_take(littlefs_mutex, LITTLEFS_MUTEX_TIMEOUT)) {
         if (w25qxx_debug) LOGE(TAG, "[PROG] Mutex timeout: bkl=%u, off=%u, sz=%u, adr=0x%x", block, off, size, phy_addr);
         return LFS_ERR_IO;
     }
@@ -129,7 +130,7 @@ static int internal_prog(const struct lfs_config *c, lfs_block_t block, lfs_off_
 static int internal_erase(const struct lfs_config *c, lfs_block_t block)
 {
     uint32_t phy_addr = LITTLEFS_CFG_START_ADDR + (block * w25qxx_FLASH_SECTOR_SIZE);
-    if (xSemaphoreTake(littlefs_mutex, LITTLEFS_MUTEX_TIMEOUT) != pdTRUE) {
+    if (!flashlock_take(littlefs_mutex, LITTLEFS_MUTEX_TIMEOUT)) {
         //if (w25qxx_debug) LOGE(TAG, "[ERASE] Mutex timeout: bkl=%u, adr=0x%x", block, phy_addr);
         return LFS_ERR_IO;
     }
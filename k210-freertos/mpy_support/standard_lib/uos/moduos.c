@@ -52,6 +52,10 @@
 #include "vfs_sdcard.h"
 #endif
 #include "mphalport.h"
+#include "file_xfer.h"
+#if MICROPY_PY_UZLIB
+#include "extmod/uzlib/uzlib.h"
+#endif
 
 
 STATIC const qstr os_uname_info_fields[] = {
@@ -200,25 +204,146 @@ STATIC mp_obj_t os_checkfile(mp_obj_t fname_in)
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(os_checkfile_obj, os_checkfile);
 
+#if MICROPY_PY_UZLIB
+typedef struct _getfile_inflate_t {
+    TINF_DATA decomp;
+    file_xfer_t *xfer;
+    int err;
+} getfile_inflate_t;
+
+// Get the next compressed block from the transfer
+//---------------------------------------------
+STATIC int getfile_read_source(TINF_DATA *data)
+{
+    getfile_inflate_t *inf = (getfile_inflate_t *)data;
+    const uint8_t *block;
+    int len = file_xfer_recv(inf->xfer, &block);
+    if (len <= 0) {
+        // transfer error or the compressed stream is longer than the transferred data
+        inf->err = (len < 0) ? len : XFER_ERR_DATA;
+        return -1;
+    }
+    data->source = block + 1;
+    data->source_limit = block + len;
+    return block[0];
+}
+#endif
+
+// Receive the file using the windowed transfer
+// If 'zsize' > 0, 'zsize' bytes of raw deflate stream are received and decompressed
+//------------------------------------------------------------------------
+STATIC int getfile_windowed(mp_obj_t ffd, int size, int window, int zsize)
+{
+    file_xfer_t xfer;
+    const uint8_t *block;
+    int len, res = 0, total = 0;
+
+    #if MICROPY_PY_UZLIB
+    getfile_inflate_t *inf = NULL;
+    uint8_t *dict = NULL, *outbuf = NULL;
+    if (zsize > 0) {
+        inf = pvPortMalloc(sizeof(getfile_inflate_t));
+        dict = pvPortMalloc(32768);
+        outbuf = pvPortMalloc(XFER_BLOCK_SIZE);
+        if ((!inf) || (!dict) || (!outbuf)) {
+            res = -3;
+            goto exit;
+        }
+    }
+    #else
+    if (zsize > 0) return -7;
+    #endif
+
+    res = file_xfer_start(&xfer, false, (zsize > 0) ? zsize : size, window);
+    if (res < 0) {
+        res = -3;
+        goto exit;
+    }
+
+    if (zsize == 0) {
+        // write the blocks as they arrive, the next ones are received meanwhile
+        while ((len = file_xfer_recv(&xfer, &block)) > 0) {
+            if (mp_stream_posix_write((void *)ffd, block, len) != len) {
+                len = XFER_ERR_FILE;
+                break;
+            }
+            total += len;
+        }
+        res = len;
+    }
+    #if MICROPY_PY_UZLIB
+    else {
+        memset(inf, 0, sizeof(getfile_inflate_t));
+        inf->xfer = &xfer;
+        inf->decomp.source_read_cb = getfile_read_source;
+        uzlib_uncompress_init(&inf->decomp, dict, 32768);
+        while (1) {
+            inf->decomp.dest = outbuf;
+            inf->decomp.dest_limit = outbuf + XFER_BLOCK_SIZE;
+            int st = uzlib_uncompress(&inf->decomp);
+            len = inf->decomp.dest - outbuf;
+            if ((len > 0) && (mp_stream_posix_write((void *)ffd, outbuf, len) != len)) {
+                res = XFER_ERR_FILE;
+                break;
+            }
+            total += len;
+            if ((st < 0) || inf->err) {
+                res = (inf->err) ? inf->err : XFER_ERR_DATA;
+                break;
+            }
+            if (st == TINF_DONE) {
+                // acknowledge the last block
+                res = file_xfer_recv(&xfer, &block);
+                if (res > 0) res = XFER_ERR_DATA;
+                break;
+            }
+        }
+    }
+    #endif
+    if ((res == 0) && (total != size)) res = XFER_ERR_DATA;
+    file_xfer_end(&xfer, res);
+    if (res == XFER_ERR_FILE) res = -6;
+    else if (res == XFER_ERR_DATA) res = -7;
+    else if (res < 0) res = -5;
+
+exit:
+    #if MICROPY_PY_UZLIB
+    if (inf) vPortFree(inf);
+    if (dict) vPortFree(dict);
+    if (outbuf) vPortFree(outbuf);
+    #endif
+    return res;
+}
+
+// get_file(fname, size [, window, zsize])
+// If 'window' is given, the windowed transfer is used
 //-------------------------------------------------------------
-STATIC mp_obj_t os_getfile(mp_obj_t fname_in, mp_obj_t size_in)
+STATIC mp_obj_t os_getfile(size_t n_args, const mp_obj_t *args)
 {
     int res = 0, remain, blk_size;
-    int size = mp_obj_get_int(size_in);
-    if ((size < 1) || (size > 1000000)) {
+    int size = mp_obj_get_int(args[1]);
+    int window = (n_args > 2) ? mp_obj_get_int(args[2]) : 0;
+    int zsize = (n_args > 3) ? mp_obj_get_int(args[3]) : 0;
+    if ((size < 1) || (size > ((window > 0) ? XFER_MAX_FILE_SIZE : 1000000)) || (zsize < 0)) {
         // wrong file size
         return mp_obj_new_int(-3);
     }
 
-    mp_obj_t args[2];
-    args[0] = fname_in;
-    args[1] = mp_obj_new_str("wb", 2);
+    mp_obj_t fargs[2];
+    fargs[0] = args[0];
+    fargs[1] = mp_obj_new_str("wb", 2);
     // Open the file for writing
-    mp_obj_t ffd = mp_vfs_open(2, args, (mp_map_t*)&mp_const_empty_map);
+    mp_obj_t ffd = mp_vfs_open(2, fargs, (mp_map_t*)&mp_const_empty_map);
     if (!ffd) {
         return mp_obj_new_int(-4);
     }
 
+    if (window > 0) {
+        res = getfile_windowed(ffd, size, window, zsize);
+        mp_stream_close(ffd);
+        return (res < 0) ? mp_obj_new_int(res) : mp_const_true;
+    }
+
     bool do_write = true;
     uint8_t buf[1028];
     mp_obj_t fres = mp_const_true;
@@ -249,24 +374,58 @@ STATIC mp_obj_t os_getfile(mp_obj_t fname_in, mp_obj_t size_in)
 
     return fres;
 }
-STATIC MP_DEFINE_CONST_FUN_OBJ_2(os_getfile_obj, os_getfile);
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(os_getfile_obj, 2, 4, os_getfile);
 
+// Send the file using the windowed transfer
 //--------------------------------------------------------------
-STATIC mp_obj_t os_sendfile(mp_obj_t fname_in, mp_obj_t size_in)
+STATIC int sendfile_windowed(mp_obj_t ffd, int size, int window)
 {
-    mp_obj_t args[2];
-    args[0] = fname_in;
-    args[1] = mp_obj_new_str("rb", 2);
+    file_xfer_t xfer;
+    uint8_t *buf = pvPortMalloc(XFER_BLOCK_SIZE);
+    if (buf == NULL) return -3;
+
+    int res = file_xfer_start(&xfer, true, size, window);
+    if (res < 0) {
+        vPortFree(buf);
+        return -3;
+    }
+    int remain = size;
+    while (remain > 0) {
+        int blk_size = (remain > XFER_BLOCK_SIZE) ? XFER_BLOCK_SIZE : remain;
+        if (mp_stream_posix_read((void *)ffd, buf, blk_size) != blk_size) {
+            res = XFER_ERR_FILE;
+            break;
+        }
+        res = file_xfer_send(&xfer, buf, blk_size);
+        if (res < 0) break;
+        remain -= blk_size;
+    }
+    if (res == 0) res = file_xfer_flush(&xfer);
+    file_xfer_end(&xfer, res);
+    vPortFree(buf);
+    if (res == XFER_ERR_FILE) return -4;
+    return (res < 0) ? -5 : 0;
+}
+
+// send_file(fname, size [, window])
+// If 'window' is given, the windowed transfer is used
+//--------------------------------------------------------------
+STATIC mp_obj_t os_sendfile(size_t n_args, const mp_obj_t *args)
+{
+    mp_obj_t fargs[2];
+    fargs[0] = args[0];
+    fargs[1] = mp_obj_new_str("rb", 2);
     uint8_t buf[1028];
     int res = 0, remain, blk_size;
-    int size = mp_obj_get_int(size_in);
-    if ((size < 0) || (size > 1000000)) {
+    int size = mp_obj_get_int(args[1]);
+    int window = (n_args > 2) ? mp_obj_get_int(args[2]) : 0;
+    if ((size < 0) || (size > ((window > 0) ? XFER_MAX_FILE_SIZE : 1000000))) {
         // wrong file size
         return mp_obj_new_int(-4);
     }
 
     // Open the file
-    mp_obj_t ffd = mp_vfs_open(2, args, (mp_map_t*)&mp_const_empty_map);
+    mp_obj_t ffd = mp_vfs_open(2, fargs, (mp_map_t*)&mp_const_empty_map);
     if (ffd) {
         // Get file size
         int fsize = mp_stream_posix_lseek((void *)ffd, 0, SEEK_END);
@@ -278,6 +437,11 @@ STATIC mp_obj_t os_sendfile(mp_obj_t fname_in, mp_obj_t size_in)
         }
 
         if ((fsize > 0) && (at_start == 0) && (fsize == size)) {
+            if (window > 0) {
+                res = sendfile_windowed(ffd, size, window);
+                mp_stream_close(ffd);
+                return (res < 0) ? mp_obj_new_int(res) : mp_const_true;
+            }
             remain = size;
             // send all file blocks
             while (remain > 0) {
@@ -311,7 +475,7 @@ STATIC mp_obj_t os_sendfile(mp_obj_t fname_in, mp_obj_t size_in)
     if (res != 0) return mp_obj_new_int(res);
     return mp_const_true;
 }
-STATIC MP_DEFINE_CONST_FUN_OBJ_2(os_sendfile_obj, os_sendfile);
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(os_sendfile_obj, 2, 3, os_sendfile);
 
 //--------------------------------------------------------------------
 STATIC mp_obj_t os_list_dir_files(size_t n_args, const mp_obj_t *args)
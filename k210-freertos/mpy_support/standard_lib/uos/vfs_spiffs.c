@@ -45,6 +45,7 @@
 #include "vfs_spiffs.h"
 #include "spiffs_config.h"
 #include "w25qxx.h"
+#include "flashlock.h"
 
 int spiffs_dbg_level = 0;
 bool force_erase_fs_flash = false;
@@ -111,7 +112,7 @@ static void mp_spiffs_check_cb(spiffs_check_type type, spiffs_check_report repor
 //------------------------------
 void spiffs_api_lock(spiffs *fs)
 {
-    xSemaphoreTake(spiffs_lock, portMAX_DELAY);
+    flashlock_take(spiffs_lock, portMAX_DELAY);
 }
 
 //--------------------------------
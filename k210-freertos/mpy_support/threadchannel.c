@@ -0,0 +1,134 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "threadchannel.h"
+
+// The producer reserves the space in the ring buffer, writes the data directly into it
+// and commits the written size. The consumer gets the pointer to the committed data
+// and releases it when it is not needed anymore.
+// Each message is preceded by 8-byte header (data length & flag). If the message does not fit
+// at the end of the ring buffer, the wrap header is written and the message is placed at the buffer start.
+
+#define CHANNEL_ALIGN(len)  (((len) + 7) & ~7)
+
+// Returns the number of free bytes in the channel's ring buffer
+//---------------------------------------------------
+uint32_t mp_thread_channel_free(thread_channel_t *ch)
+{
+    return ch->size - (ch->wr_idx - ch->rd_idx);
+}
+
+// Reserve the space for 'len' bytes in the ring buffer
+// Returns the pointer to the reserved space or NULL if no space is available
+//--------------------------------------------------------------------
+uint8_t *mp_thread_channel_reserve(thread_channel_t *ch, uint32_t len)
+{
+    if ((ch->buf == NULL) || (ch->reserved) || (len == 0)) return NULL;
+
+    uint32_t need = THREAD_CHANNEL_HDR_SIZE + CHANNEL_ALIGN(len);
+    if (need > ch->size) return NULL;
+
+    uint32_t wr = ch->wr_idx;
+    uint32_t pos = wr & (ch->size - 1);
+    uint32_t pad = 0;
+    // The message is always stored contiguously, skip the buffer end if needed
+    if ((ch->size - pos) < need) pad = ch->size - pos;
+    if (mp_thread_channel_free(ch) < (need + pad)) return NULL;
+
+    ch->reserved = len;
+    ch->reserved_pad = pad;
+    return ch->buf + ((pos + pad) & (ch->size - 1)) + THREAD_CHANNEL_HDR_SIZE;
+}
+
+// Commit 'len' bytes written to the reserved space, 'len' can be less than the reserved size
+//--------------------------------------------------------------
+int mp_thread_channel_commit(thread_channel_t *ch, uint32_t len)
+{
+    if ((ch->reserved == 0) || (len > ch->reserved)) return 0;
+
+    uint32_t wr = ch->wr_idx;
+    uint32_t pos = wr & (ch->size - 1);
+    uint32_t *hdr;
+    if (ch->reserved_pad) {
+        hdr = (uint32_t *)(ch->buf + pos);
+        hdr[0] = 0;
+        hdr[1] = THREAD_CHANNEL_FLAG_WRAP;
+        pos = 0;
+    }
+    hdr = (uint32_t *)(ch->buf + pos);
+    hdr[0] = len;
+    hdr[1] = 0;
+
+    // make sure the data are written before the index is updated
+    __sync_synchronize();
+    ch->wr_idx = wr + ch->reserved_pad + THREAD_CHANNEL_HDR_SIZE + CHANNEL_ALIGN(len);
+    ch->n_commit++;
+
+    ch->reserved = 0;
+    ch->reserved_pad = 0;
+    return 1;
+}
+
+// Get the pointer to the next committed message, NULL if no message is available
+//---------------------------------------------------------------------
+uint8_t *mp_thread_channel_receive(thread_channel_t *ch, uint32_t *len)
+{
+    if ((ch->buf == NULL) || (ch->received)) return NULL;
+
+    while (1) {
+        uint32_t rd = ch->rd_idx;
+        if (rd == ch->wr_idx) return NULL;
+        // make sure the data are read after the index
+        __sync_synchronize();
+
+        uint32_t pos = rd & (ch->size - 1);
+        uint32_t *hdr = (uint32_t *)(ch->buf + pos);
+        if (hdr[1] == THREAD_CHANNEL_FLAG_WRAP) {
+            // skip to the buffer start
+            ch->rd_idx = rd + (ch->size - pos);
+            continue;
+        }
+        *len = hdr[0];
+        ch->received = THREAD_CHANNEL_HDR_SIZE + CHANNEL_ALIGN(hdr[0]);
+        return ch->buf + pos + THREAD_CHANNEL_HDR_SIZE;
+    }
+}
+
+// Release the last received message, its space can be reused by the producer
+//-------------------------------------------------
+int mp_thread_channel_release(thread_channel_t *ch)
+{
+    if (ch->received == 0) return 0;
+
+    // make sure all data reads are finished before the space is given back
+    __sync_synchronize();
+    ch->rd_idx += ch->received;
+    ch->n_release++;
+    ch->received = 0;
+    return 1;
+}
@@ -0,0 +1,65 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MICROPY_INCLUDED_THREADCHANNEL_H__
+#define __MICROPY_INCLUDED_THREADCHANNEL_H__
+
+#include <stdint.h>
+
+#define THREAD_MAX_CHANNELS                 4
+#define THREAD_CHANNEL_MIN_SIZE             256
+#define THREAD_CHANNEL_MAX_SIZE             (1024*1024)
+#define THREAD_CHANNEL_HDR_SIZE             8
+#define THREAD_CHANNEL_FLAG_WRAP            0x57524150
+
+// Single producer/single consumer ring buffer used for data exchange between
+// the two MicroPython instances (or threads) without copying the data.
+// Both the structure and the ring buffer are allocated outside of MicroPython heaps.
+// 'wr_idx' is only modified by the producer, 'rd_idx' only by the consumer,
+// both are free running counters, the buffer size is always a power of 2
+typedef struct _thread_channel_t {
+    volatile uint32_t wr_idx;       // committed write position
+    volatile uint32_t rd_idx;       // released read position
+    volatile uint32_t n_commit;     // number of committed messages
+    volatile uint32_t n_release;    // number of released messages
+    uint32_t size;                  // ring buffer size in bytes
+    uint32_t reserved;              // size of the currently reserved block (0 if none)
+    uint32_t reserved_pad;          // bytes skipped at the end of the buffer by the current reservation
+    uint32_t received;              // size of the currently received block (0 if none)
+    uint16_t id;                    // channel id used to open the channel from both sides
+    uint8_t  nopen;                 // number of open channel objects
+    uint8_t  *buf;                  // ring buffer
+} __attribute__((aligned(8))) thread_channel_t;
+
+// The ring buffer operations don't depend on the RTOS,
+// opening and closing the channel is done in mpthreadport.c
+uint8_t *mp_thread_channel_reserve(thread_channel_t *ch, uint32_t len);
+int mp_thread_channel_commit(thread_channel_t *ch, uint32_t len);
+uint8_t *mp_thread_channel_receive(thread_channel_t *ch, uint32_t *len);
+int mp_thread_channel_release(thread_channel_t *ch);
+uint32_t mp_thread_channel_free(thread_channel_t *ch);
+
+#endif
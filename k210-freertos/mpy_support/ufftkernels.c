@@ -0,0 +1,149 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <math.h>
+#include "ufftkernels.h"
+
+// Hardware expects the imaginary part at the lower address
+//-----------------------------------------------
+void ufft_swap_ri(uint32_t *data, size_t points)
+{
+    for (size_t i=0; i<points; i++) {
+        data[i] = (data[i] << 16) | (data[i] >> 16);
+    }
+}
+
+// Radix-2 decimation in time, Q15 twiddle factors,
+// the intermediate result is divided by 2 after the stages selected by 'shift' mask
+//------------------------------------------------------------------------------------
+void ufft_sw_fft(const int16_t *in, int16_t *out, int points, int shift, bool inverse)
+{
+    int stages = 0;
+    while ((1 << stages) < points) stages++;
+
+    // bit reversed copy to the output buffer
+    if (in == out) {
+        for (int i=0, j=0; i<points; i++) {
+            if (i < j) {
+                int16_t tr = out[i*2], ti = out[i*2+1];
+                out[i*2] = out[j*2]; out[i*2+1] = out[j*2+1];
+                out[j*2] = tr; out[j*2+1] = ti;
+            }
+            int bit = points >> 1;
+            while (j & bit) { j ^= bit; bit >>= 1; }
+            j |= bit;
+        }
+    }
+    else {
+        for (int i=0, j=0; i<points; i++) {
+            out[j*2] = in[i*2]; out[j*2+1] = in[i*2+1];
+            int bit = points >> 1;
+            while (j & bit) { j ^= bit; bit >>= 1; }
+            j |= bit;
+        }
+    }
+
+    for (int s=0; s<stages; s++) {
+        int half = 1 << s;
+        int step = points >> (s + 1);
+        int sh = (shift >> s) & 1;
+        for (int k=0; k<half; k++) {
+            float angle = -2.0f * (float)M_PI * (float)(k * step) / (float)points;
+            if (inverse) angle = -angle;
+            int32_t wr = (int32_t)lroundf(cosf(angle) * 32767.0f);
+            int32_t wi = (int32_t)lroundf(sinf(angle) * 32767.0f);
+            for (int i=k; i<points; i+=(half << 1)) {
+                int16_t *a = out + (i * 2);
+                int16_t *b = out + ((i + half) * 2);
+                int32_t tr = ((b[0] * wr) - (b[1] * wi)) >> 15;
+                int32_t ti = ((b[0] * wi) + (b[1] * wr)) >> 15;
+                int32_t ar = (a[0] + tr) >> sh, ai = (a[1] + ti) >> sh;
+                int32_t br = (a[0] - tr) >> sh, bi = (a[1] - ti) >> sh;
+                a[0] = (ar > 32767) ? 32767 : (ar < -32768) ? -32768 : ar;
+                a[1] = (ai > 32767) ? 32767 : (ai < -32768) ? -32768 : ai;
+                b[0] = (br > 32767) ? 32767 : (br < -32768) ? -32768 : br;
+                b[1] = (bi > 32767) ? 32767 : (bi < -32768) ? -32768 : bi;
+            }
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+void ufft_calc_magnitude(const int16_t *in, uint16_t *out, size_t points)
+{
+    for (size_t i=0; i<points; i++) {
+        int32_t re = in[i*2], im = in[i*2+1];
+        uint32_t pw = (uint32_t)(re * re) + (uint32_t)(im * im);
+        // integer square root
+        uint32_t root = 0, bit = 1UL << 30;
+        while (bit > pw) bit >>= 2;
+        while (bit) {
+            if (pw >= (root + bit)) {
+                pw -= root + bit;
+                root = (root >> 1) + bit;
+            }
+            else root >>= 1;
+            bit >>= 2;
+        }
+        out[i] = (root > 0xFFFF) ? 0xFFFF : root;
+    }
+}
+
+//---------------------------------------------------------------------
+void ufft_calc_power(const int16_t *in, uint32_t *out, size_t points)
+{
+    for (size_t i=0; i<points; i++) {
+        int32_t re = in[i*2], im = in[i*2+1];
+        out[i] = (uint32_t)(re * re) + (uint32_t)(im * im);
+    }
+}
+
+//-------------------------------------------------------------------------
+void ufft_real_to_complex(const int16_t *in, int16_t *out, size_t samples)
+{
+    // backwards, so the conversion can be done in place
+    for (int i=samples-1; i>=0; i--) {
+        out[i*2] = in[i];
+        out[i*2+1] = 0;
+    }
+}
+
+//---------------------------------------------------------------
+void ufft_apply_window(int16_t *data, int n, int step, int kind)
+{
+    for (int i=0; i<n; i++) {
+        float x = 2.0f * (float)M_PI * (float)i / (float)(n - 1);
+        float w;
+        if (kind == UFFT_WINDOW_HANN) w = 0.5f - 0.5f * cosf(x);
+        else if (kind == UFFT_WINDOW_HAMMING) w = 0.54f - 0.46f * cosf(x);
+        else w = 0.42f - 0.5f * cosf(x) + 0.08f * cosf(2.0f * x);
+        // Q15 coefficient
+        int32_t coef = (int32_t)lroundf(w * 32767.0f);
+        for (int j=0; j<step; j++) {
+            data[i*step+j] = (int16_t)((data[i*step+j] * coef) >> 15);
+        }
+    }
+}
@@ -0,0 +1,54 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __MICROPY_INCLUDED_UFFTKERNELS_H__
+#define __MICROPY_INCLUDED_UFFTKERNELS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define UFFT_WINDOW_HANN        0
+#define UFFT_WINDOW_HAMMING     1
+#define UFFT_WINDOW_BLACKMAN    2
+
+// Data processing functions of the ufft module, independent of the FFT hardware.
+// Complex data is stored as interleaved 16-bit (real, imaginary) pairs.
+
+// Swap real and imaginary part of each point
+void ufft_swap_ri(uint32_t *data, size_t points);
+// Software reference implementation of the hardware FFT, 'in' and 'out' may be the same buffer
+void ufft_sw_fft(const int16_t *in, int16_t *out, int points, int shift, bool inverse);
+// Magnitude of each point, rounded down and limited to 0xFFFF
+void ufft_calc_magnitude(const int16_t *in, uint16_t *out, size_t points);
+// Power (re^2 + im^2) of each point
+void ufft_calc_power(const int16_t *in, uint32_t *out, size_t points);
+// Real samples to complex data, 'in' and 'out' may be the same buffer
+void ufft_real_to_complex(const int16_t *in, int16_t *out, size_t samples);
+// Apply the window function to 'n' samples, 'step' is 2 for complex data (both parts are scaled)
+void ufft_apply_window(int16_t *data, int n, int step, int kind);
+
+#endif
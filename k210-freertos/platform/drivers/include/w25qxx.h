@@ -63,6 +63,8 @@
 #define w25qxx_FLASH_SECTOR_SIZE            4096
 #define w25qxx_FLASH_PAGE_NUM_PER_SECTOR    16
 #define w25qxx_FLASH_CHIP_SIZE              (16777216 UL)
+// Flash is memory mapped at this address when SPI3 XIP mode is enabled
+#define w25qxx_FLASH_XIP_ADDRESS            (0x54000000)
 
 #define WRITE_ENABLE                        0x06
 #define WRITE_DISABLE                       0x04
@@ -111,6 +113,9 @@ enum w25qxx_status_t
     W25QXX_ERROR,
 };
 
+typedef int (*w25qxx_xip_lock_t)(bool write);
+typedef void (*w25qxx_xip_unlock_t)(int state, bool write);
+
 extern bool w25qxx_spi_check;
 extern bool w25qxx_debug;
 extern uint32_t w25qxx_flash_speed;
@@ -127,6 +132,7 @@ enum w25qxx_status_t w25qxx_sector_erase(uint32_t addr);
 enum w25qxx_status_t w25qxx_read_id(uint8_t *manuf_id, uint8_t *device_id);
 enum w25qxx_status_t w25qxx_enable_xip_mode(void);
 enum w25qxx_status_t w25qxx_disable_xip_mode(void);
+void w25qxx_set_xip_lock(w25qxx_xip_lock_t lock, w25qxx_xip_unlock_t unlock);
 
 #endif
 
@@ -60,6 +60,12 @@ static uint32_t rd_count;
 static uint32_t wr_count;
 static uint32_t er_count;
 static uint64_t op_time;
+static volatile bool xip_enabled = false;
+static bool xip_restore = false;
+static TaskHandle_t xip_owner = NULL;
+static int xip_lock_state = 0;
+static w25qxx_xip_lock_t xip_lock = NULL;
+static w25qxx_xip_unlock_t xip_unlock = NULL;
 static uint8_t __attribute__((aligned(8))) swap_buf[w25qxx_FLASH_SECTOR_SIZE];
 
 //--------------------------------------------------------------------------------------------------------------------
@@ -187,13 +193,51 @@ static enum w25qxx_status_t w25qxx_enable_quad_mode(void)
     return W25QXX_OK;
 }
 
+// While XIP mode is enabled the SPI3 registers can not be used.
+// Reads are done through the XIP window, XIP is only disabled during the
+// program, erase and configuration operations and enabled again after them.
+// The XIP lock functions, if set, keep all XIP readers (on both cores)
+// away from the Flash for the duration of the operation.
+// Nested calls from the same task are executed as part of the outer operation.
+//--------------------------------
+static bool w25qxx_xip_pause(void)
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    if ((xip_owner != NULL) && (xip_owner == task)) return false;
+    if ((xip_lock == NULL) && (!xip_enabled)) return false;
+
+    int state = (xip_lock) ? xip_lock(true) : 0;
+    xip_owner = task;
+    xip_lock_state = state;
+    xip_restore = xip_enabled;
+    if (xip_enabled) {
+        spi_dev_set_xip_mode(spi_adapter, false);
+        xip_enabled = false;
+    }
+    return true;
+}
+
+//----------------------------------------
+static void w25qxx_xip_resume(bool paused)
+{
+    if (!paused) return;
+    if (xip_restore) {
+        spi_dev_set_xip_mode(spi_adapter, true);
+        xip_enabled = true;
+    }
+    xip_owner = NULL;
+    if (xip_unlock) xip_unlock(xip_lock_state, true);
+}
+
 //------------------------------------------------------------------------
 enum w25qxx_status_t w25qxx_read_id(uint8_t *manuf_id, uint8_t *device_id)
 {
     uint8_t cmd[4] = {READ_ID, 0x00, 0x00, 0x00};
     uint8_t data[2] = {0};
 
+    bool xip = w25qxx_xip_pause();
     w25qxx_receive_data(cmd, 4, data, 2);
+    w25qxx_xip_resume(xip);
     *manuf_id = data[0];
     *device_id = data[1];
     return W25QXX_OK;
@@ -250,6 +294,11 @@ static enum w25qxx_status_t _w25qxx_read_data(uint32_t addr, uint8_t* data_buf,
     uint32_t len;
     uint64_t ticks_start = sys_ticks_us();
     uint64_t ticks;
+    if (xip_enabled) {
+        // memory mapped Flash, the XIP reads are not cached
+        memcpy(data_buf, (const void *)(w25qxx_FLASH_XIP_ADDRESS + addr), length);
+        length = 0;
+    }
     while (length) {
         len = length >= 0x010000 ? 0x010000 : length;
         w25qxx_read_data_less_64kb(addr, data_buf, len);
@@ -264,8 +313,8 @@ static enum w25qxx_status_t _w25qxx_read_data(uint32_t addr, uint8_t* data_buf,
     return W25QXX_OK;
 }
 
-//--------------------------------------------------------------------------------------
-enum w25qxx_status_t w25qxx_read_data(uint32_t addr, uint8_t* data_buf, uint32_t length)
+//-----------------------------------------------------------------------------------------------------
+static enum w25qxx_status_t w25qxx_read_data_checked(uint32_t addr, uint8_t* data_buf, uint32_t length)
 {
     uint8_t *read_buf = NULL;
     int retry = 0;
@@ -287,6 +336,20 @@ start:
     return W25QXX_OK;
 }
 
+// XIP is not disabled for reading, the XIP lock only keeps the writers away.
+// Nested reads in a flash operation are done in register mode.
+//--------------------------------------------------------------------------------------
+enum w25qxx_status_t w25qxx_read_data(uint32_t addr, uint8_t* data_buf, uint32_t length)
+{
+    if ((xip_lock == NULL) || (xip_owner == xTaskGetCurrentTaskHandle())) {
+        return w25qxx_read_data_checked(addr, data_buf, length);
+    }
+    int state = xip_lock(false);
+    enum w25qxx_status_t res = w25qxx_read_data_checked(addr, data_buf, length);
+    xip_unlock(state, false);
+    return res;
+}
+
 // ==== Flash write functions ====================================================================
 
 // Erase the flash sector at address 'addr'
@@ -298,10 +361,12 @@ enum w25qxx_status_t w25qxx_sector_erase(uint32_t addr)
     cmd[1] = (uint8_t)(addr >> 16);
     cmd[2] = (uint8_t)(addr >> 8);
     cmd[3] = (uint8_t)(addr);
+    bool xip = w25qxx_xip_pause();
     w25qxx_write_enable();
     w25qxx_send_data(spi_stand, cmd, 4, 0, 0);
     er_count++;
     enum w25qxx_status_t res = w25qxx_wait_busy();
+    w25qxx_xip_resume(xip);
     return res;
 }
 
@@ -361,9 +426,8 @@ static enum w25qxx_status_t w25qxx_sector_program(uint32_t addr, uint8_t* data_b
     return W25QXX_OK;
 }
 
-// Write data buffer of arbitrary length to flash address 'addr'
-//---------------------------------------------------------------------------------------
-enum w25qxx_status_t w25qxx_write_data(uint32_t addr, uint8_t* data_buf, uint32_t length)
+//------------------------------------------------------------------------------------------------------
+static enum w25qxx_status_t w25qxx_write_data_sectors(uint32_t addr, uint8_t* data_buf, uint32_t length)
 {
     uint32_t sector_addr, sector_offset, sector_remain, write_len, index;
     uint8_t *pread, *pwrite;
@@ -431,10 +495,21 @@ enum w25qxx_status_t w25qxx_write_data(uint32_t addr, uint8_t* data_buf, uint32_
     return W25QXX_OK;
 }
 
+// Write data buffer of arbitrary length to flash address 'addr'
+//---------------------------------------------------------------------------------------
+enum w25qxx_status_t w25qxx_write_data(uint32_t addr, uint8_t* data_buf, uint32_t length)
+{
+    bool xip = w25qxx_xip_pause();
+    enum w25qxx_status_t res = w25qxx_write_data_sectors(addr, data_buf, length);
+    w25qxx_xip_resume(xip);
+    return res;
+}
+
 //---------------------------------------------------------------------
 uint32_t w25qxx_init(uintptr_t spi_in, uint8_t mode, double clock_rate)
 {
     configASSERT(mode < 3);
+    bool xip = w25qxx_xip_pause();
     work_trans_mode = mode;
     uint8_t manuf_id, device_id;
     w25qxx_actual_speed = clock_rate;
@@ -454,6 +529,8 @@ uint32_t w25qxx_init(uintptr_t spi_in, uint8_t mode, double clock_rate)
     w25qxx_read_id(&manuf_id, &device_id);
     if ((manuf_id != 0xEF && manuf_id != 0xC8) || (device_id != 0x17 && device_id != 0x16)) {
         if (w25qxx_debug) LOGE("w25qxx_init", "Unsupported manuf_id: 0x%02x, device_id:0x%02x", manuf_id, device_id);
+        xip_restore = false;
+        w25qxx_xip_resume(xip);
         return 0;
     }
     if (w25qxx_debug) LOGD("w25qxx_init", "manuf_id:0x%02x, device_id:0x%02x", manuf_id, device_id);
@@ -473,13 +550,20 @@ uint32_t w25qxx_init(uintptr_t spi_in, uint8_t mode, double clock_rate)
             spi_dev_config_non_standard(spi_adapter_wr, INSTRUCTION_LENGTH, ADDRESS_LENGTH, 0, SPI_AITM_STANDARD);
             spi_dev_set_clock_rate(spi_adapter_wr, clock_rate);
 
-            if (w25qxx_enable_quad_mode() != W25QXX_OK) return 0;
+            if (w25qxx_enable_quad_mode() != W25QXX_OK) {
+                xip_restore = false;
+                w25qxx_xip_resume(xip);
+                return 0;
+            }
             break;
         case SPI_FF_STANDARD:
         default:
             spi_adapter = spi_stand;
             break;
     }
+    // XIP is only available in quad mode and stays disabled otherwise
+    if (work_trans_mode != SPI_FF_QUAD) xip_restore = false;
+    w25qxx_xip_resume(xip);
     return w25qxx_actual_speed;
 }
 
@@ -487,7 +571,8 @@ uint32_t w25qxx_init(uintptr_t spi_in, uint8_t mode, double clock_rate)
 enum w25qxx_status_t w25qxx_enable_xip_mode(void)
 {
     if (!spi_adapter) return W25QXX_ERROR;
-    spi_dev_set_xip_mode(spi_adapter, true);
+    if (!spi_dev_set_xip_mode(spi_adapter, true)) return W25QXX_ERROR;
+    xip_enabled = true;
     return W25QXX_OK;
 }
 
@@ -496,9 +581,20 @@ enum w25qxx_status_t w25qxx_disable_xip_mode(void)
 {
     if (!spi_adapter) return W25QXX_ERROR;
     spi_dev_set_xip_mode(spi_adapter, false);
+    xip_enabled = false;
     return W25QXX_OK;
 }
 
+// Set the functions used to lock out the XIP readers during flash operations.
+// 'lock' is called with 'write' set before XIP is disabled, and without it
+// around the reads through the XIP window; its result is passed to 'unlock'
+//--------------------------------------------------------------------------
+void w25qxx_set_xip_lock(w25qxx_xip_lock_t lock, w25qxx_xip_unlock_t unlock)
+{
+    xip_lock = lock;
+    xip_unlock = unlock;
+}
+
 //--------------------------
 void w25qxx_clear_counters()
 {
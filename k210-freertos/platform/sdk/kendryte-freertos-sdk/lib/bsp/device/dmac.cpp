@@ -253,6 +253,7 @@ public:
         if (flow_control != DMAC_MEM2MEM_DMA && old_elm_size < 4)
         {
             void *alloc_mem = malloc(sizeof(uint32_t) * count + 128);
+            configASSERT(alloc_mem);
             session_.alloc_mem = alloc_mem;
             element_size = sizeof(uint32_t);
 
@@ -12,6 +12,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <stdlib.h>
 #include <FreeRTOS.h>
 #include <fft.h>
 #include <hal.h>
@@ -24,6 +25,9 @@ using namespace sys;
 #define COMMON_ENTRY \
     semaphore_lock locker(free_mutex_);
 
+// 64-bit words in one frame of the maximal size (512 points, 4 bytes each)
+#define FFT_FRAME_WORDS_MAX 256
+
 class k_fft_driver : public fft_driver, public static_object, public free_object_access
 {
 public:
@@ -41,6 +45,8 @@ public:
     virtual void on_first_open() override
     {
         sysctl_clock_enable(clock_);
+        // two frames, the next frame is prepared while the current one is transferred
+        swap_buf_ = (uint64_t *)malloc(FFT_FRAME_WORDS_MAX * 2 * sizeof(uint64_t));
 
         fft_.intr_clear.fft_done_clear = 1;
         fft_.intr_mask.fft_done_mask = 0;
@@ -49,10 +55,43 @@ public:
     virtual void on_last_close() override
     {
         sysctl_clock_disable(clock_);
+        free(swap_buf_);
+        swap_buf_ = nullptr;
     }
 
     virtual void complex_uint16(uint16_t shift, fft_direction_t direction, const uint64_t *input, size_t point_num, uint64_t *output) override
     {
+        complex_uint16_batch(shift, direction, input, point_num, 1, output);
+    }
+
+    virtual void complex_uint16_batch(uint16_t shift, fft_direction_t direction, const uint64_t *input, size_t point_num, size_t frames, uint64_t *output) override
+    {
+        run(shift, direction, input, point_num, frames, output, false);
+    }
+
+    virtual void complex_uint16_batch_ri(uint16_t shift, fft_direction_t direction, const uint64_t *input, size_t point_num, size_t frames, uint64_t *output) override
+    {
+        run(shift, direction, input, point_num, frames, output, true);
+    }
+
+private:
+    // Swap the real and imaginary part of each point (16-bit halves of each 32-bit word)
+    static void swap_ri(const uint64_t *src, uint64_t *dst, size_t words)
+    {
+        for (size_t i = 0; i < words; i++)
+        {
+            uint64_t v = src[i];
+            dst[i] = ((v >> 16) & 0x0000FFFF0000FFFFULL) | ((v << 16) & 0xFFFF0000FFFF0000ULL);
+        }
+    }
+
+    // With 'ri' set, the points are (real, imaginary) pairs. Each input frame is swapped into
+    // the driver's buffer, the input is never modified. Each output frame is swapped in place
+    // while the next frame is transferred.
+    void run(uint16_t shift, fft_direction_t direction, const uint64_t *input, size_t point_num, size_t frames, uint64_t *output, bool ri)
+    {
+        COMMON_ENTRY;
+
         fft_point_t point = FFT_512;
         switch (point_num)
         {
@@ -84,14 +123,35 @@ public:
         ctl.fft_enable = 1;
         fft_.fft_ctrl.data = ctl.data;
 
+        // DMA channels and events are shared by all frames
         uintptr_t dma_write = dma_open_free();
         uintptr_t dma_read = dma_open_free();
         dma_set_request_source(dma_write, SYSCTL_DMA_SELECT_FFT_TX_REQ);
         dma_set_request_source(dma_read, SYSCTL_DMA_SELECT_FFT_RX_REQ);
         SemaphoreHandle_t event_read = xSemaphoreCreateBinary(), event_write = xSemaphoreCreateBinary();
-        dma_transmit_async(dma_read, &fft_.fft_output_fifo, output, 0, 1, sizeof(uint64_t), point_num >> 1, 4, event_read);
-        dma_transmit_async(dma_write, input, &fft_.fft_input_fifo, 1, 0, sizeof(uint64_t), point_num >> 1, 4, event_write);
-        configASSERT(xSemaphoreTake(event_read, portMAX_DELAY) == pdTRUE && xSemaphoreTake(event_write, portMAX_DELAY) == pdTRUE);
+        size_t frame_size = point_num >> 1;
+        if (ri)
+        {
+            configASSERT(swap_buf_);
+            swap_ri(input, swap_buf_, frame_size);
+        }
+        for (size_t i = 0; i < frames; i++)
+        {
+            const uint64_t *src = (ri) ? swap_buf_ + ((i & 1) * FFT_FRAME_WORDS_MAX) : input + (i * frame_size);
+            dma_transmit_async(dma_read, &fft_.fft_output_fifo, output + (i * frame_size), 0, 1, sizeof(uint64_t), frame_size, 4, event_read);
+            dma_transmit_async(dma_write, src, &fft_.fft_input_fifo, 1, 0, sizeof(uint64_t), frame_size, 4, event_write);
+            if (ri)
+            {
+                // the input frame was already read if the output is the same buffer
+                if (i + 1 < frames)
+                    swap_ri(input + ((i + 1) * frame_size), swap_buf_ + (((i + 1) & 1) * FFT_FRAME_WORDS_MAX), frame_size);
+                if (i > 0)
+                    swap_ri(output + ((i - 1) * frame_size), output + ((i - 1) * frame_size), frame_size);
+            }
+            configASSERT(xSemaphoreTake(event_read, portMAX_DELAY) == pdTRUE && xSemaphoreTake(event_write, portMAX_DELAY) == pdTRUE);
+        }
+        if (ri)
+            swap_ri(output + ((frames - 1) * frame_size), output + ((frames - 1) * frame_size), frame_size);
 
         dma_close(dma_write);
         dma_close(dma_read);
@@ -99,10 +159,10 @@ public:
         vSemaphoreDelete(event_write);
     }
 
-private:
     volatile fft_t &fft_;
     sysctl_clock_t clock_;
     SemaphoreHandle_t free_mutex_;
+    uint64_t *swap_buf_ = nullptr;
 };
 
 static k_fft_driver dev0_driver(FFT_BASE_ADDR, SYSCTL_CLOCK_FFT);
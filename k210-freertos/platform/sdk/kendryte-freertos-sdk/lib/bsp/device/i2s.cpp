@@ -168,6 +168,7 @@ public:
         memset(session_.buffer, 0, session_.buffer_size * BUFFER_COUNT);
         session_.buffer_ptr = 0;
         session_.next_free_buffer = 0;
+        session_.prefilled = 0;
         session_.stop_signal = 0;
         session_.transmit_dma = NULL_HANDLE;
         session_.dma_in_use_buffer = 0;
@@ -275,6 +276,7 @@ public:
         memset(session_.buffer, 0, session_.buffer_size * BUFFER_COUNT);
         session_.buffer_ptr = 0;
         session_.next_free_buffer = 0;
+        session_.prefilled = 0;
         session_.stop_signal = 0;
         session_.transmit_dma = NULL_HANDLE;
         session_.dma_in_use_buffer = 0;
@@ -286,12 +288,9 @@ public:
 
     virtual void get_buffer(gsl::span<uint8_t> &buffer, size_t &frames) override
     {
-        int next_free_buffer = session_.next_free_buffer;
-        while (next_free_buffer == session_.dma_in_use_buffer)
-        {
+        while (!free_buffer_available())
             xSemaphoreTake(session_.stage_completion_event, portMAX_DELAY);
-            next_free_buffer = session_.next_free_buffer;
-        }
+        int next_free_buffer = session_.next_free_buffer;
 
         frames = (session_.buffer_size - session_.buffer_ptr) / session_.block_align;
         buffer = { session_.buffer + session_.buffer_size * next_free_buffer + session_.buffer_ptr, std::ptrdiff_t(frames * session_.block_align) };
@@ -301,13 +300,7 @@ public:
     {
         session_.buffer_ptr += frames * session_.block_align;
         if (session_.buffer_ptr >= session_.buffer_size)
-        {
-            session_.buffer_ptr = 0;
-            int next_free_buffer = session_.next_free_buffer + 1;
-            if (next_free_buffer == BUFFER_COUNT)
-                next_free_buffer = 0;
-            session_.next_free_buffer = next_free_buffer;
-        }
+            next_buffer();
     }
 
     virtual void start() override
@@ -316,6 +309,11 @@ public:
         {
             configASSERT(!session_.transmit_dma);
 
+            // LoBo: the partially prefilled buffer is played as it is, silence after the written frames
+            if (session_.buffer_ptr)
+                next_buffer();
+            session_.prefilled = 0;
+
             session_.stop_signal = 0;
             session_.transmit_dma = dma_open_free();
             dma_set_request_source(session_.transmit_dma, dma_req_ - 1);
@@ -373,10 +371,69 @@ public:
 
     virtual void stop() override
     {
+        // LoBo: stop the DMA loop, so that the device can be started again
+        if (session_.transmit_dma)
+        {
+            session_.stop_signal = 1;
+            xSemaphoreTake(session_.completion_event, 1000 / portTICK_PERIOD_MS);
+        }
         i2s_transmit_set_enable(session_.transmit, 0);
+        if (session_.transmit_dma)
+        {
+            dma_close(session_.transmit_dma);
+            session_.transmit_dma = NULL_HANDLE;
+            vSemaphoreDelete(session_.stage_completion_event);
+            vSemaphoreDelete(session_.completion_event);
+            session_.stage_completion_event = NULL;
+            session_.completion_event = NULL;
+        }
+        // LoBo: the data not played or not read is discarded, the next start begins with the first buffer
+        memset(session_.buffer, 0, session_.buffer_size * BUFFER_COUNT);
+        session_.buffer_ptr = 0;
+        session_.next_free_buffer = 0;
+        session_.dma_in_use_buffer = 0;
+        session_.prefilled = 0;
+    }
+
+    // LoBo: added functions
+    virtual bool try_get_buffer(gsl::span<uint8_t> &buffer, size_t &frames) override
+    {
+        if (!free_buffer_available())
+            return false;
+        int next_free_buffer = session_.next_free_buffer;
+
+        frames = (session_.buffer_size - session_.buffer_ptr) / session_.block_align;
+        buffer = { session_.buffer + session_.buffer_size * next_free_buffer + session_.buffer_ptr, std::ptrdiff_t(frames * session_.block_align) };
+        return true;
+    }
+
+    virtual void set_on_stage_completion(i2s_stage_completion_handler_t handler, void *userdata) override
+    {
+        session_.on_stage_completion_data = userdata;
+        session_.on_stage_completion = handler;
     }
 
 private:
+    // LoBo: while the render is stopped, both buffers can be filled before the start (prefill),
+    // the DMA starts with the first one
+    bool free_buffer_available()
+    {
+        if ((session_.transmit == I2S_SEND) && (!session_.transmit_dma))
+            return session_.prefilled < BUFFER_COUNT;
+        return session_.next_free_buffer != session_.dma_in_use_buffer;
+    }
+
+    void next_buffer()
+    {
+        session_.buffer_ptr = 0;
+        int next_free_buffer = session_.next_free_buffer + 1;
+        if (next_free_buffer == BUFFER_COUNT)
+            next_free_buffer = 0;
+        session_.next_free_buffer = next_free_buffer;
+        if (!session_.transmit_dma)
+            session_.prefilled++;
+    }
+
     void i2s_set_threshold(volatile i2s_channel_t &i2sc, i2s_transmit transmit, i2s_fifo_threshold_t threshold)
     {
         if (transmit == I2S_RECEIVE)
@@ -517,6 +574,10 @@ private:
             dma_in_use_buffer = 0;
         driver.session_.dma_in_use_buffer = dma_in_use_buffer;
 
+        // LoBo: notify the user
+        if (driver.session_.on_stage_completion)
+            driver.session_.on_stage_completion(driver.session_.on_stage_completion_data);
+
         BaseType_t xHigherPriorityTaskWoken = pdFALSE;
         xSemaphoreGiveFromISR(driver.session_.stage_completion_event, &xHigherPriorityTaskWoken);
         if (xHigherPriorityTaskWoken)
@@ -542,10 +603,13 @@ private:
         size_t buffer_ptr;
         volatile int next_free_buffer;
         volatile int dma_in_use_buffer;
+        int prefilled;
         int stop_signal;
         handle_t transmit_dma;
         SemaphoreHandle_t stage_completion_event;
         SemaphoreHandle_t completion_event;
+        i2s_stage_completion_handler_t on_stage_completion;
+        void *on_stage_completion_data;
     } session_;
 };
 
@@ -19,6 +19,7 @@
 #include <hal.h>
 #include <kernel/driver_impl.hpp>
 #include <kpu.h>
+#include <kpu_kernels.h>
 #include <sysctl.h>
 #include <math.h>
 #include <float.h>
@@ -368,144 +369,13 @@ private:
     {
         const uint8_t *src_a = (const uint8_t *)(ctx_.main_buffer + arg->main_mem_in_a_address);
         const uint8_t *src_b = (const uint8_t *)(ctx_.main_buffer + arg->main_mem_in_b_address);
-        size_t count = ALIGN_UP(arg->count, 8) / 8;
-        int64_t off_a = arg->in_a_offset, mul_a = arg->in_a_mul, sh_a = arg->in_a_shift;
-        int64_t off_b = arg->in_b_offset, mul_b = arg->in_b_mul, sh_b = arg->in_b_shift;
-        int64_t off_o = arg->out_offset, mul_o = arg->out_mul, sh_o = arg->out_shift;
-    
         uint8_t *dest = (uint8_t *)(ctx_.main_buffer + arg->main_mem_out_address);
-        size_t i;
+        kpu_kernel_quant_add_param_t param = {
+            arg->in_a_offset, arg->in_a_mul, arg->in_a_shift,
+            arg->in_b_offset, arg->in_b_mul, arg->in_b_shift,
+            arg->out_offset, arg->out_mul, arg->out_shift };
 
-        if (sh_a == sh_b)
-        {
-#define QADD_UNROLL_1(x)     \
-            int64_t a##x = *src_a++; \
-            int64_t b##x = *src_b++;
-        
-#define QADD_UNROLL_2(x) \
-            a##x += off_a; \
-            b##x += off_b;
-        
-#define QADD_UNROLL_3(x) \
-            a##x *= mul_a; \
-            b##x *= mul_b;
-        
-#define QADD_UNROLL_4(x) \
-            int64_t v##x = a##x + b##x;
-        
-#define QADD_UNROLL_5(x) \
-            v##x >>= sh_a;
-        
-#define QADD_UNROLL_6(x) \
-            v##x *= mul_o;
-        
-#define QADD_UNROLL_7(x) \
-            v##x >>= sh_o;
-        
-#define QADD_UNROLL_8(x) \
-            v##x += off_o;
-        
-#define QADD_UNROLL_9(x) \
-            v##x = min(0xFF, max(0, v##x));
-        
-#define QADD_UNROLL_10(x) \
-            *dest++ = v##x;
-        
-#define QADD_UNROLL_S(x) \
-            QADD_UNROLL_##x(0) \
-            QADD_UNROLL_##x(1) \
-            QADD_UNROLL_##x(2) \
-            QADD_UNROLL_##x(3) \
-            QADD_UNROLL_##x(4) \
-            QADD_UNROLL_##x(5) \
-            QADD_UNROLL_##x(6) \
-            QADD_UNROLL_##x(7)
-
-            for (i = 0; i < count; i++)
-            {
-                QADD_UNROLL_S(1);
-                QADD_UNROLL_S(2);
-                QADD_UNROLL_S(3);
-                QADD_UNROLL_S(4);
-                QADD_UNROLL_S(5);
-                QADD_UNROLL_S(6);
-                QADD_UNROLL_S(7);
-                QADD_UNROLL_S(8);
-                QADD_UNROLL_S(9);
-                QADD_UNROLL_S(10);
-            }
-        }
-        else
-        {
-#undef QADD_UNROLL_1
-#define QADD_UNROLL_1(x)     \
-            int64_t a##x = *src_a++; \
-            int64_t b##x = *src_b++;
-
-#undef QADD_UNROLL_2
-#define QADD_UNROLL_2(x) \
-            a##x += off_a; \
-            b##x += off_b;
-
-#undef QADD_UNROLL_3
-#define QADD_UNROLL_3(x) \
-            a##x *= mul_a; \
-            b##x *= mul_b;
-
-#undef QADD_UNROLL_4
-#define QADD_UNROLL_4(x) \
-            a##x >>= sh_a; \
-            b##x >>= sh_b;
-
-#undef QADD_UNROLL_5
-#define QADD_UNROLL_5(x) \
-            int64_t v##x = a##x + b##x;
-
-#undef QADD_UNROLL_6
-#define QADD_UNROLL_6(x) \
-            v##x *= mul_o;
-
-#undef QADD_UNROLL_7
-#define QADD_UNROLL_7(x) \
-            v##x >>= sh_o;
-
-#undef QADD_UNROLL_8
-#define QADD_UNROLL_8(x) \
-            v##x += off_o;
-
-#undef QADD_UNROLL_9
-#define QADD_UNROLL_9(x) \
-            v##x = min(0xFF, max(0, v##x));
-
-#undef QADD_UNROLL_10
-#define QADD_UNROLL_10(x) \
-            *dest++ = v##x;
-
-#undef QADD_UNROLL_S
-#define QADD_UNROLL_S(x) \
-            QADD_UNROLL_##x(0) \
-            QADD_UNROLL_##x(1) \
-            QADD_UNROLL_##x(2) \
-            QADD_UNROLL_##x(3) \
-            QADD_UNROLL_##x(4) \
-            QADD_UNROLL_##x(5) \
-            QADD_UNROLL_##x(6) \
-            QADD_UNROLL_##x(7)
-
-            for (i = 0; i < count; i++)
-            {
-                QADD_UNROLL_S(1);
-                QADD_UNROLL_S(2);
-                QADD_UNROLL_S(3);
-                QADD_UNROLL_S(4);
-                QADD_UNROLL_S(5);
-                QADD_UNROLL_S(6);
-                QADD_UNROLL_S(7);
-                QADD_UNROLL_S(8);
-                QADD_UNROLL_S(9);
-                QADD_UNROLL_S(10);
-            }
-        }
+        kpu_kernel_quantized_add(src_a, src_b, dest, arg->count, &param);
     }
 
     void kpu_global_average_pool2d(const kpu_model_gap2d_layer_argument_t *arg)
@@ -646,21 +516,9 @@ private:
     {
         const uint8_t *src = (const uint8_t *)(ctx_.main_buffer + arg->main_mem_in_address);
         uint8_t *dest = (uint8_t *)(ctx_.main_buffer + arg->main_mem_out_address);
-        size_t oc, count = ALIGN_UP(arg->count, 8) / 8;
-        const uint8_t *table = arg->table;
-        
-		for (oc = 0; oc < count;)
-	    {
-			dest[oc++] = table[*src++];
-			dest[oc++] = table[*src++];
-			dest[oc++] = table[*src++];
-			dest[oc++] = table[*src++];
-			dest[oc++] = table[*src++];
-			dest[oc++] = table[*src++];
-			dest[oc++] = table[*src++];
-			dest[oc++] = table[*src++];
-	    }
-	}
+
+        kpu_kernel_requantize(src, dest, arg->count, arg->table);
+    }
 
     void kpu_l2_normalization(const kpu_model_l2_norm_layer_argument_t *arg)
     {
@@ -683,54 +541,25 @@ private:
     {
         const float *src = (const float *)(ctx_.main_buffer + arg->main_mem_in_address);
         float *dest = (float *)(ctx_.main_buffer + arg->main_mem_out_address);
-        size_t oc, channels = arg->channels;
-    
-        float max = FLT_MIN;
-        for (oc = 0; oc < channels; oc++)
-            max = fmaxf(max, src[oc]);
-    
-        float sum = 0.f;
-        for (oc = 0; oc < channels; oc++)
-        {
-            float value = expf(src[oc] - max);
-            sum += value;
-            dest[oc] = value;
-        }
-            
-        for (oc = 0; oc < channels; oc++)
-            dest[oc] /= sum;
+
+        kpu_kernel_softmax(src, dest, arg->channels);
     }
 
     void kpu_concat(const kpu_model_concat_layer_argument_t *arg)
     {
         uint8_t *dest = (uint8_t *)(ctx_.main_buffer + arg->main_mem_out_address);
-        uint32_t count = arg->input_count, i;
-    
-        for (i = 0; i < count; i++)
-        {
-            kpu_model_memory_range_t input = arg->inputs_mem[i];
-            const uint8_t *src = (const uint8_t *)(ctx_.main_buffer + input.start);
-            memcpy(dest, src, input.size);
-            dest += input.size;
-        }
+
+        kpu_kernel_concat(ctx_.main_buffer, (const uint32_t *)arg->inputs_mem, arg->input_count, dest);
     }
 
     void kpu_fully_connected(const kpu_model_fully_connected_layer_argument_t *arg)
     {
         const float *src = (const float *)(ctx_.main_buffer + arg->main_mem_in_address);
         float *dest = (float *)(ctx_.main_buffer + arg->main_mem_out_address);
-        uint32_t in_channels = arg->in_channels, out_channels = arg->out_channels, ic, oc;
+        uint32_t in_channels = arg->in_channels, out_channels = arg->out_channels;
         const float *weights = arg->weights, *bias = arg->weights + in_channels * out_channels;
 
-        for (oc = 0; oc < out_channels; oc++)
-        {
-            const float *c_weights = weights + oc * in_channels;
-
-            float sum = 0.0f;
-            for (ic = 0; ic < in_channels; ic++)
-                sum += src[ic] * c_weights[ic];
-            dest[oc] = sum + bias[oc];
-        }
+        kpu_kernel_fully_connected(src, dest, weights, bias, in_channels, out_channels);
     }
 
     void kpu_tf_flatten(const kpu_model_tf_flatten_layer_argument_t *arg)
@@ -751,26 +580,8 @@ private:
         const float *src = (const float *)(ctx_.main_buffer + arg->main_mem_in_address);
         float *dest = (float *)(ctx_.main_buffer + arg->main_mem_out_address);
         kpu_model_shape_t in_shape = arg->in_shape;
-        uint32_t out_width = arg->out_width, out_height = arg->out_height;
-        uint32_t oc, oy, ox;
-    
-        float height_scale = (float)in_shape.height / out_height;
-        float width_scale = (float)in_shape.width / out_width;
-    
-        for (oc = 0; oc < in_shape.channels; oc++)
-        {
-            const float *channel_src = src + in_shape.width * in_shape.height * oc;
-            for (oy = 0; oy <out_height; oy++)
-            {
-                uint32_t in_y = (uint32_t)min(floorf(oy * height_scale), in_shape.height - 1);
-                const float *y_origin = channel_src + in_y * in_shape.width;
-                for (ox = 0; ox < out_width; ox++)
-                {
-                    uint32_t in_x = (uint32_t)min(floorf(ox * width_scale), in_shape.width - 1);
-                    *dest++ = y_origin[in_x];
-                }
-            }
-        }
+
+        kpu_kernel_resize_nearest_neighbor(src, dest, in_shape.width, in_shape.height, in_shape.channels, arg->out_width, arg->out_height);
     }
 
     void kpu_conv(const kpu_model_conv_layer_argument_t *arg)
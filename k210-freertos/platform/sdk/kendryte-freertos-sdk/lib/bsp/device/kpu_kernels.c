@@ -0,0 +1,260 @@
+/* Copyright 2019 LoBo (https://github.com/loboris)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <kpu_kernels.h>
+
+#define KK_MIN(a, b) (((a) < (b)) ? (a) : (b))
+#define KK_MAX(a, b) (((a) > (b)) ? (a) : (b))
+#define KK_ALIGN_UP(x, align) ((x + (align - 1)) & (~(align - 1)))
+
+// Max output width for which the source column index table is used in resize
+#define KK_RESIZE_MAX_TABLE 512
+
+// 2^(i/256), i = 0 ~ 256
+static const float exp2_table[257] =
+{
+    1.000000000f, 1.002711275f, 1.005429901f, 1.008155898f, 1.010889286f, 1.013630085f,
+    1.016378315f, 1.019133996f, 1.021897149f, 1.024667793f, 1.027445949f, 1.030231638f,
+    1.033024879f, 1.035825694f, 1.038634102f, 1.041450125f, 1.044273782f, 1.047105096f,
+    1.049944086f, 1.052790773f, 1.055645178f, 1.058507323f, 1.061377227f, 1.064254913f,
+    1.067140401f, 1.070033712f, 1.072934868f, 1.075843889f, 1.078760798f, 1.081685615f,
+    1.084618362f, 1.087559061f, 1.090507733f, 1.093464399f, 1.096429082f, 1.099401803f,
+    1.102382583f, 1.105371446f, 1.108368412f, 1.111373503f, 1.114386743f, 1.117408152f,
+    1.120437752f, 1.123475567f, 1.126521619f, 1.129575929f, 1.132638520f, 1.135709414f,
+    1.138788635f, 1.141876204f, 1.144972144f, 1.148076479f, 1.151189230f, 1.154310421f,
+    1.157440074f, 1.160578212f, 1.163724859f, 1.166880037f, 1.170043770f, 1.173216080f,
+    1.176396992f, 1.179586527f, 1.182784711f, 1.185991566f, 1.189207115f, 1.192431383f,
+    1.195664392f, 1.198906167f, 1.202156731f, 1.205416109f, 1.208684324f, 1.211961399f,
+    1.215247360f, 1.218542230f, 1.221846033f, 1.225158794f, 1.228480536f, 1.231811285f,
+    1.235151064f, 1.238499898f, 1.241857812f, 1.245224830f, 1.248600977f, 1.251986278f,
+    1.255380757f, 1.258784440f, 1.262197350f, 1.265619515f, 1.269050957f, 1.272491703f,
+    1.275941778f, 1.279401208f, 1.282870016f, 1.286348230f, 1.289835873f, 1.293332973f,
+    1.296839555f, 1.300355643f, 1.303881265f, 1.307416446f, 1.310961212f, 1.314515588f,
+    1.318079601f, 1.321653278f, 1.325236643f, 1.328829724f, 1.332432547f, 1.336045138f,
+    1.339667524f, 1.343299731f, 1.346941786f, 1.350593716f, 1.354255547f, 1.357927306f,
+    1.361609021f, 1.365300717f, 1.369002423f, 1.372714165f, 1.376435971f, 1.380167867f,
+    1.383909882f, 1.387662042f, 1.391424376f, 1.395196910f, 1.398979673f, 1.402772691f,
+    1.406575994f, 1.410389608f, 1.414213562f, 1.418047884f, 1.421892602f, 1.425747744f,
+    1.429613338f, 1.433489413f, 1.437375997f, 1.441273119f, 1.445180807f, 1.449099090f,
+    1.453027996f, 1.456967554f, 1.460917794f, 1.464878744f, 1.468850433f, 1.472832891f,
+    1.476826146f, 1.480830228f, 1.484845166f, 1.488870990f, 1.492907728f, 1.496955412f,
+    1.501014070f, 1.505083732f, 1.509164428f, 1.513256187f, 1.517359041f, 1.521473019f,
+    1.525598151f, 1.529734467f, 1.533881998f, 1.538040774f, 1.542210825f, 1.546392183f,
+    1.550584878f, 1.554788940f, 1.559004400f, 1.563231290f, 1.567469640f, 1.571719481f,
+    1.575980845f, 1.580253763f, 1.584538265f, 1.588834384f, 1.593142151f, 1.597461598f,
+    1.601792756f, 1.606135656f, 1.610490332f, 1.614856814f, 1.619235135f, 1.623625327f,
+    1.628027422f, 1.632441452f, 1.636867450f, 1.641305448f, 1.645755478f, 1.650217574f,
+    1.654691768f, 1.659178092f, 1.663676580f, 1.668187265f, 1.672710180f, 1.677245357f,
+    1.681792831f, 1.686352633f, 1.690924799f, 1.695509361f, 1.700106354f, 1.704715810f,
+    1.709337763f, 1.713972248f, 1.718619298f, 1.723278948f, 1.727951231f, 1.732636182f,
+    1.737333835f, 1.742044225f, 1.746767386f, 1.751503353f, 1.756252160f, 1.761013843f,
+    1.765788436f, 1.770575974f, 1.775376493f, 1.780190027f, 1.785016611f, 1.789856282f,
+    1.794709075f, 1.799575025f, 1.804454168f, 1.809346539f, 1.814252176f, 1.819171112f,
+    1.824103385f, 1.829049031f, 1.834008086f, 1.838980587f, 1.843966569f, 1.848966070f,
+    1.853979125f, 1.859005772f, 1.864046048f, 1.869099990f, 1.874167634f, 1.879249018f,
+    1.884344179f, 1.889453154f, 1.894575982f, 1.899712698f, 1.904863342f, 1.910027950f,
+    1.915206561f, 1.920399213f, 1.925605944f, 1.930826791f, 1.936061793f, 1.941310990f,
+    1.946574418f, 1.951852116f, 1.957144124f, 1.962450480f, 1.967771223f, 1.973106392f,
+    1.978456026f, 1.983820165f, 1.989198847f, 1.994592112f, 2.000000000f
+};
+
+float kpu_kernel_exp(float x)
+{
+    // exp(x) = 2^(x * log2(e)) = 2^n * 2^f, 0 <= f < 1
+    float t = x * 1.44269504f;
+    if (isnan(t))
+        return t;
+    // results below FLT_MIN (no denormals) and above FLT_MAX
+    if (t < -126.0f)
+        return 0.0f;
+    if (t >= 128.0f)
+        return INFINITY;
+    int32_t n = (int32_t)floorf(t);
+    float idx = (t - (float)n) * 256.0f;
+    int32_t i = (int32_t)idx;
+    // for tiny negative t, 't - n' rounds to 1.0f, use 2^(255/256 + 1/256)
+    if (i > 255)
+        i = 255;
+    float frac = idx - (float)i;
+    float v = exp2_table[i] + (exp2_table[i + 1] - exp2_table[i]) * frac;
+
+    union
+    {
+        uint32_t u;
+        float f;
+    } scale;
+    scale.u = (uint32_t)(n + 127) << 23;
+    return v * scale.f;
+}
+
+void kpu_kernel_fully_connected(const float *src, float *dest, const float *weights, const float *bias, uint32_t in_channels, uint32_t out_channels)
+{
+    uint32_t ic, oc = 0;
+
+    // 4 output channels per pass, each input value is loaded only once for all of them
+    // every sum is still accumulated in input channel order, so the result is the same
+    // as computing the channels one by one
+    for (; oc + 4 <= out_channels; oc += 4)
+    {
+        const float *w0 = weights + oc * in_channels;
+        const float *w1 = w0 + in_channels;
+        const float *w2 = w1 + in_channels;
+        const float *w3 = w2 + in_channels;
+        float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+
+        for (ic = 0; ic < in_channels; ic++)
+        {
+            float x = src[ic];
+            s0 += x * w0[ic];
+            s1 += x * w1[ic];
+            s2 += x * w2[ic];
+            s3 += x * w3[ic];
+        }
+        dest[oc] = s0 + bias[oc];
+        dest[oc + 1] = s1 + bias[oc + 1];
+        dest[oc + 2] = s2 + bias[oc + 2];
+        dest[oc + 3] = s3 + bias[oc + 3];
+    }
+
+    for (; oc < out_channels; oc++)
+    {
+        const float *c_weights = weights + oc * in_channels;
+        float sum = 0.0f;
+        for (ic = 0; ic < in_channels; ic++)
+            sum += src[ic] * c_weights[ic];
+        dest[oc] = sum + bias[oc];
+    }
+}
+
+void kpu_kernel_softmax(const float *src, float *dest, size_t channels)
+{
+    size_t oc;
+    float max = -FLT_MAX;
+    for (oc = 0; oc < channels; oc++)
+        max = fmaxf(max, src[oc]);
+
+    float sum = 0.f;
+    for (oc = 0; oc < channels; oc++)
+    {
+#if KPU_KERNELS_FAST_EXP
+        float value = kpu_kernel_exp(src[oc] - max);
+#else
+        float value = expf(src[oc] - max);
+#endif
+        sum += value;
+        dest[oc] = value;
+    }
+
+    float scale = 1.f / sum;
+    for (oc = 0; oc < channels; oc++)
+        dest[oc] *= scale;
+}
+
+static inline uint8_t quantized_add_value(int64_t a, int64_t b, int64_t sh_a, int64_t sh_b, int64_t mul_o, int64_t sh_o, int64_t off_o)
+{
+    int64_t v = (sh_a == sh_b) ? ((a + b) >> sh_a) : ((a >> sh_a) + (b >> sh_b));
+    v = ((v * mul_o) >> sh_o) + off_o;
+    return (uint8_t)KK_MIN(0xFF, KK_MAX(0, v));
+}
+
+void kpu_kernel_quantized_add(const uint8_t *src_a, const uint8_t *src_b, uint8_t *dest, size_t count, const kpu_kernel_quant_add_param_t *param)
+{
+    int64_t off_a = param->in_a_offset, mul_a = param->in_a_mul, sh_a = param->in_a_shift;
+    int64_t off_b = param->in_b_offset, mul_b = param->in_b_mul, sh_b = param->in_b_shift;
+    int64_t off_o = param->out_offset, mul_o = param->out_mul, sh_o = param->out_shift;
+    size_t i, j;
+
+    count = KK_ALIGN_UP(count, 8);
+    // blocks of 8 values, the inner loop is unrolled by the compiler
+    for (i = 0; i < count; i += 8)
+    {
+        for (j = i; j < i + 8; j++)
+            dest[j] = quantized_add_value((src_a[j] + off_a) * mul_a, (src_b[j] + off_b) * mul_b, sh_a, sh_b, mul_o, sh_o, off_o);
+    }
+}
+
+void kpu_kernel_requantize(const uint8_t *src, uint8_t *dest, size_t count, const uint8_t *table)
+{
+    size_t i;
+    count = KK_ALIGN_UP(count, 8);
+    for (i = 0; i < count; i += 8)
+    {
+        dest[i] = table[src[i]];
+        dest[i + 1] = table[src[i + 1]];
+        dest[i + 2] = table[src[i + 2]];
+        dest[i + 3] = table[src[i + 3]];
+        dest[i + 4] = table[src[i + 4]];
+        dest[i + 5] = table[src[i + 5]];
+        dest[i + 6] = table[src[i + 6]];
+        dest[i + 7] = table[src[i + 7]];
+    }
+}
+
+void kpu_kernel_resize_nearest_neighbor(const float *src, float *dest, uint32_t in_width, uint32_t in_height, uint32_t channels, uint32_t out_width, uint32_t out_height)
+{
+    uint32_t oc, oy, ox;
+    float height_scale = (float)in_height / out_height;
+    float width_scale = (float)in_width / out_width;
+
+    // source column for each output column is the same for all rows
+    uint16_t x_table[KK_RESIZE_MAX_TABLE];
+    int use_table = (out_width <= KK_RESIZE_MAX_TABLE);
+    if (use_table)
+    {
+        for (ox = 0; ox < out_width; ox++)
+            x_table[ox] = (uint16_t)KK_MIN(floorf(ox * width_scale), in_width - 1);
+    }
+
+    for (oc = 0; oc < channels; oc++)
+    {
+        const float *channel_src = src + in_width * in_height * oc;
+        uint32_t last_y = UINT32_MAX;
+        for (oy = 0; oy < out_height; oy++)
+        {
+            uint32_t in_y = (uint32_t)KK_MIN(floorf(oy * height_scale), in_height - 1);
+            if (in_y == last_y)
+            {
+                // same source row, copy the previous output row
+                memcpy(dest, dest - out_width, out_width * sizeof(float));
+                dest += out_width;
+                continue;
+            }
+            last_y = in_y;
+            const float *y_origin = channel_src + in_y * in_width;
+            if (use_table)
+            {
+                for (ox = 0; ox < out_width; ox++)
+                    *dest++ = y_origin[x_table[ox]];
+            }
+            else
+            {
+                for (ox = 0; ox < out_width; ox++)
+                    *dest++ = y_origin[(uint32_t)KK_MIN(floorf(ox * width_scale), in_width - 1)];
+            }
+        }
+    }
+}
+
+void kpu_kernel_concat(const uint8_t *base, const uint32_t *ranges, uint32_t count, uint8_t *dest)
+{
+    uint32_t i;
+    for (i = 0; i < count; i++)
+    {
+        memcpy(dest, base + ranges[i * 2], ranges[i * 2 + 1]);
+        dest += ranges[i * 2 + 1];
+    }
+}
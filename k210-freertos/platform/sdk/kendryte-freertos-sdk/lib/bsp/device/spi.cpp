@@ -129,6 +129,7 @@ public:
     double set_clock_rate(k_spi_device_driver &device, double clock_rate);
     int read(k_spi_device_driver &device, gsl::span<uint8_t> buffer);
     int write(k_spi_device_driver &device, gsl::span<const uint8_t> buffer);
+    int write_with_instruction(k_spi_device_driver &device, uint32_t instruction, uint32_t address, gsl::span<const uint8_t> buffer);
     int transfer_full_duplex(k_spi_device_driver &device, gsl::span<const uint8_t> write_buffer, gsl::span<uint8_t> read_buffer);
     int transfer_sequential(k_spi_device_driver &device, gsl::span<const uint8_t> write_buffer, gsl::span<uint8_t> read_buffer);
     int transfer_sequential_with_delay(k_spi_device_driver &device, gsl::span<const uint8_t> write_buffer, gsl::span<uint8_t> read_buffer, uint16_t delay);
@@ -212,6 +213,7 @@ public:
 private:
     //---------------------------------------------
     void setup_device(k_spi_device_driver &device);
+    void write_data(k_spi_device_driver &device, const uint8_t *inst, const uint8_t *addr, const uint8_t *buffer_write, size_t tx_buffer_len);
 
     // SPI Slave command processing task
     // Runs with the priority higher than the main task
@@ -726,6 +728,11 @@ public:
         return spi_->write(*this, buffer);
     }
 
+    virtual int write_with_instruction(uint32_t instruction, uint32_t address, gsl::span<const uint8_t> buffer) override // LoBo
+    {
+        return spi_->write_with_instruction(*this, instruction, address, buffer);
+    }
+
     virtual int transfer_full_duplex(gsl::span<const uint8_t> write_buffer, gsl::span<uint8_t> read_buffer) override
     {
         return spi_->transfer_full_duplex(*this, write_buffer, read_buffer);
@@ -935,10 +942,31 @@ int k_spi_driver::write(k_spi_device_driver &device, gsl::span<const uint8_t> bu
 
     setup_device(device);
 
+    const uint8_t *inst = buffer.data();
+    const uint8_t *addr = inst + device.inst_width_;
+    write_data(device, inst, addr, addr + device.addr_width_, buffer.size() - (device.inst_width_ + device.addr_width_));
+
+    return buffer.size();
+}
+
+// LoBo: added function
+// Instruction and address are taken from the arguments instead of the buffer head,
+// so a command can be prepended to a buffer without copying it
+int k_spi_driver::write_with_instruction(k_spi_device_driver &device, uint32_t instruction, uint32_t address, gsl::span<const uint8_t> buffer)
+{
+    COMMON_ENTRY;
+
+    setup_device(device);
+
+    write_data(device, (const uint8_t *)&instruction, (const uint8_t *)&address, buffer.data(), buffer.size());
+
+    return buffer.size();
+}
+
+void k_spi_driver::write_data(k_spi_device_driver &device, const uint8_t *inst, const uint8_t *addr, const uint8_t *buffer_write, size_t tx_buffer_len)
+{
     uint32_t i = 0;
-    size_t tx_buffer_len = buffer.size() - (device.inst_width_ + device.addr_width_);
     size_t tx_frames = tx_buffer_len / device.buffer_width_;
-    auto buffer_write = buffer.data();
     set_bit_mask(&spi_.ctrlr0, TMOD_MASK, TMOD_VALUE(1));
 
     if (tx_frames < SPI_TRANSMISSION_THRESHOLD)
@@ -946,8 +974,8 @@ int k_spi_driver::write(k_spi_device_driver &device, gsl::span<const uint8_t> bu
         vTaskEnterCritical();
         size_t index, fifo_len;
         spi_.ssienr = 0x01;
-        write_inst_addr(spi_.dr, &buffer_write, device.inst_width_);
-        write_inst_addr(spi_.dr, &buffer_write, device.addr_width_);
+        write_inst_addr(spi_.dr, &inst, device.inst_width_);
+        write_inst_addr(spi_.dr, &addr, device.addr_width_);
         spi_.ser = device.chip_select_mask_;
         while (tx_buffer_len)
         {
@@ -980,8 +1008,8 @@ int k_spi_driver::write(k_spi_device_driver &device, gsl::span<const uint8_t> bu
         dma_set_request_source(dma_write, dma_req_ + 1);
         spi_.dmacr = 0x2;
         spi_.ssienr = 0x01;
-        write_inst_addr(spi_.dr, &buffer_write, device.inst_width_);
-        write_inst_addr(spi_.dr, &buffer_write, device.addr_width_);
+        write_inst_addr(spi_.dr, &inst, device.inst_width_);
+        write_inst_addr(spi_.dr, &addr, device.addr_width_);
         SemaphoreHandle_t event_write = xSemaphoreCreateBinary();
         dma_transmit_async(dma_write, buffer_write, &spi_.dr[0], 1, 0, device.buffer_width_, tx_frames, 4, event_write);
         spi_.ser = device.chip_select_mask_;
@@ -994,8 +1022,6 @@ int k_spi_driver::write(k_spi_device_driver &device, gsl::span<const uint8_t> bu
     spi_.ser = 0x00;
     spi_.ssienr = 0x00;
     spi_.dmacr = 0x00;
-
-    return buffer.size();
 }
 
 int k_spi_driver::transfer_full_duplex(k_spi_device_driver &device, gsl::span<const uint8_t> write_buffer, gsl::span<uint8_t> read_buffer)
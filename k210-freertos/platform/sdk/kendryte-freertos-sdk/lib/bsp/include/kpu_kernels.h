@@ -0,0 +1,105 @@
+/* Copyright 2019 LoBo (https://github.com/loboris)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * CPU kernels for the kmodel layers not executed by the KPU
+ *
+ * The kernels only depend on the standard C library, they take plain pointers
+ * and sizes (not the kmodel layer arguments), so they can be compiled and
+ * verified on any host.
+ */
+#ifndef _BSP_KPU_KERNELS_H
+#define _BSP_KPU_KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Use the table based exp() in softmax
+// Relative error is < 1e-5, set to 0 to use the standard 'expf'
+#ifndef KPU_KERNELS_FAST_EXP
+#define KPU_KERNELS_FAST_EXP    1
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    int32_t in_a_offset;
+    int32_t in_a_mul;
+    int32_t in_a_shift;
+    int32_t in_b_offset;
+    int32_t in_b_mul;
+    int32_t in_b_shift;
+    int32_t out_offset;
+    int32_t out_mul;
+    int32_t out_shift;
+} kpu_kernel_quant_add_param_t;
+
+/**
+ * @brief       Fully connected layer, dest = weights * src + bias
+ *
+ * @param[in]   src             Input vector, 'in_channels' values
+ * @param[out]  dest            Output vector, 'out_channels' values
+ * @param[in]   weights         Weights matrix, 'in_channels' values for each output channel
+ * @param[in]   bias            Bias vector, 'out_channels' values
+ */
+void kpu_kernel_fully_connected(const float *src, float *dest, const float *weights, const float *bias, uint32_t in_channels, uint32_t out_channels);
+
+/**
+ * @brief       Softmax over 'channels' values
+ */
+void kpu_kernel_softmax(const float *src, float *dest, size_t channels);
+
+/**
+ * @brief       Quantized add of two uint8 vectors
+ *              'count' is rounded up to the multiple of 8
+ */
+void kpu_kernel_quantized_add(const uint8_t *src_a, const uint8_t *src_b, uint8_t *dest, size_t count, const kpu_kernel_quant_add_param_t *param);
+
+/**
+ * @brief       Requantize uint8 vector using the translation table
+ *              'count' is rounded up to the multiple of 8
+ */
+void kpu_kernel_requantize(const uint8_t *src, uint8_t *dest, size_t count, const uint8_t *table);
+
+/**
+ * @brief       Nearest neighbor resize of the CHW float tensor
+ */
+void kpu_kernel_resize_nearest_neighbor(const float *src, float *dest, uint32_t in_width, uint32_t in_height, uint32_t channels, uint32_t out_width, uint32_t out_height);
+
+/**
+ * @brief       Concatenate the memory ranges
+ *
+ * @param[in]   base            Base address of the input ranges
+ * @param[in]   ranges          'count' pairs of (start offset, size in bytes)
+ * @param[in]   count           Number of input ranges
+ * @param[out]  dest            Output buffer
+ */
+void kpu_kernel_concat(const uint8_t *base, const uint32_t *ranges, uint32_t count, uint8_t *dest);
+
+/**
+ * @brief       Table based exp() (used by softmax with x <= 0)
+ *              Relative error is < 1e-5 for -87.3 <= x <= 88.7,
+ *              0 is returned below (no denormals), +inf above, NaN for NaN
+ */
+float kpu_kernel_exp(float x);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BSP_KPU_KERNELS_H */
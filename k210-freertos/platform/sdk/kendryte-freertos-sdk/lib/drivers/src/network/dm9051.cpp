@@ -54,6 +54,7 @@ enum DM9051_TYPE
 #define DM9051_ID       (0x90510A46) /* DM9051A ID                                                   */
 #define DM9051_PKT_MAX  (1536) /* Received packet max size                                     */
 #define DM9051_PKT_RDY  (0x01) /* Packet ready to receive                                      */
+#define DM9051_TX_TIMEOUT    (10) /* TX busy wait in ticks, a full frame takes 1.2 ms at 10M      */
 
 #define DM9051_NCR      (0x00)
 #define DM9051_NSR      (0x01)
@@ -232,6 +233,7 @@ public:
 
     virtual void install() override
     {
+        tx_event_ = xSemaphoreCreateBinary();
     }
 
     virtual void on_first_open() override
@@ -239,6 +241,9 @@ public:
         auto spi = make_accessor(spi_driver_);
         spi_dev_ = make_accessor(spi->get_device(SPI_MODE_0, SPI_FF_STANDARD, spi_cs_mask_, 8));
         spi_dev_->set_clock_rate(20000000);
+        /* 8-bit instruction phase: memory writes send the opcode from write_with_instruction(), */
+        /* register writes are unchanged as their first byte is sent as the instruction           */
+        spi_dev_->config_non_standard(8, 0, 0, SPI_AITM_STANDARD);
 
         int_gpio_ = make_accessor(int_gpio_driver_);
         int_gpio_->set_drive_mode(int_gpio_pin_, GPIO_DM_INPUT);
@@ -340,16 +345,19 @@ public:
         write(DM9051_NSR, NSR_CLR_STATUS);
         write(DM9051_ISR, ISR_CLR_STATUS);
 
-        write(DM9051_IMR, IMR_PAR | IMR_PRM);
+        write(DM9051_IMR, IMR_DEFAULT);
         write(DM9051_RCR, (RCR_DEFAULT | RCR_RXEN)); /* Enable RX */
     }
 
     virtual void begin_send(size_t length) override
     {
         configASSERT(length <= std::numeric_limits<uint16_t>::max());
+        /* Clear the previous TX complete status, so the end of the frame in progress is a new INT edge */
+        write(DM9051_ISR, ISR_PTS);
         while (read(DM9051_TCR) & DM9051_TCR_SET)
         {
-            usleep(5000);
+            /* Woken by the TX complete interrupt, or by disable_rx() if INT was already low */
+            xSemaphoreTake(tx_event_, DM9051_TX_TIMEOUT);
         }
         write(DM9051_TXPLL, length & 0xff);
         write(DM9051_TXPLH, (length >> 8) & 0xff);
@@ -394,16 +402,26 @@ public:
             }
         }
 
+        rx_remaining_ = len;
         return len;
     }
 
     virtual void receive(gsl::span<uint8_t> buffer) override
     {
         read_memory(buffer);
+        rx_remaining_ -= std::min(rx_remaining_, (size_t)buffer.size());
     }
 
     virtual void end_receive() override
     {
+        /* Drop what was not read (no pbuf available), so the next frame header is read from the right place */
+        uint8_t scratch[64];
+        while (rx_remaining_)
+        {
+            size_t len = std::min(rx_remaining_, sizeof(scratch));
+            read_memory({ scratch, scratch + len });
+            rx_remaining_ -= len;
+        }
     }
 
     virtual void disable_rx() override
@@ -424,12 +442,17 @@ public:
         }
         /* clear the rx interrupt-event */
         write(DM9051_ISR, rxchk);
+        /* With INT held low by the rx status, the end of a frame gave no edge */
+        if (rxchk & ISR_PTS)
+        {
+            xSemaphoreGive(tx_event_);
+        }
     }
 
     virtual void enable_rx() override
     {
-        /* restore receive interrupt */
-        write(DM9051_IMR, IMR_PAR | IMR_PRM);
+        /* restore receive and TX complete interrupts */
+        write(DM9051_IMR, IMR_DEFAULT);
     }
 
     virtual bool interface_check() override
@@ -453,7 +476,9 @@ private:
     {
         auto &driver = *reinterpret_cast<dm9051_driver *>(userdata);
         BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+        /* The status can't be read here, wake both the poll thread and a waiting sender */
         xSemaphoreGiveFromISR(driver.interrupt_event_, &xHigherPriorityTaskWoken);
+        xSemaphoreGiveFromISR(driver.tx_event_, &xHigherPriorityTaskWoken);
         if (xHigherPriorityTaskWoken)
         {
             portYIELD_FROM_ISR();
@@ -524,10 +549,8 @@ private:
 
     void write_memory(gsl::span<const uint8_t> buffer)
     {
-        auto new_buffer = std::make_unique<uint8_t[]>(buffer.size_bytes() + 1);
-        std::copy(buffer.begin(), buffer.end(), new_buffer.get() + 1);
-        new_buffer[0] = SPI_WR_BURST;
-        spi_dev_->write({ new_buffer.get(), buffer.size_bytes() + 1 });
+        /* The opcode goes out in the instruction phase, the data is sent in place */
+        spi_dev_->write_with_instruction(SPI_WR_BURST, 0, buffer);
     }
 
     void set_mac_address(const mac_address_t &mac_addr)
@@ -593,6 +616,8 @@ private:
     object_accessor<spi_device_driver> spi_dev_;
 
     SemaphoreHandle_t interrupt_event_;
+    SemaphoreHandle_t tx_event_;
+    size_t rx_remaining_ = 0;
 };
 
 handle_t dm9051_driver_install(handle_t spi_handle, uint32_t spi_cs_mask, handle_t int_gpio_handle, uint32_t int_gpio_pin, const mac_address_t *mac_address)
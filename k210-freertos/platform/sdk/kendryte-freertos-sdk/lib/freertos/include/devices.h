@@ -286,6 +286,26 @@ void i2s_start(handle_t file);
  */
 void i2s_stop(handle_t file);
 
+/** LoBo
+ * @brief       Get the audio buffer of a I2S controller without waiting
+ *
+ * @param[in]   file        The I2S controller handle
+ * @param[out]  buffer      The address of audio buffer
+ * @param[out]  frames      The available frames count in buffer
+ *
+ * @return      true if the buffer is available, false if it is still used by DMA
+ */
+bool i2s_try_get_buffer(handle_t file, uint8_t **buffer, size_t *frames);
+
+/** LoBo
+ * @brief       Set the handler called (from ISR) when the DMA finishes one of the buffers
+ *
+ * @param[in]   file        The I2S controller handle
+ * @param[in]   handler     The handler, NULL to disable
+ * @param[in]   userdata    The handler's user data
+ */
+void i2s_set_on_stage_completion(handle_t file, i2s_stage_completion_handler_t handler, void *userdata);
+
 /**
  * LoBo
  * @brief       Set spi slave configuration
@@ -542,6 +562,32 @@ void sccb_dev_write_byte(handle_t file, uint16_t reg_address, uint8_t value);
  */
 void fft_complex_uint16(uint16_t shift, fft_direction_t direction, const uint64_t *input, size_t point, uint64_t *output);
 
+/** LoBo
+ * @brief       Do 16bit quantized complex FFT on a number of consecutive frames
+ *              DMA channels are opened only once for all frames
+ *
+ * @param[in]   shift           The shifts selection in 9 stage
+ * @param[in]   direction       The direction
+ * @param[in]   input           The input data, 'frames' frames of 'point' points
+ * @param[in]   point           The FFT points count of one frame
+ * @param[in]   frames          The number of frames
+ * @param[out]  output          The output data, can be the same as input
+ */
+void fft_complex_uint16_batch(uint16_t shift, fft_direction_t direction, const uint64_t *input, size_t point, size_t frames, uint64_t *output);
+
+/** LoBo
+ * @brief       The same as 'fft_complex_uint16_batch', but the points are (real, imaginary) pairs
+ *              Each input frame is swapped into the driver's buffer, the input is never modified
+ *
+ * @param[in]   shift           The shifts selection in 9 stage
+ * @param[in]   direction       The direction
+ * @param[in]   input           The input data, 'frames' frames of 'point' points
+ * @param[in]   point           The FFT points count of one frame, 512 max
+ * @param[in]   frames          The number of frames
+ * @param[out]  output          The output data, can be the same as input
+ */
+void fft_complex_uint16_batch_ri(uint16_t shift, fft_direction_t direction, const uint64_t *input, size_t point, size_t frames, uint64_t *output);
+
 /**
  * @brief       AES-ECB-128 decryption
  *
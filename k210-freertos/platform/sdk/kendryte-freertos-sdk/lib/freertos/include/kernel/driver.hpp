@@ -236,6 +236,9 @@ public:
     virtual void release_buffer(uint32_t frames) = 0;
     virtual void start() = 0;
     virtual void stop() = 0;
+    // LoBo: added functions
+    virtual bool try_get_buffer(gsl::span<uint8_t> &buffer, size_t &frames) = 0;
+    virtual void set_on_stage_completion(i2s_stage_completion_handler_t handler, void *userdata) = 0;
 };
 
 class spi_device_driver : public driver
@@ -252,6 +255,7 @@ public:
     virtual bool set_xip_mode(bool enable) = 0;
     virtual int transfer_sequential_with_delay(gsl::span<const uint8_t> write_buffer, gsl::span<uint8_t> read_buffer, uint16_t delay) = 0;
     virtual void master_config_half_duplex(int8_t mosi, int8_t miso) = 0;
+    virtual int write_with_instruction(uint32_t instruction, uint32_t address, gsl::span<const uint8_t> buffer) = 0;
 };
 
 class spi_driver : public driver
@@ -294,6 +298,8 @@ class fft_driver : public driver
 {
 public:
     virtual void complex_uint16(uint16_t shift, fft_direction_t direction, const uint64_t *input, size_t point_num, uint64_t *output) = 0;
+    virtual void complex_uint16_batch(uint16_t shift, fft_direction_t direction, const uint64_t *input, size_t point_num, size_t frames, uint64_t *output) = 0;
+    virtual void complex_uint16_batch_ri(uint16_t shift, fft_direction_t direction, const uint64_t *input, size_t point_num, size_t frames, uint64_t *output) = 0;
 };
 
 class aes_driver : public driver
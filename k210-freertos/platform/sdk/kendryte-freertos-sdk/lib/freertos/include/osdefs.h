@@ -106,6 +106,9 @@ typedef enum _i2s_align_mode
     I2S_AM_LEFT
 } i2s_align_mode_t;
 
+// LoBo: I2S buffer completion callback
+typedef void (*i2s_stage_completion_handler_t)(void *userdata);
+
 typedef enum _spi_mode
 {
     SPI_MODE_0,
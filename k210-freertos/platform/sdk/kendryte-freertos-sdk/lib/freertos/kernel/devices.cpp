@@ -481,6 +481,23 @@ void i2s_stop(handle_t file)
     i2s->stop();
 }
 
+// LoBo: added functions
+bool i2s_try_get_buffer(handle_t file, uint8_t **buffer, size_t *frames)
+{
+    COMMON_ENTRY(i2s);
+    gsl::span<uint8_t> span;
+    if (!i2s->try_get_buffer(span, *frames))
+        return false;
+    *buffer = span.data();
+    return true;
+}
+
+void i2s_set_on_stage_completion(handle_t file, i2s_stage_completion_handler_t handler, void *userdata)
+{
+    COMMON_ENTRY(i2s);
+    i2s->set_on_stage_completion(handler, userdata);
+}
+
 /* SPI */
 // LoBo: changed function
 void spi_slave_config(handle_t file, size_t data_bit_length, uint8_t *data, uint32_t len, uint32_t ro_len, spi_slave_receive_callback_t callback, spi_slave_csum_callback_t csum_callback, int priority, int mosi, int miso)
@@ -638,6 +655,18 @@ void fft_complex_uint16(uint16_t shift, fft_direction_t direction, const uint64_
     fft->complex_uint16(shift, direction, input, point_num, output);
 }
 
+void fft_complex_uint16_batch(uint16_t shift, fft_direction_t direction, const uint64_t *input, size_t point_num, size_t frames, uint64_t *output)
+{
+    COMMON_ENTRY_FILE(fft_file_, fft);
+    fft->complex_uint16_batch(shift, direction, input, point_num, frames, output);
+}
+
+void fft_complex_uint16_batch_ri(uint16_t shift, fft_direction_t direction, const uint64_t *input, size_t point_num, size_t frames, uint64_t *output)
+{
+    COMMON_ENTRY_FILE(fft_file_, fft);
+    fft->complex_uint16_batch_ri(shift, direction, input, point_num, frames, output);
+}
+
 /* AES */
 
 void aes_ecb128_hard_decrypt(const uint8_t *input_key, const uint8_t *input_data, size_t input_len, uint8_t *output_data)
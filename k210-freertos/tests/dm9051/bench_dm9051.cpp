@@ -0,0 +1,255 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host benchmark of the DM9051 driver (lib/drivers/src/network/dm9051.cpp) with lwIP's lwiperf
+ *
+ * The driver runs against the simulated chip (dm9051_host.cpp), its wire is a TAP interface
+ * of the host. lwIP (the SDK's sources and options, without the OS) runs in the main loop, as
+ * the tcpip thread does. The poll thread of network.cpp runs when the main loop waits.
+ * The host side of each test is a thread using the host's TCP stack:
+ *   RX  the host sends to the lwiperf server
+ *   TX  the lwiperf client sends to the host for 10 s
+ * The throughput is the one reported by lwiperf, on the virtual clock. It is limited by the
+ * SPI transfers and the wire, the CPU time of lwIP and the driver on the K210 is not counted.
+ * The time the host takes to answer is counted as it passes.
+ * 'spin %' is the time in usleep(), which the SDK implements as a busy loop.
+ *
+ * Creating the TAP interface needs CAP_NET_ADMIN, without it the benchmark is skipped.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <deque>
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <kernel/driver.hpp>
+#include "lwip/init.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+#include "lwip/timeouts.h"
+#include "lwip/etharp.h"
+#include "lwip/apps/lwiperf.h"
+#include "netif/ethernet.h"
+#include "dm9051_host.h"
+
+using namespace sys;
+
+#define RX_SIZE         (2 * 1024 * 1024)
+
+static const mac_address_t mac = { { 0x02, 0x00, 0x00, 0x51, 0x90, 0x01 } };
+static network_adapter_driver *adapter;
+static SemaphoreHandle_t interrupt_event;
+static struct netif netif;
+static std::deque<struct pbuf *> input_queue;      // tcpip thread mailbox
+static volatile bool test_done;
+static u32_t test_bytes, test_ms, test_kbps;
+
+extern "C" u32_t sys_now(void)
+{
+    return (u32_t)(host_now_ns() / 1000000);
+}
+
+static uint64_t real_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// ==== Ethernet interface, as in network.cpp ====
+
+static struct pbuf *low_level_input()
+{
+    size_t len = adapter->begin_receive();
+    struct pbuf *p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
+    if (p != NULL) {
+        for (struct pbuf *q = p; q != NULL; q = q->next) adapter->receive({ (uint8_t *)q->payload, q->len });
+    }
+    adapter->end_receive();
+    return p;
+}
+
+static err_t low_level_output(struct netif *netif, struct pbuf *p)
+{
+    adapter->begin_send(p->tot_len);
+    for (struct pbuf *q = p; q != NULL; q = q->next) adapter->send({ (const uint8_t *)q->payload, q->len });
+    adapter->end_send();
+    return ERR_OK;
+}
+
+// tcpip_input(), the frame is passed to lwIP by the main loop
+static err_t queue_input(struct pbuf *p, struct netif *netif)
+{
+    input_queue.push_back(p);
+    return ERR_OK;
+}
+
+static err_t ethernetif_init(struct netif *netif)
+{
+    netif->output = etharp_output;
+    netif->linkoutput = low_level_output;
+    netif->hwaddr_len = ETHARP_HWADDR_LEN;
+    memcpy(netif->hwaddr, mac.data, ETHARP_HWADDR_LEN);
+    netif->mtu = 1500;
+    netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_LINK_UP;
+    adapter->reset(interrupt_event);
+    return ERR_OK;
+}
+
+static void poll_thread()
+{
+    if (xSemaphoreTake(interrupt_event, 0) && adapter->interface_check()) {
+        adapter->disable_rx();
+        while (adapter->is_packet_available()) {
+            struct pbuf *p = low_level_input();
+            if ((p != NULL) && (netif.input(p, &netif) != ERR_OK)) pbuf_free(p);
+        }
+        adapter->enable_rx();
+    }
+}
+
+static void report(void *arg, enum lwiperf_report_type report_type, const ip_addr_t *local_addr, u16_t local_port,
+                   const ip_addr_t *remote_addr, u16_t remote_port, u32_t bytes_transferred, u32_t ms_duration, u32_t bandwidth_kbitpsec)
+{
+    if ((report_type != LWIPERF_TCP_DONE_SERVER) && (report_type != LWIPERF_TCP_DONE_CLIENT)) {
+        printf("lwiperf: test aborted (%d)\n", (int)report_type);
+        bytes_transferred = 0;
+    }
+    test_bytes = bytes_transferred;
+    test_ms = ms_duration;
+    test_kbps = bandwidth_kbitpsec;
+    test_done = true;
+}
+
+// ==== Main loop ====
+
+static void run_until_done()
+{
+    static uint8_t frame[2048];
+    uint64_t real = real_ns();
+    test_done = false;
+    // the host side must see the board's FIN too
+    while (!test_done || !tap_peer_done()) {
+        bool busy = false;
+        int n;
+        while ((n = tap_read(frame, sizeof(frame))) > 0) {
+            host_receive(frame, n);
+            busy = true;
+        }
+        while (!input_queue.empty()) {
+            struct pbuf *p = input_queue.front();
+            input_queue.pop_front();
+            if (ethernet_input(p, &netif) != ERR_OK) pbuf_free(p);
+            busy = true;
+        }
+        poll_thread();
+        sys_check_timeouts();
+        uint64_t now = real_ns();
+        if (busy || !input_queue.empty()) {
+            real = now;
+            continue;
+        }
+        uint64_t next = host_next_event();
+        if (next != UINT64_MAX) {
+            host_advance(next - host_now_ns());
+            real = now;
+        }
+        else {
+            // waiting for the host, its time counts as it passes
+            tap_wait(1);
+            now = real_ns();
+            host_advance(now - real);
+            real = now;
+        }
+    }
+}
+
+static void bench(int link_mbps)
+{
+    host_dm9051.link_mbps = link_mbps;
+    const char *names[2] = { "RX", "TX" };
+    for (int tx = 0; tx < 2; tx++) {
+        host_chip_stats start = host_dm9051.stats;
+        uint64_t start_ns = host_now_ns();
+        if (tx) {
+            ip_addr_t host_ip;
+            ipaddr_aton(TAP_HOST_IP, &host_ip);
+            tap_start_peer(false, 0);
+            lwiperf_start_tcp_client_default(&host_ip, report, NULL);
+        }
+        else tap_start_peer(true, RX_SIZE);
+        run_until_done();
+        tap_join_peer();
+        const host_chip_stats &end = host_dm9051.stats;
+        uint64_t frames = tx ? (end.tx_frames - start.tx_frames) : (end.rx_frames - start.rx_frames);
+        uint64_t ns = host_now_ns() - start_ns;
+        printf("%4d Mbit  %s %8u %8u %10u %10.1f %8.1f %8.2f %10llu %8llu\n", link_mbps, names[tx], test_bytes / 1024, test_ms, test_kbps,
+               (end.spi_ns - start.spi_ns) * 100.0 / ns, (end.spin_ns - start.spin_ns) * 100.0 / ns,
+               (double)(end.tcr_reads - start.tcr_reads) / (end.tx_frames - start.tx_frames),
+               (unsigned long long)(end.take_timeouts - start.take_timeouts), (unsigned long long)frames);
+        // let the connection close
+        uint64_t until = host_now_ns() + 1000000000ULL;
+        while (host_now_ns() < until) {
+            test_done = false;
+            sys_check_timeouts();
+            host_advance(10000000);
+        }
+    }
+}
+
+int main()
+{
+    if (!tap_open()) {
+        printf("bench_dm9051: skipped, the TAP interface can't be created (needs CAP_NET_ADMIN)\n");
+        return 0;
+    }
+
+    interrupt_event = xSemaphoreCreateBinary();
+    adapter = system_handle_to_object(host_install(mac)).as<network_adapter_driver>();
+    host_dm9051.on_tx = [](const std::vector<uint8_t> &frame) { tap_write(frame.data(), frame.size()); };
+    host_dm9051.idle = poll_thread;
+
+    lwip_init();
+    ip4_addr_t ip, mask, gw;
+    ip4addr_aton(TAP_BOARD_IP, &ip);
+    ip4addr_aton("255.255.255.0", &mask);
+    ip4addr_aton(TAP_HOST_IP, &gw);
+    netif_add(&netif, &ip, &mask, &gw, NULL, ethernetif_init, queue_input);
+    netif_set_default(&netif);
+    netif_set_up(&netif);
+    // lwiperf_abort() of this lwIP version loses the list, the server is kept for all the tests
+    lwiperf_start_tcp_server_default(report, NULL);
+
+    printf("DM9051 lwiperf over TAP, SPI at 20 MHz with %d us per transfer, TCP_MSS %d, TCP_WND %d\n",
+           HOST_SPI_OVERHEAD_NS / 1000, TCP_MSS, TCP_WND);
+    printf("%9s %3s %8s %8s %10s %10s %8s %8s %10s %8s\n", "link", "", "KB", "ms", "kbit/s", "SPI busy %", "spin %", "TCR/TX", "timeouts", "frames");
+    bench(100);
+    bench(10);
+    return 0;
+}
@@ -0,0 +1,596 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Host stand-ins used by the DM9051 driver: FreeRTOS semaphores on the virtual clock,
+// the SPI and GPIO drivers, the handle table, and the simulated DM9051 behind them
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <task.h>
+#include <sys/unistd.h>
+#include <kernel/driver_impl.hpp>
+#include <network/dm9051.h>
+#include "dm9051_host.h"
+
+using namespace sys;
+
+#define NS_PER_TICK     (1000000ULL)
+
+// DM9051 registers and bits used by the driver
+#define REG_NCR         (0x00)
+#define REG_NSR         (0x01)
+#define REG_TCR         (0x02)
+#define REG_RCR         (0x05)
+#define REG_EPCR        (0x0B)
+#define REG_VIDL        (0x28)
+#define REG_MPCR        (0x55)
+#define REG_MRCMDX      (0x70)
+#define REG_MRCMDX1     (0x71)
+#define REG_MRCMD       (0x72)
+#define REG_TXPLL       (0x7C)
+#define REG_TXPLH       (0x7D)
+#define REG_ISR         (0x7E)
+#define REG_IMR         (0x7F)
+#define SPI_WR_BURST    (0xF8)
+#define NCR_RST         (0x01)
+#define NSR_SPEED       (0x80)
+#define NSR_LINKST      (0x40)
+#define NSR_TX1END      (0x04)
+#define TCR_TXREQ       (0x01)
+#define RCR_RXEN        (0x01)
+#define ISR_PTS         (0x02)
+#define ISR_PRS         (0x01)
+#define ISR_STATUS      (0x3F)
+
+host_chip host_dm9051;
+static uint64_t now_ns;
+
+//--------------------------------------------------------------------
+void host_assert_failed(const char *expr, const char *file, int line)
+{
+    fprintf(stderr, "%s:%d: assertion failed: %s\n", file, line, expr);
+    abort();
+}
+
+// ==== Virtual clock and chip events ====
+
+//--------------------
+uint64_t host_now_ns()
+{
+    return now_ns;
+}
+
+//-----------------------------
+uint64_t host_wire_ns(size_t len)
+{
+    // minimal frame, CRC, preamble and inter-frame gap
+    uint64_t bytes = std::max(len, (size_t)60) + 4 + 8 + 12;
+    return bytes * 8 * 1000 / host_dm9051.link_mbps;
+}
+
+//---------------------------
+uint64_t host_next_event()
+{
+    auto &chip = host_dm9051;
+    uint64_t next = UINT64_MAX;
+    if (chip.tx_done_at) next = chip.tx_done_at;
+    if (!chip.rx_wire.empty()) next = std::min(next, chip.rx_wire.front().first);
+    return next;
+}
+
+//-------------------------
+static void update_int()
+{
+    auto &chip = host_dm9051;
+    bool low = (chip.isr & chip.regs[REG_IMR] & ISR_STATUS) != 0;
+    if (low && !chip.int_low) {
+        chip.int_low = true;
+        chip.stats.int_edges++;
+        if (chip.int_handler) chip.int_handler(0, chip.int_userdata);
+    }
+    chip.int_low = low;
+}
+
+//-------------------------
+static void run_events()
+{
+    auto &chip = host_dm9051;
+    if (chip.tx_done_at && (chip.tx_done_at <= now_ns)) {
+        chip.tx_done_at = 0;
+        chip.isr |= ISR_PTS;
+        chip.regs[REG_NSR] |= NSR_TX1END;
+        chip.stats.tx_frames++;
+        if (chip.on_tx) chip.on_tx(chip.tx_frame);
+        update_int();
+    }
+    while (!chip.rx_wire.empty() && (chip.rx_wire.front().first <= now_ns)) {
+        std::vector<uint8_t> frame = std::move(chip.rx_wire.front().second);
+        chip.rx_wire.pop_front();
+        // the length includes the CRC
+        size_t len = frame.size() + 4;
+        if (!(chip.regs[REG_RCR] & RCR_RXEN) || ((chip.rx_sram.size() + 4 + len) > HOST_RX_SRAM_SIZE)) {
+            chip.stats.rx_dropped++;
+            continue;
+        }
+        const uint8_t header[4] = { 0x01, 0x00, (uint8_t)(len & 0xff), (uint8_t)(len >> 8) };
+        chip.rx_sram.insert(chip.rx_sram.end(), header, header + 4);
+        chip.rx_sram.insert(chip.rx_sram.end(), frame.begin(), frame.end());
+        chip.rx_sram.insert(chip.rx_sram.end(), 4, 0);
+        chip.stats.rx_frames++;
+        chip.isr |= ISR_PRS;
+        update_int();
+    }
+}
+
+//--------------------------------
+static void advance_to(uint64_t t)
+{
+    uint64_t next;
+    while ((next = host_next_event()) <= t) {
+        now_ns = std::max(now_ns, next);
+        run_events();
+    }
+    now_ns = std::max(now_ns, t);
+}
+
+//-------------------------
+void host_advance(uint64_t ns)
+{
+    advance_to(now_ns + ns);
+}
+
+//--------------------------------------------------
+void host_receive(const uint8_t *frame, size_t len)
+{
+    auto &chip = host_dm9051;
+    uint64_t start = std::max(now_ns, chip.rx_wire_free);
+    chip.rx_wire_free = start + host_wire_ns(len);
+    chip.rx_wire.emplace_back(chip.rx_wire_free, std::vector<uint8_t>(frame, frame + len));
+}
+
+// ==== FreeRTOS ====
+
+struct host_semaphore {
+    int count;
+    int max;
+};
+
+static bool in_idle;
+
+//---------------------------------------------
+static SemaphoreHandle_t create(int count, int max)
+{
+    SemaphoreHandle_t semaphore = (SemaphoreHandle_t)calloc(1, sizeof(host_semaphore));
+    configASSERT(semaphore);
+    semaphore->count = count;
+    semaphore->max = max;
+    return semaphore;
+}
+
+//----------------------------------------
+SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    return create(0, 1);
+}
+
+//---------------------------------------
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return create(1, 1);
+}
+
+//------------------------------------------------
+void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+    free(semaphore);
+}
+
+//-----------------------------------------------------------------
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t wait)
+{
+    if ((semaphore->count == 0) && (wait != 0)) {
+        // wakes on the tick interrupt after 'wait' ticks
+        uint64_t deadline = (wait == portMAX_DELAY) ? UINT64_MAX : ((now_ns / NS_PER_TICK) + wait) * NS_PER_TICK;
+        while ((semaphore->count == 0) && (now_ns < deadline)) {
+            // the lower priority task runs while this one sleeps
+            uint64_t next = std::min(host_next_event(), deadline);
+            if (host_dm9051.idle && !in_idle) {
+                if (now_ns >= host_dm9051.idle_at) {
+                    in_idle = true;
+                    host_dm9051.idle();
+                    in_idle = false;
+                    if (semaphore->count) break;
+                }
+                else next = std::min(next, host_dm9051.idle_at);
+            }
+            configASSERT(next != UINT64_MAX);
+            advance_to(next);
+        }
+        if (semaphore->count == 0) host_dm9051.stats.take_timeouts++;
+    }
+    if (semaphore->count == 0) return pdFALSE;
+    semaphore->count--;
+    return pdTRUE;
+}
+
+//-------------------------------------------------
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    if (semaphore->count >= semaphore->max) return pdFALSE;
+    semaphore->count++;
+    return pdTRUE;
+}
+
+//------------------------------------------------------------------------------
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t *woken)
+{
+    if (woken) *woken = pdTRUE;
+    return xSemaphoreGive(semaphore);
+}
+
+//------------------------------
+TickType_t xTaskGetTickCount()
+{
+    return now_ns / NS_PER_TICK;
+}
+
+//-------------------------------
+void vTaskDelay(TickType_t ticks)
+{
+    host_advance(ticks * NS_PER_TICK);
+}
+
+void vTaskEnterCritical() {}
+void vTaskExitCritical() {}
+
+//-----------------------------------
+int host_usleep(unsigned long usec)
+{
+    host_dm9051.stats.spin_ns += (uint64_t)usec * 1000;
+    host_advance((uint64_t)usec * 1000);
+    return 0;
+}
+
+// ==== DM9051 registers and SRAM ====
+
+//--------------------------------
+static uint8_t chip_read(uint8_t addr)
+{
+    auto &chip = host_dm9051;
+    switch (addr) {
+        case REG_NSR:
+            return chip.regs[REG_NSR] | NSR_LINKST | ((chip.link_mbps == 10) ? NSR_SPEED : 0);
+        case REG_TCR:
+            chip.stats.tcr_reads++;
+            return chip.regs[REG_TCR] | (chip.tx_done_at ? TCR_TXREQ : 0);
+        case REG_ISR:
+            return chip.isr;
+        case REG_MRCMDX:
+        case REG_MRCMDX1:
+            // next byte of the RX SRAM, without moving the read pointer
+            return chip.rx_sram.empty() ? 0 : chip.rx_sram.front();
+        default:
+            return chip.regs[addr];
+    }
+}
+
+//---------------------------------------------
+static void chip_reset()
+{
+    auto &chip = host_dm9051;
+    memset(chip.regs, 0, sizeof(chip.regs));
+    // DM9051A vendor and product ID
+    const uint8_t id[4] = { 0x46, 0x0A, 0x51, 0x90 };
+    memcpy(&chip.regs[REG_VIDL], id, sizeof(id));
+    chip.isr = 0;
+    chip.tx_sram.clear();
+    chip.tx_done_at = 0;
+    chip.rx_sram.clear();
+    update_int();
+}
+
+//---------------------------------------------------
+static void chip_write(uint8_t addr, uint8_t value)
+{
+    auto &chip = host_dm9051;
+    switch (addr) {
+        case REG_NCR:
+            if (value & NCR_RST) chip_reset();
+            else chip.regs[REG_NCR] = value;
+            break;
+        case REG_NSR:
+            chip.regs[REG_NSR] &= ~value;
+            break;
+        case REG_TCR:
+            chip.regs[REG_TCR] = value & ~TCR_TXREQ;
+            if ((value & TCR_TXREQ) && !chip.tx_done_at) {
+                size_t len = chip.regs[REG_TXPLL] | (chip.regs[REG_TXPLH] << 8);
+                if (len != chip.tx_sram.size()) chip.stats.tx_errors++;
+                chip.tx_sram.resize(len);
+                chip.tx_frame = std::move(chip.tx_sram);
+                chip.tx_sram.clear();
+                chip.tx_done_at = now_ns + host_wire_ns(len);
+            }
+            break;
+        case REG_EPCR:
+            // PHY access completes at once, the busy bit is never set
+            chip.regs[REG_EPCR] = value & ~0x01;
+            break;
+        case REG_MPCR:
+            if (value & 0x01) chip.rx_sram.clear();
+            break;
+        case REG_ISR:
+            chip.isr &= ~(value & ISR_STATUS);
+            update_int();
+            break;
+        case REG_IMR:
+            chip.regs[REG_IMR] = value;
+            update_int();
+            break;
+        default:
+            chip.regs[addr] = value;
+            break;
+    }
+}
+
+// ==== SPI and GPIO drivers ====
+
+//------------------------------------
+static void unused(const char *what)
+{
+    host_assert_failed(what, __FILE__, __LINE__);
+}
+
+class host_spi_device_driver : public spi_device_driver, public heap_object, public free_object_access
+{
+public:
+    virtual void install() override
+    {
+    }
+
+    virtual void config_non_standard(uint32_t instruction_length, uint32_t address_length, uint32_t wait_cycles, spi_inst_addr_trans_mode_t trans_mode) override
+    {
+        instruction_length_ = instruction_length;
+        address_length_ = address_length;
+    }
+
+    virtual double set_clock_rate(double clock_rate) override
+    {
+        clock_rate_ = clock_rate;
+        return clock_rate;
+    }
+
+    virtual int read(gsl::span<uint8_t> buffer) override
+    {
+        unused("spi read");
+        return 0;
+    }
+
+    virtual int write(gsl::span<const uint8_t> buffer) override
+    {
+        // register write: address | 0x80, value
+        configASSERT((buffer.size() == 2) && (buffer[0] & 0x80));
+        transfer_time(2);
+        chip_write(buffer[0] & 0x7f, buffer[1]);
+        return 2;
+    }
+
+    virtual int transfer_full_duplex(gsl::span<const uint8_t> write_buffer, gsl::span<uint8_t> read_buffer) override
+    {
+        unused("spi transfer_full_duplex");
+        return 0;
+    }
+
+    virtual int transfer_sequential(gsl::span<const uint8_t> write_buffer, gsl::span<uint8_t> read_buffer) override
+    {
+        configASSERT((write_buffer.size() == 1) && !(write_buffer[0] & 0x80));
+        transfer_time(1 + read_buffer.size());
+        auto &chip = host_dm9051;
+        if (write_buffer[0] == REG_MRCMD) {
+            // burst read of the RX SRAM
+            for (auto &b : read_buffer) {
+                if (chip.rx_sram.empty()) {
+                    chip.stats.rx_underruns++;
+                    b = 0;
+                }
+                else {
+                    b = chip.rx_sram.front();
+                    chip.rx_sram.pop_front();
+                }
+            }
+        }
+        else {
+            configASSERT(read_buffer.size() == 1);
+            read_buffer[0] = chip_read(write_buffer[0]);
+        }
+        return read_buffer.size();
+    }
+
+    virtual void fill(uint32_t instruction, uint32_t address, uint32_t value, size_t count) override
+    {
+        unused("spi fill");
+    }
+
+    virtual bool set_xip_mode(bool enable) override
+    {
+        return false;
+    }
+
+    virtual int transfer_sequential_with_delay(gsl::span<const uint8_t> write_buffer, gsl::span<uint8_t> read_buffer, uint16_t delay) override
+    {
+        unused("spi transfer_sequential_with_delay");
+        return 0;
+    }
+
+    virtual void master_config_half_duplex(int8_t mosi, int8_t miso) override
+    {
+        unused("spi master_config_half_duplex");
+    }
+
+    virtual int write_with_instruction(uint32_t instruction, uint32_t address, gsl::span<const uint8_t> buffer) override
+    {
+        // burst write of the TX SRAM, the opcode is sent in the instruction phase
+        configASSERT((instruction == SPI_WR_BURST) && (instruction_length_ == 8) && (address_length_ == 0));
+        transfer_time(1 + buffer.size());
+        auto &chip = host_dm9051;
+        chip.tx_sram.insert(chip.tx_sram.end(), buffer.begin(), buffer.end());
+        return buffer.size();
+    }
+
+private:
+    void transfer_time(size_t bytes)
+    {
+        auto &stats = host_dm9051.stats;
+        configASSERT(clock_rate_ > 0);
+        uint64_t ns = HOST_SPI_OVERHEAD_NS + (uint64_t)(bytes * 8 * 1e9 / clock_rate_);
+        stats.spi_transfers++;
+        stats.spi_bytes += bytes;
+        stats.spi_ns += ns;
+        host_advance(ns);
+    }
+
+    uint32_t instruction_length_ = 0;
+    uint32_t address_length_ = 0;
+    double clock_rate_ = 0;
+};
+
+class host_spi_driver : public spi_driver, public static_object, public free_object_access
+{
+public:
+    virtual void install() override
+    {
+    }
+
+    virtual object_ptr<spi_device_driver> get_device(spi_mode_t mode, spi_frame_format_t frame_format, uint32_t chip_select_mask, uint32_t data_bit_length) override
+    {
+        configASSERT((mode == SPI_MODE_0) && (frame_format == SPI_FF_STANDARD) && (data_bit_length == 8));
+        return make_object<host_spi_device_driver>();
+    }
+
+    virtual void slave_config(size_t data_bit_length, uint8_t *data, uint32_t len, uint32_t ro_len, spi_slave_receive_callback_t callback, spi_slave_csum_callback_t csum_callback, int priority, int mosi, int miso) override
+    {
+        unused("spi slave_config");
+    }
+
+    virtual void slave_deinit() override
+    {
+        unused("spi slave_deinit");
+    }
+};
+
+class host_gpio_driver : public gpio_driver, public static_object, public free_object_access
+{
+public:
+    virtual void install() override
+    {
+    }
+
+    virtual uint32_t get_pin_count() override
+    {
+        return 32;
+    }
+
+    virtual void set_drive_mode(uint32_t pin, gpio_drive_mode_t mode) override
+    {
+        configASSERT(mode == GPIO_DM_INPUT);
+    }
+
+    virtual void set_pin_edge(uint32_t pin, gpio_pin_edge_t edge) override
+    {
+        configASSERT(edge == GPIO_PE_FALLING);
+    }
+
+    virtual void set_on_changed(uint32_t pin, gpio_on_changed_t callback, void *userdata) override
+    {
+        host_dm9051.int_handler = callback;
+        host_dm9051.int_userdata = userdata;
+    }
+
+    virtual gpio_pin_value_t get_pin_value(uint32_t pin) override
+    {
+        return host_dm9051.int_low ? GPIO_PV_LOW : GPIO_PV_HIGH;
+    }
+
+    virtual void set_pin_value(uint32_t pin, gpio_pin_value_t value) override
+    {
+        unused("gpio set_pin_value");
+    }
+};
+
+// ==== Handles ====
+
+#define HANDLE_OFFSET   (1)
+#define MAX_HANDLES     (8)
+
+static object_accessor<object_access> handles_[MAX_HANDLES];
+static size_t handle_count_;
+static host_spi_driver spi_;
+static host_gpio_driver gpio_;
+
+//----------------------------------------------------------------
+handle_t sys::system_alloc_handle(object_accessor<object_access> object)
+{
+    configASSERT(handle_count_ < MAX_HANDLES);
+    handles_[handle_count_] = std::move(object);
+    return HANDLE_OFFSET + handle_count_++;
+}
+
+//---------------------------------------------------------------------
+object_accessor<object_access> &sys::system_handle_to_object(handle_t file)
+{
+    configASSERT((file >= HANDLE_OFFSET) && (file < HANDLE_OFFSET + handle_count_));
+    return handles_[file - HANDLE_OFFSET];
+}
+
+//----------------------------------------------
+handle_t host_install(const mac_address_t &mac)
+{
+    // close the driver of the previous test
+    while (handle_count_) handles_[--handle_count_] = object_accessor<object_access>();
+
+    auto &chip = host_dm9051;
+    now_ns = 0;
+    chip.link_mbps = 100;
+    chip.int_low = false;
+    chip.rx_wire.clear();
+    chip.rx_wire_free = 0;
+    chip.on_tx = nullptr;
+    chip.int_handler = nullptr;
+    chip.idle = nullptr;
+    chip.idle_at = 0;
+    chip_reset();
+    memset(&chip.stats, 0, sizeof(chip.stats));
+
+    handle_t spi = system_alloc_handle(make_accessor(object_ptr<object_access>(&spi_)));
+    handle_t gpio = system_alloc_handle(make_accessor(object_ptr<object_access>(&gpio_)));
+    handle_t adapter = dm9051_driver_install(spi, 1, gpio, 0, &mac);
+    configASSERT(adapter != NULL_HANDLE);
+    return adapter;
+}
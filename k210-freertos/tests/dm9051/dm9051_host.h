@@ -0,0 +1,119 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Simulated DM9051 board for the host tests and benchmarks of the DM9051 driver
+//
+// The driver talks to the chip model through stand-ins of the SDK's SPI and GPIO drivers.
+// Everything runs on one thread against a virtual clock, which is advanced by
+//  - the SPI transfers: the bytes at the device clock rate, plus HOST_SPI_OVERHEAD_NS per transfer
+//  - usleep() and the blocking semaphore takes, up to the next chip event or the timeout,
+//    the 'idle' task is run first
+//  - host_advance() called by the harness
+// The chip events are the end of a frame on the wire and the arrival of received frames.
+// The INT pin is low while any enabled ISR status is set, the driver's handler is called on its falling edge.
+
+#ifndef _DM9051_HOST_H_
+#define _DM9051_HOST_H_
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <osdefs.h>
+
+// Time the K210 SPI driver needs to set up and finish a transfer, beyond the bits on the bus (assumed)
+#define HOST_SPI_OVERHEAD_NS    (2000)
+// DM9051 RX SRAM (SMCR_DEFAULT: 13 KB), frames which don't fit are dropped
+#define HOST_RX_SRAM_SIZE       (13 * 1024)
+
+struct host_chip_stats {
+    uint64_t spi_transfers;
+    uint64_t spi_bytes;
+    uint64_t spi_ns;            // time spent in SPI transfers
+    uint64_t tcr_reads;         // TCR register reads
+    uint64_t tx_frames;
+    uint64_t tx_errors;         // TXREQ with a length different from the written data
+    uint64_t rx_frames;
+    uint64_t rx_dropped;        // RX SRAM full
+    uint64_t rx_underruns;      // reads past the end of the received data
+    uint64_t int_edges;
+    uint64_t take_timeouts;     // blocking semaphore takes which timed out
+    uint64_t spin_ns;           // time in usleep(), a busy loop on the K210
+};
+
+struct host_chip {
+    uint8_t regs[256];
+    uint8_t isr;
+    bool int_low;
+    int link_mbps;                      // 100 or 10
+    std::vector<uint8_t> tx_sram;       // written since the last TXREQ
+    uint64_t tx_done_at;                // 0: no frame on the wire
+    std::vector<uint8_t> tx_frame;
+    std::deque<uint8_t> rx_sram;        // received frames with their 4-byte headers
+    std::deque<std::pair<uint64_t, std::vector<uint8_t>>> rx_wire;      // frames arriving at the given time
+    uint64_t rx_wire_free;              // end of the last arriving frame
+    std::function<void(const std::vector<uint8_t> &frame)> on_tx;       // frame sent on the wire
+    gpio_on_changed_t int_handler;
+    void *int_userdata;
+    std::function<void()> idle;         // lower priority task (the poll thread), run while a take sleeps
+    uint64_t idle_at;                   // and the clock has reached this time
+    host_chip_stats stats;
+};
+
+extern host_chip host_dm9051;
+
+// Resets the virtual clock and the chip, returns the handle of the installed DM9051 driver
+handle_t host_install(const mac_address_t &mac);
+uint64_t host_now_ns(void);
+// Advances the virtual clock by 'ns', runs the chip events on the way
+void host_advance(uint64_t ns);
+// Next chip event, UINT64_MAX if none
+uint64_t host_next_event(void);
+// Queues a frame (without CRC) received from the wire, it arrives after the previous one at the link rate
+void host_receive(const uint8_t *frame, size_t len);
+// Time a frame of 'len' bytes (without CRC) takes on the wire, with the preamble and the inter-frame gap
+uint64_t host_wire_ns(size_t len);
+
+// TAP interface of the host, the wire of the benchmark (dm9051_tap.cpp)
+#define TAP_HOST_IP             "192.168.151.1"
+#define TAP_BOARD_IP            "192.168.151.2"
+#define TAP_IPERF_PORT          (5001)
+
+// Creates the interface with the host address and the socket for the board's iperf client, false if it can't
+bool tap_open(void);
+// Reads a frame, 0 if there is none
+int tap_read(uint8_t *frame, size_t size);
+void tap_write(const uint8_t *frame, size_t len);
+// Waits up to 'ms' for a frame
+void tap_wait(int ms);
+// Starts the host side of a test in a thread: sends 'size' bytes to the board's iperf server,
+// or receives from the board's iperf client until it closes the connection
+void tap_start_peer(bool send, size_t size);
+// True when the host side has closed its socket
+bool tap_peer_done(void);
+void tap_join_peer(void);
+
+#endif
@@ -0,0 +1,165 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// TAP interface and host side of the DM9051 benchmark, apart from bench_dm9051.cpp
+// as the host's socket headers and lwIP's can't be used together
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <atomic>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+#include "dm9051_host.h"
+
+#define TAP_NAME    "dm9051tap0"
+
+static int tap = -1;
+static int listener = -1;
+static pthread_t peer;
+static size_t peer_size;
+static std::atomic<bool> peer_done;
+
+//-----------------------------------------------------
+static void set_address(struct sockaddr_in *addr, const char *ip)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons(TAP_IPERF_PORT);
+    inet_pton(AF_INET, ip, &addr->sin_addr);
+}
+
+//-----------------
+bool tap_open()
+{
+    tap = open("/dev/net/tun", O_RDWR | O_NONBLOCK);
+    if (tap < 0) return false;
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+    strncpy(ifr.ifr_name, TAP_NAME, IFNAMSIZ - 1);
+    if (ioctl(tap, TUNSETIFF, &ifr) < 0) return false;
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in *addr = (struct sockaddr_in *)&ifr.ifr_addr;
+    set_address(addr, TAP_HOST_IP);
+    addr->sin_port = 0;
+    bool ok = (ioctl(sock, SIOCSIFADDR, &ifr) == 0);
+    inet_pton(AF_INET, "255.255.255.0", &addr->sin_addr);
+    ok = ok && (ioctl(sock, SIOCSIFNETMASK, &ifr) == 0);
+    ok = ok && (ioctl(sock, SIOCGIFFLAGS, &ifr) == 0);
+    ifr.ifr_flags |= IFF_UP | IFF_RUNNING;
+    ok = ok && (ioctl(sock, SIOCSIFFLAGS, &ifr) == 0);
+    close(sock);
+    if (!ok) return false;
+
+    struct sockaddr_in listen_addr;
+    set_address(&listen_addr, TAP_HOST_IP);
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    return (bind(listener, (struct sockaddr *)&listen_addr, sizeof(listen_addr)) == 0) && (listen(listener, 1) == 0);
+}
+
+//----------------------------------------
+int tap_read(uint8_t *frame, size_t size)
+{
+    ssize_t n = read(tap, frame, size);
+    return (n > 0) ? n : 0;
+}
+
+//-----------------------------------------------
+void tap_write(const uint8_t *frame, size_t len)
+{
+    (void)!write(tap, frame, len);
+}
+
+//---------------------
+void tap_wait(int ms)
+{
+    struct pollfd pfd = { tap, POLLIN, 0 };
+    poll(&pfd, 1, ms);
+}
+
+//-------------------------------
+static void *peer_send(void *arg)
+{
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    set_address(&addr, TAP_BOARD_IP);
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        // iperf settings (no answer test), then the data
+        uint8_t *buf = (uint8_t *)calloc(1, peer_size);
+        for (size_t pos = 0; pos < peer_size; ) {
+            ssize_t n = send(sock, buf + pos, peer_size - pos, 0);
+            if (n <= 0) break;
+            pos += n;
+        }
+        free(buf);
+    }
+    close(sock);
+    peer_done = true;
+    return NULL;
+}
+
+//----------------------------------
+static void *peer_receive(void *arg)
+{
+    int sock = accept(listener, NULL, NULL);
+    static uint8_t buf[65536];
+    while (recv(sock, buf, sizeof(buf), 0) > 0) ;
+    close(sock);
+    peer_done = true;
+    return NULL;
+}
+
+//------------------------------------------
+void tap_start_peer(bool send, size_t size)
+{
+    peer_size = size;
+    peer_done = false;
+    pthread_create(&peer, NULL, send ? peer_send : peer_receive, NULL);
+}
+
+//----------------------
+bool tap_peer_done()
+{
+    return peer_done;
+}
+
+//---------------------
+void tap_join_peer()
+{
+    pthread_join(peer, NULL);
+}
@@ -0,0 +1,67 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Host build of the DM9051 driver (lib/drivers/src/network/dm9051.cpp)
+// The FreeRTOS include guards are kept, so the SDK headers included with quotes are skipped.
+// The harness runs on one thread against a virtual clock (dm9051_host.cpp), a tick is one millisecond.
+// A blocking take advances the clock to the next event of the simulated chip or to the timeout.
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint64_t TickType_t;
+
+#define pdFALSE                     0
+#define pdTRUE                      1
+#define pdFAIL                      0
+#define pdPASS                      1
+#define portMAX_DELAY               ((TickType_t)-1)
+#define configTICK_RATE_HZ          ((TickType_t)1000)
+#define portTICK_PERIOD_MS          1
+#define pdMS_TO_TICKS(ms)           ((TickType_t)(ms))
+#define portYIELD_FROM_ISR()
+
+void host_assert_failed(const char *expr, const char *file, int line);
+#define configASSERT(x)             do { if (!(x)) host_assert_failed(#x, __FILE__, __LINE__); } while (0)
+
+typedef struct host_task *TaskHandle_t;
+typedef struct host_semaphore *SemaphoreHandle_t;
+typedef SemaphoreHandle_t xSemaphoreHandle;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
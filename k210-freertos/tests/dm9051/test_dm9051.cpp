@@ -0,0 +1,288 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host tests of the DM9051 driver (lib/drivers/src/network/dm9051.cpp) against the simulated chip
+ * The frames go through the driver as network.cpp passes them: TX from a chain of pbufs,
+ * RX into a chain of pool pbufs (PBUF_POOL_BUFSIZE of the SDK's lwIP options: 592 bytes).
+ * A frame is written over SPI at 20 MHz in about half the time it takes on a 10 Mbit wire,
+ * the next one then waits in begin_send() for the TX complete interrupt.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <kernel/driver.hpp>
+#include "dm9051_host.h"
+
+using namespace sys;
+
+static int failed = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failed++; \
+        return; \
+    } } while (0)
+
+#define POOL_BUFSIZE    592
+#define IMR_DEFAULT     (0x83)      // PAR | PTM | PRM
+#define NS_PER_TICK     (1000000ULL)
+
+static const mac_address_t mac = { { 0x02, 0x00, 0x00, 0x51, 0x90, 0x01 } };
+static SemaphoreHandle_t interrupt_event;
+static std::vector<std::vector<uint8_t>> sent;
+
+static std::vector<uint8_t> make_frame(size_t len, uint8_t seed)
+{
+    std::vector<uint8_t> frame(len);
+    for (size_t i = 0; i < len; i++) frame[i] = (uint8_t)(seed + i * 7);
+    return frame;
+}
+
+// Installs the driver on a new chip and resets it, as network.cpp does when the interface is added
+static network_adapter_driver *open_adapter(int link_mbps)
+{
+    handle_t handle = host_install(mac);
+    host_dm9051.link_mbps = link_mbps;
+    sent.clear();
+    host_dm9051.on_tx = [](const std::vector<uint8_t> &frame) { sent.push_back(frame); };
+    while (xSemaphoreTake(interrupt_event, 0)) ;
+    auto adapter = system_handle_to_object(handle).as<network_adapter_driver>();
+    adapter->reset(interrupt_event);
+    return adapter;
+}
+
+// low_level_output(): one send() per pbuf of the chain
+static void send_frame(network_adapter_driver *adapter, const std::vector<uint8_t> &frame)
+{
+    adapter->begin_send(frame.size());
+    for (size_t pos = 0; pos < frame.size(); pos += POOL_BUFSIZE) {
+        size_t len = std::min(frame.size() - pos, (size_t)POOL_BUFSIZE);
+        adapter->send({ frame.data() + pos, (ptrdiff_t)len });
+    }
+    adapter->end_send();
+}
+
+// low_level_input(): one receive() per pool pbuf, 'max' bytes at most (no more pbufs)
+static std::vector<uint8_t> receive_frame(network_adapter_driver *adapter, size_t max = SIZE_MAX)
+{
+    size_t len = adapter->begin_receive();
+    std::vector<uint8_t> frame(std::min(len, max));
+    for (size_t pos = 0; pos < frame.size(); pos += POOL_BUFSIZE) {
+        size_t n = std::min(frame.size() - pos, (size_t)POOL_BUFSIZE);
+        adapter->receive({ frame.data() + pos, (ptrdiff_t)n });
+    }
+    adapter->end_receive();
+    return frame;
+}
+
+static void test_reset()
+{
+    auto adapter = open_adapter(100);
+    CHECK(host_dm9051.regs[0x7F] == IMR_DEFAULT, "IMR %02x", host_dm9051.regs[0x7F]);
+    CHECK(host_dm9051.regs[0x05] & 0x01, "RX not enabled");
+    CHECK(memcmp(&host_dm9051.regs[0x10], mac.data, 6) == 0, "MAC address not set");
+    CHECK(adapter->interface_check(), "no link");
+    CHECK(!adapter->is_packet_available(), "packet available");
+}
+
+static void test_send()
+{
+    auto adapter = open_adapter(100);
+    auto frame = make_frame(1514, 1);
+    send_frame(adapter, frame);
+    host_advance(host_wire_ns(frame.size()));
+    CHECK(sent.size() == 1, "%d frame(s) sent", (int)sent.size());
+    CHECK(sent[0] == frame, "frame data differs");
+    CHECK(host_dm9051.stats.tx_errors == 0, "TX length differs from the data written");
+}
+
+// The next frame is written while the previous one is on the wire, begin_send() sleeps until it's sent
+static void test_send_wait()
+{
+    auto adapter = open_adapter(10);
+    auto frame = make_frame(1514, 2);
+    send_frame(adapter, frame);
+    uint64_t done = host_now_ns() + host_wire_ns(frame.size());
+    uint64_t tcr_reads = host_dm9051.stats.tcr_reads;
+    adapter->begin_send(frame.size());
+    uint64_t waited = host_now_ns();
+    CHECK(waited >= done, "begin_send() returned %llu us before the end of the frame", (unsigned long long)(done - waited) / 1000);
+    CHECK(waited - done < 10000, "begin_send() returned %llu us after the end of the frame", (unsigned long long)(waited - done) / 1000);
+    CHECK(host_dm9051.stats.tcr_reads - tcr_reads <= 2, "%llu TCR reads while waiting", (unsigned long long)(host_dm9051.stats.tcr_reads - tcr_reads));
+    CHECK(host_dm9051.stats.take_timeouts == 0, "woken by the timeout");
+
+    adapter->send({ frame });
+    adapter->end_send();
+
+    // back to back frames, the INT edges stay in step with the frames
+    for (int i = 0; i < 20; i++) {
+        frame = make_frame(60 + i * 70, 3 + i);
+        send_frame(adapter, frame);
+    }
+    host_advance(host_wire_ns(frame.size()));
+    CHECK(sent.size() == 22, "%d frame(s) sent", (int)sent.size());
+    CHECK(sent[21] == frame, "frame data differs");
+    CHECK(host_dm9051.stats.tx_errors == 0, "TX length differs from the data written");
+    CHECK(host_dm9051.stats.take_timeouts == 0, "%llu wait(s) woken by the timeout", (unsigned long long)host_dm9051.stats.take_timeouts);
+}
+
+// poll_thread() of network.cpp
+static network_adapter_driver *poll_adapter;
+static std::vector<std::vector<uint8_t>> received;
+
+static void poll_thread()
+{
+    if (xSemaphoreTake(interrupt_event, 0) && poll_adapter->interface_check()) {
+        poll_adapter->disable_rx();
+        while (poll_adapter->is_packet_available()) received.push_back(receive_frame(poll_adapter));
+        poll_adapter->enable_rx();
+    }
+}
+
+// A frame received while begin_send() waits holds INT low, the end of the sent frame gives no edge.
+// The poll thread, getting the CPU 100 us later, clears both statuses and wakes the sender.
+// Without it, begin_send() returns on the timeout.
+static void test_send_int_held_low()
+{
+    for (int poll = 1; poll >= 0; poll--) {
+        auto adapter = open_adapter(10);
+        auto frame = make_frame(1514, 4);
+        send_frame(adapter, frame);
+        uint64_t done = host_now_ns() + host_wire_ns(frame.size());
+        auto rx = make_frame(100, 5);
+        host_receive(rx.data(), rx.size());
+        received.clear();
+        if (poll) {
+            poll_adapter = adapter;
+            host_dm9051.idle = poll_thread;
+            host_dm9051.idle_at = done + 100000;
+        }
+        adapter->begin_send(frame.size());
+        host_dm9051.idle = nullptr;
+        uint64_t waited = host_now_ns();
+        uint64_t edges = host_dm9051.stats.int_edges;
+        CHECK(waited >= done, "begin_send() returned before the end of the frame");
+        if (poll) {
+            CHECK(waited - done < 200000, "begin_send() returned %llu us after the end of the frame", (unsigned long long)(waited - done) / 1000);
+            CHECK(host_dm9051.stats.take_timeouts == 0, "woken by the timeout");
+            CHECK((received.size() == 1) && std::equal(rx.begin(), rx.end(), received[0].begin()), "frame not received");
+        }
+        else {
+            CHECK(waited - done <= 10 * NS_PER_TICK, "begin_send() returned %llu us after the end of the frame", (unsigned long long)(waited - done) / 1000);
+            CHECK(host_dm9051.stats.take_timeouts == 1, "not woken by the timeout");
+        }
+        CHECK(edges == 1, "%llu INT edge(s)", (unsigned long long)edges);
+    }
+}
+
+static void test_receive()
+{
+    auto adapter = open_adapter(100);
+    auto frame1 = make_frame(60, 6);
+    auto frame2 = make_frame(1514, 7);
+    host_receive(frame1.data(), frame1.size());
+    host_receive(frame2.data(), frame2.size());
+    host_advance(host_wire_ns(frame1.size()) + host_wire_ns(frame2.size()));
+    CHECK(xSemaphoreTake(interrupt_event, 0), "no interrupt");
+
+    // poll_thread()
+    CHECK(adapter->interface_check(), "no link");
+    adapter->disable_rx();
+    CHECK(!host_dm9051.int_low, "INT still low");
+    CHECK(adapter->is_packet_available(), "no packet available");
+    auto rx1 = receive_frame(adapter);
+    CHECK(adapter->is_packet_available(), "no packet available");
+    auto rx2 = receive_frame(adapter);
+    CHECK(!adapter->is_packet_available(), "packet available");
+    adapter->enable_rx();
+
+    // the length includes the CRC
+    CHECK((rx1.size() == frame1.size() + 4) && std::equal(frame1.begin(), frame1.end(), rx1.begin()), "frame 1 differs");
+    CHECK((rx2.size() == frame2.size() + 4) && std::equal(frame2.begin(), frame2.end(), rx2.begin()), "frame 2 differs");
+    CHECK(host_dm9051.stats.rx_underruns == 0, "read past the received data");
+    CHECK(host_dm9051.regs[0x7F] == IMR_DEFAULT, "IMR %02x", host_dm9051.regs[0x7F]);
+}
+
+// No pbuf for the rest of the frame: end_receive() drops it, the next frame is read from its header
+static void test_receive_drop()
+{
+    auto adapter = open_adapter(100);
+    auto frame1 = make_frame(1000, 8);
+    auto frame2 = make_frame(200, 9);
+    host_receive(frame1.data(), frame1.size());
+    host_receive(frame2.data(), frame2.size());
+    host_advance(host_wire_ns(frame1.size()) + host_wire_ns(frame2.size()));
+    adapter->disable_rx();
+    CHECK(adapter->is_packet_available(), "no packet available");
+    receive_frame(adapter, 14);
+    CHECK(adapter->is_packet_available(), "no packet available after the dropped frame");
+    auto rx2 = receive_frame(adapter);
+    CHECK((rx2.size() == frame2.size() + 4) && std::equal(frame2.begin(), frame2.end(), rx2.begin()), "frame 2 differs");
+    CHECK(!adapter->is_packet_available(), "packet available");
+    adapter->enable_rx();
+}
+
+// A frame received while the poll thread drains the RX SRAM is signalled when the interrupts are enabled again
+static void test_receive_during_drain()
+{
+    auto adapter = open_adapter(100);
+    while (xSemaphoreTake(interrupt_event, 0)) ;
+    adapter->disable_rx();
+    auto frame = make_frame(300, 10);
+    host_receive(frame.data(), frame.size());
+    host_advance(host_wire_ns(frame.size()));
+    CHECK(!xSemaphoreTake(interrupt_event, 0), "interrupt while disabled");
+    adapter->enable_rx();
+    CHECK(xSemaphoreTake(interrupt_event, 0), "no interrupt after enable_rx()");
+    adapter->disable_rx();
+    auto rx = receive_frame(adapter);
+    CHECK(std::equal(frame.begin(), frame.end(), rx.begin()), "frame differs");
+    adapter->enable_rx();
+}
+
+int main()
+{
+    interrupt_event = xSemaphoreCreateBinary();
+    test_reset();
+    test_send();
+    test_send_wait();
+    test_send_int_held_low();
+    test_receive();
+    test_receive_drop();
+    test_receive_during_drain();
+    if (failed) {
+        printf("dm9051: %d test(s) failed\n", failed);
+        return 1;
+    }
+    printf("dm9051: OK\n");
+    return 0;
+}
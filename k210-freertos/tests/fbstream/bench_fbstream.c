@@ -0,0 +1,104 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host benchmark of the frame buffer stream encoder (display/fbstream.c)
+ * Compression ratio and encoding speed of the synthetic 320x240 frames,
+ * 1024 bytes chunks as the FBstream() default; the time is the best of 'BENCH_RUNS' runs.
+ * Every encoded frame is checked with the reference decoder.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "fbstream_reference.h"
+
+#define BENCH_RUNS  50
+
+static uint8_t out_buf[FB_W * FB_H * 4];
+static int out_len;
+
+static int out_write(void *ctx, const uint8_t *buf, int len)
+{
+    (void)ctx;
+    memcpy(out_buf + out_len, buf, len);
+    out_len += len;
+    return 0;
+}
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+static color_t fb[FB_W * FB_H], ref[FB_W * FB_H], ref_run[FB_W * FB_H], canvas[FB_W * FB_H];
+static uint8_t chunk[1024];
+
+// Encode 'fb' (against 'refp' if not NULL), print the size and speed
+static int bench(const char *name, color_t *refp)
+{
+    double best = 1e30;
+    int n = 0;
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        if (refp) memcpy(ref_run, refp, sizeof(ref_run));
+        out_len = 0;
+        double t0 = now_us();
+        n = fb_stream_encode(fb, (refp) ? ref_run : NULL, FB_W, 0, 0, FB_W, FB_H, chunk, sizeof(chunk), out_write, NULL);
+        double t = now_us() - t0;
+        if (t < best) best = t;
+    }
+    if (refp) memcpy(canvas, refp, sizeof(canvas));
+    int ok = (ref_decode(out_buf, out_len, canvas, FB_W) == 0) && (memcmp(canvas, fb, sizeof(fb)) == 0);
+    int raw = FB_W * FB_H * sizeof(color_t);
+    printf("%-24s %7d %7d %7.1f:1 %8.0f %s\n", name, raw, n, (double)raw / n, raw / best, (ok) ? "OK" : "DECODE FAILED");
+    return ok;
+}
+
+int main(void)
+{
+    int ok = 1;
+    printf("%-24s %7s %7s %9s %8s\n", "frame", "raw", "encoded", "ratio", "MB/s");
+    ref_frame_dashboard(fb, 0);
+    ok &= bench("HMI dashboard", NULL);
+    ref_frame_menu(fb);
+    ok &= bench("menu on gradient", NULL);
+    ref_frame_photo(fb);
+    ok &= bench("photo", NULL);
+    ref_frame_noise(fb, 1);
+    ok &= bench("noise (worst case)", NULL);
+
+    // consecutive dashboard frames, each one against the previous
+    ref_frame_dashboard(ref, 0);
+    for (int v = 1; v < 4; v++) {
+        char name[32];
+        ref_frame_dashboard(fb, v);
+        snprintf(name, sizeof(name), "dashboard delta %d", v);
+        ok &= bench(name, ref);
+        memcpy(ref, fb, sizeof(ref));
+    }
+    return (ok) ? 0 : 1;
+}
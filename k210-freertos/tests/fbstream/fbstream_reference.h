@@ -0,0 +1,203 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Reference decoder of the frame buffer stream (the format is documented in fbstream.h)
+ * and the synthetic 320x240 RGB565 test frames used by the tests and the benchmark
+ */
+#ifndef _FBSTREAM_REFERENCE_H_
+#define _FBSTREAM_REFERENCE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "fbstream.h"
+
+#define FB_W    320
+#define FB_H    240
+
+#define RGB565(r, g, b) ((color_t)((((r) >> 3) << 11) | (((g) >> 2) << 5) | ((b) >> 3)))
+#define REF_HASH(c)     (((((c) >> 11) * 3) + ((((c) >> 5) & 0x3F) * 5) + (((c) & 0x1F) * 7)) & 0x3F)
+
+// Decode the stream 'p' of 'n' bytes into 'canvas' ('stride' pixels per row)
+// Returns 0 on success or the negative error code
+static inline int ref_decode(const uint8_t *p, int n, color_t *canvas, int stride)
+{
+    if ((n < FB_STREAM_HEADER_SIZE + 1) || (memcmp(p, "Q565", 4) != 0)) return -1;
+    int delta = p[4] & FB_STREAM_FLAG_DELTA;
+    int x = p[6] | (p[7] << 8), y = p[8] | (p[9] << 8);
+    int w = p[10] | (p[11] << 8), h = p[12] | (p[13] << 8);
+    const uint8_t *q = p + FB_STREAM_HEADER_SIZE, *end = p + n;
+    color_t index[64] = { 0 }, prev = 0;
+    long i = 0, total = (long)w * h;
+
+    #define REF_AT(k)   canvas[(y + (k) / w) * stride + x + (k) % w]
+    #define REF_PUT(c)  do { if (i >= total) return -3; REF_AT(i) = (c); i++; } while (0)
+    while (q < end) {
+        uint8_t op = *q++;
+        if (op == 0xFF) break;
+        if (op == 0xFE) {
+            prev = q[0] | (q[1] << 8);
+            q += 2;
+            index[REF_HASH(prev)] = prev;
+            REF_PUT(prev);
+        }
+        else if ((op >= 0xC0) && (op <= 0xDE)) {
+            int cnt = (op & 0x1F) + 1;
+            if (op == 0xDE) {
+                cnt = q[0] | (q[1] << 8);
+                q += 2;
+            }
+            while (cnt--) REF_PUT(prev);
+        }
+        else if (op >= 0xDF) {
+            if (!delta) return -2;
+            int cnt = (op & 0x1F) + 1;
+            if (op == 0xDF) {
+                cnt = q[0] | (q[1] << 8);
+                q += 2;
+            }
+            i += cnt;
+            if (i > total) return -3;
+            prev = REF_AT(i - 1);
+        }
+        else if ((op & 0xC0) == 0x00) {
+            prev = index[op];
+            REF_PUT(prev);
+        }
+        else {
+            int r = prev >> 11, g = (prev >> 5) & 0x3F, b = prev & 0x1F;
+            if ((op & 0xC0) == 0x40) {
+                r += ((op >> 4) & 3) - 2;
+                g += ((op >> 2) & 3) - 2;
+                b += (op & 3) - 2;
+            }
+            else {
+                int dg = (op & 0x3F) - 32;
+                g += dg;
+                r += (*q >> 4) - 8 + (dg >> 1);
+                b += (*q & 0x0F) - 8 + (dg >> 1);
+                q++;
+            }
+            if ((r < 0) || (r > 31) || (g < 0) || (g > 63) || (b < 0) || (b > 31)) return -5;
+            prev = (r << 11) | (g << 5) | b;
+            index[REF_HASH(prev)] = prev;
+            REF_PUT(prev);
+        }
+    }
+    #undef REF_PUT
+    #undef REF_AT
+    return ((i == total) && (q == end)) ? 0 : -4;
+}
+
+static inline uint32_t ref_rand(uint32_t *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 8;
+}
+
+static inline void ref_rect(color_t *fb, int x, int y, int w, int h, color_t c)
+{
+    for (int r = y; r < y + h; r++)
+        for (int k = x; k < x + w; k++) fb[r * FB_W + k] = c;
+}
+
+// 5x7 pseudo glyphs, like the text drawn with the bitmap fonts
+static inline void ref_text(color_t *fb, int x, int y, const char *s, color_t fg)
+{
+    for (; *s; s++, x += 7) {
+        uint32_t seed = (uint8_t)*s;
+        for (int r = 0; r < 7; r++) {
+            uint32_t bits = ref_rand(&seed);
+            for (int k = 0; k < 5; k++) {
+                if ((*s != ' ') && (bits & (1 << k))) fb[(y + r) * FB_W + x + k] = fg;
+            }
+        }
+    }
+}
+
+// HMI dashboard: title bar, value boxes, gauge with the needle and status lamps,
+// 'v' changes the values, the needle and the lamps like consecutive frames
+static inline void ref_frame_dashboard(color_t *fb, int v)
+{
+    char txt[24];
+    ref_rect(fb, 0, 0, FB_W, FB_H, RGB565(16, 24, 40));
+    ref_rect(fb, 0, 0, FB_W, 28, RGB565(0, 80, 160));
+    ref_text(fb, 8, 10, "LINE 3  PRESSURE", RGB565(255, 255, 255));
+    for (int i = 0; i < 4; i++) {
+        ref_rect(fb, 8 + i * 78, 40, 70, 70, RGB565(200, 200, 200));
+        ref_rect(fb, 9 + i * 78, 41, 68, 68, RGB565(40, 40, 60));
+        snprintf(txt, sizeof(txt), "%d.%d", (v * 7 + i * 13) % 100, i);
+        ref_text(fb, 20 + i * 78, 70, txt, RGB565(255, 220, 0));
+    }
+    for (int a = 0; a < 360; a++) {
+        double r = a * M_PI / 180;
+        for (int d = 56; d < 59; d++) fb[(int)(178 + d * sin(r)) * FB_W + (int)(160 + d * cos(r))] = RGB565(255, 255, 255);
+    }
+    double na = (200 + v * 3) * M_PI / 180;
+    for (int d = 0; d < 50; d++) ref_rect(fb, (int)(160 + d * cos(na)) - 1, (int)(178 + d * sin(na)) - 1, 3, 3, RGB565(255, 0, 0));
+    for (int i = 0; i < 20; i++) {
+        ref_rect(fb, 240 + (i % 4) * 18, 120 + (i / 4) * 22, 14, 16, ((i + v) % 3) ? RGB565(0, 200, 0) : RGB565(200, 0, 0));
+    }
+}
+
+// Menu items on the gradient background
+static inline void ref_frame_menu(color_t *fb)
+{
+    char txt[24];
+    for (int y = 0; y < FB_H; y++) ref_rect(fb, 0, y, FB_W, 1, RGB565(y / 2, 60 + y / 3, 200 - y / 2));
+    for (int i = 0; i < 5; i++) {
+        ref_rect(fb, 20, 20 + i * 42, 280, 32, RGB565(230, 230, 230));
+        snprintf(txt, sizeof(txt), "MENU ITEM %d", i);
+        ref_text(fb, 30, 32 + i * 42, txt, RGB565(0, 0, 0));
+    }
+}
+
+// Photo like content, smooth shapes with the sensor noise
+static inline void ref_frame_photo(color_t *fb)
+{
+    uint32_t seed = 7;
+    for (int y = 0; y < FB_H; y++) {
+        for (int x = 0; x < FB_W; x++) {
+            double l = 0.5 + 0.25 * sin(x / 23.0) * cos(y / 17.0) + 0.2 * sin((x + y) / 41.0);
+            int n = (int)(ref_rand(&seed) % 13) - 6;
+            int r = (int)(l * 220) + n, g = (int)(l * 180 + y / 4) + n, b = (int)(l * 120 + x / 5) + n;
+            r = (r < 0) ? 0 : (r > 255) ? 255 : r;
+            g = (g < 0) ? 0 : (g > 255) ? 255 : g;
+            b = (b < 0) ? 0 : (b > 255) ? 255 : b;
+            fb[y * FB_W + x] = RGB565(r, g, b);
+        }
+    }
+}
+
+// Worst case, random pixels
+static inline void ref_frame_noise(color_t *fb, uint32_t seed)
+{
+    for (int i = 0; i < FB_W * FB_H; i++) fb[i] = ref_rand(&seed);
+}
+
+#endif
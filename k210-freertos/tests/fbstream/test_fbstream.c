@@ -0,0 +1,211 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host tests of the frame buffer stream encoder (display/fbstream.c)
+ * Every frame is decoded with the reference decoder and must be pixel exact,
+ * for key and delta frames, rectangles and all chunk sizes.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "fbstream_reference.h"
+
+static int failed = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failed++; \
+        return; \
+    } } while (0)
+
+// Output collected from the chunks
+// (the counters are cleared before each frame, 'buf' must be the last member)
+typedef struct {
+    int len;
+    int n_writes;
+    int max_write;
+    int fail_at;        // the write number which fails, 0: never
+    uint8_t buf[FB_W * FB_H * 4];
+} out_t;
+
+static out_t out;
+
+static int out_write(void *ctx, const uint8_t *buf, int len)
+{
+    out_t *o = ctx;
+    o->n_writes++;
+    if ((o->fail_at) && (o->n_writes >= o->fail_at)) return -1;
+    memcpy(o->buf + o->len, buf, len);
+    o->len += len;
+    if (len > o->max_write) o->max_write = len;
+    return 0;
+}
+
+static color_t fb[FB_W * FB_H], ref[FB_W * FB_H], canvas[FB_W * FB_H];
+static uint8_t chunk[16384];
+
+static int encode(color_t *refp, int x, int y, int w, int h, int chunk_size)
+{
+    memset(&out, 0, sizeof(out_t) - sizeof(out.buf));
+    return fb_stream_encode(fb, refp, FB_W, x, y, w, h, chunk, chunk_size, out_write, &out);
+}
+
+static int rect_equal(const color_t *a, const color_t *b, int x, int y, int w, int h)
+{
+    for (int r = y; r < y + h; r++) {
+        if (memcmp(a + r * FB_W + x, b + r * FB_W + x, w * sizeof(color_t)) != 0) return 0;
+    }
+    return 1;
+}
+
+static void check_key_frame(const char *name, int x, int y, int w, int h, int chunk_size)
+{
+    memset(canvas, 0x55, sizeof(canvas));
+    int n = encode(NULL, x, y, w, h, chunk_size);
+    CHECK(n == out.len, "%s: returned %d, written %d", name, n, out.len);
+    CHECK(out.max_write <= chunk_size, "%s: write of %d bytes with %d chunk", name, out.max_write, chunk_size);
+    int res = ref_decode(out.buf, out.len, canvas, FB_W);
+    CHECK(res == 0, "%s: decode error %d", name, res);
+    CHECK(rect_equal(canvas, fb, x, y, w, h), "%s: decoded frame differs", name);
+    // nothing outside of the rectangle is touched
+    if (y > 0) CHECK(canvas[(y - 1) * FB_W + x] == 0x5555, "%s: pixel above the rectangle changed", name);
+    // at most 3 bytes per pixel (RGB565 literal), the header and the end
+    CHECK(n <= FB_STREAM_HEADER_SIZE + (3 * w * h) + 1, "%s: %d bytes for %d pixels", name, n, w * h);
+}
+
+static void test_key_frames(void)
+{
+    static const int chunks[] = { 64, 65, 100, 1024, 4096, 16384 };
+    for (int c = 0; c < 6; c++) {
+        ref_frame_dashboard(fb, 0);
+        check_key_frame("dashboard", 0, 0, FB_W, FB_H, chunks[c]);
+        check_key_frame("dashboard rect", 8, 40, 100, 70, chunks[c]);
+        check_key_frame("single pixel", 319, 239, 1, 1, chunks[c]);
+        ref_frame_menu(fb);
+        check_key_frame("menu", 0, 0, FB_W, FB_H, chunks[c]);
+        ref_frame_photo(fb);
+        check_key_frame("photo", 0, 0, FB_W, FB_H, chunks[c]);
+        ref_frame_noise(fb, c + 1);
+        check_key_frame("noise", 0, 0, FB_W, FB_H, chunks[c]);
+        check_key_frame("noise column", 100, 0, 1, FB_H, chunks[c]);
+    }
+}
+
+static void test_long_runs(void)
+{
+    // 76800 equal pixels, more than one 2-byte run length
+    ref_rect(fb, 0, 0, FB_W, FB_H, RGB565(10, 200, 30));
+    check_key_frame("single color", 0, 0, FB_W, FB_H, 64);
+    CHECK(out.len < 32, "single color frame is %d bytes", out.len);
+    // black frame, the previous pixel starts as 0
+    memset(fb, 0, sizeof(fb));
+    check_key_frame("black", 0, 0, FB_W, FB_H, 64);
+}
+
+static void test_extreme_diffs(void)
+{
+    // all DIFF and LUMA ranges around the component limits
+    uint32_t seed = 3;
+    for (int i = 0; i < FB_W * FB_H; i++) {
+        color_t p = (i > 0) ? fb[i - 1] : 0;
+        int r = (p >> 11) + (int)(ref_rand(&seed) % 21) - 10;
+        int g = ((p >> 5) & 0x3F) + (int)(ref_rand(&seed) % 71) - 35;
+        int b = (p & 0x1F) + (int)(ref_rand(&seed) % 21) - 10;
+        if ((ref_rand(&seed) & 7) == 0) { r = (r & 1) ? 31 : 0; g = (g & 1) ? 63 : 0; }
+        r = (r < 0) ? 0 : (r > 31) ? 31 : r;
+        g = (g < 0) ? 0 : (g > 63) ? 63 : g;
+        b = (b < 0) ? 0 : (b > 31) ? 31 : b;
+        fb[i] = (r << 11) | (g << 5) | b;
+    }
+    check_key_frame("diffs", 0, 0, FB_W, FB_H, 1024);
+}
+
+static void test_delta_frames(void)
+{
+    // the receiver and the encoder's reference both start cleared
+    memset(ref, 0, sizeof(ref));
+    memset(canvas, 0, sizeof(canvas));
+    for (int v = 0; v < 10; v++) {
+        ref_frame_dashboard(fb, v);
+        int n = encode(ref, 0, 0, FB_W, FB_H, 1024);
+        CHECK(n == out.len, "frame %d: returned %d, written %d", v, n, out.len);
+        CHECK(out.buf[4] & FB_STREAM_FLAG_DELTA, "frame %d: delta flag not set", v);
+        int res = ref_decode(out.buf, out.len, canvas, FB_W);
+        CHECK(res == 0, "frame %d: decode error %d", v, res);
+        CHECK(rect_equal(canvas, fb, 0, 0, FB_W, FB_H), "frame %d: decoded frame differs", v);
+        CHECK(rect_equal(ref, fb, 0, 0, FB_W, FB_H), "frame %d: reference not updated", v);
+    }
+    // unchanged frame is a single skip
+    int n = encode(ref, 0, 0, FB_W, FB_H, 1024);
+    CHECK(n < 32, "unchanged frame is %d bytes", n);
+    CHECK(ref_decode(out.buf, out.len, canvas, FB_W) == 0, "unchanged frame not decoded");
+
+    // delta of a rectangle, the rest of the reference is not touched
+    ref_frame_dashboard(fb, 20);
+    n = encode(ref, 8, 40, 100, 70, 64);
+    CHECK(ref_decode(out.buf, out.len, canvas, FB_W) == 0, "rectangle not decoded");
+    CHECK(rect_equal(canvas, fb, 8, 40, 100, 70), "rectangle differs");
+    CHECK(rect_equal(ref, canvas, 0, 0, FB_W, FB_H), "reference differs from the receiver");
+
+    // random changes between noisy frames
+    for (int v = 0; v < 5; v++) {
+        uint32_t seed = v + 100;
+        for (int i = 0; i < 3000; i++) fb[ref_rand(&seed) % (FB_W * FB_H)] = ref_rand(&seed);
+        encode(ref, 0, 0, FB_W, FB_H, 100);
+        CHECK(ref_decode(out.buf, out.len, canvas, FB_W) == 0, "noisy delta %d not decoded", v);
+        CHECK(rect_equal(canvas, fb, 0, 0, FB_W, FB_H), "noisy delta %d differs", v);
+    }
+}
+
+static void test_write_error(void)
+{
+    ref_frame_photo(fb);
+    for (int fail_at = 1; fail_at < 5; fail_at++) {
+        memset(&out, 0, sizeof(out_t) - sizeof(out.buf));
+        out.fail_at = fail_at;
+        int n = fb_stream_encode(fb, NULL, FB_W, 0, 0, FB_W, FB_H, chunk, 1024, out_write, &out);
+        CHECK(n == -1, "write error at %d not reported (%d)", fail_at, n);
+        CHECK(out.n_writes == fail_at, "writes continued after the error (%d)", out.n_writes);
+    }
+}
+
+int main(void)
+{
+    test_key_frames();
+    test_long_runs();
+    test_extreme_diffs();
+    test_delta_frames();
+    test_write_error();
+    if (failed) {
+        printf("fbstream: %d test(s) failed\n", failed);
+        return 1;
+    }
+    printf("fbstream: OK\n");
+    return 0;
+}
@@ -0,0 +1,49 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Host build of uos/file_xfer.c
+// Only the functions used by file_xfer.c are declared, they are implemented
+// by the device stand-in (xfer_device.c) over a pty
+
+#ifndef _MPHALPORT_H_
+#define _MPHALPORT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "py/ringbuf.h"
+
+typedef uintptr_t mp_uint_t;
+
+#define BLOCK_CTRL_READY    0x06
+
+void mp_hal_uarths_setirq_default();
+void mp_hal_uarths_setirq_ring(ringbuf_t *ring);
+int mp_hal_uarths_read_ring(ringbuf_t *ring, uint8_t *buf, int len, uint32_t timeout);
+uint16_t mp_hal_crc16(const uint8_t *buf, uint32_t count);
+void mp_hal_send_bytes(char *buf, int len);
+mp_uint_t mp_hal_ticks_ms(void);
+
+#endif
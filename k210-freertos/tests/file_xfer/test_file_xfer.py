@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+#
+# Tests of the windowed file transfer, MPyTerm.py against the device side
+# (uos/file_xfer.c) built for the host (xfer_device.c), connected by a pty
+#
+#   test_file_xfer.py xfer_device           run the tests
+#   test_file_xfer.py --bench xfer_device   measure the transfer speed
+#
+# The UART runs at 200 KB/s, writing a 2 KB block to the file system takes 8 ms
+#
+
+import os
+import sys
+import io
+import time
+import zlib
+import random
+import subprocess
+import importlib.util
+import serial
+
+spec = importlib.util.spec_from_file_location("MPyTerm", os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "MPyTerm.py"))
+MPyTerm = importlib.util.module_from_spec(spec)
+spec.loader.exec_module(MPyTerm)
+
+UART_RATE = 200000
+WRITE_US = 8000
+TMP_FILE = "xfer_device.bin"
+
+#-----------------------------------------------------------------------------------------
+def Transfer(device, to_device, data, window, deflate=False, error_rate=0.0, seed=1):
+    # Returns (host result, data received, device result, transfer time)
+    master, slave = os.openpty()
+    term = MPyTerm.PyTerm.__new__(MPyTerm.PyTerm)
+    term.uart = serial.Serial(os.ttyname(slave), 115200, timeout=0.1)
+
+    payload = data
+    zsize = 0
+    if deflate:
+        comp = zlib.compressobj(9, zlib.DEFLATED, -15)
+        payload = comp.compress(data) + comp.flush()
+        zsize = len(payload)
+    if not to_device:
+        with open(TMP_FILE, "wb") as f:
+            f.write(data)
+
+    args = [device, str(master), "get" if to_device else "send", TMP_FILE, str(len(data)), str(window),
+            str(zsize), str(UART_RATE), str(error_rate), str(WRITE_US), str(seed)]
+    dev = subprocess.Popen(args, pass_fds=[master], stderr=subprocess.PIPE)
+    start = time.time()
+    received = None
+    if to_device:
+        st = term.XferWaitStart(5)
+        res = term.XferSendData(payload, st[2], st[3] + (st[4] << 8)) if st else -3
+    else:
+        st = term.XferWaitStart(11)
+        if st and (term.crc_16(st[0:9]) == ((st[9] << 8) | st[10])):
+            out = io.BytesIO()
+            stdout = sys.stdout
+            sys.stdout = io.StringIO()
+            res = term.XferReceiveData(out, int.from_bytes(st[5:9], "little"), st[2], st[3] + (st[4] << 8))
+            sys.stdout = stdout
+            received = out.getvalue()
+        else:
+            res = -3
+    dev_res = dev.wait(timeout=30)
+    elapsed = time.time() - start
+    dev_msg = dev.stderr.read().decode().strip()
+    term.uart.close()
+    os.close(slave)
+    os.close(master)
+    if to_device:
+        with open(TMP_FILE, "rb") as f:
+            received = f.read()
+    os.remove(TMP_FILE)
+    return res, received, dev_res, elapsed, dev_msg
+
+#-----------------
+def TestData(size):
+    rnd = random.Random(size)
+    binary = bytes(rnd.getrandbits(8) for _ in range(size))
+    with open(MPyTerm.__file__, "rb") as f:
+        text = f.read()
+    text = (text * (size // len(text) + 1))[:size]
+    return binary, text
+
+#-----------------
+def Tests(device):
+    binary, text = TestData(60001)
+    cases = [
+        # name, to device, data, window, deflate, error rate
+        ("to device, window 8", True, binary, 8, False, 0.0),
+        ("to device, window 1", True, binary, 1, False, 0.0),
+        ("to device, window 16", True, binary, 16, False, 0.0),
+        ("to device, deflate", True, text, 8, True, 0.0),
+        ("to device, 1 byte", True, binary[:1], 8, False, 0.0),
+        ("to device, 1 block", True, binary[:2048], 8, False, 0.0),
+        ("from device, window 8", False, binary, 8, False, 0.0),
+        ("from device, window 1", False, binary, 1, False, 0.0),
+        ("from device, 1 byte", False, binary[:1], 8, False, 0.0),
+        ("to device, damaged bytes", True, binary, 8, False, 2e-4),
+        ("to device, deflate, damaged bytes", True, text, 8, True, 2e-4),
+        ("from device, damaged bytes", False, binary, 8, False, 2e-4),
+    ]
+    failed = 0
+    for name, to_device, data, window, deflate, error_rate in cases:
+        res, received, dev_res, elapsed, dev_msg = Transfer(device, to_device, data, window, deflate, error_rate)
+        if (res != 0) or (dev_res != 0) or (received != data):
+            print("FAIL {}: host result {}, device {}, data {}".format(name, res, dev_msg, "match" if received == data else "different"))
+            failed += 1
+    if failed:
+        print("file_xfer: {} test(s) failed".format(failed))
+        return 1
+    print("file_xfer: OK")
+    return 0
+
+#-----------------
+def Bench(device):
+    binary, text = TestData(200000)
+    print("Windowed file transfer, 200 KB, UART {} KB/s, {} ms per block write".format(UART_RATE // 1000, WRITE_US // 1000))
+    print("{:<14} {:>7} {:>8} {:>12} {:>10}".format("direction", "window", "deflate", "error rate", "KB/s"))
+    for to_device, window, deflate, error_rate in ((True, 1, False, 0.0), (True, 4, False, 0.0), (True, 8, False, 0.0),
+                                                   (True, 16, False, 0.0), (True, 8, True, 0.0), (True, 8, False, 1e-4),
+                                                   (False, 1, False, 0.0), (False, 8, False, 0.0), (False, 8, False, 1e-4)):
+        data = text if deflate else binary
+        res, received, dev_res, elapsed, dev_msg = Transfer(device, to_device, data, window, deflate, error_rate)
+        if (res != 0) or (dev_res != 0) or (received != data):
+            print("transfer failed: host result {}, device {}".format(res, dev_msg))
+            return 1
+        print("{:<14} {:>7} {:>8} {:>12g} {:>10.1f}".format("to device" if to_device else "from device", window,
+              "text" if deflate else "-", error_rate, len(data) / elapsed / 1024))
+    return 0
+
+if __name__ == '__main__':
+    if (len(sys.argv) == 3) and (sys.argv[1] == "--bench"):
+        sys.exit(Bench(sys.argv[2]))
+    if len(sys.argv) != 2:
+        print("usage: test_file_xfer.py [--bench] xfer_device")
+        sys.exit(2)
+    sys.exit(Tests(sys.argv[1]))
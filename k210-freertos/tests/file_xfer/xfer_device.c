@@ -0,0 +1,287 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host stand-in of the device side of the windowed file transfer (uos/file_xfer.c)
+ *
+ * Runs the receive loop of os.get_file() (optionally decompressing the raw
+ * deflate stream with uzlib) or the send loop of os.send_file() over the pty
+ * given as file descriptor; MPyTerm is at the other end.
+ * The UART is simulated at 'rate' bytes per second in both directions, with
+ * 'error_rate' probability of a damaged byte. The UART interrupt handler
+ * filling the ring buffer is a thread. Writing (reading) a block to (from)
+ * the file system takes 'write_us' (write_us / 4) microseconds.
+ *
+ * usage: xfer_device fd get|send file size window zsize rate error_rate write_us seed
+ * The result is printed to stderr, the exit code is 0 on success.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <poll.h>
+#include <time.h>
+#include "mphalport.h"
+#include "file_xfer.h"
+#include "extmod/uzlib/uzlib.h"
+
+static int uart_fd;
+static double uart_rate;            // bytes per second
+static double error_rate;           // probability of a damaged byte
+static uint32_t error_seed;
+static unsigned long damaged = 0;
+
+static pthread_mutex_t ring_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ring_changed = PTHREAD_COND_INITIALIZER;
+static ringbuf_t *uart_ring = NULL;
+static volatile bool uart_irq = false;
+static pthread_t uart_irq_thread;
+
+static void sleep_us(double us)
+{
+    if (us >= 1) usleep((useconds_t)us);
+}
+
+// Damage the bytes with the probability 'error_rate'
+static void damage(uint8_t *buf, int len)
+{
+    if (error_rate <= 0) return;
+    for (int i = 0; i < len; i++) {
+        error_seed = (error_seed * 1103515245U) + 12345U;
+        if (((error_seed >> 8) / 16777216.0) < error_rate) {
+            buf[i] ^= 0x5A;
+            damaged++;
+        }
+    }
+}
+
+mp_uint_t mp_hal_ticks_ms(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (t.tv_sec * 1000) + (t.tv_nsec / 1000000);
+}
+
+// CRC-16/CCITT, as mphalport.c
+uint16_t mp_hal_crc16(const uint8_t *buf, uint32_t count)
+{
+    uint16_t crc = 0xFFFF;
+    while (count--) {
+        crc ^= (uint16_t)(*buf++) << 8;
+        for (int i = 0; i < 8; i++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+void mp_hal_send_bytes(char *buf, int len)
+{
+    uint8_t *data = malloc(len);
+    memcpy(data, buf, len);
+    damage(data, len);
+    sleep_us(len / uart_rate * 1e6);
+    int sent = 0;
+    while (sent < len) {
+        int n = write(uart_fd, data + sent, len - sent);
+        if (n > 0) sent += n;
+    }
+    free(data);
+}
+
+// The UART receive interrupt handler
+static void *uart_irq_task(void *arg)
+{
+    uint8_t buf[256];
+    while (uart_irq) {
+        struct pollfd pfd = { uart_fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 20) <= 0) continue;
+        int n = read(uart_fd, buf, sizeof(buf));
+        if (n <= 0) continue;
+        sleep_us(n / uart_rate * 1e6);
+        damage(buf, n);
+        pthread_mutex_lock(&ring_lock);
+        for (int i = 0; i < n; i++) ringbuf_put(uart_ring, buf[i]);
+        pthread_cond_signal(&ring_changed);
+        pthread_mutex_unlock(&ring_lock);
+    }
+    return NULL;
+}
+
+void mp_hal_uarths_setirq_ring(ringbuf_t *ring)
+{
+    uart_ring = ring;
+    uart_irq = true;
+    pthread_create(&uart_irq_thread, NULL, uart_irq_task, NULL);
+}
+
+void mp_hal_uarths_setirq_default()
+{
+    uart_irq = false;
+    pthread_join(uart_irq_thread, NULL);
+}
+
+int mp_hal_uarths_read_ring(ringbuf_t *ring, uint8_t *buf, int len, uint32_t timeout)
+{
+    pthread_mutex_lock(&ring_lock);
+    if ((ring->iget == ring->iput) && (timeout > 0)) {
+        struct timespec t;
+        clock_gettime(CLOCK_REALTIME, &t);
+        t.tv_nsec += (long)timeout * 1000000;
+        t.tv_sec += t.tv_nsec / 1000000000;
+        t.tv_nsec %= 1000000000;
+        pthread_cond_timedwait(&ring_changed, &ring_lock, &t);
+    }
+    int n = 0;
+    while (n < len) {
+        int c = ringbuf_get(ring);
+        if (c < 0) break;
+        buf[n++] = c;
+    }
+    pthread_mutex_unlock(&ring_lock);
+    return n;
+}
+
+// ==== os.get_file() ====
+
+typedef struct {
+    TINF_DATA decomp;
+    file_xfer_t *xfer;
+    int err;
+} inflate_t;
+
+// uzlib source callback, the compressed stream is read block by block
+static int inflate_read_source(TINF_DATA *data)
+{
+    inflate_t *inf = (inflate_t *)data;
+    const uint8_t *block;
+    int len = file_xfer_recv(inf->xfer, &block);
+    if (len <= 0) {
+        inf->err = (len < 0) ? len : XFER_ERR_DATA;
+        return -1;
+    }
+    data->source = block + 1;
+    data->source_limit = block + len;
+    return block[0];
+}
+
+static int get_file(FILE *f, int size, int window, int zsize, int write_us)
+{
+    static uint8_t dict[32768], out[XFER_BLOCK_SIZE];
+    static inflate_t inf;
+    file_xfer_t xfer;
+    const uint8_t *block;
+    int len, res, total = 0;
+
+    if (file_xfer_start(&xfer, false, (zsize > 0) ? zsize : size, window) < 0) return XFER_ERR_MEMORY;
+    if (zsize == 0) {
+        while ((len = file_xfer_recv(&xfer, &block)) > 0) {
+            fwrite(block, 1, len, f);
+            sleep_us(write_us);
+            total += len;
+        }
+        res = len;
+    }
+    else {
+        inf.xfer = &xfer;
+        inf.decomp.source_read_cb = inflate_read_source;
+        uzlib_uncompress_init(&inf.decomp, dict, sizeof(dict));
+        while (1) {
+            inf.decomp.dest = out;
+            inf.decomp.dest_limit = out + XFER_BLOCK_SIZE;
+            int st = uzlib_uncompress(&inf.decomp);
+            len = inf.decomp.dest - out;
+            if (len > 0) {
+                fwrite(out, 1, len, f);
+                sleep_us(write_us);
+            }
+            total += len;
+            if ((st < 0) || inf.err) {
+                res = (inf.err) ? inf.err : XFER_ERR_DATA;
+                break;
+            }
+            if (st == TINF_DONE) {
+                res = file_xfer_recv(&xfer, &block);
+                if (res > 0) res = XFER_ERR_DATA;
+                break;
+            }
+        }
+    }
+    if ((res == 0) && (total != size)) res = XFER_ERR_DATA;
+    file_xfer_end(&xfer, res);
+    return res;
+}
+
+// ==== os.send_file() ====
+
+static int send_file(FILE *f, int size, int window, int write_us)
+{
+    static uint8_t buf[XFER_BLOCK_SIZE];
+    file_xfer_t xfer;
+    int res = 0;
+
+    if (file_xfer_start(&xfer, true, size, window) < 0) return XFER_ERR_MEMORY;
+    for (int remain = size; remain > 0; ) {
+        int n = (remain > XFER_BLOCK_SIZE) ? XFER_BLOCK_SIZE : remain;
+        if (fread(buf, 1, n, f) != n) {
+            res = XFER_ERR_FILE;
+            break;
+        }
+        sleep_us(write_us / 4);
+        res = file_xfer_send(&xfer, buf, n);
+        if (res < 0) break;
+        remain -= n;
+    }
+    if (res == 0) res = file_xfer_flush(&xfer);
+    file_xfer_end(&xfer, res);
+    return res;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 11) {
+        fprintf(stderr, "usage: %s fd get|send file size window zsize rate error_rate write_us seed\n", argv[0]);
+        return 2;
+    }
+    uart_fd = atoi(argv[1]);
+    bool get = (strcmp(argv[2], "get") == 0);
+    int size = atoi(argv[4]);
+    int window = atoi(argv[5]);
+    int zsize = atoi(argv[6]);
+    uart_rate = atof(argv[7]);
+    error_rate = atof(argv[8]);
+    int write_us = atoi(argv[9]);
+    error_seed = atoi(argv[10]);
+
+    FILE *f = fopen(argv[3], (get) ? "wb" : "rb");
+    if (f == NULL) {
+        fprintf(stderr, "%s not opened\n", argv[3]);
+        return 2;
+    }
+    int res = (get) ? get_file(f, size, window, zsize, write_us) : send_file(f, size, window, write_us);
+    fclose(f);
+    fprintf(stderr, "result %d, %lu damaged bytes\n", res, damaged);
+    return (res != 0);
+}
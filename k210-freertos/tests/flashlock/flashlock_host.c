@@ -0,0 +1,107 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Host stand-in for the FreeRTOS mutexes and tasks used by flashlock.c
+
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "FreeRTOS.h"
+
+// ==== FreeRTOS ====
+
+struct host_task {
+    int dummy;
+};
+
+struct host_mutex {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    TaskHandle_t volatile holder;
+};
+
+static __thread struct host_task current_task;
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return &current_task;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t mutex = calloc(1, sizeof(struct host_mutex));
+    if (mutex == NULL) return NULL;
+    pthread_mutex_init(&mutex->lock, NULL);
+    pthread_cond_init(&mutex->changed, NULL);
+    return mutex;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t wait)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    if (wait != portMAX_DELAY) {
+        deadline.tv_sec += wait / 1000;
+        deadline.tv_nsec += (wait % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+    pthread_mutex_lock(&mutex->lock);
+    while (mutex->holder != NULL) {
+        if (wait == 0) break;
+        if (wait == portMAX_DELAY) pthread_cond_wait(&mutex->changed, &mutex->lock);
+        else if (pthread_cond_timedwait(&mutex->changed, &mutex->lock, &deadline) == ETIMEDOUT) break;
+    }
+    BaseType_t res = pdFALSE;
+    if (mutex->holder == NULL) {
+        mutex->holder = &current_task;
+        res = pdTRUE;
+    }
+    pthread_mutex_unlock(&mutex->lock);
+    return res;
+}
+
+// As the FreeRTOS mutex, only the holder can give it
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex)
+{
+    pthread_mutex_lock(&mutex->lock);
+    BaseType_t res = pdFALSE;
+    if (mutex->holder == &current_task) {
+        mutex->holder = NULL;
+        pthread_cond_broadcast(&mutex->changed);
+        res = pdTRUE;
+    }
+    pthread_mutex_unlock(&mutex->lock);
+    return res;
+}
+
+TaskHandle_t xSemaphoreGetMutexHolder(SemaphoreHandle_t mutex)
+{
+    return mutex->holder;
+}
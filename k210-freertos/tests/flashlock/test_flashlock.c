@@ -0,0 +1,306 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host tests of the lock between the Flash writes and the MicroPython code executed
+ * from the XIP image (mpy_support/flashlock.c)
+ * Each MicroPython instance is a GIL mutex and the threads holding it. 'xip_enabled'
+ * is cleared for the duration of each simulated write, the code "executed from the
+ * image" checks it is set. The file system mutex is taken with a timeout, as in
+ * littleflash.c, a lock order inversion shows as a timeout. A deadlock ends the test.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include "flashlock.h"
+
+static int failed = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failed++; \
+        return; \
+    } } while (0)
+
+#define FS_MUTEX_TIMEOUT    600
+#define STRESS_TASKS        2       // per instance
+#define STRESS_RUNS         1000    // per task
+#define TEST_TIMEOUT        60      // seconds, a deadlock ends the test
+
+static SemaphoreHandle_t gil[FLASHLOCK_INSTANCES];
+static SemaphoreHandle_t fs_mutex;
+static volatile bool xip_enabled = true;
+static volatile int image_errors = 0;
+static volatile int read_errors = 0;
+static volatile int fs_timeouts = 0;
+
+static void count(volatile int *counter)
+{
+    __sync_fetch_and_add(counter, 1);
+}
+
+// MicroPython code executed from the image, the caller holds its instance's GIL
+static void run_image_code(void)
+{
+    for (int i = 0; i < 20; i++) {
+        if (!xip_enabled) {
+            count(&image_errors);
+            return;
+        }
+    }
+}
+
+// w25qxx_read_data(): read through the XIP window
+static void flash_read(void)
+{
+    int state = flashlock_xip_lock(false);
+    if (!xip_enabled) count(&read_errors);
+    usleep(10);
+    flashlock_xip_unlock(state, false);
+}
+
+// w25qxx_write_data() or w25qxx_sector_erase(): XIP is disabled during the operation
+static void flash_write(unsigned int us)
+{
+    int state = flashlock_xip_lock(true);
+    xip_enabled = false;
+    usleep(us);
+    xip_enabled = true;
+    flashlock_xip_unlock(state, true);
+}
+
+static bool fs_lock(void)
+{
+    if (flashlock_take(fs_mutex, FS_MUTEX_TIMEOUT)) return true;
+    count(&fs_timeouts);
+    return false;
+}
+
+static void init_locks(void)
+{
+    SemaphoreHandle_t *gil_ptr[FLASHLOCK_INSTANCES];
+    for (int i = 0; i < FLASHLOCK_INSTANCES; i++) {
+        gil[i] = xSemaphoreCreateMutex();
+        gil_ptr[i] = &gil[i];
+    }
+    fs_mutex = xSemaphoreCreateMutex();
+    flashlock_init(gil_ptr);
+}
+
+// ==== Instance 1 task, waits for the file system while holding its GIL ====
+
+typedef struct {
+    volatile bool has_gil;
+    volatile bool returned;
+} parked_ctx_t;
+
+static void *parked_task(void *arg)
+{
+    parked_ctx_t *ctx = arg;
+    xSemaphoreTake(gil[1], portMAX_DELAY);
+    ctx->has_gil = true;
+    if (fs_lock()) {
+        ctx->returned = true;
+        run_image_code();
+        xSemaphoreGive(fs_mutex);
+    }
+    xSemaphoreGive(gil[1]);
+    return NULL;
+}
+
+// The write does not wait for the GIL of an instance blocked on the file system mutex,
+// and that instance does not continue before the write is finished
+static void test_parked(void)
+{
+    parked_ctx_t ctx = { 0 };
+    pthread_t task;
+
+    xSemaphoreTake(gil[0], portMAX_DELAY);
+    xSemaphoreTake(fs_mutex, portMAX_DELAY);
+    CHECK(pthread_create(&task, NULL, parked_task, &ctx) == 0, "task not started");
+    while (!ctx.has_gil) usleep(100);
+    usleep(20000);
+
+    int state = flashlock_xip_lock(true);
+    xip_enabled = false;
+    // the file system is free now, but the parked task must wait for the end of the write
+    xSemaphoreGive(fs_mutex);
+    usleep(50000);
+    bool returned = ctx.returned;
+    xip_enabled = true;
+    flashlock_xip_unlock(state, true);
+    pthread_join(task, NULL);
+    xSemaphoreGive(gil[0]);
+
+    CHECK(state == 0, "GIL of the parked instance taken (state %d)", state);
+    CHECK(!returned, "parked task returned during the write");
+    CHECK(ctx.returned, "parked task did not get the file system mutex");
+    CHECK(image_errors == 0, "image code executed during the write");
+}
+
+// ==== Instance 1 task running the image code ====
+
+static volatile bool running_stop = false;
+
+static void *running_task(void *arg)
+{
+    while (!running_stop) {
+        xSemaphoreTake(gil[1], portMAX_DELAY);
+        for (int i = 0; i < 100; i++) run_image_code();
+        xSemaphoreGive(gil[1]);
+        sched_yield();
+    }
+    return NULL;
+}
+
+// The write takes the GIL of the running instance, the caller's own GIL is kept
+static void test_running(void)
+{
+    pthread_t task;
+    running_stop = false;
+    xSemaphoreTake(gil[0], portMAX_DELAY);
+    CHECK(pthread_create(&task, NULL, running_task, NULL) == 0, "task not started");
+    int state = 0;
+    for (int i = 0; i < 200; i++) {
+        state |= flashlock_xip_lock(true);
+        xip_enabled = false;
+        usleep(100);
+        xip_enabled = true;
+        flashlock_xip_unlock(state & 2, true);
+    }
+    TaskHandle_t holder = xSemaphoreGetMutexHolder(gil[0]);
+    running_stop = true;
+    pthread_join(task, NULL);
+    xSemaphoreGive(gil[0]);
+
+    CHECK(state == 2, "wrong GILs taken (state %d)", state);
+    CHECK(holder == xTaskGetCurrentTaskHandle(), "own GIL released");
+    CHECK(image_errors == 0, "%d image code run(s) during the writes", image_errors);
+}
+
+// ==== Stress test, all operations from both instances and a task without a GIL ====
+
+typedef struct {
+    int instance;       // -1: no GIL
+    unsigned int seed;
+} stress_arg_t;
+
+static void *stress_task(void *arg)
+{
+    stress_arg_t *sa = arg;
+    for (int n = 0; n < STRESS_RUNS; n++) {
+        if (sa->instance >= 0) xSemaphoreTake(gil[sa->instance], portMAX_DELAY);
+        for (int k = 0; k < 4; k++) {
+            switch (rand_r(&sa->seed) % 8) {
+                case 0:
+                    // file system read
+                    if (fs_lock()) {
+                        flash_read();
+                        flash_read();
+                        xSemaphoreGive(fs_mutex);
+                    }
+                    break;
+                case 1:
+                    // file system write, the driver reads the sector first
+                    if (fs_lock()) {
+                        flash_read();
+                        flash_write(50);
+                        xSemaphoreGive(fs_mutex);
+                    }
+                    break;
+                case 2:
+                    // file system operation served from the cache
+                    if (fs_lock()) xSemaphoreGive(fs_mutex);
+                    break;
+                case 3:
+                    // write outside of the file system (machine configuration)
+                    if ((rand_r(&sa->seed) % 4) == 0) flash_write(50);
+                    break;
+                case 4:
+                    // read outside of the file system (kpu model)
+                    flash_read();
+                    break;
+                default:
+                    break;
+            }
+            if (sa->instance >= 0) run_image_code();
+        }
+        if (sa->instance >= 0) xSemaphoreGive(gil[sa->instance]);
+        if ((rand_r(&sa->seed) % 4) == 0) usleep(rand_r(&sa->seed) % 50);
+        else sched_yield();
+    }
+    return NULL;
+}
+
+static void test_stress(void)
+{
+    const int ntasks = FLASHLOCK_INSTANCES * STRESS_TASKS + 1;
+    pthread_t task[ntasks];
+    stress_arg_t arg[ntasks];
+
+    for (int i = 0; i < ntasks; i++) {
+        arg[i].instance = (i < (ntasks - 1)) ? (i % FLASHLOCK_INSTANCES) : -1;
+        arg[i].seed = i + 1;
+        CHECK(pthread_create(&task[i], NULL, stress_task, &arg[i]) == 0, "task %d not started", i);
+    }
+    for (int i = 0; i < ntasks; i++) pthread_join(task[i], NULL);
+
+    CHECK(fs_timeouts == 0, "%d file system mutex timeout(s)", fs_timeouts);
+    CHECK(read_errors == 0, "%d XIP read(s) during a write", read_errors);
+    CHECK(image_errors == 0, "%d image code run(s) during a write", image_errors);
+}
+
+// The blocked threads can not be stopped, the test is ended from the signal handler
+static void deadlock(int sig)
+{
+    const char *msg = "FAIL: deadlock, test timed out\nflashlock: test(s) failed\n";
+    (void)sig;
+    (void)!write(STDOUT_FILENO, msg, strlen(msg));
+    _exit(1);
+}
+
+int main(void)
+{
+    signal(SIGALRM, deadlock);
+    alarm(TEST_TIMEOUT);
+    init_locks();
+    test_parked();
+    test_running();
+    test_stress();
+    if (failed) {
+        printf("flashlock: %d test(s) failed\n", failed);
+        return 1;
+    }
+    printf("flashlock: OK\n");
+    return 0;
+}
@@ -0,0 +1,320 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "i2s_host.h"
+
+#define BUFFER_COUNT    2
+
+typedef struct {
+    bool capture;
+    bool running;
+    uint32_t bits;
+    uint32_t channels;
+    size_t block_align;
+    size_t buffer_frames;
+    size_t buffer_size;
+    uint8_t *buffer;
+    size_t buffer_ptr;
+    int next_free_buffer;
+    int dma_in_use_buffer;
+    int prefilled;
+    uint32_t overruns;
+    FILE *wav_in;
+    uint32_t wav_remain;
+    size_t wav_block_align;
+    FILE *wav_out;
+    wav_info_t out_info;
+    i2s_stage_completion_handler_t on_stage_completion;
+    void *on_stage_completion_data;
+} i2s_host_t;
+
+static uint32_t get_le(const uint8_t *p, int n)
+{
+    uint32_t v = 0;
+    for (int i=n-1; i>=0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static void put_le(uint8_t *p, uint32_t v, int n)
+{
+    for (int i=0; i<n; i++) {
+        p[i] = v & 0xFF;
+        v >>= 8;
+    }
+}
+
+int wav_read_header(FILE *f, wav_info_t *info)
+{
+    uint8_t hdr[12], chunk[8], fmt[16];
+
+    if ((fread(hdr, 1, 12, f) != 12) || (memcmp(hdr, "RIFF", 4) != 0) || (memcmp(hdr+8, "WAVE", 4) != 0)) return -1;
+    memset(info, 0, sizeof(wav_info_t));
+    while (fread(chunk, 1, 8, f) == 8) {
+        uint32_t len = get_le(chunk+4, 4);
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            if ((len < 16) || (fread(fmt, 1, 16, f) != 16)) return -1;
+            // PCM or WAVE_FORMAT_EXTENSIBLE
+            uint32_t tag = get_le(fmt, 2);
+            if ((tag != 1) && (tag != 0xFFFE)) return -1;
+            info->channels = get_le(fmt+2, 2);
+            info->rate = get_le(fmt+4, 4);
+            info->bits = get_le(fmt+14, 2);
+            if (fseek(f, (len - 16) + (len & 1), SEEK_CUR) != 0) return -1;
+        }
+        else if (memcmp(chunk, "data", 4) == 0) {
+            if (info->channels == 0) return -1;
+            if ((info->bits != 16) && (info->bits != 24) && (info->bits != 32)) return -1;
+            info->data_len = len;
+            return 0;
+        }
+        else if (fseek(f, len + (len & 1), SEEK_CUR) != 0) return -1;
+    }
+    return -1;
+}
+
+void wav_write_header(FILE *f, const wav_info_t *info)
+{
+    uint8_t hdr[44];
+    uint32_t block_align = info->channels * (info->bits / 8);
+
+    memcpy(hdr, "RIFF", 4);
+    put_le(hdr+4, 36 + info->data_len, 4);
+    memcpy(hdr+8, "WAVEfmt ", 8);
+    put_le(hdr+16, 16, 4);
+    put_le(hdr+20, 1, 2);
+    put_le(hdr+22, info->channels, 2);
+    put_le(hdr+24, info->rate, 4);
+    put_le(hdr+28, info->rate * block_align, 4);
+    put_le(hdr+32, block_align, 2);
+    put_le(hdr+34, info->bits, 2);
+    memcpy(hdr+36, "data", 4);
+    put_le(hdr+40, info->data_len, 4);
+    fwrite(hdr, 1, 44, f);
+}
+
+handle_t i2s_host_open(void)
+{
+    i2s_host_t *dev = calloc(1, sizeof(i2s_host_t));
+    return (handle_t)dev;
+}
+
+void i2s_host_close(handle_t file)
+{
+    i2s_host_t *dev = (i2s_host_t *)file;
+    if (dev->wav_out) {
+        fseek(dev->wav_out, 0, SEEK_SET);
+        wav_write_header(dev->wav_out, &dev->out_info);
+        fflush(dev->wav_out);
+    }
+    free(dev->buffer);
+    free(dev);
+}
+
+static void i2s_host_config(i2s_host_t *dev, const audio_format_t *format, size_t delay_ms, bool capture)
+{
+    dev->capture = capture;
+    dev->running = false;
+    dev->bits = format->bits_per_sample;
+    dev->channels = format->channels;
+    dev->block_align = format->channels * ((format->bits_per_sample == 16) ? 2 : 4);
+    dev->buffer_frames = format->sample_rate * delay_ms / 1000;
+    dev->buffer_size = dev->block_align * dev->buffer_frames;
+    free(dev->buffer);
+    dev->buffer = calloc(BUFFER_COUNT, dev->buffer_size);
+    dev->buffer_ptr = 0;
+    dev->next_free_buffer = 0;
+    dev->dma_in_use_buffer = 0;
+    dev->prefilled = 0;
+    dev->overruns = 0;
+    dev->out_info = (wav_info_t){format->channels, format->bits_per_sample, format->sample_rate, 0};
+}
+
+void i2s_config_as_render(handle_t file, const audio_format_t *format, size_t delay_ms, i2s_align_mode_t align_mode, size_t channels_mask)
+{
+    i2s_host_config((i2s_host_t *)file, format, delay_ms, false);
+}
+
+void i2s_config_as_capture(handle_t file, const audio_format_t *format, size_t delay_ms, i2s_align_mode_t align_mode, size_t channels_mask)
+{
+    i2s_host_config((i2s_host_t *)file, format, delay_ms, true);
+}
+
+int i2s_host_set_input(handle_t file, FILE *wav)
+{
+    i2s_host_t *dev = (i2s_host_t *)file;
+    wav_info_t info;
+    if (wav_read_header(wav, &info) != 0) return -1;
+    if ((info.channels != dev->channels) || (info.bits != dev->bits)) return -1;
+    dev->wav_in = wav;
+    dev->wav_remain = info.data_len;
+    dev->wav_block_align = info.channels * (info.bits / 8);
+    return 0;
+}
+
+void i2s_host_set_output(handle_t file, FILE *wav)
+{
+    i2s_host_t *dev = (i2s_host_t *)file;
+    dev->wav_out = wav;
+    dev->out_info.data_len = 0;
+    // the header is written when closed
+    fseek(wav, 44, SEEK_SET);
+}
+
+// Read one frame from the input WAV file into the DMA buffer
+static bool read_frame(i2s_host_t *dev, uint8_t *dst)
+{
+    uint8_t frame[8 * 4];
+    if ((dev->wav_in == NULL) || (dev->wav_remain < dev->wav_block_align)) return false;
+    if (fread(frame, 1, dev->wav_block_align, dev->wav_in) != dev->wav_block_align) return false;
+    dev->wav_remain -= dev->wav_block_align;
+
+    int nb = dev->bits / 8;
+    for (uint32_t ch=0; ch<dev->channels; ch++) {
+        uint32_t v = get_le(frame + ch*nb, nb);
+        if (dev->bits == 16) put_le(dst + ch*2, v, 2);
+        else {
+            if ((dev->bits == 24) && (v & 0x800000)) v |= 0xFF000000;
+            put_le(dst + ch*4, v, 4);
+        }
+    }
+    return true;
+}
+
+// Write one frame from the DMA buffer to the output WAV file
+static void write_frame(i2s_host_t *dev, const uint8_t *src)
+{
+    uint8_t frame[8 * 4];
+    int nb = dev->bits / 8;
+    int sb = (dev->bits == 16) ? 2 : 4;
+    for (uint32_t ch=0; ch<dev->channels; ch++) {
+        put_le(frame + ch*nb, get_le(src + ch*sb, sb), nb);
+    }
+    fwrite(frame, 1, dev->channels * nb, dev->wav_out);
+    dev->out_info.data_len += dev->channels * nb;
+}
+
+int i2s_host_dma_stage(handle_t file)
+{
+    i2s_host_t *dev = (i2s_host_t *)file;
+    if (!dev->running) return -1;
+
+    int n = 0;
+    uint8_t *buf = dev->buffer + dev->buffer_size * dev->dma_in_use_buffer;
+    for (size_t i=0; i<dev->buffer_frames; i++) {
+        uint8_t *frame = buf + i * dev->block_align;
+        if (dev->capture) {
+            if (read_frame(dev, frame)) n++;
+            else memset(frame, 0, dev->block_align);
+        }
+        else if (dev->wav_out) {
+            write_frame(dev, frame);
+            n++;
+        }
+    }
+
+    int dma_in_use_buffer = dev->dma_in_use_buffer + 1;
+    if (dma_in_use_buffer == BUFFER_COUNT) dma_in_use_buffer = 0;
+    dev->dma_in_use_buffer = dma_in_use_buffer;
+    // the application is still using the buffer the DMA continues with
+    if (dev->next_free_buffer == dma_in_use_buffer) dev->overruns++;
+
+    if (dev->on_stage_completion) dev->on_stage_completion(dev->on_stage_completion_data);
+    return n;
+}
+
+uint32_t i2s_host_overruns(handle_t file)
+{
+    return ((i2s_host_t *)file)->overruns;
+}
+
+size_t i2s_host_buffer_frames(handle_t file)
+{
+    return ((i2s_host_t *)file)->buffer_frames;
+}
+
+// While the render is stopped, both buffers can be filled before the start (prefill)
+static bool free_buffer_available(i2s_host_t *dev)
+{
+    if ((!dev->capture) && (!dev->running)) return dev->prefilled < BUFFER_COUNT;
+    return dev->next_free_buffer != dev->dma_in_use_buffer;
+}
+
+static void next_buffer(i2s_host_t *dev)
+{
+    dev->buffer_ptr = 0;
+    int next_free_buffer = dev->next_free_buffer + 1;
+    if (next_free_buffer == BUFFER_COUNT) next_free_buffer = 0;
+    dev->next_free_buffer = next_free_buffer;
+    if (!dev->running) dev->prefilled++;
+}
+
+bool i2s_try_get_buffer(handle_t file, uint8_t **buffer, size_t *frames)
+{
+    i2s_host_t *dev = (i2s_host_t *)file;
+    if (!free_buffer_available(dev)) return false;
+
+    *frames = (dev->buffer_size - dev->buffer_ptr) / dev->block_align;
+    *buffer = dev->buffer + dev->buffer_size * dev->next_free_buffer + dev->buffer_ptr;
+    return true;
+}
+
+void i2s_release_buffer(handle_t file, size_t frames)
+{
+    i2s_host_t *dev = (i2s_host_t *)file;
+    dev->buffer_ptr += frames * dev->block_align;
+    if (dev->buffer_ptr >= dev->buffer_size) next_buffer(dev);
+}
+
+void i2s_start(handle_t file)
+{
+    i2s_host_t *dev = (i2s_host_t *)file;
+    // the partially prefilled buffer is played as it is, silence after the written frames
+    if ((!dev->capture) && (dev->buffer_ptr)) next_buffer(dev);
+    dev->prefilled = 0;
+    dev->dma_in_use_buffer = 0;
+    dev->running = true;
+}
+
+// The data not played or not read is discarded, the next start begins with the first buffer
+void i2s_stop(handle_t file)
+{
+    i2s_host_t *dev = (i2s_host_t *)file;
+    dev->running = false;
+    memset(dev->buffer, 0, dev->buffer_size * BUFFER_COUNT);
+    dev->buffer_ptr = 0;
+    dev->next_free_buffer = 0;
+    dev->dma_in_use_buffer = 0;
+    dev->prefilled = 0;
+}
+
+void i2s_set_on_stage_completion(handle_t file, i2s_stage_completion_handler_t handler, void *userdata)
+{
+    i2s_host_t *dev = (i2s_host_t *)file;
+    dev->on_stage_completion_data = userdata;
+    dev->on_stage_completion = handler;
+}
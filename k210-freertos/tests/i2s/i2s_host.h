@@ -0,0 +1,77 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host stand-in of the K210 I2S device
+ *
+ * Implements the i2s functions of devices.h used by machine.I2S.
+ * The DMA buffers are handled as in lib/bsp/device/i2s.cpp: two buffers of
+ * 'delay_ms' milliseconds, the application gets the one not used by the DMA.
+ *
+ * The DMA is simulated by i2s_host_dma_stage(), one call per finished buffer:
+ *   capture: the buffer is filled with the frames read from the input WAV file
+ *            (silence after its end)
+ *   render:  the played buffer is appended to the output WAV file
+ * Then the stage completion handler is called, as from the DMA ISR.
+ *
+ * 16-bit samples are stored as 16-bit values in the DMA buffer,
+ * 24 and 32-bit samples as 32-bit values (24-bit sign extended).
+ */
+
+#ifndef _I2S_HOST_H_
+#define _I2S_HOST_H_
+
+#include <stdio.h>
+#include "devices.h"
+
+typedef struct {
+    uint16_t channels;
+    uint16_t bits;
+    uint32_t rate;
+    uint32_t data_len;      // bytes of sample data
+} wav_info_t;
+
+// Read the WAV header, the file is left positioned at the sample data
+// Returns 0 on success, -1 if not a supported PCM WAV file
+int wav_read_header(FILE *f, wav_info_t *info);
+// Write the 44 bytes PCM WAV header
+void wav_write_header(FILE *f, const wav_info_t *info);
+
+handle_t i2s_host_open(void);
+void i2s_host_close(handle_t file);
+// Input WAV file for capture, its format must match the configured one
+int i2s_host_set_input(handle_t file, FILE *wav);
+// Output WAV file for render, the header is written when the device is closed
+void i2s_host_set_output(handle_t file, FILE *wav);
+// Finish the buffer used by the DMA, returns the number of frames
+// taken from the input or written to the output, -1 if not started
+int i2s_host_dma_stage(handle_t file);
+// Number of buffers not (fully) processed by the application when the DMA reused them
+uint32_t i2s_host_overruns(handle_t file);
+// Size of one DMA buffer in frames
+size_t i2s_host_buffer_frames(handle_t file);
+
+#endif
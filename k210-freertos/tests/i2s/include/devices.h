@@ -0,0 +1,70 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Host build of standard_lib/machine/i2s_buffer.c
+// Only the types and i2s functions of the SDK's devices.h are declared,
+// the functions are implemented by the host stand-in (i2s_host.c)
+
+#ifndef _DEVICES_H
+#define _DEVICES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef uintptr_t handle_t;
+
+typedef enum _audio_format_type
+{
+    AUDIO_FMT_PCM
+} audio_format_type_t;
+
+typedef struct _audio_format
+{
+    audio_format_type_t type;
+    uint32_t bits_per_sample;
+    uint32_t sample_rate;
+    uint32_t channels;
+} audio_format_t;
+
+typedef enum _i2s_align_mode
+{
+    I2S_AM_STANDARD,
+    I2S_AM_RIGHT,
+    I2S_AM_LEFT
+} i2s_align_mode_t;
+
+typedef void (*i2s_stage_completion_handler_t)(void *userdata);
+
+void i2s_config_as_render(handle_t file, const audio_format_t *format, size_t delay_ms, i2s_align_mode_t align_mode, size_t channels_mask);
+void i2s_config_as_capture(handle_t file, const audio_format_t *format, size_t delay_ms, i2s_align_mode_t align_mode, size_t channels_mask);
+void i2s_release_buffer(handle_t file, size_t frames);
+void i2s_start(handle_t file);
+void i2s_stop(handle_t file);
+bool i2s_try_get_buffer(handle_t file, uint8_t **buffer, size_t *frames);
+void i2s_set_on_stage_completion(handle_t file, i2s_stage_completion_handler_t handler, void *userdata);
+
+#endif
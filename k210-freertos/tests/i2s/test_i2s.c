@@ -0,0 +1,441 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host tests of the machine.I2S buffer transfers (machine/i2s_buffer.c)
+ * The audio data is fed from WAV files through the host stand-in of the I2S
+ * device (i2s_host.c), which handles the DMA buffers as the SDK driver does.
+ * The captured and rendered streams must be bit exact, without dropouts.
+ *
+ *   test_i2s [file.wav]   a given WAV file is also captured and rendered back
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "i2s_host.h"
+#include "i2s_buffer.h"
+
+static int failed = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failed++; \
+        goto exit; \
+    } } while (0)
+
+static int stages_completed = 0;
+static int stages_run = 0;
+
+// Called by the stand-in as from the DMA ISR
+static void stage_completion(void *userdata)
+{
+    (*(int *)userdata)++;
+}
+
+// Create the WAV file with a sine wave of different frequency in each channel
+// and some low bits noise; the sample data is also returned in 'data'
+static FILE *make_wav(int channels, int bits, int rate, int frames, uint8_t **data)
+{
+    int nb = bits / 8;
+    size_t len = (size_t)frames * channels * nb;
+    uint8_t *p = malloc(len);
+    uint32_t seed = 12345 + channels * 100 + bits;
+    *data = p;
+
+    for (int i=0; i<frames; i++) {
+        for (int ch=0; ch<channels; ch++) {
+            double s = sin(2.0 * M_PI * (220.0 * (ch+1)) * i / rate) * 0.9;
+            seed = seed * 1103515245 + 12345;
+            int64_t v = (int64_t)(s * (double)((1LL << (bits-1)) - 256)) + ((seed >> 16) & 0xFF);
+            for (int b=0; b<nb; b++) *p++ = (v >> (8*b)) & 0xFF;
+        }
+    }
+    FILE *f = tmpfile();
+    wav_info_t info = {channels, bits, rate, len};
+    wav_write_header(f, &info);
+    fwrite(*data, 1, len, f);
+    rewind(f);
+    return f;
+}
+
+// Convert the frames from the DMA buffer format to the WAV sample format
+// Returns false if a 24-bit sample is not sign extended in the DMA buffer
+static bool dma_to_wav(int channels, int bits, const uint8_t *src, uint8_t *dst, size_t frames)
+{
+    int nb = bits / 8;
+    int sb = (bits == 16) ? 2 : 4;
+    for (size_t i=0; i<frames * channels; i++) {
+        memcpy(dst, src, nb);
+        if ((bits == 24) && (src[3] != ((src[2] & 0x80) ? 0xFF : 0x00))) return false;
+        src += sb;
+        dst += nb;
+    }
+    return true;
+}
+
+static void wav_to_dma(int channels, int bits, const uint8_t *src, uint8_t *dst, size_t frames)
+{
+    int nb = bits / 8;
+    int sb = (bits == 16) ? 2 : 4;
+    for (size_t i=0; i<frames * channels; i++) {
+        memcpy(dst, src, nb);
+        if (bits == 24) dst[3] = (src[2] & 0x80) ? 0xFF : 0x00;
+        src += nb;
+        dst += sb;
+    }
+}
+
+// Capture the WAV file 'wav', reading with the user buffers of 'chunk' bytes
+// (chunk 0: varying sizes) after each finished DMA buffer.
+// Returns the captured data converted to the WAV sample format and its length in frames
+static uint8_t *capture(FILE *wav, const wav_info_t *info, int buf_ms, size_t chunk, size_t *n_frames, uint32_t *overruns)
+{
+    audio_format_t format = {AUDIO_FMT_PCM, info->bits, info->rate, info->channels};
+    size_t block_align = info->channels * ((info->bits == 16) ? 2 : 4);
+    size_t total = info->data_len / (info->channels * (info->bits / 8));
+    handle_t h = i2s_host_open();
+    i2s_config_as_capture(h, &format, buf_ms, I2S_AM_STANDARD, (1 << info->channels) - 1);
+    if (i2s_host_set_input(h, wav) != 0) {
+        i2s_host_close(h);
+        return NULL;
+    }
+    stages_completed = 0;
+    stages_run = 0;
+    i2s_set_on_stage_completion(h, stage_completion, &stages_completed);
+
+    // all captured buffers, the last one is only partly from the input
+    size_t cap = (total + 2 * i2s_host_buffer_frames(h)) * block_align;
+    uint8_t *dmadata = malloc(cap);
+    uint8_t *user = malloc(chunk ? chunk : block_align * 97 + 3);
+    size_t len = 0;
+    int sizes = 0;
+
+    i2s_start(h);
+    while (1) {
+        size_t n;
+        int stage_frames = i2s_host_dma_stage(h);
+        stages_run++;
+        if (stage_frames <= 0) break;
+        do {
+            size_t ulen = chunk;
+            // varying buffer sizes, not always a multiple of the frame size
+            if (ulen == 0) {
+                ulen = ((sizes % 97) + 1) * block_align + (sizes % 3);
+                sizes++;
+            }
+            n = i2s_buffer_transfer(h, user, ulen, block_align, true);
+            if ((n % block_align) || (n > ulen) || (len + n > cap)) {
+                len = cap + 1;
+                break;
+            }
+            memcpy(dmadata + len, user, n);
+            len += n;
+        } while (n > 0);
+        if (len > cap) break;
+    }
+    i2s_stop(h);
+    *overruns = i2s_host_overruns(h);
+    i2s_host_close(h);
+    free(user);
+
+    uint8_t *data = NULL;
+    if (len <= cap) {
+        *n_frames = len / block_align;
+        data = malloc(len + 1);
+        if (!dma_to_wav(info->channels, info->bits, dmadata, data, *n_frames)) {
+            free(data);
+            data = NULL;
+        }
+    }
+    free(dmadata);
+    return data;
+}
+
+// Render the sample data (WAV format) into the WAV file 'out', writing
+// with the user buffers of 'chunk' bytes after each finished DMA buffer.
+// The data is padded with silence to the whole DMA buffers.
+// Returns the number of played buffers
+static int render(FILE *out, const wav_info_t *info, const uint8_t *data, int buf_ms, size_t chunk, uint32_t *overruns)
+{
+    audio_format_t format = {AUDIO_FMT_PCM, info->bits, info->rate, info->channels};
+    size_t block_align = info->channels * ((info->bits == 16) ? 2 : 4);
+    size_t total = info->data_len / (info->channels * (info->bits / 8));
+    size_t buffer_frames = info->rate * buf_ms / 1000;
+    size_t padded = (total + buffer_frames - 1) / buffer_frames * buffer_frames;
+    uint8_t *dmadata = calloc(padded, block_align);
+    wav_to_dma(info->channels, info->bits, data, dmadata, total);
+
+    handle_t h = i2s_host_open();
+    i2s_config_as_render(h, &format, buf_ms, I2S_AM_STANDARD, (1 << info->channels) - 1);
+    i2s_host_set_output(h, out);
+    stages_completed = 0;
+    i2s_set_on_stage_completion(h, stage_completion, &stages_completed);
+
+    size_t pos = 0;
+    int stages = 0;
+    *overruns = 0;
+    i2s_start(h);
+    // play until the last written buffer is played,
+    // nothing is written for the buffer after it
+    while (stages < 2) {
+        size_t n;
+        do {
+            size_t ulen = padded * block_align - pos;
+            if (ulen > chunk) ulen = chunk;
+            n = i2s_buffer_transfer(h, dmadata + pos, ulen, block_align, false);
+            pos += n;
+        } while (n > 0);
+        if (pos >= padded * block_align) stages++;
+        if (stages == 2) *overruns = i2s_host_overruns(h);
+        if (i2s_host_dma_stage(h) < 0) break;
+    }
+    i2s_stop(h);
+    i2s_host_close(h);
+    free(dmadata);
+    return stages_completed;
+}
+
+static void test_capture(int channels, int bits, int rate, int buf_ms, size_t chunk)
+{
+    uint8_t *data, *captured = NULL;
+    int frames = rate / 3 + 17;
+    FILE *wav = make_wav(channels, bits, rate, frames, &data);
+    wav_info_t info;
+    size_t n_frames = 0;
+    uint32_t overruns = 0;
+    size_t fsize = channels * (bits / 8);
+
+    CHECK(wav_read_header(wav, &info) == 0, "WAV header");
+    CHECK((info.channels == channels) && (info.bits == bits) && (info.rate == rate), "WAV format");
+    rewind(wav);
+    captured = capture(wav, &info, buf_ms, chunk, &n_frames, &overruns);
+    CHECK(captured != NULL, "capture %d ch, %d bit, chunk %zu", channels, bits, chunk);
+    CHECK(overruns == 0, "%u overruns", overruns);
+    CHECK(n_frames >= frames, "%zu of %d frames captured", n_frames, frames);
+    CHECK(memcmp(captured, data, frames * fsize) == 0, "captured data differs, %d ch, %d bit, chunk %zu", channels, bits, chunk);
+    // silence after the end of the input
+    for (size_t i=frames * fsize; i<n_frames * fsize; i++) CHECK(captured[i] == 0, "no silence at %zu", i);
+    CHECK(stages_completed == stages_run, "%d stage completions for %d buffers", stages_completed, stages_run);
+exit:
+    free(captured);
+    free(data);
+    fclose(wav);
+}
+
+// The application does not read for two DMA buffers, the data is lost
+static void test_capture_overrun(void)
+{
+    uint8_t *data;
+    FILE *wav = make_wav(2, 16, 16000, 16000, &data);
+    wav_info_t info;
+    audio_format_t format = {AUDIO_FMT_PCM, 16, 16000, 2};
+    uint8_t user[4096];
+    handle_t h = i2s_host_open();
+
+    CHECK(wav_read_header(wav, &info) == 0, "WAV header");
+    rewind(wav);
+    i2s_config_as_capture(h, &format, 10, I2S_AM_STANDARD, 3);
+    CHECK(i2s_host_set_input(h, wav) == 0, "input");
+    CHECK(i2s_buffer_transfer(h, user, sizeof(user), 4, true) == 0, "data before start");
+    i2s_start(h);
+    CHECK(i2s_buffer_transfer(h, user, sizeof(user), 4, true) == 0, "data before the first buffer");
+    CHECK(i2s_host_dma_stage(h) == 160, "first buffer");
+    CHECK(i2s_buffer_transfer(h, user, 3, 4, true) == 0, "partial frame read");
+    CHECK(i2s_buffer_transfer(h, user, 40, 4, true) == 40, "10 frames");
+    CHECK(i2s_host_overruns(h) == 0, "no overrun yet");
+    i2s_host_dma_stage(h);
+    CHECK(i2s_host_overruns(h) == 1, "overrun not detected");
+    // the rest of the first buffer is not available while the DMA writes into it
+    CHECK(i2s_buffer_transfer(h, user, sizeof(user), 4, true) == 0, "buffer available during overrun");
+    i2s_host_dma_stage(h);
+    CHECK(i2s_buffer_transfer(h, user, sizeof(user), 4, true) == 150 * 4, "rest of the buffer");
+    // these are the frames 330~479, frames 10~159 were lost
+    CHECK(memcmp(user, data + 330 * 4, 150 * 4) == 0, "overwritten data");
+exit:
+    i2s_host_close(h);
+    free(data);
+    fclose(wav);
+}
+
+static void test_render(int channels, int bits, int rate, int buf_ms, size_t chunk)
+{
+    uint8_t *data, *played = NULL;
+    int frames = rate / 4 + 5;
+    FILE *wav = make_wav(channels, bits, rate, frames, &data);
+    FILE *out = tmpfile();
+    wav_info_t info, out_info;
+    uint32_t overruns = 0;
+    size_t fsize = channels * (bits / 8);
+    size_t buffer_frames = rate * buf_ms / 1000;
+
+    CHECK(wav_read_header(wav, &info) == 0, "WAV header");
+    int stages = render(out, &info, data, buf_ms, chunk, &overruns);
+    CHECK(overruns == 0, "%u underruns", overruns);
+    rewind(out);
+    CHECK(wav_read_header(out, &out_info) == 0, "output WAV header");
+    CHECK((out_info.channels == channels) && (out_info.bits == bits) && (out_info.rate == rate), "output WAV format");
+    CHECK(out_info.data_len == stages * buffer_frames * fsize, "output length %u, %d stages", out_info.data_len, stages);
+    played = malloc(out_info.data_len);
+    CHECK(fread(played, 1, out_info.data_len, out) == out_info.data_len, "output data");
+    // both buffers are played before the written data
+    size_t skip = 2 * buffer_frames * fsize;
+    for (size_t i=0; i<skip; i++) CHECK(played[i] == 0, "no silence at %zu", i);
+    CHECK(out_info.data_len >= skip + frames * fsize, "output too short");
+    CHECK(memcmp(played + skip, data, frames * fsize) == 0, "played data differs, %d ch, %d bit, chunk %zu", channels, bits, chunk);
+exit:
+    free(played);
+    free(data);
+    fclose(wav);
+    fclose(out);
+}
+
+// Data written before the start is played from the first DMA buffer, without the initial silence.
+// A partially prefilled buffer is played with silence after the written frames,
+// stop() discards the data not played yet.
+static void test_render_prefill(void)
+{
+    uint8_t *data, *played = NULL;
+    FILE *wav = make_wav(2, 16, 16000, 1000, &data);
+    FILE *out = tmpfile();
+    audio_format_t format = {AUDIO_FMT_PCM, 16, 16000, 2};
+    wav_info_t out_info;
+    handle_t h = i2s_host_open();
+
+    // 160 frames (640 bytes) in each buffer
+    i2s_config_as_render(h, &format, 10, I2S_AM_STANDARD, 3);
+    i2s_host_set_output(h, out);
+    CHECK(i2s_buffer_transfer(h, data, 1000 * 4, 4, false) == 320 * 4, "prefill of both buffers");
+    CHECK(i2s_buffer_transfer(h, data, 1000 * 4, 4, false) == 0, "written after the prefill");
+    i2s_start(h);
+    CHECK(i2s_buffer_transfer(h, data, 1000 * 4, 4, false) == 0, "buffer available before the first stage");
+    size_t pos = 320 * 4;
+    // buffers 1, 2, 3 ...
+    for (int i=0; i<3; i++) {
+        CHECK(i2s_host_dma_stage(h) == 160, "stage %d", i);
+        CHECK(i2s_buffer_transfer(h, data + pos, 1000 * 4 - pos, 4, false) == 160 * 4, "write after stage %d", i);
+        pos += 160 * 4;
+    }
+    CHECK(i2s_host_overruns(h) == 0, "underrun");
+    // 800 frames written, 480 played, the rest is discarded
+    i2s_stop(h);
+
+    // 100 frames, the rest of the buffer is silent
+    CHECK(i2s_buffer_transfer(h, data, 100 * 4, 4, false) == 100 * 4, "partial prefill");
+    i2s_start(h);
+    CHECK(i2s_host_dma_stage(h) == 160, "partial buffer");
+    i2s_stop(h);
+    i2s_host_close(h);
+    h = 0;
+
+    rewind(out);
+    CHECK(wav_read_header(out, &out_info) == 0, "output WAV header");
+    CHECK(out_info.data_len == (480 + 160) * 4, "output length %u", out_info.data_len);
+    played = malloc(out_info.data_len);
+    CHECK(fread(played, 1, out_info.data_len, out) == out_info.data_len, "output data");
+    CHECK(memcmp(played, data, 480 * 4) == 0, "prefilled data not played first");
+    CHECK(memcmp(played + 480 * 4, data, 100 * 4) == 0, "partial buffer data");
+    for (size_t i=580 * 4; i<640 * 4; i++) CHECK(played[i] == 0, "no silence at %zu", i);
+exit:
+    if (h) i2s_host_close(h);
+    free(played);
+    free(data);
+    fclose(wav);
+    fclose(out);
+}
+
+// Capture the WAV file and render it back, the sample data must be unchanged
+static void test_wav_file(const char *fname)
+{
+    FILE *wav = fopen(fname, "rb");
+    FILE *out = NULL;
+    uint8_t *data = NULL, *captured = NULL, *played = NULL;
+    wav_info_t info, out_info;
+    size_t n_frames = 0;
+    uint32_t overruns = 0;
+
+    CHECK(wav != NULL, "%s: can not open", fname);
+    CHECK(wav_read_header(wav, &info) == 0, "%s: not a 16/24/32-bit PCM WAV file", fname);
+    CHECK((info.channels >= 2) && (info.channels <= 8) && ((info.channels & 1) == 0), "%s: 2, 4, 6 or 8 channels required", fname);
+    data = malloc(info.data_len + 1);
+    CHECK(fread(data, 1, info.data_len, wav) == info.data_len, "%s: short file", fname);
+    fseek(wav, 0, SEEK_SET);
+
+    size_t fsize = info.channels * (info.bits / 8);
+    size_t frames = info.data_len / fsize;
+    captured = capture(wav, &info, 50, 0, &n_frames, &overruns);
+    CHECK(captured != NULL, "%s: capture", fname);
+    CHECK((overruns == 0) && (n_frames >= frames), "%s: capture dropouts", fname);
+    CHECK(memcmp(captured, data, frames * fsize) == 0, "%s: captured data differs", fname);
+
+    out = tmpfile();
+    info.data_len = frames * fsize;
+    render(out, &info, captured, 50, 4096, &overruns);
+    CHECK(overruns == 0, "%s: render dropouts", fname);
+    rewind(out);
+    CHECK(wav_read_header(out, &out_info) == 0, "%s: output header", fname);
+    played = malloc(out_info.data_len + 1);
+    CHECK(fread(played, 1, out_info.data_len, out) == out_info.data_len, "%s: output data", fname);
+    size_t skip = 2 * (info.rate * 50 / 1000) * fsize;
+    CHECK(out_info.data_len >= skip + info.data_len, "%s: output too short", fname);
+    CHECK(memcmp(played + skip, data, info.data_len) == 0, "%s: rendered data differs", fname);
+    printf("i2s: %s: %zu frames, %u Hz, %u bit, %u channels, captured and rendered\n", fname, frames, info.rate, info.bits, info.channels);
+exit:
+    free(played);
+    free(captured);
+    free(data);
+    if (out) fclose(out);
+    if (wav) fclose(wav);
+}
+
+int main(int argc, char *argv[])
+{
+    static const int formats[][2] = { {2, 16}, {2, 24}, {2, 32}, {4, 16}, {8, 32}, {6, 24} };
+    static const size_t chunks[] = { 0, 4096, 1000, 192000 };
+
+    for (int f=0; f<6; f++) {
+        for (int c=0; c<4; c++) {
+            test_capture(formats[f][0], formats[f][1], 48000, 20, chunks[c]);
+            test_render(formats[f][0], formats[f][1], 48000, 20, (chunks[c]) ? chunks[c] : 777);
+        }
+    }
+    test_capture(2, 16, 8000, 13, 0);
+    test_capture(2, 32, 192000, 1, 0);
+    test_render(2, 16, 22050, 7, 333);
+    test_capture_overrun();
+    test_render_prefill();
+    for (int i=1; i<argc; i++) test_wav_file(argv[i]);
+
+    if (failed) {
+        printf("i2s: %d test(s) failed\n", failed);
+        return 1;
+    }
+    printf("i2s: OK\n");
+    return 0;
+}
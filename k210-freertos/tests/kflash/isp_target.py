@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+#
+# Simulated K210 board for kflash.py, installed as the 'serial' module
+#
+# Before the reset into ISP mode the board runs the MicroPython raw REPL,
+# 'machine.flash_crc(address, size)' returns the CRC32 of each 4 KB sector of the Flash.
+# After DTR/RTS are used the board answers the ISP ROM and flash stub SLIP frames,
+# 0xD4 frames are written to the Flash. As on the board, each 32-bit word of the written
+# data is read back byte swapped.
+#
+#   repl = 'crc'        flash_crc() is available
+#   repl = 'no_crc'     the firmware has no flash_crc(), AttributeError is reported
+#   repl = 'none'       the board does not answer on the REPL
+#
+
+import sys
+import re
+import types
+import struct
+import binascii
+
+FLASH_SIZE = 16 * 1024 * 1024
+SECTOR_SIZE = 4096
+
+#-----------------
+class Target:
+    def __init__(self):
+        self.flash = bytearray(b'\xff' * FLASH_SIZE)
+        self.repl = 'crc'
+        self.ResetStats()
+
+    def ResetStats(self):
+        self.written = 0        # bytes written to the Flash
+        self.frames = 0         # 0xD4 frames
+        self.sectors = set()    # written sectors
+        self.isp_bytes = 0      # bytes sent in ISP mode
+        self.isp_time = 0.0     # time needed to send them at the used baudrate
+
+target = Target()
+
+#-----------------
+def wswap(data):
+    n = len(data) // 4
+    return struct.pack('<%dI' % n, *struct.unpack('>%dI' % n, data))
+
+#-----------------------
+class Serial:
+    def __init__(self, port=None, baudrate=115200, **kwargs):
+        self.baudrate = baudrate
+        self.timeout = kwargs.get('timeout', 0.1)
+        self.out = bytearray()
+        self.rx = bytearray()
+        self.isp = False
+        self.raw = False
+        self.cmd = b''
+
+    def isOpen(self):
+        return True
+
+    def close(self):
+        pass
+
+    def setDTR(self, value):
+        self.isp = True
+
+    def setRTS(self, value):
+        self.isp = True
+
+    def inWaiting(self):
+        return len(self.out)
+
+    @property
+    def in_waiting(self):
+        return len(self.out)
+
+    def flushInput(self):
+        self.out.clear()
+
+    reset_input_buffer = flushInput
+
+    def flushOutput(self):
+        pass
+
+    def read(self, size=1):
+        data = bytes(self.out[:size])
+        del self.out[:size]
+        return data
+
+    def write(self, data):
+        if not self.isp:
+            if target.repl != 'none':
+                self.Repl(data)
+            return len(data)
+        target.isp_bytes += len(data)
+        target.isp_time += len(data) * 10 / self.baudrate
+        self.rx += data
+        while True:
+            start = self.rx.find(b'\xc0')
+            if start < 0:
+                break
+            end = self.rx.find(b'\xc0', start + 1)
+            if end < 0:
+                break
+            pkt = bytes(self.rx[start+1:end]).replace(b'\xdb\xdc', b'\xc0').replace(b'\xdb\xdd', b'\xdb')
+            del self.rx[:end+1]
+            if pkt:
+                self.Isp(pkt)
+        return len(data)
+
+    #------------------------
+    def Repl(self, data):
+        for c in data:
+            if c == 0x01:
+                self.raw = True
+                self.cmd = b''
+                self.out += b'\r\nraw REPL; CTRL-B to exit\r\n>'
+            elif c == 0x02:
+                self.raw = False
+            elif (c == 0x04) and self.raw:
+                self.out += b'OK' + self.Execute(self.cmd.decode()) + b'\x04>'
+                self.cmd = b''
+            elif self.raw:
+                self.cmd += bytes([c])
+
+    def Execute(self, cmd):
+        # Returns the output and the error message of the command
+        m = re.search(r'machine\.flash_crc\((\d+), (\d+)\)', cmd)
+        if m is None:
+            return b'\x04Traceback (most recent call last):\r\nSyntaxError: invalid syntax\r\n'
+        if target.repl == 'no_crc':
+            return b"\x04Traceback (most recent call last):\r\n  File \"<stdin>\", line 1, in <module>\r\nAttributeError: 'module' object has no attribute 'flash_crc'\r\n"
+        address, size = int(m.group(1)), int(m.group(2))
+        crc = b''.join(struct.pack('<I', binascii.crc32(target.flash[a:a+SECTOR_SIZE]) & 0xFFFFFFFF)
+                       for a in range(address, address + size, SECTOR_SIZE))
+        return binascii.hexlify(crc) + b'\r\n\x04'
+
+    #-----------------------
+    def Isp(self, pkt):
+        op = pkt[0]
+        if op == 0xd4:
+            if (binascii.crc32(pkt[8:]) & 0xFFFFFFFF) != struct.unpack('<I', pkt[4:8])[0]:
+                self.Reply(op, 0xe2)
+                return
+            address, size = struct.unpack('<II', pkt[8:16])
+            target.flash[address:address+size] = wswap(pkt[16:16+size])
+            target.written += size
+            target.frames += 1
+            target.sectors.update(range(address // SECTOR_SIZE, (address + size + SECTOR_SIZE - 1) // SECTOR_SIZE))
+        if op == 0xc5:
+            # boot, no response
+            return
+        self.Reply(op, 0xe0)
+
+    def Reply(self, op, status):
+        payload = bytes([op, status])
+        self.out += b'\xc0' + payload.replace(b'\xdb', b'\xdb\xdd').replace(b'\xc0', b'\xdb\xdc') + b'\xc0'
+
+#-------------
+def Install():
+    # Replace pyserial with the simulated board
+    serial = types.ModuleType('serial')
+    serial.Serial = Serial
+    serial.PARITY_NONE = 'N'
+    serial.STOPBITS_ONE = 1
+    serial.EIGHTBITS = 8
+    tools = types.ModuleType('serial.tools')
+    list_ports = types.ModuleType('serial.tools.list_ports')
+    list_ports.grep = lambda *args: iter([])
+    list_ports.comports = lambda *args: []
+    tools.list_ports = list_ports
+    serial.tools = tools
+    sys.modules['serial'] = serial
+    sys.modules['serial.tools'] = tools
+    sys.modules['serial.tools.list_ports'] = list_ports
@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+#
+# Tests of the kflash.py delta flashing (--delta) against the simulated board (isp_target.py)
+#
+#   test_kflash_delta.py            run the tests
+#   test_kflash_delta.py --bench    compare the delta and the full writes
+#
+# The images are made from firmware/MaixPy.kfpkg. After each delta write the Flash must
+# be the same as after the full write of the same image to an erased Flash.
+#
+
+import os
+import sys
+import io
+import re
+import random
+import zipfile
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import isp_target
+isp_target.Install()
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", ".."))
+import kflash
+
+KFPKG = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "..", "firmware", "MaixPy.kfpkg")
+
+#---------------------
+def Run(args, repl='crc'):
+    # Run kflash.py, returns its output, None if it exited with an error
+    isp_target.target.repl = repl
+    isp_target.target.ResetStats()
+    sys.argv = ['kflash.py', '-p', 'sim', '-B', 'dan'] + args
+    stdout = sys.stdout
+    sys.stdout = io.StringIO()
+    try:
+        kflash.KFlash().process()
+        out = sys.stdout.getvalue()
+    except SystemExit:
+        out = None
+    finally:
+        sys.stdout = stdout
+    return out
+
+#-----------------------
+def Reference(args):
+    # Flash content after the full write to an erased Flash
+    saved = isp_target.target.flash
+    isp_target.target.flash = bytearray(b'\xff' * isp_target.FLASH_SIZE)
+    Run(args)
+    ref = isp_target.target.flash
+    isp_target.target.flash = saved
+    return ref
+
+#------------------
+def Images(tmpdir):
+    # Returns the file names of the test images
+    rand = random.Random(1)
+    with zipfile.ZipFile(KFPKG) as zf:
+        flash_list = zf.read('flash-list.json')
+        fw = zf.read('MaixPy.bin')
+        lfs = zf.read('maixpy_lfs.img')
+
+    def Package(name, fw, lfs):
+        fname = os.path.join(tmpdir, name)
+        with zipfile.ZipFile(fname, 'w') as zf:
+            zf.writestr('flash-list.json', flash_list)
+            zf.writestr('MaixPy.bin', fw)
+            zf.writestr('maixpy_lfs.img', lfs)
+        return fname
+
+    images = {}
+    images['v1'] = Package('v1.kfpkg', fw, lfs)
+    # patched version string and one changed littlefs block
+    fw2 = bytearray(fw)
+    fw2[700000:700008] = b'v2.0.1\x00\x00'
+    lfs2 = bytearray(lfs)
+    lfs2[0x20000:0x20200] = bytes(rand.getrandbits(8) for _ in range(0x200))
+    images['patch'] = Package('patch.kfpkg', bytes(fw2), bytes(lfs2))
+    # rebuilt firmware, the code inserted in the middle moves the rest
+    fw3 = fw[:700000] + bytes(rand.getrandbits(8) for _ in range(300)) + fw[700000:]
+    images['insert'] = Package('insert.kfpkg', fw3, bytes(lfs2))
+    images['bin'] = os.path.join(tmpdir, 'fw.bin')
+    with open(images['bin'], 'wb') as f:
+        f.write(bytes(fw2))
+    return images
+
+#------------
+def Tests():
+    failed = 0
+
+    def Check(name, cond, msg=''):
+        nonlocal failed
+        if not cond:
+            print("FAIL {}: {}".format(name, msg))
+            failed += 1
+
+    target = isp_target.target
+    with tempfile.TemporaryDirectory() as tmpdir:
+        images = Images(tmpdir)
+        out = Run([images['v1']])
+        full = target.written
+        Check("full write", (out is not None) and (full > 0), "not written")
+
+        # each image is written by delta over the previous one
+        for name, pkg, max_sectors in (("patch", images['patch'], 4), ("insert", images['insert'], 200),
+                                       ("unchanged", images['insert'], 0)):
+            ref = Reference([pkg])
+            out = Run(['--delta', pkg])
+            Check(name, out is not None, "kflash failed")
+            Check(name, target.flash == ref, "Flash differs from the full write")
+            Check(name, len(target.sectors) <= max_sectors, "{} sectors written".format(len(target.sectors)))
+            Check(name, len(re.findall(r'Delta: \d+ of \d+ sectors changed', out or '')) == 2, "no delta report")
+
+        # single binary at address 0, over the v1 image
+        # the patched sector and the last one, holding the SHA256 of the image, are written
+        Run([images['v1']])
+        ref = Reference([images['bin']])
+        out = Run(['--delta', images['bin']])
+        size = (os.path.getsize(images['bin']) + 37 + isp_target.SECTOR_SIZE - 1) & ~(isp_target.SECTOR_SIZE - 1)
+        Check("bin", target.flash[:size] == ref[:size], "Flash differs from the full write")
+        Check("bin", len(target.sectors) == 2, "{} sectors written".format(len(target.sectors)))
+
+        # firmware without flash_crc, or not responding: all sectors are written
+        for name, repl in (("no flash_crc", 'no_crc'), ("no REPL", 'none')):
+            out = Run(['--delta', images['v1']], repl=repl)
+            Check(name, out is not None, "kflash failed")
+            Check(name, 'all sectors will be written' in (out or ''), "no fallback warning")
+            Check(name, target.written == full, "{} of {} bytes written".format(target.written, full))
+            Check(name, target.flash == Reference([images['v1']]), "Flash differs from the full write")
+
+    if failed:
+        print("kflash_delta: {} test(s) failed".format(failed))
+        return 1
+    print("kflash_delta: OK")
+    return 0
+
+#--------
+def Bench():
+    target = isp_target.target
+    with tempfile.TemporaryDirectory() as tmpdir:
+        images = Images(tmpdir)
+        Run([images['v1']])
+        full, full_time = target.written, target.isp_time
+        print("kflash delta write, MaixPy.kfpkg, {} KB full write, {:.1f} s at 115200 baud".format(full // 1024, full_time))
+        print("{:<26} {:>8} {:>10} {:>8} {:>10}".format("image", "sectors", "written KB", "% full", "time s"))
+        for name, pkg in (("version string + lfs block", images['patch']), ("300 bytes inserted", images['insert']),
+                          ("unchanged", images['insert'])):
+            ref = Reference([pkg])
+            if Run(['--delta', pkg]) is None or target.flash != ref:
+                print("delta write failed")
+                return 1
+            print("{:<26} {:>8} {:>10} {:>8.1f} {:>10.1f}".format(name, len(target.sectors), target.written // 1024,
+                  target.written * 100 / full, target.isp_time))
+    return 0
+
+if __name__ == '__main__':
+    if (len(sys.argv) == 2) and (sys.argv[1] == "--bench"):
+        sys.exit(Bench())
+    if len(sys.argv) != 1:
+        print("usage: test_kflash_delta.py [--bench]")
+        sys.exit(2)
+    sys.exit(Tests())
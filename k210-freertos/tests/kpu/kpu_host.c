@@ -0,0 +1,95 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "FreeRTOS.h"
+#include "kpu_host.h"
+
+volatile unsigned int kpu_host_give_delay_us = 0;
+
+// ==== FreeRTOS ====
+
+struct host_semaphore {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    int given;
+};
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    SemaphoreHandle_t sem = calloc(1, sizeof(struct host_semaphore));
+    if (sem == NULL) return NULL;
+    pthread_mutex_init(&sem->lock, NULL);
+    pthread_cond_init(&sem->changed, NULL);
+    return sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    if (wait != portMAX_DELAY) {
+        deadline.tv_sec += wait / 1000;
+        deadline.tv_nsec += (wait % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+    pthread_mutex_lock(&sem->lock);
+    while (!sem->given) {
+        if (wait == 0) break;
+        if (wait == portMAX_DELAY) pthread_cond_wait(&sem->changed, &sem->lock);
+        else if (pthread_cond_timedwait(&sem->changed, &sem->lock, &deadline) == ETIMEDOUT) break;
+    }
+    BaseType_t res = (sem->given) ? pdTRUE : pdFALSE;
+    sem->given = 0;
+    pthread_mutex_unlock(&sem->lock);
+    return res;
+}
+
+// As the FreeRTOS binary semaphore, giving the already given semaphore fails
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (kpu_host_give_delay_us) usleep(kpu_host_give_delay_us);
+    pthread_mutex_lock(&sem->lock);
+    BaseType_t res = (sem->given) ? pdFALSE : pdTRUE;
+    sem->given = 1;
+    pthread_cond_broadcast(&sem->changed);
+    pthread_mutex_unlock(&sem->lock);
+    return res;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    pthread_cond_destroy(&sem->changed);
+    pthread_mutex_destroy(&sem->lock);
+    free(sem);
+}
@@ -0,0 +1,157 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host tests of the synchronization between the kpu.Model object and its inference task
+ * (mpy_support/standard_lib/kpu/kpu_runner.c)
+ * The inference task runs in its own thread, the token given back after the inference
+ * is delayed to catch the waits returning before the inference they wait for is finished.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "kpu_runner.h"
+#include "kpu_host.h"
+
+static int failed = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failed++; \
+        return; \
+    } } while (0)
+
+#define RACE_RUNS   2000
+
+static void test_basic(void)
+{
+    kpu_runner_t runner;
+    CHECK(kpu_runner_init(&runner), "init failed");
+    CHECK(kpu_runner_done(&runner), "not done after init");
+    CHECK(kpu_runner_wait(&runner, 0), "wait failed with no inference");
+
+    CHECK(kpu_runner_start(&runner, 0), "start failed");
+    CHECK(!kpu_runner_done(&runner), "done while running");
+    CHECK(!kpu_runner_wait(&runner, 0), "wait returned while running");
+    CHECK(!kpu_runner_wait(&runner, 20), "wait with timeout returned while running");
+    CHECK(!kpu_runner_start(&runner, 0), "second inference started while running");
+
+    kpu_runner_finish(&runner);
+    CHECK(kpu_runner_done(&runner), "not done after finish");
+    // repeated waits all return, the token is kept
+    for (int i = 0; i < 3; i++) {
+        CHECK(kpu_runner_wait(&runner, 0), "wait %d failed after finish", i);
+    }
+    CHECK(kpu_runner_start(&runner, 0), "start failed after wait");
+    kpu_runner_finish(&runner);
+    kpu_runner_deinit(&runner);
+    CHECK(runner.idle_sem == NULL, "semaphore not deleted");
+}
+
+// ==== Inference task ====
+
+typedef struct {
+    kpu_runner_t runner;
+    SemaphoreHandle_t request;
+    volatile int seq;           // inference requested by the main thread
+    volatile int result;        // last finished inference
+    volatile bool exit;
+} race_ctx_t;
+
+static void *inference_task(void *arg)
+{
+    race_ctx_t *ctx = arg;
+    while (1) {
+        xSemaphoreTake(ctx->request, portMAX_DELAY);
+        if (ctx->exit) break;
+        usleep(50);
+        ctx->result = ctx->seq;
+        kpu_runner_finish(&ctx->runner);
+    }
+    return NULL;
+}
+
+// Each inference is started as soon as the previous one is seen as finished,
+// either by 'done()' polling or by 'wait()'. The result seen after the wait
+// must always be the one of the last started inference.
+static void test_task_race(void)
+{
+    race_ctx_t ctx = { .seq = -1, .result = -1 };
+    pthread_t task;
+    CHECK(kpu_runner_init(&ctx.runner), "init failed");
+    ctx.request = xSemaphoreCreateBinary();
+    CHECK(pthread_create(&task, NULL, inference_task, &ctx) == 0, "task not started");
+    kpu_host_give_delay_us = 100;
+
+    int stale = 0, polled = 0;
+    for (int i = 0; i < RACE_RUNS; i++) {
+        if (!kpu_runner_start(&ctx.runner, 1000)) {
+            stale = -1;
+            break;
+        }
+        ctx.seq = i;
+        xSemaphoreGive(ctx.request);
+        if (i & 1) {
+            while (!kpu_runner_done(&ctx.runner)) usleep(1);
+            if (ctx.result != i) polled++;
+        }
+        else {
+            if (!kpu_runner_wait(&ctx.runner, 1000)) {
+                stale = -1;
+                break;
+            }
+            if (ctx.result != i) stale++;
+        }
+    }
+    kpu_host_give_delay_us = 0;
+    kpu_runner_wait(&ctx.runner, 1000);
+    ctx.exit = true;
+    xSemaphoreGive(ctx.request);
+    pthread_join(task, NULL);
+    vSemaphoreDelete(ctx.request);
+    kpu_runner_deinit(&ctx.runner);
+
+    CHECK(stale >= 0, "start or wait timed out");
+    CHECK(polled == 0, "%d inference(s) seen done before the result was stored", polled);
+    CHECK(stale == 0, "%d of %d wait(s) returned before the inference was finished", stale, RACE_RUNS / 2);
+}
+
+int main(void)
+{
+    test_basic();
+    test_task_race();
+    if (failed) {
+        printf("kpu_runner: %d test(s) failed\n", failed);
+        return 1;
+    }
+    printf("kpu_runner: OK\n");
+    return 0;
+}
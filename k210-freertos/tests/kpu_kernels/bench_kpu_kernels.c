@@ -0,0 +1,94 @@
+/* Copyright 2019 LoBo (https://github.com/loboris)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host benchmark of the KPU CPU kernels against the reference scalar loops
+ * Layer sizes are those of the typical model tails (mobilenet classifier,
+ * yolo upsample), the time is the best of 'BENCH_RUNS' runs.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "kpu_reference.h"
+
+#define BENCH_RUNS  20
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+#define BENCH(name, ref_call, kernel_call) do { \
+    double best_ref = 1e30, best_kernel = 1e30; \
+    for (int r = 0; r < BENCH_RUNS; r++) { \
+        double t0 = now_us(); \
+        ref_call; \
+        double t1 = now_us(); \
+        kernel_call; \
+        double t2 = now_us(); \
+        if ((t1 - t0) < best_ref) best_ref = t1 - t0; \
+        if ((t2 - t1) < best_kernel) best_kernel = t2 - t1; \
+    } \
+    printf("%-28s %10.1f %10.1f %7.2fx\n", name, best_ref, best_kernel, best_ref / best_kernel); \
+} while (0)
+
+int main(void)
+{
+    uint32_t seed = 1;
+    uint32_t in_ch = 1024, out_ch = 1000;
+    float *src = malloc(in_ch * sizeof(float));
+    float *weights = malloc(in_ch * out_ch * sizeof(float));
+    float *bias = malloc(out_ch * sizeof(float));
+    float *dest = malloc(416 * 416 * sizeof(float));
+    uint8_t *qa = malloc(65536), *qb = malloc(65536), *qo = malloc(65536), table[256];
+
+    for (uint32_t i = 0; i < in_ch; i++)
+        src[i] = ref_randf(&seed, -4.0f, 4.0f);
+    for (uint32_t i = 0; i < in_ch * out_ch; i++)
+        weights[i] = ref_randf(&seed, -1.0f, 1.0f);
+    for (uint32_t i = 0; i < out_ch; i++)
+        bias[i] = ref_randf(&seed, -1.0f, 1.0f);
+    for (uint32_t i = 0; i < 65536; i++)
+    {
+        qa[i] = ref_rand(&seed);
+        qb[i] = ref_rand(&seed);
+    }
+    for (uint32_t i = 0; i < 256; i++)
+        table[i] = ref_rand(&seed);
+    kpu_kernel_quant_add_param_t qp = { -128, 3, 2, -100, 5, 2, 7, 11, 4 };
+
+    printf("%-28s %10s %10s %8s\n", "kernel (us)", "reference", "kernel", "speedup");
+    BENCH("fully_connected 1024x1000",
+          ref_fully_connected(src, dest, weights, bias, in_ch, out_ch),
+          kpu_kernel_fully_connected(src, dest, weights, bias, in_ch, out_ch));
+    BENCH("softmax 1000",
+          ref_softmax(weights, dest, 1000),
+          kpu_kernel_softmax(weights, dest, 1000));
+    BENCH("quantized_add 65536",
+          ref_quantized_add(qa, qb, qo, 65536, &qp),
+          kpu_kernel_quantized_add(qa, qb, qo, 65536, &qp));
+    BENCH("requantize 65536",
+          ref_requantize(qa, qo, 65536, table),
+          kpu_kernel_requantize(qa, qo, 65536, table));
+    BENCH("resize 13x13x256 -> 26x26",
+          ref_resize_nearest_neighbor(weights, dest, 13, 13, 256, 26, 26),
+          kpu_kernel_resize_nearest_neighbor(weights, dest, 13, 13, 256, 26, 26));
+
+    free(src); free(weights); free(bias); free(dest);
+    free(qa); free(qb); free(qo);
+    return 0;
+}
@@ -0,0 +1,144 @@
+/* Copyright 2019 LoBo (https://github.com/loboris)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Reference implementations of the KPU CPU layers,
+ * the scalar loops kpu.cpp used before the kernel library
+ */
+#ifndef _KPU_REFERENCE_H
+#define _KPU_REFERENCE_H
+
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <kpu_kernels.h>
+
+#define REF_MIN(a, b) (((a) < (b)) ? (a) : (b))
+#define REF_MAX(a, b) (((a) > (b)) ? (a) : (b))
+
+static inline void ref_fully_connected(const float *src, float *dest, const float *weights, const float *bias, uint32_t in_channels, uint32_t out_channels)
+{
+    uint32_t ic, oc;
+    for (oc = 0; oc < out_channels; oc++)
+    {
+        const float *c_weights = weights + oc * in_channels;
+
+        float sum = 0.0f;
+        for (ic = 0; ic < in_channels; ic++)
+            sum += src[ic] * c_weights[ic];
+        dest[oc] = sum + bias[oc];
+    }
+}
+
+// expf() based, with the -FLT_MAX initial maximum
+static inline void ref_softmax(const float *src, float *dest, size_t channels)
+{
+    size_t oc;
+    float max = -FLT_MAX;
+    for (oc = 0; oc < channels; oc++)
+        max = fmaxf(max, src[oc]);
+
+    float sum = 0.f;
+    for (oc = 0; oc < channels; oc++)
+    {
+        float value = expf(src[oc] - max);
+        sum += value;
+        dest[oc] = value;
+    }
+
+    for (oc = 0; oc < channels; oc++)
+        dest[oc] /= sum;
+}
+
+// all 'count' values (the old unrolled loop stopped after count/8)
+static inline void ref_quantized_add(const uint8_t *src_a, const uint8_t *src_b, uint8_t *dest, size_t count, const kpu_kernel_quant_add_param_t *p)
+{
+    int64_t off_a = p->in_a_offset, mul_a = p->in_a_mul, sh_a = p->in_a_shift;
+    int64_t off_b = p->in_b_offset, mul_b = p->in_b_mul, sh_b = p->in_b_shift;
+    int64_t off_o = p->out_offset, mul_o = p->out_mul, sh_o = p->out_shift;
+    size_t i;
+
+    count = (count + 7) & ~(size_t)7;
+    for (i = 0; i < count; i++)
+    {
+        int64_t a = ((int64_t)src_a[i] + off_a) * mul_a;
+        int64_t b = ((int64_t)src_b[i] + off_b) * mul_b;
+        int64_t v;
+        if (sh_a == sh_b)
+            v = (a + b) >> sh_a;
+        else
+            v = (a >> sh_a) + (b >> sh_b);
+        v = ((v * mul_o) >> sh_o) + off_o;
+        dest[i] = (uint8_t)REF_MIN(0xFF, REF_MAX(0, v));
+    }
+}
+
+static inline void ref_requantize(const uint8_t *src, uint8_t *dest, size_t count, const uint8_t *table)
+{
+    size_t i;
+    count = (count + 7) & ~(size_t)7;
+    for (i = 0; i < count; i++)
+        dest[i] = table[src[i]];
+}
+
+static inline void ref_resize_nearest_neighbor(const float *src, float *dest, uint32_t in_width, uint32_t in_height, uint32_t channels, uint32_t out_width, uint32_t out_height)
+{
+    uint32_t oc, oy, ox;
+    float height_scale = (float)in_height / out_height;
+    float width_scale = (float)in_width / out_width;
+
+    for (oc = 0; oc < channels; oc++)
+    {
+        const float *channel_src = src + in_width * in_height * oc;
+        for (oy = 0; oy < out_height; oy++)
+        {
+            uint32_t in_y = (uint32_t)REF_MIN(floorf(oy * height_scale), in_height - 1);
+            const float *y_origin = channel_src + in_y * in_width;
+            for (ox = 0; ox < out_width; ox++)
+            {
+                uint32_t in_x = (uint32_t)REF_MIN(floorf(ox * width_scale), in_width - 1);
+                *dest++ = y_origin[in_x];
+            }
+        }
+    }
+}
+
+static inline void ref_concat(const uint8_t *base, const uint32_t *ranges, uint32_t count, uint8_t *dest)
+{
+    uint32_t i;
+    for (i = 0; i < count; i++)
+    {
+        memcpy(dest, base + ranges[i * 2], ranges[i * 2 + 1]);
+        dest += ranges[i * 2 + 1];
+    }
+}
+
+// xorshift32, the same sequence on every host
+static inline uint32_t ref_rand(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static inline float ref_randf(uint32_t *state, float lo, float hi)
+{
+    return lo + (hi - lo) * (float)(ref_rand(state) >> 8) / (float)(1 << 24);
+}
+
+#endif /* _KPU_REFERENCE_H */
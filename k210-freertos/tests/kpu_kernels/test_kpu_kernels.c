@@ -0,0 +1,228 @@
+/* Copyright 2019 LoBo (https://github.com/loboris)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host tests of the KPU CPU kernels against the reference scalar loops
+ * The integer and data movement kernels, and the fully connected layer
+ * (same accumulation order) must be bit-exact, the table based exp() and
+ * softmax must be within the documented relative error.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "kpu_reference.h"
+
+static int failed = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failed++; \
+        return; \
+    } } while (0)
+
+static void test_fully_connected(void)
+{
+    static const uint32_t sizes[][2] = { {1, 1}, {3, 5}, {17, 4}, {64, 10}, {1024, 1000}, {7, 1023} };
+    uint32_t seed = 1;
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        uint32_t in_ch = sizes[s][0], out_ch = sizes[s][1];
+        float *src = malloc(in_ch * sizeof(float));
+        float *weights = malloc(in_ch * out_ch * sizeof(float));
+        float *bias = malloc(out_ch * sizeof(float));
+        float *ref = malloc(out_ch * sizeof(float));
+        float *out = malloc(out_ch * sizeof(float));
+        for (uint32_t i = 0; i < in_ch; i++)
+            src[i] = ref_randf(&seed, -4.0f, 4.0f);
+        for (uint32_t i = 0; i < in_ch * out_ch; i++)
+            weights[i] = ref_randf(&seed, -1.0f, 1.0f);
+        for (uint32_t i = 0; i < out_ch; i++)
+            bias[i] = ref_randf(&seed, -1.0f, 1.0f);
+
+        ref_fully_connected(src, ref, weights, bias, in_ch, out_ch);
+        kpu_kernel_fully_connected(src, out, weights, bias, in_ch, out_ch);
+        int same = (memcmp(ref, out, out_ch * sizeof(float)) == 0);
+        free(src); free(weights); free(bias); free(ref); free(out);
+        CHECK(same, "%ux%u not bit-exact", in_ch, out_ch);
+    }
+}
+
+static void test_exp(void)
+{
+    // the whole float range the softmax uses, and the edges of the table
+    float max_err = 0.0f;
+    for (float x = -87.0f; x <= 88.0f; x += 0.001f)
+    {
+        float e = expf(x), v = kpu_kernel_exp(x);
+        float err = fabsf(v - e) / e;
+        if (err > max_err) max_err = err;
+    }
+    CHECK(max_err < 1e-5f, "relative error %g", max_err);
+
+    // t - floor(t) rounds to 1.0f, the table index must stay in range
+    float tiny[] = { nextafterf(0.1f, 0.0f) - 0.1f, -FLT_MIN, -1e-30f, -1e-10f, -0.0f, 0.0f };
+    for (size_t i = 0; i < sizeof(tiny) / sizeof(tiny[0]); i++)
+    {
+        float v = kpu_kernel_exp(tiny[i]);
+        CHECK(fabsf(v - 1.0f) < 1e-5f, "exp(%g) = %g", tiny[i], v);
+    }
+    for (int k = 0; k < 100000; k++)
+    {
+        uint32_t seed = k + 1;
+        float x = -ref_randf(&seed, 0.0f, 1.0f) * ldexpf(1.0f, -(k % 120));
+        float v = kpu_kernel_exp(x), e = expf(x);
+        CHECK(fabsf(v - e) / e < 1e-5f, "exp(%g) = %g, expected %g", x, v, e);
+    }
+
+    CHECK(kpu_kernel_exp(-100.0f) == 0.0f, "underflow");
+    CHECK(kpu_kernel_exp(-INFINITY) == 0.0f, "-inf");
+    CHECK(isinf(kpu_kernel_exp(89.0f)), "overflow");
+    CHECK(isinf(kpu_kernel_exp(INFINITY)), "+inf");
+    CHECK(isnan(kpu_kernel_exp(NAN)), "nan");
+}
+
+static void test_softmax(void)
+{
+    static const size_t sizes[] = { 1, 2, 10, 1000 };
+    uint32_t seed = 2;
+    float src[1000], ref[1000], out[1000];
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        size_t n = sizes[s];
+        for (size_t i = 0; i < n; i++)
+            src[i] = ref_randf(&seed, -20.0f, 20.0f);
+        ref_softmax(src, ref, n);
+        kpu_kernel_softmax(src, out, n);
+        for (size_t i = 0; i < n; i++)
+            CHECK(fabsf(out[i] - ref[i]) <= 2e-5f * ref[i] + 1e-30f, "n=%zu [%zu] %g != %g", n, i, out[i], ref[i]);
+    }
+
+    // all values negative, the old FLT_MIN initial maximum was wrong here
+    for (size_t i = 0; i < 10; i++)
+        src[i] = -100.0f - i;
+    kpu_kernel_softmax(src, out, 10);
+    CHECK(fabsf(out[0] - 0.632149f) < 1e-5f, "negative inputs %g", out[0]);
+}
+
+static void test_quantized_add(void)
+{
+    static const kpu_kernel_quant_add_param_t params[] = {
+        { -128, 3, 2, -100, 5, 2, 7, 11, 4 },
+        { 0, 1, 0, 0, 1, 0, 0, 1, 1 },
+        { 12, 1 << 20, 18, -7, 1 << 19, 17, -3, 29, 6 },
+        { -255, 17, 3, 255, 9, 5, 128, 1 << 12, 14 },
+    };
+    static const size_t counts[] = { 1, 7, 8, 9, 64, 1001 };
+    static uint8_t a[1008], b[1008], ref[1008], out[1008];
+    uint32_t seed = 3;
+
+    for (size_t i = 0; i < sizeof(a); i++)
+    {
+        a[i] = ref_rand(&seed);
+        b[i] = ref_rand(&seed);
+    }
+    for (size_t p = 0; p < sizeof(params) / sizeof(params[0]); p++)
+    {
+        for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+        {
+            memset(ref, 0xAA, sizeof(ref));
+            memset(out, 0xAA, sizeof(out));
+            ref_quantized_add(a, b, ref, counts[c], &params[p]);
+            kpu_kernel_quantized_add(a, b, out, counts[c], &params[p]);
+            CHECK(memcmp(ref, out, sizeof(ref)) == 0, "params %zu count %zu", p, counts[c]);
+        }
+    }
+}
+
+static void test_requantize(void)
+{
+    static const size_t counts[] = { 1, 8, 13, 4096 };
+    static uint8_t src[4096], ref[4096], out[4096], table[256];
+    uint32_t seed = 4;
+
+    for (size_t i = 0; i < sizeof(src); i++)
+        src[i] = ref_rand(&seed);
+    for (size_t i = 0; i < sizeof(table); i++)
+        table[i] = ref_rand(&seed);
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+        memset(ref, 0, sizeof(ref));
+        memset(out, 0, sizeof(out));
+        ref_requantize(src, ref, counts[c], table);
+        kpu_kernel_requantize(src, out, counts[c], table);
+        CHECK(memcmp(ref, out, sizeof(ref)) == 0, "count %zu", counts[c]);
+    }
+}
+
+static void test_resize_nearest_neighbor(void)
+{
+    // in w, h, channels, out w, h; the last one doesn't use the column table
+    static const uint32_t sizes[][5] = {
+        { 4, 4, 1, 8, 8 }, { 13, 7, 3, 26, 14 }, { 20, 20, 2, 7, 5 },
+        { 1, 1, 4, 5, 3 }, { 10, 6, 2, 10, 6 }, { 300, 2, 1, 600, 3 },
+    };
+    uint32_t seed = 5;
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        uint32_t iw = sizes[s][0], ih = sizes[s][1], ch = sizes[s][2], ow = sizes[s][3], oh = sizes[s][4];
+        float *src = malloc(iw * ih * ch * sizeof(float));
+        float *ref = malloc(ow * oh * ch * sizeof(float));
+        float *out = malloc(ow * oh * ch * sizeof(float));
+        for (uint32_t i = 0; i < iw * ih * ch; i++)
+            src[i] = ref_randf(&seed, -1.0f, 1.0f);
+        ref_resize_nearest_neighbor(src, ref, iw, ih, ch, ow, oh);
+        kpu_kernel_resize_nearest_neighbor(src, out, iw, ih, ch, ow, oh);
+        int same = (memcmp(ref, out, ow * oh * ch * sizeof(float)) == 0);
+        free(src); free(ref); free(out);
+        CHECK(same, "%ux%ux%u -> %ux%u", iw, ih, ch, ow, oh);
+    }
+}
+
+static void test_concat(void)
+{
+    static uint8_t base[256], ref[512], out[512];
+    static const uint32_t ranges[] = { 0, 16, 100, 3, 7, 0, 200, 56, 1, 255 };
+    uint32_t seed = 6;
+
+    for (size_t i = 0; i < sizeof(base); i++)
+        base[i] = ref_rand(&seed);
+    ref_concat(base, ranges, 5, ref);
+    kpu_kernel_concat(base, ranges, 5, out);
+    CHECK(memcmp(ref, out, 16 + 3 + 0 + 56 + 255) == 0, "concat");
+}
+
+int main(void)
+{
+    test_fully_connected();
+    test_exp();
+    test_softmax();
+    test_quantized_add();
+    test_requantize();
+    test_resize_nearest_neighbor();
+    test_concat();
+
+    if (failed)
+    {
+        printf("kpu_kernels: %d test(s) failed\n", failed);
+        return 1;
+    }
+    printf("kpu_kernels: OK\n");
+    return 0;
+}
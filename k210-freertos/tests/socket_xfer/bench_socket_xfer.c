@@ -0,0 +1,134 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host benchmark of the socket <-> file transfer (mpy_support/standard_lib/network/socket_xfer.c)
+ * The file and the network peer are simulated with the given transfer times,
+ * sleeping while they are busy as the K210 does while waiting for the DMA.
+ * The overlapped transfer is compared with the read/send (receive/write) loop
+ * running in one task, which was used by microWebSrv and uftpserver.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "socket_xfer.h"
+#include "socket_xfer_host.h"
+
+#define BENCH_SIZE      (256 * 1024)
+
+static uint8_t src[BENCH_SIZE];
+static uint8_t dst[BENCH_SIZE];
+
+static void serial_send(host_stream_t *file, host_stream_t *peer, int bufsize)
+{
+    socket_xfer_t xfer;
+    memset(&xfer, 0, sizeof(xfer));
+    xfer.sock = peer;
+    xfer.buf[0] = malloc(bufsize);
+    int n;
+    while ((n = host_file_read(file, xfer.buf[0], bufsize)) > 0) {
+        xfer.len[0] = n;
+        host_net_send(&xfer, 0);
+    }
+    free(xfer.buf[0]);
+}
+
+static void serial_recv(host_stream_t *file, host_stream_t *peer, int bufsize)
+{
+    socket_xfer_t xfer;
+    memset(&xfer, 0, sizeof(xfer));
+    xfer.sock = peer;
+    xfer.buf[0] = malloc(bufsize);
+    xfer.len[0] = bufsize;
+    int n;
+    while ((n = host_net_recv(&xfer, 0)) > 0) host_file_write(file, xfer.buf[0], n);
+    free(xfer.buf[0]);
+}
+
+// Returns the throughput in KB/s, 0 if the data differ
+static double run(bool send, bool overlapped, int bufsize, unsigned int file_ns, unsigned int net_ns)
+{
+    host_stream_t file, peer;
+    memset(dst, 0, sizeof(dst));
+    if (send) {
+        host_stream_init(&file, src, BENCH_SIZE);
+        host_stream_init(&peer, dst, BENCH_SIZE);
+    }
+    else {
+        host_stream_init(&peer, src, BENCH_SIZE);
+        host_stream_init(&file, dst, BENCH_SIZE);
+    }
+    file.ns_per_byte = file_ns;
+    peer.ns_per_byte = net_ns;
+
+    uint64_t t0 = host_time_ns();
+    if (overlapped) {
+        socket_xfer_t xfer;
+        if (!socket_xfer_start(&xfer, &peer, send, bufsize, (send) ? host_net_send : host_net_recv, NULL)) return 0;
+        int res = (send) ? socket_xfer_send_file(&xfer, &file, host_file_read, -1)
+                         : socket_xfer_recv_file(&xfer, &file, host_file_write, -1);
+        socket_xfer_end(&xfer);
+        if (res != BENCH_SIZE) return 0;
+    }
+    else if (send) serial_send(&file, &peer, bufsize);
+    else serial_recv(&file, &peer, bufsize);
+    uint64_t t1 = host_time_ns();
+
+    if (memcmp(src, dst, BENCH_SIZE) != 0) return 0;
+    return (BENCH_SIZE / 1024.0) / ((t1 - t0) / 1e9);
+}
+
+int main(void)
+{
+    static const struct {
+        const char *name;
+        int bufsize;
+        unsigned int file_ns;
+        unsigned int net_ns;
+    } cases[] = {
+        { "lwIP, flash 2 MB/s",        3072,   500,  125 },
+        { "lwIP, SD card 1 MB/s",      3072,  1000,  125 },
+        { "WiFi 250 KB/s, flash",      2048,   500, 4000 },
+        { "file and net 1 MB/s",       3072,  1000, 1000 },
+    };
+    for (int i = 0; i < BENCH_SIZE; i++) src[i] = (uint8_t)(i * 7);
+
+    printf("socket_xfer, %d KB transferred, KB/s\n", BENCH_SIZE / 1024);
+    printf("%-24s %-9s %10s %10s %8s\n", "case", "direction", "one task", "overlapped", "speedup");
+    for (int c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        for (int dir = 0; dir < 2; dir++) {
+            double serial = run(dir == 0, false, cases[c].bufsize, cases[c].file_ns, cases[c].net_ns);
+            double overlapped = run(dir == 0, true, cases[c].bufsize, cases[c].file_ns, cases[c].net_ns);
+            if ((serial == 0) || (overlapped == 0)) {
+                printf("%s: transfer failed\n", cases[c].name);
+                return 1;
+            }
+            printf("%-24s %-9s %10.0f %10.0f %7.2fx\n", cases[c].name, (dir == 0) ? "send" : "receive",
+                    serial, overlapped, overlapped / serial);
+        }
+    }
+    return 0;
+}
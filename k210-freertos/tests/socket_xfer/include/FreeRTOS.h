@@ -0,0 +1,62 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Host build of network/socket_xfer.c, the FreeRTOS heap is the C heap,
+// the queues and tasks are implemented with POSIX threads by the host stand-in (socket_xfer_host.c)
+
+#ifndef _FREERTOS_H_
+#define _FREERTOS_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#define pvPortMalloc                malloc
+#define vPortFree                   free
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint64_t TickType_t;
+
+#define pdFALSE                     0
+#define pdTRUE                      1
+#define pdFAIL                      0
+#define pdPASS                      1
+#define portMAX_DELAY               ((TickType_t)-1)
+#define configMINIMAL_STACK_SIZE    1024
+
+typedef struct host_queue *QueueHandle_t;
+typedef struct host_task *TaskHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait);
+void vQueueDelete(QueueHandle_t queue);
+
+BaseType_t xTaskCreate(void (*task)(void *), const char *name, uint32_t stack_depth, void *arg,
+        UBaseType_t priority, TaskHandle_t *handle);
+void vTaskDelete(TaskHandle_t task);
+
+#endif
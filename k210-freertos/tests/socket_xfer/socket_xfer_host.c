@@ -0,0 +1,230 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "FreeRTOS.h"
+#include "socket_xfer_host.h"
+
+// ==== FreeRTOS ====
+
+struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t *items;
+};
+
+struct host_task {
+    pthread_t thread;
+    void (*task)(void *);
+    void *arg;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    QueueHandle_t queue = calloc(1, sizeof(struct host_queue));
+    if (queue == NULL) return NULL;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->changed, NULL);
+    queue->length = length;
+    queue->item_size = item_size;
+    queue->items = malloc(length * item_size);
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait)
+{
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length) pthread_cond_wait(&queue->changed, &queue->lock);
+    memcpy(queue->items + (((queue->head + queue->count) % queue->length) * queue->item_size), item, queue->item_size);
+    queue->count++;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait)
+{
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) pthread_cond_wait(&queue->changed, &queue->lock);
+    memcpy(item, queue->items + (queue->head * queue->item_size), queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    pthread_cond_destroy(&queue->changed);
+    pthread_mutex_destroy(&queue->lock);
+    free(queue->items);
+    free(queue);
+}
+
+static void *task_entry(void *arg)
+{
+    TaskHandle_t handle = arg;
+    handle->task(handle->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(void (*task)(void *), const char *name, uint32_t stack_depth, void *arg,
+        UBaseType_t priority, TaskHandle_t *handle)
+{
+    TaskHandle_t h = malloc(sizeof(struct host_task));
+    if (h == NULL) return pdFAIL;
+    h->task = task;
+    h->arg = arg;
+    if (pthread_create(&h->thread, NULL, task_entry, h) != 0) {
+        free(h);
+        return pdFAIL;
+    }
+    pthread_detach(h->thread);
+    *handle = h;
+    return pdPASS;
+}
+
+// Only the task deleting itself is used
+void vTaskDelete(TaskHandle_t task)
+{
+    pthread_exit(NULL);
+}
+
+// ==== Simulated file and network peer ====
+
+uint64_t host_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// The transfer time is accumulated and slept off,
+// so that the other thread can run as it would while the DMA is working
+static void stream_delay(host_stream_t *stream, int len)
+{
+    stream->ops++;
+    if (stream->ns_per_byte == 0) return;
+    uint64_t now = host_time_ns();
+    if (stream->busy_until < now) stream->busy_until = now;
+    stream->busy_until += (uint64_t)len * stream->ns_per_byte;
+    struct timespec ts = { stream->busy_until / 1000000000ULL, stream->busy_until % 1000000000ULL };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) ;
+}
+
+void host_stream_init(host_stream_t *stream, uint8_t *data, int size)
+{
+    memset(stream, 0, sizeof(host_stream_t));
+    stream->data = data;
+    stream->size = size;
+    stream->fail_at = -1;
+}
+
+// Returns the number of bytes the operation can transfer, -1 if it fails
+static int stream_limit(host_stream_t *stream, int len, bool write)
+{
+    if (stream->fail_at >= 0) {
+        if (stream->pos >= stream->fail_at) {
+            if ((stream->fail_errno) || (!write)) return -1;
+            return 0;
+        }
+        if (stream->pos + len > stream->fail_at) len = stream->fail_at - stream->pos;
+    }
+    if (len > stream->size - stream->pos) len = stream->size - stream->pos;
+    return len;
+}
+
+int host_file_read(void *file, uint8_t *buf, int len)
+{
+    host_stream_t *stream = file;
+    int n = stream_limit(stream, len, false);
+    if (n < 0) {
+        errno = stream->fail_errno;
+        return -1;
+    }
+    memcpy(buf, stream->data + stream->pos, n);
+    stream->pos += n;
+    stream_delay(stream, n);
+    return n;
+}
+
+int host_file_write(void *file, uint8_t *buf, int len)
+{
+    host_stream_t *stream = file;
+    int n = stream_limit(stream, len, true);
+    if (n >= 0) {
+        memcpy(stream->data + stream->pos, buf, n);
+        stream->pos += n;
+        stream_delay(stream, n);
+    }
+    if ((n < 0) || ((n < len) && (stream->fail_errno))) {
+        errno = stream->fail_errno;
+        return -1;
+    }
+    return n;
+}
+
+int host_net_send(socket_xfer_t *xfer, int idx)
+{
+    host_stream_t *stream = xfer->sock;
+    int n = stream_limit(stream, xfer->len[idx], true);
+    if (n >= 0) {
+        memcpy(stream->data + stream->pos, xfer->buf[idx], n);
+        stream->pos += n;
+        stream_delay(stream, n);
+    }
+    if ((n < 0) || ((n < xfer->len[idx]) && (stream->fail_errno))) {
+        xfer->err = stream->fail_errno;
+        return -1;
+    }
+    return n;
+}
+
+// Returns 0 (peer closed) at the end of the data
+int host_net_recv(socket_xfer_t *xfer, int idx)
+{
+    host_stream_t *stream = xfer->sock;
+    int len = xfer->len[idx];
+    if ((stream->max_chunk) && (len > stream->max_chunk)) len = stream->max_chunk;
+    int n = stream_limit(stream, len, false);
+    if (n < 0) {
+        xfer->err = stream->fail_errno;
+        return -1;
+    }
+    memcpy(xfer->buf[idx], stream->data + stream->pos, n);
+    stream->pos += n;
+    stream_delay(stream, n);
+    return n;
+}
@@ -0,0 +1,64 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Host stand-in for the FreeRTOS queues and tasks used by network/socket_xfer.c
+// and the simulated file and network peer used by its tests and benchmarks
+
+#ifndef _SOCKET_XFER_HOST_H_
+#define _SOCKET_XFER_HOST_H_
+
+#include <stdint.h>
+#include "socket_xfer.h"
+
+// Memory backed file or network peer
+// Reads take the data from 'data', writes append it to 'data' (up to 'size' bytes).
+// A read crossing 'fail_at' stops there, the next one fails with 'fail_errno'.
+// A write crossing 'fail_at' writes the bytes up to it and fails with 'fail_errno',
+// with 'fail_errno' 0 the write is short instead.
+typedef struct {
+    uint8_t *data;
+    int size;
+    int pos;
+    int fail_at;                // -1: never fails
+    int fail_errno;
+    int max_chunk;              // max bytes per receive (0: no limit)
+    unsigned int ns_per_byte;   // simulated transfer time
+    uint64_t busy_until;
+    int ops;                    // number of operations
+} host_stream_t;
+
+void host_stream_init(host_stream_t *stream, uint8_t *data, int size);
+
+// socket_xfer_file_t, 'file' is host_stream_t
+int host_file_read(void *file, uint8_t *buf, int len);
+int host_file_write(void *file, uint8_t *buf, int len);
+// socket_xfer_net_t, 'xfer->sock' is host_stream_t
+int host_net_send(socket_xfer_t *xfer, int idx);
+int host_net_recv(socket_xfer_t *xfer, int idx);
+
+uint64_t host_time_ns(void);
+
+#endif
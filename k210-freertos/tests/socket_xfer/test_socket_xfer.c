@@ -0,0 +1,224 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host tests of the socket <-> file transfer (mpy_support/standard_lib/network/socket_xfer.c)
+ * The network side runs in the transfer task (a POSIX thread) against a simulated peer,
+ * the file is memory backed. Each transfer must deliver exactly the file content,
+ * and any error, also after some data were transferred, must be reported.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "socket_xfer.h"
+#include "socket_xfer_host.h"
+
+static int failed = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failed++; \
+        return; \
+    } } while (0)
+
+#define FILE_SIZE   100000
+#define BUF_SIZE    3072        // 2*TCP_MSS
+
+static uint8_t src[FILE_SIZE];
+static uint8_t dst[FILE_SIZE * 2];
+static int n_polls;
+
+static void poll(void)
+{
+    n_polls++;
+}
+
+static void fill(void)
+{
+    for (int i = 0; i < FILE_SIZE; i++) src[i] = (uint8_t)((i * 131) ^ (i >> 8));
+    memset(dst, 0, sizeof(dst));
+    n_polls = 0;
+}
+
+// Send 'count' bytes of the file to the peer, returns the result of socket_xfer_send_file()
+static int send_file(host_stream_t *file, host_stream_t *peer, int count, socket_xfer_t *xfer)
+{
+    if (!socket_xfer_start(xfer, peer, true, BUF_SIZE, host_net_send, poll)) return -2;
+    int res = socket_xfer_send_file(xfer, file, host_file_read, count);
+    socket_xfer_end(xfer);
+    return res;
+}
+
+static int recv_file(host_stream_t *file, host_stream_t *peer, int count, socket_xfer_t *xfer)
+{
+    if (!socket_xfer_start(xfer, peer, false, BUF_SIZE, host_net_recv, poll)) return -2;
+    int res = socket_xfer_recv_file(xfer, file, host_file_write, count);
+    socket_xfer_end(xfer);
+    return res;
+}
+
+static void test_send(void)
+{
+    socket_xfer_t xfer;
+    host_stream_t file, peer;
+    fill();
+    host_stream_init(&file, src, FILE_SIZE);
+    host_stream_init(&peer, dst, sizeof(dst));
+    int res = send_file(&file, &peer, -1, &xfer);
+    CHECK(res == FILE_SIZE, "sent %d of %d", res, FILE_SIZE);
+    CHECK(peer.pos == FILE_SIZE, "peer received %d", peer.pos);
+    CHECK(memcmp(src, dst, FILE_SIZE) == 0, "data differ");
+    CHECK(n_polls == (FILE_SIZE + BUF_SIZE - 1) / BUF_SIZE, "%d polls", n_polls);
+
+    // 'count' bytes from the current file position
+    fill();
+    host_stream_init(&peer, dst, sizeof(dst));
+    file.pos = 1000;
+    res = send_file(&file, &peer, 5000, &xfer);
+    CHECK(res == 5000, "sent %d of 5000", res);
+    CHECK((file.pos == 6000) && (peer.pos == 5000), "file at %d, peer received %d", file.pos, peer.pos);
+    CHECK(memcmp(src + 1000, dst, 5000) == 0, "data differ");
+
+    // the file is empty at the offset
+    host_stream_init(&peer, dst, sizeof(dst));
+    file.pos = FILE_SIZE;
+    res = send_file(&file, &peer, -1, &xfer);
+    CHECK((res == 0) && (peer.ops == 0), "sent %d, %d sends", res, peer.ops);
+}
+
+static void test_send_errors(void)
+{
+    socket_xfer_t xfer;
+    host_stream_t file, peer;
+
+    // connection reset in the middle of the transfer
+    fill();
+    host_stream_init(&file, src, FILE_SIZE);
+    host_stream_init(&peer, dst, sizeof(dst));
+    peer.fail_at = 40000;
+    peer.fail_errno = ECONNRESET;
+    int res = send_file(&file, &peer, -1, &xfer);
+    CHECK(res == -1, "returned %d after the reset", res);
+    CHECK(xfer.err == ECONNRESET, "err %d", xfer.err);
+    CHECK(xfer.total == 40000 - (40000 % BUF_SIZE), "%d bytes reported as sent", xfer.total);
+
+    // short send
+    host_stream_init(&file, src, FILE_SIZE);
+    host_stream_init(&peer, dst, sizeof(dst));
+    peer.fail_at = 40000;
+    res = send_file(&file, &peer, -1, &xfer);
+    CHECK((res == -1) && (xfer.err == EIO), "short send returned %d, err %d", res, xfer.err);
+
+    // file read error
+    host_stream_init(&file, src, FILE_SIZE);
+    host_stream_init(&peer, dst, sizeof(dst));
+    file.fail_at = 30000;
+    file.fail_errno = EIO;
+    res = send_file(&file, &peer, -1, &xfer);
+    CHECK((res == -1) && (xfer.err == EIO), "read error returned %d, err %d", res, xfer.err);
+    CHECK((xfer.total == 30000) && (peer.pos == 30000), "sent %d, peer received %d", xfer.total, peer.pos);
+}
+
+static void test_recv(void)
+{
+    socket_xfer_t xfer;
+    host_stream_t file, peer;
+
+    // until the peer closes, received in small chunks
+    fill();
+    host_stream_init(&peer, src, FILE_SIZE);
+    host_stream_init(&file, dst, sizeof(dst));
+    peer.max_chunk = 700;
+    int res = recv_file(&file, &peer, -1, &xfer);
+    CHECK(res == FILE_SIZE, "received %d of %d", res, FILE_SIZE);
+    CHECK(file.pos == FILE_SIZE, "%d bytes written", file.pos);
+    CHECK(memcmp(src, dst, FILE_SIZE) == 0, "data differ");
+
+    // 'count' bytes, the rest is left to the socket
+    fill();
+    host_stream_init(&peer, src, FILE_SIZE);
+    host_stream_init(&file, dst, sizeof(dst));
+    res = recv_file(&file, &peer, 12345, &xfer);
+    CHECK((res == 12345) && (file.pos == 12345) && (peer.pos == 12345), "received %d, written %d, peer at %d",
+            res, file.pos, peer.pos);
+    CHECK(memcmp(src, dst, 12345) == 0, "data differ");
+
+    // peer closes immediately
+    host_stream_init(&peer, src, 0);
+    host_stream_init(&file, dst, sizeof(dst));
+    res = recv_file(&file, &peer, -1, &xfer);
+    CHECK((res == 0) && (file.ops == 0), "received %d, %d writes", res, file.ops);
+}
+
+static void test_recv_errors(void)
+{
+    socket_xfer_t xfer;
+    host_stream_t file, peer;
+
+    // file system full: the short write must not be reported as a received count
+    fill();
+    host_stream_init(&peer, src, FILE_SIZE);
+    host_stream_init(&file, dst, 50000);
+    int res = recv_file(&file, &peer, -1, &xfer);
+    CHECK(res == -1, "returned %d with the file system full", res);
+    CHECK(xfer.err == ENOSPC, "err %d", xfer.err);
+    CHECK(xfer.total < 50000, "%d bytes reported as written", xfer.total);
+
+    // file write error
+    host_stream_init(&peer, src, FILE_SIZE);
+    host_stream_init(&file, dst, sizeof(dst));
+    file.fail_at = 20000;
+    file.fail_errno = EIO;
+    res = recv_file(&file, &peer, -1, &xfer);
+    CHECK((res == -1) && (xfer.err == EIO), "write error returned %d, err %d", res, xfer.err);
+
+    // connection reset in the middle of the transfer
+    host_stream_init(&peer, src, FILE_SIZE);
+    host_stream_init(&file, dst, sizeof(dst));
+    peer.fail_at = 30000;
+    peer.fail_errno = ECONNRESET;
+    res = recv_file(&file, &peer, -1, &xfer);
+    CHECK((res == -1) && (xfer.err == ECONNRESET), "reset returned %d, err %d", res, xfer.err);
+    CHECK((xfer.total == 30000) && (file.pos == 30000), "received %d, written %d", xfer.total, file.pos);
+}
+
+int main(void)
+{
+    test_send();
+    test_send_errors();
+    test_recv();
+    test_recv_errors();
+    if (failed) {
+        printf("socket_xfer: %d test(s) failed\n", failed);
+        return 1;
+    }
+    printf("socket_xfer: OK\n");
+    return 0;
+}
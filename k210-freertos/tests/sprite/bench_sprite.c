@@ -0,0 +1,105 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host benchmark of the sprite compositing (display/sprite.c)
+ * 12 sprites over a background image, 4 of them moving in every frame:
+ * compose() against redrawing and sending the whole screen in every frame.
+ * The pixel count is what the panel would receive over SPI.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "sprite_reference.h"
+
+#define FRAMES  2000
+#define NS      12
+
+static color_t frame[FB_W * FB_H];
+static color_t full[FB_W * FB_H];
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+static void move_sprites(tft_sprite_t *spr, uint32_t *seed)
+{
+    for (int i = 0; i < NS; i += 3) {
+        TFT_sprite_move(&spr[i], spr[i].x + (int)(ref_rand(seed) % 7) - 3, spr[i].y + (int)(ref_rand(seed) % 7) - 3);
+    }
+}
+
+// Run the animation, redraw the whole screen in every frame if 'full' is set
+// Returns the time in us, the last frame is left in 'frame'
+static double run(bool full)
+{
+    tft_layer_t layer;
+    tft_sprite_t spr[NS];
+    uint32_t seed = 1;
+
+    for (int i = 0; i < FB_W * FB_H; i++) frame[i] = (color_t)ref_rand(&seed);
+    tft_frame_buffer = frame;
+    if (!TFT_layer_init(&layer, true, 0)) exit(1);
+    for (int i = 0; i < NS; i++) {
+        if (!ref_random_sprite(&spr[i], i, &seed)) exit(1);
+        TFT_layer_add(&layer, &spr[i]);
+    }
+    TFT_layer_compose(&layer, true);
+
+    panel_rects = panel_pixels = 0;
+    double t0 = now_us();
+    for (int f = 0; f < FRAMES; f++) {
+        move_sprites(spr, &seed);
+        if (full) TFT_layer_damage(&layer, 0, 0, FB_W - 1, FB_H - 1);
+        TFT_layer_compose(&layer, true);
+    }
+    double t = now_us() - t0;
+
+    TFT_layer_free(&layer);
+    for (int i = 0; i < NS; i++) TFT_sprite_free(&spr[i]);
+    return t;
+}
+
+int main(void)
+{
+    double t_full = run(true);
+    long full_rects = panel_rects, full_pixels = panel_pixels;
+    memcpy(full, frame, sizeof(full));
+    double t_damage = run(false);
+
+    printf("%-22s %12s %12s %14s\n", "compose, 12 sprites", "us/frame", "rects/frame", "pixels/frame");
+    printf("%-22s %12.1f %12.1f %14.0f\n", "full screen", t_full / FRAMES, (double)full_rects / FRAMES, (double)full_pixels / FRAMES);
+    printf("%-22s %12.1f %12.1f %14.0f (%.1f%%)\n", "damaged areas", t_damage / FRAMES, (double)panel_rects / FRAMES,
+           (double)panel_pixels / FRAMES, 100.0 * panel_pixels / FRAMES / (FB_W * FB_H));
+    if (memcmp(full, frame, sizeof(full)) != 0) {
+        printf("the last frames differ\n");
+        return 1;
+    }
+    return 0;
+}
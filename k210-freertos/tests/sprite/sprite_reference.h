@@ -0,0 +1,158 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Pixel buffer panel and golden image model of the sprite compositing (display/sprite.c)
+ * The panel receives the frame buffer rectangles sent by compose(), the model draws
+ * the whole screen from scratch: the background, then every visible sprite in z order.
+ */
+#ifndef _SPRITE_REFERENCE_H_
+#define _SPRITE_REFERENCE_H_
+
+#include <stdint.h>
+#include <string.h>
+#include "sprite.h"
+
+#define FB_W    320
+#define FB_H    240
+
+int _width = FB_W;
+int _height = FB_H;
+uint16_t *tft_frame_buffer = NULL;
+
+// The panel and the counters of the sent rectangles and pixels
+static color_t panel[FB_W * FB_H];
+static long panel_rects = 0;
+static long panel_pixels = 0;
+
+void send_frame_buffer_rect(int x1, int y1, int x2, int y2)
+{
+    for (int y = y1; y <= y2; y++) {
+        memcpy(panel + (y * _width) + x1, tft_frame_buffer + (y * _width) + x1, (x2 - x1 + 1) * sizeof(color_t));
+    }
+    panel_rects++;
+    panel_pixels += (long)(x2 - x1 + 1) * (y2 - y1 + 1);
+}
+
+// Blend the components one by one, 'a' is the opacity of 'fg' in range 0~32
+static inline color_t ref_blend(color_t fg, color_t bg, int a)
+{
+    int r = ((((fg >> 11) & 0x1F) * a) + (((bg >> 11) & 0x1F) * (32 - a))) >> 5;
+    int g = ((((fg >> 5) & 0x3F) * a) + (((bg >> 5) & 0x3F) * (32 - a))) >> 5;
+    int b = (((fg & 0x1F) * a) + ((bg & 0x1F) * (32 - a))) >> 5;
+    return (color_t)((r << 11) | (g << 5) | b);
+}
+
+// Draw the golden image of the layer into 'out'
+// The sprites are drawn in the layer's order, which must be sorted by z
+// (sprites with the same z keep their previous order, see ref_sorted())
+static inline void ref_render(const tft_layer_t *layer, color_t *out)
+{
+    for (int i = 0; i < FB_W * FB_H; i++) out[i] = (layer->bg) ? layer->bg[i] : layer->bg_color;
+
+    for (int k = 0; k < layer->n_sprites; k++) {
+        const tft_sprite_t *spr = layer->sprite[k];
+        if (!spr->visible) continue;
+        int a = (spr->alpha + 4) >> 3;
+        for (int y = 0; y < spr->height; y++) {
+            for (int x = 0; x < spr->width; x++) {
+                int dx = spr->x + x, dy = spr->y + y;
+                if ((dx < 0) || (dy < 0) || (dx >= FB_W) || (dy >= FB_H)) continue;
+                color_t c;
+                if (spr->format == SPRITE_FMT_PAL8) {
+                    int idx = spr->bitmap[(y * spr->width) + x];
+                    if (idx == spr->key) continue;
+                    c = spr->palette[idx];
+                }
+                else {
+                    c = ((const color_t *)spr->bitmap)[(y * spr->width) + x];
+                    if (c == spr->key) continue;
+                }
+                color_t *d = &out[(dy * FB_W) + dx];
+                *d = (a >= 32) ? c : ref_blend(c, *d, a);
+            }
+        }
+    }
+}
+
+// Check that the layer holds the sprites in z order, each once and linked to the layer
+static inline bool ref_sorted(const tft_layer_t *layer)
+{
+    for (int k = 0; k < layer->n_sprites; k++) {
+        if (layer->sprite[k]->layer != layer) return false;
+        if ((k > 0) && (layer->sprite[k-1]->z > layer->sprite[k]->z)) return false;
+        for (int j = 0; j < k; j++) {
+            if (layer->sprite[j] == layer->sprite[k]) return false;
+        }
+    }
+    return true;
+}
+
+// Count the pixels which differ, 'first' gets the index of the first one
+static inline int ref_diff(const color_t *a, const color_t *b, int *first)
+{
+    int n = 0;
+    *first = -1;
+    for (int i = 0; i < FB_W * FB_H; i++) {
+        if (a[i] != b[i]) {
+            if (*first < 0) *first = i;
+            n++;
+        }
+    }
+    return n;
+}
+
+// Pseudo random numbers, the same on every host
+static inline uint32_t ref_rand(uint32_t *seed)
+{
+    *seed = (*seed * 1103515245u) + 12345u;
+    return (*seed >> 8) & 0xFFFFFF;
+}
+
+// Sprite 'i' of the random scenes: RGB565 or palettized, with a key, alpha or opaque
+static inline bool ref_random_sprite(tft_sprite_t *spr, int i, uint32_t *seed)
+{
+    int w = 8 + ref_rand(seed) % 40, h = 8 + ref_rand(seed) % 40;
+    bool pal = (i & 1);
+    if (!TFT_sprite_init(spr, w, h, (pal) ? SPRITE_FMT_PAL8 : SPRITE_FMT_RGB565)) return false;
+    if (pal) {
+        for (int k = 0; k < 256; k++) spr->palette[k] = ref_rand(seed);
+        for (int k = 0; k < w * h; k++) spr->bitmap[k] = ref_rand(seed) % 8;
+        spr->key = 0;
+    }
+    else {
+        color_t *bmp = (color_t *)spr->bitmap;
+        for (int k = 0; k < w * h; k++) bmp[k] = (ref_rand(seed) % 5) ? (color_t)ref_rand(seed) : 0x1234;
+        if ((i % 4) == 0) spr->key = 0x1234;
+    }
+    if ((i % 3) == 2) spr->alpha = 100 + i;
+    spr->x = (ref_rand(seed) % FB_W) - 20;
+    spr->y = (ref_rand(seed) % FB_H) - 20;
+    spr->z = ref_rand(seed) % 4;
+    return true;
+}
+
+#endif
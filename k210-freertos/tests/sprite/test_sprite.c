@@ -0,0 +1,332 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host tests of the sprite and layer compositing (display/sprite.c)
+ * After compose() the frame buffer must match the golden image drawn from scratch
+ * by the model in sprite_reference.h, and the panel must match the frame buffer,
+ * i.e. every changed pixel must have been sent.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "sprite_reference.h"
+
+static int failed = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failed++; \
+        return; \
+    } } while (0)
+
+static color_t frame[FB_W * FB_H];
+static color_t golden[FB_W * FB_H];
+
+// Random frame buffer content and an empty panel
+static void screen_init(uint32_t seed)
+{
+    for (int i = 0; i < FB_W * FB_H; i++) frame[i] = (color_t)ref_rand(&seed);
+    memset(panel, 0, sizeof(panel));
+    tft_frame_buffer = frame;
+    panel_rects = 0;
+    panel_pixels = 0;
+}
+
+// Compare the frame buffer with the golden image and the panel with the frame buffer
+// Returns the number of different pixels, 'where' describes the first one
+static int screen_check(tft_layer_t *layer, char *where)
+{
+    int first;
+    ref_render(layer, golden);
+    int n = ref_diff(golden, frame, &first);
+    if (n) {
+        sprintf(where, "frame buffer at %d,%d", first % FB_W, first / FB_W);
+        return n;
+    }
+    n = ref_diff(panel, frame, &first);
+    if (n) sprintf(where, "panel at %d,%d", first % FB_W, first / FB_W);
+    return n;
+}
+
+// Known pixel values: key color and index, opacity, palette
+static void test_golden_pixels(void)
+{
+    tft_layer_t layer;
+    tft_sprite_t rgb, pal;
+
+    screen_init(1);
+    CHECK(TFT_layer_init(&layer, false, 0x001F), "layer init");
+    CHECK(TFT_sprite_init(&rgb, 3, 1, SPRITE_FMT_RGB565), "sprite init");
+    CHECK(TFT_sprite_init(&pal, 3, 1, SPRITE_FMT_PAL8), "sprite init");
+    color_t *bmp = (color_t *)rgb.bitmap;
+    bmp[0] = 0xF800;
+    bmp[1] = 0x1234;
+    bmp[2] = 0x07E0;
+    rgb.key = 0x1234;
+    rgb.alpha = 128;
+    TFT_sprite_move(&rgb, 10, 20);
+    pal.palette[1] = 0xFFFF;
+    pal.palette[7] = 0xF81F;
+    pal.bitmap[0] = 1;
+    pal.bitmap[1] = 0;
+    pal.bitmap[2] = 7;
+    pal.key = 0;
+    TFT_sprite_move(&pal, 11, 20);
+    pal.z = 1;
+    TFT_layer_add(&layer, &rgb);
+    TFT_layer_add(&layer, &pal);
+
+    CHECK(TFT_layer_compose(&layer, true) == 1, "one full screen rect");
+    CHECK(panel_pixels == FB_W * FB_H, "full screen sent: %ld", panel_pixels);
+    const color_t *row = frame + (20 * FB_W);
+    CHECK(row[9] == 0x001F, "background %04x", row[9]);
+    // red over blue at half opacity
+    CHECK(row[10] == 0x780F, "blend %04x", row[10]);
+    // the palettized sprite is on top, opaque
+    CHECK(row[11] == 0xFFFF, "palette %04x", row[11]);
+    // key index of the palettized sprite, green at half opacity over blue below it
+    CHECK(row[12] == 0x03EF, "key index %04x", row[12]);
+    CHECK(row[13] == 0xF81F, "palette %04x", row[13]);
+    CHECK(row[14] == 0x001F, "background %04x", row[14]);
+    CHECK(frame[(19 * FB_W) + 11] == 0x001F, "background %04x", frame[(19 * FB_W) + 11]);
+    CHECK(memcmp(panel, frame, sizeof(frame)) == 0, "panel differs");
+
+    // the key color of the RGB565 sprite
+    TFT_sprite_move(&pal, 100, 100);
+    TFT_layer_compose(&layer, true);
+    CHECK(row[11] == 0x001F, "key color %04x", row[11]);
+    CHECK(memcmp(panel, frame, sizeof(frame)) == 0, "panel differs");
+
+    TFT_layer_free(&layer);
+    TFT_sprite_free(&rgb);
+    TFT_sprite_free(&pal);
+}
+
+// Only the old and new areas of a moved sprite are redrawn and sent
+static void test_damage(void)
+{
+    tft_layer_t layer;
+    tft_sprite_t spr;
+    char where[64];
+    uint32_t seed = 7;
+
+    screen_init(2);
+    CHECK(TFT_layer_init(&layer, true, 0), "layer init");
+    CHECK(TFT_sprite_init(&spr, 20, 10, SPRITE_FMT_RGB565), "sprite init");
+    for (int i = 0; i < 20 * 10; i++) ((color_t *)spr.bitmap)[i] = ref_rand(&seed);
+    TFT_sprite_move(&spr, 50, 60);
+    TFT_layer_add(&layer, &spr);
+    TFT_layer_compose(&layer, true);
+    CHECK(screen_check(&layer, where) == 0, "%s", where);
+
+    // touching rectangles are merged
+    panel_rects = panel_pixels = 0;
+    TFT_sprite_move(&spr, 52, 61);
+    CHECK(TFT_layer_compose(&layer, true) == 1, "one rect");
+    CHECK(panel_pixels == 22 * 11, "sent %ld pixels", panel_pixels);
+    CHECK(screen_check(&layer, where) == 0, "%s", where);
+
+    // separate rectangles
+    panel_rects = panel_pixels = 0;
+    TFT_sprite_move(&spr, 200, 150);
+    CHECK(TFT_layer_compose(&layer, true) == 2, "two rects");
+    CHECK(panel_pixels == 2 * 20 * 10, "sent %ld pixels", panel_pixels);
+    CHECK(screen_check(&layer, where) == 0, "%s", where);
+
+    // nothing changed
+    panel_rects = panel_pixels = 0;
+    TFT_sprite_move(&spr, 200, 150);
+    CHECK(TFT_layer_compose(&layer, true) == 0, "no rects");
+    CHECK(panel_rects == 0, "sent %ld rects", panel_rects);
+
+    // bitmap change, then hidden, then removed
+    ((color_t *)spr.bitmap)[0] ^= 0xFFFF;
+    TFT_sprite_changed(&spr);
+    CHECK(TFT_layer_compose(&layer, true) == 1, "one rect");
+    CHECK(screen_check(&layer, where) == 0, "%s", where);
+    TFT_sprite_set_visible(&spr, false);
+    TFT_layer_compose(&layer, true);
+    CHECK(screen_check(&layer, where) == 0, "%s", where);
+    TFT_sprite_set_visible(&spr, true);
+    TFT_layer_compose(&layer, true);
+    TFT_layer_remove(&layer, &spr);
+    CHECK(spr.layer == NULL, "still in the layer");
+    CHECK(TFT_layer_compose(&layer, true) == 1, "one rect");
+    CHECK(screen_check(&layer, where) == 0, "%s", where);
+
+    // more separate rectangles than the damage list holds
+    panel_rects = 0;
+    for (int i = 0; i < 40; i++) TFT_layer_damage(&layer, i * 8, i * 6, i * 8 + 2, i * 6 + 2);
+    CHECK(layer.n_damage <= TFT_LAYER_DAMAGE_RECTS, "%d rects", layer.n_damage);
+    TFT_layer_compose(&layer, true);
+    CHECK(screen_check(&layer, where) == 0, "%s", where);
+
+    TFT_layer_free(&layer);
+    TFT_sprite_free(&spr);
+}
+
+// Sprites crossing every display edge and sprites outside the display
+static void test_clipping(void)
+{
+    tft_layer_t layer;
+    tft_sprite_t spr[6];
+    char where[64];
+    uint32_t seed = 3;
+    const int pos[6][2] = { {-10, 50}, {300, 100}, {100, -15}, {150, 230}, {-30, -30}, {400, 10} };
+
+    screen_init(3);
+    CHECK(TFT_layer_init(&layer, true, 0), "layer init");
+    for (int i = 0; i < 6; i++) {
+        CHECK(ref_random_sprite(&spr[i], i, &seed), "sprite init");
+        spr[i].x = pos[i][0];
+        spr[i].y = pos[i][1];
+        TFT_layer_add(&layer, &spr[i]);
+    }
+    TFT_layer_compose(&layer, true);
+    CHECK(screen_check(&layer, where) == 0, "%s", where);
+
+    for (int step = 0; step < 30; step++) {
+        for (int i = 0; i < 6; i++) TFT_sprite_move(&spr[i], spr[i].x + ((i & 1) ? -3 : 3), spr[i].y + ((i & 2) ? -2 : 2));
+        TFT_layer_compose(&layer, true);
+        CHECK(screen_check(&layer, where) == 0, "step %d: %s", step, where);
+    }
+
+    // moving outside the display sends nothing
+    TFT_sprite_move(&spr[5], 500, 10);
+    TFT_layer_compose(&layer, true);
+    panel_rects = 0;
+    TFT_sprite_move(&spr[5], 600, 300);
+    CHECK(TFT_layer_compose(&layer, true) == 0, "rects outside the display");
+    CHECK(panel_rects == 0, "sent %ld rects", panel_rects);
+
+    TFT_layer_free(&layer);
+    for (int i = 0; i < 6; i++) TFT_sprite_free(&spr[i]);
+}
+
+// Drawing into the background image, display size change
+static void test_background(void)
+{
+    tft_layer_t layer;
+    tft_sprite_t spr;
+    char where[64];
+    uint32_t seed = 5;
+
+    screen_init(4);
+    CHECK(TFT_layer_init(&layer, true, 0), "layer init");
+    CHECK(memcmp(layer.bg, frame, sizeof(frame)) == 0, "background is not the frame buffer content");
+    CHECK(ref_random_sprite(&spr, 0, &seed), "sprite init");
+    TFT_sprite_move(&spr, 40, 40);
+    TFT_layer_add(&layer, &spr);
+    TFT_layer_compose(&layer, true);
+
+    CHECK(TFT_layer_bgdraw(&layer, true), "bgdraw");
+    CHECK(tft_frame_buffer == layer.bg, "drawing does not go to the background");
+    for (int y = 30; y < 70; y++) {
+        for (int x = 30; x < 90; x++) tft_frame_buffer[(y * FB_W) + x] = 0xF800;
+    }
+    TFT_layer_damage(&layer, 30, 30, 89, 69);
+    // compose() ends the background drawing
+    TFT_layer_compose(&layer, true);
+    CHECK(tft_frame_buffer == frame, "frame buffer not restored");
+    CHECK(screen_check(&layer, where) == 0, "%s", where);
+
+    // a solid color layer has no background image
+    tft_layer_t solid;
+    CHECK(TFT_layer_init(&solid, false, 0x1234), "layer init");
+    CHECK(!TFT_layer_bgdraw(&solid, true), "bgdraw without an image");
+    TFT_layer_add(&solid, &spr);
+    CHECK(spr.layer == &solid, "not moved to the new layer");
+    CHECK(layer.n_sprites == 0, "still in the old layer");
+    TFT_layer_compose(&solid, true);
+    CHECK(screen_check(&solid, where) == 0, "%s", where);
+
+    // the layer was made for another display size
+    _width = FB_H;
+    _height = FB_W;
+    CHECK(TFT_layer_compose(&solid, true) == -1, "compose after the size change");
+    _width = FB_W;
+    _height = FB_H;
+
+    TFT_layer_free(&solid);
+    TFT_layer_free(&layer);
+    CHECK(spr.layer == NULL, "sprite still linked");
+    TFT_sprite_free(&spr);
+}
+
+// Random scenes: moves, z order, visibility, remove and add, checked against the golden image
+static void test_random_scenes(void)
+{
+    enum { NS = 12, FRAMES = 2000 };
+    tft_layer_t layer;
+    tft_sprite_t spr[NS];
+    char where[64];
+    uint32_t seed = 1;
+
+    screen_init(5);
+    CHECK(TFT_layer_init(&layer, true, 0), "layer init");
+    for (int i = 0; i < NS; i++) {
+        CHECK(ref_random_sprite(&spr[i], i, &seed), "sprite init");
+        CHECK(TFT_layer_add(&layer, &spr[i]), "layer add");
+    }
+    TFT_layer_compose(&layer, true);
+    CHECK(screen_check(&layer, where) == 0, "%s", where);
+
+    for (int f = 0; f < FRAMES; f++) {
+        for (int i = 0; i < NS; i += 3) {
+            TFT_sprite_move(&spr[i], spr[i].x + (int)(ref_rand(&seed) % 7) - 3, spr[i].y + (int)(ref_rand(&seed) % 7) - 3);
+        }
+        if ((f % 50) == 7) TFT_sprite_set_z(&spr[f % NS], ref_rand(&seed) % 4);
+        if ((f % 70) == 9) TFT_sprite_set_visible(&spr[f % NS], !spr[f % NS].visible);
+        if ((f % 300) == 5) TFT_layer_remove(&layer, &spr[3]);
+        if ((f % 300) == 150) TFT_layer_add(&layer, &spr[3]);
+        TFT_layer_compose(&layer, true);
+        if (((f % 97) == 0) || (f == (FRAMES - 1))) {
+            CHECK(ref_sorted(&layer), "frame %d: sprites not in z order", f);
+            CHECK(screen_check(&layer, where) == 0, "frame %d: %s", f, where);
+        }
+    }
+
+    TFT_layer_free(&layer);
+    for (int i = 0; i < NS; i++) TFT_sprite_free(&spr[i]);
+}
+
+int main(void)
+{
+    test_golden_pixels();
+    test_damage();
+    test_clipping();
+    test_background();
+    test_random_scenes();
+    if (failed) {
+        printf("sprite: %d test(s) failed\n", failed);
+        return 1;
+    }
+    printf("sprite: OK\n");
+    return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host benchmark of the JPEG output of the display driver (display/tft.c)
+ * The 320x240 images are decoded to the frame buffer, then sent directly to
+ * the panel without and with the helper task.
+ * The SPI transfer is simulated as a sleeping wait (tft_host.c). Its speed is
+ * set so a full frame takes as long as decoding test1.jpg, about as on the K210.
+ * The host may have a single CPU, the parallel decoding of the images with
+ * restart markers then only overlaps with the transfers.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "tft_jpg_reference.h"
+
+#define FRAMES  40
+
+static const char *images[] = {
+    "../mpy_support/examples/display/test1.jpg",
+    "../mpy_support/examples/display/test2.jpg",
+    "../mpy_support/examples/display/test3.jpg",
+    "../mpy_support/examples/display/test4.jpg",
+    "tft/images/test1_rst.jpg",
+    "tft/images/test2_420rst.jpg",
+};
+#define N_IMAGES    (int)(sizeof(images) / sizeof(images[0]))
+
+static uint8_t jpg[REF_JPG_MAX_SIZE];
+static color_t frame[TFT_HOST_WIDTH * TFT_HOST_HEIGHT];
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+// Returns ms per frame, 'windows' is set to the windows per frame
+static double run(int size, bool fb, bool helper, double *windows)
+{
+    mpy_config.config.use_two_main_tasks = !helper;
+    tft_host_init((fb) ? frame : NULL);
+    double t0 = now_us();
+    for (int f = 0; f < FRAMES; f++) TFT_jpg_image(0, 0, 0, mp_const_none, jpg, size);
+    double t = (now_us() - t0) / FRAMES / 1000;
+    *windows = (double)tft_host_stats.windows / FRAMES;
+    return t;
+}
+
+int main(void)
+{
+    double windows, decode, direct, async;
+
+    for (int i = 0; i < N_IMAGES; i++) {
+        int size = ref_jpg_read(images[i], jpg, sizeof(jpg));
+        if (size <= 0) {
+            printf("%s not read\n", images[i]);
+            return 1;
+        }
+        if (i == 0) {
+            tft_host_spi_ns_per_pixel = 0;
+            decode = run(size, true, true, &windows);
+            tft_host_spi_ns_per_pixel = decode * 1e6 / (TFT_HOST_WIDTH * TFT_HOST_HEIGHT);
+            printf("SPI: %.1f ns/pixel, %.2f ms/frame\n\n", tft_host_spi_ns_per_pixel, decode);
+            printf("%-18s %14s %26s %26s\n", "", "frame buffer", "direct, no helper", "direct, helper");
+            printf("%-18s %14s %8s %8s %8s %8s %8s %8s\n", "image", "ms/frame", "ms/frame", "fps", "windows", "ms/frame", "fps", "windows");
+        }
+        decode = run(size, true, true, &windows);
+        direct = run(size, false, false, &windows);
+        printf("%-18s %14.2f %8.2f %8.1f %8.0f", strrchr(images[i], '/') + 1, decode, direct, 1000 / direct, windows);
+        async = run(size, false, true, &windows);
+        printf(" %8.2f %8.1f %8.0f\n", async, 1000 / async, windows);
+        if (tft_host_stats.conflicts) {
+            printf("%lu overlapping transfers\n", tft_host_stats.conflicts);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host benchmark of the text output of the display driver (display/tft.c)
+ * A status screen of 8 lines with changing numbers is printed in every font,
+ * with the glyph cache and text runs (buffered) and character by character.
+ * 'windows' is the number of address windows (SPI transactions) per character,
+ * 'pixels' the pixels per character the panel receives.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "tft_text_reference.h"
+
+#define FRAMES  300
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+typedef struct {
+    double us_per_char;
+    double windows;
+    double pixels;
+    uint64_t hash;
+} result_t;
+
+static void run(int font, bool buffered, result_t *res)
+{
+    char line[64];
+    long nchars = 0;
+
+    tft_host_init(NULL);
+    memset(tft_host_panel, 0, sizeof(tft_host_panel));
+    TFT_setFont(font, NULL, false);
+    font_buffered_char = buffered;
+    font_transparent = 0;
+    int fh = TFT_getfontheight();
+    int nlines = TFT_HOST_HEIGHT / fh;
+    if (nlines > 8) nlines = 8;
+
+    double t0 = now_us();
+    for (int f = 0; f < FRAMES; f++) {
+        for (int l = 0; l < nlines; l++) {
+            _fg = (l & 1) ? TFT_YELLOW : TFT_GREEN;
+            _bg = TFT_BLACK;
+            snprintf(line, sizeof(line), "T%d: %3d.%d C  %5d rpm", l, ((f * 7) + l) % 100, f % 10, ((f * 131) + (l * 17)) % 10000);
+            TFT_print(line, 0, l * fh);
+            nchars += strlen(line);
+        }
+    }
+    res->us_per_char = (now_us() - t0) / nchars;
+    res->windows = (double)tft_host_stats.windows / nchars;
+    res->pixels = (double)tft_host_stats.pixels / nchars;
+    res->hash = tft_host_hash(tft_host_panel, TFT_HOST_WIDTH * TFT_HOST_HEIGHT);
+}
+
+int main(void)
+{
+    result_t buf, chr;
+
+    printf("Status screen, %d frames\n", FRAMES);
+    printf("%-14s %20s %20s %20s\n", "", "us/char", "windows/char", "pixels/char");
+    printf("%-14s %9s %10s %9s %10s %9s %10s\n", "font", "buffered", "by char", "buffered", "by char", "buffered", "by char");
+    for (int font = 0; font < REF_N_FONTS; font++) {
+        run(font, true, &buf);
+        run(font, false, &chr);
+        if (buf.hash != chr.hash) {
+            printf("%s: different output\n", ref_font_names[font]);
+            return 1;
+        }
+        printf("%-14s %9.3f %10.3f %9.2f %10.2f %9.1f %10.1f\n", ref_font_names[font],
+               buf.us_per_char, chr.us_per_char, buf.windows, chr.windows, buf.pixels, chr.pixels);
+    }
+    font_buffered_char = 1;
+    return 0;
+}
@@ -0,0 +1,47 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Host build of the display code
+// The MicroPython objects used by tft.c: a string object is its C string,
+// a file object is the host FILE (see tft_host.c)
+
+#ifndef _PY_OBJ_H_
+#define _PY_OBJ_H_
+
+#include <stddef.h>
+#include "py/mpprint.h"
+
+typedef void *mp_obj_t;
+typedef struct _mp_map_t { int unused; } mp_map_t;
+
+extern const mp_map_t mp_const_empty_map;
+extern const int mp_const_none_obj;
+#define mp_const_none   ((mp_obj_t)&mp_const_none_obj)
+
+mp_obj_t mp_obj_new_str(const char *data, size_t len);
+const char *mp_obj_str_get_str(mp_obj_t self_in);
+
+#endif
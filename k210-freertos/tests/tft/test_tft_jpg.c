@@ -0,0 +1,234 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host tests of the JPEG output of the display driver (display/tft.c)
+ * TFT_jpg_image() must draw the same pixels as the image decoded by the plain
+ * TJpgDec output (tft_jpg_reference.h) in all positions and scales, in the
+ * frame buffer and directly to the panel, with and without the helper task.
+ * The images with restart markers are also decoded in two parts in parallel.
+ * In direct mode every MCU row must be sent as one address window and the
+ * transfers must never overlap.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "tft_jpg_reference.h"
+
+static int failed = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failed++; \
+        return; \
+    } } while (0)
+
+#define N_PIXELS    (TFT_HOST_WIDTH * TFT_HOST_HEIGHT)
+
+typedef struct {
+    const char *name;
+    bool restart;       // the image has restart markers aligned to MCU rows
+} test_image_t;
+
+static const test_image_t images[] = {
+    { "../mpy_support/examples/display/test1.jpg", false },
+    { "../mpy_support/examples/display/test2.jpg", false },
+    { "../mpy_support/examples/display/test3.jpg", false },
+    { "../mpy_support/examples/display/test4.jpg", false },
+    { "tft/images/test1_rst.jpg", true },
+    { "tft/images/test2_420rst.jpg", true },
+};
+#define N_IMAGES    (int)(sizeof(images) / sizeof(images[0]))
+
+static const int positions[][2] = {
+    { 0, 0 }, { -37, -21 }, { CENTER, CENTER }, { 101, 93 }, { -300, 5 }, { 250, 200 }, { RIGHT, BOTTOM }
+};
+#define N_POSITIONS (int)(sizeof(positions) / sizeof(positions[0]))
+
+static uint8_t jpg[REF_JPG_MAX_SIZE];
+static color_t frame[N_PIXELS];
+static color_t expect[N_PIXELS];
+
+static color_t *screen(void)
+{
+    return (use_frame_buffer) ? tft_frame_buffer : tft_host_panel;
+}
+
+// Random screen content, 'fb' selects the frame buffer mode
+static void screen_init(bool fb, uint32_t seed)
+{
+    tft_host_init((fb) ? frame : NULL);
+    for (int i = 0; i < N_PIXELS; i++) {
+        seed = (seed * 1103515245U) + 12345U;
+        screen()[i] = (color_t)(seed >> 8);
+    }
+    memcpy(expect, screen(), sizeof(expect));
+}
+
+// Returns the number of pixels different from the expected ones, 'where' describes the first one
+static int screen_diff(char *where)
+{
+    int n = 0;
+    for (int i = 0; i < N_PIXELS; i++) {
+        if (screen()[i] != expect[i]) {
+            if (n == 0) sprintf(where, "%d,%d: 0x%04X expected 0x%04X", i % TFT_HOST_WIDTH, i / TFT_HOST_WIDTH, screen()[i], expect[i]);
+            n++;
+        }
+    }
+    return n;
+}
+
+// Number of the image MCU rows visible in the display window
+static int visible_mcu_rows(int width, int height, int mcu_height, int x, int y)
+{
+    // place an image of the row numbers as the reference does
+    static color_t rows_img[TFT_HOST_WIDTH * TFT_HOST_HEIGHT * 4];
+    static color_t rows_screen[N_PIXELS];
+    for (int i = 0; i < width * height; i++) rows_img[i] = (i / width) + 1;
+    memset(rows_screen, 0, sizeof(rows_screen));
+    ref_jpg_place(rows_screen, rows_img, width, height, x, y);
+
+    int rows = 0, last = -1;
+    for (int i = 0; i < N_PIXELS; i++) {
+        if (rows_screen[i] == 0) continue;
+        int row = (rows_screen[i] - 1) / mcu_height;
+        if (row != last) rows++;
+        last = row;
+        i = (((i / TFT_HOST_WIDTH) + 1) * TFT_HOST_WIDTH) - 1;
+    }
+    return rows;
+}
+
+// 'clip' draws the image to a smaller display window
+static void check_image(const test_image_t *image, int size, int scale, int x, int y, bool fb, bool helper, bool clip)
+{
+    char where[64];
+    int width, height, mcu_height;
+    color_t *img = ref_jpg_decode(jpg, size, scale, &width, &height, &mcu_height);
+    CHECK(img != NULL, "%s not decoded", image->name);
+
+    mpy_config.config.use_two_main_tasks = !helper;
+    screen_init(fb, size + scale + x);
+    if (clip) TFT_setclipwin(21, 30, 290, 201);
+    int rows = visible_mcu_rows(width, height, mcu_height, x, y);
+    ref_jpg_place(expect, img, width, height, x, y);
+    free(img);
+    TFT_jpg_image(x, y, scale, mp_const_none, jpg, size);
+
+    const char *mode = (fb) ? ((helper) ? "frame buffer" : "frame buffer, no helper") : ((helper) ? "direct" : "direct, no helper");
+    CHECK(screen_diff(where) == 0, "%s scale %d at %d,%d (%s): %s", image->name, scale, x, y, mode, where);
+    CHECK(tft_host_stats.conflicts == 0, "%s: %lu overlapping transfers", image->name, tft_host_stats.conflicts);
+    if (fb) {
+        CHECK(tft_host_stats.windows == 0, "%s: %lu windows in frame buffer mode", image->name, tft_host_stats.windows);
+        return;
+    }
+    CHECK((long)tft_host_stats.windows == rows, "%s scale %d at %d,%d (%s): %lu windows for %d MCU rows",
+          image->name, scale, x, y, mode, tft_host_stats.windows, rows);
+    if (!helper) {
+        CHECK(tft_host_stats.task_windows == 0, "%s: %lu windows sent by the helper", image->name, tft_host_stats.task_windows);
+    }
+    else if (!image->restart) {
+        // all bands are sent by the helper
+        CHECK(tft_host_stats.task_windows == tft_host_stats.windows, "%s: %lu of %lu windows sent by the helper",
+              image->name, tft_host_stats.task_windows, tft_host_stats.windows);
+    }
+    else if ((x == 0) && (y == 0)) {
+        // both parts of the image are decoded and sent
+        CHECK((tft_host_stats.task_windows > 0) && (tft_host_stats.task_windows < tft_host_stats.windows),
+              "%s: %lu of %lu windows sent by the helper", image->name, tft_host_stats.task_windows, tft_host_stats.windows);
+    }
+}
+
+// All images, positions, scales and modes
+static void test_images(void)
+{
+    for (int i = 0; i < N_IMAGES; i++) {
+        int size = ref_jpg_read(images[i].name, jpg, sizeof(jpg));
+        CHECK(size > 0, "%s not read", images[i].name);
+        for (int mode = 0; mode < 4; mode++) {
+            for (int scale = 0; scale < 4; scale++) {
+                for (int p = 0; p < N_POSITIONS; p++) {
+                    int n = failed;
+                    check_image(&images[i], size, scale, positions[p][0], positions[p][1], (mode & 1), !(mode & 2), false);
+                    if (failed != n) return;
+                }
+            }
+        }
+    }
+    mpy_config.config.use_two_main_tasks = false;
+}
+
+// Images clipped to a display window
+static void test_clip_window(void)
+{
+    for (int i = 0; i < N_IMAGES; i += 4) {
+        int size = ref_jpg_read(images[i].name, jpg, sizeof(jpg));
+        CHECK(size > 0, "%s not read", images[i].name);
+        for (int p = 0; p < N_POSITIONS; p++) {
+            int n = failed;
+            check_image(&images[i], size, p % 2, positions[p][0], positions[p][1], false, true, true);
+            if (failed != n) return;
+        }
+    }
+}
+
+// Images read from the file, never decoded in two parts
+static void test_file(void)
+{
+    char where[64];
+    int width, height, mcu_height;
+
+    for (int i = 0; i < N_IMAGES; i++) {
+        int size = ref_jpg_read(images[i].name, jpg, sizeof(jpg));
+        CHECK(size > 0, "%s not read", images[i].name);
+        color_t *img = ref_jpg_decode(jpg, size, 1, &width, &height, &mcu_height);
+        CHECK(img != NULL, "%s not decoded", images[i].name);
+        screen_init(false, i);
+        ref_jpg_place(expect, img, width, height, 40, -7);
+        free(img);
+        TFT_jpg_image(40, -7, 1, (mp_obj_t)images[i].name, NULL, 0);
+        CHECK(screen_diff(where) == 0, "%s: %s", images[i].name, where);
+        CHECK(tft_host_stats.task_windows == tft_host_stats.windows, "%s: %lu of %lu windows sent by the helper",
+              images[i].name, tft_host_stats.task_windows, tft_host_stats.windows);
+    }
+}
+
+int main(void)
+{
+    // the transfers take time, so overlapping ones are detected
+    tft_host_spi_ns_per_pixel = 20;
+    test_images();
+    test_clip_window();
+    test_file();
+    if (failed) {
+        printf("tft_jpg: %d test(s) failed\n", failed);
+        return 1;
+    }
+    printf("tft_jpg: OK\n");
+    return 0;
+}
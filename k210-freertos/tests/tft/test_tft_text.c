@@ -0,0 +1,331 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host tests of the text output of the display driver (display/tft.c)
+ * The text printed with the glyph cache and the text runs, and without them,
+ * must match the text drawn character by character from the font data
+ * (tft_text_reference.h), on the panel and in the frame buffer.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "tft_text_reference.h"
+
+static int failed = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failed++; \
+        return; \
+    } } while (0)
+
+#define N_PIXELS    (TFT_HOST_WIDTH * TFT_HOST_HEIGHT)
+
+// text modes
+#define MODE_BUFFERED       1   // glyph cache and text runs
+#define MODE_TRANSPARENT    2
+#define MODE_FORCE_FIXED    4
+
+static color_t frame[N_PIXELS];
+static color_t expect[N_PIXELS];
+
+static uint32_t rand_next(uint32_t *seed)
+{
+    *seed = (*seed * 1103515245U) + 12345U;
+    return *seed >> 8;
+}
+
+static color_t *screen(void)
+{
+    return (use_frame_buffer) ? tft_frame_buffer : tft_host_panel;
+}
+
+// Random screen content, 'fb' selects the frame buffer mode
+static void screen_init(bool fb, uint32_t seed)
+{
+    tft_host_init((fb) ? frame : NULL);
+    for (int i = 0; i < N_PIXELS; i++) screen()[i] = (color_t)rand_next(&seed);
+    memcpy(expect, screen(), sizeof(expect));
+}
+
+// Returns the number of pixels different from the expected ones, 'where' describes the first one
+static int screen_diff(char *where)
+{
+    int n = 0;
+    for (int i = 0; i < N_PIXELS; i++) {
+        if (screen()[i] != expect[i]) {
+            if (n == 0) sprintf(where, "%d,%d: 0x%04X expected 0x%04X", i % TFT_HOST_WIDTH, i / TFT_HOST_WIDTH, screen()[i], expect[i]);
+            n++;
+        }
+    }
+    return n;
+}
+
+static void set_mode(int mode, color_t fg, color_t bg)
+{
+    font_buffered_char = (mode & MODE_BUFFERED) ? 1 : 0;
+    font_transparent = (mode & MODE_TRANSPARENT) ? 1 : 0;
+    font_forceFixed = (mode & MODE_FORCE_FIXED) ? 1 : 0;
+    font_rotate = 0;
+    _fg = fg;
+    _bg = bg;
+}
+
+// Print the string with the driver and the reference
+static void print_both(const ref_font_t *rf, const char *s, int x, int y, int mode)
+{
+    TFT_print((char *)s, x, y);
+    bool text_run = ((mode & MODE_BUFFERED) && !(mode & MODE_TRANSPARENT));
+    ref_print(expect, rf, s, x, y, _fg, _bg, (mode & MODE_TRANSPARENT), (mode & MODE_FORCE_FIXED), text_run);
+}
+
+// Width of the cell of the character, 0 if not in the font
+static int cell_width(const ref_font_t *rf, uint8_t c, int mode)
+{
+    ref_glyph_t g;
+    return (ref_glyph(rf, c, (mode & MODE_FORCE_FIXED), &g)) ? g.cell_width : 0;
+}
+
+// Print all characters 0x20 ~ 0xFF of the font in lines of different colors
+static void test_font(int font, bool fb, int mode)
+{
+    ref_font_t rf;
+    char line[TFT_HOST_WIDTH];
+    char where[64];
+    uint32_t seed = 1234 + font;
+
+    screen_init(fb, seed);
+    TFT_setFont(font, NULL, false);
+    CHECK(cfont.font == ref_fonts[font], "font %d not set", font);
+    ref_font_init(&rf, ref_fonts[font]);
+    CHECK(cfont.y_size == rf.height, "%s height %d expected %d", ref_font_names[font], cfont.y_size, rf.height);
+
+    bool text_runs = ((mode & MODE_BUFFERED) && !(mode & MODE_TRANSPARENT));
+    int c = 0x20, x = 3, y = 2, lines = 0;
+    unsigned long windows = 0;
+    while (c <= 0xFF) {
+        // the characters which fit in the line
+        int n = 0, w = 0;
+        while ((c + n <= 0xFF) && (n < 40)) {
+            int cw = cell_width(&rf, c + n, mode);
+            if ((x + w + cw) >= (TFT_HOST_WIDTH - 1)) break;
+            w += cw;
+            line[n] = c + n;
+            n++;
+        }
+        line[n] = 0;
+        if ((y + rf.height) > TFT_HOST_HEIGHT) {
+            CHECK(screen_diff(where) == 0, "%s mode %d: %s", ref_font_names[font], mode, where);
+            screen_init(fb, rand_next(&seed));
+            y = 2;
+        }
+        set_mode(mode, (color_t)rand_next(&seed), (color_t)rand_next(&seed));
+        windows = tft_host_stats.windows;
+        print_both(&rf, line, x, y, mode);
+        windows = tft_host_stats.windows - windows;
+        if (text_runs) {
+            // the whole line is sent as one window
+            CHECK(windows == ((w > 0) ? 1 : 0), "%s: %lu windows for %d characters", ref_font_names[font], windows, n);
+        }
+        c += n;
+        x = 3 + (lines % 5);
+        y += rf.height + 1;
+        lines++;
+    }
+    CHECK(screen_diff(where) == 0, "%s mode %d: %s", ref_font_names[font], mode, where);
+    if (text_runs) {
+        CHECK(tft_host_stats.draw_pixels == 0, "%s: %lu pixels drawn one by one", ref_font_names[font], tft_host_stats.draw_pixels);
+    }
+}
+
+// All built-in fonts in all modes, on the panel and in the frame buffer
+static void test_fonts(void)
+{
+    static const int modes[] = {
+        MODE_BUFFERED, 0, MODE_TRANSPARENT, MODE_BUFFERED | MODE_TRANSPARENT,
+        MODE_BUFFERED | MODE_FORCE_FIXED, MODE_FORCE_FIXED
+    };
+    for (int fb = 0; fb < 2; fb++) {
+        for (int font = 0; font < REF_N_FONTS; font++) {
+            for (int m = 0; m < (int)(sizeof(modes) / sizeof(modes[0])); m++) {
+                int n = failed;
+                test_font(font, fb, modes[m]);
+                if (failed != n) return;
+            }
+        }
+    }
+}
+
+// More glyphs than the cache can hold: many color pairs of a large font,
+// then the first colors again, and more characters than the cache entries
+static void test_cache_eviction(void)
+{
+    ref_font_t rf;
+    char where[64];
+    const char *text = "Eviction 0123456";
+
+    screen_init(false, 77);
+    TFT_setFont(TOONEY32_FONT, NULL, false);
+    ref_font_init(&rf, tft_tooney32);
+    for (int pass = 0; pass < 3; pass++) {
+        for (int i = 0; i < 40; i++) {
+            // pass 1 changes only the background, pass 2 only the foreground
+            color_t fg = (pass == 1) ? TFT_YELLOW : 0x1000 + (i * 0x0841);
+            color_t bg = (pass == 2) ? TFT_NAVY : 0xFFFF - (i * 0x0421);
+            set_mode(MODE_BUFFERED, fg, bg);
+            print_both(&rf, text, 2 + (i % 7), ((i % 6) * 36) + 4, MODE_BUFFERED);
+            CHECK(screen_diff(where) == 0, "pass %d colors %d: %s", pass, i, where);
+        }
+    }
+
+    TFT_setFont(SMALL_FONT, NULL, false);
+    ref_font_init(&rf, tft_SmallFont);
+    char line[33];
+    for (int i = 0; i < 12; i++) {
+        for (int j = 0; j < 32; j++) line[j] = 0x20 + (((i * 32) + j) % 95);
+        line[32] = 0;
+        set_mode(MODE_BUFFERED, (i & 1) ? TFT_WHITE : TFT_YELLOW, (i & 2) ? TFT_NAVY : TFT_BLACK);
+        print_both(&rf, line, 4, 4 + (i * 14), MODE_BUFFERED);
+    }
+    CHECK(screen_diff(where) == 0, "%s", where);
+}
+
+// A line longer than a text run
+static void test_long_run(void)
+{
+    ref_font_t rf;
+    char where[64];
+    char line[80];
+
+    screen_init(false, 99);
+    TFT_setFont(DEFAULT_FONT, NULL, false);
+    ref_font_init(&rf, tft_DefaultFont);
+    int n = 0, w = 0;
+    while ((n < 79) && ((w + cell_width(&rf, "il.:"[n % 4], 0)) < (TFT_HOST_WIDTH - 2))) {
+        w += cell_width(&rf, "il.:"[n % 4], 0);
+        line[n] = "il.:"[n % 4];
+        n++;
+    }
+    line[n] = 0;
+    CHECK(n > 64, "only %d characters", n);
+    set_mode(MODE_BUFFERED, TFT_GREEN, TFT_BLACK);
+    print_both(&rf, line, 1, 10, MODE_BUFFERED);
+    CHECK(screen_diff(where) == 0, "%s", where);
+    CHECK(tft_host_stats.windows == 2, "%lu windows for %d characters", tft_host_stats.windows, n);
+}
+
+// The same text and colors in all fonts, twice
+static void test_font_switch(void)
+{
+    ref_font_t rf;
+    char where[64];
+
+    screen_init(false, 21);
+    for (int i = 0; i < 2 * REF_N_FONTS; i++) {
+        int font = i % REF_N_FONTS;
+        TFT_setFont(font, NULL, false);
+        ref_font_init(&rf, ref_fonts[font]);
+        set_mode(MODE_BUFFERED, TFT_GREEN, TFT_BLACK);
+        print_both(&rf, "Abc123", 4 + ((i / REF_N_FONTS) * 160), 4 + (font * 26), MODE_BUFFERED);
+    }
+    CHECK(screen_diff(where) == 0, "%s", where);
+}
+
+// Glyphs starting left of their cell ('J' of DejaVuSans24, 'j' of minya24)
+// overlap the previous character inside a text run
+static void test_overhang(void)
+{
+    ref_font_t rf;
+    char where[64];
+
+    screen_init(false, 11);
+    TFT_setFont(DEJAVU24_FONT, NULL, false);
+    ref_font_init(&rf, tft_Dejavu24);
+    set_mode(MODE_BUFFERED, TFT_WHITE, TFT_DARKGREY);
+    print_both(&rf, "JAJJ.J", 10, 10, MODE_BUFFERED);
+    TFT_setFont(MINYA24_FONT, NULL, false);
+    ref_font_init(&rf, tft_minya24);
+    set_mode(MODE_BUFFERED, TFT_BLACK, TFT_ORANGE);
+    print_both(&rf, "jajj_j", 10, 60, MODE_BUFFERED);
+    CHECK(screen_diff(where) == 0, "%s", where);
+}
+
+// Write a fixed 8x8 font file, the glyph of each character depends on 'variant'
+static bool write_user_font(const char *name, int variant, uint8_t *font)
+{
+    font[0] = 8;
+    font[1] = 8;
+    font[2] = 0x20;
+    font[3] = 96;
+    for (int i = 0; i < 96 * 8; i++) font[4 + i] = (uint8_t)((i * (variant + 3)) ^ (variant * 0x5A));
+    FILE *f = fopen(name, "wb");
+    if (f == NULL) return false;
+    fwrite(font, 1, 4 + (96 * 8), f);
+    fwrite("RPH_font", 1, 8, f);
+    fclose(f);
+    return true;
+}
+
+// Loading another file font must drop the cached glyphs of the previous one,
+// its data is usually loaded to the same address
+static void test_user_font_reload(void)
+{
+    static uint8_t font_data[4 + (96 * 8)];
+    ref_font_t rf;
+    char where[64];
+    char name[] = "build/tft_user_font.fon";
+
+    screen_init(false, 5);
+    for (int variant = 0; variant < 4; variant++) {
+        CHECK(write_user_font(name, variant, font_data), "%s not written", name);
+        CHECK(TFT_setFont(USER_FONT, (mp_obj_t)name, false), "font file not loaded");
+        ref_font_init(&rf, font_data);
+        set_mode(MODE_BUFFERED, TFT_WHITE, TFT_BLUE);
+        print_both(&rf, "Reload the user font", 10, 10 + (variant * 10), MODE_BUFFERED);
+        print_both(&rf, "Reload the user font", 10, 120, MODE_BUFFERED);
+        CHECK(screen_diff(where) == 0, "font %d: %s", variant, where);
+    }
+    remove(name);
+}
+
+int main(void)
+{
+    test_fonts();
+    test_cache_eviction();
+    test_long_run();
+    test_font_switch();
+    test_overhang();
+    test_user_font_reload();
+    if (failed) {
+        printf("tft_text: %d test(s) failed\n", failed);
+        return 1;
+    }
+    printf("tft_text: OK\n");
+    return 0;
+}
@@ -0,0 +1,342 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include "FreeRTOS.h"
+#include "tft_host.h"
+#include "mphalport.h"
+#include "modmachine.h"
+#include "py/stream.h"
+#include "extmod/vfs.h"
+
+// ==== Display driver (tftspi.c) ====
+
+bool use_frame_buffer = false;
+uint8_t gray_scale = 0;
+int _width = TFT_HOST_WIDTH;
+int _height = TFT_HOST_HEIGHT;
+uint8_t tft_disp_type = 0;
+uint8_t tft_touch_type = 0;
+uint8_t gamma_curve = 0;
+uint16_t *tft_frame_buffer = NULL;
+
+color_t tft_host_panel[TFT_HOST_WIDTH * TFT_HOST_HEIGHT];
+tft_host_stats_t tft_host_stats;
+double tft_host_spi_ns_per_pixel = 0;
+
+static pthread_mutex_t spi_bus = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t main_task;
+
+void tft_host_init(color_t *frame_buffer)
+{
+    _width = TFT_HOST_WIDTH;
+    _height = TFT_HOST_HEIGHT;
+    dispWin.x1 = 0;
+    dispWin.y1 = 0;
+    dispWin.x2 = _width - 1;
+    dispWin.y2 = _height - 1;
+    use_frame_buffer = (frame_buffer != NULL);
+    tft_frame_buffer = frame_buffer;
+    memset(&tft_host_stats, 0, sizeof(tft_host_stats));
+    main_task = pthread_self();
+}
+
+uint64_t tft_host_hash(const color_t *pixels, int n)
+{
+    uint64_t h = 1469598103934665603ULL;
+    for (int i = 0; i < n; i++) {
+        h ^= pixels[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Start the transfer of 'len' pixels into the address window (inclusive coordinates)
+static color_t *transfer_begin(int x1, int y1, int x2, int y2, uint32_t len)
+{
+    if (pthread_mutex_trylock(&spi_bus) != 0) {
+        __atomic_add_fetch(&tft_host_stats.conflicts, 1, __ATOMIC_RELAXED);
+        pthread_mutex_lock(&spi_bus);
+    }
+    tft_host_stats.windows++;
+    if (!pthread_equal(pthread_self(), main_task)) tft_host_stats.task_windows++;
+    tft_host_stats.pixels += len;
+    return (use_frame_buffer) ? tft_frame_buffer : tft_host_panel;
+}
+
+// Wait for the simulated SPI transfer
+static void transfer_end(uint32_t len)
+{
+    if (tft_host_spi_ns_per_pixel > 0) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        // the address window takes about as long as 4 pixels
+        long ns = ts.tv_nsec + (long)((4 + len) * tft_host_spi_ns_per_pixel);
+        ts.tv_sec += ns / 1000000000;
+        ts.tv_nsec = ns % 1000000000;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+    }
+    pthread_mutex_unlock(&spi_bus);
+}
+
+void drawPixel(int16_t x, int16_t y, color_t color)
+{
+    color_t *dst = transfer_begin(x, y, x, y, 1);
+    tft_host_stats.draw_pixels++;
+    if ((x >= 0) && (y >= 0) && (x < _width) && (y < _height)) dst[(y * _width) + x] = color;
+    transfer_end(1);
+}
+
+void TFT_pushColorRep(int x1, int y1, int x2, int y2, color_t color, uint32_t len)
+{
+    color_t *dst = transfer_begin(x1, y1, x2, y2, len);
+    tft_host_stats.fills++;
+    for (int y = y1; y <= y2; y++) {
+        for (int x = x1; x <= x2; x++) {
+            if ((x >= 0) && (y >= 0) && (x < _width) && (y < _height)) dst[(y * _width) + x] = color;
+        }
+    }
+    transfer_end(len);
+}
+
+// The window is x1 ~ x2-1, y1 ~ y2-1 (as in tftspi.c)
+void send_data(int x1, int y1, int x2, int y2, uint32_t len, color_t *buf)
+{
+    color_t *dst = transfer_begin(x1, y1, x2 - 1, y2 - 1, len);
+    uint32_t idx = 0;
+    for (int y = y1; (y < y2) && (idx < len); y++) {
+        for (int x = x1; (x < x2) && (idx < len); x++, idx++) {
+            if ((x >= 0) && (y >= 0) && (x < _width) && (y < _height)) dst[(y * _width) + x] = buf[idx];
+        }
+    }
+    transfer_end(len);
+}
+
+void disp_spi_transfer_cmd(int8_t cmd)
+{
+}
+
+void disp_spi_transfer_cmd_data(int8_t cmd, uint8_t *data, uint32_t len)
+{
+}
+
+void send_frame_buffer()
+{
+    if (use_frame_buffer) memcpy(tft_host_panel, tft_frame_buffer, sizeof(tft_host_panel));
+}
+
+void _tft_setRotation(uint8_t rot)
+{
+}
+
+
+// ==== MicroPython ====
+
+mpy_config_t mpy_config;
+const mp_map_t mp_const_empty_map;
+const int mp_const_none_obj = 0;
+const mp_print_t mp_plat_print;
+
+uint64_t mp_hal_ticks_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (t.tv_sec * 1000000ULL) + (t.tv_nsec / 1000);
+}
+
+int mp_printf(const mp_print_t *print, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vprintf(fmt, ap);
+    va_end(ap);
+    return n;
+}
+
+// Only used for the file names and modes, which are NUL terminated
+mp_obj_t mp_obj_new_str(const char *data, size_t len)
+{
+    return (mp_obj_t)data;
+}
+
+const char *mp_obj_str_get_str(mp_obj_t self_in)
+{
+    return (const char *)self_in;
+}
+
+mp_obj_t mp_vfs_open(size_t n_args, const mp_obj_t *args, mp_map_t *kw_args)
+{
+    return fopen((const char *)args[0], (const char *)args[1]);
+}
+
+ssize_t mp_stream_posix_read(void *stream, void *buf, size_t len)
+{
+    return fread(buf, 1, len, (FILE *)stream);
+}
+
+off_t mp_stream_posix_lseek(void *stream, off_t offset, int whence)
+{
+    if (fseek((FILE *)stream, offset, whence) != 0) return -1;
+    return ftell((FILE *)stream);
+}
+
+mp_obj_t mp_stream_close(mp_obj_t stream)
+{
+    if ((stream != NULL) && (stream != mp_const_none)) fclose((FILE *)stream);
+    return mp_const_none;
+}
+
+
+// ==== FreeRTOS ====
+
+struct host_semaphore {
+    sem_t sem;
+};
+
+struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t *items;
+};
+
+struct host_task {
+    pthread_t thread;
+    void (*task)(void *);
+    void *arg;
+};
+
+static SemaphoreHandle_t semaphore_create(unsigned int initial)
+{
+    SemaphoreHandle_t sem = malloc(sizeof(struct host_semaphore));
+    if (sem) sem_init(&sem->sem, 0, initial);
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return semaphore_create(0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return semaphore_create(1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial)
+{
+    return semaphore_create(initial);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait)
+{
+    while (sem_wait(&sem->sem) != 0) ;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    sem_post(&sem->sem);
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    sem_destroy(&sem->sem);
+    free(sem);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    QueueHandle_t queue = calloc(1, sizeof(struct host_queue));
+    if (queue == NULL) return NULL;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->changed, NULL);
+    queue->length = length;
+    queue->item_size = item_size;
+    queue->items = malloc(length * item_size);
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait)
+{
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length) pthread_cond_wait(&queue->changed, &queue->lock);
+    memcpy(queue->items + (((queue->head + queue->count) % queue->length) * queue->item_size), item, queue->item_size);
+    queue->count++;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait)
+{
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) pthread_cond_wait(&queue->changed, &queue->lock);
+    memcpy(item, queue->items + (queue->head * queue->item_size), queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+static void *task_entry(void *arg)
+{
+    TaskHandle_t handle = arg;
+    handle->task(handle->arg);
+    return NULL;
+}
+
+// The task runs in its own thread, the processor is not used
+BaseType_t xTaskCreateAtProcessor(UBaseType_t proc, void (*task)(void *), const char *name,
+        uint32_t stack_depth, void *arg, UBaseType_t priority, TaskHandle_t *handle)
+{
+    TaskHandle_t h = malloc(sizeof(struct host_task));
+    if (h == NULL) return pdFAIL;
+    h->task = task;
+    h->arg = arg;
+    if (pthread_create(&h->thread, NULL, task_entry, h) != 0) {
+        free(h);
+        return pdFAIL;
+    }
+    pthread_detach(h->thread);
+    *handle = h;
+    return pdPASS;
+}
+
+UBaseType_t uxPortGetProcessorId(void)
+{
+    return MAIN_TASK_PROC;
+}
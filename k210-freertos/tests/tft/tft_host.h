@@ -0,0 +1,74 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host stand-in of the display driver (tftspi.c) and of the MicroPython and FreeRTOS
+ * functions used by tft.c
+ *
+ * The panel is a pixel buffer written through the address windows sent by tft.c,
+ * as the display controller does. In frame buffer mode the functions write to
+ * 'tft_frame_buffer' as tftspi.c does.
+ * Every address window is counted as one transaction; with 'tft_host_spi_ns_per_pixel'
+ * set, the calling thread also sleeps for the time the SPI transfer would take,
+ * as the K210 task waits for the DMA. Transfers running concurrently are counted
+ * as bus conflicts.
+ *
+ * The tasks are threads; as on the K210, tft.c doesn't start its helper task on the
+ * other core if 'mpy_config.config.use_two_main_tasks' is set.
+ * File objects are host files opened with mp_vfs_open(), a string object is its C string.
+ */
+
+#ifndef _TFT_HOST_H_
+#define _TFT_HOST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tft.h"
+
+#define TFT_HOST_WIDTH      320
+#define TFT_HOST_HEIGHT     240
+
+typedef struct {
+    unsigned long windows;      // address windows (send_data, TFT_pushColorRep, drawPixel)
+    unsigned long pixels;       // pixels written by all of them
+    unsigned long draw_pixels;  // drawPixel calls
+    unsigned long fills;        // TFT_pushColorRep calls
+    unsigned long conflicts;    // transfers started while another one was running
+    unsigned long task_windows; // address windows sent by other tasks than the one calling tft_host_init()
+} tft_host_stats_t;
+
+extern color_t tft_host_panel[TFT_HOST_WIDTH * TFT_HOST_HEIGHT];
+extern tft_host_stats_t tft_host_stats;
+extern double tft_host_spi_ns_per_pixel;
+
+// Set the display size and window, clear the statistics
+// 'frame_buffer' selects the frame buffer mode, it is the frame buffer used
+void tft_host_init(color_t *frame_buffer);
+
+// FNV-1a hash of the pixels
+uint64_t tft_host_hash(const color_t *pixels, int n);
+
+#endif
@@ -0,0 +1,133 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Reference JPEG output for the tests of tft.c
+ * The image is decoded by TJpgDec into a full RGB565 image with a plain output
+ * function (no clipping, bands, helper task or split), then placed on the
+ * screen as TFT_jpg_image() positions it, clipped to the display window.
+ */
+#ifndef _TFT_JPG_REFERENCE_H_
+#define _TFT_JPG_REFERENCE_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tjpgd.h"
+#include "tft_host.h"
+
+#define REF_JPG_MAX_SIZE    100000
+
+typedef struct {
+    const uint8_t *data;
+    uint32_t size;
+    uint32_t pos;
+    color_t *pixels;
+    int width;                  // width of the scaled image
+} ref_jpg_dev_t;
+
+static inline UINT ref_jpg_input(JDEC *jd, BYTE *buff, UINT nd)
+{
+    ref_jpg_dev_t *dev = (ref_jpg_dev_t *)jd->device;
+    if ((dev->pos + nd) > dev->size) nd = dev->size - dev->pos;
+    if (buff) memcpy(buff, dev->data + dev->pos, nd);
+    dev->pos += nd;
+    return nd;
+}
+
+static inline UINT ref_jpg_output(JDEC *jd, void *bitmap, JRECT *rect)
+{
+    ref_jpg_dev_t *dev = (ref_jpg_dev_t *)jd->device;
+    const BYTE *src = bitmap;
+    for (int y = rect->top; y <= rect->bottom; y++) {
+        for (int x = rect->left; x <= rect->right; x++) {
+            dev->pixels[(y * dev->width) + x] = ((src[0] >> 3) << 11) | ((src[1] >> 2) << 5) | (src[2] >> 3);
+            src += 3;
+        }
+    }
+    return 1;
+}
+
+// Decode the image at 1/2^scale size, returns the RGB565 pixels (to be freed) or NULL
+// 'mcu_height' is the scaled height of the MCU rows
+static inline color_t *ref_jpg_decode(const uint8_t *data, uint32_t size, int scale, int *width, int *height, int *mcu_height)
+{
+    static uint8_t work[8192];
+    ref_jpg_dev_t dev = { .data = data, .size = size };
+    JDEC jd;
+
+    if (jd_prepare(&jd, ref_jpg_input, work, sizeof(work), &dev) != JDR_OK) return NULL;
+    *width = jd.width >> scale;
+    *height = jd.height >> scale;
+    // the output of the partial MCUs at the right and bottom edges is not clipped
+    int mcu_w = jd.msx * 8, mcu_h = jd.msy * 8;
+    *mcu_height = mcu_h >> scale;
+    dev.width = ((jd.width + mcu_w - 1) / mcu_w) * mcu_w;
+    dev.pixels = malloc(dev.width * ((jd.height + mcu_h - 1) / mcu_h) * mcu_h * sizeof(color_t));
+    if (dev.pixels == NULL) return NULL;
+    dev.width >>= scale;
+    if (jd_decomp(&jd, ref_jpg_output, scale) != JDR_OK) {
+        free(dev.pixels);
+        return NULL;
+    }
+    // keep only the image area
+    for (int y = 0; y < *height; y++) memmove(dev.pixels + (y * *width), dev.pixels + (y * dev.width), *width * sizeof(color_t));
+    return dev.pixels;
+}
+
+// Draw the decoded image to the screen as TFT_jpg_image(x, y, ...) does
+static inline void ref_jpg_place(color_t *screen, const color_t *img, int width, int height, int x, int y)
+{
+    if (x == CENTER) x = ((dispWin.x2 - dispWin.x1 + 1 - width) / 2) + dispWin.x1;
+    else if (x == RIGHT) x = dispWin.x2 + 1 - width;
+    if (y == CENTER) y = ((dispWin.y2 - dispWin.y1 + 1 - height) / 2) + dispWin.y1;
+    else if (y == BOTTOM) y = dispWin.y2 + 1 - height;
+    if (x < -(dispWin.x2 - 1)) x = -(dispWin.x2 - 1);
+    if (y < -(dispWin.y2 - 1)) y = -(dispWin.y2 - 1);
+    if (x > (dispWin.x2 - 1)) x = dispWin.x2 - 1;
+    if (y > (dispWin.y2 - 1)) y = dispWin.y2 - 1;
+
+    for (int j = 0; j < height; j++) {
+        for (int i = 0; i < width; i++) {
+            int sx = x + i, sy = y + j;
+            if ((sx >= dispWin.x1) && (sx <= dispWin.x2) && (sy >= dispWin.y1) && (sy <= dispWin.y2)) {
+                screen[(sy * TFT_HOST_WIDTH) + sx] = img[(j * width) + i];
+            }
+        }
+    }
+}
+
+// Read the file, returns its size or -1
+static inline int ref_jpg_read(const char *name, uint8_t *buf, int size)
+{
+    FILE *f = fopen(name, "rb");
+    if (f == NULL) return -1;
+    int n = fread(buf, 1, size, f);
+    fclose(f);
+    return (n < size) ? n : -1;
+}
+
+#endif
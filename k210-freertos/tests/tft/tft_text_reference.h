@@ -0,0 +1,167 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Reference text output for the tests of tft.c
+ * Draws the strings character by character straight from the font data,
+ * as the TFT driver did before the glyph cache and text runs: the character
+ * cell is filled with the background color (unless transparent), then the
+ * visible glyph pixels are drawn with the foreground color.
+ */
+#ifndef _TFT_TEXT_REFERENCE_H_
+#define _TFT_TEXT_REFERENCE_H_
+
+#include <stdint.h>
+#include <string.h>
+#include "tft_host.h"
+
+extern const unsigned char tft_DefaultFont[];
+extern const unsigned char tft_Dejavu18[];
+extern const unsigned char tft_Dejavu24[];
+extern const unsigned char tft_Ubuntu16[];
+extern const unsigned char tft_Comic24[];
+extern const unsigned char tft_minya24[];
+extern const unsigned char tft_tooney32[];
+extern const unsigned char tft_SmallFont[];
+extern const unsigned char tft_def_small[];
+
+// The built-in bitmap fonts, in the order of the font numbers (DEFAULT_FONT ~ DEF_SMALL_FONT)
+static const unsigned char *const ref_fonts[] = {
+    tft_DefaultFont, tft_Dejavu18, tft_Dejavu24, tft_Ubuntu16, tft_Comic24,
+    tft_minya24, tft_tooney32, tft_SmallFont, tft_def_small
+};
+static const char *const ref_font_names[] = {
+    "DefaultFont", "DejaVuSans18", "DejaVuSans24", "Ubuntu16", "Comic24",
+    "minya24", "tooney32", "SmallFont", "def_small"
+};
+#define REF_N_FONTS     (int)(sizeof(ref_fonts) / sizeof(ref_fonts[0]))
+
+typedef struct {
+    const unsigned char *font;
+    int width;          // fixed font character width, 0 for proportional fonts
+    int height;         // font (cell) height
+    int max_width;      // proportional font: maximal glyph width or x advance
+} ref_font_t;
+
+typedef struct {
+    const unsigned char *bits;  // packed glyph bits
+    int row_bits;               // bits per glyph row
+    int width;
+    int height;
+    int x;                      // glyph position in the cell
+    int y;
+    int cell_width;
+} ref_glyph_t;
+
+static inline void ref_font_init(ref_font_t *rf, const unsigned char *font)
+{
+    rf->font = font;
+    rf->width = font[0];
+    rf->height = font[1];
+    rf->max_width = 0;
+    if (rf->width) return;
+    // proportional font: code, y offset, width, height, x offset, x advance, bits
+    const unsigned char *p = font + 4;
+    while (p[0]) {
+        int h = p[3], bottom = p[1] + p[3];
+        if (h > rf->height) rf->height = h;
+        if (bottom > rf->height) rf->height = bottom;
+        if (p[2] > rf->max_width) rf->max_width = p[2];
+        if (p[5] > rf->max_width) rf->max_width = p[5];
+        p += 6 + ((p[2]) ? ((((p[2] * p[3]) - 1) / 8) + 1) : 0);
+    }
+}
+
+// Get the glyph of the character, returns false if the font has no such character
+static inline bool ref_glyph(const ref_font_t *rf, uint8_t c, bool force_fixed, ref_glyph_t *g)
+{
+    if (rf->width) {
+        int first = rf->font[2], n = rf->font[3];
+        int row_bytes = (rf->width + 7) / 8;
+        if ((c < first) || ((c - first) > n)) c = first;
+        g->bits = rf->font + 4 + ((c - first) * row_bytes * rf->height);
+        g->row_bits = row_bytes * 8;
+        g->width = rf->width;
+        g->height = rf->height;
+        g->x = 0;
+        g->y = 0;
+        g->cell_width = rf->width;
+        return true;
+    }
+    const unsigned char *p = rf->font + 4;
+    while (p[0] && (p[0] != c)) {
+        p += 6 + ((p[2]) ? ((((p[2] * p[3]) - 1) / 8) + 1) : 0);
+    }
+    if (p[0] == 0) return false;
+    int advance = p[5];
+    g->bits = p + 6;
+    g->width = p[2];
+    g->row_bits = p[2];
+    g->height = p[3];
+    g->y = p[1];
+    g->x = (p[4] < 0x80) ? p[4] : -(0xFF - p[4]);
+    if (force_fixed) {
+        advance = rf->max_width;
+        g->x = (advance - g->width) / 2;
+    }
+    g->cell_width = ((g->width > advance) ? g->width : advance) + 1;
+    return true;
+}
+
+static inline void ref_pixel(color_t *canvas, int x, int y, color_t c)
+{
+    if ((x >= 0) && (y >= 0) && (x < TFT_HOST_WIDTH) && (y < TFT_HOST_HEIGHT)) canvas[(y * TFT_HOST_WIDTH) + x] = c;
+}
+
+// Print the string at x,y, the whole string must fit into the display line
+// With 'clip_left' the glyph pixels left of x are not drawn (the text runs start at x)
+// Returns the x position after the last character
+static inline int ref_print(color_t *canvas, const ref_font_t *rf, const char *s, int x, int y,
+                            color_t fg, color_t bg, bool transparent, bool force_fixed, bool clip_left)
+{
+    ref_glyph_t g;
+    int x_start = (clip_left) ? x : -TFT_HOST_WIDTH;
+    for (; *s; s++) {
+        if (!ref_glyph(rf, (uint8_t)*s, force_fixed, &g)) continue;
+        if (!transparent) {
+            for (int j = 0; j < rf->height; j++) {
+                for (int i = 0; i < g.cell_width; i++) ref_pixel(canvas, x + i, y + j, bg);
+            }
+        }
+        for (int j = 0; j < g.height; j++) {
+            for (int i = 0; i < g.width; i++) {
+                int bit = (j * g.row_bits) + i;
+                if ((g.bits[bit / 8] & (0x80 >> (bit % 8))) && ((x + g.x + i) >= x_start)) {
+                    ref_pixel(canvas, x + g.x + i, y + g.y + j, fg);
+                }
+            }
+        }
+        x += g.cell_width;
+    }
+    return x;
+}
+
+#endif
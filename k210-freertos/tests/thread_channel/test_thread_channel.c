@@ -0,0 +1,264 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host tests of the zero-copy channel ring buffer (mpy_support/threadchannel.c)
+ * The wrap path (message not fitting at the buffer end is padded and placed
+ * at the buffer start) is tested explicitly, with random message sizes against
+ * a simple model and with the producer and consumer running in two threads.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "threadchannel.h"
+
+static int failed = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failed++; \
+        return; \
+    } } while (0)
+
+static uint8_t ring[4096] __attribute__((aligned(8)));
+
+static void channel_init(thread_channel_t *ch, uint32_t size)
+{
+    memset(ch, 0, sizeof(thread_channel_t));
+    memset(ring, 0xEE, sizeof(ring));
+    ch->buf = ring;
+    ch->size = size;
+    ch->nopen = 1;
+}
+
+static void fill(uint8_t *buf, uint32_t len, uint32_t seq)
+{
+    for (uint32_t i = 0; i < len; i++) buf[i] = (uint8_t)(seq * 31 + i);
+}
+
+static int check_data(const uint8_t *buf, uint32_t len, uint32_t seq)
+{
+    for (uint32_t i = 0; i < len; i++) {
+        if (buf[i] != (uint8_t)(seq * 31 + i)) return 0;
+    }
+    return 1;
+}
+
+static void test_basic(void)
+{
+    thread_channel_t ch;
+    uint32_t len;
+    channel_init(&ch, 256);
+
+    CHECK(mp_thread_channel_receive(&ch, &len) == NULL, "empty channel returned a message");
+    CHECK(mp_thread_channel_reserve(&ch, 0) == NULL, "zero length reserved");
+    CHECK(mp_thread_channel_reserve(&ch, 256) == NULL, "message larger than the ring reserved");
+
+    uint8_t *w = mp_thread_channel_reserve(&ch, 20);
+    CHECK(w == ring + THREAD_CHANNEL_HDR_SIZE, "wrong reservation address");
+    CHECK(mp_thread_channel_reserve(&ch, 8) == NULL, "second reservation allowed");
+    fill(w, 20, 1);
+    CHECK(mp_thread_channel_receive(&ch, &len) == NULL, "uncommitted message received");
+    CHECK(mp_thread_channel_commit(&ch, 21) == 0, "commit larger than the reservation allowed");
+    CHECK(mp_thread_channel_commit(&ch, 13), "commit failed");
+    CHECK(mp_thread_channel_commit(&ch, 13) == 0, "commit without reservation allowed");
+    CHECK(mp_thread_channel_free(&ch) == 256 - 8 - 16, "wrong free size %u", mp_thread_channel_free(&ch));
+
+    uint8_t *r = mp_thread_channel_receive(&ch, &len);
+    CHECK((r == w) && (len == 13) && check_data(r, len, 1), "wrong message received");
+    CHECK(mp_thread_channel_receive(&ch, &len) == NULL, "second receive allowed before release");
+    CHECK(mp_thread_channel_release(&ch), "release failed");
+    CHECK(mp_thread_channel_release(&ch) == 0, "release without receive allowed");
+    CHECK(mp_thread_channel_free(&ch) == 256, "space not given back");
+    CHECK((ch.n_commit == 1) && (ch.n_release == 1), "wrong message counters");
+}
+
+static void test_wrap(void)
+{
+    thread_channel_t ch;
+    uint32_t len;
+    channel_init(&ch, 256);
+
+    // 3 x 72 bytes (64 + header), 40 bytes left at the buffer end
+    for (uint32_t i = 0; i < 3; i++) {
+        uint8_t *w = mp_thread_channel_reserve(&ch, 64);
+        CHECK(w != NULL, "reservation %u failed", i);
+        fill(w, 64, i);
+        CHECK(mp_thread_channel_commit(&ch, 64), "commit %u failed", i);
+    }
+    CHECK(mp_thread_channel_free(&ch) == 40, "wrong free size %u", mp_thread_channel_free(&ch));
+
+    // 48 bytes don't fit at the end and the start is still used
+    CHECK(mp_thread_channel_reserve(&ch, 40) == NULL, "reserved over the unreleased data");
+
+    // release the first message, 72 bytes are free at the start
+    uint8_t *r = mp_thread_channel_receive(&ch, &len);
+    CHECK((r != NULL) && (len == 64) && check_data(r, len, 0), "wrong message 0");
+    mp_thread_channel_release(&ch);
+
+    // the message must be placed at the buffer start, 40 bytes are padded at the end
+    uint8_t *w = mp_thread_channel_reserve(&ch, 60);
+    CHECK(w == ring + THREAD_CHANNEL_HDR_SIZE, "message not wrapped (offset %ld)", (long)(w - ring));
+    CHECK(ch.reserved_pad == 40, "wrong pad %u", ch.reserved_pad);
+    fill(w, 60, 3);
+    CHECK(mp_thread_channel_commit(&ch, 60), "wrapped commit failed");
+    CHECK(ch.reserved_pad == 0, "pad not cleared");
+    CHECK(((uint32_t *)(ring + 216))[1] == THREAD_CHANNEL_FLAG_WRAP, "wrap header not written");
+    CHECK(mp_thread_channel_free(&ch) == 0, "wrong free size %u", mp_thread_channel_free(&ch));
+
+    // messages 1 and 2, then the wrap header is skipped and the wrapped message is received
+    for (uint32_t i = 1; i < 4; i++) {
+        r = mp_thread_channel_receive(&ch, &len);
+        CHECK((r != NULL) && (len == ((i < 3) ? 64 : 60)) && check_data(r, len, i), "wrong message %u", i);
+        CHECK((r + len) <= (ring + 256), "message %u not contiguous", i);
+        mp_thread_channel_release(&ch);
+    }
+    CHECK(mp_thread_channel_receive(&ch, &len) == NULL, "message after the last one");
+    CHECK(mp_thread_channel_free(&ch) == 256, "space not given back, free=%u", mp_thread_channel_free(&ch));
+    CHECK(ch.rd_idx == ch.wr_idx, "indexes differ");
+}
+
+static void test_exact_end(void)
+{
+    thread_channel_t ch;
+    uint32_t len;
+    channel_init(&ch, 256);
+
+    // message ending exactly at the buffer end needs no padding
+    uint8_t *w = mp_thread_channel_reserve(&ch, 120);
+    mp_thread_channel_commit(&ch, 120);
+    w = mp_thread_channel_reserve(&ch, 120);
+    CHECK((w == ring + 136) && (ch.reserved_pad == 0), "wrong reservation at the end");
+    mp_thread_channel_commit(&ch, 120);
+    CHECK(mp_thread_channel_free(&ch) == 0, "ring not full");
+
+    for (int i = 0; i < 2; i++) {
+        CHECK(mp_thread_channel_receive(&ch, &len) != NULL, "message %d not received", i);
+        mp_thread_channel_release(&ch);
+    }
+    // free running indexes are now at the buffer size, position 0
+    w = mp_thread_channel_reserve(&ch, 248);
+    CHECK((w == ring + THREAD_CHANNEL_HDR_SIZE) && (ch.reserved_pad == 0), "wrong reservation after the wrap");
+}
+
+static void test_random(void)
+{
+    thread_channel_t ch;
+    uint32_t len, seq_w = 0, seq_r = 0;
+    uint32_t pending[64], n_pending = 0, head = 0;
+    channel_init(&ch, 1024);
+    // start near the end of the index range to also cover the counters overflow
+    ch.wr_idx = ch.rd_idx = 0xFFFFF000;
+
+    srand(1);
+    for (int iter = 0; iter < 200000; iter++) {
+        if ((rand() & 1) && (n_pending < 64)) {
+            uint32_t l = 1 + rand() % 300;
+            uint32_t free_before = mp_thread_channel_free(&ch);
+            uint8_t *w = mp_thread_channel_reserve(&ch, l);
+            if (w == NULL) {
+                uint32_t need = THREAD_CHANNEL_HDR_SIZE + ((l + 7) & ~7);
+                uint32_t pos = ch.wr_idx & (ch.size - 1);
+                uint32_t pad = ((ch.size - pos) < need) ? ch.size - pos : 0;
+                CHECK(free_before < need + pad, "reservation refused with enough space");
+                continue;
+            }
+            CHECK((w >= ring) && ((w + l) <= (ring + ch.size)), "reservation outside the ring");
+            fill(w, l, seq_w);
+            mp_thread_channel_commit(&ch, l);
+            pending[(head + n_pending++) % 64] = l;
+            seq_w++;
+        }
+        else {
+            uint8_t *r = mp_thread_channel_receive(&ch, &len);
+            if (n_pending == 0) {
+                CHECK(r == NULL, "message received from the empty channel");
+                continue;
+            }
+            CHECK((r != NULL) && (len == pending[head]) && check_data(r, len, seq_r), "wrong message %u", seq_r);
+            mp_thread_channel_release(&ch);
+            head = (head + 1) % 64;
+            n_pending--;
+            seq_r++;
+        }
+    }
+    CHECK(seq_r > 10000, "too few messages exchanged (%u)", seq_r);
+}
+
+// The producer and the consumer in two threads, as the two MicroPython instances
+#define THREADED_MESSAGES   500000
+static thread_channel_t th_ch;
+static volatile int th_errors = 0;
+
+static void *producer(void *arg)
+{
+    (void)arg;
+    for (uint32_t seq = 0; seq < THREADED_MESSAGES; seq++) {
+        uint32_t l = 1 + (seq * 7919) % 200;
+        uint8_t *w;
+        while ((w = mp_thread_channel_reserve(&th_ch, l)) == NULL) sched_yield();
+        fill(w, l, seq);
+        mp_thread_channel_commit(&th_ch, l);
+    }
+    return NULL;
+}
+
+static void test_threaded(void)
+{
+    pthread_t th;
+    uint32_t len;
+    channel_init(&th_ch, 512);
+    pthread_create(&th, NULL, producer, NULL);
+    for (uint32_t seq = 0; seq < THREADED_MESSAGES; seq++) {
+        uint8_t *r;
+        while ((r = mp_thread_channel_receive(&th_ch, &len)) == NULL) sched_yield();
+        if ((len != 1 + (seq * 7919) % 200) || !check_data(r, len, seq)) th_errors++;
+        mp_thread_channel_release(&th_ch);
+    }
+    pthread_join(th, NULL);
+    CHECK(th_errors == 0, "%d corrupted messages", th_errors);
+    CHECK(mp_thread_channel_free(&th_ch) == 512, "space not given back");
+}
+
+int main(void)
+{
+    test_basic();
+    test_wrap();
+    test_exact_end();
+    test_random();
+    test_threaded();
+    if (failed) {
+        printf("thread_channel: %d test(s) failed\n", failed);
+        return 1;
+    }
+    printf("thread_channel: OK\n");
+    return 0;
+}
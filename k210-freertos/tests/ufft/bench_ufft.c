@@ -0,0 +1,96 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host benchmark of the ufft module kernels (ufftkernels.c)
+ * The software FFT (ufft.fft_sw()) against the recursive reference model and
+ * the spectrum helpers against the straightforward implementations;
+ * the time is the best of 'BENCH_RUNS' runs of 'BENCH_FRAMES' frames.
+ */
+#include <stdio.h>
+#include <time.h>
+#include "ufft_reference.h"
+
+#define BENCH_RUNS      20
+#define BENCH_FRAMES    64
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+#define BENCH(name, ref_call, kernel_call) do { \
+    double best_ref = 1e30, best_kernel = 1e30; \
+    for (int r = 0; r < BENCH_RUNS; r++) { \
+        double t0 = now_us(); \
+        for (int f = 0; f < BENCH_FRAMES; f++) { ref_call; } \
+        double t1 = now_us(); \
+        for (int f = 0; f < BENCH_FRAMES; f++) { kernel_call; } \
+        double t2 = now_us(); \
+        if ((t1 - t0) < best_ref) best_ref = t1 - t0; \
+        if ((t2 - t1) < best_kernel) best_kernel = t2 - t1; \
+    } \
+    printf("%-28s %10.2f %10.2f %7.2fx\n", name, best_ref / BENCH_FRAMES, best_kernel / BENCH_FRAMES, best_ref / best_kernel); \
+} while (0)
+
+static int16_t in[512 * 2], out[512 * 2], out_ref[512 * 2], win[512 * 2];
+static uint16_t mag[512];
+static uint32_t pw[512];
+static volatile uint32_t sink;
+
+static void ref_calc_magnitude(const int16_t *data, uint16_t *res, int n)
+{
+    for (int i = 0; i < n; i++) res[i] = ref_magnitude(data[i*2], data[i*2+1]);
+}
+
+static void ref_apply_window(int16_t *data, int n, int kind)
+{
+    for (int i = 0; i < n; i++) data[i] = (int16_t)(data[i] * ref_window(kind, i, n));
+}
+
+int main(void)
+{
+    uint32_t seed = 1;
+    char name[32];
+    int ok = 1;
+
+    ref_random_data(in, 512, 20000, &seed);
+    printf("%-28s %10s %10s %8s\n", "kernel (us/frame)", "reference", "kernel", "speedup");
+    for (int n = 64; n <= 512; n *= 2) {
+        snprintf(name, sizeof(name), "fft_sw %d points", n);
+        BENCH(name, ref_fft(in, out_ref, n, 0x1FF, false), ufft_sw_fft(in, out, n, 0x1FF, false));
+        ok &= (memcmp(out, out_ref, n * 4) == 0);
+    }
+    BENCH("magnitude 512", ref_calc_magnitude(in, mag, 512); sink += mag[f], ufft_calc_magnitude(in, mag, 512); sink += mag[f]);
+    BENCH("power 512", for (int i = 0; i < 512; i++) pw[i] = in[i*2] * in[i*2] + in[i*2+1] * in[i*2+1]; sink += pw[f],
+          ufft_calc_power(in, pw, 512); sink += pw[f]);
+    BENCH("window (Hann) 512", memcpy(win, in, 1024); ref_apply_window(win, 512, UFFT_WINDOW_HANN),
+          memcpy(win, in, 1024); ufft_apply_window(win, 512, 1, UFFT_WINDOW_HANN));
+    if (!ok) printf("fft_sw result differs from the reference\n");
+    return (ok) ? 0 : 1;
+}
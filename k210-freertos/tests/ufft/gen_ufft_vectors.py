@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+#
+# Generate the fixed FFT reference vectors (ufft_vectors.h) for test_ufft.c
+#
+#   gen_ufft_vectors.py > ufft_vectors.h
+#
+# The expected outputs are the exact DFT, computed in double precision with the
+# Python 'math' module and scaled as the hardware FFT scales with the given shift mask
+# (1/2 for each set bit), rounded to the nearest integer. They don't depend on the
+# C kernels or on the reference model in ufft_reference.h.
+#
+
+import math
+
+VECTORS = (
+    # name, points, shift, inverse, amplitude, seed
+    ("rand64_fwd",      64, 0x1FF, False, 20000, 1),
+    ("rand64_inv",      64, 0x1FF, True,  20000, 2),
+    ("rand64_noshift",  64, 0x000, False,   300, 3),
+    ("rand128_half",   128, 0x0F0, False,  2000, 4),
+    ("rand256_fwd",    256, 0x1FF, False, 30000, 5),
+    ("rand512_fwd",    512, 0x1FF, False, 32000, 6),
+    ("rand512_inv",    512, 0x1FF, True,  32000, 7),
+)
+
+def Random(n, amp, seed):
+    # LCG, the same sequence as ref_rand() in ufft_reference.h
+    data = []
+    for _ in range(n * 2):
+        seed = (seed * 1664525 + 1013904223) & 0xFFFFFFFF
+        data.append(((seed >> 8) % (2 * amp + 1)) - amp)
+    return data
+
+def Dft(data, n, shift, inverse):
+    scale = 1.0
+    for s in range(int(math.log2(n))):
+        if shift & (1 << s):
+            scale /= 2
+    sign = 1.0 if inverse else -1.0
+    out = []
+    for k in range(n):
+        re = im = 0.0
+        for i in range(n):
+            a = sign * 2.0 * math.pi * ((i * k) % n) / n
+            re += data[i*2] * math.cos(a) - data[i*2+1] * math.sin(a)
+            im += data[i*2] * math.sin(a) + data[i*2+1] * math.cos(a)
+        out.append(int(round(re * scale)))
+        out.append(int(round(im * scale)))
+    return out
+
+def Array(name, values):
+    lines = ["static const int16_t {}[{}] = {{".format(name, len(values))]
+    for i in range(0, len(values), 16):
+        lines.append("    " + ", ".join(str(v) for v in values[i:i+16]) + ",")
+    lines.append("};")
+    return "\n".join(lines)
+
+def main():
+    print("// Generated by gen_ufft_vectors.py, do not edit")
+    print("// Exact DFT of the fixed input vectors, scaled as by the 'shift' mask and rounded\n")
+    print("#ifndef _UFFT_VECTORS_H_\n#define _UFFT_VECTORS_H_\n")
+    print("#include <stdint.h>\n#include <stdbool.h>\n")
+    for name, n, shift, inverse, amp, seed in VECTORS:
+        data = Random(n, amp, seed)
+        print(Array(name + "_in", data))
+        print(Array(name + "_out", Dft(data, n, shift, inverse)))
+        print()
+    print("typedef struct _ufft_vector_t {\n    const char *name;\n    int points;\n    int shift;\n    bool inverse;\n"
+          "    const int16_t *in;\n    const int16_t *out;\n} ufft_vector_t;\n")
+    print("static const ufft_vector_t ufft_vectors[] = {")
+    for name, n, shift, inverse, amp, seed in VECTORS:
+        print('    {{ "{0}", {1}, 0x{2:03X}, {3}, {0}_in, {0}_out }},'.format(name, n, shift, "true" if inverse else "false"))
+    print("};\n\n#endif")
+
+if __name__ == '__main__':
+    main()
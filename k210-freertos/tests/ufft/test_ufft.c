@@ -0,0 +1,246 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host tests of the ufft module kernels (ufftkernels.c)
+ * The software FFT must be bit exact with the reference model for all sizes,
+ * shift masks and directions, in place and out of place, and close to the exact DFT.
+ * The fixed vectors in ufft_vectors.h (generated by gen_ufft_vectors.py) don't depend on the model.
+ */
+#include <stdio.h>
+#include "ufft_reference.h"
+#include "ufft_vectors.h"
+
+static int failed = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failed++; \
+        return; \
+    } } while (0)
+
+static int16_t in[512 * 2], out[512 * 2], inplace[512 * 2], ref[512 * 2];
+
+// Bit exact with the reference, random data of different amplitudes
+static void test_fft_exact(void)
+{
+    static const int shifts[] = { 0x1FF, 0x000, 0x155, 0x0AA, 0x00F, 0x1F0, 0x001, 0x100 };
+    static const int amps[] = { 32767, 16384, 1000, 3 };
+    uint32_t seed = 1;
+
+    for (int n = 64; n <= 512; n *= 2) {
+        for (int s = 0; s < 8; s++) {
+            for (int a = 0; a < 4; a++) {
+                for (int inv = 0; inv < 2; inv++) {
+                    ref_random_data(in, n, amps[a], &seed);
+                    memcpy(inplace, in, n * 4);
+                    ref_fft(in, ref, n, shifts[s], inv);
+                    ufft_sw_fft(in, out, n, shifts[s], inv);
+                    ufft_sw_fft(inplace, inplace, n, shifts[s], inv);
+                    CHECK(memcmp(out, ref, n * 4) == 0, "%d points, shift 0x%03x, amplitude %d, %s",
+                          n, shifts[s], amps[a], (inv) ? "inverse" : "forward");
+                    CHECK(memcmp(inplace, ref, n * 4) == 0, "in place, %d points, shift 0x%03x, amplitude %d, %s",
+                          n, shifts[s], amps[a], (inv) ? "inverse" : "forward");
+                }
+            }
+        }
+    }
+}
+
+// Full scale input without scaling saturates, the same way as the reference
+static void test_fft_saturation(void)
+{
+    for (int n = 64; n <= 512; n *= 2) {
+        for (int i = 0; i < n; i++) {
+            in[i*2] = (i & 1) ? -32768 : 32767;
+            in[i*2+1] = 32767;
+        }
+        ref_fft(in, ref, n, 0, false);
+        ufft_sw_fft(in, out, n, 0, false);
+        CHECK(memcmp(out, ref, n * 4) == 0, "%d points", n);
+        int saturated = 0;
+        for (int i = 0; i < n * 2; i++) saturated += (out[i] == 32767) || (out[i] == -32768);
+        CHECK(saturated > 0, "%d points: no saturation", n);
+    }
+}
+
+// With the default shift the result is the DFT scaled by 1/N
+static void test_fft_accuracy(void)
+{
+    static double exact[512 * 2];
+    uint32_t seed = 7;
+
+    for (int n = 64; n <= 512; n *= 2) {
+        for (int inv = 0; inv < 2; inv++) {
+            ref_random_data(in, n, 20000, &seed);
+            ufft_sw_fft(in, out, n, 0x1FF, inv);
+            ref_dft(in, exact, n, inv, 1.0 / n);
+            double max_err = 0;
+            for (int i = 0; i < n * 2; i++) {
+                double e = fabs(out[i] - exact[i]);
+                if (e > max_err) max_err = e;
+            }
+            CHECK(max_err <= 6.0, "%d points %s: error %.2f", n, (inv) ? "inverse" : "forward", max_err);
+        }
+    }
+}
+
+// Fixed input vectors against the exact DFT computed outside of the C code
+// Each stage adds at most 2 LSB of rounding error (twiddle product, shift),
+// doubled by each following stage which is not scaled
+static void test_fft_vectors(void)
+{
+    for (size_t v = 0; v < sizeof(ufft_vectors) / sizeof(ufft_vectors[0]); v++) {
+        const ufft_vector_t *vec = &ufft_vectors[v];
+        int stages = 0;
+        while ((1 << stages) < vec->points) stages++;
+        int tolerance = 0;
+        for (int s = 0; s < stages; s++) {
+            int err = 2;
+            for (int t = s + 1; t < stages; t++) if (!((vec->shift >> t) & 1)) err *= 2;
+            tolerance += err;
+        }
+        ufft_sw_fft(vec->in, out, vec->points, vec->shift, vec->inverse);
+        for (int i = 0; i < vec->points * 2; i++) {
+            CHECK(abs(out[i] - vec->out[i]) <= tolerance, "%s: %s of point %d is %d, expected %d (+-%d)",
+                  vec->name, (i & 1) ? "imaginary" : "real", i / 2, out[i], vec->out[i], tolerance);
+        }
+    }
+}
+
+// A tone in bin 'k' gives the peak in bin 'k' (and N-k for a real input)
+static void test_fft_tone(void)
+{
+    uint16_t mag[512];
+    for (int k = 1; k < 32; k += 5) {
+        for (int i = 0; i < 512; i++) {
+            in[i] = (int16_t)lround(20000.0 * cos(2.0 * M_PI * k * i / 512));
+        }
+        ufft_real_to_complex(in, in, 512);
+        ufft_sw_fft(in, out, 512, 0x1FF, false);
+        ufft_calc_magnitude(out, mag, 512);
+        int peak = 0;
+        for (int i = 1; i < 256; i++) if (mag[i] > mag[peak]) peak = i;
+        CHECK(peak == k, "tone %d: peak in bin %d", k, peak);
+        // half of the amplitude in each of the two bins
+        CHECK(abs((int)mag[k] - 10000) <= 20, "tone %d: magnitude %u", k, mag[k]);
+        CHECK(abs((int)mag[512 - k] - (int)mag[k]) <= 8, "tone %d: mirror %u, %u", k, mag[512 - k], mag[k]);
+    }
+}
+
+static void test_magnitude_power(void)
+{
+    static const int16_t edge[] = { 0, 0, 1, 0, 0, -1, 3, 4, -32768, 0, -32768, -32768, 32767, 32767, -32768, 32767, 46, 46, 181, -181 };
+    uint16_t mag[512];
+    uint32_t pw[512];
+    uint32_t seed = 11;
+
+    int n = sizeof(edge) / 4;
+    ufft_calc_magnitude(edge, mag, n);
+    ufft_calc_power(edge, pw, n);
+    for (int i = 0; i < n; i++) {
+        CHECK(mag[i] == ref_magnitude(edge[i*2], edge[i*2+1]), "(%d, %d): magnitude %u", edge[i*2], edge[i*2+1], mag[i]);
+        CHECK(pw[i] == (uint32_t)((int64_t)edge[i*2] * edge[i*2] + (int64_t)edge[i*2+1] * edge[i*2+1]),
+              "(%d, %d): power %u", edge[i*2], edge[i*2+1], pw[i]);
+    }
+    for (int r = 0; r < 200; r++) {
+        ref_random_data(in, 512, 32767, &seed);
+        ufft_calc_magnitude(in, mag, 512);
+        ufft_calc_power(in, pw, 512);
+        for (int i = 0; i < 512; i++) {
+            CHECK(mag[i] == ref_magnitude(in[i*2], in[i*2+1]), "(%d, %d): magnitude %u", in[i*2], in[i*2+1], mag[i]);
+            CHECK(pw[i] == (uint32_t)((int64_t)in[i*2] * in[i*2] + (int64_t)in[i*2+1] * in[i*2+1]), "(%d, %d): power", in[i*2], in[i*2+1]);
+        }
+    }
+}
+
+static void test_real_to_complex(void)
+{
+    int16_t real[512];
+    uint32_t seed = 5;
+    for (int i = 0; i < 512; i++) real[i] = ref_rand(&seed);
+    ufft_real_to_complex(real, out, 512);
+    memcpy(inplace, real, sizeof(real));
+    ufft_real_to_complex(inplace, inplace, 512);
+    for (int i = 0; i < 512; i++) {
+        CHECK((out[i*2] == real[i]) && (out[i*2+1] == 0), "sample %d", i);
+        CHECK((inplace[i*2] == real[i]) && (inplace[i*2+1] == 0), "in place, sample %d", i);
+    }
+}
+
+static void test_window(void)
+{
+    for (int kind = UFFT_WINDOW_HANN; kind <= UFFT_WINDOW_BLACKMAN; kind++) {
+        for (int step = 1; step <= 2; step++) {
+            int n = 256;
+            for (int i = 0; i < n * step; i++) in[i] = (i & 1) ? -32768 : 32767;
+            ufft_apply_window(in, n, step, kind);
+            for (int i = 0; i < n; i++) {
+                for (int j = 0; j < step; j++) {
+                    int16_t orig = ((i * step + j) & 1) ? -32768 : 32767;
+                    double expected = orig * ref_window(kind, i, n);
+                    CHECK(fabs(in[i*step+j] - expected) <= 2.0, "window %d, step %d, sample %d: %d, expected %.1f",
+                          kind, step, i, in[i*step+j], expected);
+                }
+            }
+        }
+    }
+    // the window is symmetric
+    for (int i = 0; i < 255; i++) in[i] = 10000;
+    ufft_apply_window(in, 255, 1, UFFT_WINDOW_HANN);
+    for (int i = 0; i < 127; i++) CHECK(abs(in[i] - in[254 - i]) <= 1, "asymmetric at %d", i);
+    CHECK((in[0] == 0) && (in[127] >= 9998), "Hann ends %d, middle %d", in[0], in[127]);
+}
+
+static void test_swap_ri(void)
+{
+    uint32_t data[4] = { 0x12345678, 0xFFFF0000, 0x0000FFFF, 0x80007FFF };
+    ufft_swap_ri(data, 4);
+    CHECK((data[0] == 0x56781234) && (data[1] == 0x0000FFFF) && (data[2] == 0xFFFF0000) && (data[3] == 0x7FFF8000), "swap");
+}
+
+int main(void)
+{
+    test_fft_exact();
+    test_fft_saturation();
+    test_fft_accuracy();
+    test_fft_vectors();
+    test_fft_tone();
+    test_magnitude_power();
+    test_real_to_complex();
+    test_window();
+    test_swap_ri();
+
+    if (failed) {
+        printf("ufft: %d test(s) failed\n", failed);
+        return 1;
+    }
+    printf("ufft: OK\n");
+    return 0;
+}
@@ -0,0 +1,141 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Reference implementations for the host tests of the ufft module kernels (ufftkernels.c)
+ *
+ * ref_fft() is an independent, recursive model of the hardware FFT arithmetic:
+ * radix-2 decimation in time, Q15 twiddle factors rounded from the single precision
+ * cos/sin of -2*pi*j/N, products truncated by >>15, the butterfly outputs of stage 's'
+ * (combining the 2^(s+1) point transforms) divided by 2 if bit 's' of 'shift' is set,
+ * then saturated to 16 bits. The kernel must be bit exact with it.
+ */
+
+#ifndef _UFFT_REFERENCE_H_
+#define _UFFT_REFERENCE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "ufftkernels.h"
+
+static inline uint32_t ref_rand(uint32_t *seed)
+{
+    *seed = *seed * 1664525 + 1013904223;
+    return *seed >> 8;
+}
+
+static inline int16_t ref_sat16(int32_t v)
+{
+    return (v > 32767) ? 32767 : (v < -32768) ? -32768 : v;
+}
+
+// Q15 twiddle factor W_N^j
+static inline void ref_twiddle(int j, int n, bool inverse, int32_t *wr, int32_t *wi)
+{
+    float angle = -2.0f * (float)M_PI * (float)j / (float)n;
+    if (inverse) angle = -angle;
+    *wr = (int32_t)lroundf(cosf(angle) * 32767.0f);
+    *wi = (int32_t)lroundf(sinf(angle) * 32767.0f);
+}
+
+// 'm' point transform of the input points in[0], in[stride], in[2*stride], ...
+// 'n' is the size of the whole transform, 'level' the stage number of the final combination
+static inline void ref_fft_rec(const int16_t *in, int16_t *out, int m, int stride, int n, int level, int shift, bool inverse)
+{
+    if (m == 1) {
+        out[0] = in[0];
+        out[1] = in[1];
+        return;
+    }
+    int half = m / 2;
+    int16_t *even = malloc(half * 4), *odd = malloc(half * 4);
+    ref_fft_rec(in, even, half, stride * 2, n, level - 1, shift, inverse);
+    ref_fft_rec(in + stride * 2, odd, half, stride * 2, n, level - 1, shift, inverse);
+    int sh = (shift >> level) & 1;
+    for (int k = 0; k < half; k++) {
+        int32_t wr, wi;
+        ref_twiddle(k * (n / m), n, inverse, &wr, &wi);
+        int32_t br = odd[k*2], bi = odd[k*2+1];
+        int32_t tr = ((br * wr) - (bi * wi)) >> 15;
+        int32_t ti = ((br * wi) + (bi * wr)) >> 15;
+        out[k*2] = ref_sat16((even[k*2] + tr) >> sh);
+        out[k*2+1] = ref_sat16((even[k*2+1] + ti) >> sh);
+        out[(k+half)*2] = ref_sat16((even[k*2] - tr) >> sh);
+        out[(k+half)*2+1] = ref_sat16((even[k*2+1] - ti) >> sh);
+    }
+    free(even);
+    free(odd);
+}
+
+static inline void ref_fft(const int16_t *in, int16_t *out, int n, int shift, bool inverse)
+{
+    int stages = 0;
+    while ((1 << stages) < n) stages++;
+    ref_fft_rec(in, out, n, 1, n, stages - 1, shift, inverse);
+}
+
+// Exact DFT, scaled by 'scale'
+static inline void ref_dft(const int16_t *in, double *out, int n, bool inverse, double scale)
+{
+    for (int k = 0; k < n; k++) {
+        double re = 0, im = 0;
+        for (int i = 0; i < n; i++) {
+            double a = ((inverse) ? 2.0 : -2.0) * M_PI * (double)((i * k) % n) / n;
+            re += in[i*2] * cos(a) - in[i*2+1] * sin(a);
+            im += in[i*2] * sin(a) + in[i*2+1] * cos(a);
+        }
+        out[k*2] = re * scale;
+        out[k*2+1] = im * scale;
+    }
+}
+
+static inline uint16_t ref_magnitude(int16_t re, int16_t im)
+{
+    uint64_t pw = (int64_t)re * re + (int64_t)im * im;
+    uint64_t r = (uint64_t)sqrt((double)pw);
+    while (r * r > pw) r--;
+    while ((r + 1) * (r + 1) <= pw) r++;
+    return (r > 0xFFFF) ? 0xFFFF : r;
+}
+
+static inline double ref_window(int kind, int i, int n)
+{
+    double x = 2.0 * M_PI * i / (n - 1);
+    if (kind == UFFT_WINDOW_HANN) return 0.5 - 0.5 * cos(x);
+    if (kind == UFFT_WINDOW_HAMMING) return 0.54 - 0.46 * cos(x);
+    return 0.42 - 0.5 * cos(x) + 0.08 * cos(2.0 * x);
+}
+
+// Random complex data with the amplitude 'amp'
+static inline void ref_random_data(int16_t *data, int n, int amp, uint32_t *seed)
+{
+    for (int i = 0; i < n * 2; i++) data[i] = (int16_t)((int32_t)(ref_rand(seed) % (2 * amp + 1)) - amp);
+}
+
+#endif
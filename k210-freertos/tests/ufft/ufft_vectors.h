@@ -0,0 +1,464 @@
+// Generated by gen_ufft_vectors.py, do not edit
+// Exact DFT of the fixed input vectors, scaled as by the 'shift' mask and rounded
+
+#ifndef _UFFT_VECTORS_H_
+#define _UFFT_VECTORS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+static const int16_t rand64_fwd_in[128] = {
+    -13034, 15179, -434, 5683, -12040, 19335, 18041, -8938, 16704, -15500, -18233, -13854, 9890, -18935, 3821, -4547,
+    -17073, -16077, -8113, 16182, 2815, 13750, 3521, 9797, -2119, 5329, -1022, -16353, -8575, 17776, -5820, -5909,
+    -14016, -4357, 19211, 14476, 55, -18172, -19516, -4850, 7644, 17247, 19696, -14414, 11642, 3756, -2453, 17389,
+    -6213, 6538, 7062, -18069, 15840, 12813, 10464, 14529, 19934, 4261, 16782, -19894, 3076, -17137, 11422, -9702,
+    -14559, -1645, 7236, 15309, -5036, -14680, 19130, -13538, 9098, 13801, 8141, 12429, -6532, -10164, -5768, -8215,
+    14643, -241, -17470, 16525, 10402, -8867, 17053, -16817, 18264, -19501, -15337, 11402, -11493, -17178, -10711, 11783,
+    12428, -14734, -6085, 3199, 2851, -1881, 6862, -8440, -10731, 16306, 4580, -13542, 4196, -15251, -6486, -18275,
+    -3674, -6593, 18864, 15205, 19498, 8392, -11232, 19649, -11377, 4659, 18196, 11742, -16811, -11334, 14212, -2867,
+};
+static const int16_t rand64_fwd_out[128] = {
+    1895, -875, -767, 656, 368, 1505, -1247, 217, -2067, -63, -2412, 1006, -26, -356, 1174, -422,
+    556, -798, 3336, 297, 995, 1581, -786, 1404, 442, 1338, -18, -1291, -1479, 3992, 884, -3076,
+    642, 811, -1832, 1446, 1839, -1698, 1870, 1371, 2590, -350, -317, -446, -447, 1365, -69, -47,
+    -622, -1460, -1106, 917, -2210, 1440, -2122, 3593, -3281, -238, 833, 861, -615, 1129, -2211, -844,
+    -1092, -784, 897, 809, -3122, -621, 891, -1800, -1055, 42, 217, 2147, -522, 1402, 10, -2200,
+    -861, -2250, -244, 3073, 903, 641, 2205, -993, -769, -212, 3681, 1913, 2876, -747, -1003, -316,
+    -1076, 1140, -481, -1885, -3363, 237, -1557, -1962, 1798, 1171, 663, -461, -3134, -981, 236, -444,
+    -4630, 1475, -1132, 564, -693, 60, 1981, 2555, 235, -337, 1660, 1212, 2128, -794, -2466, 558,
+};
+
+static const int16_t rand64_inv_in[128] = {
+    -6532, 16898, -10019, -13301, 9129, -13270, -7336, -15623, -8686, -11698, -6169, 18304, -18305, 12720, -5589, -1759,
+    15569, -1064, 1174, -3275, -2959, 16215, 7879, 12851, 7439, 707, -3031, -4085, 1368, -2500, -4508, -3454,
+    10484, -7830, 5873, -1548, -6175, -4418, -3253, 13242, -126, 5563, 7733, 3027, 6891, -11197, 17757, -15118,
+    -8966, 10192, -6420, 7059, 5256, -10615, 13344, -7767, -4383, -4644, -17794, 3671, 886, -4042, 4076, -3574,
+    14432, -15145, -1117, -17388, -5368, -17578, 1865, -12329, -16674, -993, 16224, 12733, -1222, 739, 7304, -14105,
+    -16783, 5042, 13207, 8406, -10657, 4908, -1227, 5339, 19873, 633, -10066, -9694, 15345, -8719, 7657, 10307,
+    -12170, 9794, -13043, -12269, -15004, -3994, 17363, -15521, -6304, -17706, -19663, 18463, -7938, -3139, -1160, 9737,
+    -6048, -8930, -1928, -989, 5571, 19392, -2910, -19028, 15353, 343, -14152, -19634, 6860, -2163, -3403, 2446,
+};
+static const int16_t rand64_inv_out[128] = {
+    -487, -1740, -1444, 1537, -1279, -1194, 606, -309, 359, -3319, -733, -1335, 1259, 557, -738, 1717,
+    823, 258, 704, 1979, 2425, 1129, -2619, 688, 2323, 2337, -1921, 2437, -275, -544, 1577, -1306,
+    -485, -1535, 170, -304, -2092, 960, 306, 1799, 818, -1190, -1609, -521, 879, -810, 302, -296,
+    416, 1735, 1033, -300, 84, -1223, -3386, 76, 252, 2262, -370, 728, 727, 1424, 1414, 542,
+    -133, 287, 1888, 1337, 304, 273, 612, 1229, 2860, -2131, 279, 532, 1084, -78, -99, -1766,
+    -1618, 137, -1902, 2115, -65, 1636, -1442, 701, -1815, 381, 854, 735, -1371, -489, -544, -1210,
+    885, 1811, 344, -492, 1713, 423, -2868, 957, -1268, 2165, 597, 2825, -1119, -387, -1871, -1241,
+    -652, 166, 756, 1339, -231, -305, -301, 864, -725, -695, 518, 1064, 354, -1426, -596, -98,
+};
+
+static const int16_t rand64_noshift_in[128] = {
+    -53, -25, 70, 198, 258, -159, 75, -289, 295, -132, 256, -219, 32, -89, 282, 222,
+    -92, 25, 271, 181, 124, 254, 38, -106, -129, -64, -234, 163, 138, 24, -8, -103,
+    114, -194, 198, -292, -33, 84, 33, -286, 181, -160, -65, 24, -147, 102, 202, -7,
+    219, -206, -70, -225, -260, -180, -143, 116, -238, -279, -170, 150, -254, -287, 204, 112,
+    -276, -213, -141, 162, 231, -175, -32, -7, 103, -222, -247, -127, 274, -210, -165, -175,
+    280, -218, -156, -138, 263, -275, -258, -72, 141, 255, 106, -93, 182, 218, -172, 7,
+    191, 262, 163, -83, -93, -117, -67, 218, -224, 213, -61, -223, 16, -191, 66, -40,
+    -275, -232, 76, 244, -212, 184, 19, 106, -226, 225, -293, -250, -71, -107, 242, -47,
+};
+static const int16_t rand64_noshift_out[128] = {
+    478, -2768, 401, 772, -1012, -3587, 2509, -2155, -1689, -1804, -3155, -1073, -4, -428, 843, 30,
+    2085, -195, 1181, 1077, 1029, 1936, 31, 1169, 120, 815, 1450, -9, 224, 1270, 614, 1427,
+    -614, 572, -1314, -1205, -594, 1769, 1272, -144, -189, 369, -572, 897, -868, 472, -1168, -3638,
+    -1204, -1267, 304, 476, -343, 645, 2615, -165, 16, 816, 2279, 629, -1202, 153, -1495, 156,
+    440, -1010, -2324, 2797, -600, -4964, 1766, 3023, 52, 62, 372, -652, -378, -1782, -1011, 15,
+    -1363, -1295, -304, -1704, -1486, -1778, -659, -492, -764, 994, -276, 1763, -1601, -2506, 1566, 356,
+    -260, -654, -2853, 468, 94, 144, 2716, -987, -549, -12, 833, 451, -2625, 741, -2070, 1943,
+    1302, 209, -331, -24, -198, 1434, 1603, -1278, 1756, 2447, 581, -423, -577, 1584, 1733, 2517,
+};
+
+static const int16_t rand128_half_in[256] = {
+    -425, -86, -500, -348, -315, -1992, 453, -141, -310, -1157, 852, -383, 1339, -585, -1881, 1184,
+    -767, 1556, -1233, -913, 808, -645, 694, -1056, -1265, -1863, -1691, 679, 1438, 1472, -1704, 1032,
+    638, 991, -1791, -788, -768, -647, 1119, -1943, 1749, 1766, 1864, -1844, -1695, 289, 802, -1233,
+    898, 1569, 1190, -538, -705, -845, 312, -133, -69, -43, 1271, -1046, 470, -1764, -1167, 1595,
+    1107, 1228, 1862, 509, -1231, 342, 322, -242, 626, 591, -404, -565, -461, -1343, -47, -758,
+    -320, -1470, 1101, 1828, -1801, 997, -647, -1615, -368, 167, 888, 1042, 562, -92, 739, 516,
+    -354, -275, 129, 1218, 1217, 1837, -1315, -669, -436, -23, 62, 886, -1659, 1484, -171, 1843,
+    1052, -1179, 1479, -553, 1830, 155, -1577, -397, 1144, -1998, 1737, 201, -296, -924, -1472, -95,
+    1091, -371, -1212, 704, -1217, 971, -1715, 1165, 1465, -1887, -19, -968, 836, 564, -283, -1851,
+    -1395, -161, -455, -719, -1148, 1113, 1534, -1454, 1381, 1121, 1145, 779, -1336, 1164, 1657, -671,
+    1283, -1921, 1948, 1985, -1919, 1204, -1352, 1440, -230, -253, 731, 652, 1037, 439, -205, -838,
+    -1008, 979, -307, -157, 243, 723, 1214, -851, 828, 753, 1101, 354, -876, 1361, 563, 748,
+    -1855, -760, 1819, -369, 32, 1154, -272, -1741, -1530, -939, -579, 1564, -264, -589, 206, -708,
+    -1059, 659, 1488, -611, -1641, -1004, 1400, -1845, 559, 1662, 345, -1430, 1543, -405, 626, -507,
+    1726, 1270, -168, 977, 802, -194, 975, 1613, 1213, 798, 890, 773, 503, 1548, -1924, 1298,
+    1260, -708, -243, -270, 1825, -708, 498, 281, -831, -1947, 1256, -1746, 1156, 1564, 1141, 1287,
+};
+static const int16_t rand128_half_out[256] = {
+    2148, 109, 65, -158, -704, 381, -252, 3180, -2045, 94, 798, -1517, 734, -2250, 1088, -2310,
+    2087, 3166, -561, -592, -48, 1851, 65, 1470, -1078, 1045, 441, -1483, -2101, -420, -3417, 1298,
+    -1933, 2508, -1373, 357, -696, 2176, 518, 1853, 773, 515, 600, -1651, 2557, 2775, -3243, -283,
+    785, 298, 559, 4431, -567, -151, -427, -308, -3285, -402, -340, -2635, -2563, -1147, -3243, 3139,
+    1642, -3076, -2504, 2999, -1162, -1865, -1585, 172, -454, -1921, 643, 368, 3062, 1916, -75, -25,
+    -238, -841, -167, -1439, 179, 230, -465, 314, 1276, -635, -1354, -2255, 1504, 2708, 2863, -410,
+    107, -1439, 2234, -841, 2384, 1232, 1085, 1085, -2485, 2377, -1246, 112, 1574, -519, 222, -816,
+    979, -569, -571, 1032, -2052, 809, -1615, 1156, -655, -2166, -1024, -1440, 1861, -1979, 1130, 1495,
+    -1122, 1070, 229, -617, 4552, -1303, -1090, -1869, -227, -549, -4749, 351, 359, -33, -1036, 4585,
+    -241, -2108, 984, -1943, -2054, -317, -1702, -955, -2011, 722, 56, 428, -1243, -437, 1367, 2462,
+    989, 207, 175, 174, 1310, 83, -751, -1785, 2039, 660, 532, -1754, -799, 307, -3332, -1158,
+    464, 122, 326, -39, -582, 782, -2221, 920, 1336, -933, -611, -3414, 1136, -923, -1281, 1825,
+    230, 932, 1416, -443, 103, -2421, -2328, 932, 66, 2678, 2122, -775, 1225, 1192, 1818, -1622,
+    1188, -1386, 206, -386, -690, -3998, 1231, 556, 137, 499, -1040, 1296, 681, -719, -127, 1605,
+    -190, 1011, 2485, 1387, -444, 934, 1833, -2597, -1121, 1835, 2289, -590, -1835, 78, -1061, 434,
+    -475, 149, 1404, 880, -551, -1371, 599, -80, 983, -3928, -136, -551, 527, -1302, 1416, -1275,
+};
+
+static const int16_t rand256_fwd_in[512] = {
+    3007, 12156, 28056, -133, -10858, 15768, 200, 14355, -8441, 29830, -13565, -18404, -12819, -22228, -594, -9683,
+    -6055, -5972, -17641, 28366, -23738, 66, -22538, -7902, 6196, 10502, -25330, -20423, -1936, 3502, 6265, -25976,
+    -5990, -11398, -800, 20416, 2060, 26884, -24401, -19240, -16515, -19413, 28306, -8161, -553, 13966, -5195, 6993,
+    -23913, 4788, 26351, -17884, 13916, 25952, 11984, -1357, -7296, -14907, 11764, -29132, -18833, 11738, 12058, 28046,
+    25009, -8766, 10359, -25342, 3651, -19408, -23113, -12232, 9616, -18487, -26214, -2654, -8847, 326, -23351, -1769,
+    -4168, -28986, 18444, 20535, -20493, 16278, -9132, -21357, -28477, -2423, -7430, 20240, 5959, 3540, -753, 5604,
+    7269, 10186, -27004, -8617, -24927, -13876, -17842, -3518, 16996, 16745, 20895, 7707, 8882, -16760, -21495, 625,
+    16909, -25908, -14274, 17261, -29372, 2515, 25670, 18234, 5593, 20639, -1167, -3631, -5630, 1770, 13772, -25186,
+    28519, -5694, -4775, 614, 17378, -28215, 26513, -24270, 6793, 3729, 26630, 11410, -4679, -26424, 1029, -26911,
+    -486, -28942, 8864, 16363, -2813, 24401, 17379, -19533, -14156, 11083, -2594, 28276, 4435, 16834, -28273, -9206,
+    -7051, -10459, -24330, 15057, -17692, 8022, 3678, 22067, 11238, -17586, -26897, 8092, -21551, -21063, -6586, 27666,
+    20306, -7021, -4024, 24588, 18174, -22316, -16011, 13058, -17986, 11279, -2808, -25317, -516, 18936, -8377, -5956,
+    4283, 23613, 9607, -22156, 26185, -29518, 21321, 8961, -21701, -13941, -9392, 22413, 2348, -5530, -8050, -18219,
+    -4531, 15766, 1021, -20888, 24892, 20256, -22563, -5493, 21030, -3094, 12210, 5464, -17989, -11112, 11312, 27386,
+    10449, 9087, -17177, -11336, 5212, -3043, 17990, 11478, 7006, -18768, 2291, -2073, -20542, -24879, 18397, 9057,
+    8466, 6298, 16217, -12460, -5336, 18272, 5223, -8958, -14446, 6145, 1587, -21423, -29387, -21888, 27994, 9834,
+    11158, -7438, 817, 3759, -2897, 21245, -6081, 1601, 1321, 20068, 28667, 9340, -27807, 20316, -3072, 25433,
+    28409, -26767, -23447, 156, 29383, -6101, -25089, 25806, 6252, -12577, -19623, -29122, -27753, 25571, -7909, -342,
+    7270, -20649, -26522, 29796, -26665, 8478, -16715, -27090, -6800, 28007, -19953, -9749, -5609, -13785, -15065, 3042,
+    11687, -23801, 27542, 17672, -18364, -8553, -24240, 23538, 4843, -25270, -8192, -12692, -26968, 10027, -3566, 14387,
+    5296, -11200, -6533, 13062, 2209, -3263, 21956, 18966, -23529, 6867, -2018, -17652, -7075, -20411, -6971, -20598,
+    -19658, 19665, 8269, 17354, -5284, 3491, 24840, 22832, -15084, -13822, -12717, -25234, -1742, 852, 13203, 16932,
+    8215, 8160, -5231, 10272, -342, -4567, -14136, 28797, -917, -2097, -10864, -7662, 23027, -2185, 3425, 2097,
+    -19374, -20933, 14472, 26896, -14329, -1382, 16225, -26934, -5004, -8431, -25869, -11761, 15441, 18025, -9142, -19730,
+    -16788, -16604, 20273, -5306, 6191, 26926, 6506, -22461, 1661, -24321, -842, -8047, -23968, -24996, 2364, -9779,
+    4448, 11625, -7599, 13610, 19186, -9381, 2619, 25222, -28401, -9048, 24792, 1608, 8200, -27869, -25856, -11109,
+    9256, 17573, -8875, 13088, 2201, 24905, -27616, 18865, 2021, 14198, -27319, 14884, 22443, 12814, 7689, -7067,
+    -5950, -11416, -21175, 18297, 16772, 15425, 10665, 10255, -20761, 750, -23185, 22969, -28422, -12570, -6717, -5715,
+    9526, -7536, -25687, -8170, -27344, -3991, -185, -22768, -20156, -13103, 11711, -157, -1949, 6571, 4338, -18286,
+    -28797, -20090, -9776, 12187, 1445, 11105, -28244, 20722, -15700, -6241, -27130, -6818, -9408, -18150, 8649, -546,
+    -13273, -16119, 21212, -18402, -652, -21791, 26805, -29049, 19745, 527, -11958, -29434, -19116, 5276, -14217, 16493,
+    14146, -13464, -9472, -10809, -3886, -25194, -28767, 9157, -1905, 5277, -5394, -29611, -4450, 3930, -10846, 17467,
+};
+static const int16_t rand256_fwd_out[512] = {
+    -2654, -886, -1091, -1730, -702, 119, 1, -1219, 2203, 434, 391, -395, 123, 3053, -645, 2099,
+    813, -620, -770, 219, 1234, 1098, 298, 586, 127, -426, -339, 1095, 161, 174, 204, -1148,
+    -714, -715, 134, -293, 1698, -868, 1168, -728, 1521, -118, 725, 714, 585, 604, -328, 2417,
+    505, -864, -1151, 431, 377, 138, 33, 713, 404, 877, -600, 166, -615, 714, 270, -846,
+    2798, -869, -330, 1739, 1305, -385, 940, -609, -235, -835, 366, -928, 1317, 34, 169, -913,
+    -599, -1368, 124, -1234, -367, 839, -867, 145, 974, 325, -82, -1269, 145, 501, 169, -710,
+    -611, 1965, 1622, 473, 248, 380, -2452, -1210, -454, -1337, -2286, -1099, -594, -1475, -1812, 365,
+    -238, 415, 982, 1252, -1012, 1289, -1197, 1201, 2126, 1343, -271, -895, 577, -138, 14, 531,
+    656, -624, -160, -1599, -2014, -578, -1314, 2312, 11, -337, 1531, 259, -105, 581, 550, -1992,
+    -333, -206, 520, 622, -1089, -943, -643, -349, 480, -216, 357, -1081, 50, -114, -1681, -318,
+    545, -134, 306, 10, 1115, -68, -318, 728, -2715, -1173, 1748, -483, -19, 158, 1473, 1282,
+    -761, 243, 408, -2251, 1055, 684, -267, 130, -206, -260, -542, -2403, 695, 808, -687, -1063,
+    1008, -914, -465, -947, -2555, 372, 2031, 76, -149, -1808, 1544, -87, 83, -1106, -2143, 172,
+    1899, -154, 310, 740, -570, 1058, -442, 1291, -575, 105, 481, 896, -2042, -1509, -1055, 1723,
+    381, 1500, -253, -1222, -803, -2001, 445, -1874, 395, 402, -2029, -409, 261, 1240, 613, -561,
+    -1715, 242, 1603, -683, 257, 313, 1195, -1078, -442, 1464, -1173, -338, -432, 273, -253, 1027,
+    -99, -1103, 246, 659, 44, 1376, 728, 152, -235, -340, 1665, 839, 770, -1899, 392, 696,
+    -1031, 1062, -694, -415, -1797, -1192, 1189, 1283, -1166, 1259, 90, 369, 174, 1492, 788, -1269,
+    26, 1324, 633, 1228, -1206, -9, -1230, 1877, 799, 745, -1287, 44, 1243, -239, 705, -1330,
+    151, 390, -423, 268, 685, -714, -558, 1523, 1270, -881, -2575, 805, 57, -2819, -253, 1502,
+    247, -1811, -768, -611, -1163, -894, -778, 836, -686, -953, 316, -240, -53, 927, 246, -11,
+    257, -485, 577, 755, 777, 1464, 886, 32, -1312, -72, -417, 203, 1782, -2330, -136, 788,
+    542, -641, 298, 1494, -1286, 45, 201, -1473, -1591, 1045, -621, -469, 391, 2563, 1189, 603,
+    396, -1281, 352, -1354, 1478, -286, 546, 1178, 720, -634, -367, -117, 2341, 1272, -1514, 583,
+    1013, -951, -256, -211, 2241, -712, 261, 1019, 221, 1149, 564, 2456, 561, 1261, -809, -85,
+    634, 1673, 3102, -294, -578, 351, -1630, 1492, -858, -1363, -309, -759, -429, 1825, 455, 366,
+    1973, -219, -100, 379, -987, -781, -743, -106, -942, 585, -116, -712, 593, -1770, -758, 828,
+    996, 255, 1230, -670, 1702, 136, 1001, -1868, -809, -1327, -1983, 1050, 707, 737, 596, 156,
+    -545, 1213, -572, -1252, 1068, 547, 970, 893, -1028, -69, -1039, 1488, -1336, -299, 398, 287,
+    910, 1513, -810, 317, -1017, -708, 56, 436, 213, -604, 1182, 672, -403, 98, 1119, 1063,
+    818, 671, 1070, -1091, -563, 495, 120, 878, -518, 2326, 497, 425, -1175, 1169, 279, 517,
+    1481, -1305, -155, -1764, -1777, 753, -1250, 1106, 183, -1020, -250, 808, -606, -350, -699, 92,
+};
+
+static const int16_t rand512_fwd_in[1024] = {
+    -487, 11902, -18621, -13097, -8525, -10870, 17697, 25661, 20250, 23655, -27430, 24662, 992, -16570, 16035, 7036,
+    -14585, 7050, -31246, -28154, 31660, 20626, 2985, 5175, 25783, -19246, 26615, -14184, 21986, 2124, 14471, 18518,
+    507, 31074, -5012, -5616, -10176, -9386, -14146, -7120, 5690, 26896, 18438, 10425, -30411, 13015, -26922, 8606,
+    -9559, -8700, 6900, -3566, -13861, -3504, -2215, -6530, 30387, 26283, 23247, 3592, 12929, 17977, -29286, 8202,
+    -7152, 23692, 31182, -939, 14239, -8349, -13473, -4934, 6698, 679, 2972, 3595, -1459, 9217, 23739, -731,
+    -25620, -25675, -28860, 9571, -28427, 8049, -13433, -21238, 28, -5120, -23269, -10847, -25180, -18023, 10758, -2663,
+    -3304, 17605, -3971, -6082, 16081, 14099, -2220, 7444, 16358, -114, -17287, -2247, 18786, -6661, -30230, 22597,
+    -19456, 9731, -9073, -4969, 11594, 19538, -27150, -10386, 22320, 10374, -26587, -20986, -8799, 29018, -12904, 26215,
+    -27103, -22401, -27068, 21994, 31733, 24133, -19890, -20562, -7850, 20816, -3621, -22989, -4287, -28705, -25115, 27890,
+    -7066, -4129, -19911, -4404, 13902, 12485, -29229, -15978, 19950, 1052, -10370, 19455, 14926, 13643, -3546, 31896,
+    -20824, -2597, 12719, -24571, -449, -14038, -3186, -18088, -26324, -16730, -19689, -28938, 21349, -29258, -18884, 8448,
+    -26621, -29681, 2928, 13247, -1920, 30454, -21781, 22190, -953, 10713, 9436, 60, -11472, 4147, 31607, -14833,
+    22900, -20323, -31502, -2619, -2040, 116, 2761, -21979, -17157, 4471, -10016, -8818, -24877, -22918, 9593, -8698,
+    16400, -1554, -18927, -1120, -4222, -2682, 30565, -16343, -7182, -21527, 25925, 3224, 25951, -10572, -27579, 19870,
+    25263, 11072, 17948, 16104, 7359, 10296, 18483, 24171, 23863, 6097, -21504, 30223, 9012, 15374, -22509, 19299,
+    11298, 18559, 4537, -18366, -22242, 133, 27886, 6358, -10088, 5054, 22000, -26126, 1678, 26223, 15953, 1474,
+    31197, 5079, 21982, 960, 11257, -4620, 11128, 24295, 28206, -20758, 9125, -1380, 26579, 22326, -17780, 14149,
+    17202, 24953, 2754, 3570, -28381, -30874, -17984, -7483, -20809, 13541, -10396, -6616, -10215, -27170, 27487, -14638,
+    -539, -31687, -16968, 26413, -22952, 15519, 13508, 2436, -17397, 30512, -30182, -19612, 29841, 11439, -672, -31569,
+    24979, -14004, 18492, -7014, -9835, -20205, 6269, 1610, 22685, -12519, 10307, -30160, -20248, 20340, -30690, -12308,
+    12552, -18715, -29229, -21111, 3240, -17011, -3903, 31118, -6957, 6967, 31471, -4971, -8737, -28130, 19457, 27496,
+    -24862, -29189, -11012, 28055, 30083, 23770, 14665, 4641, 27773, -29114, 19852, -6131, -31351, 6542, -16056, 13575,
+    20702, 15347, 4388, 24017, -28734, 28292, 12941, 29069, -26272, 17086, 7925, 7812, 9951, -30435, 30435, -22538,
+    6204, 31554, 28814, 238, -18924, -9101, -4158, -26324, 3187, -4728, -29344, 9673, -12002, 879, -26998, -8241,
+    -30124, 15927, 24403, -6525, 21676, -11849, -8252, -27552, 4213, -26191, 13880, -7555, 18505, 8988, 26231, -22587,
+    -22797, 11404, 27963, -11994, -16987, -19698, -4851, -24645, -6311, -12524, 25132, 15989, 3957, 21585, -27764, 22995,
+    30920, -6605, 2762, -30044, 4990, -9534, -19066, -14284, 27310, -12510, 7935, -31783, -7069, 16529, 24859, 28153,
+    18132, 28394, -19191, 9798, -14451, 16185, 22456, -13477, -18427, 26986, 6543, 30276, -20006, 7503, 23541, -14243,
+    -4637, -31991, 24742, 4305, -6294, -11593, -15512, 12670, -5002, 19038, 2499, -8953, -28128, -14906, 23614, 399,
+    16628, -8419, -13897, -20756, -21409, -5891, 16344, -4637, -23789, -21487, 21104, 23385, -11690, -16780, 29041, 12437,
+    25522, 7062, 6091, 5418, -565, -20728, 8061, 26357, 6702, -20273, 19021, -29572, 28423, -15615, -20163, -9405,
+    21206, 11917, -17979, -11966, 17837, 8634, -27897, 10358, -30721, -3624, 27883, -6160, 16509, -4931, -12137, 13147,
+    23446, -4267, 30937, 5208, 17667, -13418, 3920, -6739, -3081, 24342, 4758, 7348, -12735, -13201, -23943, 20141,
+    -25026, 9292, 11118, -23038, 25142, 16722, -22451, -30579, -10195, -24652, -24243, -23205, 4738, 9992, 15368, -31135,
+    -2986, 3188, -14309, -5220, -16993, 5037, -18958, -26886, 1500, 2035, 24779, 29508, -27510, -13521, -27059, 25119,
+    -27034, 5671, -26721, 9832, -1571, 19466, -5841, -23329, 11983, 16574, 5693, 15842, -17357, 16673, -13993, -4561,
+    13842, -28468, 26285, 24251, -20918, -26352, -23071, -27011, -25403, -3488, 25188, 28098, -21179, -28868, 10251, -5434,
+    -13097, -22136, -8183, -451, 1413, 7046, -23881, 1662, 1266, 25660, 19322, -9753, 5368, 25546, -27626, -31472,
+    9281, 26854, -26022, -7158, -8508, 12513, 12838, -6604, 7534, -31108, 5902, 30938, -10657, -12654, 5887, 15247,
+    -24712, 31624, 11559, 19173, 10056, 24047, -29859, -20806, 15506, 14764, 273, 16857, 7645, 22695, -28705, -28383,
+    -30538, -14870, 1459, -22169, -28189, 11952, 1596, 26952, 28029, 13714, 2739, 10286, 31869, 20227, -6016, -29116,
+    2454, -274, -1520, 26677, -24749, 31183, -2261, -25543, -6279, 10413, 23123, 2096, 31614, 24904, 12595, -15041,
+    -4697, -25672, 19700, -21448, 2728, 16506, -14308, -31151, -27033, 29971, 23418, 3212, 12477, -14239, -31279, -20121,
+    18376, -28109, -21834, -5720, 14821, -12791, -10099, 17893, 3141, -28403, 24256, -29073, -9954, -2249, -13668, -22236,
+    -17500, -22560, 8234, -28555, -4050, -31059, 327, 26392, 26496, 23215, -16442, 184, 9976, -23456, -14533, -24500,
+    5904, -16272, -20560, 17211, -15256, 15378, -1671, 5372, 20349, -9281, -24042, -6109, 22170, 28374, -19294, 25927,
+    23442, 5262, 13838, -25950, -24931, -24801, -9822, -1594, -28937, 13364, -28364, -26754, 9625, -12127, -22272, 7971,
+    25534, -10125, -19356, -15247, -28070, -1111, 3432, -1026, 22140, 1783, 5465, -4893, -27293, 15746, -28991, 11248,
+    -3657, -21338, -22243, -10032, 30788, -24558, 11679, -13119, 28381, 25751, -7017, -22834, -23912, -18259, 13152, -21806,
+    24724, 27820, 18406, 10345, 11355, 12302, 23098, -18745, 13707, -28933, -17228, -9629, 22927, -19594, 2674, 14395,
+    13249, 20403, 9617, 8854, 18830, 9013, -5075, -31810, 27417, 9218, -2030, 2196, -8286, 5888, -8568, -14058,
+    -8559, -27832, -31224, 28339, -15079, -17695, -22939, -18071, 27318, -28596, -21082, 3917, -4408, 10728, -9682, 21764,
+    16801, -19723, 12373, -11488, 16895, 4519, 17584, -23859, -28557, -26934, 8683, 29122, -9748, 10755, -25412, 9848,
+    -16335, -18672, -13721, -21625, 24694, -1232, 23491, 6239, 4591, 17044, -299, 23655, -22942, -21260, -17300, 26612,
+    -17484, -17077, 30499, 27670, -22206, 16607, 22031, 27702, -8051, -12942, -7750, 11359, -22955, -13567, -6359, -10683,
+    26927, 13693, -27324, 5018, -431, 31871, -24646, -3511, -2549, -18261, -4039, 28026, -30915, -20830, -11373, 20111,
+    692, 16962, -16293, -25663, -24824, 17379, -20833, 5269, 19680, 7327, -12484, 11901, -8113, -190, 21752, -1376,
+    -30278, 10682, -19799, 20021, 19653, -23123, -5853, -19397, -5964, 9614, -9745, -13995, -18976, 9444, -12773, -27890,
+    29364, -9953, 6184, 9446, 3894, -5121, -28353, 3541, 31687, 23602, -30589, 2367, 27115, -16670, 29265, -9097,
+    3148, -12389, 28513, 3107, -4115, 2325, -30885, -21381, -26260, 31347, 23134, 13291, -16280, -21357, -413, 24464,
+    31256, 11722, 7535, 26078, -12364, -8437, 28745, 9508, -3720, -6108, 30676, 17868, -27438, 1277, -16287, 17020,
+    31173, -30315, -14356, 21193, 25366, -17032, 10034, 4005, 17313, 935, -20952, -21982, -17527, 640, -20022, -13340,
+    -6987, 9424, 10702, 31369, 27299, -25033, 7302, 3594, 9984, -26196, 6811, 11090, -9391, 29590, -4276, -2253,
+    17503, 11232, -30081, 26113, -11878, 29697, 27385, 26528, 31622, 25027, -20694, -23050, -18782, 28005, -10049, -31810,
+};
+static const int16_t rand512_fwd_out[1024] = {
+    -687, -90, -43, 447, -136, 1768, 24, 205, 1812, 422, 1355, -100, -313, 239, -1416, 114,
+    -954, 904, 141, -203, 1065, -991, -1886, -733, 1018, 122, 910, -817, -886, 1646, -601, 251,
+    -1372, -603, 329, 514, -561, 1239, -85, -231, -219, -306, -1136, -1016, -485, -234, -37, 590,
+    34, -661, -2278, -1000, -764, 952, -380, 1277, 1092, 728, -988, -657, -105, -138, 129, 633,
+    654, -460, 665, 335, 149, -787, -181, 307, 1708, -524, -892, -1248, 763, 495, -163, 1078,
+    -453, -1092, 1479, -572, 765, -1213, 1048, -303, -581, -931, -679, -407, 476, -286, -78, 49,
+    -584, -1864, -370, 707, 1526, 39, -1495, -465, 481, 996, 1241, 287, 489, -886, -110, -79,
+    -759, 159, -598, 211, 171, -1102, -1133, -75, -80, -1158, -604, -974, -559, -538, -1154, -183,
+    -875, -113, 475, -986, -126, 926, -34, 420, 25, 684, -1144, 389, 329, -259, -123, -1184,
+    434, 860, 576, -150, -309, 1257, 491, -352, 182, -2100, 1079, -694, 1669, 243, -7, 1899,
+    -987, -833, 446, -36, -1420, -1192, -1258, -258, -634, -524, 668, -1082, -24, 91, -416, -282,
+    -887, -432, 776, -1647, -445, 139, 121, 224, -486, 1825, 13, -1352, 446, -2, 515, 1415,
+    -1311, -1660, -379, -1, 1795, 1458, -1708, 561, 197, 693, 56, -151, -425, 705, 2, 423,
+    -113, -42, 200, -499, -593, 253, 1179, -505, 1615, -193, -157, 149, -460, -400, -577, -11,
+    -382, -758, -337, -228, 837, 53, 371, 196, -2379, 66, 600, 666, -7, -170, 714, 171,
+    -449, 324, -1147, 552, -1304, -435, 1171, -215, 324, 1476, 213, -868, 1090, -877, -401, -68,
+    1576, -925, 243, 2029, -566, 889, 682, 1020, -458, 646, 778, 91, -1129, -602, 646, 463,
+    -1072, 613, 708, 1453, -741, 1184, 734, 1181, 379, -500, -581, 632, 1016, 1109, 988, -192,
+    766, -76, 516, 710, -823, -299, -505, 399, 967, 520, 265, 1261, 1166, 567, 600, -357,
+    117, -86, 29, 1361, 1343, 885, -279, -1441, -85, -51, -711, -442, 100, 42, -1130, 909,
+    1221, -482, 129, -87, 560, -573, 429, 783, 118, -197, -1150, 367, -373, -244, 344, -1310,
+    -110, -379, -228, -1407, 491, -1317, -187, 313, 1114, -989, 894, -190, 158, -642, 58, 116,
+    -417, 2, -508, 764, -624, -2074, -1100, 104, -406, -826, -305, -118, 633, -201, -180, 546,
+    -90, -708, -419, -81, -278, -198, -515, 980, 1547, -1154, 1421, -1033, 183, 662, -382, -13,
+    -173, -525, -555, -454, -1225, 1971, 1138, 628, 2292, 685, 197, 165, 666, 1036, 823, 218,
+    -1343, 1361, -112, 1074, -563, 998, -803, -1266, 1340, 1179, -544, 605, -184, -1097, 597, 910,
+    882, 677, 609, -756, -1087, -1379, 551, -22, 972, 265, 526, -308, 727, 1783, 123, 807,
+    -477, -795, -524, -67, -1262, -424, 617, -1360, 410, 893, 894, -176, 565, -2, -789, 594,
+    756, -142, 212, -304, 1558, -469, 281, 1375, -911, -692, 1305, 806, -1114, -1331, -158, -692,
+    751, 403, 246, 707, 602, 57, -753, 921, 254, 1238, 675, 526, -225, -708, -651, 1447,
+    353, -658, 911, 57, -333, -41, 579, 146, -406, -720, -499, 158, 1351, 1116, 774, 499,
+    -365, 1930, 128, -514, -236, -1080, -889, -498, 315, -425, -585, 1211, -1695, 1276, 1227, -1115,
+    1278, 339, 1203, 306, 473, -781, 248, 442, 595, -97, -442, 966, 361, -159, 416, -43,
+    2575, 930, -419, -55, 1715, 240, -757, 712, -387, 701, -1041, -286, 76, 615, -717, -351,
+    -928, 631, 515, 788, -1136, -594, -125, -1131, -476, -732, 767, -338, 711, -90, -113, -460,
+    105, 123, -958, 811, -953, 1534, 1861, 27, -1631, -558, 360, 1817, -1910, -393, 666, 581,
+    -1420, 524, -1009, 74, 266, 1421, -590, -518, 995, -989, -894, 876, -430, 902, -887, -549,
+    -762, -1978, 371, 158, 955, 539, -1776, -591, -756, 265, -244, -367, 1070, -779, 746, 1041,
+    144, -914, 1248, 262, -168, 1059, -1068, 1699, 460, -46, -415, 1792, -746, 1089, -297, -1018,
+    408, 706, 185, -212, -134, 487, -909, 855, 238, 266, -1228, 563, 82, -875, -472, -686,
+    855, -1142, -583, -448, -337, -697, -1663, 1168, -2, 543, 1466, 481, 1449, -314, -423, -499,
+    -1408, 2355, 442, -708, -1231, -350, -1320, -613, 240, -854, -227, 939, 870, 28, 1223, -1635,
+    -1227, -869, -147, 647, 170, 965, -967, 1877, 797, 52, 1213, -540, 858, -97, -683, 593,
+    574, -552, -1412, 23, -1057, -651, -1038, 635, -426, 168, 10, -1215, 326, 199, 1015, 36,
+    -154, 570, -52, -14, -1131, 1952, 464, 1266, -1997, -389, 829, -173, 149, -607, 311, -927,
+    -267, -258, -1473, -192, 1367, 22, -494, -661, 260, 74, 1245, -215, -384, 1072, 793, -972,
+    865, -237, 649, -81, -125, 119, 278, 913, 509, 140, -1134, -1314, 103, -29, -744, -1185,
+    -405, -926, 971, -171, -1151, -432, -360, -274, 1453, -580, 550, 818, -626, 66, 718, -286,
+    841, 715, 424, -1136, -434, 1545, 283, -479, 1376, 357, -767, -1053, 374, -913, 1220, -1490,
+    491, 1001, 1302, -753, -521, -1351, -18, -897, 272, 48, -291, -1004, -701, 295, 352, -634,
+    -79, 895, 170, -248, -978, 419, 110, 1378, 1374, 134, 114, -840, 1048, 551, 1082, 248,
+    663, -715, 279, 319, 357, 1152, -448, -202, -634, 600, -302, 1262, -36, 132, -35, 508,
+    1944, 664, -696, 1890, -243, 16, 1005, 225, 412, 270, -1100, 1084, 1616, -521, -502, -405,
+    -1443, -1163, 1442, -84, -437, -302, 373, 707, -1379, 1098, -285, -1334, 497, 328, -603, -235,
+    -249, -655, -48, -611, 724, 223, -142, -70, -144, -1071, 1170, -1020, -244, -9, -839, 443,
+    440, 1870, 907, -1070, -1189, 131, 1395, 822, -465, -312, -1509, -776, 1130, -818, -884, 1141,
+    -547, 185, -444, 704, -813, 755, -188, -1293, 892, 1150, -1373, 435, -1384, -537, -1070, -25,
+    -1214, 126, -1253, -524, -113, -214, 40, -1490, 261, 419, -1073, 312, 154, -1871, 358, 47,
+    24, -612, 345, -327, -317, 660, -905, 1450, 1050, -1262, -275, -230, 452, -398, -1781, -253,
+    -152, 477, 1129, -997, 500, -430, 898, -604, 321, -1241, -2006, 432, 1229, 1248, -369, 2,
+    822, 490, 185, 499, -627, -1322, -1087, -1170, 326, 283, 729, -642, -414, -850, -56, -931,
+    -1425, 259, 66, -1018, -1003, 303, 633, 389, 821, 960, -409, -735, 416, 791, 441, 1237,
+    380, 466, -496, -421, 903, 413, -194, 133, 519, -50, -101, 184, -1505, -942, 149, 895,
+    1018, 1221, -1583, 171, -142, -812, 155, 1349, 804, -1031, 1589, 256, -235, -49, -693, 1545,
+};
+
+static const int16_t rand512_inv_in[1024] = {
+    6015, -2366, 3744, 31926, 27795, -10559, 8231, 26963, -30014, 27466, -31295, -15230, -3206, 7076, 6661, 18695,
+    -5124, 6065, -13912, -7628, -30960, -17775, -25506, -7760, 11359, 24045, 24543, -8999, 31899, -18212, 7718, -11956,
+    25002, 28492, 5713, -21652, 15573, 21294, 10101, 18994, -2122, 31195, -10392, 3953, -19225, -1939, -22649, 31263,
+    -4265, -20194, -30553, 12743, 360, -10011, -23368, -20761, 22066, 16514, 19766, 2304, -12363, -16841, 27369, -9646,
+    -1314, -4907, -10011, 6402, -10129, -18346, -30789, -12598, 29778, 26787, -28904, 28786, -13030, 12098, 28812, -6649,
+    14917, 10667, -30164, 1551, -17425, -18186, 250, -14170, -6425, -1834, -10066, 24065, -14330, 6404, 29214, -4943,
+    -3881, -5933, -10953, -13554, -9872, -20887, -23655, 16400, 20764, 21972, 13568, 13796, -9314, 29434, 7979, 11515,
+    2170, -7682, 26126, 19750, -18400, 22544, 22030, -1971, 25041, -17897, 21037, -20358, 6976, 13309, 9464, -1342,
+    -28733, -22073, -11367, 9366, 21029, -5525, -297, 16193, -28508, 3886, -7881, -7395, 29145, -28992, 18726, -23314,
+    3390, -22271, 20362, 28817, -26448, -13444, -2793, 616, 23100, -19937, 28804, -18418, -24600, 7489, -25775, -17006,
+    20340, 30300, 713, 21801, 7738, -18108, 3943, 23748, 19062, -5886, 4550, -3979, -9756, -8410, -26138, 3223,
+    4437, 12707, -20137, 846, -8014, -14787, 23390, -3638, -4980, 1097, -31378, -16569, 31559, -11704, -14415, 25328,
+    -3534, 8784, 8429, 7869, -31327, 23734, 14185, 30028, -18617, 12880, -3691, -3009, -2113, -14318, 25233, -1186,
+    23324, -27926, 22169, 19688, -19344, 21320, 2643, -22150, -6353, 26030, 18578, -9031, 11888, -12046, -3524, -21656,
+    23016, -15999, -24944, -18463, 15499, 1626, -3034, 6850, 22716, -22097, -28267, -16443, -28388, 26571, 23522, -24473,
+    116, -19182, 6854, 5717, -4202, 24941, 7586, 19657, 7314, -13092, 3453, 16113, -2220, -11667, -11044, -8890,
+    -10770, -25361, 182, 12156, -20593, -28499, -29673, 16980, -2918, -30644, 19580, 4945, -5995, -17677, -14505, 31903,
+    -28967, -26287, 30952, 8969, 3853, -9649, 6163, -5834, -20925, -29403, 25781, 30830, -14693, 22085, -27121, -2934,
+    -27312, -25686, -28474, -2029, 3701, -19449, 12775, -6055, 13997, 11001, 22535, -11478, 7288, -9348, 19716, -4192,
+    -14789, -10214, 15436, -763, 28693, 31089, 26776, 1665, -20529, 6232, 26790, -4682, -31545, -19358, -3820, -21012,
+    17792, -11290, -13924, 2707, 15208, 12180, 16226, 26222, -27450, -30951, -24105, 4750, 15592, 21191, 7868, -26414,
+    -13020, -3101, 8646, -16208, -4558, -13006, 3429, -22613, -12332, -6419, -12638, 3917, 21027, -1778, -11319, -2831,
+    -8813, -19472, -7052, 18797, -3130, -31904, 6013, 28279, 18372, -17741, 24702, -15679, -25134, -15741, -21515, 10819,
+    25778, 30028, 30095, 26615, -22481, 9169, 21448, -16670, -17677, -14088, -25871, 29105, -14405, 12776, 18098, -30768,
+    10530, 6448, 22531, -5756, -28847, -11683, -13975, -31605, 4759, 22886, -30354, 18931, -24071, 24010, 25037, -25397,
+    27003, 17168, -2483, 1347, -22224, -16028, -29383, 26532, -30238, -10964, 20418, 3407, 22650, 4084, -10730, -911,
+    -30376, 7214, 21340, -11192, -10227, 30022, -25483, 5612, 22591, 6771, 26126, -21403, -2586, -21764, 23067, -26630,
+    12204, -10755, 782, -15751, 19364, -10023, -6812, -24165, 1896, -11831, -1743, 30629, 6401, 20618, -28211, 3212,
+    22244, 17546, 17160, 26773, -3257, 23744, -13795, -29898, -20810, 21166, -25678, 31296, -3366, -17438, 12877, 10021,
+    -19964, -10751, 19024, -19710, 26679, 15108, 26914, 944, 11073, 22210, 11328, -8424, -16933, -30373, 369, 11407,
+    -29694, 20230, 8955, -11823, 2461, 19276, 14361, 10804, -7403, -22137, -28015, 13233, 21002, 13485, -9067, 17742,
+    -20792, 8239, 2553, 31919, -18448, -16498, 14963, 24599, -5547, -18538, -24852, 2332, -13502, 1149, 571, -16234,
+    -23165, -27020, 21908, -17463, -26376, 2623, 11575, 10462, -20616, -20707, -20256, 13800, -13487, 6099, -18495, 25146,
+    -10557, 12201, 860, -26666, 23069, -6399, 24969, -22743, -24451, -26274, 8709, 11029, -6592, -12955, 8984, 21897,
+    7867, 28626, -11619, 21219, 25224, 6096, -18051, -20092, 29709, -11756, 24744, 18438, -9874, 1328, -17064, -26780,
+    22611, -20812, 16700, 15451, -27305, 16061, 10929, 8326, -3410, -22560, 15973, 26985, 24518, 13777, 17046, 11786,
+    6537, -5078, -5042, 25065, 18637, -10736, -1002, 1692, -31744, -24906, 9969, 9773, 16614, 26879, 21369, 8474,
+    3684, -18771, 24008, 22658, -7800, 3842, 15491, 29204, 26338, -31646, 22465, 10611, -21914, -275, -778, 16753,
+    21089, 2737, -19649, -28373, 18587, 30957, -22166, -24599, -23655, -280, 6056, -23429, 11522, -21810, -22022, -30394,
+    -19350, 29465, 31893, -19946, 7643, 29165, -5471, 23007, 24092, 21994, 29366, -16495, 25516, -4039, -14038, -5413,
+    30774, 29869, 10638, -22924, -8957, 9262, -6149, 343, 24870, 19496, -22614, -22261, -8736, -24420, 28015, -26211,
+    -12449, -9083, 11686, -6551, 2518, 27508, -7436, -18108, 31867, 28150, -13356, -26595, 23752, 31385, 26565, -29682,
+    -25962, 2181, 21930, -23803, -31637, -14475, -9101, -7140, 2304, -617, 9906, 23277, -11930, -21084, 8434, 23711,
+    17624, -8276, -30102, 5175, -1474, -10391, 22396, 24778, -9970, -5704, 2973, 23143, 10694, 2632, 7447, -26461,
+    -14702, 3513, 31608, 15532, 12158, -5554, 1475, -12892, -20340, 11752, -7560, -16585, -14012, 18079, -31636, 15206,
+    4073, -12960, -5693, 5320, 10799, 25467, -6534, 23623, 22805, 26359, -29326, -19265, 22157, 3027, -20220, 19175,
+    -24886, 10724, 10324, -12900, -23488, 24844, -28692, -19811, 9528, -393, -9574, -518, -24066, -28547, -24224, 31720,
+    -14797, -20095, 15865, 12498, 28672, 26430, -24506, -22851, -30285, -9193, -4183, 20339, -322, -24276, -31185, -20518,
+    -22941, 12740, -27143, 22676, 9721, -25112, 16679, 23015, -19832, 13359, -28003, -28106, 19686, -29515, -28419, 31938,
+    31473, 31518, 9658, -25972, -29084, -25081, 25710, -24973, 56, -28394, -31875, 11205, -26432, -30294, 737, 14142,
+    -7142, 19508, -21879, 8651, 15416, -18944, -5670, -16465, -19712, -16993, -17921, -18695, -25343, 4079, 7719, -11941,
+    16347, -22951, 23084, 21944, 23644, -17104, -21064, 23782, 17651, 14222, -26841, 2817, 27099, -25355, -25329, -14694,
+    19243, 24858, 11433, 25081, 27618, -11964, 22419, 2373, -1737, -7950, 4115, -4540, -19643, 3152, 9066, -5427,
+    -8651, -7306, 10720, 14707, 18217, 15302, -23813, -26162, -19142, -2385, -20053, 13660, 12309, 30996, -17320, 14368,
+    21099, 7822, 1101, -11456, -18401, 13684, 14608, 28236, 4052, 30437, -1479, -2802, -19119, -23737, -16652, -23563,
+    -14891, 19666, -19775, 23675, -10662, -7479, -17836, 22572, 12667, -8616, 7451, -22504, -10942, -17053, -19191, -28719,
+    22320, 4272, 2799, -8624, 15973, 22346, 17979, -359, 22146, 22753, 10137, 30545, 28332, -26197, 31412, -19104,
+    -5597, -25894, 2620, -25364, -25902, 18199, -6155, 28212, 25641, -10514, -4765, -28817, -30973, -27481, -1001, -5804,
+    14949, -19763, -2719, -426, 15738, -3514, 21025, 27960, 3569, -7967, 14689, 8711, 16534, -4195, 25901, 13665,
+    19972, 31273, 1057, -30864, -25160, 13146, -22190, 21841, -4164, -15486, -13478, 31626, -20288, 18422, -31691, 24870,
+    -5003, 4676, -17430, 7660, 5239, -17215, -254, -13442, -17932, -4233, 27553, -11998, -25822, 11176, 14494, -25072,
+    -24338, 3438, -2137, -8664, -3708, -475, -29948, 6446, -17975, 3513, -26677, -25948, -17477, -10811, -6492, 17254,
+    -27286, 30613, -17085, 2866, -16980, -7680, -9393, -5388, -171, 17125, 30808, 30865, 824, 30652, -27151, -21980,
+    -532, -11146, 23680, -27986, -523, -9241, 29887, 20915, -12578, -28975, -12697, 30693, 27641, 5096, 16488, 2818,
+};
+static const int16_t rand512_inv_out[1024] = {
+    -514, 184, -157, 521, 83, 1686, -642, -913, -1131, 625, 268, 637, -395, 210, 784, 950,
+    472, 108, 1338, 2, 870, 841, -160, 934, -1026, -673, -206, -274, 190, -400, 243, 327,
+    770, 29, 1241, -681, -421, -519, 765, -898, -211, 295, -487, 358, 132, -1359, -1679, -1021,
+    716, -764, 9, 982, 341, -710, -176, -295, -888, -700, 161, -116, -1626, -256, -836, 1709,
+    -695, -171, -111, 53, 1508, 1124, 1071, -948, 236, -151, 1394, 1389, 643, 768, 70, 295,
+    -1147, -1090, 441, 917, -679, 200, 557, 248, -658, 532, 464, 895, 948, 376, -1425, 743,
+    144, -1288, -531, 429, 1167, -454, 232, 678, 2143, -633, -135, -279, 226, -108, 891, -808,
+    -923, -91, -674, 1298, -1055, 490, -737, 618, 827, 869, 1176, -2084, 317, -425, -1049, -1073,
+    -497, 147, 597, -848, 1555, -1060, -34, -14, 98, 1723, 2177, -187, 502, 983, -1320, -1535,
+    -431, -122, -471, -557, 247, -991, 1122, 709, -20, 518, 914, 259, 203, 495, 192, -1391,
+    800, 1398, -981, 1023, 1223, -804, -29, 1039, -1572, -1719, -189, -238, -820, 1429, 512, 1915,
+    740, -106, 1124, 943, -518, -13, -436, -367, -1861, -354, -855, 187, 718, 748, -691, 313,
+    -368, 480, 495, 465, -201, 1184, 414, -1146, -263, -407, -659, -153, 725, -924, 96, 108,
+    104, -1423, -1683, -52, -201, 97, 1168, -1109, 1599, -607, -742, 109, -498, -819, -158, -804,
+    -1928, -60, 52, 1250, 122, -625, 280, -895, 838, -1051, -1041, 426, 475, -863, -660, -1544,
+    1118, 98, -598, -248, -658, -736, 122, 705, -1125, 294, 660, 904, -147, -461, 138, 539,
+    -43, 463, 1672, 153, 221, 314, -889, -128, -553, -957, -60, 1113, -244, 468, -1546, 1214,
+    -64, 699, -80, -979, 286, -901, 718, 137, -968, -322, 212, 722, 296, -773, -1961, -90,
+    -980, -845, 879, -342, -8, -764, 257, -807, -1159, 1792, -698, 621, 1048, -1637, -1646, -333,
+    -284, 323, -883, -2058, 1086, 848, 1172, -593, -323, 164, 56, 1212, 167, -778, 718, -725,
+    -943, 847, -712, 233, 216, -1506, -1944, -639, -158, 1211, -827, 1423, -528, -249, 708, 1179,
+    -293, -1383, 157, -665, -471, 535, -1418, 841, -736, -973, -310, 347, -973, 425, -366, -621,
+    -435, 1039, -93, -36, -1554, -270, 1122, 1942, 29, -208, -11, -77, -657, 72, 171, 847,
+    -631, 962, 830, -1767, -487, 517, -800, 782, 279, -282, -615, 127, -628, 617, -739, -455,
+    -246, 996, -285, -1264, 707, -176, 90, -775, 1468, -96, 831, -40, -403, 1408, 144, 945,
+    -533, 1375, -221, -443, 579, 683, 68, 298, -599, 2694, -86, -838, -15, -150, 371, -639,
+    145, 320, -33, -561, 837, -364, 787, -2723, -802, -880, 61, 273, 968, -476, 449, -1331,
+    29, -112, 701, 881, -511, 1415, 2799, 686, -1190, -973, 363, 759, 519, 119, -1232, 242,
+    1383, 79, 1563, -40, 227, -940, -867, -1063, 918, 158, 21, 28, -1373, 600, 850, 30,
+    -137, -998, -437, -672, 716, 60, -523, -430, -327, -139, 86, -1867, -317, 631, 577, 795,
+    283, -405, -100, -1345, 778, -458, 576, 327, -211, -1526, 316, 850, 998, -649, -1668, -578,
+    -930, 46, 535, -1108, -368, -317, 1760, 585, -842, -1694, -42, 386, -185, 176, -6, 931,
+    -543, -850, 1335, -1332, -696, 618, -509, 1628, 739, -1127, -227, 1223, -120, 860, -450, 427,
+    140, 141, 1322, -835, -1635, 1271, 114, -1371, 100, -1906, 231, 1258, -720, -74, 36, -574,
+    -445, -1440, 112, -58, 499, -385, -1286, 404, -720, -588, 1369, -542, -1786, -1428, 742, 115,
+    457, 1035, 179, -16, 670, 254, 637, -559, 19, -237, 182, 817, 168, 177, 1054, -1250,
+    961, 399, -81, -135, -2013, 119, -740, -1484, -665, 122, -485, -615, -59, -922, -663, 1009,
+    -612, 643, 579, 158, -86, 1374, 740, -385, 471, -903, -108, 61, -274, 13, -836, 912,
+    27, -229, -49, -638, 1394, -124, 594, 855, 412, 59, -1454, -1052, 86, 514, 135, -629,
+    82, -552, -141, 378, 635, -1007, 443, 1043, 463, -1222, -1006, 831, -1092, 1167, 730, -675,
+    -256, 264, 701, 827, 183, 685, 726, -376, -759, 237, 674, -1555, 1460, -888, 1201, -703,
+    -751, 3, 488, 373, 175, -580, -438, -562, 1055, 1046, 821, 1224, -893, -835, -751, 1331,
+    1502, -1021, 58, -1144, -319, -639, 173, 1312, 483, -494, 654, -488, -421, -701, 819, 982,
+    448, -436, 1487, -1161, -1264, 689, -1688, -370, 1229, 741, 20, 252, 318, 147, 71, 1063,
+    473, 910, 377, 572, -987, -1017, 411, -593, -1445, 1154, 631, 800, -13, -900, 71, 933,
+    867, 963, -1571, 906, -540, 205, -365, 25, 141, 141, 1083, -1422, 1071, 690, -557, -232,
+    1157, 708, -374, -643, 1418, -1018, 647, 1611, -97, 408, 701, 468, -2005, 754, -234, 806,
+    274, -264, 291, -498, -521, -225, 608, 88, -1163, -460, 985, -549, -23, 256, -398, 452,
+    749, -224, 634, 1844, 117, 97, -1629, 489, -1352, 539, -13, 413, -596, 1944, -1991, -2689,
+    -830, 115, 884, 244, 84, -857, 208, -565, -797, -582, 626, 626, 243, 948, -556, -10,
+    -480, -370, -1009, 719, -374, -1938, 42, -203, -527, -1637, -834, 2484, 132, 550, -867, -455,
+    -1321, -100, -1549, -374, 455, 409, -1031, 202, 1089, 887, -24, 458, 195, 355, -1264, 189,
+    -1330, 160, -131, -226, 320, -156, 670, 307, 1068, 600, -82, 448, 189, -94, 1076, 293,
+    203, -526, 818, 46, 686, -668, 1147, -143, 1676, -1047, 1, -383, -1024, -521, 22, -834,
+    1293, -1125, 433, 197, -601, -140, 858, -512, -209, 1222, 107, -440, 532, -1601, 443, -417,
+    630, 30, -472, -857, 379, -1079, 305, 390, -720, -75, -370, -63, 28, 745, 27, 415,
+    1106, -777, -315, -400, -1388, 112, -514, -85, -946, -778, 2011, 598, -28, -2, 172, 643,
+    -285, -256, 550, -63, 828, 293, -661, 95, -1091, -473, -246, -186, 421, 402, -252, 659,
+    885, -253, -1516, 1083, -1288, 192, 227, -179, 748, -616, -1228, 414, 776, -544, -174, 659,
+    337, -831, 394, 150, 732, -1397, 390, 600, 43, -108, 355, -907, 2420, -148, 1220, -892,
+    -72, 724, 1234, -796, 242, 541, -655, 792, 159, 1008, -173, 2215, 2044, 1833, -34, 2006,
+    254, 36, 846, 197, -927, -386, 613, 38, -296, -188, 159, 615, -814, 95, 452, 498,
+    -323, 823, -863, -841, -109, 135, 488, 1210, 12, 634, 1579, 914, 680, -540, 1927, -1002,
+    -1276, -1374, 357, 354, 726, 290, 549, -446, -1657, -456, 91, 900, 544, 303, -837, -80,
+};
+
+typedef struct _ufft_vector_t {
+    const char *name;
+    int points;
+    int shift;
+    bool inverse;
+    const int16_t *in;
+    const int16_t *out;
+} ufft_vector_t;
+
+static const ufft_vector_t ufft_vectors[] = {
+    { "rand64_fwd", 64, 0x1FF, false, rand64_fwd_in, rand64_fwd_out },
+    { "rand64_inv", 64, 0x1FF, true, rand64_inv_in, rand64_inv_out },
+    { "rand64_noshift", 64, 0x000, false, rand64_noshift_in, rand64_noshift_out },
+    { "rand128_half", 128, 0x0F0, false, rand128_half_in, rand128_half_out },
+    { "rand256_fwd", 256, 0x1FF, false, rand256_fwd_in, rand256_fwd_out },
+    { "rand512_fwd", 512, 0x1FF, false, rand512_fwd_in, rand512_fwd_out },
+    { "rand512_inv", 512, 0x1FF, true, rand512_inv_in, rand512_inv_out },
+};
+
+#endif
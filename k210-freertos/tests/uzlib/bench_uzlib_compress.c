@@ -0,0 +1,93 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host benchmark of the uzlib compressor (tdeflate.c)
+ * Ratio and speed of the zlib format written in 512 byte pieces, as by uzlib.CompressIO,
+ * against zlib with the same window and with its default 32 KB window;
+ * the time is the best of 'BENCH_RUNS' runs.
+ */
+#include <time.h>
+#include "uzlib_reference.h"
+
+#define BENCH_RUNS  3
+#define BENCH_CHUNK 512
+
+static double now_us(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+static ref_data_t sets[REF_N_DATA];
+static ref_comp_t rc;
+
+// Returns the speed in MB/s, the compressed size is in rc.out_len
+static double bench(void *mem, const ref_data_t *set, int wbits, int level, int sync)
+{
+    double best = 1e30;
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        double t0 = now_us();
+        ref_compress(&rc, mem, set->data, set->len, wbits, level, TINF_CHKSUM_ADLER, BENCH_CHUNK, sync);
+        double t = now_us() - t0;
+        if (t < best) best = t;
+    }
+    return set->len / best;
+}
+
+int main(void)
+{
+    static const int params[][2] = { { 12, 6 }, { 10, 6 }, { 12, 1 } };
+
+    if (!ref_data_init(sets)) {
+        printf("uzlib_compress: test data not found\n");
+        return 1;
+    }
+    void *mem = malloc(UZLIB_COMP_MEM_SIZE(15));
+    size_t zout_size = 2 * sets[0].len;
+    unsigned char *zout = malloc(zout_size);
+
+    printf("uzlib compressor, zlib format, %d byte writes, compressed size and MB/s\n", BENCH_CHUNK);
+    printf("%-14s %9s |", "data", "size");
+    for (unsigned p = 0; p < TINF_ARRAY_SIZE(params); p++) printf("  w%d l%d %12s|", params[p][0], params[p][1], "");
+    printf(" zlib w12 l6 / w15 l6\n");
+    for (int s = 0; s < REF_N_DATA; s++) {
+        printf("%-14s %9zu |", sets[s].name, sets[s].len);
+        for (unsigned p = 0; p < TINF_ARRAY_SIZE(params); p++) {
+            double mbs = bench(mem, &sets[s], params[p][0], params[p][1], 0);
+            printf(" %6.1f%% %6.1f MB/s |", rc.out_len * 100.0 / sets[s].len, mbs);
+        }
+        size_t z12 = ref_zlib_size(sets[s].data, sets[s].len, 12, 6, zout, zout_size);
+        size_t z15 = ref_zlib_size(sets[s].data, sets[s].len, 15, 6, zout, zout_size);
+        printf(" %6.1f%% / %.1f%%\n", z12 * 100.0 / sets[s].len, z15 * 100.0 / sets[s].len);
+    }
+
+    // Sync flush after each write, as for a log sent line by line
+    double mbs = bench(mem, &sets[0], 12, 6, 1);
+    printf("%s, sync flush after every %d bytes, w12 l6: %.1f%%, %.1f MB/s\n", sets[0].name, BENCH_CHUNK, rc.out_len * 100.0 / sets[0].len, mbs);
+    return 0;
+}
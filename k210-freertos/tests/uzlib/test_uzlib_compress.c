@@ -0,0 +1,208 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host tests of the uzlib compressor (tdeflate.c)
+ * All formats, window sizes, levels and write sizes must decode with zlib and with
+ * the uzlib decompressor to the original data, sync flushes must make all the data
+ * written so far decodable, the ratio must be close to zlib's with the same window
+ * and the compressor must stay in its memory.
+ */
+#include "uzlib_reference.h"
+
+static int failed = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failed++; \
+        return; \
+    } } while (0)
+
+// Length of the data sets used for the parameters sweep
+#define SWEEP_LEN   (256 * 1024)
+
+static const char *ref_formats[3] = { "deflate", "zlib", "gzip" };
+static ref_data_t sets[REF_N_DATA];
+static ref_comp_t rc;
+static unsigned char *mem;
+static unsigned char *dec;
+static size_t dec_size;
+
+// Decode with the uzlib decompressor, returns the decompressed length, -1 on error
+static long tinf_decode(const unsigned char *in, size_t in_len, int format)
+{
+    TINF_DATA d;
+    memset(&d, 0, sizeof(d));
+    uzlib_uncompress_init(&d, NULL, 0);
+    d.source = in;
+    d.source_limit = in + in_len;
+    d.dest_start = d.dest = dec;
+    d.dest_limit = dec + dec_size;
+    int res = TINF_OK;
+    if (format == TINF_CHKSUM_ADLER) res = uzlib_zlib_parse_header(&d);
+    else if (format == TINF_CHKSUM_CRC) res = uzlib_gzip_parse_header(&d);
+    if (res < 0) return -1;
+    do {
+        res = uzlib_uncompress_chksum(&d);
+    } while (res == TINF_OK);
+    return (res == TINF_DONE) ? (d.dest - dec) : -1;
+}
+
+// All formats, window sizes 9..15, levels 1..9 and write sizes from 1 byte to 64 KB
+static void test_roundtrip(void)
+{
+    static const struct {
+        int wbits, level;
+        size_t chunk, len;
+        int sync;
+    } params[] = {
+        { 9, 1, 1, 16384, 0 }, { 10, 4, 100, SWEEP_LEN, 1 }, { 11, 2, 4096, SWEEP_LEN, 0 },
+        { 12, 6, 777, SWEEP_LEN, 3 }, { 12, 6, 512, SWEEP_LEN, 0 }, { 13, 3, 3, 16384, 0 },
+        { 14, 7, 65536, SWEEP_LEN, 0 }, { 15, 8, 1500, SWEEP_LEN, 0 }, { 15, 9, 65536, SWEEP_LEN, 0 },
+        { 12, 5, 2047, SWEEP_LEN, 2 },
+    };
+
+    for (int s = 0; s < REF_N_DATA; s++) {
+        for (int format = TINF_CHKSUM_NONE; format <= TINF_CHKSUM_CRC; format++) {
+            for (unsigned p = 0; p < TINF_ARRAY_SIZE(params); p++) {
+                size_t len = (sets[s].len < params[p].len) ? sets[s].len : params[p].len;
+                ref_compress(&rc, mem, sets[s].data, len, params[p].wbits, params[p].level, format, params[p].chunk, params[p].sync);
+                long n = ref_inflate(rc.out, rc.out_len, dec, dec_size, params[p].wbits, format, true);
+                CHECK((n == (long)len) && (memcmp(dec, sets[s].data, len) == 0), "%s, %s, wbits %d, level %d, writes of %zu: zlib decode %s",
+                      sets[s].name, ref_formats[format], params[p].wbits, params[p].level, params[p].chunk, (n < 0) ? "error" : "different");
+                n = tinf_decode(rc.out, rc.out_len, format);
+                CHECK((n == (long)len) && (memcmp(dec, sets[s].data, len) == 0), "%s, %s, wbits %d, level %d, writes of %zu: uzlib decode %s",
+                      sets[s].name, ref_formats[format], params[p].wbits, params[p].level, params[p].chunk, (n < 0) ? "error" : "different");
+            }
+        }
+    }
+}
+
+// Empty and 1 byte streams
+static void test_short(void)
+{
+    for (int format = TINF_CHKSUM_NONE; format <= TINF_CHKSUM_CRC; format++) {
+        for (size_t len = 0; len < 3; len++) {
+            ref_compress(&rc, mem, (const unsigned char *)"ab", len, 12, 6, format, 1, 0);
+            long n = ref_inflate(rc.out, rc.out_len, dec, dec_size, 12, format, true);
+            CHECK((n == (long)len) && (memcmp(dec, "ab", len) == 0), "%s, %zu bytes", ref_formats[format], len);
+        }
+    }
+}
+
+// After each sync flush the output decodes to all the data written so far
+static void test_sync_flush(void)
+{
+    const size_t len = 64 * 1024, chunk = 512;
+
+    for (int format = TINF_CHKSUM_NONE; format <= TINF_CHKSUM_CRC; format++) {
+        rc.out_len = 0;
+        uzlib_compress_init(&rc.comp, mem, 12, 6, format);
+        rc.comp.dest_write_cb = ref_comp_write;
+        for (size_t i = 0; i < len; i += chunk) {
+            uzlib_compress_write(&rc.comp, sets[0].data + i, chunk);
+            uzlib_compress_flush(&rc.comp, UZLIB_FLUSH_SYNC);
+            CHECK((rc.out_len >= 4) && (memcmp(rc.out + rc.out_len - 4, "\x00\x00\xff\xff", 4) == 0),
+                  "%s, no empty stored block at %zu", ref_formats[format], i + chunk);
+            long n = ref_inflate(rc.out, rc.out_len, dec, dec_size, 12, format, false);
+            CHECK((n == (long)(i + chunk)) && (memcmp(dec, sets[0].data, i + chunk) == 0),
+                  "%s, %ld of %zu bytes decoded", ref_formats[format], n, i + chunk);
+        }
+        // flush without new data only adds an empty block
+        size_t out_len = rc.out_len;
+        uzlib_compress_flush(&rc.comp, UZLIB_FLUSH_SYNC);
+        CHECK(rc.out_len - out_len <= 5, "%s, %zu bytes added by an empty flush", ref_formats[format], rc.out_len - out_len);
+        uzlib_compress_flush(&rc.comp, UZLIB_FLUSH_FINISH);
+        long n = ref_inflate(rc.out, rc.out_len, dec, dec_size, 12, format, true);
+        CHECK((n == (long)len) && (memcmp(dec, sets[0].data, len) == 0), "%s, finished stream", ref_formats[format]);
+    }
+}
+
+// Ratio close to zlib with the same window and level, incompressible data expands little
+// A block holds up to 2^wbits symbols (16K in zlib), the smaller windows are not compared
+static void test_ratio(void)
+{
+    static const int params[][2] = { { 12, 6 }, { 13, 4 }, { 15, 9 }, { 12, 1 } };
+    static unsigned char zout[2 * SWEEP_LEN];
+
+    for (int s = 0; s < REF_N_DATA; s++) {
+        size_t len = (sets[s].len < SWEEP_LEN) ? sets[s].len : SWEEP_LEN;
+        for (unsigned p = 0; p < TINF_ARRAY_SIZE(params); p++) {
+            ref_compress(&rc, mem, sets[s].data, len, params[p][0], params[p][1], TINF_CHKSUM_ADLER, 512, 0);
+            size_t zsize = ref_zlib_size(sets[s].data, len, params[p][0], params[p][1], zout, sizeof(zout));
+            CHECK(rc.out_len <= zsize + zsize / 25 + 16, "%s, wbits %d, level %d: %zu bytes, zlib %zu",
+                  sets[s].name, params[p][0], params[p][1], rc.out_len, zsize);
+        }
+    }
+    ref_compress(&rc, mem, sets[4].data, sets[4].len, 12, 6, TINF_CHKSUM_ADLER, 512, 0);
+    CHECK(rc.out_len <= sets[4].len + sets[4].len / 50, "random data expanded to %zu bytes", rc.out_len);
+}
+
+// The compressor uses only UZLIB_COMP_MEM_SIZE(wbits) bytes of memory
+static void test_memory(void)
+{
+    const size_t guard = 1024;
+
+    for (int wbits = 9; wbits <= 15; wbits++) {
+        size_t size = UZLIB_COMP_MEM_SIZE(wbits);
+        unsigned char *buf = malloc(size + 2 * guard);
+        memset(buf, 0xa5, size + 2 * guard);
+        ref_compress(&rc, buf + guard, sets[1].data, SWEEP_LEN, wbits, 9, TINF_CHKSUM_CRC, 4096, 7);
+        bool ok = true;
+        for (size_t i = 0; i < guard; i++) {
+            if ((buf[i] != 0xa5) || (buf[guard + size + i] != 0xa5)) ok = false;
+        }
+        free(buf);
+        CHECK(ok, "wbits %d, memory outside of the %zu bytes buffer written", wbits, size);
+    }
+}
+
+int main(void)
+{
+    if (!ref_data_init(sets)) {
+        printf("uzlib_compress: test data not found\n");
+        return 1;
+    }
+    mem = malloc(UZLIB_COMP_MEM_SIZE(15));
+    dec_size = 4 * 1024 * 1024;
+    dec = malloc(dec_size);
+
+    test_roundtrip();
+    test_short();
+    test_sync_flush();
+    test_ratio();
+    test_memory();
+
+    if (failed) {
+        printf("uzlib_compress: %d test(s) failed\n", failed);
+        return 1;
+    }
+    printf("uzlib_compress: OK\n");
+    return 0;
+}
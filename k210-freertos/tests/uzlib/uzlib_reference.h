@@ -0,0 +1,206 @@
+/*
+ * This file is part of the MicroPython K210 project, https://github.com/loboris/MicroPython_K210_LoBo
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Test data and reference for the host tests of the uzlib compressor (tdeflate.c)
+ *
+ * The compressed streams are decoded with the system zlib, an implementation independent
+ * from uzlib, using the same window size: a match distance beyond the window, a wrong
+ * header or checksum is reported as an error.
+ * The data sets model what the firmware compresses: a sensor log, JSON records,
+ * C source, a firmware binary and incompressible data.
+ */
+
+#ifndef _UZLIB_REFERENCE_H_
+#define _UZLIB_REFERENCE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <zlib.h>
+#include "uzlib.h"
+
+#define REF_N_DATA  5
+
+typedef struct {
+    const char *name;
+    unsigned char *data;
+    size_t len;
+} ref_data_t;
+
+static inline uint32_t ref_rand(uint32_t *seed)
+{
+    *seed = *seed * 1664525 + 1013904223;
+    return *seed >> 8;
+}
+
+// Read a file of the tree, NULL if not found
+static inline unsigned char *ref_read_file(const char *fname, size_t *len)
+{
+    FILE *f = fopen(fname, "rb");
+    if (f == NULL) return NULL;
+    fseek(f, 0, SEEK_END);
+    *len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char *data = malloc(*len + 1);
+    if (fread(data, 1, *len, f) != *len) *len = 0;
+    fclose(f);
+    return data;
+}
+
+// Sensor log lines of about 'size' bytes
+static inline unsigned char *ref_sensor_log(size_t size, size_t *len)
+{
+    char *data = malloc(size + 128);
+    uint32_t seed = 1, t = 1560000000;
+    *len = 0;
+    while (*len < size) {
+        t += 1 + ref_rand(&seed) % 3;
+        int r = ref_rand(&seed);
+        if ((r % 50) == 0) {
+            *len += sprintf(data + *len, "%u W [WIFI] reconnecting, rssi=%d\n", t, -80 - (r >> 8) % 10);
+        }
+        else {
+            *len += sprintf(data + *len, "%u I [SENSOR] temp=%d.%02d hum=%d.%d press=%d.%02d batt=%d rssi=%d\n", t,
+                            20 + (r >> 4) % 5, (r >> 7) % 100, 42 + (r >> 9) % 7, (r >> 12) % 10,
+                            1013 + (r >> 13) % 4, (r >> 15) % 100, 3700 + (r >> 5) % 150, -60 - (r >> 11) % 20);
+        }
+    }
+    return (unsigned char *)data;
+}
+
+// JSON array of records of about 'size' bytes
+static inline unsigned char *ref_json_records(size_t size, size_t *len)
+{
+    char *data = malloc(size + 128);
+    uint32_t seed = 2;
+    *len = sprintf(data, "[");
+    for (int i = 0; *len < size; i++) {
+        int r = ref_rand(&seed);
+        *len += sprintf(data + *len, "%s{\"id\": %d, \"ts\": %d, \"temp\": %d.%d, \"hum\": %d.%d, \"ok\": %s}",
+                        (i) ? ", " : "", i, 1560000000 + i * 10, 20 + r % 5, (r >> 4) % 100,
+                        42 + (r >> 11) % 7, (r >> 14) % 10, ((r >> 17) % 20) ? "true" : "false");
+    }
+    *len += sprintf(data + *len, "]");
+    return (unsigned char *)data;
+}
+
+// Initialize the data sets, returns false if a file of the tree is missing
+static inline bool ref_data_init(ref_data_t *sets)
+{
+    uint32_t seed = 3;
+    sets[0].name = "sensor log";
+    sets[0].data = ref_sensor_log(1600000, &sets[0].len);
+    sets[1].name = "JSON records";
+    sets[1].data = ref_json_records(350000, &sets[1].len);
+    sets[2].name = "C source";
+    sets[2].data = ref_read_file("../mpy_support/standard_lib/display/tft.c", &sets[2].len);
+    sets[3].name = "firmware bin";
+    sets[3].data = ref_read_file("../../firmware/MaixPy.bin", &sets[3].len);
+    sets[4].name = "random";
+    sets[4].len = 200000;
+    sets[4].data = malloc(sets[4].len);
+    for (size_t i = 0; i < sets[4].len; i++) sets[4].data[i] = ref_rand(&seed);
+    return (sets[2].data != NULL) && (sets[3].data != NULL);
+}
+
+//------------------------------------------------------------------------
+// Compressed output collected in a growing buffer
+
+typedef struct {
+    struct uzlib_comp comp;
+    unsigned char *out;
+    size_t out_len;
+    size_t out_size;
+} ref_comp_t;
+
+static void ref_comp_write(struct uzlib_comp *comp, const unsigned char *data, unsigned int len)
+{
+    ref_comp_t *rc = (ref_comp_t *)comp;
+    if ((rc->out_len + len) > rc->out_size) {
+        rc->out_size = (rc->out_len + len) * 2;
+        rc->out = realloc(rc->out, rc->out_size);
+    }
+    memcpy(rc->out + rc->out_len, data, len);
+    rc->out_len += len;
+}
+
+// Compress 'data' writing 'chunk' bytes at a time, sync flush after every 'sync' writes (if not 0)
+// 'mem' must hold UZLIB_COMP_MEM_SIZE(wbits) bytes
+static inline void ref_compress(ref_comp_t *rc, void *mem, const unsigned char *data, size_t len,
+                                int wbits, int level, int format, size_t chunk, int sync)
+{
+    rc->out_len = 0;
+    uzlib_compress_init(&rc->comp, mem, wbits, level, format);
+    rc->comp.dest_write_cb = ref_comp_write;
+    int writes = 0;
+    for (size_t i = 0; i < len; i += chunk) {
+        uzlib_compress_write(&rc->comp, data + i, ((len - i) < chunk) ? (len - i) : chunk);
+        if ((sync) && ((++writes % sync) == 0)) uzlib_compress_flush(&rc->comp, UZLIB_FLUSH_SYNC);
+    }
+    uzlib_compress_flush(&rc->comp, UZLIB_FLUSH_FINISH);
+}
+
+// Decode with zlib, returns the decompressed length, -1 on error
+// 'finished' requires the end of the stream and its checksum, otherwise all data
+// up to the last sync flush must be available
+static inline long ref_inflate(const unsigned char *in, size_t in_len, unsigned char *out, size_t out_size,
+                               int wbits, int format, bool finished)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    int window = (format == TINF_CHKSUM_NONE) ? -wbits : (format == TINF_CHKSUM_ADLER) ? wbits : 16 + wbits;
+    if (inflateInit2(&zs, window) != Z_OK) return -1;
+    zs.next_in = (unsigned char *)in;
+    zs.avail_in = in_len;
+    zs.next_out = out;
+    zs.avail_out = out_size;
+    int res = inflate(&zs, (finished) ? Z_FINISH : Z_SYNC_FLUSH);
+    long len = zs.total_out;
+    inflateEnd(&zs);
+    if (finished) return ((res == Z_STREAM_END) && (zs.avail_in == 0)) ? len : -1;
+    return ((res == Z_OK) || (res == Z_BUF_ERROR)) && (zs.avail_in == 0) ? len : -1;
+}
+
+// Compressed size with zlib, level and window as uzlib
+static inline size_t ref_zlib_size(const unsigned char *data, size_t len, int wbits, int level, unsigned char *out, size_t out_size)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    deflateInit2(&zs, level, Z_DEFLATED, wbits, 8, Z_DEFAULT_STRATEGY);
+    zs.next_in = (unsigned char *)data;
+    zs.avail_in = len;
+    zs.next_out = out;
+    zs.avail_out = out_size;
+    deflate(&zs, Z_FINISH);
+    size_t size = zs.total_out;
+    deflateEnd(&zs);
+    return size;
+}
+
+#endif
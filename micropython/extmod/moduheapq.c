@@ -26,6 +26,7 @@
 
 #include "py/objlist.h"
 #include "py/runtime.h"
+#include "py/gc.h"
 
 #if MICROPY_PY_UHEAPQ
 
@@ -40,10 +41,13 @@ STATIC mp_obj_list_t *get_heap(mp_obj_t heap_in) {
 
 STATIC void heap_siftdown(mp_obj_list_t *heap, mp_uint_t start_pos, mp_uint_t pos) {
     mp_obj_t item = heap->items[pos];
+    // the slot of the item is overwritten while the comparisons run
+    GC_WRITE_BARRIER(item);
     while (pos > start_pos) {
         mp_uint_t parent_pos = (pos - 1) >> 1;
         mp_obj_t parent = heap->items[parent_pos];
         if (mp_binary_op(MP_BINARY_OP_LESS, item, parent) == mp_const_true) {
+            GC_WRITE_BARRIER(parent);
             heap->items[pos] = parent;
             pos = parent_pos;
         } else {
@@ -57,12 +61,14 @@ STATIC void heap_siftup(mp_obj_list_t *heap, mp_uint_t pos) {
     mp_uint_t start_pos = pos;
     mp_uint_t end_pos = heap->len;
     mp_obj_t item = heap->items[pos];
+    GC_WRITE_BARRIER(item);
     for (mp_uint_t child_pos = 2 * pos + 1; child_pos < end_pos; child_pos = 2 * pos + 1) {
         // choose right child if it's <= left child
         if (child_pos + 1 < end_pos && mp_binary_op(MP_BINARY_OP_LESS, heap->items[child_pos], heap->items[child_pos + 1]) == mp_const_false) {
             child_pos += 1;
         }
         // bubble up the smaller child
+        GC_WRITE_BARRIER(heap->items[child_pos]);
         heap->items[pos] = heap->items[child_pos];
         pos = child_pos;
     }
@@ -84,6 +90,7 @@ STATIC mp_obj_t mod_uheapq_heappop(mp_obj_t heap_in) {
         nlr_raise(mp_obj_new_exception_msg(&mp_type_IndexError, "empty heap"));
     }
     mp_obj_t item = heap->items[0];
+    GC_WRITE_BARRIER(item);
     heap->len -= 1;
     heap->items[0] = heap->items[heap->len];
     heap->items[heap->len] = MP_OBJ_NULL; // so we don't retain a pointer
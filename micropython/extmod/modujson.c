@@ -25,19 +25,60 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 
 #include "py/objlist.h"
-#include "py/objstringio.h"
+#include "py/objstr.h"
 #include "py/parsenum.h"
 #include "py/runtime.h"
 #include "py/stream.h"
 
 #if MICROPY_PY_UJSON
 
+// Stream input is read, and stream output written, in chunks of this size
+#define UJSON_BUF_SIZE (128)
+
+// Maximum nesting of the incremental Parser and Writer
+#define UJSON_MAX_DEPTH (64)
+
+// Output is collected in a small buffer so that the encoder, which emits
+// mostly single characters and short tokens, writes the stream in chunks.
+
+typedef struct _ujson_out_t {
+    mp_obj_t stream_obj;
+    size_t len;
+    byte buf[UJSON_BUF_SIZE];
+} ujson_out_t;
+
+STATIC void ujson_out_flush(ujson_out_t *out) {
+    if (out->len != 0) {
+        size_t len = out->len;
+        out->len = 0;
+        mp_stream_write(out->stream_obj, out->buf, len, MP_STREAM_RW_WRITE);
+    }
+}
+
+STATIC void ujson_out_strn(void *data, const char *str, size_t len) {
+    ujson_out_t *out = data;
+    if (out->len + len > sizeof(out->buf)) {
+        ujson_out_flush(out);
+        if (len > sizeof(out->buf)) {
+            mp_stream_write(out->stream_obj, str, len, MP_STREAM_RW_WRITE);
+            return;
+        }
+    }
+    memcpy(out->buf + out->len, str, len);
+    out->len += len;
+}
+
 STATIC mp_obj_t mod_ujson_dump(mp_obj_t obj, mp_obj_t stream) {
     mp_get_stream_raise(stream, MP_STREAM_OP_WRITE);
-    mp_print_t print = {MP_OBJ_TO_PTR(stream), mp_stream_write_adaptor};
+    ujson_out_t out;
+    out.stream_obj = stream;
+    out.len = 0;
+    mp_print_t print = {&out, ujson_out_strn};
     mp_obj_print_helper(&print, obj, PRINT_JSON);
+    ujson_out_flush(&out);
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_ujson_dump_obj, mod_ujson_dump);
@@ -51,7 +92,7 @@ STATIC mp_obj_t mod_ujson_dumps(mp_obj_t obj) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_ujson_dumps_obj, mod_ujson_dumps);
 
-// The function below implements a simple non-recursive JSON parser.
+// The functions below implement a simple non-recursive JSON parser.
 //
 // The JSON specification is at http://www.ietf.org/rfc/rfc4627.txt
 // The parser here will parse any valid JSON and return the correct
@@ -61,144 +102,249 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_ujson_dumps_obj, mod_ujson_dumps);
 // input is outside it's specs.
 //
 // Most of the work is parsing the primitives (null, false, true, numbers,
-// strings).  It does 1 pass over the input stream.  It tries to be fast and
-// small in code size, while not using more RAM than necessary.
+// strings).  It does 1 pass over the input, which is either a buffer or a
+// stream read in chunks.  It tries to be fast and small in code size, while
+// not using more RAM than necessary: the tokenizer only touches the heap
+// for the text of strings and numbers, and not at all when a value is
+// being skipped.
 
 typedef struct _ujson_stream_t {
-    mp_obj_t stream_obj;
+    mp_obj_t stream_obj; // MP_OBJ_NULL if parsing from a buffer
     mp_uint_t (*read)(mp_obj_t obj, void *buf, mp_uint_t size, int *errcode);
-    int errcode;
-    byte cur;
+    const byte *pos;
+    const byte *end;
+    byte buf[UJSON_BUF_SIZE];
 } ujson_stream_t;
 
 #define S_EOF (0) // null is not allowed in json stream so is ok as EOF marker
-#define S_END(s) ((s).cur == S_EOF)
-#define S_CUR(s) ((s).cur)
-#define S_NEXT(s) (ujson_stream_next(&(s)))
+#define S_PEEK(s) ((s)->pos < (s)->end ? *(s)->pos : ujson_stream_fill(s))
+#define S_SKIP(s) ((s)->pos++)
 
-STATIC byte ujson_stream_next(ujson_stream_t *s) {
-    mp_uint_t ret = s->read(s->stream_obj, &s->cur, 1, &s->errcode);
-    if (s->errcode != 0) {
-        mp_raise_OSError(s->errcode);
+// Tokens returned by ujson_token; the text of strings and numbers is left in
+// the vstr.  Brackets and braces are returned as themselves.
+#define T_EOF (S_EOF)
+#define T_STR ('"')
+#define T_INT ('0')
+#define T_FLOAT ('.')
+#define T_NULL ('n')
+#define T_TRUE ('t')
+#define T_FALSE ('f')
+
+STATIC byte ujson_stream_fill(ujson_stream_t *s) {
+    if (s->stream_obj == MP_OBJ_NULL) {
+        return S_EOF;
+    }
+    int errcode;
+    mp_uint_t ret = s->read(s->stream_obj, s->buf, sizeof(s->buf), &errcode);
+    if (ret == MP_STREAM_ERROR) {
+        mp_raise_OSError(errcode);
     }
     if (ret == 0) {
-        s->cur = S_EOF;
+        return S_EOF;
     }
-    return s->cur;
+    s->pos = s->buf;
+    s->end = s->buf + ret;
+    return *s->pos;
 }
 
-STATIC mp_obj_t mod_ujson_load(mp_obj_t stream_obj) {
-    const mp_stream_p_t *stream_p = mp_get_stream_raise(stream_obj, MP_STREAM_OP_READ);
-    ujson_stream_t s = {stream_obj, stream_p->read, 0, 0};
-    vstr_t vstr;
-    vstr_init(&vstr, 8);
-    mp_obj_list_t stack; // we use a list as a simple stack for nested JSON
-    stack.len = 0;
-    stack.items = NULL;
-    mp_obj_t stack_top = MP_OBJ_NULL;
-    mp_obj_type_t *stack_top_type = NULL;
-    mp_obj_t stack_key = MP_OBJ_NULL;
-    S_NEXT(s);
-    for (;;) {
-        cont:
-        if (S_END(s)) {
-            break;
+STATIC byte ujson_stream_get(ujson_stream_t *s) {
+    byte c = S_PEEK(s);
+    if (c != S_EOF) {
+        S_SKIP(s);
+    }
+    return c;
+}
+
+STATIC NORETURN void ujson_fail(void) {
+    mp_raise_ValueError("syntax error in JSON");
+}
+
+STATIC void ujson_expect(ujson_stream_t *s, const char *rest) {
+    for (; *rest; rest++) {
+        if (ujson_stream_get(s) != (byte)*rest) {
+            ujson_fail();
         }
-        mp_obj_t next = MP_OBJ_NULL;
-        bool enter = false;
-        byte cur = S_CUR(s);
-        S_NEXT(s);
-        switch (cur) {
-            case ',':
-            case ':':
-            case ' ':
-            case '\t':
-            case '\n':
-            case '\r':
-                goto cont;
-            case 'n':
-                if (S_CUR(s) == 'u' && S_NEXT(s) == 'l' && S_NEXT(s) == 'l') {
-                    S_NEXT(s);
-                    next = mp_const_none;
-                } else {
-                    goto fail;
-                }
-                break;
-            case 'f':
-                if (S_CUR(s) == 'a' && S_NEXT(s) == 'l' && S_NEXT(s) == 's' && S_NEXT(s) == 'e') {
-                    S_NEXT(s);
-                    next = mp_const_false;
-                } else {
-                    goto fail;
+    }
+}
+
+// Read the next token; if vstr is NULL the text of strings and numbers is dropped
+STATIC byte ujson_token(ujson_stream_t *s, vstr_t *vstr) {
+    byte c;
+    do {
+        c = ujson_stream_get(s);
+    } while (c == ',' || c == ':' || c == ' ' || c == '\t' || c == '\n' || c == '\r');
+
+    switch (c) {
+        case T_EOF:
+        case '{':
+        case '}':
+        case '[':
+        case ']':
+            return c;
+        case 'n':
+            ujson_expect(s, "ull");
+            return T_NULL;
+        case 'f':
+            ujson_expect(s, "alse");
+            return T_FALSE;
+        case 't':
+            ujson_expect(s, "rue");
+            return T_TRUE;
+        case '"':
+            if (vstr != NULL) {
+                vstr_reset(vstr);
+            }
+            for (;;) {
+                // copy a run of plain characters straight from the buffer
+                const byte *p = s->pos;
+                while (p < s->end && *p != '"' && *p != '\\' && *p != S_EOF) {
+                    p++;
                 }
-                break;
-            case 't':
-                if (S_CUR(s) == 'r' && S_NEXT(s) == 'u' && S_NEXT(s) == 'e') {
-                    S_NEXT(s);
-                    next = mp_const_true;
-                } else {
-                    goto fail;
+                if (vstr != NULL) {
+                    vstr_add_strn(vstr, (const char*)s->pos, p - s->pos);
                 }
-                break;
-            case '"':
-                vstr_reset(&vstr);
-                for (; !S_END(s) && S_CUR(s) != '"';) {
-                    byte c = S_CUR(s);
-                    if (c == '\\') {
-                        c = S_NEXT(s);
-                        switch (c) {
-                            case 'b': c = 0x08; break;
-                            case 'f': c = 0x0c; break;
-                            case 'n': c = 0x0a; break;
-                            case 'r': c = 0x0d; break;
-                            case 't': c = 0x09; break;
-                            case 'u': {
-                                mp_uint_t num = 0;
-                                for (int i = 0; i < 4; i++) {
-                                    c = (S_NEXT(s) | 0x20) - '0';
-                                    if (c > 9) {
-                                        c -= ('a' - ('9' + 1));
-                                    }
-                                    num = (num << 4) | c;
+                s->pos = p;
+                c = ujson_stream_get(s);
+                if (c == '"') {
+                    return T_STR;
+                } else if (c == S_EOF) {
+                    ujson_fail();
+                } else if (c == '\\') {
+                    c = ujson_stream_get(s);
+                    switch (c) {
+                        case 'b': c = 0x08; break;
+                        case 'f': c = 0x0c; break;
+                        case 'n': c = 0x0a; break;
+                        case 'r': c = 0x0d; break;
+                        case 't': c = 0x09; break;
+                        case 'u': {
+                            mp_uint_t num = 0;
+                            for (int i = 0; i < 4; i++) {
+                                c = (ujson_stream_get(s) | 0x20) - '0';
+                                if (c > 9) {
+                                    c -= ('a' - ('9' + 1));
                                 }
-                                vstr_add_char(&vstr, num);
-                                goto str_cont;
+                                num = (num << 4) | c;
+                            }
+                            if (vstr != NULL) {
+                                vstr_add_char(vstr, num);
                             }
+                            continue;
                         }
                     }
-                    vstr_add_byte(&vstr, c);
-                str_cont:
-                    S_NEXT(s);
                 }
-                if (S_END(s)) {
-                    goto fail;
+                if (vstr != NULL) {
+                    vstr_add_byte(vstr, c);
                 }
-                S_NEXT(s);
-                next = mp_obj_new_str(vstr.buf, vstr.len);
-                break;
-            case '-':
-            case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9': {
-                bool flt = false;
-                vstr_reset(&vstr);
-                for (;;) {
-                    vstr_add_byte(&vstr, cur);
-                    cur = S_CUR(s);
-                    if (cur == '.' || cur == 'E' || cur == 'e') {
-                        flt = true;
-                    } else if (cur == '+' || cur == '-' || unichar_isdigit(cur)) {
-                        // pass
-                    } else {
-                        break;
-                    }
-                    S_NEXT(s);
-                }
-                if (flt) {
-                    next = mp_parse_num_decimal(vstr.buf, vstr.len, false, false, NULL);
+            }
+        case '-':
+        case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9': {
+            bool flt = false;
+            if (vstr != NULL) {
+                vstr_reset(vstr);
+                vstr_add_byte(vstr, c);
+            }
+            for (;;) {
+                c = S_PEEK(s);
+                if (c == '.' || c == 'E' || c == 'e') {
+                    flt = true;
+                } else if (c == '+' || c == '-' || unichar_isdigit(c)) {
+                    // pass
                 } else {
-                    next = mp_parse_num_integer(vstr.buf, vstr.len, 10, NULL);
+                    break;
                 }
-                break;
+                if (vstr != NULL) {
+                    vstr_add_byte(vstr, c);
+                }
+                S_SKIP(s);
             }
+            return flt ? T_FLOAT : T_INT;
+        }
+        default:
+            ujson_fail();
+    }
+}
+
+STATIC mp_obj_t ujson_token_value(byte tok, vstr_t *vstr) {
+    switch (tok) {
+        case T_STR:
+            return mp_obj_new_str(vstr->buf, vstr->len);
+        case T_INT:
+            return mp_parse_num_integer(vstr->buf, vstr->len, 10, NULL);
+        case T_FLOAT:
+            return mp_parse_num_decimal(vstr->buf, vstr->len, false, false, NULL);
+        case T_NULL:
+            return mp_const_none;
+        case T_TRUE:
+            return mp_const_true;
+        case T_FALSE:
+            return mp_const_false;
+        default:
+            ujson_fail();
+    }
+}
+
+// Skip the value starting with the given token, without allocating anything
+STATIC void ujson_skip(ujson_stream_t *s, byte tok) {
+    if (tok == '}' || tok == ']' || tok == T_EOF) {
+        ujson_fail();
+    }
+    size_t depth = (tok == '{' || tok == '[');
+    while (depth != 0) {
+        tok = ujson_token(s, NULL);
+        if (tok == '{' || tok == '[') {
+            depth += 1;
+        } else if (tok == '}' || tok == ']') {
+            depth -= 1;
+        } else if (tok == T_EOF) {
+            ujson_fail();
+        }
+    }
+}
+
+// A schema selects the parts of the document to load.  A dict keeps only the
+// listed keys of an object, the value under each key being the schema for
+// the corresponding member; applied to an array it selects from each element.
+// A list [s] applies s to each element of an array.  Anything else (eg None)
+// loads the value whole.
+STATIC mp_obj_t ujson_schema(mp_obj_t schema) {
+    if (schema != MP_OBJ_NULL && (mp_obj_is_type(schema, &mp_type_dict) || mp_obj_is_type(schema, &mp_type_list))) {
+        return schema;
+    }
+    return MP_OBJ_NULL;
+}
+
+// The schema applying to the members of a container loaded with the given schema
+STATIC mp_obj_t ujson_schema_items(mp_obj_t schema) {
+    if (schema != MP_OBJ_NULL && mp_obj_is_type(schema, &mp_type_list)) {
+        mp_obj_list_t *list = MP_OBJ_TO_PTR(schema);
+        return list->len == 0 ? MP_OBJ_NULL : ujson_schema(list->items[0]);
+    }
+    return schema;
+}
+
+// Look up the key held in vstr in a schema dict, without creating a str object
+STATIC mp_map_elem_t *ujson_schema_lookup(mp_obj_t schema, vstr_t *vstr) {
+    mp_obj_str_t key = {{&mp_type_str}, qstr_compute_hash((const byte*)vstr->buf, vstr->len),
+        vstr->len, (const byte*)vstr->buf};
+    return mp_map_lookup(mp_obj_dict_get_map(schema), MP_OBJ_FROM_PTR(&key), MP_MAP_LOOKUP);
+}
+
+// Load the value starting with the given token; containers are read up to
+// and including their closing bracket.
+STATIC mp_obj_t ujson_parse(ujson_stream_t *s, vstr_t *vstr, byte tok, mp_obj_t schema) {
+    mp_obj_list_t stack; // we use a list as a simple stack for nested JSON: pairs of container, schema
+    stack.len = 0;
+    stack.items = NULL;
+    mp_obj_t stack_top = MP_OBJ_NULL;
+    bool stack_top_is_map = false;
+    mp_obj_t stack_schema = MP_OBJ_NULL; // schema for the members of stack_top
+    mp_obj_t stack_key = MP_OBJ_NULL;
+    schema = ujson_schema(schema); // schema for the next value
+    for (;; tok = ujson_token(s, vstr)) {
+        mp_obj_t next;
+        bool enter = false;
+        switch (tok) {
             case '[':
                 next = mp_obj_new_list(0, NULL);
                 enter = true;
@@ -211,36 +357,50 @@ STATIC mp_obj_t mod_ujson_load(mp_obj_t stream_obj) {
             case ']': {
                 if (stack_top == MP_OBJ_NULL) {
                     // no object at all
-                    goto fail;
+                    ujson_fail();
                 }
                 if (stack.len == 0) {
                     // finished; compound object
-                    goto success;
+                    return stack_top;
                 }
-                stack.len -= 1;
+                stack.len -= 2;
                 stack_top = stack.items[stack.len];
-                stack_top_type = mp_obj_get_type(stack_top);
-                goto cont;
+                stack_top_is_map = mp_obj_is_type(stack_top, &mp_type_dict);
+                stack_schema = stack.items[stack.len + 1];
+                schema = stack_top_is_map ? MP_OBJ_NULL : stack_schema;
+                continue;
             }
             default:
-                goto fail;
+                if (stack_top_is_map && stack_key == MP_OBJ_NULL && stack_schema != MP_OBJ_NULL) {
+                    // member name of an object filtered by a schema dict
+                    mp_map_elem_t *elem = tok == T_STR ? ujson_schema_lookup(stack_schema, vstr) : NULL;
+                    if (elem == NULL) {
+                        ujson_skip(s, ujson_token(s, NULL));
+                    } else {
+                        stack_key = elem->key;
+                        schema = ujson_schema(elem->value);
+                    }
+                    continue;
+                }
+                // T_EOF fails here
+                next = ujson_token_value(tok, vstr);
+                break;
         }
         if (stack_top == MP_OBJ_NULL) {
             stack_top = next;
-            stack_top_type = mp_obj_get_type(stack_top);
             if (!enter) {
                 // finished; single primitive only
-                goto success;
+                return stack_top;
             }
         } else {
             // append to list or dict
-            if (stack_top_type == &mp_type_list) {
+            if (!stack_top_is_map) {
                 mp_obj_list_append(stack_top, next);
             } else {
                 if (stack_key == MP_OBJ_NULL) {
                     stack_key = next;
                     if (enter) {
-                        goto fail;
+                        ujson_fail();
                     }
                 } else {
                     mp_obj_dict_store(stack_top, stack_key, next);
@@ -249,45 +409,394 @@ STATIC mp_obj_t mod_ujson_load(mp_obj_t stream_obj) {
             }
             if (enter) {
                 if (stack.items == NULL) {
-                    mp_obj_list_init(&stack, 1);
+                    mp_obj_list_init(&stack, 2);
                     stack.items[0] = stack_top;
+                    stack.items[1] = stack_schema;
                 } else {
                     mp_obj_list_append(MP_OBJ_FROM_PTR(&stack), stack_top);
+                    mp_obj_list_append(MP_OBJ_FROM_PTR(&stack), stack_schema);
                 }
                 stack_top = next;
-                stack_top_type = mp_obj_get_type(stack_top);
             }
         }
+        if (enter) {
+            stack_top_is_map = (tok == '{');
+            stack_schema = ujson_schema_items(schema);
+            if (stack_top_is_map && stack_schema != MP_OBJ_NULL && !mp_obj_is_type(stack_schema, &mp_type_dict)) {
+                stack_schema = MP_OBJ_NULL;
+            }
+        }
+        schema = stack_top_is_map ? MP_OBJ_NULL : stack_schema;
     }
-    success:
+}
+
+STATIC mp_obj_t ujson_load(ujson_stream_t *s, mp_obj_t schema) {
+    vstr_t vstr;
+    vstr_init(&vstr, 8);
+    mp_obj_t obj = ujson_parse(s, &vstr, ujson_token(s, &vstr), schema);
     // eat trailing whitespace
-    while (unichar_isspace(S_CUR(s))) {
-        S_NEXT(s);
+    while (unichar_isspace(S_PEEK(s))) {
+        S_SKIP(s);
     }
-    if (!S_END(s)) {
+    if (S_PEEK(s) != S_EOF) {
         // unexpected chars
-        goto fail;
-    }
-    if (stack_top == MP_OBJ_NULL || stack.len != 0) {
-        // not exactly 1 object
-        goto fail;
+        ujson_fail();
     }
     vstr_clear(&vstr);
-    return stack_top;
+    return obj;
+}
 
-    fail:
-    mp_raise_ValueError("syntax error in JSON");
+STATIC mp_obj_t mod_ujson_load(size_t n_args, const mp_obj_t *args) {
+    ujson_stream_t s;
+    s.stream_obj = args[0];
+    s.read = mp_get_stream_raise(args[0], MP_STREAM_OP_READ)->read;
+    s.pos = s.end = s.buf;
+    return ujson_load(&s, n_args > 1 ? args[1] : MP_OBJ_NULL);
 }
-STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_ujson_load_obj, mod_ujson_load);
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_ujson_load_obj, 1, 2, mod_ujson_load);
 
-STATIC mp_obj_t mod_ujson_loads(mp_obj_t obj) {
-    size_t len;
-    const char *buf = mp_obj_str_get_data(obj, &len);
-    vstr_t vstr = {len, len, (char*)buf, true};
-    mp_obj_stringio_t sio = {{&mp_type_stringio}, &vstr, 0, MP_OBJ_NULL};
-    return mod_ujson_load(MP_OBJ_FROM_PTR(&sio));
+STATIC mp_obj_t mod_ujson_loads(size_t n_args, const mp_obj_t *args) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[0], &bufinfo, MP_BUFFER_READ);
+    ujson_stream_t s;
+    s.stream_obj = MP_OBJ_NULL;
+    s.pos = bufinfo.buf;
+    s.end = s.pos + bufinfo.len;
+    return ujson_load(&s, n_args > 1 ? args[1] : MP_OBJ_NULL);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_ujson_loads_obj, 1, 2, mod_ujson_loads);
+
+#if MICROPY_PY_UJSON_STREAM
+
+// Incremental parser: iterating over it yields one event per token, as a
+// qstr, without building the document.  The value of the last string,
+// number, boolean or null is returned by value(), and skip()/load() consume
+// the rest of the container just started, or the value of the key just read.
+
+typedef struct _ujson_parser_obj_t {
+    mp_obj_base_t base;
+    mp_obj_t src;
+    vstr_t vstr;
+    byte tok;
+    byte depth;
+    // '[' in array, '{' in object before a key, ':' in object after a key
+    byte stack[UJSON_MAX_DEPTH];
+    ujson_stream_t s;
+} ujson_parser_obj_t;
+
+STATIC const mp_obj_type_t ujson_parser_type;
+
+STATIC void ujson_stream_init(ujson_stream_t *s, mp_obj_t obj) {
+    mp_buffer_info_t bufinfo;
+    if (mp_get_buffer(obj, &bufinfo, MP_BUFFER_READ)) {
+        s->stream_obj = MP_OBJ_NULL;
+        s->pos = bufinfo.buf;
+        s->end = s->pos + bufinfo.len;
+    } else {
+        s->stream_obj = obj;
+        s->read = mp_get_stream_raise(obj, MP_STREAM_OP_READ)->read;
+        s->pos = s->end = s->buf;
+    }
+}
+
+STATIC mp_obj_t ujson_parser_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, 1, false);
+    ujson_parser_obj_t *self = m_new_obj(ujson_parser_obj_t);
+    self->base.type = &ujson_parser_type;
+    self->src = args[0];
+    ujson_stream_init(&self->s, args[0]);
+    vstr_init(&self->vstr, 8);
+    self->tok = T_EOF;
+    self->depth = 0;
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// A complete value was read in the current container
+STATIC void ujson_parser_value_done(ujson_parser_obj_t *self) {
+    if (self->depth != 0 && self->stack[self->depth - 1] == ':') {
+        self->stack[self->depth - 1] = '{';
+    }
 }
-STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_ujson_loads_obj, mod_ujson_loads);
+
+STATIC mp_obj_t ujson_parser_iternext(mp_obj_t self_in) {
+    ujson_parser_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    byte tok = ujson_token(&self->s, &self->vstr);
+    byte state = self->depth == 0 ? 0 : self->stack[self->depth - 1];
+    self->tok = tok;
+    if (state == '{' && tok != T_STR && tok != '}') {
+        // object member name expected
+        ujson_fail();
+    }
+    qstr event;
+    switch (tok) {
+        case T_EOF:
+            if (self->depth != 0) {
+                ujson_fail();
+            }
+            return MP_OBJ_STOP_ITERATION;
+        case '{':
+        case '[':
+            if (self->depth == UJSON_MAX_DEPTH) {
+                mp_raise_ValueError("JSON nested too deep");
+            }
+            self->stack[self->depth++] = tok;
+            return MP_OBJ_NEW_QSTR(tok == '{' ? MP_QSTR_start_map : MP_QSTR_start_array);
+        case '}':
+        case ']':
+            if (state != (tok == '}' ? '{' : '[')) {
+                ujson_fail();
+            }
+            self->depth -= 1;
+            event = tok == '}' ? MP_QSTR_end_map : MP_QSTR_end_array;
+            break;
+        case T_STR:
+            if (state == '{') {
+                self->stack[self->depth - 1] = ':';
+                return MP_OBJ_NEW_QSTR(MP_QSTR_map_key);
+            }
+            event = MP_QSTR_string;
+            break;
+        case T_INT:
+        case T_FLOAT:
+            event = MP_QSTR_number;
+            break;
+        case T_NULL:
+            event = MP_QSTR_null;
+            break;
+        default:
+            event = MP_QSTR_boolean;
+            break;
+    }
+    ujson_parser_value_done(self);
+    return MP_OBJ_NEW_QSTR(event);
+}
+
+STATIC mp_obj_t ujson_parser_value(mp_obj_t self_in) {
+    ujson_parser_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    switch (self->tok) {
+        case T_STR:
+        case T_INT:
+        case T_FLOAT:
+        case T_NULL:
+        case T_TRUE:
+        case T_FALSE:
+            return ujson_token_value(self->tok, &self->vstr);
+        default:
+            return mp_const_none;
+    }
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(ujson_parser_value_obj, ujson_parser_value);
+
+STATIC mp_obj_t ujson_parser_depth(mp_obj_t self_in) {
+    ujson_parser_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return MP_OBJ_NEW_SMALL_INT(self->depth);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(ujson_parser_depth_obj, ujson_parser_depth);
+
+// Consume the container just started or the value of the key just read,
+// loading it with the given schema, or skipping it if skip is set
+STATIC mp_obj_t ujson_parser_consume(ujson_parser_obj_t *self, mp_obj_t schema, bool skip) {
+    byte tok = self->tok;
+    if (tok == T_STR && self->depth != 0 && self->stack[self->depth - 1] == ':') {
+        // map_key: the member value follows
+        tok = ujson_token(&self->s, skip ? NULL : &self->vstr);
+        if (tok == '}' || tok == ']') {
+            ujson_fail();
+        }
+    } else if (tok == '{' || tok == '[') {
+        self->depth -= 1;
+    } else {
+        // nothing pending; a scalar event stands for its own value
+        return skip ? mp_const_none : ujson_parser_value(MP_OBJ_FROM_PTR(self));
+    }
+    mp_obj_t obj = mp_const_none;
+    if (skip) {
+        ujson_skip(&self->s, tok);
+    } else {
+        obj = ujson_parse(&self->s, &self->vstr, tok, schema);
+    }
+    self->tok = T_EOF;
+    ujson_parser_value_done(self);
+    return obj;
+}
+
+STATIC mp_obj_t ujson_parser_skip(mp_obj_t self_in) {
+    return ujson_parser_consume(MP_OBJ_TO_PTR(self_in), MP_OBJ_NULL, true);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(ujson_parser_skip_obj, ujson_parser_skip);
+
+STATIC mp_obj_t ujson_parser_load(size_t n_args, const mp_obj_t *args) {
+    return ujson_parser_consume(MP_OBJ_TO_PTR(args[0]), n_args > 1 ? args[1] : MP_OBJ_NULL, false);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(ujson_parser_load_obj, 1, 2, ujson_parser_load);
+
+STATIC const mp_rom_map_elem_t ujson_parser_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_value), MP_ROM_PTR(&ujson_parser_value_obj) },
+    { MP_ROM_QSTR(MP_QSTR_depth), MP_ROM_PTR(&ujson_parser_depth_obj) },
+    { MP_ROM_QSTR(MP_QSTR_skip), MP_ROM_PTR(&ujson_parser_skip_obj) },
+    { MP_ROM_QSTR(MP_QSTR_load), MP_ROM_PTR(&ujson_parser_load_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(ujson_parser_locals_dict, ujson_parser_locals_dict_table);
+
+STATIC const mp_obj_type_t ujson_parser_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_Parser,
+    .make_new = ujson_parser_make_new,
+    .getiter = mp_identity_getiter,
+    .iternext = ujson_parser_iternext,
+    .locals_dict = (void*)&ujson_parser_locals_dict,
+};
+
+// Incremental encoder: writes a document member by member to a stream,
+// inserting the same separators as dumps(), so the document never exists as
+// a whole in RAM.
+// Output is buffered and written out when a top-level value is complete or
+// on flush().
+
+typedef struct _ujson_writer_obj_t {
+    mp_obj_base_t base;
+    byte depth;
+    // '[' in array, '{' in object before a key, ':' in object after a key;
+    // WRITER_NONEMPTY is or'ed in once the container has a member
+    byte stack[UJSON_MAX_DEPTH];
+    ujson_out_t out;
+} ujson_writer_obj_t;
+
+#define WRITER_NONEMPTY (0x80)
+
+STATIC const mp_obj_type_t ujson_writer_type;
+
+STATIC mp_obj_t ujson_writer_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, 1, false);
+    mp_get_stream_raise(args[0], MP_STREAM_OP_WRITE);
+    ujson_writer_obj_t *self = m_new_obj(ujson_writer_obj_t);
+    self->base.type = &ujson_writer_type;
+    self->depth = 0;
+    self->out.stream_obj = args[0];
+    self->out.len = 0;
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// Write the separator before a value, checking that a value may go here
+STATIC void ujson_writer_begin_value(ujson_writer_obj_t *self) {
+    if (self->depth == 0) {
+        return;
+    }
+    byte *state = &self->stack[self->depth - 1];
+    if ((*state & ~WRITER_NONEMPTY) == '{') {
+        mp_raise_ValueError("JSON object key expected");
+    }
+    if (*state == ('[' | WRITER_NONEMPTY)) {
+        ujson_out_strn(&self->out, ", ", 2);
+    }
+    *state = (*state == ':') ? ('{' | WRITER_NONEMPTY) : ('[' | WRITER_NONEMPTY);
+}
+
+STATIC void ujson_writer_end_value(ujson_writer_obj_t *self) {
+    if (self->depth == 0) {
+        ujson_out_flush(&self->out);
+    }
+}
+
+STATIC mp_obj_t ujson_writer_start(mp_obj_t self_in, byte kind) {
+    ujson_writer_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->depth == UJSON_MAX_DEPTH) {
+        mp_raise_ValueError("JSON nested too deep");
+    }
+    ujson_writer_begin_value(self);
+    self->stack[self->depth++] = kind;
+    ujson_out_strn(&self->out, (const char*)&kind, 1);
+    return mp_const_none;
+}
+
+STATIC mp_obj_t ujson_writer_end(mp_obj_t self_in, byte kind) {
+    ujson_writer_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->depth == 0 || (self->stack[self->depth - 1] & ~WRITER_NONEMPTY) != kind) {
+        mp_raise_ValueError(kind == '{' ? "no JSON object to end" : "no JSON array to end");
+    }
+    self->depth -= 1;
+    ujson_out_strn(&self->out, kind == '{' ? "}" : "]", 1);
+    ujson_writer_end_value(self);
+    return mp_const_none;
+}
+
+STATIC mp_obj_t ujson_writer_start_map(mp_obj_t self_in) {
+    return ujson_writer_start(self_in, '{');
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(ujson_writer_start_map_obj, ujson_writer_start_map);
+
+STATIC mp_obj_t ujson_writer_end_map(mp_obj_t self_in) {
+    return ujson_writer_end(self_in, '{');
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(ujson_writer_end_map_obj, ujson_writer_end_map);
+
+STATIC mp_obj_t ujson_writer_start_array(mp_obj_t self_in) {
+    return ujson_writer_start(self_in, '[');
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(ujson_writer_start_array_obj, ujson_writer_start_array);
+
+STATIC mp_obj_t ujson_writer_end_array(mp_obj_t self_in) {
+    return ujson_writer_end(self_in, '[');
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(ujson_writer_end_array_obj, ujson_writer_end_array);
+
+STATIC mp_obj_t ujson_writer_key(mp_obj_t self_in, mp_obj_t key) {
+    ujson_writer_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->depth == 0 || (self->stack[self->depth - 1] & ~WRITER_NONEMPTY) != '{') {
+        mp_raise_ValueError("JSON object key not expected");
+    }
+    if (!mp_obj_is_str(key)) {
+        mp_raise_TypeError("JSON object key must be str");
+    }
+    if (self->stack[self->depth - 1] & WRITER_NONEMPTY) {
+        ujson_out_strn(&self->out, ", ", 2);
+    }
+    self->stack[self->depth - 1] = ':';
+    mp_print_t print = {&self->out, ujson_out_strn};
+    mp_obj_print_helper(&print, key, PRINT_JSON);
+    ujson_out_strn(&self->out, ": ", 2);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(ujson_writer_key_obj, ujson_writer_key);
+
+STATIC mp_obj_t ujson_writer_value(mp_obj_t self_in, mp_obj_t obj) {
+    ujson_writer_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    ujson_writer_begin_value(self);
+    mp_print_t print = {&self->out, ujson_out_strn};
+    mp_obj_print_helper(&print, obj, PRINT_JSON);
+    ujson_writer_end_value(self);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(ujson_writer_value_obj, ujson_writer_value);
+
+STATIC mp_obj_t ujson_writer_flush(mp_obj_t self_in) {
+    ujson_writer_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    ujson_out_flush(&self->out);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(ujson_writer_flush_obj, ujson_writer_flush);
+
+STATIC const mp_rom_map_elem_t ujson_writer_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_start_map), MP_ROM_PTR(&ujson_writer_start_map_obj) },
+    { MP_ROM_QSTR(MP_QSTR_end_map), MP_ROM_PTR(&ujson_writer_end_map_obj) },
+    { MP_ROM_QSTR(MP_QSTR_start_array), MP_ROM_PTR(&ujson_writer_start_array_obj) },
+    { MP_ROM_QSTR(MP_QSTR_end_array), MP_ROM_PTR(&ujson_writer_end_array_obj) },
+    { MP_ROM_QSTR(MP_QSTR_key), MP_ROM_PTR(&ujson_writer_key_obj) },
+    { MP_ROM_QSTR(MP_QSTR_value), MP_ROM_PTR(&ujson_writer_value_obj) },
+    { MP_ROM_QSTR(MP_QSTR_flush), MP_ROM_PTR(&ujson_writer_flush_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(ujson_writer_locals_dict, ujson_writer_locals_dict_table);
+
+STATIC const mp_obj_type_t ujson_writer_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_Writer,
+    .make_new = ujson_writer_make_new,
+    .locals_dict = (void*)&ujson_writer_locals_dict,
+};
+
+#endif // MICROPY_PY_UJSON_STREAM
 
 STATIC const mp_rom_map_elem_t mp_module_ujson_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_ujson) },
@@ -295,6 +804,10 @@ STATIC const mp_rom_map_elem_t mp_module_ujson_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_dumps), MP_ROM_PTR(&mod_ujson_dumps_obj) },
     { MP_ROM_QSTR(MP_QSTR_load), MP_ROM_PTR(&mod_ujson_load_obj) },
     { MP_ROM_QSTR(MP_QSTR_loads), MP_ROM_PTR(&mod_ujson_loads_obj) },
+    #if MICROPY_PY_UJSON_STREAM
+    { MP_ROM_QSTR(MP_QSTR_Parser), MP_ROM_PTR(&ujson_parser_type) },
+    { MP_ROM_QSTR(MP_QSTR_Writer), MP_ROM_PTR(&ujson_writer_type) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_ujson_globals, mp_module_ujson_globals_table);
@@ -201,10 +201,166 @@ error:
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_uzlib_decompress_obj, 1, 3, mod_uzlib_decompress);
 
+#if MICROPY_PY_UZLIB_COMPRESS
+
+// wbits: 9..15 - zlib, 25..31 - gzip, -9..-15 - raw deflate, window size is 2^(wbits & 15)
+STATIC int get_comp_format(mp_int_t wbits, int *chksum_type) {
+    if (wbits < 0) {
+        wbits = -wbits;
+        *chksum_type = TINF_CHKSUM_NONE;
+    } else if (wbits >= 16) {
+        wbits -= 16;
+        *chksum_type = TINF_CHKSUM_CRC;
+    } else {
+        *chksum_type = TINF_CHKSUM_ADLER;
+    }
+    if (wbits < 9 || wbits > 15) {
+        mp_raise_ValueError("wbits");
+    }
+    return wbits;
+}
+
+typedef struct _mp_obj_compio_t {
+    mp_obj_base_t base;
+    mp_obj_t dest_stream;
+    struct uzlib_comp comp;
+    byte *mem;
+    bool finished;
+} mp_obj_compio_t;
+
+STATIC void write_dest_stream(struct uzlib_comp *comp, const unsigned char *data, unsigned int len) {
+    byte *p = (void*)comp;
+    p -= offsetof(mp_obj_compio_t, comp);
+    mp_obj_compio_t *self = (mp_obj_compio_t*)p;
+
+    int err;
+    mp_stream_write_exactly(self->dest_stream, data, len, &err);
+    if (err != 0) {
+        mp_raise_OSError(err);
+    }
+}
+
+STATIC mp_obj_t compio_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, 3, false);
+    mp_get_stream_raise(args[0], MP_STREAM_OP_WRITE);
+    mp_int_t level = (n_args > 1) ? mp_obj_get_int(args[1]) : 6;
+    int chksum_type;
+    int wbits = get_comp_format((n_args > 2) ? mp_obj_get_int(args[2]) : 12, &chksum_type);
+
+    mp_obj_compio_t *o = m_new_obj(mp_obj_compio_t);
+    o->base.type = type;
+    o->dest_stream = args[0];
+    o->finished = false;
+    o->mem = m_new(byte, UZLIB_COMP_MEM_SIZE(wbits));
+    uzlib_compress_init(&o->comp, o->mem, wbits, level, chksum_type);
+    o->comp.dest_write_cb = write_dest_stream;
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC mp_uint_t compio_write(mp_obj_t o_in, const void *buf, mp_uint_t size, int *errcode) {
+    mp_obj_compio_t *o = MP_OBJ_TO_PTR(o_in);
+    if (o->finished) {
+        *errcode = MP_EINVAL;
+        return MP_STREAM_ERROR;
+    }
+    uzlib_compress_write(&o->comp, buf, size);
+    return size;
+}
+
+STATIC mp_uint_t compio_ioctl(mp_obj_t o_in, mp_uint_t request, uintptr_t arg, int *errcode) {
+    mp_obj_compio_t *o = MP_OBJ_TO_PTR(o_in);
+    (void)arg;
+    if (request == MP_STREAM_FLUSH) {
+        // all data written so far can be decompressed by the receiver
+        if (!o->finished) {
+            uzlib_compress_flush(&o->comp, UZLIB_FLUSH_SYNC);
+        }
+        return 0;
+    } else if (request == MP_STREAM_CLOSE) {
+        // finish the compressed stream, the destination stream is not closed
+        if (!o->finished) {
+            o->finished = true;
+            uzlib_compress_flush(&o->comp, UZLIB_FLUSH_FINISH);
+            m_del(byte, o->mem, UZLIB_COMP_MEM_SIZE(o->comp.wbits));
+            o->mem = NULL;
+        }
+        return 0;
+    }
+    *errcode = MP_EINVAL;
+    return MP_STREAM_ERROR;
+}
+
+STATIC mp_obj_t compio___exit__(size_t n_args, const mp_obj_t *args) {
+    (void)n_args;
+    return mp_stream_close(args[0]);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(compio___exit___obj, 4, 4, compio___exit__);
+
+STATIC const mp_rom_map_elem_t compio_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_write), MP_ROM_PTR(&mp_stream_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_flush), MP_ROM_PTR(&mp_stream_flush_obj) },
+    { MP_ROM_QSTR(MP_QSTR_close), MP_ROM_PTR(&mp_stream_close_obj) },
+    { MP_ROM_QSTR(MP_QSTR___enter__), MP_ROM_PTR(&mp_identity_obj) },
+    { MP_ROM_QSTR(MP_QSTR___exit__), MP_ROM_PTR(&compio___exit___obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(compio_locals_dict, compio_locals_dict_table);
+
+STATIC const mp_stream_p_t compio_stream_p = {
+    .write = compio_write,
+    .ioctl = compio_ioctl,
+};
+
+STATIC const mp_obj_type_t compio_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_CompressIO,
+    .make_new = compio_make_new,
+    .protocol = &compio_stream_p,
+    .locals_dict = (void*)&compio_locals_dict,
+};
+
+typedef struct _compress_vstr_t {
+    struct uzlib_comp comp;
+    vstr_t vstr;
+} compress_vstr_t;
+
+STATIC void write_vstr(struct uzlib_comp *comp, const unsigned char *data, unsigned int len) {
+    vstr_add_strn(&((compress_vstr_t*)comp)->vstr, (const char*)data, len);
+}
+
+STATIC mp_obj_t mod_uzlib_compress(size_t n_args, const mp_obj_t *args) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[0], &bufinfo, MP_BUFFER_READ);
+    mp_int_t level = (n_args > 1) ? mp_obj_get_int(args[1]) : 6;
+    int chksum_type;
+    int wbits = get_comp_format((n_args > 2) ? mp_obj_get_int(args[2]) : 12, &chksum_type);
+
+    compress_vstr_t *c = m_new_obj(compress_vstr_t);
+    byte *mem = m_new(byte, UZLIB_COMP_MEM_SIZE(wbits));
+    // typical text compresses to less than a half
+    vstr_init(&c->vstr, bufinfo.len / 2 + 32);
+    uzlib_compress_init(&c->comp, mem, wbits, level, chksum_type);
+    c->comp.dest_write_cb = write_vstr;
+    uzlib_compress_write(&c->comp, bufinfo.buf, bufinfo.len);
+    uzlib_compress_flush(&c->comp, UZLIB_FLUSH_FINISH);
+
+    m_del(byte, mem, UZLIB_COMP_MEM_SIZE(wbits));
+    mp_obj_t res = mp_obj_new_str_from_vstr(&mp_type_bytes, &c->vstr);
+    m_del_obj(compress_vstr_t, c);
+    return res;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_uzlib_compress_obj, 1, 3, mod_uzlib_compress);
+
+#endif // MICROPY_PY_UZLIB_COMPRESS
+
 STATIC const mp_rom_map_elem_t mp_module_uzlib_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_uzlib) },
     { MP_ROM_QSTR(MP_QSTR_decompress), MP_ROM_PTR(&mod_uzlib_decompress_obj) },
     { MP_ROM_QSTR(MP_QSTR_DecompIO), MP_ROM_PTR(&decompio_type) },
+    #if MICROPY_PY_UZLIB_COMPRESS
+    { MP_ROM_QSTR(MP_QSTR_compress), MP_ROM_PTR(&mod_uzlib_compress_obj) },
+    { MP_ROM_QSTR(MP_QSTR_CompressIO), MP_ROM_PTR(&compio_type) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_uzlib_globals, mp_module_uzlib_globals_table);
@@ -222,5 +378,8 @@ const mp_obj_module_t mp_module_uzlib = {
 #include "uzlib/tinfgzip.c"
 #include "uzlib/adler32.c"
 #include "uzlib/crc32.c"
+#if MICROPY_PY_UZLIB_COMPRESS
+#include "uzlib/tdeflate.c"
+#endif
 
 #endif // MICROPY_PY_UZLIB
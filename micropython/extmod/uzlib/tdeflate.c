@@ -0,0 +1,765 @@
+/*
+ * uzlib  -  tiny deflate/inflate library (deflate, gzip, zlib)
+ *
+ * Streaming deflate compressor
+ *
+ * LZ77 with hash chains and lazy matching over a bounded sliding
+ * window, each block is encoded with fixed or dynamic Huffman codes,
+ * whichever is smaller.
+ * Matching strategy and level parameters follow zlib's deflate_slow(),
+ * Huffman code lengths are computed with the in-place algorithm of
+ * Moffat and Katajainen.
+ *
+ * Copyright (c) 2019 by Boris Lovosevic
+ *
+ * This software is provided 'as-is', without any express
+ * or implied warranty.  In no event will the authors be
+ * held liable for any damages arising from the use of
+ * this software.
+ *
+ * Permission is granted to anyone to use this software
+ * for any purpose, including commercial applications,
+ * and to alter it and redistribute it freely, subject to
+ * the following restrictions:
+ *
+ * 1. The origin of this software must not be
+ *    misrepresented; you must not claim that you
+ *    wrote the original software. If you use this
+ *    software in a product, an acknowledgment in
+ *    the product documentation would be appreciated
+ *    but is not required.
+ *
+ * 2. Altered source versions must be plainly marked
+ *    as such, and must not be misrepresented as
+ *    being the original software.
+ *
+ * 3. This notice may not be removed or altered from
+ *    any source distribution.
+ */
+
+#include <string.h>
+#include "tinf.h"
+
+#define DEFL_MIN_MATCH     3
+#define DEFL_MAX_MATCH     258
+/* minimal lookahead needed to find the longest match, except at the end of input */
+#define DEFL_MIN_LOOKAHEAD (DEFL_MAX_MATCH + DEFL_MIN_MATCH + 1)
+/* matches of minimal length are discarded if farther than this */
+#define DEFL_TOO_FAR       4096
+#define DEFL_MAX_BITS      15
+#define DEFL_MAX_CL_BITS   7
+
+/* ------------------------------------- *
+ * -- static tables, built on first use -- *
+ * ------------------------------------- */
+
+static const unsigned char defl_len_extra[29] = {
+   0, 0, 0, 0, 0, 0, 0, 0,
+   1, 1, 1, 1, 2, 2, 2, 2,
+   3, 3, 3, 3, 4, 4, 4, 4,
+   5, 5, 5, 5, 0
+};
+static const unsigned char defl_dist_extra[30] = {
+   0, 0, 0, 0, 1, 1, 2, 2,
+   3, 3, 4, 4, 5, 5, 6, 6,
+   7, 7, 8, 8, 9, 9, 10, 10,
+   11, 11, 12, 12, 13, 13
+};
+static const unsigned char defl_cl_extra[19] = {
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+   2, 3, 7
+};
+/* special ordering of code length codes */
+static const unsigned char defl_cl_order[19] = {
+   16, 17, 18, 0, 8, 7, 9, 6,
+   10, 5, 11, 4, 12, 3, 13, 2,
+   14, 1, 15
+};
+
+/* match length - 3 -> length code - 257 */
+static unsigned char defl_len_code[256];
+/* first match length of each length code, - 3 */
+static unsigned char defl_len_base[29];
+/* distance - 1 -> distance code, see DEFL_DIST_CODE() */
+static unsigned char defl_dist_code[512];
+static unsigned short defl_dist_base[30];
+/* fixed Huffman codes (bit reversed) and their lengths */
+static unsigned short defl_fixed_lcode[288];
+static unsigned char defl_fixed_llen[288];
+static unsigned short defl_fixed_dcode[30];
+static bool defl_tables_ok = false;
+
+#define DEFL_DIST_CODE(d) (((d) < 256) ? defl_dist_code[d] : defl_dist_code[256 + ((d) >> 7)])
+
+/* compression level parameters: good_length, max_lazy, nice_length, max_chain */
+static const unsigned short defl_config[10][4] = {
+   {0,   0,   0,    0},
+   {4,   4,   8,    4},
+   {4,   5,  16,    8},
+   {4,   6,  32,   32},
+   {4,   4,  16,   16},
+   {8,  16,  32,   32},
+   {8,  16, 128,  128},
+   {8,  32, 128,  256},
+   {32, 128, 258, 1024},
+   {32, 258, 258, 4096}
+};
+
+/* ----------------------- *
+ * -- utility functions -- *
+ * ----------------------- */
+
+static unsigned int defl_bit_reverse(unsigned int code, int len)
+{
+   unsigned int res = 0;
+
+   while (len-- > 0)
+   {
+      res = (res << 1) | (code & 1);
+      code >>= 1;
+   }
+   return res;
+}
+
+/* assign canonical codes (bit reversed, as they are sent LSB first) to the code lengths */
+static void defl_gen_codes(unsigned short *codes, const unsigned char *lens, int num)
+{
+   unsigned short count[DEFL_MAX_BITS + 1];
+   unsigned short next[DEFL_MAX_BITS + 1];
+   unsigned int code = 0;
+   int i;
+
+   for (i = 0; i <= DEFL_MAX_BITS; ++i) count[i] = 0;
+   for (i = 0; i < num; ++i) count[lens[i]]++;
+   count[0] = 0;
+
+   for (i = 1; i <= DEFL_MAX_BITS; ++i)
+   {
+      code = (code + count[i - 1]) << 1;
+      next[i] = code;
+   }
+   for (i = 0; i < num; ++i)
+   {
+      if (lens[i]) codes[i] = defl_bit_reverse(next[lens[i]]++, lens[i]);
+   }
+}
+
+static void defl_build_tables(void)
+{
+   int code, n, len = 0, dist = 0;
+
+   for (code = 0; code < 28; ++code)
+   {
+      defl_len_base[code] = len;
+      for (n = 0; n < (1 << defl_len_extra[code]); ++n) defl_len_code[len++] = code;
+   }
+   /* length 258 has its own code */
+   defl_len_base[28] = 255;
+   defl_len_code[255] = 28;
+
+   for (code = 0; code < 16; ++code)
+   {
+      defl_dist_base[code] = dist;
+      for (n = 0; n < (1 << defl_dist_extra[code]); ++n) defl_dist_code[dist++] = code;
+   }
+   dist >>= 7;
+   for (; code < 30; ++code)
+   {
+      defl_dist_base[code] = dist << 7;
+      for (n = 0; n < (1 << (defl_dist_extra[code] - 7)); ++n) defl_dist_code[256 + dist++] = code;
+   }
+
+   for (n = 0; n < 144; ++n) defl_fixed_llen[n] = 8;
+   for (; n < 256; ++n) defl_fixed_llen[n] = 9;
+   for (; n < 280; ++n) defl_fixed_llen[n] = 7;
+   for (; n < 288; ++n) defl_fixed_llen[n] = 8;
+   defl_gen_codes(defl_fixed_lcode, defl_fixed_llen, 288);
+   for (n = 0; n < 30; ++n) defl_fixed_dcode[n] = defl_bit_reverse(n, 5);
+
+   defl_tables_ok = true;
+}
+
+/* --------------------- *
+ * -- output functions -- *
+ * --------------------- */
+
+static void defl_flush_output(struct uzlib_comp *c)
+{
+   if (c->outlen)
+   {
+      c->dest_write_cb(c, c->outbuf, c->outlen);
+      c->outlen = 0;
+   }
+}
+
+static void defl_put_byte(struct uzlib_comp *c, unsigned char b)
+{
+   c->outbuf[c->outlen++] = b;
+   if (c->outlen == sizeof(c->outbuf)) defl_flush_output(c);
+}
+
+/* nbits must not be greater than 16 */
+static void defl_put_bits(struct uzlib_comp *c, unsigned int bits, unsigned int nbits)
+{
+   c->bitbuf |= bits << c->bitcount;
+   c->bitcount += nbits;
+   while (c->bitcount >= 8)
+   {
+      defl_put_byte(c, c->bitbuf & 0xff);
+      c->bitbuf >>= 8;
+      c->bitcount -= 8;
+   }
+}
+
+static void defl_align(struct uzlib_comp *c)
+{
+   if (c->bitcount) defl_put_bits(c, 0, 8 - c->bitcount);
+}
+
+/* ------------------------ *
+ * -- Huffman code stage -- *
+ * ------------------------ */
+
+/* A[0..n-1] contains the weights sorted ascending, on return
+   A[i] contains the code length of the i-th weight (Moffat & Katajainen) */
+static void defl_min_redundancy(unsigned int *A, int n)
+{
+   int root, leaf, next, avbl, used, dpth;
+
+   if (n == 0) return;
+   if (n == 1)
+   {
+      A[0] = 1;
+      return;
+   }
+
+   /* first pass, left to right, set parent pointers */
+   A[0] += A[1];
+   root = 0;
+   leaf = 2;
+   for (next = 1; next < n - 1; ++next)
+   {
+      if ((leaf >= n) || (A[root] < A[leaf]))
+      {
+         A[next] = A[root];
+         A[root++] = next;
+      }
+      else A[next] = A[leaf++];
+
+      if ((leaf >= n) || ((root < next) && (A[root] < A[leaf])))
+      {
+         A[next] += A[root];
+         A[root++] = next;
+      }
+      else A[next] += A[leaf++];
+   }
+
+   /* second pass, right to left, set internal depths */
+   A[n - 2] = 0;
+   for (next = n - 3; next >= 0; --next) A[next] = A[A[next]] + 1;
+
+   /* third pass, right to left, set leaf depths */
+   avbl = 1;
+   used = dpth = 0;
+   root = n - 2;
+   next = n - 1;
+   while (avbl > 0)
+   {
+      while ((root >= 0) && ((int)A[root] == dpth))
+      {
+         used++;
+         root--;
+      }
+      while (avbl > used)
+      {
+         A[next--] = dpth;
+         avbl--;
+      }
+      avbl = 2 * used;
+      dpth++;
+      used = 0;
+   }
+}
+
+/* compute length limited Huffman code lengths for the given symbol frequencies */
+static void defl_build_lengths(struct uzlib_comp *c, const unsigned short *freq, unsigned char *lens, int num, int max_bits)
+{
+   unsigned short *sym = c->huff_sym;
+   unsigned int *A = c->huff_work;
+   unsigned int count[DEFL_MAX_BITS + 1];
+   unsigned int total;
+   int i, j, n = 0;
+
+   for (i = 0; i < num; ++i)
+   {
+      lens[i] = 0;
+      if (freq[i] == 0) continue;
+      /* insertion sort by frequency, the alphabets are small and mostly sparse */
+      for (j = n; (j > 0) && (freq[sym[j - 1]] > freq[i]); --j) sym[j] = sym[j - 1];
+      sym[j] = i;
+      n++;
+   }
+   /* at least two codes are needed (one bit must be sent even for a single used symbol) */
+   for (i = 0; (n < 2) && (i < num); ++i)
+   {
+      if (freq[i] == 0)
+      {
+         for (j = n; j > 0; --j) sym[j] = sym[j - 1];
+         sym[0] = i;
+         n++;
+      }
+   }
+
+   for (i = 0; i < n; ++i) A[i] = freq[sym[i]] ? freq[sym[i]] : 1;
+   defl_min_redundancy(A, n);
+
+   /* limit the code lengths to max_bits, keeping the Kraft sum */
+   for (i = 0; i <= DEFL_MAX_BITS; ++i) count[i] = 0;
+   for (i = 0; i < n; ++i) count[(A[i] > (unsigned int)max_bits) ? (unsigned int)max_bits : A[i]]++;
+   total = 0;
+   for (i = max_bits; i > 0; --i) total += count[i] << (max_bits - i);
+   while (total > (1u << max_bits))
+   {
+      count[max_bits]--;
+      for (i = max_bits - 1; i > 0; --i)
+      {
+         if (count[i])
+         {
+            count[i]--;
+            count[i + 1] += 2;
+            break;
+         }
+      }
+      total--;
+   }
+
+   /* the least frequent symbols get the longest codes */
+   j = 0;
+   for (i = max_bits; i > 0; --i)
+   {
+      unsigned int k;
+      for (k = count[i]; k > 0; --k) lens[sym[j++]] = i;
+   }
+}
+
+/* run length encode the code lengths, returns the number of entries in c->cl_buf */
+static int defl_encode_lengths(struct uzlib_comp *c, const unsigned char *lens, int total)
+{
+   int i = 0, n = 0;
+
+   while (i < total)
+   {
+      int cur = lens[i];
+      int run = 1;
+      while ((i + run < total) && (lens[i + run] == cur)) run++;
+      i += run;
+
+      if (cur == 0)
+      {
+         while (run >= 11)
+         {
+            int r = (run > 138) ? 138 : run;
+            c->cl_buf[n++] = 18 | ((r - 11) << 5);
+            run -= r;
+         }
+         if (run >= 3)
+         {
+            c->cl_buf[n++] = 17 | ((run - 3) << 5);
+            run = 0;
+         }
+      }
+      else
+      {
+         c->cl_buf[n++] = cur;
+         run--;
+         while (run >= 3)
+         {
+            int r = (run > 6) ? 6 : run;
+            c->cl_buf[n++] = 16 | ((r - 3) << 5);
+            run -= r;
+         }
+      }
+      while (run-- > 0) c->cl_buf[n++] = cur;
+   }
+   return n;
+}
+
+/* write the buffered symbols as one deflate block */
+static void defl_flush_block(struct uzlib_comp *c, int last)
+{
+   const unsigned short *lcode, *dcode;
+   const unsigned char *llen, *dlen;
+   unsigned char lens[286 + 30];
+   unsigned char cl_len[19];
+   unsigned short cl_freq[19];
+   unsigned short cl_code[19];
+   unsigned long dyn_bits, fixed_bits;
+   unsigned int i;
+   int hlit, hdist, hclen, ncl = 0;
+
+   /* symbol frequencies */
+   memset(c->freq_l, 0, sizeof(c->freq_l));
+   memset(c->freq_d, 0, sizeof(c->freq_d));
+   for (i = 0; i < c->sym_count; ++i)
+   {
+      unsigned int dist = c->sym_dist[i];
+      if (dist == 0) c->freq_l[c->sym_lit[i]]++;
+      else
+      {
+         c->freq_l[257 + defl_len_code[c->sym_lit[i]]]++;
+         c->freq_d[DEFL_DIST_CODE(dist - 1)]++;
+      }
+   }
+   c->freq_l[256] = 1;
+
+   /* block size with the fixed codes */
+   fixed_bits = 3;
+   for (i = 0; i < 286; ++i) fixed_bits += (unsigned long)c->freq_l[i] * defl_fixed_llen[i];
+   for (i = 0; i < 30; ++i) fixed_bits += (unsigned long)c->freq_d[i] * 5;
+
+   /* block size with the dynamic codes */
+   defl_build_lengths(c, c->freq_l, c->len_l, 286, DEFL_MAX_BITS);
+   defl_build_lengths(c, c->freq_d, c->len_d, 30, DEFL_MAX_BITS);
+   for (hlit = 286; (hlit > 257) && (c->len_l[hlit - 1] == 0); --hlit);
+   for (hdist = 30; (hdist > 1) && (c->len_d[hdist - 1] == 0); --hdist);
+   memcpy(lens, c->len_l, hlit);
+   memcpy(lens + hlit, c->len_d, hdist);
+   ncl = defl_encode_lengths(c, lens, hlit + hdist);
+
+   memset(cl_freq, 0, sizeof(cl_freq));
+   for (i = 0; i < (unsigned int)ncl; ++i) cl_freq[c->cl_buf[i] & 0x1f]++;
+   defl_build_lengths(c, cl_freq, cl_len, 19, DEFL_MAX_CL_BITS);
+   for (hclen = 19; (hclen > 4) && (cl_len[defl_cl_order[hclen - 1]] == 0); --hclen);
+
+   dyn_bits = 3 + 5 + 5 + 4 + 3 * hclen;
+   for (i = 0; i < 19; ++i) dyn_bits += (unsigned long)cl_freq[i] * (cl_len[i] + defl_cl_extra[i]);
+   for (i = 0; i < 286; ++i) dyn_bits += (unsigned long)c->freq_l[i] * c->len_l[i];
+   for (i = 0; i < 30; ++i) dyn_bits += (unsigned long)c->freq_d[i] * c->len_d[i];
+
+   if (dyn_bits < fixed_bits)
+   {
+      defl_gen_codes(c->code_l, c->len_l, 286);
+      defl_gen_codes(c->code_d, c->len_d, 30);
+      defl_gen_codes(cl_code, cl_len, 19);
+
+      defl_put_bits(c, last, 1);
+      defl_put_bits(c, 2, 2);
+      defl_put_bits(c, hlit - 257, 5);
+      defl_put_bits(c, hdist - 1, 5);
+      defl_put_bits(c, hclen - 4, 4);
+      for (i = 0; i < (unsigned int)hclen; ++i) defl_put_bits(c, cl_len[defl_cl_order[i]], 3);
+      for (i = 0; i < (unsigned int)ncl; ++i)
+      {
+         unsigned int sym = c->cl_buf[i] & 0x1f;
+         defl_put_bits(c, cl_code[sym], cl_len[sym]);
+         if (defl_cl_extra[sym]) defl_put_bits(c, c->cl_buf[i] >> 5, defl_cl_extra[sym]);
+      }
+      lcode = c->code_l;
+      llen = c->len_l;
+      dcode = c->code_d;
+      dlen = c->len_d;
+   }
+   else
+   {
+      static const unsigned char fixed_dlen[30] = {
+         5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+         5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5
+      };
+      defl_put_bits(c, last, 1);
+      defl_put_bits(c, 1, 2);
+      lcode = defl_fixed_lcode;
+      llen = defl_fixed_llen;
+      dcode = defl_fixed_dcode;
+      dlen = fixed_dlen;
+   }
+
+   /* compressed data */
+   for (i = 0; i < c->sym_count; ++i)
+   {
+      unsigned int dist = c->sym_dist[i];
+      unsigned int lit = c->sym_lit[i];
+      if (dist == 0) defl_put_bits(c, lcode[lit], llen[lit]);
+      else
+      {
+         unsigned int code = defl_len_code[lit];
+         defl_put_bits(c, lcode[257 + code], llen[257 + code]);
+         if (defl_len_extra[code]) defl_put_bits(c, lit - defl_len_base[code], defl_len_extra[code]);
+         dist--;
+         code = DEFL_DIST_CODE(dist);
+         defl_put_bits(c, dcode[code], dlen[code]);
+         if (defl_dist_extra[code]) defl_put_bits(c, dist - defl_dist_base[code], defl_dist_extra[code]);
+      }
+   }
+   /* end of block */
+   defl_put_bits(c, lcode[256], llen[256]);
+
+   c->sym_count = 0;
+}
+
+static void defl_literal(struct uzlib_comp *c, unsigned char lit)
+{
+   c->sym_lit[c->sym_count] = lit;
+   c->sym_dist[c->sym_count++] = 0;
+   if (c->sym_count == (1u << c->wbits)) defl_flush_block(c, 0);
+}
+
+static void defl_match(struct uzlib_comp *c, unsigned int dist, unsigned int len)
+{
+   c->sym_lit[c->sym_count] = len - DEFL_MIN_MATCH;
+   c->sym_dist[c->sym_count++] = dist;
+   if (c->sym_count == (1u << c->wbits)) defl_flush_block(c, 0);
+}
+
+/* ----------------- *
+ * -- LZ77 stage -- *
+ * ----------------- */
+
+/* insert the string at pos into the hash chains, return the previous head of its chain */
+static inline unsigned int defl_insert(struct uzlib_comp *c, unsigned int pos)
+{
+   const unsigned char *p = c->window + pos;
+   unsigned int h = ((((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2]) * 2654435761u) >> (32 - c->wbits);
+   unsigned int head = c->hash_head[h];
+
+   c->hash_prev[pos & ((1u << c->wbits) - 1)] = head;
+   c->hash_head[h] = pos;
+   return head;
+}
+
+static unsigned int defl_longest_match(struct uzlib_comp *c, unsigned int cur_match)
+{
+   const unsigned char *scan = c->window + c->strstart;
+   unsigned int wsize = 1u << c->wbits;
+   unsigned int limit = (c->strstart > wsize) ? c->strstart - wsize : 0;
+   unsigned int chain = c->max_chain;
+   unsigned int best_len = c->prev_length;
+   unsigned int max_len = (c->lookahead < DEFL_MAX_MATCH) ? c->lookahead : DEFL_MAX_MATCH;
+   unsigned int nice_len = (c->nice_length < max_len) ? c->nice_length : max_len;
+
+   if (best_len >= max_len) return best_len;
+   if (c->prev_length >= c->good_length) chain >>= 2;
+
+   do
+   {
+      const unsigned char *match = c->window + cur_match;
+      unsigned int len;
+
+      if ((match[best_len] != scan[best_len]) || (match[0] != scan[0]) || (match[1] != scan[1])) continue;
+
+      for (len = 2; (len < max_len) && (match[len] == scan[len]); ++len);
+      if (len > best_len)
+      {
+         c->match_start = cur_match;
+         best_len = len;
+         if (len >= nice_len) break;
+      }
+   } while (((cur_match = c->hash_prev[cur_match & (wsize - 1)]) > limit) && (--chain != 0));
+
+   return best_len;
+}
+
+/* drop the older half of the window when it is full */
+static void defl_slide(struct uzlib_comp *c)
+{
+   unsigned int wsize = 1u << c->wbits;
+   unsigned int i;
+
+   memcpy(c->window, c->window + wsize, wsize);
+   c->strstart -= wsize;
+   c->match_start -= wsize;
+   for (i = 0; i < wsize; ++i)
+   {
+      c->hash_head[i] = (c->hash_head[i] >= wsize) ? c->hash_head[i] - wsize : 0;
+      c->hash_prev[i] = (c->hash_prev[i] >= wsize) ? c->hash_prev[i] - wsize : 0;
+   }
+}
+
+/* compress the data in the window, at least DEFL_MIN_LOOKAHEAD bytes are kept unless flushing */
+static void defl_process(struct uzlib_comp *c, bool flush)
+{
+   unsigned int wsize = 1u << c->wbits;
+
+   while (c->lookahead > 0)
+   {
+      unsigned int hash_head = 0;
+
+      if ((c->lookahead < DEFL_MIN_LOOKAHEAD) && (!flush)) break;
+
+      if (c->lookahead >= DEFL_MIN_MATCH) hash_head = defl_insert(c, c->strstart);
+
+      /* find the longest match, discarding those <= prev_length */
+      c->prev_length = c->match_length;
+      c->prev_match = c->match_start;
+      c->match_length = DEFL_MIN_MATCH - 1;
+      if ((hash_head != 0) && (c->prev_length < c->max_lazy) && ((c->strstart - hash_head) < wsize))
+      {
+         c->match_length = defl_longest_match(c, hash_head);
+         if ((c->match_length == DEFL_MIN_MATCH) && ((c->strstart - c->match_start) > DEFL_TOO_FAR))
+         {
+            c->match_length = DEFL_MIN_MATCH - 1;
+         }
+      }
+
+      if ((c->prev_length >= DEFL_MIN_MATCH) && (c->match_length <= c->prev_length))
+      {
+         /* the previous match is better, output it */
+         unsigned int max_insert = c->strstart + c->lookahead - DEFL_MIN_MATCH;
+         unsigned int n = c->prev_length - 2;
+
+         defl_match(c, c->strstart - 1 - c->prev_match, c->prev_length);
+         c->lookahead -= c->prev_length - 1;
+         do
+         {
+            if (++c->strstart <= max_insert) defl_insert(c, c->strstart);
+         } while (--n != 0);
+         c->match_available = false;
+         c->match_length = DEFL_MIN_MATCH - 1;
+         c->strstart++;
+      }
+      else if (c->match_available)
+      {
+         /* no better match, output the previous literal */
+         defl_literal(c, c->window[c->strstart - 1]);
+         c->strstart++;
+         c->lookahead--;
+      }
+      else
+      {
+         /* wait for the next step to decide */
+         c->match_available = true;
+         c->strstart++;
+         c->lookahead--;
+      }
+   }
+
+   if (flush && c->match_available)
+   {
+      defl_literal(c, c->window[c->strstart - 1]);
+      c->match_available = false;
+   }
+}
+
+/* ------------------------------ *
+ * -- compression API functions -- *
+ * ------------------------------ */
+
+void uzlib_compress_init(struct uzlib_comp *c, void *mem, int wbits, int level, int checksum_type)
+{
+   unsigned int wsize = 1u << wbits;
+   unsigned char *p = mem;
+
+   if (!defl_tables_ok) defl_build_tables();
+
+   /* 16-bit arrays first, then the byte arrays */
+   c->hash_head = (unsigned short *)p;
+   p += wsize * sizeof(unsigned short);
+   c->hash_prev = (unsigned short *)p;
+   p += wsize * sizeof(unsigned short);
+   c->sym_dist = (unsigned short *)p;
+   p += wsize * sizeof(unsigned short);
+   c->window = p;
+   p += 2 * wsize;
+   c->sym_lit = p;
+   memset(c->hash_head, 0, wsize * sizeof(unsigned short));
+   memset(c->hash_prev, 0, wsize * sizeof(unsigned short));
+
+   if ((level < 1) || (level > 9)) level = 6;
+   c->good_length = defl_config[level][0];
+   c->max_lazy = defl_config[level][1];
+   c->nice_length = defl_config[level][2];
+   c->max_chain = defl_config[level][3];
+
+   c->wbits = wbits;
+   c->sym_count = 0;
+   c->strstart = 0;
+   c->lookahead = 0;
+   c->match_length = c->prev_length = DEFL_MIN_MATCH - 1;
+   c->match_start = c->prev_match = 0;
+   c->match_available = false;
+   c->bitbuf = 0;
+   c->bitcount = 0;
+   c->outlen = 0;
+   c->total_in = 0;
+
+   c->checksum_type = checksum_type;
+   if (checksum_type == TINF_CHKSUM_ADLER)
+   {
+      /* zlib header, window size and compression level */
+      unsigned int cmf = 0x08 | ((wbits - 8) << 4);
+      unsigned int flg = ((level < 2) ? 0 : (level < 6) ? 1 : (level == 6) ? 2 : 3) << 6;
+      flg |= 31 - (((cmf << 8) | flg) % 31);
+      defl_put_byte(c, cmf);
+      defl_put_byte(c, flg);
+      c->checksum = 1;
+   }
+   else if (checksum_type == TINF_CHKSUM_CRC)
+   {
+      /* gzip header, no file name and modification time */
+      static const unsigned char gz_header[10] = { 0x1f, 0x8b, 0x08, 0, 0, 0, 0, 0, 0, 0xff };
+      for (unsigned int i = 0; i < sizeof(gz_header); ++i) defl_put_byte(c, gz_header[i]);
+      c->checksum = ~0;
+   }
+}
+
+void uzlib_compress_write(struct uzlib_comp *c, const void *data, unsigned int len)
+{
+   const unsigned char *src = data;
+   unsigned int size = 2u << c->wbits;
+
+   if (c->checksum_type == TINF_CHKSUM_ADLER) c->checksum = uzlib_adler32(data, len, c->checksum);
+   else if (c->checksum_type == TINF_CHKSUM_CRC) c->checksum = uzlib_crc32(data, len, c->checksum);
+   c->total_in += len;
+
+   while (len > 0)
+   {
+      unsigned int end = c->strstart + c->lookahead;
+      unsigned int n;
+
+      if (end == size)
+      {
+         defl_slide(c);
+         end -= size >> 1;
+      }
+      n = size - end;
+      if (n > len) n = len;
+      memcpy(c->window + end, src, n);
+      c->lookahead += n;
+      src += n;
+      len -= n;
+      defl_process(c, false);
+   }
+}
+
+void uzlib_compress_flush(struct uzlib_comp *c, int mode)
+{
+   defl_process(c, true);
+   c->match_length = c->prev_length = DEFL_MIN_MATCH - 1;
+
+   if (mode == UZLIB_FLUSH_FINISH)
+   {
+      defl_flush_block(c, 1);
+      defl_align(c);
+      if (c->checksum_type == TINF_CHKSUM_ADLER)
+      {
+         for (int i = 24; i >= 0; i -= 8) defl_put_byte(c, c->checksum >> i);
+      }
+      else if (c->checksum_type == TINF_CHKSUM_CRC)
+      {
+         uint32_t crc = ~c->checksum;
+         for (int i = 0; i < 32; i += 8) defl_put_byte(c, crc >> i);
+         for (int i = 0; i < 32; i += 8) defl_put_byte(c, c->total_in >> i);
+      }
+   }
+   else if (mode == UZLIB_FLUSH_SYNC)
+   {
+      if (c->sym_count) defl_flush_block(c, 0);
+      /* empty stored block, byte aligns the output */
+      defl_put_bits(c, 0, 3);
+      defl_align(c);
+      defl_put_byte(c, 0x00);
+      defl_put_byte(c, 0x00);
+      defl_put_byte(c, 0xff);
+      defl_put_byte(c, 0xff);
+   }
+   defl_flush_output(c);
+}
@@ -143,17 +143,70 @@ int TINFCC uzlib_gzip_parse_header(TINF_DATA *d);
 
 /* Compression API */
 
-typedef const uint8_t *uzlib_hash_entry_t;
+/* Memory needed by the compressor for the window size of 2^wbits (9..15) bytes */
+#define UZLIB_COMP_MEM_SIZE(wbits) (9u << (wbits))
+
+/* uzlib_compress_flush() modes */
+/* flush all pending output and byte align it, the stream can be continued */
+#define UZLIB_FLUSH_SYNC   1
+/* finish the stream, write the checksum trailer */
+#define UZLIB_FLUSH_FINISH 2
 
 struct uzlib_comp {
-    struct Outbuf out;
+    /* Called with each chunk of compressed data, must be set after
+       uzlib_compress_init() and before writing any data */
+    void (*dest_write_cb)(struct uzlib_comp *comp, const unsigned char *data, unsigned int len);
+
+    /* Working buffers, located in the memory passed to uzlib_compress_init() */
+    unsigned short *hash_head;
+    unsigned short *hash_prev;
+    unsigned short *sym_dist;
+    unsigned char *sym_lit;
+    unsigned char *window;
+
+    unsigned int wbits;
+    unsigned int sym_count;
+
+    /* LZ77 state */
+    unsigned int strstart;
+    unsigned int lookahead;
+    unsigned int match_length;
+    unsigned int match_start;
+    unsigned int prev_length;
+    unsigned int prev_match;
+    bool match_available;
+    unsigned short good_length;
+    unsigned short max_lazy;
+    unsigned short nice_length;
+    unsigned short max_chain;
+
+    /* Huffman stage */
+    unsigned short freq_l[286];
+    unsigned short freq_d[30];
+    unsigned short code_l[286];
+    unsigned short code_d[30];
+    unsigned char len_l[286];
+    unsigned char len_d[30];
+    unsigned short cl_buf[286 + 30];
+    unsigned short huff_sym[286];
+    unsigned int huff_work[286];
+
+    /* Output */
+    uint32_t bitbuf;
+    unsigned int bitcount;
+    unsigned int outlen;
+    unsigned char outbuf[128];
 
-    uzlib_hash_entry_t *hash_table;
-    unsigned int hash_bits;
-    unsigned int dict_size;
+    uint32_t checksum;
+    uint32_t total_in;
+    char checksum_type;
 };
 
-void TINFCC uzlib_compress(struct uzlib_comp *c, const uint8_t *src, unsigned slen);
+/* checksum_type selects the format: TINF_CHKSUM_NONE - raw deflate,
+   TINF_CHKSUM_ADLER - zlib, TINF_CHKSUM_CRC - gzip */
+void TINFCC uzlib_compress_init(struct uzlib_comp *c, void *mem, int wbits, int level, int checksum_type);
+void TINFCC uzlib_compress_write(struct uzlib_comp *c, const void *data, unsigned int len);
+void TINFCC uzlib_compress_flush(struct uzlib_comp *c, int mode);
 
 /* Checksum API */
 
@@ -0,0 +1,320 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "py/compile.h"
+#include "py/runtime.h"
+#include "py/gc.h"
+#include "py/stackctrl.h"
+#include "py/lexer.h"
+#include "py/stream.h"
+#include "py/mperrno.h"
+#include "py/mphal.h"
+#include "py/builtin.h"
+#include "py/emitglue.h"
+
+static char *stack_top;
+
+mp_uint_t mp_hal_ticks_us(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000LL + t.tv_nsec / 1000;
+}
+
+void mp_hal_stdout_tx_strn_cooked(const char *str, size_t len) {
+    fwrite(str, 1, len, stdout);
+}
+
+// ==== host module, used by the tests and benchmarks ====
+
+// host file stream, 'counted' counts the read and write calls
+typedef struct _host_file_obj_t {
+    mp_obj_base_t base;
+    FILE *f;
+    bool counted;
+} host_file_obj_t;
+
+static unsigned long host_stream_calls = 0;
+
+STATIC mp_uint_t host_file_read(mp_obj_t self_in, void *buf, mp_uint_t size, int *errcode) {
+    host_file_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->counted) {
+        host_stream_calls++;
+    }
+    return fread(buf, 1, size, self->f);
+}
+
+STATIC mp_uint_t host_file_write(mp_obj_t self_in, const void *buf, mp_uint_t size, int *errcode) {
+    host_file_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->counted) {
+        host_stream_calls++;
+    }
+    return fwrite(buf, 1, size, self->f);
+}
+
+STATIC mp_uint_t host_file_ioctl(mp_obj_t self_in, mp_uint_t request, uintptr_t arg, int *errcode) {
+    host_file_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (request == MP_STREAM_CLOSE) {
+        if (self->f) {
+            fclose(self->f);
+            self->f = NULL;
+        }
+        return 0;
+    }
+    if (request == MP_STREAM_FLUSH) {
+        fflush(self->f);
+        return 0;
+    }
+    *errcode = MP_EINVAL;
+    return MP_STREAM_ERROR;
+}
+
+STATIC const mp_rom_map_elem_t host_file_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_read), MP_ROM_PTR(&mp_stream_read_obj) },
+    { MP_ROM_QSTR(MP_QSTR_readinto), MP_ROM_PTR(&mp_stream_readinto_obj) },
+    { MP_ROM_QSTR(MP_QSTR_write), MP_ROM_PTR(&mp_stream_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_flush), MP_ROM_PTR(&mp_stream_flush_obj) },
+    { MP_ROM_QSTR(MP_QSTR_close), MP_ROM_PTR(&mp_stream_close_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(host_file_locals_dict, host_file_locals_dict_table);
+
+STATIC const mp_stream_p_t host_file_stream_p = {
+    .read = host_file_read,
+    .write = host_file_write,
+    .ioctl = host_file_ioctl,
+};
+
+STATIC const mp_obj_type_t host_file_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_file,
+    .protocol = &host_file_stream_p,
+    .locals_dict = (mp_obj_dict_t*)&host_file_locals_dict,
+};
+
+STATIC mp_obj_t host_file_open(mp_obj_t name, mp_obj_t mode, bool counted) {
+    host_file_obj_t *o = m_new_obj(host_file_obj_t);
+    o->base.type = &host_file_type;
+    o->counted = counted;
+    o->f = fopen(mp_obj_str_get_str(name), mp_obj_str_get_str(mode));
+    if (o->f == NULL) {
+        mp_raise_OSError(MP_ENOENT);
+    }
+    return MP_OBJ_FROM_PTR(o);
+}
+
+// file(name, mode): host file stream
+STATIC mp_obj_t host_file(mp_obj_t name, mp_obj_t mode) {
+    return host_file_open(name, mode, false);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(host_file_obj, host_file);
+
+// cfile(name, mode): host file stream which counts the read and write calls
+STATIC mp_obj_t host_cfile(mp_obj_t name, mp_obj_t mode) {
+    return host_file_open(name, mode, true);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(host_cfile_obj, host_cfile);
+
+// calls(): number of the cfile read and write calls since the last call
+STATIC mp_obj_t host_calls(void) {
+    mp_obj_t res = mp_obj_new_int_from_uint(host_stream_calls);
+    host_stream_calls = 0;
+    return res;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(host_calls_obj, host_calls);
+
+// ticks_us(): monotonic time in microseconds
+STATIC mp_obj_t host_ticks_us(void) {
+    return mp_obj_new_int_from_uint(mp_hal_ticks_us());
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(host_ticks_us_obj, host_ticks_us);
+
+// used(): bytes of the GC heap in use
+STATIC mp_obj_t host_used(void) {
+    gc_info_t info;
+    gc_info(&info);
+    return mp_obj_new_int_from_uint(info.used);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(host_used_obj, host_used);
+
+// xip(): True if the XIP module image is used
+STATIC mp_obj_t host_xip(void) {
+    return mp_obj_new_bool(MP_STATE_VM(frozen_xip_image) != NULL);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(host_xip_obj, host_xip);
+
+STATIC const mp_rom_map_elem_t host_module_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_host) },
+    { MP_ROM_QSTR(MP_QSTR_file), MP_ROM_PTR(&host_file_obj) },
+    { MP_ROM_QSTR(MP_QSTR_cfile), MP_ROM_PTR(&host_cfile_obj) },
+    { MP_ROM_QSTR(MP_QSTR_calls), MP_ROM_PTR(&host_calls_obj) },
+    { MP_ROM_QSTR(MP_QSTR_ticks_us), MP_ROM_PTR(&host_ticks_us_obj) },
+    { MP_ROM_QSTR(MP_QSTR_used), MP_ROM_PTR(&host_used_obj) },
+    { MP_ROM_QSTR(MP_QSTR_xip), MP_ROM_PTR(&host_xip_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(host_module_globals, host_module_globals_table);
+
+const mp_obj_module_t mp_module_host = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t*)&host_module_globals,
+};
+
+mp_obj_t mp_builtin_open(size_t n_args, const mp_obj_t *args, mp_map_t *kwargs) {
+    return host_file(args[0], (n_args > 1) ? args[1] : MP_OBJ_NEW_QSTR(MP_QSTR_r));
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(mp_builtin_open_obj, 1, mp_builtin_open);
+
+// ==== GC ====
+
+#if MICROPY_GC_PARALLEL_MARK
+// The helper marker runs in its own thread, as on the other K210 core
+static MICROPY_GC_STACK_ENTRY_TYPE gc_helper_stack[MICROPY_ALLOC_GC_STACK_SIZE];
+
+static void *gc_helper_thread(void *arg) {
+    gc_mark_helper(gc_helper_stack);
+    return NULL;
+}
+
+void gc_mark_helper_start(void) {
+    if (!MP_STATE_MEM(gc_mark_parallel)) {
+        return;
+    }
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, gc_helper_thread, NULL) == 0) {
+        pthread_detach(thread);
+    }
+}
+#endif
+
+void host_vm_loop_hook(void) {
+    #if MICROPY_GC_LAZY_SWEEP
+    gc_sweep_step();
+    #endif
+    #if MICROPY_GC_INCREMENTAL
+    gc_mark_step();
+    #endif
+}
+
+void gc_collect(void) {
+    gc_collect_start();
+    // the registers are pushed on the stack by setjmp
+    jmp_buf regs;
+    setjmp(regs);
+    gc_collect_root((void**)&regs, ((uintptr_t)stack_top - (uintptr_t)&regs) / sizeof(uintptr_t));
+    gc_collect_end();
+}
+
+mp_import_stat_t mp_import_stat(const char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return MP_IMPORT_STAT_NO_EXIST;
+    }
+    return S_ISDIR(st.st_mode) ? MP_IMPORT_STAT_DIR : MP_IMPORT_STAT_FILE;
+}
+
+// ==== XIP module image ====
+
+// no modules are frozen in the firmware
+const char mp_frozen_mpy_names[] = "\0";
+const mp_raw_code_t *const mp_frozen_mpy_content[] = { NULL };
+
+const unsigned char *host_xip_image = NULL;
+
+// The image created by 'make xipimg' stands in for the memory mapped flash
+static unsigned char *host_xip_load(const char *name) {
+    FILE *f = fopen(name, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char *image = malloc(size);
+    if ((image != NULL) && (fread(image, 1, size, f) != (size_t)size)) {
+        free(image);
+        image = NULL;
+    }
+    fclose(f);
+    return image;
+}
+
+void nlr_jump_fail(void *val) {
+    fprintf(stderr, "FATAL: uncaught NLR %p\n", val);
+    exit(1);
+}
+
+// mphost script.py [heap_size]
+int main(int argc, char **argv) {
+    int stack_dummy;
+    stack_top = (char*)&stack_dummy;
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s script.py [heap_size]\n", argv[0]);
+        return 2;
+    }
+    size_t heap_size = (argc > 2) ? strtoul(argv[2], NULL, 0) : (1 << 20);
+    char *heap = malloc(heap_size);
+
+    unsigned char *xip_image = NULL;
+    if (getenv("MPHOST_XIPIMG") != NULL) {
+        xip_image = host_xip_load(getenv("MPHOST_XIPIMG"));
+        if (xip_image == NULL) {
+            fprintf(stderr, "%s: XIP image not loaded\n", getenv("MPHOST_XIPIMG"));
+            return 2;
+        }
+    }
+    host_xip_image = xip_image;
+
+    mp_stack_set_limit(1 << 20);
+    gc_init(heap, heap + heap_size);
+    mp_init();
+    mp_obj_list_init(MP_OBJ_TO_PTR(mp_sys_path), 0);
+    mp_obj_list_init(MP_OBJ_TO_PTR(mp_sys_argv), 0);
+
+    int ret = 0;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_lexer_t *lex = mp_lexer_new_from_file(argv[1]);
+        qstr source_name = lex->source_name;
+        mp_parse_tree_t parse_tree = mp_parse(lex, MP_PARSE_FILE_INPUT);
+        mp_obj_t module_fun = mp_compile(&parse_tree, source_name, MP_EMIT_OPT_NONE, false);
+        mp_call_function_0(module_fun);
+        nlr_pop();
+    } else {
+        mp_obj_print_exception(&mp_plat_print, (mp_obj_t)nlr.ret_val);
+        ret = 1;
+    }
+    mp_deinit();
+    free(heap);
+    free(xip_image);
+    return ret;
+}
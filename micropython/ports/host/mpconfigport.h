@@ -0,0 +1,131 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 LoBo (https://github.com/loboris)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Host port configuration
+// The core options added for the K210 port are enabled as in k210-freertos/mpy_support/mpconfigport.h,
+// each one can be changed from the command line: make CFLAGS_EXTRA=-DMICROPY_xxx=0
+
+#include <stdint.h>
+
+#define MICROPY_ALLOC_PATH_MAX      (256)
+#define MICROPY_ENABLE_COMPILER     (1)
+#define MICROPY_ENABLE_GC           (1)
+#define MICROPY_ENABLE_FINALISER    (1)
+#define MICROPY_HELPER_LEXER_UNIX   (1)
+#define MICROPY_READER_POSIX        (1)
+#define MICROPY_GCREGS_SETJMP       (1)
+#define MICROPY_NLR_SETJMP          (1)
+#define MICROPY_LONGINT_IMPL        (MICROPY_LONGINT_IMPL_MPZ)
+#define MICROPY_FLOAT_IMPL          (MICROPY_FLOAT_IMPL_FLOAT)
+#define MICROPY_ERROR_REPORTING     (MICROPY_ERROR_REPORTING_DETAILED)
+#define MICROPY_ENABLE_SOURCE_LINE  (1)
+#define MICROPY_CPYTHON_COMPAT      (1)
+#define MICROPY_USE_INTERNAL_PRINTF (0)
+
+#define MICROPY_PY_BUILTINS_STR_UNICODE (1)
+#define MICROPY_PY_BUILTINS_BYTEARRAY (1)
+#define MICROPY_PY_BUILTINS_MEMORYVIEW (1)
+#define MICROPY_PY_BUILTINS_FLOAT   (1)
+#define MICROPY_PY_IO               (1)
+#define MICROPY_PY_GC               (1)
+#define MICROPY_PY_GC_COLLECT_RETVAL (1)
+#define MICROPY_PY_SYS              (1)
+#define MICROPY_PY_MICROPYTHON_MEM_INFO (1)
+#define MICROPY_PY_UTIME_MP_HAL     (0)
+#define MICROPY_PY_COLLECTIONS      (1)
+#define MICROPY_PY_ARRAY            (1)
+#define MICROPY_PY_STRUCT           (1)
+#define MICROPY_PY_UJSON            (1)
+#define MICROPY_PY_UZLIB            (1)
+#define MICROPY_PY_URE              (1)
+
+// K210 port options
+#ifndef MICROPY_OPT_INLINE_CACHE
+#define MICROPY_OPT_INLINE_CACHE    (1)
+#endif
+#ifndef MICROPY_GC_NOSCAN
+#define MICROPY_GC_NOSCAN           (1)
+#endif
+#ifndef MICROPY_GC_PARALLEL_MARK
+#define MICROPY_GC_PARALLEL_MARK    (1)
+#endif
+#ifndef MICROPY_GC_LAZY_SWEEP
+#define MICROPY_GC_LAZY_SWEEP       (1)
+#endif
+#ifndef MICROPY_GC_FREE_INDEX
+#define MICROPY_GC_FREE_INDEX       (1)
+#endif
+#ifndef MICROPY_GC_INCREMENTAL
+#define MICROPY_GC_INCREMENTAL      (1)
+#endif
+#ifndef MICROPY_PY_UJSON_STREAM
+#define MICROPY_PY_UJSON_STREAM     (1)
+#endif
+#ifndef MICROPY_PY_UZLIB_COMPRESS
+#define MICROPY_PY_UZLIB_COMPRESS   (1)
+#endif
+
+// .mpy files are imported from the current directory, the XIP module image
+// is loaded from the file given by MPHOST_XIPIMG (see perf/xip_import.py)
+#define MICROPY_PERSISTENT_CODE_LOAD (1)
+#define MICROPY_MODULE_FROZEN_MPY   (1)
+#define MICROPY_MODULE_FROZEN_XIP   (1)
+#define MICROPY_MODULE_FROZEN_XIP_IMAGE (host_xip_image)
+extern const unsigned char *host_xip_image;
+
+#define MP_SSIZE_MAX                (0x7fffffffffffffff)
+
+typedef long mp_int_t;
+typedef unsigned long mp_uint_t;
+typedef long mp_off_t;
+
+#define MP_PLAT_PRINT_STRN(str, len) fwrite(str, 1, len, stdout)
+
+#define MICROPY_PORT_BUILTINS \
+    { MP_ROM_QSTR(MP_QSTR_open), MP_ROM_PTR(&mp_builtin_open_obj) },
+
+extern const struct _mp_obj_module_t mp_module_host;
+#define MICROPY_PORT_BUILTIN_MODULES \
+    { MP_ROM_QSTR(MP_QSTR_host), MP_ROM_PTR(&mp_module_host) },
+
+// 're' is used by microWebTemplate.py in the XIP import benchmark
+#define MICROPY_MODULE_WEAK_LINKS   (1)
+extern const struct _mp_obj_module_t mp_module_ure;
+#define MICROPY_PORT_BUILTIN_MODULE_WEAK_LINKS \
+    { MP_ROM_QSTR(MP_QSTR_re), MP_ROM_PTR(&mp_module_ure) },
+
+// the GC slices are continued between the bytecodes, as by vm_loop_hook() on the K210
+#define MICROPY_VM_HOOK_LOOP        host_vm_loop_hook();
+void host_vm_loop_hook(void);
+
+#define MICROPY_HW_BOARD_NAME "host"
+#define MICROPY_HW_MCU_NAME "host"
+
+#define MP_STATE_PORT MP_STATE_VM
+#define MICROPY_PORT_ROOT_POINTERS
+
+#include <alloca.h>
+#include <stdio.h>
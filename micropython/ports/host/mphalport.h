@@ -0,0 +1 @@
+// empty file, mp_hal_ticks_us() is declared in py/mphal.h
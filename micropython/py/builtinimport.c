@@ -181,6 +181,109 @@ STATIC void do_execute_raw_code(mp_obj_t module_obj, mp_raw_code_t *raw_code) {
 }
 #endif
 
+#if MICROPY_MODULE_CACHE_MPY
+
+#if !MICROPY_PERSISTENT_CODE_LOAD || !MICROPY_PERSISTENT_CODE_SAVE || !MICROPY_VFS
+#error MICROPY_MODULE_CACHE_MPY requires MICROPY_PERSISTENT_CODE_LOAD, MICROPY_PERSISTENT_CODE_SAVE and MICROPY_VFS
+#endif
+
+#include "extmod/vfs.h"
+
+#define CACHE_DIR "__pycache__"
+
+// Remove the other (outdated) cached versions of the module
+// 'prefix_len' is the length of "<dir>/__pycache__/<name>."
+STATIC void cache_remove_stale(const char *cache_str, size_t dir_len, size_t prefix_len) {
+    mp_obj_t dir = mp_obj_new_str(cache_str, dir_len);
+    mp_obj_t list = mp_vfs_listdir(1, &dir);
+    size_t n;
+    mp_obj_t *items;
+    mp_obj_list_get(list, &n, &items);
+    const char *prefix = cache_str + dir_len + 1;
+    size_t name_len = prefix_len - dir_len - 1;
+    for (size_t i = 0; i < n; ++i) {
+        size_t len;
+        const char *name = mp_obj_str_get_data(items[i], &len);
+        if (len > name_len + 4 && memcmp(name, prefix, name_len) == 0
+            && memcmp(name + len - 4, ".mpy", 4) == 0
+            && (len != strlen(prefix) || memcmp(name, prefix, len) != 0)) {
+            vstr_t path;
+            vstr_init(&path, dir_len + 1 + len);
+            vstr_add_strn(&path, cache_str, dir_len + 1);
+            vstr_add_strn(&path, name, len);
+            mp_vfs_remove(mp_obj_new_str(path.buf, path.len));
+            vstr_clear(&path);
+        }
+    }
+}
+
+// Load the module's raw code from the cache, or compile the source file and
+// save it to the cache. Returns NULL if the cache can not be used for the file.
+STATIC mp_raw_code_t *do_load_cached(const char *file_str, size_t file_len) {
+    // the file modification time identifies the cached version
+    mp_int_t mtime = 0;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_obj_tuple_t *st = MP_OBJ_TO_PTR(mp_vfs_stat(mp_obj_new_str(file_str, file_len)));
+        mtime = mp_obj_get_int(st->items[8]);
+        nlr_pop();
+    }
+    if (mtime <= 0) {
+        return NULL;
+    }
+
+    // <dir>/__pycache__/<name>.<mtime>.mpy
+    const char *name = strrchr(file_str, PATH_SEP_CHAR);
+    name = (name == NULL) ? file_str : name + 1;
+    vstr_t cache;
+    vstr_init(&cache, file_len + 32);
+    vstr_add_strn(&cache, file_str, name - file_str);
+    vstr_add_str(&cache, CACHE_DIR);
+    size_t dir_len = cache.len;
+    vstr_add_char(&cache, PATH_SEP_CHAR);
+    vstr_add_strn(&cache, name, file_str + file_len - 3 - name);
+    vstr_add_char(&cache, '.');
+    size_t prefix_len = cache.len;
+    vstr_printf(&cache, INT_FMT ".mpy", mtime);
+    const char *cache_str = vstr_null_terminated_str(&cache);
+
+    mp_raw_code_t *raw_code = NULL;
+    if (mp_import_stat(cache_str) == MP_IMPORT_STAT_FILE) {
+        if (nlr_push(&nlr) == 0) {
+            raw_code = mp_raw_code_load_file(cache_str);
+            nlr_pop();
+        } else {
+            // invalid or incompatible cache file, it will be replaced
+            raw_code = NULL;
+        }
+    }
+
+    if (raw_code == NULL) {
+        // compile the source, errors are reported as usual
+        mp_lexer_t *lex = mp_lexer_new_from_file(file_str);
+        qstr source_name = lex->source_name;
+        mp_parse_tree_t parse_tree = mp_parse(lex, MP_PARSE_FILE_INPUT);
+        raw_code = mp_compile_to_raw_code(&parse_tree, source_name, MP_EMIT_OPT_NONE, false);
+
+        // saving to the cache is optional (read-only or full file system...)
+        if (nlr_push(&nlr) == 0) {
+            vstr_t dir;
+            vstr_init(&dir, dir_len + 1);
+            vstr_add_strn(&dir, cache.buf, dir_len);
+            if (mp_import_stat(vstr_null_terminated_str(&dir)) != MP_IMPORT_STAT_DIR) {
+                mp_vfs_mkdir(mp_obj_new_str(dir.buf, dir.len));
+            }
+            vstr_clear(&dir);
+            mp_raw_code_save_file(raw_code, cache_str);
+            cache_remove_stale(cache_str, dir_len, prefix_len);
+            nlr_pop();
+        }
+    }
+    vstr_clear(&cache);
+    return raw_code;
+}
+#endif
+
 STATIC void do_load(mp_obj_t module_obj, vstr_t *file) {
     #if MICROPY_MODULE_FROZEN || MICROPY_ENABLE_COMPILER || (MICROPY_PERSISTENT_CODE_LOAD && MICROPY_HAS_FILE_READER)
     char *file_str = vstr_null_terminated_str(file);
@@ -221,6 +324,19 @@ STATIC void do_load(mp_obj_t module_obj, vstr_t *file) {
     }
     #endif
 
+    // If the compiled modules are cached then load the module from the cache,
+    // compiling and saving it first if needed.
+    #if MICROPY_MODULE_CACHE_MPY
+    mp_raw_code_t *cached_code = do_load_cached(file_str, file->len);
+    if (cached_code != NULL) {
+        #if MICROPY_PY___FILE__
+        mp_store_attr(module_obj, MP_QSTR___file__, MP_OBJ_NEW_QSTR(qstr_from_strn(file_str, file->len)));
+        #endif
+        do_execute_raw_code(module_obj, cached_code);
+        return;
+    }
+    #endif
+
     // If we can compile scripts then load the file and compile and execute it.
     #if MICROPY_ENABLE_COMPILER
     {
@@ -96,6 +96,101 @@ STATIC const mp_raw_code_t *mp_find_frozen_mpy(const char *str, size_t len) {
 
 #endif
 
+#if MICROPY_MODULE_FROZEN_XIP
+
+#include "py/mpstate.h"
+#include "py/persistentcode.h"
+
+#if !MICROPY_MODULE_FROZEN_MPY || MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
+#error MICROPY_MODULE_FROZEN_XIP requires MICROPY_MODULE_FROZEN_MPY and read-only bytecode
+#endif
+
+#define MP_FROZEN_XIP_VERSION (1)
+
+// Header of the XIP module image, as created by tools/mpy-tool.py -x
+// All offsets are from the start of the image.
+typedef struct _mp_frozen_xip_header_t {
+    byte magic[4];          // "MPXI"
+    byte mpy_header[4];     // same as at the start of an .mpy file
+    byte version;
+    byte qstr_bytes_in_hash;
+    byte qstr_bytes_in_len;
+    byte reserved;
+    uint32_t size;
+    uint32_t qstr_base;     // number of the first qstr in the image
+    uint32_t qstr_check;    // checksum of the firmware qstrs below qstr_base
+    uint32_t n_qstr;
+    uint32_t qstr_table;    // offsets of the qstr data (hash, length, chars, 0)
+    uint32_t n_module;
+    uint32_t names;         // module names, in the same format as mp_frozen_mpy_names
+    uint32_t module_table;  // offsets of the module raw code data
+} mp_frozen_xip_header_t;
+
+// The bytecode in the image has the qstr numbers of the firmware it was built
+// against, so it can only be used if all firmware qstrs are the same
+STATIC uint32_t frozen_xip_qstr_check(size_t n) {
+    uint32_t check = 5381;
+    for (size_t q = 1; q < n; ++q) {
+        check = check * 33 + qstr_hash(q) + (qstr_len(q) << 8);
+    }
+    return check;
+}
+
+// Register the image qstrs, must be called right after qstr_init()
+void mp_frozen_xip_init(void) {
+    MP_STATE_VM(frozen_xip_image) = NULL;
+    const mp_frozen_xip_header_t *hdr = (const mp_frozen_xip_header_t*)(MICROPY_MODULE_FROZEN_XIP_IMAGE);
+    if (hdr == NULL
+        || memcmp(hdr->magic, "MPXI", 4) != 0
+        || hdr->version != MP_FROZEN_XIP_VERSION
+        || hdr->qstr_bytes_in_hash != MICROPY_QSTR_BYTES_IN_HASH
+        || hdr->qstr_bytes_in_len != MICROPY_QSTR_BYTES_IN_LEN
+        || !mp_raw_code_xip_header_ok(hdr->mpy_header)
+        || hdr->qstr_base != QSTR_TOTAL()
+        || hdr->qstr_check != frozen_xip_qstr_check(hdr->qstr_base)) {
+        return;
+    }
+    const byte *image = (const byte*)hdr;
+    if (hdr->n_qstr > 0) {
+        // only the table of pointers is in RAM, the qstr data stays in the image
+        qstr_pool_t *pool = m_new_obj_var_maybe(qstr_pool_t, const byte*, hdr->n_qstr);
+        if (pool == NULL) {
+            return;
+        }
+        const uint32_t *qstr_table = (const uint32_t*)(image + hdr->qstr_table);
+        for (size_t i = 0; i < hdr->n_qstr; ++i) {
+            pool->qstrs[i] = image + qstr_table[i];
+        }
+        pool->len = hdr->n_qstr;
+        qstr_add_pool(pool);
+    }
+    MP_STATE_VM(frozen_xip_image) = image;
+}
+
+STATIC const char *frozen_xip_names(void) {
+    const byte *image = MP_STATE_VM(frozen_xip_image);
+    if (image == NULL) {
+        return "";
+    }
+    return (const char*)image + ((const mp_frozen_xip_header_t*)image)->names;
+}
+
+STATIC const byte *mp_find_frozen_xip(const char *str, size_t len) {
+    const byte *image = MP_STATE_VM(frozen_xip_image);
+    const char *name = frozen_xip_names();
+    for (size_t i = 0; *name != 0; i++) {
+        size_t l = strlen(name);
+        if (l == len && !memcmp(str, name, l)) {
+            const uint32_t *module_table = (const uint32_t*)(image + ((const mp_frozen_xip_header_t*)image)->module_table);
+            return image + module_table[i];
+        }
+        name += l + 1;
+    }
+    return NULL;
+}
+
+#endif
+
 #if MICROPY_MODULE_FROZEN
 
 STATIC mp_import_stat_t mp_frozen_stat_helper(const char *name, const char *str) {
@@ -132,6 +227,13 @@ mp_import_stat_t mp_frozen_stat(const char *str) {
     }
     #endif
 
+    #if MICROPY_MODULE_FROZEN_XIP
+    stat = mp_frozen_stat_helper(frozen_xip_names(), str);
+    if (stat != MP_IMPORT_STAT_NO_EXIST) {
+        return stat;
+    }
+    #endif
+
     return MP_IMPORT_STAT_NO_EXIST;
 }
 
@@ -150,6 +252,14 @@ int mp_find_frozen_module(const char *str, size_t len, void **data) {
         return MP_FROZEN_MPY;
     }
     #endif
+    #if MICROPY_MODULE_FROZEN_XIP
+    const byte *xip_data = mp_find_frozen_xip(str, len);
+    if (xip_data != NULL) {
+        // only the raw code structures and constants are created in RAM
+        *data = mp_raw_code_load_xip(xip_data);
+        return MP_FROZEN_MPY;
+    }
+    #endif
     return MP_FROZEN_NONE;
 }
 
@@ -38,5 +38,8 @@ enum {
 int mp_find_frozen_module(const char *str, size_t len, void **data);
 const char *mp_find_frozen_str(const char *str, size_t *len);
 mp_import_stat_t mp_frozen_stat(const char *str);
+#if MICROPY_MODULE_FROZEN_XIP
+void mp_frozen_xip_init(void);
+#endif
 
 #endif // MICROPY_INCLUDED_PY_FROZENMOD_H
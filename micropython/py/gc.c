@@ -32,6 +32,12 @@
 
 #include "py/gc.h"
 #include "py/runtime.h"
+#if MICROPY_GC_LAZY_SWEEP
+#include "py/mphal.h"
+#endif
+#if MICROPY_GC_INCREMENTAL_VERIFY
+#include <stdlib.h>
+#endif
 
 #if MICROPY_ENABLE_GC
 
@@ -79,9 +85,9 @@ extern const mp_print_t mp_debug_print;
 
 #define BLOCK_SHIFT(block) (2 * ((block) & (BLOCKS_PER_ATB - 1)))
 #define ATB_GET_KIND(block) ((MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB] >> BLOCK_SHIFT(block)) & 3)
-#define ATB_ANY_TO_FREE(block) do { MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB] &= (~(AT_MARK << BLOCK_SHIFT(block))); } while (0)
-#define ATB_FREE_TO_HEAD(block) do { MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB] |= (AT_HEAD << BLOCK_SHIFT(block)); } while (0)
-#define ATB_FREE_TO_TAIL(block) do { MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB] |= (AT_TAIL << BLOCK_SHIFT(block)); } while (0)
+#define ATB_ANY_TO_FREE(block) do { MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB] &= (~(AT_MARK << BLOCK_SHIFT(block))); FRI_SET_DIRTY(block); } while (0)
+#define ATB_FREE_TO_HEAD(block) do { MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB] |= (AT_HEAD << BLOCK_SHIFT(block)); FRI_SET_DIRTY(block); } while (0)
+#define ATB_FREE_TO_TAIL(block) do { MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB] |= (AT_TAIL << BLOCK_SHIFT(block)); FRI_SET_DIRTY(block); } while (0)
 #define ATB_HEAD_TO_MARK(block) do { MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB] |= (AT_MARK << BLOCK_SHIFT(block)); } while (0)
 #define ATB_MARK_TO_HEAD(block) do { MP_STATE_MEM(gc_alloc_table_start)[(block) / BLOCKS_PER_ATB] &= (~(AT_TAIL << BLOCK_SHIFT(block))); } while (0)
 
@@ -89,6 +95,38 @@ extern const mp_print_t mp_debug_print;
 #define PTR_FROM_BLOCK(block) (((block) * BYTES_PER_BLOCK + (uintptr_t)MP_STATE_MEM(gc_pool_start)))
 #define ATB_FROM_BLOCK(bl) ((bl) / BLOCKS_PER_ATB)
 
+#if MICROPY_GC_LAZY_SWEEP
+// the heads not yet reached by the lazy sweep are still marked
+#define ATB_IS_HEAD(block) (ATB_GET_KIND(block) & AT_HEAD)
+#define GC_SWEEP_PENDING() (MP_STATE_MEM(gc_sweep_block) < MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB)
+// number of blocks swept between the checks of the sweep time limit
+#define GC_SWEEP_CHUNK (256)
+#else
+#define ATB_IS_HEAD(block) (ATB_GET_KIND(block) == AT_HEAD)
+#endif
+
+#if MICROPY_GC_INCREMENTAL
+#if !MICROPY_GC_LAZY_SWEEP || !MICROPY_GC_ALLOC_THRESHOLD
+#error MICROPY_GC_INCREMENTAL requires MICROPY_GC_LAZY_SWEEP and MICROPY_GC_ALLOC_THRESHOLD
+#endif
+// Incremental mark phase (snapshot at the beginning)
+// START:   the next collection only marks the roots and the blocks they point to
+// MARKING: the grey blocks are checked in slices, the write barriers mark the
+//          overwritten pointers, the new blocks are allocated marked
+// FINISH:  the collection checks the rest of the grey blocks, traces the roots
+//          again and starts the sweep
+#define GC_INC_IDLE (0)
+#define GC_INC_START (1)
+#define GC_INC_MARKING (2)
+#define GC_INC_FINISH (3)
+// number of the checked blocks between the checks of the mark slice time limit
+#define GC_GREY_CHUNK (16)
+// larger blocks are checked in parts of this many words
+#define GC_GREY_WORDS (1024)
+
+int gc_inc_marking = 0;
+#endif
+
 #if MICROPY_ENABLE_FINALISER
 // FTB = finaliser table byte
 // if set, then the corresponding block may have a finaliser
@@ -100,6 +138,43 @@ extern const mp_print_t mp_debug_print;
 #define FTB_CLEAR(block) do { MP_STATE_MEM(gc_finaliser_table_start)[(block) / BLOCKS_PER_FTB] &= (~(1 << ((block) & 7))); } while (0)
 #endif
 
+#if MICROPY_GC_NOSCAN
+// NTB = no-scan table byte
+// if set, then the corresponding block is marked but its content is never
+// scanned for the heap pointers (bytes, bytearray and array data, buffers)
+// The ATB has no free state left for this, so a separate bit table is used
+
+#define BLOCKS_PER_NTB (8)
+
+#define NTB_GET(block) ((MP_STATE_MEM(gc_noscan_table_start)[(block) / BLOCKS_PER_NTB] >> ((block) & 7)) & 1)
+#define NTB_SET(block) do { MP_STATE_MEM(gc_noscan_table_start)[(block) / BLOCKS_PER_NTB] |= (1 << ((block) & 7)); } while (0)
+#define NTB_CLEAR(block) do { MP_STATE_MEM(gc_noscan_table_start)[(block) / BLOCKS_PER_NTB] &= (~(1 << ((block) & 7))); } while (0)
+#else
+#define NTB_GET(block) (0)
+#define NTB_CLEAR(block)
+#endif
+
+#if MICROPY_GC_FREE_INDEX
+// FRI = free run index
+// for each chunk of BLOCKS_PER_FRI blocks: the length of the free run at the start
+// of the chunk, at the end of the chunk and the longest free run in the chunk
+// Any change of the free blocks in the chunk marks the entry dirty, it is
+// recomputed when needed by gc_alloc
+
+#define BLOCKS_PER_FRI (256)
+#define FRI_PREFIX (0)
+#define FRI_SUFFIX (1)
+#define FRI_MAX (2)
+#define FRI_ENTRY_LEN (3)
+#define FRI_DIRTY (0xffff)
+// allocations of less blocks scan the ATB from gc_last_free_atb_index
+#define FRI_MIN_BLOCKS (8)
+
+#define FRI_SET_DIRTY(block) (MP_STATE_MEM(gc_free_index)[(block) / BLOCKS_PER_FRI * FRI_ENTRY_LEN + FRI_MAX] = FRI_DIRTY)
+#else
+#define FRI_SET_DIRTY(block)
+#endif
+
 #if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
 #define GC_ENTER() mp_thread_mutex_lock(&MP_STATE_MEM(gc_mutex), 1)
 #define GC_EXIT() mp_thread_mutex_unlock(&MP_STATE_MEM(gc_mutex))
@@ -114,32 +189,51 @@ void gc_init(void *start, void *end) {
     end = (void*)((uintptr_t)end & (~(BYTES_PER_BLOCK - 1)));
     DEBUG_GC_printf("Initializing GC heap: %p..%p = " UINT_FMT " bytes\r\n", start, end, (byte*)end - (byte*)start);
 
-    // calculate parameters for GC (T=total, A=alloc table, F=finaliser table, P=pool; all in bytes):
-    // T = A + F + P
+#if MICROPY_GC_FREE_INDEX
+    // the free run index is placed before the tables, sized for the whole heap
+    size_t gc_free_index_len = ((byte*)end - (byte*)start) / (BYTES_PER_BLOCK * BLOCKS_PER_FRI) + 1;
+    MP_STATE_MEM(gc_free_index) = (uint16_t*)(((uintptr_t)start + 1) & ~(uintptr_t)1);
+    start = MP_STATE_MEM(gc_free_index) + gc_free_index_len * FRI_ENTRY_LEN;
+    // all entries dirty
+    memset(MP_STATE_MEM(gc_free_index), 0xff, gc_free_index_len * FRI_ENTRY_LEN * sizeof(uint16_t));
+#endif
+
+    // calculate parameters for GC (T=total, A=alloc table, F=finaliser table, N=no-scan table, P=pool; all in bytes):
+    // T = A + F + N + P
     //     F = A * BLOCKS_PER_ATB / BLOCKS_PER_FTB
+    //     N = A * BLOCKS_PER_ATB / BLOCKS_PER_NTB
     //     P = A * BLOCKS_PER_ATB * BYTES_PER_BLOCK
-    // => T = A * (1 + BLOCKS_PER_ATB / BLOCKS_PER_FTB + BLOCKS_PER_ATB * BYTES_PER_BLOCK)
+    // => T = A * (1 + BLOCKS_PER_ATB / BLOCKS_PER_FTB + BLOCKS_PER_ATB / BLOCKS_PER_NTB + BLOCKS_PER_ATB * BYTES_PER_BLOCK)
     size_t total_byte_len = (byte*)end - (byte*)start;
-#if MICROPY_ENABLE_FINALISER
-    MP_STATE_MEM(gc_alloc_table_byte_len) = total_byte_len * BITS_PER_BYTE / (BITS_PER_BYTE + BITS_PER_BYTE * BLOCKS_PER_ATB / BLOCKS_PER_FTB + BITS_PER_BYTE * BLOCKS_PER_ATB * BYTES_PER_BLOCK);
-#else
-    MP_STATE_MEM(gc_alloc_table_byte_len) = total_byte_len / (1 + BITS_PER_BYTE / 2 * BYTES_PER_BLOCK);
-#endif
+    MP_STATE_MEM(gc_alloc_table_byte_len) = total_byte_len * BITS_PER_BYTE / (BITS_PER_BYTE
+        #if MICROPY_ENABLE_FINALISER
+        + BITS_PER_BYTE * BLOCKS_PER_ATB / BLOCKS_PER_FTB
+        #endif
+        #if MICROPY_GC_NOSCAN
+        + BITS_PER_BYTE * BLOCKS_PER_ATB / BLOCKS_PER_NTB
+        #endif
+        + BITS_PER_BYTE * BLOCKS_PER_ATB * BYTES_PER_BLOCK);
 
     MP_STATE_MEM(gc_alloc_table_start) = (byte*)start;
+    byte *gc_tables_end = MP_STATE_MEM(gc_alloc_table_start) + MP_STATE_MEM(gc_alloc_table_byte_len);
 
 #if MICROPY_ENABLE_FINALISER
     size_t gc_finaliser_table_byte_len = (MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB + BLOCKS_PER_FTB - 1) / BLOCKS_PER_FTB;
-    MP_STATE_MEM(gc_finaliser_table_start) = MP_STATE_MEM(gc_alloc_table_start) + MP_STATE_MEM(gc_alloc_table_byte_len);
+    MP_STATE_MEM(gc_finaliser_table_start) = gc_tables_end;
+    gc_tables_end += gc_finaliser_table_byte_len;
+#endif
+
+#if MICROPY_GC_NOSCAN
+    size_t gc_noscan_table_byte_len = (MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB + BLOCKS_PER_NTB - 1) / BLOCKS_PER_NTB;
+    MP_STATE_MEM(gc_noscan_table_start) = gc_tables_end;
+    gc_tables_end += gc_noscan_table_byte_len;
 #endif
 
     size_t gc_pool_block_len = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
     MP_STATE_MEM(gc_pool_start) = (byte*)end - gc_pool_block_len * BYTES_PER_BLOCK;
     MP_STATE_MEM(gc_pool_end) = end;
 
-#if MICROPY_ENABLE_FINALISER
-    assert(MP_STATE_MEM(gc_pool_start) >= MP_STATE_MEM(gc_finaliser_table_start) + gc_finaliser_table_byte_len);
-#endif
+    assert(MP_STATE_MEM(gc_pool_start) >= gc_tables_end);
 
     // clear ATBs
     memset(MP_STATE_MEM(gc_alloc_table_start), 0, MP_STATE_MEM(gc_alloc_table_byte_len));
@@ -149,9 +243,44 @@ void gc_init(void *start, void *end) {
     memset(MP_STATE_MEM(gc_finaliser_table_start), 0, gc_finaliser_table_byte_len);
 #endif
 
+#if MICROPY_GC_NOSCAN
+    // clear NTBs
+    memset(MP_STATE_MEM(gc_noscan_table_start), 0, gc_noscan_table_byte_len);
+#endif
+
     // set last free ATB index to start of heap
     MP_STATE_MEM(gc_last_free_atb_index) = 0;
 
+    #if MICROPY_GC_PARALLEL_MARK
+    MP_STATE_MEM(gc_mark_parallel) = 1;
+    MP_STATE_MEM(gc_mark_done) = 1;
+    MP_STATE_MEM(gc_mark_markers) = 1;
+    MP_STATE_MEM(gc_mark_active) = 0;
+    MP_STATE_MEM(gc_mark_pool_len) = 0;
+    MP_STATE_MEM(gc_mark_lock) = 0;
+    #endif
+
+    #if MICROPY_GC_LAZY_SWEEP
+    // no sweep pending, full sweep after each collection
+    MP_STATE_MEM(gc_sweep_block) = gc_pool_block_len;
+    MP_STATE_MEM(gc_sweep_free_tail) = 0;
+    MP_STATE_MEM(gc_sweep_slice_us) = 0;
+    gc_pause_reset();
+    #endif
+
+    #if MICROPY_GC_INCREMENTAL
+    // the whole heap is marked in one pause
+    MP_STATE_MEM(gc_inc_phase) = GC_INC_IDLE;
+    MP_STATE_MEM(gc_inc_slice_us) = 0;
+    MP_STATE_MEM(gc_inc_auto) = 0;
+    MP_STATE_MEM(gc_inc_live) = 0;
+    MP_STATE_MEM(gc_grey_sp) = 0;
+    MP_STATE_MEM(gc_grey_overflow) = 0;
+    MP_STATE_MEM(gc_grey_rescan) = gc_pool_block_len;
+    MP_STATE_MEM(gc_grey_block) = 0;
+    MP_STATE_MEM(gc_grey_n_large) = 0;
+    #endif
+
     // unlock the GC
     MP_STATE_MEM(gc_lock_depth) = 0;
 
@@ -172,6 +301,9 @@ void gc_init(void *start, void *end) {
     DEBUG_GC_printf("      alloc table at %p, length " UINT_FMT " bytes, " UINT_FMT " blocks\r\n", MP_STATE_MEM(gc_alloc_table_start), MP_STATE_MEM(gc_alloc_table_byte_len), MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB);
 #if MICROPY_ENABLE_FINALISER
     DEBUG_GC_printf("  finaliser table at %p, length " UINT_FMT " bytes, " UINT_FMT " blocks\r\n", MP_STATE_MEM(gc_finaliser_table_start), gc_finaliser_table_byte_len, gc_finaliser_table_byte_len * BLOCKS_PER_FTB);
+#endif
+#if MICROPY_GC_NOSCAN
+    DEBUG_GC_printf("    no-scan table at %p, length " UINT_FMT " bytes, " UINT_FMT " blocks\r\n", MP_STATE_MEM(gc_noscan_table_start), gc_noscan_table_byte_len, gc_noscan_table_byte_len * BLOCKS_PER_NTB);
 #endif
     DEBUG_GC_printf("             pool at %p, length " UINT_FMT " bytes, " UINT_FMT " blocks\r\n", MP_STATE_MEM(gc_pool_start), gc_pool_block_len * BYTES_PER_BLOCK, gc_pool_block_len);
 }
@@ -208,11 +340,63 @@ bool gc_is_locked(void) {
 #endif
 #endif
 
+#if MICROPY_GC_PARALLEL_MARK
+// Parallel mark phase
+// The roots are only marked and collected into the shared mark pool, the pool
+// is then traced by the caller of gc_collect_end and by the helper marker,
+// which the port runs on the other core. The heads are marked with an atomic
+// OR on the ATB word, so that each block is traced only by the marker which
+// changed its state from HEAD to MARK. Each marker uses its own mark stack,
+// when the other marker is idle, half of the stack is moved into the pool.
+
+#if MP_ENDIANNESS_BIG
+#error MICROPY_GC_PARALLEL_MARK requires a little endian target
+#endif
+
+STATIC inline bool gc_try_mark(size_t block) {
+    byte *atb = &MP_STATE_MEM(gc_alloc_table_start)[block / BLOCKS_PER_ATB];
+    uint32_t *atw = (uint32_t*)((uintptr_t)atb & ~(uintptr_t)3);
+    unsigned int shift = ((uintptr_t)atb & 3) * BITS_PER_BYTE + BLOCK_SHIFT(block);
+    // HEAD (0b01) -> MARK (0b11)
+    uint32_t old = __atomic_fetch_or(atw, (uint32_t)AT_TAIL << shift, __ATOMIC_RELAXED);
+    return ((old >> shift) & 3) == AT_HEAD;
+}
+
+STATIC inline void gc_mark_pool_lock(void) {
+    while (__atomic_exchange_n(&MP_STATE_MEM(gc_mark_lock), 1, __ATOMIC_ACQUIRE)) {
+    }
+}
+
+STATIC inline void gc_mark_pool_unlock(void) {
+    __atomic_store_n(&MP_STATE_MEM(gc_mark_lock), 0, __ATOMIC_RELEASE);
+}
+
+// Move the bottom half of the mark stack (the oldest entries) into the pool,
+// returns the new stack pointer
+STATIC size_t gc_mark_pool_give(MICROPY_GC_STACK_ENTRY_TYPE *stack, size_t sp) {
+    gc_mark_pool_lock();
+    size_t n = sp / 2;
+    if (n > MICROPY_ALLOC_GC_MARK_POOL_SIZE - MP_STATE_MEM(gc_mark_pool_len)) {
+        n = MICROPY_ALLOC_GC_MARK_POOL_SIZE - MP_STATE_MEM(gc_mark_pool_len);
+    }
+    memcpy(&MP_STATE_MEM(gc_mark_pool)[MP_STATE_MEM(gc_mark_pool_len)], stack, n * sizeof(MICROPY_GC_STACK_ENTRY_TYPE));
+    MP_STATE_MEM(gc_mark_pool_len) += n;
+    gc_mark_pool_unlock();
+    memmove(stack, stack + n, (sp - n) * sizeof(MICROPY_GC_STACK_ENTRY_TYPE));
+    return sp - n;
+}
+#else
+STATIC inline bool gc_try_mark(size_t block) {
+    ATB_HEAD_TO_MARK(block);
+    return true;
+}
+#endif
+
 // Take the given block as the topmost block on the stack. Check all it's
 // children: mark the unmarked child blocks and put those newly marked
 // blocks on the stack. When all children have been checked, pop off the
 // topmost block on the stack and repeat with that one.
-STATIC void gc_mark_subtree(size_t block) {
+STATIC void gc_mark_subtree(size_t block, MICROPY_GC_STACK_ENTRY_TYPE *stack) {
     // Start with the block passed in the argument.
     size_t sp = 0;
     for (;;) {
@@ -229,12 +413,15 @@ STATIC void gc_mark_subtree(size_t block) {
             if (VERIFY_PTR(ptr)) {
                 // Mark and push this pointer
                 size_t childblock = BLOCK_FROM_PTR(ptr);
-                if (ATB_GET_KIND(childblock) == AT_HEAD) {
+                if ((ATB_GET_KIND(childblock) == AT_HEAD) && (gc_try_mark(childblock))) {
                     // an unmarked head, mark it, and push it on gc stack
                     TRACE_MARK(childblock, ptr);
-                    ATB_HEAD_TO_MARK(childblock);
+                    if (NTB_GET(childblock)) {
+                        // no-scan block, there are no children to check
+                        continue;
+                    }
                     if (sp < MICROPY_ALLOC_GC_STACK_SIZE) {
-                        MP_STATE_MEM(gc_stack)[sp++] = childblock;
+                        stack[sp++] = childblock;
                     } else {
                         MP_STATE_MEM(gc_stack_overflow) = 1;
                     }
@@ -242,16 +429,78 @@ STATIC void gc_mark_subtree(size_t block) {
             }
         }
 
+        #if MICROPY_GC_PARALLEL_MARK
+        if ((sp > 1) && (__atomic_load_n(&MP_STATE_MEM(gc_mark_markers), __ATOMIC_RELAXED) > 1)
+            && (__atomic_load_n(&MP_STATE_MEM(gc_mark_active), __ATOMIC_RELAXED) < MP_STATE_MEM(gc_mark_markers))) {
+            // the helper marker runs and is idle, share the work
+            sp = gc_mark_pool_give(stack, sp);
+        }
+        #endif
+
         // Are there any blocks on the stack?
         if (sp == 0) {
             break; // No, stack is empty, we're done.
         }
 
         // pop the next block off the stack
-        block = MP_STATE_MEM(gc_stack)[--sp];
+        block = stack[--sp];
+    }
+}
+
+#if MICROPY_GC_PARALLEL_MARK
+// Trace the blocks from the mark pool until the pool is empty and all markers are idle
+STATIC void gc_mark_run(MICROPY_GC_STACK_ENTRY_TYPE *stack) {
+    bool active = true;
+    for (;;) {
+        gc_mark_pool_lock();
+        if (MP_STATE_MEM(gc_mark_pool_len) > 0) {
+            size_t block = MP_STATE_MEM(gc_mark_pool)[--MP_STATE_MEM(gc_mark_pool_len)];
+            if (!active) {
+                MP_STATE_MEM(gc_mark_active)++;
+                active = true;
+            }
+            gc_mark_pool_unlock();
+            gc_mark_subtree(block, stack);
+            continue;
+        }
+        if (active) {
+            MP_STATE_MEM(gc_mark_active)--;
+            active = false;
+        }
+        if (MP_STATE_MEM(gc_mark_active) == 0) {
+            // the pool is empty and no marker can add to it
+            MP_STATE_MEM(gc_mark_done) = 1;
+            gc_mark_pool_unlock();
+            return;
+        }
+        gc_mark_pool_unlock();
+
+        // wait for the other marker to share the work or to finish
+        while ((__atomic_load_n(&MP_STATE_MEM(gc_mark_pool_len), __ATOMIC_RELAXED) == 0)
+            && (__atomic_load_n(&MP_STATE_MEM(gc_mark_active), __ATOMIC_RELAXED) > 0)) {
+        }
     }
 }
 
+void gc_mark_helper(MICROPY_GC_STACK_ENTRY_TYPE *stack) {
+    gc_mark_pool_lock();
+    if ((MP_STATE_MEM(gc_mark_done)) || (!MP_STATE_MEM(gc_mark_parallel))) {
+        // too late or disabled, nothing to do
+        gc_mark_pool_unlock();
+        return;
+    }
+    MP_STATE_MEM(gc_mark_markers)++;
+    MP_STATE_MEM(gc_mark_active)++;
+    gc_mark_pool_unlock();
+
+    gc_mark_run(stack);
+
+    gc_mark_pool_lock();
+    MP_STATE_MEM(gc_mark_markers)--;
+    gc_mark_pool_unlock();
+}
+#endif
+
 STATIC void gc_deal_with_stack_overflow(void) {
     while (MP_STATE_MEM(gc_stack_overflow)) {
         MP_STATE_MEM(gc_stack_overflow) = 0;
@@ -259,20 +508,40 @@ STATIC void gc_deal_with_stack_overflow(void) {
         // scan entire memory looking for blocks which have been marked but not their children
         for (size_t block = 0; block < MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB; block++) {
             // trace (again) if mark bit set
-            if (ATB_GET_KIND(block) == AT_MARK) {
-                gc_mark_subtree(block);
+            if ((ATB_GET_KIND(block) == AT_MARK) && (!NTB_GET(block))) {
+                gc_mark_subtree(block, MP_STATE_MEM(gc_stack));
             }
         }
     }
 }
 
+#if MICROPY_GC_LAZY_SWEEP
+// Sweep from the sweep cursor to the end of the heap, or until 'max_us' expires
+// (if not 0), the next call continues from there. The GC must be locked.
+STATIC void gc_sweep(mp_uint_t max_us) {
+    size_t block = MP_STATE_MEM(gc_sweep_block);
+    size_t first_free = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+    int free_tail = MP_STATE_MEM(gc_sweep_free_tail);
+    mp_uint_t start = mp_hal_ticks_us();
+    #if MICROPY_GC_INCREMENTAL
+    size_t n_live = 0;
+    #endif
+#else
 STATIC void gc_sweep(void) {
     #if MICROPY_PY_GC_COLLECT_RETVAL
     MP_STATE_MEM(gc_collected) = 0;
     #endif
     // free unmarked heads and their tails
     int free_tail = 0;
-    for (size_t block = 0; block < MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB; block++) {
+    size_t block = 0;
+#endif
+    for (; block < MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB; block++) {
+        #if MICROPY_GC_LAZY_SWEEP
+        if ((max_us > 0) && ((block % GC_SWEEP_CHUNK) == 0) && (block != MP_STATE_MEM(gc_sweep_block))
+                && ((mp_hal_ticks_us() - start) >= max_us)) {
+            break;
+        }
+        #endif
         switch (ATB_GET_KIND(block)) {
             case AT_HEAD:
 #if MICROPY_ENABLE_FINALISER
@@ -297,6 +566,7 @@ STATIC void gc_sweep(void) {
                     FTB_CLEAR(block);
                 }
 #endif
+                NTB_CLEAR(block);
                 free_tail = 1;
                 DEBUG_GC_printf("gc_sweep [HEAD] (%p)\r\n", (void *)PTR_FROM_BLOCK(block));
                 #if MICROPY_PY_GC_COLLECT_RETVAL
@@ -308,21 +578,429 @@ STATIC void gc_sweep(void) {
                 if (free_tail) {
                     DEBUG_GC_printf("gc_sweep [FREE TAIL] (%p)\r\n", (void *)PTR_FROM_BLOCK(block));
                     ATB_ANY_TO_FREE(block);
+                    #if MICROPY_GC_LAZY_SWEEP
+                    if (block < first_free) {
+                        first_free = block;
+                    }
+                    #endif
                     #if CLEAR_ON_SWEEP
                     memset((void*)PTR_FROM_BLOCK(block), 0, BYTES_PER_BLOCK);
                     #endif
                 }
+                #if MICROPY_GC_INCREMENTAL
+                else {
+                    n_live++;
+                }
+                #endif
                 break;
 
             case AT_MARK:
                 DEBUG_GC_printf("gc_sweep [MARK] (%p)\r\n", (void *)PTR_FROM_BLOCK(block));
                 ATB_MARK_TO_HEAD(block);
                 free_tail = 0;
+                #if MICROPY_GC_INCREMENTAL
+                n_live++;
+                #endif
                 break;
         }
     }
+    #if MICROPY_GC_LAZY_SWEEP
+    MP_STATE_MEM(gc_sweep_block) = block;
+    MP_STATE_MEM(gc_sweep_free_tail) = free_tail;
+    #if MICROPY_GC_INCREMENTAL
+    MP_STATE_MEM(gc_inc_live) += n_live;
+    if ((!GC_SWEEP_PENDING()) && (MP_STATE_MEM(gc_inc_auto))) {
+        // start the next mark phase when half of the free blocks are allocated,
+        // the other half is left for the allocations while it runs
+        size_t n_total = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+        size_t n_free = n_total - MP_STATE_MEM(gc_inc_live);
+        MP_STATE_MEM(gc_alloc_threshold) = MAX(n_free / 2, n_total / 32);
+    }
+    #endif
+    // the blocks freed in this slice can be allocated again
+    if (first_free / BLOCKS_PER_ATB < MP_STATE_MEM(gc_last_free_atb_index)) {
+        MP_STATE_MEM(gc_last_free_atb_index) = first_free / BLOCKS_PER_ATB;
+    }
+    #endif
+}
+
+#if MICROPY_GC_FREE_INDEX
+// Get the free run index entry of the chunk, recompute it if dirty
+STATIC uint16_t *gc_free_index_get(size_t chunk) {
+    uint16_t *entry = &MP_STATE_MEM(gc_free_index)[chunk * FRI_ENTRY_LEN];
+    if (entry[FRI_MAX] == FRI_DIRTY) {
+        size_t first = chunk * BLOCKS_PER_FRI;
+        size_t last = first + BLOCKS_PER_FRI;
+        if (last > MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB) {
+            // the last chunk
+            last = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+        }
+        size_t prefix = last - first;
+        size_t len = 0;
+        size_t max = 0;
+        for (size_t block = first; block < last; block++) {
+            if (ATB_GET_KIND(block) == AT_FREE) {
+                if (++len > max) {
+                    max = len;
+                }
+            } else {
+                if (prefix == last - first) {
+                    prefix = block - first;
+                }
+                len = 0;
+            }
+        }
+        entry[FRI_PREFIX] = prefix;
+        entry[FRI_SUFFIX] = len;
+        entry[FRI_MAX] = max;
+    }
+    return entry;
+}
+
+// Find the first run of 'n_blocks' free blocks using the free run index
+// Returns the last block of the run, or 0 if not found
+STATIC size_t gc_free_index_find(size_t n_blocks) {
+    size_t n_blocks_total = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+    size_t n_chunks = (n_blocks_total + BLOCKS_PER_FRI - 1) / BLOCKS_PER_FRI;
+    // the free run continued from the previous chunks
+    size_t n_free = 0;
+    // there are no free blocks before gc_last_free_atb_index
+    for (size_t chunk = MP_STATE_MEM(gc_last_free_atb_index) * BLOCKS_PER_ATB / BLOCKS_PER_FRI; chunk < n_chunks; chunk++) {
+        uint16_t *entry = gc_free_index_get(chunk);
+        size_t first = chunk * BLOCKS_PER_FRI;
+        if (n_free + entry[FRI_PREFIX] >= n_blocks) {
+            return first - n_free + n_blocks - 1;
+        }
+        if (entry[FRI_MAX] >= n_blocks) {
+            // the run is inside this chunk
+            n_free = 0;
+            for (size_t block = first; block < first + BLOCKS_PER_FRI; block++) {
+                if (ATB_GET_KIND(block) == AT_FREE) {
+                    if (++n_free >= n_blocks) {
+                        return block;
+                    }
+                } else {
+                    n_free = 0;
+                }
+            }
+        }
+        if ((entry[FRI_PREFIX] == BLOCKS_PER_FRI) || (first + entry[FRI_PREFIX] == n_blocks_total)) {
+            // the whole chunk is free
+            n_free += entry[FRI_PREFIX];
+        } else {
+            n_free = entry[FRI_SUFFIX];
+        }
+    }
+    return 0;
+}
+#endif
+
+#if MICROPY_GC_LAZY_SWEEP
+void gc_pause_reset(void) {
+    MP_STATE_MEM(gc_pause_max) = 0;
+    MP_STATE_MEM(gc_pause_total) = 0;
+    MP_STATE_MEM(gc_pause_count) = 0;
+    memset(MP_STATE_MEM(gc_pause_hist), 0, sizeof(MP_STATE_MEM(gc_pause_hist)));
+}
+
+STATIC void gc_pause_record(mp_uint_t start) {
+    mp_uint_t t = mp_hal_ticks_us() - start;
+    size_t n = 0;
+    while ((n < (MICROPY_GC_PAUSE_HIST_LEN - 1)) && (t >= ((mp_uint_t)128 << n))) {
+        n++;
+    }
+    MP_STATE_MEM(gc_pause_hist)[n]++;
+    MP_STATE_MEM(gc_pause_count)++;
+    MP_STATE_MEM(gc_pause_total) += t;
+    if (t > MP_STATE_MEM(gc_pause_max)) {
+        MP_STATE_MEM(gc_pause_max) = t;
+    }
+}
+
+// Continue the pending sweep for at most 'max_us', finish it if 0
+// The GC must not be locked
+STATIC void gc_sweep_slice(mp_uint_t max_us) {
+    mp_uint_t start = mp_hal_ticks_us();
+    GC_ENTER();
+    MP_STATE_MEM(gc_lock_depth)++;
+    gc_sweep(max_us);
+    MP_STATE_MEM(gc_lock_depth)--;
+    GC_EXIT();
+    gc_pause_record(start);
+}
+
+void gc_sweep_step(void) {
+    // not while the sweep runs a finaliser
+    if ((MP_STATE_MEM(gc_lock_depth) == 0) && GC_SWEEP_PENDING()) {
+        gc_sweep_slice(MP_STATE_MEM(gc_sweep_slice_us));
+    }
+}
+
+void gc_sweep_finish(void) {
+    if ((MP_STATE_MEM(gc_lock_depth) == 0) && GC_SWEEP_PENDING()) {
+        gc_sweep_slice(0);
+    }
+}
+#endif
+
+#if MICROPY_GC_INCREMENTAL
+// number of blocks in the chain starting with this one
+STATIC size_t gc_n_blocks(size_t block) {
+    size_t n_blocks = 0;
+    do {
+        n_blocks += 1;
+    } while (ATB_GET_KIND(block + n_blocks) == AT_TAIL);
+    return n_blocks;
+}
+
+// If 'ptr' points to an unmarked head: mark it, and push it on the grey stack
+STATIC void gc_grey_mark(void *ptr) {
+    if (VERIFY_PTR(ptr)) {
+        size_t block = BLOCK_FROM_PTR(ptr);
+        if ((ATB_GET_KIND(block) == AT_HEAD) && (gc_try_mark(block))) {
+            TRACE_MARK(block, ptr);
+            if (NTB_GET(block)) {
+                // no-scan block, there are no children to check
+                return;
+            }
+            if (MP_STATE_MEM(gc_grey_sp) < MICROPY_ALLOC_GC_GREY_STACK_SIZE) {
+                MP_STATE_MEM(gc_grey_stack)[MP_STATE_MEM(gc_grey_sp)++] = block;
+            } else {
+                // all marked blocks are checked again when the grey stack is empty
+                MP_STATE_MEM(gc_grey_overflow) = 1;
+            }
+        }
+    }
+}
+
+// Mark the children in the words 'start' to 'end' of the block
+STATIC void gc_grey_words(size_t block, size_t start, size_t end) {
+    void **ptrs = (void**)PTR_FROM_BLOCK(block);
+    for (size_t i = start; i < end; i++) {
+        gc_grey_mark(ptrs[i]);
+    }
+}
+
+STATIC void gc_grey_children(size_t block) {
+    gc_grey_words(block, 0, gc_n_blocks(block) * WORDS_PER_BLOCK);
+}
+
+// Check the children of the grey blocks for at most 'max_us' from 'start', until
+// there are no grey blocks left if 0. Returns true if none are left.
+// The GC must be locked.
+STATIC bool gc_grey_trace(mp_uint_t start, mp_uint_t max_us) {
+    size_t n_total = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+    for (size_t n = 1;; n++) {
+        if ((max_us > 0) && ((n % GC_GREY_CHUNK) == 0) && ((mp_hal_ticks_us() - start) >= max_us)) {
+            return false;
+        }
+        size_t block;
+        size_t pos = 0;
+        if (MP_STATE_MEM(gc_grey_sp) > 0) {
+            block = MP_STATE_MEM(gc_grey_stack)[--MP_STATE_MEM(gc_grey_sp)];
+        } else if (MP_STATE_MEM(gc_grey_pos) > 0) {
+            // the rest of the large block, after the children of its checked part
+            block = MP_STATE_MEM(gc_grey_block);
+            pos = MP_STATE_MEM(gc_grey_pos);
+            MP_STATE_MEM(gc_grey_pos) = 0;
+        } else if (MP_STATE_MEM(gc_grey_n_large) > 0) {
+            block = MP_STATE_MEM(gc_grey_large)[--MP_STATE_MEM(gc_grey_n_large)];
+        } else if (MP_STATE_MEM(gc_grey_rescan) < n_total) {
+            // the grey stack overflowed, check the children of all marked blocks
+            block = MP_STATE_MEM(gc_grey_rescan)++;
+            if (NTB_GET(block)) {
+                continue;
+            }
+        } else if (MP_STATE_MEM(gc_grey_overflow)) {
+            MP_STATE_MEM(gc_grey_overflow) = 0;
+            MP_STATE_MEM(gc_grey_rescan) = 0;
+            continue;
+        } else {
+            return true;
+        }
+        if (ATB_GET_KIND(block) != AT_MARK) {
+            // freed since it was marked, gc_free marked its children
+            continue;
+        }
+        size_t end = gc_n_blocks(block) * WORDS_PER_BLOCK;
+        if ((max_us > 0) && (end > pos + GC_GREY_WORDS)) {
+            if (MP_STATE_MEM(gc_grey_pos) > 0) {
+                // one large block is checked at a time
+                if (MP_STATE_MEM(gc_grey_n_large) < MICROPY_ALLOC_GC_GREY_LARGE_SIZE) {
+                    MP_STATE_MEM(gc_grey_large)[MP_STATE_MEM(gc_grey_n_large)++] = block;
+                } else {
+                    MP_STATE_MEM(gc_grey_overflow) = 1;
+                }
+                continue;
+            }
+            // check the large block in parts, the time limit is checked after each part
+            end = pos + GC_GREY_WORDS;
+            MP_STATE_MEM(gc_grey_block) = block;
+            MP_STATE_MEM(gc_grey_pos) = end;
+            n = GC_GREY_CHUNK - 1;
+        }
+        gc_grey_words(block, pos, end);
+    }
 }
 
+STATIC bool gc_grey_empty(void) {
+    return (MP_STATE_MEM(gc_grey_sp) == 0) && (MP_STATE_MEM(gc_grey_pos) == 0) && (MP_STATE_MEM(gc_grey_n_large) == 0)
+        && (!MP_STATE_MEM(gc_grey_overflow))
+        && (MP_STATE_MEM(gc_grey_rescan) >= MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB);
+}
+
+STATIC void gc_grey_reset(void) {
+    MP_STATE_MEM(gc_grey_sp) = 0;
+    MP_STATE_MEM(gc_grey_pos) = 0;
+    MP_STATE_MEM(gc_grey_n_large) = 0;
+    MP_STATE_MEM(gc_grey_overflow) = 0;
+    MP_STATE_MEM(gc_grey_rescan) = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+}
+
+void gc_mark_step(void) {
+    // not while the sweep runs a finaliser
+    if ((MP_STATE_MEM(gc_inc_phase) != GC_INC_MARKING) || (MP_STATE_MEM(gc_lock_depth) > 0)) {
+        return;
+    }
+    mp_uint_t start = mp_hal_ticks_us();
+    if (((start - MP_STATE_MEM(gc_inc_last)) < MP_STATE_MEM(gc_inc_slice_us))
+        && (MP_STATE_MEM(gc_alloc_amount) < MP_STATE_MEM(gc_alloc_threshold) / 2)) {
+        // the program runs at least as long as a mark slice between the slices,
+        // unless it allocates faster than the blocks are marked
+        return;
+    }
+    if (gc_grey_empty()) {
+        // all reachable blocks are marked, trace the roots again and start the sweep
+        gc_collect();
+        return;
+    }
+    GC_ENTER();
+    MP_STATE_MEM(gc_lock_depth)++;
+    gc_grey_trace(start, MP_STATE_MEM(gc_inc_slice_us));
+    MP_STATE_MEM(gc_lock_depth)--;
+    GC_EXIT();
+    gc_pause_record(start);
+    MP_STATE_MEM(gc_inc_last) = mp_hal_ticks_us();
+}
+
+void gc_incremental(mp_uint_t max_us) {
+    MP_STATE_MEM(gc_inc_slice_us) = max_us;
+    MP_STATE_MEM(gc_sweep_slice_us) = max_us;
+    if ((max_us > 0) && (MP_STATE_MEM(gc_alloc_threshold) == (size_t)-1)) {
+        // the mark phase must start before the heap is full, after a quarter
+        // of the heap is allocated until the first sweep counts the free blocks
+        MP_STATE_MEM(gc_alloc_threshold) = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB / 4;
+        MP_STATE_MEM(gc_inc_auto) = 1;
+    } else if ((max_us == 0) && (MP_STATE_MEM(gc_inc_auto))) {
+        MP_STATE_MEM(gc_alloc_threshold) = (size_t)-1;
+        MP_STATE_MEM(gc_inc_auto) = 0;
+    }
+}
+
+void gc_write_barrier(const void *old) {
+    GC_ENTER();
+    if (MP_STATE_MEM(gc_inc_phase) == GC_INC_MARKING) {
+        gc_grey_mark((void*)old);
+    }
+    GC_EXIT();
+}
+
+void gc_write_barrier_obj(const void *ptr) {
+    GC_ENTER();
+    if ((MP_STATE_MEM(gc_inc_phase) == GC_INC_MARKING) && VERIFY_PTR(ptr)) {
+        size_t block = BLOCK_FROM_PTR(ptr);
+        if (ATB_IS_HEAD(block)) {
+            if (ATB_GET_KIND(block) == AT_HEAD) {
+                gc_try_mark(block);
+            }
+            if (!NTB_GET(block)) {
+                gc_grey_children(block);
+            }
+        }
+    }
+    GC_EXIT();
+}
+
+void gc_write_barrier_move(const void *ptr) {
+    GC_ENTER();
+    if ((MP_STATE_MEM(gc_inc_phase) == GC_INC_MARKING) && (MP_STATE_MEM(gc_grey_pos) > 0)
+        && VERIFY_PTR(ptr) && (BLOCK_FROM_PTR(ptr) == MP_STATE_MEM(gc_grey_block))) {
+        // a pointer could be moved from the part of the block which is not checked yet
+        // to the part which is, check the rest of the block now
+        mp_uint_t start = mp_hal_ticks_us();
+        size_t block = MP_STATE_MEM(gc_grey_block);
+        gc_grey_words(block, MP_STATE_MEM(gc_grey_pos), gc_n_blocks(block) * WORDS_PER_BLOCK);
+        MP_STATE_MEM(gc_grey_pos) = 0;
+        gc_pause_record(start);
+    }
+    GC_EXIT();
+}
+
+#if MICROPY_GC_INCREMENTAL_VERIFY
+// roots of the collection which finishes the incremental mark phase
+#define GC_VERIFY_ROOTS (32)
+STATIC struct {
+    void **ptrs;
+    size_t len;
+} gc_verify_roots[GC_VERIFY_ROOTS];
+STATIC size_t gc_verify_n_roots;
+
+// Trace the heap from the roots without using the marks, all reachable blocks
+// must be marked. A block found unmarked was reachable only from the marked
+// blocks, a pointer to it was overwritten without the write barrier.
+STATIC void gc_inc_verify(void) {
+    size_t n_total = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+    byte *seen = calloc(n_total / BITS_PER_BYTE + 1, 1);
+    size_t *stack = malloc(n_total * sizeof(size_t));
+    if ((seen == NULL) || (stack == NULL)) {
+        abort();
+    }
+    size_t sp = 0;
+    size_t n_roots = 0;
+    size_t n_missed = 0;
+    for (;;) {
+        void **ptrs;
+        size_t len;
+        if (sp > 0) {
+            size_t block = stack[--sp];
+            ptrs = (void**)PTR_FROM_BLOCK(block);
+            len = gc_n_blocks(block) * WORDS_PER_BLOCK;
+        } else if (n_roots < gc_verify_n_roots) {
+            ptrs = gc_verify_roots[n_roots].ptrs;
+            len = gc_verify_roots[n_roots].len;
+            n_roots++;
+        } else {
+            break;
+        }
+        for (size_t i = 0; i < len; i++) {
+            void *ptr = ptrs[i];
+            if (!VERIFY_PTR(ptr)) {
+                continue;
+            }
+            size_t block = BLOCK_FROM_PTR(ptr);
+            if ((!ATB_IS_HEAD(block)) || (seen[block / BITS_PER_BYTE] & (1 << (block & 7)))) {
+                continue;
+            }
+            seen[block / BITS_PER_BYTE] |= 1 << (block & 7);
+            if ((ATB_GET_KIND(block) != AT_MARK) && (n_missed++ < 8)) {
+                mp_printf(&mp_plat_print, "GC verify: %p not marked, referenced from %p, first word %p\n",
+                    ptr, (void*)&ptrs[i], *(void**)ptr);
+            }
+            if (!NTB_GET(block)) {
+                stack[sp++] = block;
+            }
+        }
+    }
+    free(stack);
+    free(seen);
+    if (n_missed > 0) {
+        mp_printf(&mp_plat_print, "GC verify: %u reachable blocks not marked\n", (uint)n_missed);
+        abort();
+    }
+}
+#endif
+#endif
+
 void gc_collect_start(void) {
     GC_ENTER();
     MP_STATE_MEM(gc_lock_depth)++;
@@ -330,6 +1008,31 @@ void gc_collect_start(void) {
     MP_STATE_MEM(gc_alloc_amount) = 0;
     #endif
     MP_STATE_MEM(gc_stack_overflow) = 0;
+    #if MICROPY_GC_LAZY_SWEEP
+    MP_STATE_MEM(gc_pause_start) = mp_hal_ticks_us();
+    // the previous sweep must be finished before marking
+    gc_sweep(0);
+    #endif
+    #if MICROPY_GC_PARALLEL_MARK
+    // the helper marker can't join while the roots are being collected
+    MP_STATE_MEM(gc_mark_done) = 1;
+    MP_STATE_MEM(gc_mark_markers) = 1;
+    MP_STATE_MEM(gc_mark_pool_len) = 0;
+    #endif
+    #if MICROPY_GC_INCREMENTAL
+    if (MP_STATE_MEM(gc_inc_phase) == GC_INC_START) {
+        gc_grey_reset();
+    } else if (MP_STATE_MEM(gc_inc_phase) == GC_INC_MARKING) {
+        // finish the incremental mark phase, the program is stopped until the
+        // end of the collection and the write barriers are not needed
+        MP_STATE_MEM(gc_inc_phase) = GC_INC_FINISH;
+        __atomic_sub_fetch(&gc_inc_marking, 1, __ATOMIC_RELAXED);
+        gc_grey_trace(0, 0);
+        #if MICROPY_GC_INCREMENTAL_VERIFY
+        gc_verify_n_roots = 0;
+        #endif
+    }
+    #endif
 
     // Trace root pointers.  This relies on the root pointers being organized
     // correctly in the mp_state_ctx structure.  We scan nlr_top, dict_locals,
@@ -361,6 +1064,13 @@ void gc_collect_start(void) {
 
 void gc_collect_root(void **ptrs, size_t len) {
     DEBUG_GC_printf("  --> root at %p, size: %lu (%lu)\r\n", ptrs, len, len*sizeof(void *));
+    #if MICROPY_GC_INCREMENTAL_VERIFY
+    if ((MP_STATE_MEM(gc_inc_phase) == GC_INC_FINISH) && (gc_verify_n_roots < GC_VERIFY_ROOTS)) {
+        gc_verify_roots[gc_verify_n_roots].ptrs = ptrs;
+        gc_verify_roots[gc_verify_n_roots].len = len;
+        gc_verify_n_roots++;
+    }
+    #endif
     size_t n = 0;
     for (size_t i = 0; i < len; i++) {
         void *ptr = ptrs[i];
@@ -372,24 +1082,130 @@ void gc_collect_root(void **ptrs, size_t len) {
                 // An unmarked head: mark it, and mark all its children
                 TRACE_MARK(block, ptr);
                 ATB_HEAD_TO_MARK(block);
-                gc_mark_subtree(block);
+                if (NTB_GET(block)) {
+                    continue;
+                }
+                #if MICROPY_GC_INCREMENTAL
+                if (MP_STATE_MEM(gc_inc_phase) == GC_INC_START) {
+                    // Mark the children now, the rest is marked in the slices. The
+                    // frames on the heap are changed without the write barriers.
+                    gc_grey_children(block);
+                    continue;
+                }
+                #endif
+                #if MICROPY_GC_PARALLEL_MARK
+                if ((MP_STATE_MEM(gc_mark_parallel)) && (MP_STATE_MEM(gc_mark_pool_len) < MICROPY_ALLOC_GC_MARK_POOL_SIZE)) {
+                    // only collect the root, it is traced in gc_collect_end
+                    MP_STATE_MEM(gc_mark_pool)[MP_STATE_MEM(gc_mark_pool_len)++] = block;
+                    continue;
+                }
+                #endif
+                gc_mark_subtree(block, MP_STATE_MEM(gc_stack));
             }
         }
     }
 }
 
 void gc_collect_end(void) {
+    #if MICROPY_GC_INCREMENTAL
+    if (MP_STATE_MEM(gc_inc_phase) == GC_INC_START) {
+        // the grey blocks are checked by gc_mark_step, the program continues
+        MP_STATE_MEM(gc_inc_phase) = GC_INC_MARKING;
+        __atomic_add_fetch(&gc_inc_marking, 1, __ATOMIC_RELAXED);
+        MP_STATE_MEM(gc_lock_depth)--;
+        GC_EXIT();
+        gc_pause_record(MP_STATE_MEM(gc_pause_start));
+        MP_STATE_MEM(gc_inc_last) = mp_hal_ticks_us();
+        return;
+    }
+    #endif
+    #if MICROPY_GC_PARALLEL_MARK
+    if ((MP_STATE_MEM(gc_mark_parallel)) && (MP_STATE_MEM(gc_mark_pool_len) > 0)) {
+        // trace the collected roots, together with the helper marker if the port can start it
+        MP_STATE_MEM(gc_mark_markers) = 1;
+        MP_STATE_MEM(gc_mark_active) = 1;
+        __atomic_store_n(&MP_STATE_MEM(gc_mark_done), 0, __ATOMIC_RELEASE);
+        gc_mark_helper_start();
+        gc_mark_run(MP_STATE_MEM(gc_stack));
+        // wait until the helper marker exits
+        while (__atomic_load_n(&MP_STATE_MEM(gc_mark_markers), __ATOMIC_ACQUIRE) > 1) {
+        }
+    }
+    // Only this marker is left, gc_mark_subtree doesn't share any more.
+    // Trace whatever is still in the pool (roots collected with gc.parallel(False)
+    // set in between) before the sweep, together with the stack overflow rescan.
+    MP_STATE_MEM(gc_mark_active) = 0;
+    MP_STATE_MEM(gc_mark_done) = 1;
+    do {
+        while (MP_STATE_MEM(gc_mark_pool_len) > 0) {
+            gc_mark_subtree(MP_STATE_MEM(gc_mark_pool)[--MP_STATE_MEM(gc_mark_pool_len)], MP_STATE_MEM(gc_stack));
+        }
+        gc_deal_with_stack_overflow();
+    } while (MP_STATE_MEM(gc_mark_pool_len) > 0);
+    #else
     gc_deal_with_stack_overflow();
+    #endif
+    #if MICROPY_GC_LAZY_SWEEP
+    #if MICROPY_PY_GC_COLLECT_RETVAL
+    MP_STATE_MEM(gc_collected) = 0;
+    #endif
+    MP_STATE_MEM(gc_sweep_block) = 0;
+    MP_STATE_MEM(gc_sweep_free_tail) = 0;
+    MP_STATE_MEM(gc_last_free_atb_index) = 0;
+    #if MICROPY_GC_INCREMENTAL
+    MP_STATE_MEM(gc_inc_live) = 0;
+    if (MP_STATE_MEM(gc_inc_phase) == GC_INC_FINISH) {
+        #if MICROPY_GC_INCREMENTAL_VERIFY
+        gc_inc_verify();
+        #endif
+        // this pause only traced the roots again, the sweep is done in the slices
+        MP_STATE_MEM(gc_inc_phase) = GC_INC_IDLE;
+    } else
+    #endif
+    {
+        // with the lazy sweep only the first slice is swept here,
+        // the sweep is continued from gc_alloc and gc_sweep_step
+        gc_sweep(MP_STATE_MEM(gc_sweep_slice_us));
+    }
+    #else
     gc_sweep();
     MP_STATE_MEM(gc_last_free_atb_index) = 0;
+    #endif
     MP_STATE_MEM(gc_lock_depth)--;
     GC_EXIT();
+    #if MICROPY_GC_LAZY_SWEEP
+    gc_pause_record(MP_STATE_MEM(gc_pause_start));
+    #endif
 }
 
 void gc_sweep_all(void) {
     GC_ENTER();
     MP_STATE_MEM(gc_lock_depth)++;
     MP_STATE_MEM(gc_stack_overflow) = 0;
+    #if MICROPY_GC_PARALLEL_MARK
+    // nothing is marked, nothing to trace
+    MP_STATE_MEM(gc_mark_done) = 1;
+    MP_STATE_MEM(gc_mark_pool_len) = 0;
+    #endif
+    #if MICROPY_GC_LAZY_SWEEP
+    // finish the pending sweep, nothing is marked after it, then sweep the whole heap
+    MP_STATE_MEM(gc_pause_start) = mp_hal_ticks_us();
+    gc_sweep(0);
+    MP_STATE_MEM(gc_sweep_slice_us) = 0;
+    #endif
+    #if MICROPY_GC_INCREMENTAL
+    if (MP_STATE_MEM(gc_inc_phase) == GC_INC_MARKING) {
+        // abandon the incremental mark phase
+        MP_STATE_MEM(gc_inc_phase) = GC_INC_IDLE;
+        __atomic_sub_fetch(&gc_inc_marking, 1, __ATOMIC_RELAXED);
+        gc_grey_reset();
+        for (size_t block = 0; block < MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB; block++) {
+            if (ATB_GET_KIND(block) == AT_MARK) {
+                ATB_MARK_TO_HEAD(block);
+            }
+        }
+    }
+    #endif
     gc_collect_end();
 }
 
@@ -413,6 +1229,9 @@ void gc_info(gc_info_t *info) {
                 break;
 
             case AT_HEAD:
+            #if MICROPY_GC_LAZY_SWEEP
+            case AT_MARK: // not swept yet
+            #endif
                 info->used += 1;
                 len = 1;
                 break;
@@ -422,9 +1241,11 @@ void gc_info(gc_info_t *info) {
                 len += 1;
                 break;
 
+            #if !MICROPY_GC_LAZY_SWEEP
             case AT_MARK:
                 // shouldn't happen
                 break;
+            #endif
         }
 
         block++;
@@ -432,6 +1253,11 @@ void gc_info(gc_info_t *info) {
         // Get next block type if possible
         if (!finish) {
             kind = ATB_GET_KIND(block);
+            #if MICROPY_GC_LAZY_SWEEP
+            if (kind == AT_MARK) {
+                kind = AT_HEAD;
+            }
+            #endif
         }
 
         if (finish || kind == AT_FREE || kind == AT_HEAD) {
@@ -467,6 +1293,14 @@ void *gc_alloc(size_t n_bytes, unsigned int alloc_flags) {
         return NULL;
     }
 
+    #if MICROPY_GC_LAZY_SWEEP
+    // the pending sweep is paced by the allocations
+    gc_sweep_step();
+    #endif
+    #if MICROPY_GC_INCREMENTAL
+    gc_mark_step();
+    #endif
+
     GC_ENTER();
 
     // check if GC is locked
@@ -484,8 +1318,20 @@ void *gc_alloc(size_t n_bytes, unsigned int alloc_flags) {
     #if MICROPY_GC_ALLOC_THRESHOLD
     if (!collected && MP_STATE_MEM(gc_alloc_amount) >= MP_STATE_MEM(gc_alloc_threshold)) {
         GC_EXIT();
-        gc_collect();
-        collected = 1;
+        #if MICROPY_GC_INCREMENTAL
+        if (MP_STATE_MEM(gc_inc_slice_us) > 0) {
+            // Start the incremental mark phase when the sweep is finished. Nothing
+            // is freed yet, if the allocation fails the collection is finished.
+            if ((MP_STATE_MEM(gc_inc_phase) == GC_INC_IDLE) && (!GC_SWEEP_PENDING())) {
+                MP_STATE_MEM(gc_inc_phase) = GC_INC_START;
+                gc_collect();
+            }
+        } else
+        #endif
+        {
+            gc_collect();
+            collected = 1;
+        }
         GC_ENTER();
     }
     #endif
@@ -494,7 +1340,19 @@ void *gc_alloc(size_t n_bytes, unsigned int alloc_flags) {
 
         // look for a run of n_blocks available blocks
         n_free = 0;
-        for (i = MP_STATE_MEM(gc_last_free_atb_index); i < MP_STATE_MEM(gc_alloc_table_byte_len); i++) {
+        i = MP_STATE_MEM(gc_last_free_atb_index);
+        #if MICROPY_GC_FREE_INDEX
+        if (n_blocks >= FRI_MIN_BLOCKS) {
+            // skip the chunks without a long enough free run
+            i = gc_free_index_find(n_blocks);
+            if (i > 0) {
+                n_free = n_blocks;
+                goto found;
+            }
+            i = MP_STATE_MEM(gc_alloc_table_byte_len);
+        }
+        #endif
+        for (; i < MP_STATE_MEM(gc_alloc_table_byte_len); i++) {
             byte a = MP_STATE_MEM(gc_alloc_table_start)[i];
             if (ATB_0_IS_FREE(a)) { if (++n_free >= n_blocks) { i = i * BLOCKS_PER_ATB + 0; goto found; } } else { n_free = 0; }
             if (ATB_1_IS_FREE(a)) { if (++n_free >= n_blocks) { i = i * BLOCKS_PER_ATB + 1; goto found; } } else { n_free = 0; }
@@ -504,6 +1362,14 @@ void *gc_alloc(size_t n_bytes, unsigned int alloc_flags) {
 
         GC_EXIT();
         // nothing found!
+        #if MICROPY_GC_LAZY_SWEEP
+        if (GC_SWEEP_PENDING()) {
+            // finish the sweep before collecting again
+            gc_sweep_slice(0);
+            GC_ENTER();
+            continue;
+        }
+        #endif
         if (collected) {
             return NULL;
         }
@@ -530,6 +1396,21 @@ found:
 
     // mark first block as used head
     ATB_FREE_TO_HEAD(start_block);
+    #if MICROPY_GC_INCREMENTAL
+    if (MP_STATE_MEM(gc_inc_phase) == GC_INC_MARKING) {
+        // allocated in the mark phase, it is kept until the next collection
+        ATB_HEAD_TO_MARK(start_block);
+    } else
+    #endif
+    #if MICROPY_GC_LAZY_SWEEP
+    if (start_block >= MP_STATE_MEM(gc_sweep_block)) {
+        // not swept yet, allocate it as marked
+        ATB_HEAD_TO_MARK(start_block);
+    } else if (end_block >= MP_STATE_MEM(gc_sweep_block)) {
+        // the sweep must not free the tail past its cursor
+        MP_STATE_MEM(gc_sweep_free_tail) = 0;
+    }
+    #endif
 
     // mark rest of blocks as used tail
     // TODO for a run of many blocks can make this more efficient
@@ -573,6 +1454,14 @@ found:
     (void)has_finaliser;
     #endif
 
+    #if MICROPY_GC_NOSCAN
+    if (alloc_flags & GC_ALLOC_FLAG_NO_SCAN) {
+        GC_ENTER();
+        NTB_SET(start_block);
+        GC_EXIT();
+    }
+    #endif
+
     #if EXTENSIVE_HEAP_PROFILING
     gc_dump_alloc_table();
     #endif
@@ -608,11 +1497,19 @@ void gc_free(void *ptr) {
         // get the GC block number corresponding to this pointer
         assert(VERIFY_PTR(ptr));
         size_t block = BLOCK_FROM_PTR(ptr);
-        assert(ATB_GET_KIND(block) == AT_HEAD);
+        assert(ATB_IS_HEAD(block));
+
+        #if MICROPY_GC_INCREMENTAL
+        if ((MP_STATE_MEM(gc_inc_phase) == GC_INC_MARKING) && (!NTB_GET(block))) {
+            // the pointers in the block are removed, mark them as the write barrier
+            gc_grey_children(block);
+        }
+        #endif
 
         #if MICROPY_ENABLE_FINALISER
         FTB_CLEAR(block);
         #endif
+        NTB_CLEAR(block);
 
         // set the last_free pointer to this block if it's earlier in the heap
         if (block / BLOCKS_PER_ATB < MP_STATE_MEM(gc_last_free_atb_index)) {
@@ -637,7 +1534,7 @@ size_t gc_nbytes(const void *ptr) {
     GC_ENTER();
     if (VERIFY_PTR(ptr)) {
         size_t block = BLOCK_FROM_PTR(ptr);
-        if (ATB_GET_KIND(block) == AT_HEAD) {
+        if (ATB_IS_HEAD(block)) {
             // work out number of consecutive blocks in the chain starting with this on
             size_t n_blocks = 0;
             do {
@@ -706,7 +1603,7 @@ void *gc_realloc(void *ptr_in, size_t n_bytes, bool allow_move) {
     // get the GC block number corresponding to this pointer
     assert(VERIFY_PTR(ptr));
     size_t block = BLOCK_FROM_PTR(ptr);
-    assert(ATB_GET_KIND(block) == AT_HEAD);
+    assert(ATB_IS_HEAD(block));
 
     // compute number of new blocks that are requested
     size_t new_blocks = (n_bytes + BYTES_PER_BLOCK - 1) / BYTES_PER_BLOCK;
@@ -745,6 +1642,12 @@ void *gc_realloc(void *ptr_in, size_t n_bytes, bool allow_move) {
 
     // check if we can shrink the allocated area
     if (new_blocks < n_blocks) {
+        #if MICROPY_GC_INCREMENTAL
+        if ((MP_STATE_MEM(gc_inc_phase) == GC_INC_MARKING) && (!NTB_GET(block))) {
+            // the pointers in the freed tail are removed
+            gc_grey_words(block, new_blocks * WORDS_PER_BLOCK, n_blocks * WORDS_PER_BLOCK);
+        }
+        #endif
         // free unneeded tail blocks
         for (size_t bl = block + new_blocks, count = n_blocks - new_blocks; count > 0; bl++, count--) {
             ATB_ANY_TO_FREE(bl);
@@ -771,6 +1674,12 @@ void *gc_realloc(void *ptr_in, size_t n_bytes, bool allow_move) {
             assert(ATB_GET_KIND(bl) == AT_FREE);
             ATB_FREE_TO_TAIL(bl);
         }
+        #if MICROPY_GC_LAZY_SWEEP
+        if ((block < MP_STATE_MEM(gc_sweep_block)) && (block + new_blocks > MP_STATE_MEM(gc_sweep_block))) {
+            // the sweep must not free the new tail past its cursor
+            MP_STATE_MEM(gc_sweep_free_tail) = 0;
+        }
+        #endif
 
         GC_EXIT();
 
@@ -789,11 +1698,15 @@ void *gc_realloc(void *ptr_in, size_t n_bytes, bool allow_move) {
         return ptr_in;
     }
 
+    unsigned int alloc_flags = 0;
     #if MICROPY_ENABLE_FINALISER
-    bool ftb_state = FTB_GET(block);
-    #else
-    bool ftb_state = false;
+    if (FTB_GET(block)) {
+        alloc_flags |= GC_ALLOC_FLAG_HAS_FINALISER;
+    }
     #endif
+    if (NTB_GET(block)) {
+        alloc_flags |= GC_ALLOC_FLAG_NO_SCAN;
+    }
 
     GC_EXIT();
 
@@ -803,7 +1716,7 @@ void *gc_realloc(void *ptr_in, size_t n_bytes, bool allow_move) {
     }
 
     // can't resize inplace; try to find a new contiguous chain
-    void *ptr_out = gc_alloc(n_bytes, ftb_state);
+    void *ptr_out = gc_alloc(n_bytes, alloc_flags);
 
     // check that the alloc succeeded
     if (ptr_out == NULL) {
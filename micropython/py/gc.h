@@ -52,8 +52,57 @@ void gc_collect_end(void);
 // Use this function to sweep the whole heap and run all finalisers
 void gc_sweep_all(void);
 
+#if MICROPY_GC_PARALLEL_MARK
+// Implemented by the port: run gc_mark_helper() on the other core, using the
+// MicroPython state of the caller, or do nothing if that is not possible.
+// Must not be started on the core of the caller, which busy-waits for it.
+void gc_mark_helper_start(void);
+// The helper marker, 'stack' is its own mark stack (MICROPY_ALLOC_GC_STACK_SIZE entries)
+void gc_mark_helper(MICROPY_GC_STACK_ENTRY_TYPE *stack);
+#endif
+
+#if MICROPY_GC_LAZY_SWEEP
+// Continue the pending lazy sweep for at most the sweep slice time,
+// can be called by the port when the VM is idle or between the bytecodes
+void gc_sweep_step(void);
+// Finish the pending lazy sweep
+void gc_sweep_finish(void);
+// Clear the GC pause statistics
+void gc_pause_reset(void);
+#endif
+
+#if MICROPY_GC_INCREMENTAL
+// Number of the heaps in the incremental mark phase, the write barriers
+// do nothing while it is 0
+extern int gc_inc_marking;
+// Continue the incremental mark phase for at most the mark slice time, the port
+// calls it between the bytecodes as gc_sweep_step. Finishes the collection when
+// all marked blocks are checked.
+void gc_mark_step(void);
+// Set the time limit of the mark and sweep slices, 0 collects in one pause
+void gc_incremental(mp_uint_t max_us);
+// Must be called with the old value before a pointer stored in a heap block is
+// overwritten or cleared, so that the object it points to is still marked
+void gc_write_barrier(const void *old);
+// For the blocks changed without the write barriers (a generator frame when
+// resumed, a list being sorted): marks everything referenced from the block
+void gc_write_barrier_obj(const void *ptr);
+// Must be called before the pointers in the block starting at 'ptr' are moved
+// to the lower addresses of the block (the large blocks are checked in parts)
+void gc_write_barrier_move(const void *ptr);
+#define GC_WRITE_BARRIER(old) do { if (gc_inc_marking) { gc_write_barrier(old); } } while (0)
+#define GC_WRITE_BARRIER_OBJ(ptr) do { if (gc_inc_marking) { gc_write_barrier_obj(ptr); } } while (0)
+#define GC_WRITE_BARRIER_MOVE(ptr) do { if (gc_inc_marking) { gc_write_barrier_move(ptr); } } while (0)
+#else
+#define GC_WRITE_BARRIER(old) (void)0
+#define GC_WRITE_BARRIER_OBJ(ptr) (void)0
+#define GC_WRITE_BARRIER_MOVE(ptr) (void)0
+#endif
+
 enum {
     GC_ALLOC_FLAG_HAS_FINALISER = 1,
+    // the block never contains heap pointers, it is marked but not scanned
+    GC_ALLOC_FLAG_NO_SCAN = 2,
 };
 
 void *gc_alloc(size_t n_bytes, unsigned int alloc_flags);
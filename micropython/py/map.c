@@ -32,6 +32,7 @@
 #include "py/mpconfig.h"
 #include "py/misc.h"
 #include "py/runtime.h"
+#include "py/gc.h"
 
 #if MICROPY_DEBUG_VERBOSE // print debugging info
 #define DEBUG_PRINT (1)
@@ -170,10 +171,16 @@ mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t
     if (map->is_ordered) {
         for (mp_map_elem_t *elem = &map->table[0], *top = &map->table[map->used]; elem < top; elem++) {
             if (elem->key == index || (!compare_only_ptrs && mp_obj_equal(elem->key, index))) {
+                if (lookup_kind != MP_MAP_LOOKUP) {
+                    // the value is overwritten or removed by the caller
+                    GC_WRITE_BARRIER(elem->value);
+                }
                 #if MICROPY_PY_COLLECTIONS_ORDEREDDICT
                 if (MP_UNLIKELY(lookup_kind == MP_MAP_LOOKUP_REMOVE_IF_FOUND)) {
                     // remove the found element by moving the rest of the array down
                     mp_obj_t value = elem->value;
+                    GC_WRITE_BARRIER(elem->key);
+                    GC_WRITE_BARRIER_MOVE(map->table);
                     --map->used;
                     memmove(elem, elem + 1, (top - elem - 1) * sizeof(*elem));
                     // put the found element after the end so the caller can access it if needed
@@ -253,8 +260,13 @@ mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t
         } else if (slot->key == index || (!compare_only_ptrs && mp_obj_equal(slot->key, index))) {
             // found index
             // Note: CPython does not replace the index; try x={True:'true'};x[1]='one';x
+            if (lookup_kind != MP_MAP_LOOKUP) {
+                // the value is overwritten or removed by the caller
+                GC_WRITE_BARRIER(slot->value);
+            }
             if (lookup_kind == MP_MAP_LOOKUP_REMOVE_IF_FOUND) {
                 // delete element in this slot
+                GC_WRITE_BARRIER(slot->key);
                 map->used--;
                 if (map->table[(pos + 1) % map->alloc].key == MP_OBJ_NULL) {
                     // optimisation if next slot is empty
@@ -358,6 +370,7 @@ mp_obj_t mp_set_lookup(mp_set_t *set, mp_obj_t index, mp_map_lookup_kind_t looku
             // found index
             if (lookup_kind & MP_MAP_LOOKUP_REMOVE_IF_FOUND) {
                 // delete element
+                GC_WRITE_BARRIER(elem);
                 set->used--;
                 if (set->table[(pos + 1) % set->alloc] == MP_OBJ_NULL) {
                     // optimisation if next slot is empty
@@ -398,6 +411,7 @@ mp_obj_t mp_set_remove_first(mp_set_t *set) {
         if (mp_set_slot_is_filled(set, pos)) {
             mp_obj_t elem = set->table[pos];
             // delete element
+            GC_WRITE_BARRIER(elem);
             set->used--;
             if (set->table[(pos + 1) % set->alloc] == MP_OBJ_NULL) {
                 // optimisation if next slot is empty
@@ -27,6 +27,7 @@
 #include "py/mpstate.h"
 #include "py/obj.h"
 #include "py/gc.h"
+#include "py/runtime.h"
 
 #if MICROPY_PY_GC && MICROPY_ENABLE_GC
 
@@ -34,6 +35,10 @@
 STATIC mp_obj_t py_gc_collect(void) {
     gc_collect();
 #if MICROPY_PY_GC_COLLECT_RETVAL
+    #if MICROPY_GC_LAZY_SWEEP
+    // the number of the freed objects is only known when the sweep is finished
+    gc_sweep_finish();
+    #endif
     return MP_OBJ_NEW_SMALL_INT(MP_STATE_MEM(gc_collected));
 #else
     return mp_const_none;
@@ -76,6 +81,70 @@ STATIC mp_obj_t gc_mem_alloc(void) {
 }
 MP_DEFINE_CONST_FUN_OBJ_0(gc_mem_alloc_obj, gc_mem_alloc);
 
+#if MICROPY_GC_PARALLEL_MARK
+// parallel([enable]): get or set the use of the helper marker on the other core
+STATIC mp_obj_t gc_parallel(size_t n_args, const mp_obj_t *args) {
+    if (n_args > 0) {
+        MP_STATE_MEM(gc_mark_parallel) = mp_obj_is_true(args[0]);
+    }
+    return mp_obj_new_bool(MP_STATE_MEM(gc_mark_parallel));
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(gc_parallel_obj, 0, 1, gc_parallel);
+#endif
+
+#if MICROPY_GC_LAZY_SWEEP
+// lazy_sweep([max_slice_us]): get or set the time limit of the sweep slices
+// 0 sweeps the whole heap at the end of each collection
+STATIC mp_obj_t gc_lazy_sweep(size_t n_args, const mp_obj_t *args) {
+    if (n_args > 0) {
+        mp_int_t val = mp_obj_get_int(args[0]);
+        if (val < 0) {
+            mp_raise_ValueError("invalid pause time");
+        }
+        MP_STATE_MEM(gc_sweep_slice_us) = val;
+    }
+    return mp_obj_new_int_from_uint(MP_STATE_MEM(gc_sweep_slice_us));
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(gc_lazy_sweep_obj, 0, 1, gc_lazy_sweep);
+
+// stats([reset]): return (pauses, max_us, total_us, histogram) of the GC pauses
+// histogram item 'n' counts the pauses shorter than 128 << n us, the last one all longer
+STATIC mp_obj_t gc_stats(size_t n_args, const mp_obj_t *args) {
+    mp_obj_t hist[MICROPY_GC_PAUSE_HIST_LEN];
+    for (int i = 0; i < MICROPY_GC_PAUSE_HIST_LEN; i++) {
+        hist[i] = mp_obj_new_int_from_uint(MP_STATE_MEM(gc_pause_hist)[i]);
+    }
+    mp_obj_t tuple[4] = {
+        mp_obj_new_int_from_uint(MP_STATE_MEM(gc_pause_count)),
+        mp_obj_new_int_from_uint(MP_STATE_MEM(gc_pause_max)),
+        mp_obj_new_int_from_uint(MP_STATE_MEM(gc_pause_total)),
+        mp_obj_new_tuple(MICROPY_GC_PAUSE_HIST_LEN, hist),
+    };
+    if ((n_args > 0) && mp_obj_is_true(args[0])) {
+        gc_pause_reset();
+    }
+    return mp_obj_new_tuple(4, tuple);
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(gc_stats_obj, 0, 1, gc_stats);
+#endif
+
+#if MICROPY_GC_INCREMENTAL
+// incremental([max_pause_us]): get or set the time limit of the mark and sweep slices
+// 0 marks and sweeps the whole heap in one pause. The mark phase is started by the
+// allocation threshold, if not set it is set to half of the free heap after each sweep.
+STATIC mp_obj_t py_gc_incremental(size_t n_args, const mp_obj_t *args) {
+    if (n_args > 0) {
+        mp_int_t val = mp_obj_get_int(args[0]);
+        if (val < 0) {
+            mp_raise_ValueError("invalid pause time");
+        }
+        gc_incremental(val);
+    }
+    return mp_obj_new_int_from_uint(MP_STATE_MEM(gc_inc_slice_us));
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(gc_incremental_obj, 0, 1, py_gc_incremental);
+#endif
+
 #if MICROPY_GC_ALLOC_THRESHOLD
 STATIC mp_obj_t gc_threshold(size_t n_args, const mp_obj_t *args) {
     if (n_args == 0) {
@@ -85,6 +154,10 @@ STATIC mp_obj_t gc_threshold(size_t n_args, const mp_obj_t *args) {
         return mp_obj_new_int(MP_STATE_MEM(gc_alloc_threshold) * MICROPY_BYTES_PER_GC_BLOCK);
     }
     mp_int_t val = mp_obj_get_int(args[0]);
+    #if MICROPY_GC_INCREMENTAL
+    // not set from the free blocks any more
+    MP_STATE_MEM(gc_inc_auto) = 0;
+    #endif
     if (val < 0) {
         MP_STATE_MEM(gc_alloc_threshold) = (size_t)-1;
     } else {
@@ -106,6 +179,16 @@ STATIC const mp_rom_map_elem_t mp_module_gc_globals_table[] = {
     #if MICROPY_GC_ALLOC_THRESHOLD
     { MP_ROM_QSTR(MP_QSTR_threshold), MP_ROM_PTR(&gc_threshold_obj) },
     #endif
+    #if MICROPY_GC_PARALLEL_MARK
+    { MP_ROM_QSTR(MP_QSTR_parallel), MP_ROM_PTR(&gc_parallel_obj) },
+    #endif
+    #if MICROPY_GC_LAZY_SWEEP
+    { MP_ROM_QSTR(MP_QSTR_lazy_sweep), MP_ROM_PTR(&gc_lazy_sweep_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stats), MP_ROM_PTR(&gc_stats_obj) },
+    #endif
+    #if MICROPY_GC_INCREMENTAL
+    { MP_ROM_QSTR(MP_QSTR_incremental), MP_ROM_PTR(&gc_incremental_obj) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_gc_globals, mp_module_gc_globals_table);
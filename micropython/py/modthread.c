@@ -1019,6 +1019,382 @@ STATIC mp_obj_t mod_thread_ipc_notify(mp_obj_t in_value)
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_thread_ipc_notify_obj, mod_thread_ipc_notify);
 
 
+/****************************************************************/
+// _thread.Channel
+// Zero-copy data channel between MicroPython instances (or threads)
+// Only one side is allowed to write (reserve/commit) and only one side to read (receive/release)
+
+typedef struct _mod_thread_chanbuf_obj_t mod_thread_chanbuf_obj_t;
+
+typedef struct _mod_thread_channel_obj_t {
+    mp_obj_base_t       base;
+    thread_channel_t    *channel;
+    mod_thread_chanbuf_obj_t *wbuf;     // buffer returned by the outstanding 'reserve()'
+    mod_thread_chanbuf_obj_t *rbuf;     // buffer returned by the outstanding 'receive()'
+} mod_thread_channel_obj_t;
+
+// The buffer object returned by 'reserve()' and 'receive()' points into the channel's ring buffer.
+// It is invalidated on 'commit()', 'release()' and 'close()', any access after that raises ValueError.
+// Restriction: a memoryview taken from the buffer object (memoryview(buf), or any object keeping
+// the pointer obtained through the buffer protocol) is NOT invalidated, the memoryview only holds
+// the raw pointer and not the buffer object. After 'commit()' or 'release()' its memory belongs to
+// other messages, after 'close()' the ring buffer is freed. Such memoryview must not be used after
+// the buffer object is invalidated; read and write the buffer object itself (items, slices,
+// readinto(), write()), it is checked on each access.
+struct _mod_thread_chanbuf_obj_t {
+    mp_obj_base_t       base;
+    mod_thread_channel_obj_t *chan;     // keeps the channel object alive while the buffer is referenced
+    uint8_t             *buf;           // NULL if invalidated
+    uint32_t            len;
+    bool                rw;
+};
+
+const mp_obj_type_t mod_thread_channel_type;
+const mp_obj_type_t mod_thread_chanbuf_type;
+
+//---------------------------------------------------------------------------------------------------------------
+STATIC mod_thread_chanbuf_obj_t *chanbuf_new(mod_thread_channel_obj_t *chan, uint8_t *buf, uint32_t len, bool rw)
+{
+    mod_thread_chanbuf_obj_t *self = m_new_obj(mod_thread_chanbuf_obj_t);
+    self->base.type = &mod_thread_chanbuf_type;
+    self->chan = chan;
+    self->buf = buf;
+    self->len = len;
+    self->rw = rw;
+    return self;
+}
+
+//-------------------------------------------------------
+STATIC void chanbuf_check(mod_thread_chanbuf_obj_t *self)
+{
+    if (self->buf == NULL) {
+        mp_raise_ValueError("Channel buffer released");
+    }
+}
+
+//---------------------------------------------------------------------------------------------------
+STATIC void mod_thread_chanbuf_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind)
+{
+    mod_thread_chanbuf_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->buf == NULL) mp_printf(print, "ChannelBuffer(released)");
+    else mp_printf(print, "ChannelBuffer(len=%u, %s)", self->len, (self->rw) ? "rw" : "ro");
+}
+
+//-----------------------------------------------------------------------------
+STATIC mp_obj_t mod_thread_chanbuf_unary_op(mp_unary_op_t op, mp_obj_t self_in)
+{
+    mod_thread_chanbuf_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    switch (op) {
+        case MP_UNARY_OP_BOOL: return mp_obj_new_bool(self->buf != NULL);
+        case MP_UNARY_OP_LEN: chanbuf_check(self); return MP_OBJ_NEW_SMALL_INT(self->len);
+        default: return MP_OBJ_NULL; // op not supported
+    }
+}
+
+// Items and slices are copied, slice assignment must not change the buffer size
+//--------------------------------------------------------------------------------------------
+STATIC mp_obj_t mod_thread_chanbuf_subscr(mp_obj_t self_in, mp_obj_t index_in, mp_obj_t value)
+{
+    mod_thread_chanbuf_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (value == MP_OBJ_NULL) return MP_OBJ_NULL; // delete not supported
+    chanbuf_check(self);
+    if ((value != MP_OBJ_SENTINEL) && (!self->rw)) {
+        mp_raise_TypeError("Read-only channel buffer");
+    }
+
+    if (MP_OBJ_IS_TYPE(index_in, &mp_type_slice)) {
+        mp_bound_slice_t slice;
+        if (!mp_seq_get_fast_slice_indexes(self->len, index_in, &slice)) {
+            mp_raise_NotImplementedError("only slices with step=1 (aka None) are supported");
+        }
+        size_t slen = slice.stop - slice.start;
+        if (value == MP_OBJ_SENTINEL) {
+            return mp_obj_new_bytes(self->buf + slice.start, slen);
+        }
+        mp_buffer_info_t src;
+        mp_get_buffer_raise(value, &src, MP_BUFFER_READ);
+        if (src.len != slen) {
+            mp_raise_ValueError("Slice assignment can't change the buffer size");
+        }
+        memmove(self->buf + slice.start, src.buf, slen);
+        return mp_const_none;
+    }
+
+    size_t index = mp_get_index(self->base.type, self->len, index_in, false);
+    if (value == MP_OBJ_SENTINEL) {
+        return MP_OBJ_NEW_SMALL_INT(self->buf[index]);
+    }
+    self->buf[index] = mp_obj_get_int(value);
+    return mp_const_none;
+}
+
+// The buffer pointer obtained this way is only valid until the buffer is invalidated
+//---------------------------------------------------------------------------------------------------------
+STATIC mp_int_t mod_thread_chanbuf_get_buffer(mp_obj_t self_in, mp_buffer_info_t *bufinfo, mp_uint_t flags)
+{
+    mod_thread_chanbuf_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    chanbuf_check(self);
+    if ((flags & MP_BUFFER_WRITE) && (!self->rw)) return 1;
+    bufinfo->buf = self->buf;
+    bufinfo->len = self->len;
+    bufinfo->typecode = 'B';
+    return 0;
+}
+
+//=========================================
+const mp_obj_type_t mod_thread_chanbuf_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_ChannelBuffer,
+    .print = mod_thread_chanbuf_print,
+    .unary_op = mod_thread_chanbuf_unary_op,
+    .subscr = mod_thread_chanbuf_subscr,
+    .buffer_p = { .get_buffer = mod_thread_chanbuf_get_buffer },
+};
+
+//------------------------------------------------------------
+STATIC void chanbuf_invalidate(mod_thread_chanbuf_obj_t **buf)
+{
+    if (*buf != NULL) {
+        (*buf)->buf = NULL;
+        (*buf)->len = 0;
+        *buf = NULL;
+    }
+}
+
+//-------------------------------------------------------
+STATIC void check_channel(mod_thread_channel_obj_t *self)
+{
+    if (self->channel == NULL) {
+        mp_raise_ValueError("Channel closed");
+    }
+}
+
+//--------------------------------------------------------------------------------------------------------------------------
+STATIC mp_obj_t mod_thread_channel_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args)
+{
+    enum { ARG_id, ARG_size };
+    const mp_arg_t allowed_args[] = {
+        { MP_QSTR_id,    MP_ARG_REQUIRED | MP_ARG_INT, { .u_int = 0 } },
+        { MP_QSTR_size,                    MP_ARG_INT, { .u_int = 4096 } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_map_t kw_args;
+    mp_map_init_fixed_table(&kw_args, n_kw, all_args + n_args);
+    mp_arg_parse_all(n_args, all_args, &kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if ((args[ARG_size].u_int < THREAD_CHANNEL_MIN_SIZE) || (args[ARG_size].u_int > THREAD_CHANNEL_MAX_SIZE)) {
+        nlr_raise(mp_obj_new_exception_msg_varg(&mp_type_ValueError, "Channel size range is %d ~ %d", THREAD_CHANNEL_MIN_SIZE, THREAD_CHANNEL_MAX_SIZE));
+    }
+
+    // allocate the object first, the opened channel must not leak if the allocation fails
+    mod_thread_channel_obj_t *self = m_new_obj_with_finaliser(mod_thread_channel_obj_t);
+    self->base.type = &mod_thread_channel_type;
+    self->channel = NULL;
+    self->wbuf = NULL;
+    self->rbuf = NULL;
+
+    thread_channel_t *channel = mp_thread_channel_open(args[ARG_id].u_int, args[ARG_size].u_int);
+    if (channel == NULL) {
+        mp_raise_msg(&mp_type_OSError, "Error opening channel");
+    }
+    self->channel = channel;
+    return MP_OBJ_FROM_PTR(self);
+}
+
+//---------------------------------------------------------------------------------------------------
+STATIC void mod_thread_channel_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind)
+{
+    mod_thread_channel_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->channel == NULL) {
+        mp_printf(print, "Channel(closed)");
+        return;
+    }
+    thread_channel_t *ch = self->channel;
+    mp_printf(print, "Channel(id=%u, size=%u, free=%u, pending=%u, opened=%u)",
+            ch->id, ch->size, mp_thread_channel_free(ch), ch->n_commit - ch->n_release, ch->nopen);
+}
+
+// Reserve the space for 'len' bytes and return the writable buffer object on it
+// Returns None if not enough space is available in the channel
+// The buffer is invalidated by 'commit()', memoryviews taken from it are not (see ChannelBuffer)
+//---------------------------------------------------------------------------
+STATIC mp_obj_t mod_thread_channel_reserve(mp_obj_t self_in, mp_obj_t len_in)
+{
+    mod_thread_channel_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    check_channel(self);
+    mp_int_t len = mp_obj_get_int(len_in);
+    if (len <= 0) {
+        mp_raise_ValueError("Wrong length");
+    }
+    if (self->channel->reserved) {
+        mp_raise_msg(&mp_type_OSError, "Previous reservation not committed");
+    }
+
+    // allocate before reserving, so that the reservation is never left without its buffer object
+    mod_thread_chanbuf_obj_t *wbuf = chanbuf_new(self, NULL, 0, true);
+    uint8_t *buf = mp_thread_channel_reserve(self->channel, len);
+    if (buf == NULL) return mp_const_none;
+    wbuf->buf = buf;
+    wbuf->len = len;
+    self->wbuf = wbuf;
+    return MP_OBJ_FROM_PTR(wbuf);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_thread_channel_reserve_obj, mod_thread_channel_reserve);
+
+// Make the reserved data available to the consumer
+// If the length is not given, the whole reserved size is committed
+// The buffer returned by 'reserve()' is invalidated
+//----------------------------------------------------------------------------
+STATIC mp_obj_t mod_thread_channel_commit(size_t n_args, const mp_obj_t *args)
+{
+    mod_thread_channel_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    check_channel(self);
+    uint32_t len = self->channel->reserved;
+    if (n_args > 1) {
+        mp_int_t clen = mp_obj_get_int(args[1]);
+        if ((clen < 0) || (clen > len)) {
+            mp_raise_ValueError("Wrong length");
+        }
+        len = clen;
+    }
+    chanbuf_invalidate(&self->wbuf);
+    return mp_obj_new_bool(mp_thread_channel_commit(self->channel, len));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_thread_channel_commit_obj, 1, 2, mod_thread_channel_commit);
+
+// Return the read-only buffer object on the next committed message or None
+// Optional timeout in ms can be given to wait for the message
+// The buffer is invalidated by 'release()', memoryviews taken from it are not (see ChannelBuffer)
+//-----------------------------------------------------------------------------
+STATIC mp_obj_t mod_thread_channel_receive(size_t n_args, const mp_obj_t *args)
+{
+    mod_thread_channel_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    check_channel(self);
+    if (self->channel->received) {
+        mp_raise_msg(&mp_type_OSError, "Previous message not released");
+    }
+    mp_int_t tmo = 0;
+    if (n_args > 1) tmo = mp_obj_get_int(args[1]);
+
+    mod_thread_chanbuf_obj_t *rbuf = chanbuf_new(self, NULL, 0, false);
+    uint32_t len = 0;
+    uint8_t *buf = mp_thread_channel_receive(self->channel, &len);
+    if ((buf == NULL) && (tmo > 0)) {
+        mp_uint_t start_ms = mp_hal_ticks_ms();
+        while ((buf == NULL) && ((mp_uint_t)(mp_hal_ticks_ms() - start_ms) < (mp_uint_t)tmo)) {
+            MP_THREAD_GIL_EXIT();
+            vTaskDelay(1 / portTICK_PERIOD_MS);
+            MP_THREAD_GIL_ENTER();
+            mp_handle_pending();
+            // the channel may have been closed by another thread while the GIL was released
+            check_channel(self);
+            buf = mp_thread_channel_receive(self->channel, &len);
+        }
+    }
+    if (buf == NULL) return mp_const_none;
+    rbuf->buf = buf;
+    rbuf->len = len;
+    self->rbuf = rbuf;
+    return MP_OBJ_FROM_PTR(rbuf);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_thread_channel_receive_obj, 1, 2, mod_thread_channel_receive);
+
+// Release the received message, the buffer returned by 'receive()' is invalidated
+//----------------------------------------------------------
+STATIC mp_obj_t mod_thread_channel_release(mp_obj_t self_in)
+{
+    mod_thread_channel_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    check_channel(self);
+    chanbuf_invalidate(&self->rbuf);
+    return mp_obj_new_bool(mp_thread_channel_release(self->channel));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_thread_channel_release_obj, mod_thread_channel_release);
+
+// Number of committed but not yet released messages
+//------------------------------------------------------
+STATIC mp_obj_t mod_thread_channel_any(mp_obj_t self_in)
+{
+    mod_thread_channel_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    check_channel(self);
+    return mp_obj_new_int(self->channel->n_commit - self->channel->n_release);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_thread_channel_any_obj, mod_thread_channel_any);
+
+//-------------------------------------------------------
+STATIC mp_obj_t mod_thread_channel_free(mp_obj_t self_in)
+{
+    mod_thread_channel_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    check_channel(self);
+    return mp_obj_new_int(mp_thread_channel_free(self->channel));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_thread_channel_free_obj, mod_thread_channel_free);
+
+// The channel can't be closed while the buffer returned by 'reserve()' or 'receive()'
+// is outstanding, 'commit()' or 'release()' it first
+//--------------------------------------------------------
+STATIC mp_obj_t mod_thread_channel_close(mp_obj_t self_in)
+{
+    mod_thread_channel_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->channel != NULL) {
+        if ((self->wbuf != NULL) || (self->rbuf != NULL)) {
+            mp_raise_msg(&mp_type_OSError, "Channel buffer not committed or released");
+        }
+        if (!mp_thread_channel_close(self->channel)) {
+            mp_raise_msg(&mp_type_OSError, "Channel buffer not committed or released");
+        }
+        self->channel = NULL;
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_thread_channel_close_obj, mod_thread_channel_close);
+
+// Finaliser, the buffer objects reference the channel object, so they are unreachable too
+// (and may already be swept, they are not accessed here);
+// drop the outstanding reservation and message and close the channel
+//------------------------------------------------------
+STATIC mp_obj_t mod_thread_channel_del(mp_obj_t self_in)
+{
+    mod_thread_channel_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->channel != NULL) {
+        if (self->wbuf != NULL) {
+            self->wbuf = NULL;
+            self->channel->reserved = 0;
+            self->channel->reserved_pad = 0;
+        }
+        if (self->rbuf != NULL) {
+            self->rbuf = NULL;
+            mp_thread_channel_release(self->channel);
+        }
+        mp_thread_channel_close(self->channel);
+        self->channel = NULL;
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_thread_channel_del_obj, mod_thread_channel_del);
+
+//================================================================
+STATIC const mp_rom_map_elem_t mod_thread_channel_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___del__),     MP_ROM_PTR(&mod_thread_channel_del_obj) },
+    { MP_ROM_QSTR(MP_QSTR_close),       MP_ROM_PTR(&mod_thread_channel_close_obj) },
+    { MP_ROM_QSTR(MP_QSTR_reserve),     MP_ROM_PTR(&mod_thread_channel_reserve_obj) },
+    { MP_ROM_QSTR(MP_QSTR_commit),      MP_ROM_PTR(&mod_thread_channel_commit_obj) },
+    { MP_ROM_QSTR(MP_QSTR_receive),     MP_ROM_PTR(&mod_thread_channel_receive_obj) },
+    { MP_ROM_QSTR(MP_QSTR_release),     MP_ROM_PTR(&mod_thread_channel_release_obj) },
+    { MP_ROM_QSTR(MP_QSTR_any),         MP_ROM_PTR(&mod_thread_channel_any_obj) },
+    { MP_ROM_QSTR(MP_QSTR_free),        MP_ROM_PTR(&mod_thread_channel_free_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(mod_thread_channel_locals_dict, mod_thread_channel_locals_dict_table);
+
+//==========================================
+const mp_obj_type_t mod_thread_channel_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_Channel,
+    .print = mod_thread_channel_print,
+    .make_new = mod_thread_channel_make_new,
+    .locals_dict = (mp_obj_dict_t*)&mod_thread_channel_locals_dict,
+};
+
+
 //=================================================================
 STATIC const mp_rom_map_elem_t mp_module_thread_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__),			MP_ROM_QSTR(MP_QSTR__thread) },
@@ -1057,6 +1433,7 @@ STATIC const mp_rom_map_elem_t mp_module_thread_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_ipc_bussy),           MP_ROM_PTR(&mod_thread_get_ipc_state_obj) },
     { MP_ROM_QSTR(MP_QSTR_ipc_break),           MP_ROM_PTR(&mod_thread_get_ipc_setexception_obj) },
     { MP_ROM_QSTR(MP_QSTR_ipc_notify),          MP_ROM_PTR(&mod_thread_ipc_notify_obj) },
+    { MP_ROM_QSTR(MP_QSTR_Channel),             MP_ROM_PTR(&mod_thread_channel_type) },
 
     { MP_ROM_QSTR(MP_QSTR_IPC_EXEC),            MP_ROM_INT(THREAD_IPC_TYPE_EXECUTE) },
 
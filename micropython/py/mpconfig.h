@@ -132,6 +132,64 @@
 #define MICROPY_GC_STACK_ENTRY_TYPE size_t
 #endif
 
+// Whether the mark phase can be shared with the helper marker on the other core
+// The port must implement gc_mark_helper_start()
+#ifndef MICROPY_GC_PARALLEL_MARK
+#define MICROPY_GC_PARALLEL_MARK (0)
+#endif
+
+// Size of the pool of blocks shared by the markers in the parallel mark phase
+#ifndef MICROPY_ALLOC_GC_MARK_POOL_SIZE
+#define MICROPY_ALLOC_GC_MARK_POOL_SIZE (256)
+#endif
+
+// Whether gc_alloc uses the index of the free runs in each 256 blocks of the
+// heap (6 bytes per 4KB with 16-byte blocks) to find space for larger allocations
+#ifndef MICROPY_GC_FREE_INDEX
+#define MICROPY_GC_FREE_INDEX (0)
+#endif
+
+// Whether the sweep can be split into time limited slices (lazy sweep), continued
+// from gc_alloc and gc_sweep_step(), and the GC pauses are recorded in a histogram
+// Without MICROPY_GC_INCREMENTAL the mark phase always runs to completion in one pause
+// The port must implement mp_hal_ticks_us()
+#ifndef MICROPY_GC_LAZY_SWEEP
+#define MICROPY_GC_LAZY_SWEEP (0)
+#endif
+
+// Whether the mark phase can be split into time limited slices (incremental
+// marking), started by the allocation threshold and continued from gc_alloc and
+// gc_mark_step(). The marking is snapshot-at-the-beginning: a heap pointer must
+// not be overwritten or cleared without GC_WRITE_BARRIER() while it runs.
+// Requires MICROPY_GC_LAZY_SWEEP and MICROPY_GC_ALLOC_THRESHOLD
+#ifndef MICROPY_GC_INCREMENTAL
+#define MICROPY_GC_INCREMENTAL (0)
+#endif
+
+// Number of entries of the grey stack, the marked blocks whose children the
+// incremental mark phase has not checked yet
+#ifndef MICROPY_ALLOC_GC_GREY_STACK_SIZE
+#define MICROPY_ALLOC_GC_GREY_STACK_SIZE (1024)
+#endif
+
+// Number of the large grey blocks waiting until the one being checked in parts is done
+#ifndef MICROPY_ALLOC_GC_GREY_LARGE_SIZE
+#define MICROPY_ALLOC_GC_GREY_LARGE_SIZE (8)
+#endif
+
+// Whether each incremental mark phase is checked when it finishes: all blocks
+// reachable from the roots must be marked, or a missing write barrier is reported
+// Slow, for the tests only; uses malloc() and abort()
+#ifndef MICROPY_GC_INCREMENTAL_VERIFY
+#define MICROPY_GC_INCREMENTAL_VERIFY (0)
+#endif
+
+// Number of buckets in the GC pause histogram, bucket 'n' counts the pauses
+// shorter than 128 << n us, the last bucket all longer pauses
+#ifndef MICROPY_GC_PAUSE_HIST_LEN
+#define MICROPY_GC_PAUSE_HIST_LEN (12)
+#endif
+
 // Be conservative and always clear to zero newly (re)allocated memory in the GC.
 // This helps eliminate stray pointers that hold on to memory that's no longer
 // used.  It decreases performance due to unnecessary memory clearing.
@@ -442,6 +500,14 @@
 #define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE (0)
 #endif
 
+// Whether to cache result of map lookups in LOAD_NAME, LOAD_GLOBAL, LOAD_ATTR,
+// LOAD_METHOD and STORE_ATTR bytecodes in a per-function side table on the
+// heap.  Unlike MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE the bytecode is not
+// modified, so it also works for bytecode in ROM (frozen or XIP mpy files).
+#ifndef MICROPY_OPT_INLINE_CACHE
+#define MICROPY_OPT_INLINE_CACHE (0)
+#endif
+
 // Whether to use fast versions of bitwise operations (and, or, xor) when the
 // arguments are both positive.  Increases Thumb2 code size by about 250 bytes.
 #ifndef MICROPY_OPT_MPZ_BITWISE
@@ -505,6 +571,13 @@
 #define MICROPY_ENABLE_FINALISER (0)
 #endif
 
+// Whether to support the no-scan heap blocks in the garbage collector
+// Data of bytes, bytearray, array and vstr objects is allocated as no-scan,
+// it is marked but its content is never scanned for the heap pointers
+#ifndef MICROPY_GC_NOSCAN
+#define MICROPY_GC_NOSCAN (0)
+#endif
+
 // Whether to enable a separate allocator for the Python stack.
 // If enabled then the code must call mp_pystack_init before mp_init.
 #ifndef MICROPY_ENABLE_PYSTACK
@@ -694,6 +767,13 @@ typedef double mp_float_t;
 #define MICROPY_MODULE_WEAK_LINKS (0)
 #endif
 
+// Whether compiled .py modules are cached as __pycache__/<name>.<mtime>.mpy
+// next to the source file and loaded from there while the source is unchanged
+// (requires MICROPY_PERSISTENT_CODE_LOAD/SAVE and MICROPY_VFS)
+#ifndef MICROPY_MODULE_CACHE_MPY
+#define MICROPY_MODULE_CACHE_MPY (0)
+#endif
+
 // Whether frozen modules are supported in the form of strings
 #ifndef MICROPY_MODULE_FROZEN_STR
 #define MICROPY_MODULE_FROZEN_STR (0)
@@ -704,6 +784,13 @@ typedef double mp_float_t;
 #define MICROPY_MODULE_FROZEN_MPY (0)
 #endif
 
+// Whether frozen .mpy modules can also be executed in place from an image
+// in memory mapped (XIP) flash; the port must define
+// MICROPY_MODULE_FROZEN_XIP_IMAGE to give the image address (or NULL)
+#ifndef MICROPY_MODULE_FROZEN_XIP
+#define MICROPY_MODULE_FROZEN_XIP (0)
+#endif
+
 // Convenience macro for whether frozen modules are supported
 #ifndef MICROPY_MODULE_FROZEN
 #define MICROPY_MODULE_FROZEN (MICROPY_MODULE_FROZEN_STR || MICROPY_MODULE_FROZEN_MPY)
@@ -1237,10 +1324,20 @@ typedef double mp_float_t;
 #define MICROPY_PY_UZLIB (0)
 #endif
 
+// Whether to provide the compressor (compress, CompressIO) in uzlib module
+#ifndef MICROPY_PY_UZLIB_COMPRESS
+#define MICROPY_PY_UZLIB_COMPRESS (0)
+#endif
+
 #ifndef MICROPY_PY_UJSON
 #define MICROPY_PY_UJSON (0)
 #endif
 
+// Whether to provide the incremental Parser and Writer in ujson module
+#ifndef MICROPY_PY_UJSON_STREAM
+#define MICROPY_PY_UJSON_STREAM (0)
+#endif
+
 #ifndef MICROPY_PY_URE
 #define MICROPY_PY_URE (0)
 #endif
@@ -75,11 +75,55 @@ typedef struct _mp_state_mem_t {
     #if MICROPY_ENABLE_FINALISER
     byte *gc_finaliser_table_start;
     #endif
+    #if MICROPY_GC_NOSCAN
+    byte *gc_noscan_table_start;
+    #endif
     byte *gc_pool_start;
     byte *gc_pool_end;
 
     int gc_stack_overflow;
     MICROPY_GC_STACK_ENTRY_TYPE gc_stack[MICROPY_ALLOC_GC_STACK_SIZE];
+    #if MICROPY_GC_PARALLEL_MARK
+    // shared by the markers during the parallel mark phase
+    MICROPY_GC_STACK_ENTRY_TYPE gc_mark_pool[MICROPY_ALLOC_GC_MARK_POOL_SIZE];
+    size_t gc_mark_pool_len;
+    int gc_mark_lock;
+    int gc_mark_markers;
+    int gc_mark_active;
+    int gc_mark_done;
+    uint16_t gc_mark_parallel;
+    #endif
+    #if MICROPY_GC_LAZY_SWEEP
+    // the lazy sweep continues from gc_sweep_block, if below the last block
+    size_t gc_sweep_block;
+    int gc_sweep_free_tail;
+    mp_uint_t gc_sweep_slice_us;
+    // GC pause statistics
+    mp_uint_t gc_pause_start;
+    mp_uint_t gc_pause_max;
+    mp_uint_t gc_pause_total;
+    size_t gc_pause_count;
+    size_t gc_pause_hist[MICROPY_GC_PAUSE_HIST_LEN];
+    #endif
+    #if MICROPY_GC_INCREMENTAL
+    // incremental mark phase, the grey blocks are marked but their children not checked yet
+    int gc_inc_phase;
+    mp_uint_t gc_inc_slice_us;
+    mp_uint_t gc_inc_last;
+    // the allocation threshold is set from the free blocks after each sweep
+    int gc_inc_auto;
+    // blocks left allocated by the current sweep
+    size_t gc_inc_live;
+    int gc_grey_overflow;
+    size_t gc_grey_rescan;
+    // the large block partly checked by the last mark slice, and the next word to check
+    size_t gc_grey_block;
+    size_t gc_grey_pos;
+    size_t gc_grey_sp;
+    MICROPY_GC_STACK_ENTRY_TYPE gc_grey_stack[MICROPY_ALLOC_GC_GREY_STACK_SIZE];
+    size_t gc_grey_n_large;
+    MICROPY_GC_STACK_ENTRY_TYPE gc_grey_large[MICROPY_ALLOC_GC_GREY_LARGE_SIZE];
+    #endif
     uint16_t gc_lock_depth;
 
     // This variable controls auto garbage collection.  If set to 0 then the
@@ -94,6 +138,10 @@ typedef struct _mp_state_mem_t {
 
     size_t gc_last_free_atb_index;
 
+    #if MICROPY_GC_FREE_INDEX
+    uint16_t *gc_free_index;
+    #endif
+
     #if MICROPY_PY_GC_COLLECT_RETVAL
     size_t gc_collected;
     #endif
@@ -194,6 +242,16 @@ typedef struct _mp_state_vm_t {
     size_t qstr_last_alloc;
     size_t qstr_last_used;
 
+    #if MICROPY_MODULE_FROZEN_XIP
+    // XIP module image, only set if its qstrs are registered
+    const byte *frozen_xip_image;
+    #endif
+
+    #ifdef MICRO_PY_BOOT_TRACE_SIZE
+    // nesting level of the boot trace spans started by this instance
+    uint32_t boot_trace_level;
+    #endif
+
     #if MICROPY_PY_THREAD
     // This is a global mutex used to make qstr interning thread-safe.
     mp_thread_mutex_t qstr_mutex;
@@ -106,7 +106,12 @@ STATIC mp_obj_array_t *array_new(char typecode, size_t n) {
     o->typecode = typecode;
     o->free = 0;
     o->len = n;
-    o->items = m_new(byte, typecode_size * o->len);
+    if ((typecode == 'O') || (typecode == 'P') || (typecode == 'S')) {
+        // items are pointers, must be scanned by the GC
+        o->items = m_new(byte, typecode_size * o->len);
+    } else {
+        o->items = m_new_noscan(byte, typecode_size * o->len);
+    }
     return o;
 }
 #endif
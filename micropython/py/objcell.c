@@ -25,6 +25,7 @@
  */
 
 #include "py/obj.h"
+#include "py/gc.h"
 
 typedef struct _mp_obj_cell_t {
     mp_obj_base_t base;
@@ -38,6 +39,7 @@ mp_obj_t mp_obj_cell_get(mp_obj_t self_in) {
 
 void mp_obj_cell_set(mp_obj_t self_in, mp_obj_t obj) {
     mp_obj_cell_t *self = MP_OBJ_TO_PTR(self_in);
+    GC_WRITE_BARRIER(self->obj);
     self->obj = obj;
 }
 
@@ -31,6 +31,7 @@
 #if MICROPY_PY_COLLECTIONS_DEQUE
 
 #include "py/runtime.h"
+#include "py/gc.h"
 
 typedef struct _mp_obj_deque_t {
     mp_obj_base_t base;
@@ -105,6 +106,8 @@ STATIC mp_obj_t mp_obj_deque_append(mp_obj_t self_in, mp_obj_t arg) {
         mp_raise_msg(&mp_type_IndexError, "full");
     }
 
+    // the oldest item is overwritten when the deque is full
+    GC_WRITE_BARRIER(self->items[self->i_put]);
     self->items[self->i_put] = arg;
     self->i_put = new_i_put;
 
@@ -126,6 +129,7 @@ STATIC mp_obj_t deque_popleft(mp_obj_t self_in) {
     }
 
     mp_obj_t ret = self->items[self->i_get];
+    GC_WRITE_BARRIER(ret);
     self->items[self->i_get] = MP_OBJ_NULL;
 
     if (++self->i_get == self->alloc) {
@@ -31,6 +31,7 @@
 #include "py/runtime.h"
 #include "py/builtin.h"
 #include "py/objtype.h"
+#include "py/gc.h"
 
 #define mp_obj_is_dict_type(o) (mp_obj_is_obj(o) && ((mp_obj_base_t*)MP_OBJ_TO_PTR(o))->type->make_new == dict_make_new)
 
@@ -316,6 +317,8 @@ STATIC mp_obj_t dict_popitem(mp_obj_t self_in) {
     }
     self->map.used--;
     mp_obj_t items[] = {next->key, next->value};
+    GC_WRITE_BARRIER(next->key);
+    GC_WRITE_BARRIER(next->value);
     next->key = MP_OBJ_SENTINEL; // must mark key as sentinel to indicate that it was deleted
     next->value = MP_OBJ_NULL;
     mp_obj_t tuple = mp_obj_new_tuple(2, items);
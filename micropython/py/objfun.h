@@ -28,11 +28,42 @@
 
 #include "py/obj.h"
 
+#if MICROPY_OPT_INLINE_CACHE
+// Inline cache of map lookups, one per bytecode function, indexed by the
+// bytecode offset of the LOAD_NAME/LOAD_GLOBAL/LOAD_ATTR/LOAD_METHOD/STORE_ATTR
+// opcode.  Each entry remembers the slot in the map where the name was last
+// found; the slot is only used if the map still holds the same key there.
+// A miss is remembered together with the number of used entries of the map
+// (modulo MP_INLINE_CACHE_SLOT_MASK), and expires when that number changes.
+// The MISS flag is only stored for attribute and local name lookups and the
+// BUILTIN flag only for global lookups, so they can share the same bit.
+#define MP_INLINE_CACHE_EMPTY (0xffff)
+#define MP_INLINE_CACHE_SLOT_MASK (0x7fff)
+#define MP_INLINE_CACHE_SLOT_MISS (0x8000)
+#define MP_INLINE_CACHE_SLOT_BUILTIN (0x8000)
+#define MP_INLINE_CACHE_MIN_SIZE (8)
+#define MP_INLINE_CACHE_MAX_SIZE (256)
+
+typedef struct _mp_inline_cache_entry_t {
+    uint16_t offset;
+    uint16_t slot;
+} mp_inline_cache_entry_t;
+
+typedef struct _mp_inline_cache_t {
+    uint16_t mask;
+    uint16_t n_evict;
+    mp_inline_cache_entry_t entry[];
+} mp_inline_cache_t;
+#endif
+
 typedef struct _mp_obj_fun_bc_t {
     mp_obj_base_t base;
     mp_obj_dict_t *globals;         // the context within which this function was defined
     const byte *bytecode;           // bytecode for the function
     const mp_uint_t *const_table;   // constant table
+    #if MICROPY_OPT_INLINE_CACHE
+    mp_inline_cache_t *inline_cache; // allocated on first lookup, may stay NULL
+    #endif
     // the following extra_args array is allocated space to take (in order):
     //  - values of positional default args (if any)
     //  - a single slot for default kw args dict (if it has them)
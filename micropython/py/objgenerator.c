@@ -33,6 +33,7 @@
 #include "py/objgenerator.h"
 #include "py/objfun.h"
 #include "py/stackctrl.h"
+#include "py/gc.h"
 
 /******************************************************************************/
 /* generator wrapper                                                          */
@@ -138,6 +139,8 @@ mp_vm_return_kind_t mp_obj_gen_resume(mp_obj_t self_in, mp_obj_t send_value, mp_
         *ret_val = MP_OBJ_STOP_ITERATION;
         return MP_VM_RETURN_NORMAL;
     }
+    // the frame is changed without the write barriers while the generator runs
+    GC_WRITE_BARRIER_OBJ(self);
     if (self->code_state.sp == self->code_state.state - 1) {
         if (send_value != mp_const_none) {
             mp_raise_TypeError("can't send non-None value to a just-started generator");
@@ -303,6 +306,7 @@ STATIC mp_obj_t gen_instance_pend_throw(mp_obj_t self_in, mp_obj_t exc_in) {
         mp_raise_TypeError("can't pend throw to just-started generator");
     }
     mp_obj_t prev = *self->code_state.sp;
+    GC_WRITE_BARRIER(prev);
     *self->code_state.sp = exc_in;
     return prev;
 }
@@ -30,6 +30,7 @@
 #include "py/objlist.h"
 #include "py/runtime.h"
 #include "py/stackctrl.h"
+#include "py/gc.h"
 
 STATIC mp_obj_t mp_obj_new_list_iterator(mp_obj_t list, size_t cur, mp_obj_iter_buf_t *iter_buf);
 STATIC mp_obj_list_t *list_new(size_t n);
@@ -164,6 +165,7 @@ STATIC mp_obj_t list_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
             mp_int_t len_adj = slice.start - slice.stop;
             //printf("Len adj: %d\n", len_adj);
             assert(len_adj <= 0);
+            GC_WRITE_BARRIER_OBJ(self->items);
             mp_seq_replace_slice_no_grow(self->items, self->len, slice.start, slice.stop, self->items/*NULL*/, 0, sizeof(*self->items));
             // Clear "freed" elements at the end of list
             mp_seq_clear(self->items, self->len + len_adj, self->len, sizeof(*self->items));
@@ -209,9 +211,11 @@ STATIC mp_obj_t list_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
                     self->items = m_renew(mp_obj_t, self->items, self->alloc, self->len + len_adj);
                     self->alloc = self->len + len_adj;
                 }
+                GC_WRITE_BARRIER_OBJ(self->items);
                 mp_seq_replace_slice_grow_inplace(self->items, self->len,
                     slice_out.start, slice_out.stop, value_items, value_len, len_adj, sizeof(*self->items));
             } else {
+                GC_WRITE_BARRIER_OBJ(self->items);
                 mp_seq_replace_slice_no_grow(self->items, self->len,
                     slice_out.start, slice_out.stop, value_items, value_len, sizeof(*self->items));
                 // Clear "freed" elements at the end of list
@@ -272,6 +276,8 @@ STATIC mp_obj_t list_pop(size_t n_args, const mp_obj_t *args) {
     }
     size_t index = mp_get_index(self->base.type, self->len, n_args == 1 ? MP_OBJ_NEW_SMALL_INT(-1) : args[1], false);
     mp_obj_t ret = self->items[index];
+    GC_WRITE_BARRIER(ret);
+    GC_WRITE_BARRIER_MOVE(self->items);
     self->len -= 1;
     memmove(self->items + index, self->items + index + 1, (self->len - index) * sizeof(mp_obj_t));
     // Clear stale pointer from slot which just got freed to prevent GC issues
@@ -293,10 +299,15 @@ STATIC void mp_quicksort(mp_obj_t *head, mp_obj_t *tail, mp_obj_t key_fn, mp_obj
             do ++h; while (h < t && mp_binary_op(MP_BINARY_OP_LESS, key_fn == MP_OBJ_NULL ? h[0] : mp_call_function_1(key_fn, h[0]), v) == binop_less_result);
             do --t; while (h < t && mp_binary_op(MP_BINARY_OP_LESS, v, key_fn == MP_OBJ_NULL ? t[0] : mp_call_function_1(key_fn, t[0])) == binop_less_result);
             if (h >= t) break;
+            // the key function can run a mark slice between the swaps
+            GC_WRITE_BARRIER(h[0]);
+            GC_WRITE_BARRIER(t[0]);
             mp_obj_t x = h[0];
             h[0] = t[0];
             t[0] = x;
         }
+        GC_WRITE_BARRIER(h[0]);
+        GC_WRITE_BARRIER(tail[0]);
         mp_obj_t x = h[0];
         h[0] = tail[0];
         tail[0] = x;
@@ -340,6 +351,7 @@ mp_obj_t mp_obj_list_sort(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_
 STATIC mp_obj_t list_clear(mp_obj_t self_in) {
     mp_check_self(mp_obj_is_type(self_in, &mp_type_list));
     mp_obj_list_t *self = MP_OBJ_TO_PTR(self_in);
+    GC_WRITE_BARRIER_OBJ(self->items);
     self->len = 0;
     self->items = m_renew(mp_obj_t, self->items, self->alloc, LIST_MIN_ALLOC);
     self->alloc = LIST_MIN_ALLOC;
@@ -404,6 +416,7 @@ STATIC mp_obj_t list_reverse(mp_obj_t self_in) {
     mp_obj_list_t *self = MP_OBJ_TO_PTR(self_in);
 
     mp_int_t len = self->len;
+    GC_WRITE_BARRIER_MOVE(self->items);
     for (mp_int_t i = 0; i < len/2; i++) {
          mp_obj_t a = self->items[i];
          self->items[i] = self->items[len-i-1];
@@ -493,6 +506,7 @@ void mp_obj_list_set_len(mp_obj_t self_in, size_t len) {
 void mp_obj_list_store(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
     mp_obj_list_t *self = MP_OBJ_TO_PTR(self_in);
     size_t i = mp_get_index(self->base.type, self->len, index, false);
+    GC_WRITE_BARRIER(self->items[i]);
     self->items[i] = value;
 }
 
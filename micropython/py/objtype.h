@@ -28,6 +28,10 @@
 
 #include "py/obj.h"
 
+// flags stored in mp_obj_type_t.flags for user classes
+#define TYPE_FLAG_IS_SUBCLASSED (0x0001)
+#define TYPE_FLAG_HAS_SPECIAL_ACCESSORS (0x0002)
+
 // instance object
 // creating an instance of a class makes one of these objects
 typedef struct _mp_obj_instance_t {
@@ -157,7 +157,7 @@ typedef struct _bytecode_prelude_t {
     uint code_info_size;
 } bytecode_prelude_t;
 
-#if MICROPY_PERSISTENT_CODE_SAVE || MICROPY_EMIT_NATIVE
+#if MICROPY_PERSISTENT_CODE_SAVE || MICROPY_EMIT_NATIVE || MICROPY_MODULE_FROZEN_XIP
 
 // ip will point to start of opcodes
 // ip2 will point to simple_name, source_file qstrs
@@ -405,12 +405,14 @@ STATIC mp_raw_code_t *load_raw_code(mp_reader_t *reader, qstr_window_t *qw) {
     }
 
     mp_uint_t *const_table = NULL;
+    size_t n_obj = 0;
+    size_t n_raw_code = 0;
     if (kind != MP_CODE_NATIVE_ASM) {
         // Load constant table for bytecode, native and viper
 
         // Number of entries in constant table
-        size_t n_obj = read_uint(reader, NULL);
-        size_t n_raw_code = read_uint(reader, NULL);
+        n_obj = read_uint(reader, NULL);
+        n_raw_code = read_uint(reader, NULL);
 
         // Allocate constant table
         size_t n_alloc = prelude.n_pos_args + prelude.n_kwonly_args + n_obj + n_raw_code;
@@ -511,6 +513,108 @@ mp_raw_code_t *mp_raw_code_load_file(const char *filename) {
 
 #endif // MICROPY_HAS_FILE_READER
 
+#if MICROPY_MODULE_FROZEN_XIP
+
+#include "py/objstr.h"
+
+// Raw code in a frozen XIP image has the same layout as in an .mpy file but
+// the qstrs are already linked: the bytecode is used in place and the qstrs
+// of the argument names are stored as plain numbers.  Only the raw code
+// structures, constant tables and constant objects are allocated in the heap.
+
+STATIC size_t xip_read_uint(const byte **ptr) {
+    size_t unum = 0;
+    for (;;) {
+        byte b = *(*ptr)++;
+        unum = (unum << 7) | (b & 0x7f);
+        if ((b & 0x80) == 0) {
+            break;
+        }
+    }
+    return unum;
+}
+
+STATIC mp_obj_t xip_load_obj(const byte **ptr) {
+    byte obj_type = *(*ptr)++;
+    if (obj_type == 'e') {
+        return MP_OBJ_FROM_PTR(&mp_const_ellipsis_obj);
+    }
+    size_t len = xip_read_uint(ptr);
+    const byte *data = *ptr;
+    *ptr += len;
+    if (obj_type == 's' || obj_type == 'b') {
+        // str and bytes are immutable, their data stays in the image
+        mp_obj_str_t *o = m_new_obj(mp_obj_str_t);
+        o->base.type = obj_type == 's' ? &mp_type_str : &mp_type_bytes;
+        o->hash = qstr_compute_hash(data, len);
+        o->len = len;
+        o->data = data;
+        return MP_OBJ_FROM_PTR(o);
+    } else if (obj_type == 'i') {
+        return mp_parse_num_integer((const char*)data, len, 10, NULL);
+    } else {
+        assert(obj_type == 'f' || obj_type == 'c');
+        return mp_parse_num_decimal((const char*)data, len, obj_type == 'c', false, NULL);
+    }
+}
+
+STATIC mp_raw_code_t *xip_load_raw_code(const byte **ptr) {
+    size_t kind_len = xip_read_uint(ptr);
+    if ((kind_len & 3) + MP_CODE_BYTECODE != MP_CODE_BYTECODE) {
+        mp_raise_ValueError("incompatible .mpy file");
+    }
+    size_t fun_data_len = kind_len >> 2;
+    const byte *fun_data = *ptr;
+    *ptr += fun_data_len;
+
+    const byte *ip = fun_data;
+    const byte *ip2;
+    bytecode_prelude_t prelude;
+    extract_prelude(&ip, &ip2, &prelude);
+
+    size_t n_obj = xip_read_uint(ptr);
+    size_t n_raw_code = xip_read_uint(ptr);
+    size_t n_arg = prelude.n_pos_args + prelude.n_kwonly_args;
+    mp_uint_t *const_table = m_new(mp_uint_t, n_arg + n_obj + n_raw_code);
+    mp_uint_t *ct = const_table;
+    for (size_t i = 0; i < n_arg; ++i) {
+        *ct++ = (mp_uint_t)MP_OBJ_NEW_QSTR(xip_read_uint(ptr));
+    }
+    for (size_t i = 0; i < n_obj; ++i) {
+        *ct++ = (mp_uint_t)xip_load_obj(ptr);
+    }
+    for (size_t i = 0; i < n_raw_code; ++i) {
+        *ct++ = (mp_uint_t)(uintptr_t)xip_load_raw_code(ptr);
+    }
+
+    mp_raw_code_t *rc = mp_emit_glue_new_raw_code();
+    mp_emit_glue_assign_bytecode(rc, fun_data,
+        #if MICROPY_PERSISTENT_CODE_SAVE || MICROPY_DEBUG_PRINTERS
+        fun_data_len,
+        #endif
+        const_table,
+        #if MICROPY_PERSISTENT_CODE_SAVE
+        n_obj, n_raw_code,
+        #endif
+        prelude.scope_flags);
+    return rc;
+}
+
+// Check the .mpy header stored in an XIP image; only bytecode can be used
+bool mp_raw_code_xip_header_ok(const byte *header) {
+    return header[0] == 'M'
+        && header[1] == MPY_VERSION
+        && MPY_FEATURE_DECODE_FLAGS(header[2]) == MPY_FEATURE_FLAGS
+        && MPY_FEATURE_DECODE_ARCH(header[2]) == MP_NATIVE_ARCH_NONE
+        && header[3] <= mp_small_int_bits();
+}
+
+mp_raw_code_t *mp_raw_code_load_xip(const byte *data) {
+    return xip_load_raw_code(&data);
+}
+
+#endif // MICROPY_MODULE_FROZEN_XIP
+
 #endif // MICROPY_PERSISTENT_CODE_LOAD
 
 #if MICROPY_PERSISTENT_CODE_SAVE
@@ -626,6 +730,7 @@ STATIC void save_raw_code(mp_print_t *print, mp_raw_code_t *rc, qstr_window_t *q
 
         // Save bytecode
         save_bytecode(print, qstr_window, ip, ip_top);
+    #if MICROPY_EMIT_NATIVE || MICROPY_EMIT_INLINE_ASM
     } else {
         // Save native code
         mp_print_bytes(print, rc->fun_data, rc->fun_data_len);
@@ -654,6 +759,7 @@ STATIC void save_raw_code(mp_print_t *print, mp_raw_code_t *rc, qstr_window_t *q
                 mp_print_uint(print, rc->type_sig);
             }
         }
+    #endif
     }
 
     if (rc->kind == MP_CODE_BYTECODE || rc->kind == MP_CODE_NATIVE_PY) {
@@ -750,21 +856,98 @@ void mp_raw_code_save(mp_raw_code_t *rc, mp_print_t *print) {
 
 #if defined(__i386__) || defined(__x86_64__) || defined(__unix__)
 
+#include <errno.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <fcntl.h>
-
-STATIC void fd_print_strn(void *env, const char *str, size_t len) {
-    int fd = (intptr_t)env;
-    ssize_t ret = write(fd, str, len);
-    (void)ret;
+#include "py/mperrno.h"
+
+typedef struct _fd_print_env_t {
+    int fd;
+    int error;
+} fd_print_env_t;
+
+STATIC void fd_print_strn(void *env_in, const char *str, size_t len) {
+    fd_print_env_t *env = env_in;
+    ssize_t ret = write(env->fd, str, len);
+    if (ret != (ssize_t)len && env->error == 0) {
+        env->error = (ret < 0) ? errno : MP_ENOSPC;
+    }
 }
 
 void mp_raw_code_save_file(mp_raw_code_t *rc, const char *filename) {
-    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-    mp_print_t fd_print = {(void*)(intptr_t)fd, fd_print_strn};
+    fd_print_env_t env = {open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644), 0};
+    if (env.fd < 0) {
+        mp_raise_OSError(errno);
+    }
+    mp_print_t fd_print = {&env, fd_print_strn};
     mp_raw_code_save(rc, &fd_print);
-    close(fd);
+    struct stat st;
+    bool regular = fstat(env.fd, &st) == 0 && S_ISREG(st.st_mode);
+    if (close(env.fd) != 0 && env.error == 0) {
+        env.error = errno;
+    }
+    if (env.error != 0) {
+        // don't leave an incomplete .mpy file behind (but never remove a device or a pipe)
+        if (regular) {
+            unlink(filename);
+        }
+        mp_raise_OSError(env.error);
+    }
+}
+
+#elif MICROPY_VFS
+
+#include "py/stream.h"
+#include "py/mperrno.h"
+#include "extmod/vfs.h"
+
+void mp_raw_code_save_file(mp_raw_code_t *rc, const char *filename) {
+    // create the file content in RAM first, so that an incomplete write
+    // (eg. file system full) can be detected
+    vstr_t vstr;
+    mp_print_t print;
+    vstr_init_print(&vstr, 256, &print);
+    mp_raw_code_save(rc, &print);
+
+    // the content is written to a temporary file which is renamed on success,
+    // an incomplete .mpy file is never left under the final name
+    size_t name_len = strlen(filename);
+    vstr_t tmp;
+    vstr_init(&tmp, name_len + 5);
+    vstr_add_strn(&tmp, filename, name_len);
+    vstr_add_str(&tmp, ".tmp");
+    mp_obj_t tmp_name = mp_obj_new_str(tmp.buf, tmp.len);
+    vstr_clear(&tmp);
+
+    mp_obj_t args[2] = {tmp_name, MP_OBJ_NEW_QSTR(MP_QSTR_wb)};
+    mp_obj_t file = mp_vfs_open(MP_ARRAY_SIZE(args), args, (mp_map_t*)&mp_const_empty_map);
+    volatile bool opened = true;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_obj_t n = mp_stream_write(file, vstr.buf, vstr.len, MP_STREAM_RW_WRITE);
+        if (n == mp_const_none || (size_t)MP_OBJ_SMALL_INT_VALUE(n) != vstr.len) {
+            mp_raise_OSError(MP_ENOSPC);
+        }
+        // closing the file flushes it, it can fail too
+        opened = false;
+        mp_stream_close(file);
+        mp_vfs_rename(tmp_name, mp_obj_new_str(filename, name_len));
+        nlr_pop();
+        vstr_clear(&vstr);
+    } else {
+        vstr_clear(&vstr);
+        // remove the incomplete file, errors are ignored, the original exception is raised
+        nlr_buf_t nlr_clean;
+        if (nlr_push(&nlr_clean) == 0) {
+            if (opened) {
+                mp_stream_close(file);
+            }
+            mp_vfs_remove(tmp_name);
+            nlr_pop();
+        }
+        nlr_jump(nlr.ret_val);
+    }
 }
 
 #else
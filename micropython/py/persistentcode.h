@@ -49,6 +49,10 @@ enum {
 mp_raw_code_t *mp_raw_code_load(mp_reader_t *reader);
 mp_raw_code_t *mp_raw_code_load_mem(const byte *buf, size_t len);
 mp_raw_code_t *mp_raw_code_load_file(const char *filename);
+#if MICROPY_MODULE_FROZEN_XIP
+bool mp_raw_code_xip_header_ok(const byte *header);
+mp_raw_code_t *mp_raw_code_load_xip(const byte *data);
+#endif
 
 void mp_raw_code_save(mp_raw_code_t *rc, mp_print_t *print);
 void mp_raw_code_save_file(mp_raw_code_t *rc, const char *filename);
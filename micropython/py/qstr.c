@@ -129,6 +129,20 @@ void qstr_init(void) {
     #endif
 }
 
+#if MICROPY_MODULE_FROZEN_XIP
+// Append a filled-in pool of qstrs whose data is not in the heap (eg in XIP
+// flash).  Its qstrs are numbered after all the qstrs added so far.
+void qstr_add_pool(qstr_pool_t *pool) {
+    QSTR_ENTER();
+    pool->prev = MP_STATE_VM(last_pool);
+    pool->total_prev_len = pool->prev->total_prev_len + pool->prev->len;
+    // as for the const pools, keep the next dynamic pool small
+    pool->alloc = MIN(pool->len, MICROPY_ALLOC_QSTR_ENTRIES_INIT);
+    MP_STATE_VM(last_pool) = pool;
+    QSTR_EXIT();
+}
+#endif
+
 STATIC const byte *find_qstr(qstr q) {
     // search pool for this qstr
     // total_prev_len==0 in the final pool, so the loop will always terminate
@@ -42,6 +42,7 @@
 #include "py/builtin.h"
 #include "py/stackctrl.h"
 #include "py/gc.h"
+#include "py/frozenmod.h"
 
 #if MICROPY_DEBUG_VERBOSE // print debugging info
 #define DEBUG_PRINT (1)
@@ -61,6 +62,11 @@ mp_obj_module_t mp_module___main__ = {
 void mp_init(void) {
     qstr_init();
 
+    #if MICROPY_MODULE_FROZEN_XIP
+    // the qstrs of the XIP module image must come before any dynamic qstr
+    mp_frozen_xip_init();
+    #endif
+
     // no pending exceptions to start with
     MP_STATE_VM(mp_pending_exception) = MP_OBJ_NULL;
     #if MICROPY_ENABLE_SCHEDULER
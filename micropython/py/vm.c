@@ -35,6 +35,10 @@
 #include "py/runtime.h"
 #include "py/bc0.h"
 #include "py/bc.h"
+#include "py/gc.h"
+#if MICROPY_OPT_INLINE_CACHE
+#include "py/builtin.h"
+#endif
 
 #if 0
 #define TRACE(ip) printf("sp=%d ", (int)(sp - &code_state->state[0] + 1)); mp_bytecode_print2(ip, 1, code_state->fun_bc->const_table);
@@ -109,6 +113,235 @@
     exc_sp--; /* pop back to previous exception handler */ \
     CLEAR_SYS_EXC_INFO() /* just clear sys.exc_info(), not compliant, but it shouldn't be used in 1st place */
 
+#if MICROPY_OPT_INLINE_CACHE
+
+#if MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
+#error MICROPY_OPT_INLINE_CACHE and MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE are mutually exclusive
+#endif
+#if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
+#error MICROPY_OPT_INLINE_CACHE requires MICROPY_PY_THREAD_GIL
+#endif
+
+// The cache is a small direct-mapped table hanging off the function object,
+// indexed by the offset of the opcode in the bytecode.  An entry only holds
+// a slot index; it is used if map->table[slot] still holds the looked-up key,
+// which stays correct whatever happens to the map (rehash, deletion, or a
+// completely different map being passed at that opcode), so no invalidation
+// is needed.
+
+STATIC mp_inline_cache_t *vm_ic_new(size_t size) {
+    mp_inline_cache_t *ic = m_new_obj_var_maybe(mp_inline_cache_t, mp_inline_cache_entry_t, size);
+    if (ic != NULL) {
+        ic->mask = size - 1;
+        ic->n_evict = 0;
+        for (size_t i = 0; i < size; ++i) {
+            ic->entry[i].offset = MP_INLINE_CACHE_EMPTY;
+        }
+    }
+    return ic;
+}
+
+static inline size_t vm_ic_get(const mp_obj_fun_bc_t *fun, size_t offset) {
+    const mp_inline_cache_t *ic = fun->inline_cache;
+    if (ic != NULL) {
+        const mp_inline_cache_entry_t *e = &ic->entry[offset & ic->mask];
+        if (e->offset == offset) {
+            return e->slot;
+        }
+    }
+    return MP_INLINE_CACHE_EMPTY;
+}
+
+STATIC void vm_ic_put(mp_obj_fun_bc_t *fun, size_t offset, size_t slot) {
+    if (offset >= MP_INLINE_CACHE_EMPTY) {
+        // huge function, opcode can't be cached
+        return;
+    }
+    mp_inline_cache_t *ic = fun->inline_cache;
+    if (ic == NULL) {
+        // first lookup in this function; if the heap is full just don't cache
+        ic = vm_ic_new(MP_INLINE_CACHE_MIN_SIZE);
+        if (ic == NULL) {
+            return;
+        }
+        fun->inline_cache = ic;
+    }
+    mp_inline_cache_entry_t *e = &ic->entry[offset & ic->mask];
+    if (e->offset != MP_INLINE_CACHE_EMPTY && e->offset != offset
+        && ++ic->n_evict > ic->mask && ic->mask + 1U < MP_INLINE_CACHE_MAX_SIZE) {
+        // too many opcodes compete for the entries, double the table; each old
+        // entry i goes to i or i + old size, so there are no collisions here
+        size_t old_size = ic->mask + 1;
+        mp_inline_cache_t *ic2 = vm_ic_new(old_size * 2);
+        if (ic2 != NULL) {
+            for (size_t i = 0; i < old_size; ++i) {
+                if (ic->entry[i].offset != MP_INLINE_CACHE_EMPTY) {
+                    ic2->entry[ic->entry[i].offset & ic2->mask] = ic->entry[i];
+                }
+            }
+            m_del_var(mp_inline_cache_t, mp_inline_cache_entry_t, old_size, ic);
+            fun->inline_cache = ic = ic2;
+            e = &ic->entry[offset & ic->mask];
+        }
+    }
+    e->offset = offset;
+    e->slot = slot;
+}
+
+// The tag of a remembered miss, never equal to the low bits of MP_INLINE_CACHE_EMPTY
+static inline size_t vm_ic_miss_tag(const mp_map_t *map) {
+    return MP_INLINE_CACHE_SLOT_MISS | (map->used % MP_INLINE_CACHE_SLOT_MASK);
+}
+
+// Look up key in map, trying the cached slot first.  Returns NULL if the key
+// is not in the map, or was not in it the last time this opcode looked and
+// the number of entries in the map hasn't changed since then (a key can't be
+// added without changing it, unless another one is removed at the same time).
+// NULL only means the caller has to do the complete lookup.
+STATIC mp_map_elem_t *vm_ic_map_lookup(mp_obj_fun_bc_t *fun, size_t offset, mp_map_t *map, mp_obj_t key) {
+    size_t slot = vm_ic_get(fun, offset);
+    if (slot < map->alloc && map->table[slot].key == key) {
+        return &map->table[slot];
+    }
+    if (slot == vm_ic_miss_tag(map)) {
+        return NULL;
+    }
+    mp_map_elem_t *elem = mp_map_lookup(map, key, MP_MAP_LOOKUP);
+    slot = vm_ic_miss_tag(map);
+    if (elem != NULL && (size_t)(elem - map->table) < MP_INLINE_CACHE_SLOT_MASK) {
+        slot = elem - map->table;
+    }
+    vm_ic_put(fun, offset, slot);
+    return elem;
+}
+
+STATIC mp_obj_t vm_ic_load_global(mp_obj_fun_bc_t *fun, size_t offset, qstr qst) {
+    mp_obj_t key = MP_OBJ_NEW_QSTR(qst);
+    mp_map_t *map = &mp_globals_get()->map;
+    mp_map_t *builtins_map = (mp_map_t*)&mp_module_builtins_globals.map;
+    size_t slot = vm_ic_get(fun, offset);
+    if (slot < map->alloc && map->table[slot].key == key) {
+        return map->table[slot].value;
+    }
+    if (slot != MP_INLINE_CACHE_EMPTY && (slot & MP_INLINE_CACHE_SLOT_BUILTIN)) {
+        // a builtin is only valid while no global shadows it
+        slot &= ~MP_INLINE_CACHE_SLOT_BUILTIN;
+        if (slot < builtins_map->alloc && builtins_map->table[slot].key == key
+            #if MICROPY_CAN_OVERRIDE_BUILTINS
+            && MP_STATE_VM(mp_module_builtins_override_dict) == NULL
+            #endif
+            && mp_map_lookup(map, key, MP_MAP_LOOKUP) == NULL) {
+            return builtins_map->table[slot].value;
+        }
+    }
+    mp_map_elem_t *elem = mp_map_lookup(map, key, MP_MAP_LOOKUP);
+    if (elem != NULL) {
+        if ((size_t)(elem - map->table) < MP_INLINE_CACHE_SLOT_MASK) {
+            vm_ic_put(fun, offset, elem - map->table);
+        }
+        return elem->value;
+    }
+    #if MICROPY_CAN_OVERRIDE_BUILTINS
+    if (MP_STATE_VM(mp_module_builtins_override_dict) == NULL)
+    #endif
+    {
+        elem = mp_map_lookup(builtins_map, key, MP_MAP_LOOKUP);
+        if (elem != NULL && (size_t)(elem - builtins_map->table) < MP_INLINE_CACHE_SLOT_MASK) {
+            vm_ic_put(fun, offset, MP_INLINE_CACHE_SLOT_BUILTIN | (elem - builtins_map->table));
+        }
+    }
+    // let the runtime do the complete lookup and raise NameError if needed
+    return mp_load_global(qst);
+}
+
+STATIC mp_obj_t vm_ic_load_name(mp_obj_fun_bc_t *fun, size_t offset, qstr qst) {
+    mp_obj_dict_t *locals = mp_locals_get();
+    if (locals == mp_globals_get()) {
+        // module level code
+        return vm_ic_load_global(fun, offset, qst);
+    }
+    mp_map_elem_t *elem = vm_ic_map_lookup(fun, offset, &locals->map, MP_OBJ_NEW_QSTR(qst));
+    if (elem != NULL) {
+        return elem->value;
+    }
+    return mp_load_name(qst);
+}
+
+// Return the map holding the attributes of base if loading attr from it is a
+// plain lookup in that map, as done by mp_load_method_maybe.
+STATIC mp_map_t *vm_ic_attr_map(mp_obj_t base, const mp_obj_type_t *type, qstr attr) {
+    #if MICROPY_CPYTHON_COMPAT
+    if (attr == MP_QSTR___class__) {
+        return NULL;
+    }
+    #endif
+    if (attr == MP_QSTR___next__ && type->iternext != NULL) {
+        return NULL;
+    }
+    if (mp_obj_is_instance_type(type)) {
+        // instance members come before anything in the class
+        return &((mp_obj_instance_t*)MP_OBJ_TO_PTR(base))->members;
+    }
+    if (type == &mp_type_module) {
+        return &mp_obj_module_get_globals(base)->map;
+    }
+    if (type->attr == NULL && type->locals_dict != NULL) {
+        return &type->locals_dict->map;
+    }
+    return NULL;
+}
+
+STATIC mp_obj_t vm_ic_load_attr(mp_obj_fun_bc_t *fun, size_t offset, mp_obj_t base, qstr qst) {
+    mp_obj_type_t *type = mp_obj_get_type(base);
+    mp_map_t *map = vm_ic_attr_map(base, type, qst);
+    // native type methods need binding, leave them to mp_load_attr
+    if (map != NULL && type->attr != NULL) {
+        mp_map_elem_t *elem = vm_ic_map_lookup(fun, offset, map, MP_OBJ_NEW_QSTR(qst));
+        if (elem != NULL) {
+            return elem->value;
+        }
+    }
+    return mp_load_attr(base, qst);
+}
+
+STATIC void vm_ic_load_method(mp_obj_fun_bc_t *fun, size_t offset, mp_obj_t base, qstr qst, mp_obj_t *dest) {
+    mp_obj_type_t *type = mp_obj_get_type(base);
+    mp_map_t *map = vm_ic_attr_map(base, type, qst);
+    if (map != NULL) {
+        mp_map_elem_t *elem = vm_ic_map_lookup(fun, offset, map, MP_OBJ_NEW_QSTR(qst));
+        if (elem != NULL) {
+            dest[0] = elem->value;
+            dest[1] = MP_OBJ_NULL;
+            if (type->attr == NULL) {
+                // found in the locals dict of a native type
+                mp_convert_member_lookup(base, type, elem->value, dest);
+            }
+            return;
+        }
+    }
+    mp_load_method(base, qst, dest);
+}
+
+STATIC void vm_ic_store_attr(mp_obj_fun_bc_t *fun, size_t offset, mp_obj_t base, qstr qst, mp_obj_t value) {
+    mp_obj_type_t *type = mp_obj_get_type(base);
+    // an existing member can be overwritten directly, unless the class has
+    // __setattr__, properties or descriptors which may intercept the store
+    if (mp_obj_is_instance_type(type) && !(type->flags & TYPE_FLAG_HAS_SPECIAL_ACCESSORS)
+        && value != MP_OBJ_NULL) {
+        mp_map_elem_t *elem = vm_ic_map_lookup(fun, offset, &((mp_obj_instance_t*)MP_OBJ_TO_PTR(base))->members, MP_OBJ_NEW_QSTR(qst));
+        if (elem != NULL) {
+            GC_WRITE_BARRIER(elem->value);
+            elem->value = value;
+            return;
+        }
+    }
+    mp_store_attr(base, qst, value);
+}
+
+#define IC_OFFSET() ((size_t)(ip - code_state->fun_bc->bytecode))
+
+#endif // MICROPY_OPT_INLINE_CACHE
+
 // fastn has items in reverse order (fastn[0] is local[0], fastn[-1] is local[1], etc)
 // sp points to bottom of stack which grows up
 // returns:
@@ -264,7 +497,14 @@ dispatch_loop:
                     goto load_check;
                 }
 
-                #if !MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
+                #if MICROPY_OPT_INLINE_CACHE
+                ENTRY(MP_BC_LOAD_NAME): {
+                    MARK_EXC_IP_SELECTIVE();
+                    DECODE_QSTR;
+                    PUSH(vm_ic_load_name(code_state->fun_bc, IC_OFFSET(), qst));
+                    DISPATCH();
+                }
+                #elif !MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
                 ENTRY(MP_BC_LOAD_NAME): {
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
@@ -293,7 +533,14 @@ dispatch_loop:
                 }
                 #endif
 
-                #if !MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
+                #if MICROPY_OPT_INLINE_CACHE
+                ENTRY(MP_BC_LOAD_GLOBAL): {
+                    MARK_EXC_IP_SELECTIVE();
+                    DECODE_QSTR;
+                    PUSH(vm_ic_load_global(code_state->fun_bc, IC_OFFSET(), qst));
+                    DISPATCH();
+                }
+                #elif !MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
                 ENTRY(MP_BC_LOAD_GLOBAL): {
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
@@ -322,7 +569,14 @@ dispatch_loop:
                 }
                 #endif
 
-                #if !MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
+                #if MICROPY_OPT_INLINE_CACHE
+                ENTRY(MP_BC_LOAD_ATTR): {
+                    MARK_EXC_IP_SELECTIVE();
+                    DECODE_QSTR;
+                    SET_TOP(vm_ic_load_attr(code_state->fun_bc, IC_OFFSET(), TOP(), qst));
+                    DISPATCH();
+                }
+                #elif !MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
                 ENTRY(MP_BC_LOAD_ATTR): {
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
@@ -363,7 +617,11 @@ dispatch_loop:
                 ENTRY(MP_BC_LOAD_METHOD): {
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
+                    #if MICROPY_OPT_INLINE_CACHE
+                    vm_ic_load_method(code_state->fun_bc, IC_OFFSET(), *sp, qst, sp);
+                    #else
                     mp_load_method(*sp, qst, sp);
+                    #endif
                     sp += 1;
                     DISPATCH();
                 }
@@ -414,7 +672,15 @@ dispatch_loop:
                     DISPATCH();
                 }
 
-                #if !MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
+                #if MICROPY_OPT_INLINE_CACHE
+                ENTRY(MP_BC_STORE_ATTR): {
+                    MARK_EXC_IP_SELECTIVE();
+                    DECODE_QSTR;
+                    vm_ic_store_attr(code_state->fun_bc, IC_OFFSET(), sp[0], qst, sp[-1]);
+                    sp -= 2;
+                    DISPATCH();
+                }
+                #elif !MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
                 ENTRY(MP_BC_STORE_ATTR): {
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
@@ -447,6 +713,7 @@ dispatch_loop:
                                 goto store_attr_cache_fail;
                             }
                         }
+                        GC_WRITE_BARRIER(elem->value);
                         elem->value = sp[-1];
                         sp -= 2;
                         ip++;
@@ -0,0 +1,124 @@
+# Incremental ujson: load() reads its stream in chunks, loads() parses str,
+# bytes and bytearray in place, a schema keeps only the listed members, the
+# Parser events and the Writer output (the same text as dumps())
+import ujson
+import host
+
+TMP = '/tmp/mphost_ujson_stream.json'
+
+DOC = ('{"device": "gw", "n": 3, "records": ['
+       '{"id": 1, "name": "a\\"b", "loc": {"lat": 1.5, "lon": -2}, "vals": [1, 2.5, null], "ok": true}, '
+       '{"id": 2, "name": "\\u00b5s", "loc": {"lat": 0, "lon": 0}, "vals": [], "ok": false}], '
+       '"extra": [[1, [2, {"x": 3}]], "s"]}')
+
+def write_file(text):
+    f = host.file(TMP, 'w')
+    f.write(text)
+    f.close()
+
+def read_file():
+    f = host.file(TMP, 'r')
+    text = f.read().decode()
+    f.close()
+    return text
+
+def error(f):
+    try:
+        f()
+    except ValueError:
+        return 'ValueError'
+    return 'no error'
+
+# the same result from all sources, strings and numbers across the read chunks
+ref = ujson.loads(DOC)
+print('str', ref['records'][0]['name'], ref['records'][1]['name'], ref['records'][0]['loc']['lat'])
+print('bytes', ujson.loads(DOC.encode()) == ref, ujson.loads(bytearray(DOC.encode())) == ref)
+long_doc = '{"list": [' + ', '.join('{"s": "%s\\n\\u00e9", "v": %d.25}' % ('x' * (i % 300), i) for i in range(200)) + ']}'
+write_file(long_doc)
+host.calls()
+obj = ujson.load(host.cfile(TMP, 'r'))
+calls = host.calls()
+print('stream', obj == ujson.loads(long_doc), obj['list'][199]['s'][-3:] == 'x\né', obj['list'][7]['v'])
+print('read calls', calls <= len(long_doc) // 128 + 3)
+
+# schema filtered load
+print('schema', ujson.loads(DOC, {'records': {'id': 0, 'vals': 0}}) ==
+      {'records': [{'id': 1, 'vals': [1, 2.5, None]}, {'id': 2, 'vals': []}]})
+print('schema list', ujson.loads(DOC, {'records': [{'loc': {'lat': 0}}]}) ==
+      {'records': [{'loc': {'lat': 1.5}}, {'loc': {'lat': 0}}]})
+print('schema missing', ujson.loads(DOC, {'nope': 0, 'n': 0}) == {'n': 3})
+write_file(DOC)
+print('schema stream', ujson.load(host.file(TMP, 'r'), {'device': 0}) == {'device': 'gw'})
+
+# Parser events
+p = ujson.Parser('{"a": [1, "x", true, null, {"b": 2.5}], "c": false}')
+for ev in p:
+    print(ev, p.depth(), p.value())
+
+# member keys of the top level object, the values skipped or loaded
+p = ujson.Parser(host.file(TMP, 'r'))
+keys = []
+for ev in p:
+    if ev == 'map_key' and p.depth() == 1:
+        keys.append(p.value())
+        if p.value() == 'records':
+            print('load', p.load({'id': 0}))
+        else:
+            p.skip()
+print('keys', keys)
+
+# each record loaded from the array
+p = ujson.Parser(DOC.encode())
+for ev in p:
+    if ev == 'start_map' and p.depth() == 3:
+        print('record', p.load({'id': 0, 'vals': 0}))
+
+# concatenated documents
+p = ujson.Parser('{"a": 1} [2] 3 "s"')
+print('concatenated', [ev for ev in p])
+
+# nesting limit and malformed documents
+print('depth 64', error(lambda: [ev for ev in ujson.Parser('[' * 64 + ']' * 64)]))
+print('depth 65', error(lambda: [ev for ev in ujson.Parser('[' * 65 + ']' * 65)]))
+print('unclosed', error(lambda: [ev for ev in ujson.Parser('{"a": [1, 2}')]))
+print('loads unclosed', error(lambda: ujson.loads('{"a": [1, 2')))
+
+# Writer output is the same as dumps(), written when a top level value is complete
+recs = ref['records']
+f = host.cfile(TMP, 'w')
+host.calls()
+w = ujson.Writer(f)
+w.start_map()
+w.key('records')
+w.start_array()
+for r in recs:
+    w.value(r)
+w.end_array()
+w.key('n')
+w.value(2)
+w.key('empty')
+w.start_map()
+w.end_map()
+print('writer calls before end', host.calls())
+w.end_map()
+calls = host.calls()
+f.close()
+print('writer', read_file() == '{"records": ' + ujson.dumps(recs) + ', "n": 2, "empty": {}}', calls <= 2)
+
+f = host.file(TMP, 'w')
+w = ujson.Writer(f)
+print('key in array', error(lambda: (w.start_array(), w.key('a'))))
+print('end map in array', error(lambda: w.end_map()))
+w.end_array()
+print('value without key', error(lambda: (w.start_map(), w.value(1))))
+f.close()
+
+# dump() writes in chunks
+big = {'records': [{'id': i, 'name': 'sensor-%04d' % i, 'vals': [i * 0.5] * 6, 'ok': True} for i in range(100)]}
+f = host.cfile(TMP, 'w')
+host.calls()
+ujson.dump(big, f)
+calls = host.calls()
+f.close()
+text = read_file()
+print('dump', text == ujson.dumps(big), calls <= len(text) // 128 + 2)
@@ -0,0 +1,54 @@
+# uzlib compressor: compress() and CompressIO in the zlib, gzip and raw deflate
+# formats, decompressed with decompress() and DecompIO; flush() makes all data
+# written so far decodable, close() finishes the stream
+import uzlib
+import uio as io
+import host
+
+TMP = '/tmp/mphost_uzlib_compress.bin'
+
+text = b''.join(b'%d I [SENSOR] temp=%d.%d hum=%d\n' % (1560000000 + i * 2, 20 + i % 5, i % 10, 40 + i % 7) for i in range(600))
+data = bytes((i * 7 + (i >> 5)) & 0xff for i in range(3000)) + text
+
+c = uzlib.compress(data)
+print('zlib', c[0] == 0x48, len(c) < len(data) // 3, uzlib.decompress(c) == data)
+for level in (1, 9):
+    for wbits in (9, 15):
+        print('level', level, 'wbits', wbits, uzlib.decompress(uzlib.compress(data, level, wbits)) == data)
+c = uzlib.compress(data, 6, -12)
+print('raw', uzlib.decompress(c, -12) == data)
+c = uzlib.compress(data, 6, 16 + 12)
+print('gzip', c[:3] == b'\x1f\x8b\x08', uzlib.DecompIO(io.BytesIO(c), 16 + 12).read() == data)
+print('empty', uzlib.decompress(uzlib.compress(b'')) == b'', uzlib.decompress(uzlib.compress(bytearray(b'a'))) == b'a')
+
+# CompressIO, the data written in pieces, with a sync flush in the middle
+f = host.file(TMP, 'w')
+with uzlib.CompressIO(f, 6, 12) as z:
+    for i in range(0, len(data), 500):
+        z.write(data[i:i + 500])
+        if i == 2000:
+            z.flush()
+f.close()
+c = host.file(TMP, 'r').read()
+print('CompressIO', uzlib.decompress(c) == data)
+
+# after flush() all written data decodes, the stream continues
+buf = io.BytesIO()
+z = uzlib.CompressIO(buf, 6, -10)
+z.write(text[:1000])
+z.flush()
+d = uzlib.DecompIO(io.BytesIO(buf.getvalue()), -10)
+print('flush', d.read(1000) == text[:1000])
+z.write(text[1000:])
+z.close()
+print('close', uzlib.decompress(buf.getvalue(), -10) == text)
+try:
+    z.write(b'x')
+except OSError:
+    print('write after close OSError')
+
+for wbits in (8, 16, -16, 32):
+    try:
+        uzlib.compress(data, 6, wbits)
+    except ValueError:
+        print('wbits', wbits, 'ValueError')
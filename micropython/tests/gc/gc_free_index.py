@@ -0,0 +1,38 @@
+# Allocations of 8 blocks or more search the free run index (a chunk is 256
+# blocks).  On a heap fragmented by small objects, medium and large objects
+# are allocated in the runs freed between them and in the runs spanning
+# chunks; all of them must keep their contents
+import gc
+
+def fragment(n, keep):
+    objs = [(i,) for i in range(n)]
+    return [objs[i] for i in range(0, n, keep)]
+
+def medium(n, v):
+    # one heap block for every two items
+    return tuple([v] * (n * 2 - 2))
+
+def check(o, n, v):
+    return len(o) == n * 2 - 2 and o[0] == v and o[-1] == v
+
+size = lambda i: 8 + (i * 37) % 300
+
+gc.collect()
+small = fragment(30000, 3)
+h = [medium(size(i), i) for i in range(300)]
+for r in range(1, 6):
+    # free every other object (a different half in each round) and refill
+    for i in range(r % 2, 300, 2):
+        h[i] = None
+    gc.collect()
+    for i in range(r % 2, 300, 2):
+        h[i] = medium(size(i + r), i + r)
+    small.extend(fragment(300, 7))
+print('refill', all(check(h[i], size(i + 4 + i % 2), i + 4 + i % 2) for i in range(300)))
+
+# all medium objects freed: the merged runs span chunk borders
+h = None
+gc.collect()
+big = [medium(2000, i) for i in range(10)]
+print('large', all(check(big[i], 2000, i) for i in range(10)))
+print('small', all(small[i][0] == i * 3 for i in range(10000)))
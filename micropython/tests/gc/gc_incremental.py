@@ -0,0 +1,122 @@
+# The incremental mark phase: the objects reachable while it runs are kept,
+# whatever the program changes between the mark slices. The values are moved
+# between the containers, the only reference to an object is often in a slot
+# which is overwritten or removed (the write barrier keeps it).
+import gc
+
+seed = 1
+def rand(n):
+    global seed
+    seed = (seed * 1103515245 + 12345) & 0x3fffffff
+    return (seed >> 8) % n
+
+def item(r):
+    return [r, str(r)]
+
+def check(x):
+    assert x[1] == str(x[0]), x
+
+class Node:
+    def __init__(self, v):
+        self.v = v
+        self.n = None
+
+def gen(n):
+    # the generator frame is changed when resumed
+    a = item(-1)
+    for i in range(n):
+        b = a
+        a = item(i)
+        yield b
+
+def run(rounds):
+    d = {}
+    lst = [item(i) for i in range(50)]
+    # the large blocks are checked in parts, the items are moved down by pop()
+    big = [item(i) if i % 4 == 0 else i for i in range(3000)]
+    st = set()
+    holder = [None] * 16
+    obj = Node(item(0))
+    cell = item(0)
+    def get_cell():
+        return cell
+    g = gen(1 << 30)
+    for r in range(rounds):
+        op = rand(14)
+        k = rand(64)
+        if op == 0:
+            d[k] = item(r)
+        elif op == 1:
+            x = d.pop(k, None)
+            if x is not None:
+                holder[rand(16)] = [x]
+        elif op == 2:
+            lst[rand(len(lst))] = item(r)
+        elif op == 3:
+            holder[rand(16)] = [lst.pop(rand(len(lst)))]
+            lst.append(item(r))
+        elif op == 4:
+            st.add(str(k))
+            st.discard(str(rand(64)))
+        elif op == 5:
+            obj.v, obj.n = item(r), Node(obj.v)
+        elif op == 6:
+            cell = item(r)
+        elif op == 7:
+            holder[rand(16)] = [next(g), next(g)]
+        elif op == 8:
+            lst.sort(key=lambda x: (x[0] * 7) % 13)
+        elif op == 9:
+            del lst[0:3]
+            lst.extend(item(r + i) for i in range(3))
+        elif op == 10:
+            x = holder[rand(16)]
+            holder[rand(16)] = None
+            if x is not None:
+                d[k] = x[0]
+        elif op == 11:
+            lst.insert(rand(len(lst)), item(r))
+            lst.remove(lst[rand(len(lst))])
+        elif op == 12:
+            x = big.pop(rand(8))
+            big.append(item(r) if type(x) is list else x)
+        elif rand(32) == 0:
+            big.sort(key=lambda x: (x[0] if type(x) is list else x) % 13)
+        else:
+            big.reverse()
+        # garbage, the marking is paced by the allocations
+        tmp = [str(i) for i in range(rand(40))]
+    for x in d.values():
+        check(x)
+    for x in lst:
+        check(x)
+    for x in big:
+        if type(x) is list:
+            check(x)
+    for h in holder:
+        if h is not None:
+            for x in h:
+                check(x)
+    check(get_cell())
+    while obj is not None:
+        check(obj.v)
+        obj = obj.n
+    return len(lst), len(big), len(st) <= 64
+
+for us in (0, 1, 20, 500):
+    gc.incremental(us)
+    gc.threshold(64000)
+    gc.collect()
+    print(us, run(3000))
+
+# the pauses are counted, the incremental mark phase is finished by gc.collect()
+gc.incremental(10)
+gc.collect()
+gc.stats(True)
+l = [[i] for i in range(20000)]
+n = gc.collect()
+st = gc.stats()
+print(n >= 0, st[0] >= 2, sum(st[3]) == st[0])
+gc.incremental(0)
+gc.threshold(-1)
+print(gc.incremental())
@@ -0,0 +1,26 @@
+# gc.collect() returns the number of the freed objects with any sweep slice time,
+# and the objects allocated while the sweep is pending are kept
+import gc
+
+for us in (0, 1, 50, 1000):
+    gc.lazy_sweep(us)
+    gc.collect()
+    for i in range(3):
+        l = [[j] for j in range(3000)]
+        l = None
+        keep = [str(j) for j in range(500)]
+        n = gc.collect()
+        print(us, n >= 6000)
+        # allocate while the sweep is pending, nothing reachable may be freed
+        more = [bytearray(32) for j in range(500)]
+        gc.collect()
+        assert keep == [str(j) for j in range(500)]
+        assert all(len(b) == 32 for b in more)
+print(gc.lazy_sweep())
+
+# the pause statistics count every collection
+gc.stats(True)
+for i in range(5):
+    gc.collect()
+st = gc.stats()
+print(st[0] >= 5, len(st[3]), sum(st[3]) == st[0], st[1] <= st[2])
@@ -0,0 +1,59 @@
+# No-scan allocations (bytes, bytearray, array, vstr data): their content is
+# never taken for heap pointers.  A bytearray holding the address of a garbage
+# object must not keep it alive, the no-scan flag must survive a reallocation,
+# and the data of the no-scan blocks must survive the collections.
+# The garbage object takes more than 100 KB, the references at most 17 KB
+import gc
+import ustruct as struct
+import array
+import host
+
+def garbage_addr():
+    g = [[i] for i in range(2000)]
+    return id(g)
+
+gc.collect()
+base = host.used()
+ref = bytearray(struct.pack('<Q', garbage_addr()) * 16)
+gc.collect()
+print('bytearray', host.used() - base < 1000)
+
+ref.extend(struct.pack('<Q', garbage_addr()) * 1000)
+gc.collect()
+print('bytearray extended', host.used() - base < 20000)
+
+ref = None
+gc.collect()
+base = host.used()
+ref = array.array('Q', [garbage_addr()] * 16)
+gc.collect()
+print('array', host.used() - base < 1000)
+
+ref = None
+gc.collect()
+base = host.used()
+ref = struct.pack('<Q', garbage_addr()) * 16
+gc.collect()
+print('bytes', host.used() - base < 1000)
+
+# the items of an object array are still scanned
+ref = None
+keep = [[i] for i in range(100)]
+keep = [keep]
+gc.collect()
+junk = [[j * 3] for j in range(20000)]
+junk = None
+gc.collect()
+print('list', keep[0][99] == [99])
+
+# data of the no-scan blocks
+data = [bytearray(range(i, i + 200)) for i in range(50)]
+strs = ['%d-%s' % (i, 'x' * i) for i in range(50)]
+for r in range(3):
+    junk = [bytes(100) for j in range(5000)]
+    junk = None
+    gc.collect()
+ok = True
+for i in range(50):
+    ok = ok and data[i] == bytearray(range(i, i + 200)) and strs[i] == '%d-%s' % (i, 'x' * i)
+print('data', ok)
@@ -0,0 +1,30 @@
+# gc.parallel() on and off.
+# Children allocated below their parents, the parents overflow the mark stack:
+# the overflow rescan reaches a parent after its children, and the children it
+# shares into the mark pool must still be traced before the sweep
+import gc
+
+def build(r):
+    kids = [[[i * 7 + r]] for i in range(100 * 40)]
+    parents = []
+    for p in range(100):
+        parents.append(kids[p * 40:(p + 1) * 40])
+    kids = None
+    return parents
+
+def check(parents, r):
+    for p in range(100):
+        for k in range(40):
+            if parents[p][k][0] != [(p * 40 + k) * 7 + r]:
+                return False
+    return True
+
+ok = True
+for r in range(6):
+    gc.parallel(r % 2 == 0)
+    t = build(r)
+    gc.collect()
+    junk = [[j] for j in range(20000)]
+    junk = None
+    ok = ok and check(t, r)
+print(ok)
@@ -0,0 +1,51 @@
+# Allocation latency on a fragmented heap: the heap is filled to 60% with
+# 1-4 block objects, of which 50%, 20% or 5% are kept, then 3000 medium
+# (8-63 blocks) bytearrays are allocated.  The allocations of 8 blocks or more
+# use the free run index; compare with a build without it:
+#   make -C ../ports/host CFLAGS_EXTRA=-DMICROPY_GC_FREE_INDEX=0 BUILD=build-noindex PROG=mphost-noindex
+#   HEAP=8000000 MPHOST=../ports/host/mphost-noindex ./run-tests.sh --perf perf/gc_alloc_fragmented.py
+# 'layout' is a checksum of the allocated addresses, the same in both builds
+import gc
+import host
+
+def fragment(fill, keep):
+    objs = []
+    i = 0
+    while gc.mem_alloc() < fill:
+        for j in range(1000):
+            objs.append((i,) * (1 + i % 5))
+            i += 1
+    return [objs[j] for j in range(0, len(objs), keep)]
+
+def allocate(n, base):
+    seed = 1
+    total = 0
+    worst = 0
+    layout = 0
+    live = []
+    for i in range(n):
+        seed = (seed * 1103515245 + 12345) & 0x7fffffff
+        size = (8 + seed % 56) * 16 - 8
+        t = host.ticks_us()
+        b = bytearray(size)
+        t = host.ticks_us() - t
+        total += t
+        if t > worst:
+            worst = t
+        layout = (layout * 31 + id(b) - base) & 0xffffff
+        live.append(b)
+    return total, worst, layout
+
+anchor = bytearray(16)
+gc.collect()
+heap = gc.mem_alloc() + gc.mem_free()
+print('heap %d KB' % (heap // 1024))
+for keep in (2, 5, 20):
+    gc.collect()
+    small = fragment(heap * 6 // 10, keep)
+    gc.collect()
+    gc.disable()
+    total, worst, layout = allocate(3000, id(anchor))
+    gc.enable()
+    print('kept %2d%%: mean %5d us, max %6d us, layout %06x' % (100 // keep, total // 3000, worst, layout))
+    small = None
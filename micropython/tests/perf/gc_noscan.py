@@ -0,0 +1,59 @@
+# GC pause time versus heap contents: the same number of small objects plus
+# 0 .. 2.4 MB of bytearray buffers, filled with zeros or with words which look
+# like heap addresses (random pixel data on a heap at a low address).
+# With no-scan allocations the pause does not depend on the buffer payload;
+# compare with a build without them:
+#   make -C ../ports/host CFLAGS_EXTRA=-DMICROPY_GC_NOSCAN=0 BUILD=build-nonoscan PROG=mphost-nonoscan
+#   MPHOST=../ports/host/mphost-nonoscan ./run-tests.sh --perf perf/gc_noscan.py
+# 'retained' is the garbage kept alive by the buffer contents
+import gc
+import array
+import host
+
+BUF_SIZE = 48 * 1024
+
+def fill(kind, pattern):
+    if kind == 'addr':
+        p = bytes(pattern)
+        return bytearray(p * (BUF_SIZE // len(p)))
+    return bytearray(BUF_SIZE)
+
+def pause(n=5):
+    best = 1 << 30
+    for i in range(n):
+        t = host.ticks_us()
+        gc.collect()
+        t = host.ticks_us() - t
+        if t < best:
+            best = t
+    return best
+
+def addr_pattern():
+    # heap addresses spread over the heap, as 64-bit words;
+    # the objects are garbage once the pattern is made
+    objs = [bytearray(64) for i in range(512)]
+    return array.array('Q', [id(o) for o in objs])
+
+def buf_cost():
+    gc.collect()
+    used = host.used()
+    b = bytearray(BUF_SIZE)
+    gc.collect()
+    return host.used() - used
+
+small = [(i, [i]) for i in range(5000)]
+cost = buf_cost()
+print('%-6s %8s %10s %10s' % ('data', 'buffers', 'pause (us)', 'retained'))
+for kind in ('zero', 'addr'):
+    for kb in (0, 768, 1536, 2400):
+        n = kb * 1024 // BUF_SIZE
+        gc.collect()
+        used = host.used()
+        pattern = addr_pattern()
+        buffers = [fill(kind, pattern) for i in range(n)]
+        pattern = None
+        gc.collect()
+        retained = host.used() - used - n * cost - 8 * n
+        print('%-6s %5d KB %10d %10d' % (kind, kb, pause(), retained))
+        buffers = None
+        gc.collect()
@@ -0,0 +1,46 @@
+# GC pause times on an allocation heavy workload with a large live set:
+# the stop-the-world collector, with the whole sweep at the end of each
+# collection (lazy_sweep(0)) and with the lazy sweep, where only the sweep
+# is split, and the incremental collector, where the mark phase is split too
+import gc
+import host
+
+def workload(n):
+    live = [[i, str(i)] for i in range(20000)]
+    for r in range(n):
+        tmp = [bytearray(48) for i in range(2000)]
+        d = {}
+        for i in range(500):
+            d[i] = (i, [i])
+        live[r % 20000] = [r, tmp[0]]
+    return live
+
+def p99(n, hist):
+    # upper bound of the histogram bucket with the 99th percentile pause
+    acc = 0
+    for i in range(len(hist)):
+        acc += hist[i]
+        if acc * 100 >= n * 99:
+            return 128 << i
+    return -1
+
+def run(name):
+    gc.collect()
+    gc.stats(True)
+    t = host.ticks_us()
+    workload(200)
+    t = host.ticks_us() - t
+    n, max_us, total_us, hist = gc.stats()
+    print('%-16s %5d pauses, p99 < %6d us, max %6d us, total %7d us, run %8d us' % (name, n, p99(n, hist), max_us, total_us, t))
+    print('    histogram (<128us, <256us, ...):', hist)
+
+for us in (0, 500):
+    gc.lazy_sweep(us)
+    run('sweep %d us' % us)
+for us in (2000, 500, 100):
+    # the mark phase starts when half of the free heap is allocated
+    gc.incremental(us)
+    run('incremental %d' % us)
+gc.incremental(0)
+gc.threshold(-1)
+gc.lazy_sweep(0)
@@ -0,0 +1,34 @@
+# Inline cache: opcodes whose first lookup missed the map and which find
+# the name there later.  An instance attribute shadowing a class default
+# (set after the first call), and a method of an instance looked up through
+# the class (the instance members always miss)
+import host
+
+class C:
+    x = 0
+    def get(self):
+        return self.x
+    def m(self):
+        return 1
+
+def shadowed(c, n):
+    s = 0
+    for i in range(n):
+        s += c.get()
+    return s
+
+def method(c, n):
+    s = 0
+    for i in range(n):
+        s += c.m()
+    return s
+
+N = 200000
+c = C()
+c.get()         # first lookup: x is not an instance member yet
+c.x = 1         # from now on it is
+for name, f in (('shadowed', shadowed), ('method', method)):
+    t = host.ticks_us()
+    r = f(c, N)
+    t = host.ticks_us() - t
+    print('%-9s %d loops, result %d: %d ns/loop' % (name, N, r, t * 1000 // N))
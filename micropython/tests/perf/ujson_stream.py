@@ -0,0 +1,99 @@
+# Loading and writing a 74 KB JSON document (400 records) with the whole text
+# in the heap (loads(read()), dumps()) and with the incremental ujson: load()
+# from the stream, load() with a schema, the Parser, dump() and the Writer.
+# 'allocated' is the heap allocated by one run with the GC disabled, 'kept' is
+# the heap freed by dropping the result, 'io calls' counts the stream reads
+# and writes.  The peak heap of a case can be found by lowering HEAP until it
+# fails with MemoryError.
+import gc
+import ujson
+import host
+
+DOC = '/tmp/mphost_ujson_doc.json'
+OUT = '/tmp/mphost_ujson_out.json'
+RUNS = 20
+
+seed = 1
+def rand(n):
+    global seed
+    seed = (seed * 1103515245 + 12345) & 0x7fffffff
+    return seed % n
+
+def record(i):
+    return {'id': i, 'name': 'sensor-%04d' % i, 'ts': 1700000000 + i * 60,
+            'loc': {'lat': rand(180000) / 1000 - 90, 'lon': rand(360000) / 1000 - 180},
+            'vals': [rand(100000) / 1000 for j in range(6)], 'ok': rand(2) == 1,
+            'note': 'calibrated "ok" µ' if i % 3 == 0 else ''}
+
+f = host.file(DOC, 'w')
+ujson.dump({'device': 'k210-gw', 'fw': '1.0.3', 'records': [record(i) for i in range(400)]}, f)
+f.close()
+
+def case_loads(open_file):
+    f = open_file(DOC, 'r')
+    return ujson.loads(f.read())
+
+def case_load(open_file):
+    return ujson.load(open_file(DOC, 'r'))
+
+def case_schema(open_file):
+    return ujson.load(open_file(DOC, 'r'), {'records': {'id': 0, 'vals': 0}})
+
+def case_parser(open_file):
+    p = ujson.Parser(open_file(DOC, 'r'))
+    t = 0
+    for ev in p:
+        if ev == 'number' and p.depth() == 4:
+            t += p.value()
+    return t
+
+def records():
+    return [{'id': i, 'name': 'sensor-%04d' % i, 'vals': [i * 0.5] * 6, 'ok': True} for i in range(400)]
+
+def case_dumps(open_file):
+    f = open_file(OUT, 'w')
+    f.write(ujson.dumps({'records': records()}))
+    f.close()
+
+def case_dump(open_file):
+    f = open_file(OUT, 'w')
+    ujson.dump({'records': records()}, f)
+    f.close()
+
+def case_writer(open_file):
+    f = open_file(OUT, 'w')
+    w = ujson.Writer(f)
+    w.start_map()
+    w.key('records')
+    w.start_array()
+    for i in range(400):
+        w.value({'id': i, 'name': 'sensor-%04d' % i, 'vals': [i * 0.5] * 6, 'ok': True})
+    w.end_array()
+    w.end_map()
+    f.close()
+
+CASES = (('loads(read())', case_loads), ('load(stream)', case_load), ('load(schema)', case_schema),
+         ('Parser', case_parser), ('dumps() + write', case_dumps), ('dump(stream)', case_dump), ('Writer', case_writer))
+
+print('document: %d records, %d bytes' % (400, len(host.file(DOC, 'r').read())))
+print('%-16s %10s %10s %10s %10s' % ('case', 'time us', 'allocated', 'kept', 'io calls'))
+for name, case in CASES:
+    gc.collect()
+    t = host.ticks_us()
+    for r in range(RUNS):
+        case(host.file)
+    t = (host.ticks_us() - t) // RUNS
+    gc.collect()
+    base = host.used()
+    gc.disable()
+    res = case(host.file)
+    allocated = host.used() - base
+    gc.enable()
+    gc.collect()
+    kept = host.used()
+    res = None
+    gc.collect()
+    kept -= host.used()
+    host.calls()
+    case(host.cfile)
+    print('%-16s %10d %10d %10d %10d' % (name, t, allocated, kept, host.calls()))
@@ -0,0 +1,33 @@
+# Import of precompiled modules: loaded from their .mpy files into the heap,
+# or executed in place from the XIP module image (MPHOST_XIPIMG).
+# Run from the directory with the .mpy files and the image:
+#   make -C ../ports/host xipbench
+# 'heap' is the heap still used by the imported module after a collection,
+# 'time' includes reading the .mpy file (from the host page cache)
+import gc
+import host
+
+MODULES = ('board', 'font6', 'font10', 'freesans20', 'microWebTemplate')
+
+def run():
+    print("import from", "the XIP image" if host.xip() else ".mpy files")
+    print("{:<18} {:>8} {:>8}".format("module", "time us", "heap B"))
+    total_t = total_h = 0
+    for name in MODULES:
+        gc.collect()
+        used = host.used()
+        t = host.ticks_us()
+        try:
+            __import__(name)
+        except ImportError as e:
+            print(name, e, "- run 'make -C ../ports/host xipbench'")
+            return
+        t = host.ticks_us() - t
+        gc.collect()
+        h = host.used() - used
+        total_t += t
+        total_h += h
+        print("{:<18} {:>8} {:>8}".format(name, t, h))
+    print("{:<18} {:>8} {:>8}".format("total", total_t, total_h))
+
+run()
@@ -0,0 +1,54 @@
+#!/bin/sh
+#
+# Run the tests with the host port (ports/host)
+#
+#   ./run-tests.sh                  run all tests (*/*.py, not perf/)
+#   ./run-tests.sh gc/*.py          run the given tests
+#   ./run-tests.sh --perf           run the benchmarks in perf/ (results are printed, not compared)
+#
+# Each test's output is compared with the .exp file next to it.
+# MPHOST selects the interpreter, default ../ports/host/mphost
+
+cd "$(dirname "$0")"
+MPHOST=${MPHOST:-../ports/host/mphost}
+HEAP=${HEAP:-4000000}
+
+if [ ! -x "$MPHOST" ]; then
+    echo "$MPHOST not found, build it with: make -C ../ports/host"
+    exit 2
+fi
+
+if [ "$1" = "--perf" ]; then
+    shift
+    [ $# -eq 0 ] && set -- perf/*.py
+    for t in "$@"; do
+        echo "== $t"
+        "$MPHOST" "$t" "$HEAP" || exit 1
+    done
+    exit 0
+fi
+
+[ $# -eq 0 ] && set -- $(ls */*.py | grep -v '^perf/')
+
+pass=0
+fail=0
+failed=""
+for t in "$@"; do
+    exp="${t%.py}.exp"
+    out=$("$MPHOST" "$t" "$HEAP" 2>&1)
+    if [ -f "$exp" ] && [ "$out" = "$(cat "$exp")" ]; then
+        pass=$((pass + 1))
+    else
+        fail=$((fail + 1))
+        failed="$failed $t"
+        echo "FAIL $t"
+        if [ -f "$exp" ]; then
+            echo "$out" | diff "$exp" - | head -20
+        else
+            echo "  missing $exp"
+        fi
+    fi
+done
+
+echo "$pass tests passed, $fail failed"
+[ $fail -eq 0 ] || { echo "failed:$failed"; exit 1; }
@@ -0,0 +1,54 @@
+# Inline cache: the same opcode sees names appear, disappear and move
+# between maps; every lookup must give the same result as without the cache
+
+class C:
+    x = 'class'
+    def get(self):
+        return self.x
+
+def run(objs):
+    return [o.get() for o in objs]
+
+a = C()
+b = C()
+print(run([a, b]))          # miss in the instance members
+a.x = 'a'
+print(run([a, b]))          # the miss expires, found in a, not in b
+b.y = 1
+b.x = 'b'
+print(run([b, a, b]))       # different slots in different instances
+del a.x
+print(run([a, b]))          # removed from a, found in the class again
+a.z = 2                     # same number of members as with x
+print(run([a, b, a]))
+
+# instances with different numbers of members
+objs = []
+for n in (0, 1, 5, 40):
+    o = C()
+    for i in range(n):
+        setattr(o, 'm%d' % i, i)
+    objs.append(o)
+print(run(objs))
+for i, o in enumerate(objs):
+    o.x = i
+print(run(objs))
+
+# global shadowing a builtin, and removed again
+def length():
+    return len('abc')
+print(length())
+len = lambda s: -1
+print(length())
+del len
+print(length())
+
+# names in a class body
+def body(v):
+    class D:
+        if v:
+            w = 'local'
+        r = w
+    return D.r
+w = 'global'
+print(body(False), body(True), body(False))
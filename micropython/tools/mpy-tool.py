@@ -671,7 +671,7 @@ def read_raw_code(f, qstr_win):
             # load qstr link table
             n_qstr_link = read_uint(f)
             for _ in range(n_qstr_link):
-                off = read_uint(f, qstr_win)
+                off = read_uint(f)
                 qst = read_qstr(f, qstr_win)
                 qstr_links.append((off >> 2, off & 3, qst))
 
@@ -822,6 +822,164 @@ def freeze_mpy(base_qstrs, raw_codes):
         print('    &raw_code_%s,' % rc.escaped_name)
     print('};')
 
+def read_frozen_qstrs(filename):
+    # get the qstrs of the mp_qstr_frozen_const_pool from a frozen_mpy.c file
+    import re
+    qstrs = []
+    in_pool = False
+    with open(filename, 'rt') as f:
+        for line in f:
+            if line.startswith('const qstr_pool_t mp_qstr_frozen_const_pool'):
+                in_pool = True
+            elif in_pool and line.startswith('};'):
+                break
+            elif in_pool:
+                match = re.match(r'^\s*\(const byte\*\)"((?:\\x[0-9a-f]{2})+)" "(.*)",$', line)
+                if not match:
+                    continue
+                qlen = bytes_cons(bytearray(int(h, 16) for h in match.group(1).split('\\x')[1:]))
+                qlen = qlen[config.MICROPY_QSTR_BYTES_IN_HASH:]
+                qlen = sum(b << (8 * i) for i, b in enumerate(bytearray(qlen)))
+                qdata = match.group(2)
+                if len(qdata) == 4 * qlen and qdata.startswith('\\x'):
+                    qdata = bytes_cons(bytearray(int(h, 16) for h in qdata.split('\\x')[1:]))
+                    qdata = str_cons(qdata, 'utf8')
+                qstrs.append(qdata)
+    return qstrs
+
+def xip_image(base_qstrs, frozen_qstrs, raw_codes, filename):
+    # Create the image of the modules which can be executed in place from memory mapped flash
+    # (see mp_frozen_xip_init() in py/frozenmod.c).
+    # The qstr numbers used in the image are the same as in the firmware, so the image must
+    # be rebuilt each time the firmware qstrs are changed.
+    if config.MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE:
+        raise Exception('XIP image can not be used with MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE')
+
+    # firmware qstrs, in the same order as in the firmware
+    fw_qstrs = [q[2] for q in sorted(base_qstrs.values(), key=lambda x: x[0])]
+    fw_qstrs.extend(frozen_qstrs)
+    fw_qstr_num = {}
+    for i, q in enumerate(fw_qstrs):
+        fw_qstr_num.setdefault(q, i + 1)
+    qstr_base = len(fw_qstrs) + 1
+
+    # checksum of the firmware qstrs, checked by the firmware when the image is registered
+    qstr_check = 5381
+    for q in fw_qstrs:
+        qbytes = bytes_cons(q, 'utf8')
+        qhash = qstrutil.compute_hash(qbytes, config.MICROPY_QSTR_BYTES_IN_HASH)
+        qstr_check = (qstr_check * 33 + qhash + (len(qbytes) << 8)) & 0xffffffff
+
+    # qstrs not in the firmware are added to the image
+    img_qstrs = []
+    def qstr_num(idx):
+        q = global_qstrs[idx].str
+        if q not in fw_qstr_num:
+            fw_qstr_num[q] = qstr_base + len(img_qstrs)
+            img_qstrs.append(q)
+        return fw_qstr_num[q]
+
+    def encode_uint(val):
+        buf = bytearray([val & 0x7f])
+        val >>= 7
+        while val:
+            buf.insert(0, 0x80 | (val & 0x7f))
+            val >>= 7
+        return buf
+
+    def pack_qstr(buf, idx):
+        qst = qstr_num(idx)
+        buf.append(qst & 0xff)
+        buf.append(qst >> 8)
+
+    def raw_code_data(rc):
+        if rc.code_kind != MP_CODE_BYTECODE:
+            raise FreezeError(rc, 'native code can not be used in XIP image')
+        bc = rc.bytecode
+        buf = bytearray(bc[:rc.ip2])
+        pack_qstr(buf, bc[rc.ip2] | bc[rc.ip2 + 1] << 8)
+        pack_qstr(buf, bc[rc.ip2 + 2] | bc[rc.ip2 + 3] << 8)
+        buf.extend(bc[rc.ip2 + 4:rc.ip])
+        ip = rc.ip
+        while ip < len(bc):
+            f, sz = mp_opcode_format(bc, ip, True)
+            if f == MP_OPCODE_QSTR:
+                buf.append(bc[ip])
+                pack_qstr(buf, bc[ip + 1] | bc[ip + 2] << 8)
+                buf.extend(bc[ip + 3:ip + sz])
+            else:
+                buf.extend(bc[ip:ip + sz])
+            ip += sz
+        data = encode_uint(len(buf) << 2 | (rc.code_kind - MP_CODE_BYTECODE)) + buf
+        data += encode_uint(len(rc.objs)) + encode_uint(len(rc.raw_codes))
+        for qst in rc.qstrs:
+            data += encode_uint(qstr_num(qst))
+        for obj in rc.objs:
+            if obj is Ellipsis:
+                data += b'e'
+                continue
+            elif is_str_type(obj):
+                obj_type, obj = b's', bytes_cons(obj, 'utf8')
+            elif is_bytes_type(obj):
+                obj_type = b'b'
+            elif is_int_type(obj):
+                obj_type, obj = b'i', bytes_cons(str(obj), 'ascii')
+            elif type(obj) is float:
+                obj_type, obj = b'f', bytes_cons(repr(obj), 'ascii')
+            elif type(obj) is complex and obj.real == 0:
+                obj_type, obj = b'c', bytes_cons(repr(obj.imag) + 'j', 'ascii')
+            else:
+                raise FreezeError(rc, 'object %r can not be used in XIP image' % (obj,))
+            data += obj_type + encode_uint(len(obj)) + obj
+        for child in rc.raw_codes:
+            data += raw_code_data(child)
+        return data
+
+    modules = [raw_code_data(rc) for rc in raw_codes]
+    names = b''.join(bytes_cons(rc.source_file.str, 'utf8') + b'\0' for rc in raw_codes) + b'\0'
+
+    def align(buf):
+        buf.extend(bytearray(-len(buf) & 3))
+
+    hdr_fmt = '<4s4B4B8I'
+    hdr_size = struct.calcsize(hdr_fmt)
+    img = bytearray(hdr_size)
+    module_offsets = []
+    for m in modules:
+        module_offsets.append(len(img))
+        img += m
+    names_offset = len(img)
+    img += names
+    align(img)
+    module_table = len(img)
+    for off in module_offsets:
+        img += struct.pack('<I', off)
+    qstr_offsets = []
+    for q in img_qstrs:
+        qbytes = bytes_cons(q, 'utf8')
+        if len(qbytes) >= (1 << (8 * config.MICROPY_QSTR_BYTES_IN_LEN)):
+            raise Exception('qstr is too long: %s' % q)
+        qhash = qstrutil.compute_hash(qbytes, config.MICROPY_QSTR_BYTES_IN_HASH)
+        qstr_offsets.append(len(img))
+        img += bytearray((qhash >> (8 * i)) & 0xff for i in range(config.MICROPY_QSTR_BYTES_IN_HASH))
+        img += bytearray((len(qbytes) >> (8 * i)) & 0xff for i in range(config.MICROPY_QSTR_BYTES_IN_LEN))
+        img += qbytes + b'\0'
+    align(img)
+    qstr_table = len(img)
+    for off in qstr_offsets:
+        img += struct.pack('<I', off)
+
+    feature_byte = (config.MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
+        | config.MICROPY_PY_BUILTINS_STR_UNICODE << 1 | MP_NATIVE_ARCH_NONE << 2)
+    img[:hdr_size] = struct.pack(hdr_fmt, b'MPXI',
+        ord('M'), config.MPY_VERSION, feature_byte, config.mp_small_int_bits,
+        1, config.MICROPY_QSTR_BYTES_IN_HASH, config.MICROPY_QSTR_BYTES_IN_LEN, 0,
+        len(img), qstr_base, qstr_check, len(img_qstrs), qstr_table,
+        len(modules), names_offset, module_table)
+    with open(filename, 'wb') as f:
+        f.write(img)
+    print('XIP image: %u modules, %u qstrs, %u bytes' % (len(modules), len(img_qstrs), len(img)))
+
 def main():
     import argparse
     cmd_parser = argparse.ArgumentParser(description='A tool to work with MicroPython .mpy files.')
@@ -831,6 +989,10 @@ def main():
         help='freeze files')
     cmd_parser.add_argument('-q', '--qstr-header',
         help='qstr header file to freeze against')
+    cmd_parser.add_argument('-x', '--xip-image', metavar='FILE',
+        help='create the image of the modules for execution in place from flash')
+    cmd_parser.add_argument('--frozen-c', metavar='FILE',
+        help='frozen_mpy.c of the firmware the XIP image is created for')
     cmd_parser.add_argument('-mlongint-impl', choices=['none', 'longlong', 'mpz'], default='mpz',
         help='long-int implementation used by target (default mpz)')
     cmd_parser.add_argument('-mmpz-dig-size', metavar='N', type=int, default=16,
@@ -861,6 +1023,13 @@ def main():
 
     if args.dump:
         dump_mpy(raw_codes)
+    elif args.xip_image:
+        frozen_qstrs = read_frozen_qstrs(args.frozen_c) if args.frozen_c else []
+        try:
+            xip_image(base_qstrs, frozen_qstrs, raw_codes, args.xip_image)
+        except FreezeError as er:
+            print(er, file=sys.stderr)
+            sys.exit(1)
     elif args.freeze:
         try:
             freeze_mpy(base_qstrs, raw_codes)
@@ -26,6 +26,8 @@
  * THE SOFTWARE.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "lfs.h"
 #include "lfs_util.h"
 
@@ -40,9 +42,22 @@
 #include <dirent.h>
 #include <sys/stat.h>
 #include <getopt.h>
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
 
 #define LITTLEFS_ATTR_MTIME         0x10
-#define LITTLEFS_IMAGE_SIZE                  (12*1024*1024)
+#define FLASH_SECTOR_SIZE           4096
+
+// File or directory to be added to the image
+typedef struct _image_entry_t {
+    char name[512];         // path on the file system
+    char path[512];         // source path on host
+    bool is_dir;
+    bool compile;           // '.py' file, precompiled to '.mpy'
+    int pid;
+} image_entry_t;
 
 typedef struct _littlefs_file_obj_t {
     lfs_t* fs;
@@ -63,6 +78,16 @@ static uint32_t lookahead = 32;
 static char image_name[256] = {0};
 static char image_dir[256] = {0};
 static uint32_t fs_offset = 0;
+static uint32_t image_size = 0;
+static char mpy_cross[256] = {0};
+static char mpy_dir[256] = {0};
+static int max_jobs = 0;
+
+static image_entry_t *entries = NULL;
+static int entry_count = 0;
+static int entry_max = 0;
+static uint8_t *used_blocks = NULL;
+static uint32_t used_count = 0;
 
 static uint32_t *erase_log = NULL;
 static uint32_t *prog_log = NULL;
@@ -145,17 +170,18 @@ int addFile(char* name, const char* path)
     size_t size = ftell(src);
     fseek(src, 0, SEEK_SET);
 
+    uint8_t data_buf[4096];
     size_t left = size;
-    uint8_t data_byte;
     while (left > 0){
-        if (1 != fread(&data_byte, 1, 1, src)) {
+        size_t len = (left > sizeof(data_buf)) ? sizeof(data_buf) : left;
+        if (len != fread(data_buf, 1, len, src)) {
             printf("fread error!\r\n");
 
             fclose(src);
             lfs_file_close(&lfs, &o.fd);
             return 1;
         }
-        lfs_ssize_t res = lfs_file_write(&lfs, &o.fd, &data_byte, 1);
+        lfs_ssize_t res = lfs_file_write(&lfs, &o.fd, data_buf, len);
         if (res < 0) {
             printf("LittleFS write error (%d)\r\n", res);
 
@@ -163,9 +189,10 @@ int addFile(char* name, const char* path)
             lfs_file_close(&lfs, &o.fd);
             return 1;
         }
-        left -= 1;
+        left -= len;
     }
 
+    fclose(src);
     lfs_file_close(&lfs, &o.fd);
 
     return 0;
@@ -178,8 +205,26 @@ int addDir(char* name)
     return err;
 }
 
-//----------------------------------------------------
-int addFiles(const char* dirname, const char* subPath)
+//-----------------------------------------------------------------------------
+static image_entry_t *addEntry(const char *name, const char *path, bool is_dir)
+{
+    if (entry_count >= entry_max) {
+        entry_max += 256;
+        image_entry_t *new_entries = realloc(entries, entry_max * sizeof(image_entry_t));
+        if (new_entries == NULL) return NULL;
+        entries = new_entries;
+    }
+    image_entry_t *entry = &entries[entry_count++];
+    memset(entry, 0, sizeof(image_entry_t));
+    snprintf(entry->name, sizeof(entry->name), "%s", name);
+    snprintf(entry->path, sizeof(entry->path), "%s", path);
+    entry->is_dir = is_dir;
+    return entry;
+}
+
+// Collect the files and directories to be added to the image
+//-----------------------------------------------------
+int scanFiles(const char* dirname, const char* subPath)
 {
     DIR *dir;
     struct dirent *ent;
@@ -213,10 +258,8 @@ int addFiles(const char* dirname, const char* subPath)
                 if (S_ISDIR(path_stat.st_mode)) {
                     sprintf(dirpath, "%s", subPath);
                     strcat(dirpath, ent->d_name);
-                    printf("%s [D]\r\n", dirpath);
-                    int res = addDir(dirpath);
-                    if (res != 0) {
-                        printf("error adding directory (open)!\r\n");
+                    if (addEntry(dirpath, fullpath, true) == NULL) {
+                        printf("error: out of memory\r\n");
                         error = true;
                         break;
                     }
@@ -225,7 +268,7 @@ int addFiles(const char* dirname, const char* subPath)
                     strcat(newSubPath, ent->d_name);
                     strcat(newSubPath, "/");
 
-                    if (addFiles(dirname, newSubPath) != 0) {
+                    if (scanFiles(dirname, newSubPath) != 0) {
                         printf("Error for adding content from '%s' !\r\n", ent->d_name);
                         error = true;
                         break;
@@ -242,14 +285,20 @@ int addFiles(const char* dirname, const char* subPath)
             // File path with directory name as root folder.
             sprintf(filepath, "%s", subPath);
             strcat(filepath, ent->d_name);
-            printf("%s\r\n", filepath);
 
-            // Add File to image.
-            if (addFile(filepath, fullpath) != 0) {
-                printf("error adding file!\r\n");
+            image_entry_t *entry = addEntry(filepath, fullpath, false);
+            if (entry == NULL) {
+                printf("error: out of memory\r\n");
                 error = true;
                 break;
             }
+            // 'boot.py' and 'main.py' in the root directory are executed as source files
+            size_t len = strlen(filepath);
+            if ((mpy_cross[0]) && (len > 3) && (strcmp(filepath + len - 3, ".py") == 0) &&
+                (strcmp(filepath, "/boot.py") != 0) && (strcmp(filepath, "/main.py") != 0)) {
+                entry->compile = true;
+                sprintf(entry->name + len - 3, ".mpy");
+            }
         } // end while
         closedir(dir);
     }
@@ -261,14 +310,156 @@ int addFiles(const char* dirname, const char* subPath)
     return (error) ? 1 : 0;
 }
 
+//------------------------------------------------------
+static void mpyFileName(int index, char *fname, int len)
+{
+    snprintf(fname, len, "%s/%d.mpy", mpy_dir, index);
+}
+
+// Source name stored in the '.mpy' file and shown in tracebacks,
+// the original '.py' path on the file system, without the leading '/'
+//-------------------------------------------------------------------------
+static void sourceName(const image_entry_t *entry, char *fname, int len)
+{
+    snprintf(fname, len, "%.*s.py", (int)(strlen(entry->name) - 5), entry->name + 1);
+}
+
+// Precompile the '.py' files to '.mpy' using 'mpy-cross',
+// up to 'max_jobs' compiler processes are running in parallel
+//--------------------
+int compileFiles(void)
+{
+    char mpy_file[300];
+    char src_name[512];
+    int running = 0, next = 0, compiled = 0;
+    bool error = false;
+
+    sprintf(mpy_dir, "/tmp/mklfs_XXXXXX");
+    if (mkdtemp(mpy_dir) == NULL) {
+        printf("error: failed to create temporary directory (%d)\r\n", errno);
+        mpy_dir[0] = '\0';
+        return 1;
+    }
+
+    while (1) {
+        // start the compiler processes
+        while ((!error) && (running < max_jobs) && (next < entry_count)) {
+            image_entry_t *entry = &entries[next];
+            mpyFileName(next, mpy_file, sizeof(mpy_file));
+            next++;
+            if (!entry->compile) continue;
+            sourceName(entry, src_name, sizeof(src_name));
+            #ifndef _WIN32
+            pid_t pid = fork();
+            if (pid == 0) {
+                execl(mpy_cross, mpy_cross, "-o", mpy_file, "-s", src_name, entry->path, (char *)NULL);
+                _exit(127);
+            }
+            if (pid < 0) {
+                printf("error: failed to start '%s' (%d)\r\n", mpy_cross, errno);
+                error = true;
+                break;
+            }
+            entry->pid = pid;
+            running++;
+            #else
+            // no fork() on Windows, compile sequentially
+            char cmd[1400];
+            snprintf(cmd, sizeof(cmd), "\"%s\" -o \"%s\" -s \"%s\" \"%s\"", mpy_cross, mpy_file, src_name, entry->path);
+            if (system(cmd) != 0) {
+                printf("error: failed to compile '%s'\r\n", entry->path);
+                error = true;
+            }
+            else compiled++;
+            #endif
+        }
+        if (running == 0) break;
+
+        #ifndef _WIN32
+        // wait for any compiler process to finish
+        int status;
+        pid_t pid = wait(&status);
+        if (pid < 0) break;
+        running--;
+        for (int i = 0; i < entry_count; i++) {
+            if (entries[i].pid != pid) continue;
+            entries[i].pid = 0;
+            if ((!WIFEXITED(status)) || (WEXITSTATUS(status) != 0)) {
+                printf("error: failed to compile '%s'\r\n", entries[i].path);
+                error = true;
+            }
+            else compiled++;
+            break;
+        }
+        #endif
+    }
+    printf("%d files precompiled, %d parallel jobs\r\n", compiled, max_jobs);
+
+    return (error) ? 1 : 0;
+}
+
+//-----------------------
+void removeCompiled(void)
+{
+    char mpy_file[300];
+    if (mpy_dir[0] == '\0') return;
+    for (int i = 0; i < entry_count; i++) {
+        if (!entries[i].compile) continue;
+        mpyFileName(i, mpy_file, sizeof(mpy_file));
+        unlink(mpy_file);
+    }
+    rmdir(mpy_dir);
+    mpy_dir[0] = '\0';
+}
+
+// Add the collected files and directories to the image
+//----------------
+int addFiles(void)
+{
+    char mpy_file[300];
+    for (int i = 0; i < entry_count; i++) {
+        image_entry_t *entry = &entries[i];
+        if (entry->is_dir) {
+            printf("%s [D]\r\n", entry->name);
+            int res = addDir(entry->name);
+            if (res != 0) {
+                printf("error adding directory (open)!\r\n");
+                return 1;
+            }
+            continue;
+        }
+        printf("%s\r\n", entry->name);
+        if (entry->compile) mpyFileName(i, mpy_file, sizeof(mpy_file));
+        // Add File to image.
+        if (addFile(entry->name, (entry->compile) ? mpy_file : entry->path) != 0) {
+            printf("error adding file!\r\n");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Mark the blocks used by the file system, the content of the free blocks is not needed
+//----------------------------------------------------------
+static int lfs_img_used_block(void *data, lfs_block_t block)
+{
+    uint8_t *used = (uint8_t *)data;
+    if ((block < block_count) && (used[block] == 0)) {
+        used[block] = 1;
+        used_count++;
+    }
+    return 0;
+}
+
 
 //----------------------------------------
 int lfs_img_create(struct lfs_config *cfg)
 {
-    lfs_image = malloc(LITTLEFS_IMAGE_SIZE);
+    image_size = cfg->block_count * cfg->block_size;
+    lfs_image = malloc(image_size);
     if (lfs_image == NULL) return -1;
 
-    memset(lfs_image, 0xFF, LITTLEFS_IMAGE_SIZE);
+    memset(lfs_image, 0xFF, image_size);
 
     read_buffer = malloc(cfg->block_size);
     prog_buffer = malloc(config.prog_size);
@@ -300,26 +491,78 @@ int lfs_img_format(void)
     return err;
 }
 
+// Save the image trimmed after the last used Flash sector.
+// The unused blocks are left erased and the list of the used sectors
+// is saved to '<image_name>.json', the flasher only writes those sectors
 //------------------
 int save_image(void)
 {
-    // find image size
-    int size = LITTLEFS_IMAGE_SIZE;
-    for (size=LITTLEFS_IMAGE_SIZE-1; size>0; size--) {
-        if (lfs_image[size] != 0xFF) break;
+    char manifest_name[300];
+    int nsect = (image_size + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE;
+    uint8_t *used_sect = calloc(nsect, 1);
+    if (used_sect == NULL) {
+        printf("error: out of memory\r\n");
+        return 1;
     }
-    int img_size = ((size / 4096) * 4096) + 4096;
-    printf("Image size: %d (%d)\r\n", size, img_size);
+    int last_sect = 0;
+    for (uint32_t block = 0; block < block_count; block++) {
+        uint32_t offset = block * block_size;
+        if (used_blocks[block]) {
+            for (int sect = offset / FLASH_SECTOR_SIZE; sect <= (int)((offset + block_size - 1) / FLASH_SECTOR_SIZE); sect++) {
+                used_sect[sect] = 1;
+                if (sect > last_sect) last_sect = sect;
+            }
+        }
+        else memset(lfs_image + offset, 0xFF, block_size);
+    }
+    int img_size = (last_sect + 1) * FLASH_SECTOR_SIZE;
+    int used_sect_count = 0;
+    for (int sect = 0; sect <= last_sect; sect++) used_sect_count += used_sect[sect];
+
+    printf("Image size: %d, %d of %d sectors used\r\n", img_size, used_sect_count, last_sect + 1);
+    printf("Used blocks: %u of %u (%.1f%%)\r\n", used_count, block_count, (double)used_count * 100.0 / block_count);
 
     printf("Saving image to '%s'\r\n", image_name);
     FILE* img_file = fopen(image_name, "wb");
     if (!img_file) {
         printf("error: failed to open '%s'\r\n", image_name);
+        free(used_sect);
         return 1;
     }
     fwrite(lfs_image, 1, img_size, img_file);
     fclose(img_file);
 
+    // Save the used sectors as [first_sector, count] ranges
+    snprintf(manifest_name, sizeof(manifest_name), "%s.json", image_name);
+    printf("Saving used sectors list to '%s'\r\n", manifest_name);
+    FILE* man_file = fopen(manifest_name, "w");
+    if (!man_file) {
+        printf("error: failed to open '%s'\r\n", manifest_name);
+        free(used_sect);
+        return 1;
+    }
+    const char *img_base = strrchr(image_name, '/');
+    fprintf(man_file, "{\n");
+    fprintf(man_file, "    \"image\": \"%s\",\n", (img_base) ? img_base + 1 : image_name);
+    fprintf(man_file, "    \"size\": %d,\n", img_size);
+    fprintf(man_file, "    \"sector_size\": %d,\n", FLASH_SECTOR_SIZE);
+    fprintf(man_file, "    \"block_size\": %u,\n", block_size);
+    fprintf(man_file, "    \"block_count\": %u,\n", block_count);
+    fprintf(man_file, "    \"used_blocks\": %u,\n", used_count);
+    fprintf(man_file, "    \"sectors\": [");
+    bool first = true;
+    for (int sect = 0; sect <= last_sect; sect++) {
+        if (!used_sect[sect]) continue;
+        int count = 1;
+        while (((sect + count) <= last_sect) && (used_sect[sect + count])) count++;
+        fprintf(man_file, "%s[%d, %d]", (first) ? "" : ", ", sect, count);
+        first = false;
+        sect += count - 1;
+    }
+    fprintf(man_file, "]\n}\n");
+    fclose(man_file);
+    free(used_sect);
+
     return 0;
 }
 
@@ -376,7 +619,19 @@ int lfs_create_image(void)
     printf("\r\nAdding files from image directory:\r\n");
     printf("  '%s'\r\n", image_dir);
     printf("----------------------------------\r\n\r\n");
-    err = addFiles(image_dir, "/");
+    err = scanFiles(image_dir, "/");
+    if ((err == 0) && (mpy_cross[0])) {
+        err = compileFiles();
+        if (err != 0) {
+            removeCompiled();
+            printf("\r\n---------------------------------\r\n");
+            printf("Errors occured while precompiling files\r\n");
+            lfs_unmount(&lfs);
+            return 1;
+        }
+    }
+    if (err == 0) err = addFiles();
+    removeCompiled();
     printf("\r\n");
     if (err != 0) {
         printf("---------------------------------\r\n");
@@ -390,14 +645,25 @@ int lfs_create_image(void)
         return 1;
     }
 
+    used_blocks = calloc(block_count, 1);
+    if (used_blocks == NULL) {
+        printf("error: out of memory\r\n");
+        lfs_unmount(&lfs);
+        return 1;
+    }
+    err = lfs_fs_traverse(&lfs, lfs_img_used_block, used_blocks);
+    if (err) {
+        printf("Error traversing image (%d)\r\n", err);
+        lfs_unmount(&lfs);
+        return 1;
+    }
+
     err = lfs_unmount(&lfs);
     if (err) {
         printf("Error unmounting image (%d)\r\n", err);
     }
 
-    save_image();
-
-    return 0;
+    return save_image();
 }
 
 
@@ -410,7 +676,7 @@ int main(int argc, char **argv) {
     bool help = false;
 
     printf("\r\n");
-    while ( (c = getopt(argc, argv, "b:c:l")) != -1) {
+    while ( (c = getopt(argc, argv, "b:c:l:j:x:h")) != -1) {
         switch (c) {
         case 'b':
             cvalue = optarg;
@@ -424,6 +690,13 @@ int main(int argc, char **argv) {
             cvalue = optarg;
             lookahead = (uint32_t)strtol(cvalue, &ptr, 10);
             break;
+        case 'j':
+            cvalue = optarg;
+            max_jobs = (int)strtol(cvalue, &ptr, 10);
+            break;
+        case 'x':
+            snprintf(mpy_cross, sizeof(mpy_cross), "%s", optarg);
+            break;
         case 'h':
             help = true;
             break;
@@ -434,17 +707,23 @@ int main(int argc, char **argv) {
         }
     }
 
-    if (argc < 2) help = true;
+    if ((argc - optind) < 2) help = true;
     if (help) {
         printf("Usage:\r\n");
-        printf("  mklfs [-b block_size] [-c block_count] [-l lookahead_size] image_dir image_name\r\n");
+        printf("  mklfs [-b block_size] [-c block_count] [-l lookahead_size] [-x mpy_cross [-j jobs]] image_dir image_name\r\n");
         printf("      block_size: default=512   (MICRO_PY_LITTLEFS_SECTOR_SIZE)\r\n");
         printf("     block_count: default=20480 (MICRO_PY_FLASHFS_SIZE / MICRO_PY_LITTLEFS_SECTOR_SIZE)\r\n");
         printf("  lookahead_size: default=32    (LITTLEFS_CFG_LOOKAHEAD_SIZE)\r\n");
+        printf("       mpy_cross: path to 'mpy-cross', if set, '.py' files are precompiled to '.mpy'\r\n");
+        printf("                  ('boot.py' and 'main.py' in root directory are not precompiled)\r\n");
+        printf("            jobs: number of parallel 'mpy-cross' processes, default=number of CPUs\r\n");
         printf("\r\n");
         return 0;
     }
 
+    if (max_jobs < 1) max_jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (max_jobs < 1) max_jobs = 1;
+
     sprintf(image_dir, "%s", argv[optind]);
     sprintf(image_name, "%s", argv[optind+1]);
 
@@ -453,9 +732,16 @@ int main(int argc, char **argv) {
     printf("Image directory:\r\n  '%s'\r\n", image_dir);
     printf("Image name:\r\n  '%s'\r\n", image_name);
     printf("Block size=%u, Block count=%u, lookahead=%u\r\n", block_size, block_count, lookahead);
+    if (mpy_cross[0]) printf("Precompile with:\r\n  '%s'\r\n", mpy_cross);
 
+    struct timespec t_start, t_end;
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
     int err = lfs_create_image();
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
     if (lfs_image) free(lfs_image);
+    if (used_blocks) free(used_blocks);
+    if (entries) free(entries);
+    printf("Build time: %.3f s\r\n", (double)(t_end.tv_sec - t_start.tv_sec) + (double)(t_end.tv_nsec - t_start.tv_nsec) / 1e9);
     printf("=======================\r\n");
     printf("\r\n");
     